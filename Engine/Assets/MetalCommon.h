@@ -20,6 +20,8 @@ struct Uniforms
     float f0;
     float4 tex0scaleOffset;
     float4 tilesXY;
+    float4 vertexScale; // Metal decodes quantized vertices on load, so this is unused.
+    float4 vertexOffset;
     matrix_float4x4 boneMatrices[ 80 ];
     int isVR;
 };
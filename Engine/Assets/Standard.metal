@@ -150,7 +150,9 @@ fragment half4 standard_fragment( StandardColorInOut in [[stage_in]],
     const float2 uv = float2( in.tangentVS_u.w, in.bitangentVS_v.w );
     const half4 albedoColor = half4( albedoSmoothnessMap.sample( sampler0, uv ) );
     //const float smoothness = albedoColor.a;
-    const float4 normalTS = float4( normalMap.sample( sampler0, uv ).rgb * 2.0f - 1.0f, 0.0f );
+    // Z is reconstructed, so two-channel normal maps (BC5) work too.
+    const float2 normalXY = normalMap.sample( sampler0, uv ).rg * 2.0f - 1.0f;
+    const float4 normalTS = float4( normalXY, sqrt( saturate( 1.0f - dot( normalXY, normalXY ) ) ), 0.0f );
     //const float4 specular = float4( specularMap.sample( sampler0, uv ) );
     
     const float3 normalVS = tangentSpaceTransform( in.tangentVS_u.xyz, in.bitangentVS_v.xyz, in.normalVS, normalTS.xyz );
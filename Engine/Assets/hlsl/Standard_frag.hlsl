@@ -108,7 +108,9 @@ float getSquareFalloffAttenuation( float3 posToLight, float lightInvRadius )
 float4 main( PS_INPUT input ) : SV_Target
 {
     const float4 albedo = tex.Sample( sLinear, float2( input.positionVS_u.w, input.positionWS_v.w ) );
-    const float4 normalTS = float4( normalTex.Sample( sLinear, float2(input.positionVS_u.w, input.positionWS_v.w) ).xyz * 2 - 1, 0 );
+    // Z is reconstructed, so two-channel normal maps (BC5, or R8G8 chosen at load time) work too.
+    const float2 normalXY = normalTex.Sample( sLinear, float2(input.positionVS_u.w, input.positionWS_v.w) ).xy * 2 - 1;
+    const float4 normalTS = float4( normalXY, sqrt( saturate( 1 - dot( normalXY, normalXY ) ) ), 0 );
 
     const uint tileIndex = GetTileIndex( input.pos.xy );
     uint index = maxNumLightsPerTile * tileIndex;
@@ -13,8 +13,10 @@ struct VSOutput
 
 #include "ubo.h"
 
-VSOutput main( float3 pos : POSITION, float3 normal : NORMAL )
+VSOutput main( float4 inPos : POSITION, float3 inNormal : NORMAL )
 {
+    const float3 pos = DecodePosition( inPos );
+    const float3 normal = DecodeNormal( inNormal );
     VSOutput vsOut;
     vsOut.pos = mul( localToClip, float4( pos, 1.0 ) );
     vsOut.mvPosition = mul( localToView, float4( pos, 1.0 ) ).xyz;
@@ -11,8 +11,9 @@ struct VSOutput
 
 #include "ubo.h"
 
-VSOutput main( float3 pos : POSITION, float3 normal : NORMAL )
+VSOutput main( float4 inPos : POSITION, float3 normal : NORMAL )
 {
+    const float3 pos = DecodePosition( inPos );
     VSOutput vsOut;
     vsOut.pos = mul( localToClip, float4( pos, 1.0f ) );
 #if !VULKAN
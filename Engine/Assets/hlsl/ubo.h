@@ -18,6 +18,39 @@ layout(set=0, binding=0) cbuffer cbPerFrame : register(b0)
     float f0;
     float4 tex0scaleOffset;
     float4 tilesXY;
+    float4 vertexScale; // Position scale of quantized vertices. w is 1 if normals and tangents are octahedral.
+    float4 vertexOffset; // Position offset of quantized vertices.
     matrix boneMatrices[ 80 ];
     int isVR;
 };
+
+// Quantized vertices have snorm16 positions relative to the submesh AABB and octahedral normals and tangents, see VertexQuantization.hpp.
+// Full precision vertices have identity scale and offset and are returned as they are.
+float3 DecodePosition( float4 pos )
+{
+    return pos.xyz * vertexScale.xyz + vertexOffset.xyz;
+}
+
+float3 OctahedralDecode( float2 encoded )
+{
+    float3 n = float3( encoded.x, encoded.y, 1.0f - abs( encoded.x ) - abs( encoded.y ) );
+
+    if (n.z < 0)
+    {
+        const float2 signs = float2( n.x >= 0 ? 1.0f : -1.0f, n.y >= 0 ? 1.0f : -1.0f );
+        n.xy = (1.0f - abs( n.yx )) * signs;
+    }
+
+    return normalize( n );
+}
+
+float3 DecodeNormal( float3 normal )
+{
+    return vertexScale.w > 0 ? OctahedralDecode( normal.xy ) : normal;
+}
+
+// Quantized vertices store tangent handedness in pos.w.
+float4 DecodeTangent( float4 tangent, float4 pos )
+{
+    return vertexScale.w > 0 ? float4( OctahedralDecode( tangent.xy ), pos.w < 0 ? -1.0f : 1.0f ) : tangent;
+}
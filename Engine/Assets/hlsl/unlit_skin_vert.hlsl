@@ -14,8 +14,9 @@ struct VSOutput
     
 #include "ubo.h"
 
-VSOutput main( float3 pos : POSITION, float2 uv : TEXCOORD, float3 nor : NORMAL, float4 tangent : TANGENT, float4 color : COLOR, float4 boneWeights : WEIGHTS, uint4 boneIndex : BONES )
+VSOutput main( float4 inPos : POSITION, float2 uv : TEXCOORD, float3 nor : NORMAL, float4 tangent : TANGENT, float4 color : COLOR, float4 boneWeights : WEIGHTS, uint4 boneIndex : BONES )
 {
+    const float3 pos = DecodePosition( inPos );
     float4 position2 = mul( boneMatrices[ boneIndex.x ], float4( pos, 1.0 ) ) * boneWeights.x;
     position2 += mul( boneMatrices[ boneIndex.y ], float4( pos, 1.0 ) ) * boneWeights.y;
     position2 += mul( boneMatrices[ boneIndex.z ], float4( pos, 1.0 ) ) * boneWeights.z;
@@ -14,8 +14,9 @@ struct VSOutput
     
 #include "ubo.h"
 
-VSOutput main( float3 pos : POSITION, float2 uv : TEXCOORD, float4 color : COLOR )
+VSOutput main( float4 inPos : POSITION, float2 uv : TEXCOORD, float4 color : COLOR )
 {
+    const float3 pos = DecodePosition( inPos );
     VSOutput vsOut;
     vsOut.pos = mul( localToClip, float4( pos, 1.0 ) );
     
@@ -1,6 +1,7 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "GameObject.hpp"
+#include "Scene.hpp"
 #include "AudioSourceComponent.hpp"
 #include "CameraComponent.hpp"
 #include "DirectionalLightComponent.hpp"
@@ -23,6 +24,17 @@ ae3d::GameObject::GameObject( const GameObject& other )
     *this = other;
 }
 
+ae3d::GameObject::~GameObject()
+{
+    std::vector< Scene* > addedScenes;
+    addedScenes.swap( scenes );
+
+    for (auto scene : addedScenes)
+    {
+        scene->Remove( this );
+    }
+}
+
 GameObject& ae3d::GameObject::operator=( const GameObject& go )
 {
     name = go.name;
@@ -90,6 +102,40 @@ GameObject& ae3d::GameObject::operator=( const GameObject& go )
     return *this;
 }
 
+void ae3d::GameObject::SetEnabled( bool enabled )
+{
+    if (enabled != isEnabled)
+    {
+        for (auto scene : scenes)
+        {
+            if (enabled)
+            {
+                scene->AddToLayers( this, layer );
+            }
+            else
+            {
+                scene->RemoveFromLayers( this, layer );
+            }
+        }
+    }
+
+    isEnabled = enabled;
+}
+
+void ae3d::GameObject::SetLayer( unsigned aLayer )
+{
+    if (isEnabled && aLayer != layer)
+    {
+        for (auto scene : scenes)
+        {
+            scene->RemoveFromLayers( this, layer );
+            scene->AddToLayers( this, aLayer );
+        }
+    }
+
+    layer = aLayer;
+}
+
 bool ae3d::GameObject::IsEnabled() const
 {
     const TransformComponent* transform = GetComponent< TransformComponent >();
@@ -1,14 +1,20 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "MeshRendererComponent.hpp"
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
+#include "CameraComponent.hpp"
 #include "Frustum.hpp"
 #include "GfxDevice.hpp"
 #include "Matrix.hpp"
 #include "Mesh.hpp"
+#include "MeshCluster.hpp"
+#include "MeshLod.hpp"
 #include "Material.hpp"
 #include "Shader.hpp"
+#include "Statistics.hpp"
 #include "System.hpp"
 #include "SubMesh.hpp"
 #include "VertexBuffer.hpp"
@@ -72,15 +78,8 @@ std::string GetSerialized( ae3d::MeshRendererComponent* component )
     return outStr;
 }
 
-void ae3d::MeshRendererComponent::Cull( const class Frustum& cameraFrustum, const struct Matrix44& localToWorld )
+void ae3d::MeshRendererComponent::GetWorldAABB( const Matrix44& localToWorld, Vec3& outMin, Vec3& outMax ) const
 {
-    if (!mesh)
-    {
-        return;
-    }
-
-    isCulled = false;
-    
     Vec3 aabbWorld[ 8 ];
     MathUtil::GetCorners( mesh->GetAABBMin(), mesh->GetAABBMax(), aabbWorld );
     
@@ -89,8 +88,18 @@ void ae3d::MeshRendererComponent::Cull( const class Frustum& cameraFrustum, cons
         Matrix44::TransformPoint( aabbWorld[ v ], localToWorld, &aabbWorld[ v ] );
     }
     
+    MathUtil::GetMinMax( aabbWorld, 8, outMin, outMax );
+}
+
+void ae3d::MeshRendererComponent::Cull( const class Frustum& cameraFrustum, const struct Matrix44& localToWorld )
+{
+    if (!mesh)
+    {
+        return;
+    }
+
     Vec3 aabbMinWorld, aabbMaxWorld;
-    MathUtil::GetMinMax( aabbWorld, 8, aabbMinWorld, aabbMaxWorld );
+    GetWorldAABB( localToWorld, aabbMinWorld, aabbMaxWorld );
     
     if (!cameraFrustum.BoxInFrustum( aabbMinWorld, aabbMaxWorld ))
     {
@@ -98,12 +107,30 @@ void ae3d::MeshRendererComponent::Cull( const class Frustum& cameraFrustum, cons
         return;
     }
 
+    CullSubMeshes( cameraFrustum, localToWorld, nullptr );
+}
+
+void ae3d::MeshRendererComponent::CullSubMeshes( const Frustum& cameraFrustum, const Matrix44& localToWorld, const Vec3* cameraPosition )
+{
+    if (!mesh)
+    {
+        return;
+    }
+
+    isCulled = false;
+
     int subMeshCount = 0;
     SubMesh* subMeshes = mesh->GetSubMeshes( subMeshCount);
+    GrowSubMeshArrays( subMeshCount );
+
+    visibleFaceRanges.clear();
+    Vec3 localCameraPosition;
+    bool isLocalCameraPositionValid = false;
 
     for (int subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
     {
         isSubMeshCulled[ subMeshIndex ] = false;
+        firstVisibleFaceRange[ subMeshIndex ] = -1;
 
         if (materials[ subMeshIndex ] == nullptr || !materials[ subMeshIndex ]->IsValidShader())
         {
@@ -127,8 +154,135 @@ void ae3d::MeshRendererComponent::Cull( const class Frustum& cameraFrustum, cons
         if (!cameraFrustum.BoxInFrustum( meshAabbMinWorld, meshAabbMaxWorld ))
         {
             isSubMeshCulled[ subMeshIndex ] = true;
+            continue;
+        }
+
+        const std::vector< MeshCluster >& clusters = subMeshes[ subMeshIndex ].clusters;
+
+        // Clusters cover only LOD 0 faces.
+        if (clusters.empty() || (lod > 0 && subMeshes[ subMeshIndex ].lods.size() > 1))
+        {
+            continue;
+        }
+
+        if (cameraPosition != nullptr && !isLocalCameraPositionValid)
+        {
+            Matrix44 worldToLocal;
+            Matrix44::Invert( localToWorld, worldToLocal );
+            Matrix44::TransformPoint( *cameraPosition, worldToLocal, &localCameraPosition );
+            isLocalCameraPositionValid = true;
+        }
+
+        const bool cullBackFaces = isLocalCameraPositionValid && materials[ subMeshIndex ]->IsBackFaceCulled();
+        const std::size_t firstRange = visibleFaceRanges.size();
+        MathUtil::CullClusters( clusters.data(), (unsigned)clusters.size(), cameraFrustum, localToWorld, cullBackFaces ? &localCameraPosition : nullptr, visibleFaceRanges );
+
+        firstVisibleFaceRange[ subMeshIndex ] = (int)firstRange;
+        visibleFaceRangeCount[ subMeshIndex ] = (int)((visibleFaceRanges.size() - firstRange) / 2);
+
+        if (visibleFaceRangeCount[ subMeshIndex ] == 0)
+        {
+            isSubMeshCulled[ subMeshIndex ] = true;
+        }
+    }
+}
+
+void ae3d::MeshRendererComponent::SelectLod( const CameraComponent& camera, const Vec3& cameraPosition, const Matrix44& localToWorld, int viewportHeight, bool isShadowPass )
+{
+    lod = 0;
+
+    if (!mesh)
+    {
+        return;
+    }
+
+    const float scaleX = Vec3( localToWorld.m[ 0 ], localToWorld.m[ 1 ], localToWorld.m[ 2 ] ).Length();
+    const float scaleY = Vec3( localToWorld.m[ 4 ], localToWorld.m[ 5 ], localToWorld.m[ 6 ] ).Length();
+    const float scaleZ = Vec3( localToWorld.m[ 8 ], localToWorld.m[ 9 ], localToWorld.m[ 10 ] ).Length();
+    const float maxScale = std::max( scaleX, std::max( scaleY, scaleZ ) );
+    const float localDiameter = (mesh->GetAABBMax() - mesh->GetAABBMin()).Length();
+
+    // Converts mesh-local errors into pixels at the point of the mesh's bounding sphere closest to the camera.
+    float errorScale;
+
+    if (camera.GetProjectionType() == CameraComponent::ProjectionType::Perspective)
+    {
+        Vec3 worldCenter;
+        Matrix44::TransformPoint( (mesh->GetAABBMin() + mesh->GetAABBMax()) * 0.5f, localToWorld, &worldCenter );
+        const float radius = localDiameter * 0.5f * maxScale;
+        const float distance = std::max( (cameraPosition - worldCenter).Length() - radius, camera.GetNear() );
+        const float halfFovRadians = camera.GetFovDegrees() * 3.14159265358979f / 360.0f;
+        errorScale = maxScale * viewportHeight / (2 * distance * std::tan( halfFovRadians ));
+    }
+    else
+    {
+        const float orthoHeight = std::fabs( camera.GetTop() - camera.GetBottom() );
+        errorScale = orthoHeight > 0 ? maxScale * viewportHeight / orthoHeight : 0;
+    }
+
+    // Textures are assumed to be mapped once across the mesh, so the mesh's screen size is their screen size.
+    if (!isShadowPass)
+    {
+        for (unsigned materialIndex = 0; materialIndex < materials.count; ++materialIndex)
+        {
+            if (materials[ materialIndex ])
+            {
+                materials[ materialIndex ]->ReportTextureScreenSize( errorScale * localDiameter );
+            }
+        }
+    }
+
+    int subMeshCount = 0;
+    SubMesh* subMeshes = mesh->GetSubMeshes( subMeshCount );
+
+    // A mesh LOD's error is the largest error of its submeshes. Submeshes with fewer LODs use their coarsest one.
+    const int MaxLods = 16;
+    float lodErrors[ MaxLods ] = {};
+    int lodCount = 1;
+
+    for (int subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
+    {
+        const std::vector< MeshLod >& lods = subMeshes[ subMeshIndex ].lods;
+        lodCount = std::max( lodCount, std::min( (int)lods.size(), MaxLods ) );
+    }
+
+    if (lodCount == 1)
+    {
+        return;
+    }
+
+    for (int subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
+    {
+        const std::vector< MeshLod >& lods = subMeshes[ subMeshIndex ].lods;
+
+        for (int l = 0; l < lodCount && !lods.empty(); ++l)
+        {
+            lodErrors[ l ] = std::max( lodErrors[ l ], lods[ std::min( l, (int)lods.size() - 1 ) ].error );
+        }
+    }
+
+    const float bias = isShadowPass ? shadowLodBias : lodBias;
+
+    CameraLod* cameraLod = nullptr;
+
+    for (auto& candidate : cameraLods)
+    {
+        if (candidate.camera == &camera)
+        {
+            cameraLod = &candidate;
+            break;
         }
     }
+
+    if (cameraLod == nullptr)
+    {
+        cameraLods.push_back( { &camera, -1 } );
+        cameraLod = &cameraLods.back();
+    }
+
+    const float MaxPixelError = 1;
+    cameraLod->lod = MathUtil::SelectLod( lodErrors, lodCount, errorScale * bias, cameraLod->lod, MaxPixelError );
+    lod = cameraLod->lod;
 }
 
 void ae3d::MeshRendererComponent::ApplySkin( unsigned subMeshIndex )
@@ -165,6 +319,8 @@ void ae3d::MeshRendererComponent::Render( const Matrix44& localToView, const Mat
     
 	int subMeshCount = 0;
     SubMesh* subMeshes = mesh->GetSubMeshes( subMeshCount );
+    // The mesh can have finished an asynchronous load after it was culled.
+    subMeshCount = std::min( subMeshCount, (int)isSubMeshCulled.count );
 
     for (int subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
     {
@@ -249,8 +405,38 @@ void ae3d::MeshRendererComponent::Render( const Matrix44& localToView, const Mat
             depthFunc = GfxDevice::DepthFunc::NoneWriteOff;
         }
         
-        GfxDevice::Draw( subMeshes[ subMeshIndex ].vertexBuffer, 0, subMeshes[ subMeshIndex ].vertexBuffer.GetFaceCount() / 3,
-                         *shader, blendMode, depthFunc, cullMode, isWireframe ? GfxDevice::FillMode::Wireframe : GfxDevice::FillMode::Solid, GfxDevice::PrimitiveTopology::Triangles );
+        const GfxDevice::FillMode fillMode = isWireframe ? GfxDevice::FillMode::Wireframe : GfxDevice::FillMode::Solid;
+
+        const std::vector< MeshLod >& lods = subMeshes[ subMeshIndex ].lods;
+        const int subMeshLod = lods.empty() ? 0 : std::min( lod, (int)lods.size() - 1 );
+        int drawnFaces = 0;
+
+        if (firstVisibleFaceRange[ subMeshIndex ] != -1)
+        {
+            const unsigned* ranges = &visibleFaceRanges[ firstVisibleFaceRange[ subMeshIndex ] ];
+
+            for (int r = 0; r < visibleFaceRangeCount[ subMeshIndex ]; ++r)
+            {
+                GfxDevice::Draw( subMeshes[ subMeshIndex ].vertexBuffer, ranges[ r * 2 ], ranges[ r * 2 + 1 ],
+                                 *shader, blendMode, depthFunc, cullMode, fillMode, GfxDevice::PrimitiveTopology::Triangles );
+                drawnFaces += ranges[ r * 2 + 1 ] - ranges[ r * 2 ];
+            }
+        }
+        else if (!lods.empty())
+        {
+            const MeshLod& meshLod = lods[ subMeshLod ];
+            GfxDevice::Draw( subMeshes[ subMeshIndex ].vertexBuffer, meshLod.firstFace, meshLod.firstFace + meshLod.faceCount,
+                             *shader, blendMode, depthFunc, cullMode, fillMode, GfxDevice::PrimitiveTopology::Triangles );
+            drawnFaces = meshLod.faceCount;
+        }
+        else
+        {
+            drawnFaces = subMeshes[ subMeshIndex ].vertexBuffer.GetFaceCount() / 3;
+            GfxDevice::Draw( subMeshes[ subMeshIndex ].vertexBuffer, 0, drawnFaces,
+                             *shader, blendMode, depthFunc, cullMode, fillMode, GfxDevice::PrimitiveTopology::Triangles );
+        }
+
+        Statistics::IncMeshLodTriangleCount( subMeshLod, drawnFaces );
 
         if (isAabbDrawingEnabled)
         {
@@ -300,8 +486,25 @@ void ae3d::MeshRendererComponent::Render( const Matrix44& localToView, const Mat
     }
 }
 
+void ae3d::MeshRendererComponent::GrowSubMeshArrays( int subMeshCount )
+{
+    while ((int)materials.count < subMeshCount)
+    {
+        materials.Add( nullptr );
+        isSubMeshCulled.Add( true );
+        firstVisibleFaceRange.Add( -1 );
+        visibleFaceRangeCount.Add( 0 );
+    }
+}
+
 void ae3d::MeshRendererComponent::SetMaterial( Material* material, unsigned subMeshIndex )
 {
+    // A mesh that is loaded asynchronously can get more submeshes when the load finishes.
+    if (mesh != nullptr)
+    {
+        GrowSubMeshArrays( (int)subMeshIndex + 1 );
+    }
+
     if (subMeshIndex < materials.count )
     {
         materials[ subMeshIndex ] = material;
@@ -342,5 +545,15 @@ void ae3d::MeshRendererComponent::SetMesh( Mesh* aMesh )
         mesh->GetSubMeshes( subMeshCount );
         materials.Allocate( subMeshCount );
         isSubMeshCulled.Allocate( subMeshCount );
+        firstVisibleFaceRange.Allocate( subMeshCount );
+        visibleFaceRangeCount.Allocate( subMeshCount );
+
+        for (int subMeshIndex = 0; subMeshIndex < subMeshCount; ++subMeshIndex)
+        {
+            firstVisibleFaceRange[ subMeshIndex ] = -1;
+        }
     }
+
+    cameraLods.clear();
+    lod = 0;
 }
@@ -7,6 +7,7 @@
 #include "GfxDevice.hpp"
 #include "Renderer.hpp"
 #include "RenderTexture.hpp"
+#include "SpriteBatch.hpp"
 #include "System.hpp"
 #include "Texture2D.hpp"
 #include "TextureBase.hpp"
@@ -23,153 +24,63 @@ namespace GfxDeviceGlobal
     extern PerObjectUboStruct perObjectUboStruct;
 }
 
-struct Drawable
-{
-    ae3d::TextureBase* texture = ae3d::Texture2D::GetDefaultTexture();
-    int bufferStart = 0;
-    int bufferEnd = 0;
-};
-
-struct Sprite
-{
-    ae3d::TextureBase* texture = ae3d::Texture2D::GetDefaultTexture();
-    ae3d::Vec3 position;
-    ae3d::Vec3 dimension;
-    ae3d::Vec4 tint;
-};
-
-namespace
-{
-void CreateVertexBuffer( std::vector< Sprite >& sprites, ae3d::VertexBuffer& outVertexBuffer )
-{
-    const int quadVertexCount = 4;
-    const int quadFaceCount = 2;
-    std::vector< ae3d::VertexBuffer::VertexPTC > vertices( sprites.size() * quadVertexCount );
-    std::vector< ae3d::VertexBuffer::Face > faces( sprites.size() * quadFaceCount );
-    
-    // TODO: evaluate perf and consider other containers.
-    std::sort( sprites.begin(), sprites.end(), [](const Sprite& a, const Sprite& b) { return a.texture->GetID() < b.texture->GetID(); } );
-    
-    for (unsigned short i = 0; i < static_cast<unsigned short>(sprites.size()); ++i)
-    {
-        const auto& dim = sprites[ i ].dimension;
-        vertices[ i * quadVertexCount + 0 ].position = sprites[ i ].position;
-        vertices[ i * quadVertexCount + 1 ].position = sprites[ i ].position + ae3d::Vec3( dim.x, 0, 0 );
-        vertices[ i * quadVertexCount + 2 ].position = sprites[ i ].position + ae3d::Vec3( dim.x, dim.y, 0 );
-        vertices[ i * quadVertexCount + 3 ].position = sprites[ i ].position + ae3d::Vec3( 0, dim.y, 0 );
-        
-        for (int v = 0; v < quadVertexCount; ++v)
-        {
-            vertices[ i * quadVertexCount + v ].color = sprites[i].tint;
-        }
-        
-        const ae3d::Vec4& so = sprites[i].texture->GetScaleOffset();
-
-        const float u0 = 0.0f * so.x + so.z;
-        const float u1 = 1.0f * so.x + so.z;
-
-        const float v0 = 0.0f * so.y + so.w;
-        const float v1 = 1.0f * so.y + so.w;
-
-        vertices[ i * quadVertexCount + 0 ].u = u0;
-        vertices[ i * quadVertexCount + 0 ].v = v0;
-        
-        vertices[ i * quadVertexCount + 1 ].u = u1;
-        vertices[ i * quadVertexCount + 1 ].v = v0;
-        
-        vertices[ i * quadVertexCount + 2 ].u = u1;
-        vertices[ i * quadVertexCount + 2 ].v = v1;
-        
-        vertices[ i * quadVertexCount + 3 ].u = u0;
-        vertices[ i * quadVertexCount + 3 ].v = v1;
-        
-        auto& tri1 = faces[ i * quadFaceCount + 0 ];
-        tri1.a = i * quadVertexCount + 0;
-        tri1.b = i * quadVertexCount + 1;
-        tri1.c = i * quadVertexCount + 2;
-        
-        auto& tri2 = faces[ i * quadFaceCount + 1 ];
-        tri2.a = i * quadVertexCount + 2;
-        tri2.b = i * quadVertexCount + 3;
-        tri2.c = i * quadVertexCount + 0;
-    }
-    
-    outVertexBuffer.Generate( faces.data(), static_cast<int>(faces.size()), vertices.data(), static_cast<int>(vertices.size()), ae3d::VertexBuffer::Storage::GPU );
-    outVertexBuffer.SetDebugName( "sprite buffer" );
-}
-
-void CreateDrawables( const std::vector< Sprite >& sprites, std::vector< Drawable >& outDrawables )
-{
-    outDrawables.clear();
-    
-    if (sprites.empty())
-    {
-        return;
-    }
-    
-    outDrawables.emplace_back( Drawable() );
-    auto& back = outDrawables.back();
-    back.texture = sprites[0].texture;
-    back.bufferStart = 0;
-    back.bufferEnd = 2;
-    
-    for (std::size_t s = 1; s < sprites.size(); ++s)
-    {
-        if (sprites[s].texture == sprites[s - 1].texture)
-        {
-            outDrawables.back().bufferEnd += 2;
-        }
-        else
-        {
-            const int oldEnd = outDrawables.back().bufferEnd;
-            
-            outDrawables.emplace_back( Drawable() );
-            auto& back2 = outDrawables.back();
-            back2.texture = sprites[s].texture;
-            back2.bufferStart = oldEnd;
-            back2.bufferEnd = oldEnd + 2;
-        }
-    }
-}
-}
-
 struct RenderQueue
 {
     void Clear();
-    void Build();
+    void Upload();
     void Render( ae3d::GfxDevice::BlendMode blendMode, const float* localToClip );
     
-    bool isDirty = true;
-    std::vector< Sprite > sprites;
-    std::vector< Drawable > drawables;
+    ae3d::SpriteBatch batch;
     ae3d::VertexBuffer vertexBuffer;
+    int vertexCapacity = 0;
+    int faceCapacity = 0;
 };
 
 void RenderQueue::Clear()
 {
-    sprites.clear();
-    isDirty = true;
+    batch.Clear();
 }
 
-void RenderQueue::Build()
+// Writes sprites that changed since the previous frame into the dynamic buffer. The buffer is regenerated only when it's too small.
+void RenderQueue::Upload()
 {
-    if (!sprites.empty())
+    const bool areFacesChanged = batch.Update();
+    const auto& vertices = batch.GetVertices();
+    const auto& faces = batch.GetFaces();
+
+    if (static_cast< int >( vertices.size() ) > vertexCapacity || static_cast< int >( faces.size() ) > faceCapacity)
+    {
+        // Grows geometrically so that adding sprites one by one doesn't regenerate the buffer every frame.
+        vertexCapacity = std::max( static_cast< int >( vertices.size() ), vertexCapacity * 2 );
+        faceCapacity = vertexCapacity / 2;
+        vertexBuffer.GenerateDynamic( faceCapacity, vertexCapacity, ae3d::VertexBuffer::IndexType::UInt32 );
+        vertexBuffer.SetDebugName( "sprite buffer" );
+        vertexBuffer.UpdateDynamicVertices( vertices.data(), 0, static_cast< int >( vertices.size() ) );
+        vertexBuffer.UpdateDynamicFaces( faces.data(), static_cast< int >( faces.size() ) );
+        return;
+    }
+
+    for (const auto& range : batch.GetChangedVertexRanges())
     {
-        CreateVertexBuffer( sprites, vertexBuffer );
-        CreateDrawables( sprites, drawables );
+        vertexBuffer.UpdateDynamicVertices( &vertices[ range.firstVertex ], range.firstVertex, range.vertexCount );
     }
 
-    isDirty = false;
+    if (areFacesChanged)
+    {
+        vertexBuffer.UpdateDynamicFaces( faces.data(), static_cast< int >( faces.size() ) );
+    }
 }
 
 void RenderQueue::Render( ae3d::GfxDevice::BlendMode blendMode, const float* localToClip )
 {
-    if (isDirty)
+    if (batch.IsEmpty())
     {
-        Build();
+        return;
     }
+
+    Upload();
     
-    for (auto& drawable : drawables)
+    for (const auto& drawable : batch.GetDrawRanges())
     {
         renderer.builtinShaders.spriteRendererShader.Use();
         GfxDeviceGlobal::perObjectUboStruct.localToClip.InitFrom( localToClip );
@@ -184,7 +95,7 @@ void RenderQueue::Render( ae3d::GfxDevice::BlendMode blendMode, const float* loc
             renderer.builtinShaders.spriteRendererShader.SetTexture( static_cast< ae3d::Texture2D* >(drawable.texture), 0 );
         }
         
-        ae3d::GfxDevice::Draw( vertexBuffer, drawable.bufferStart, drawable.bufferEnd, renderer.builtinShaders.spriteRendererShader, blendMode,
+        ae3d::GfxDevice::Draw( vertexBuffer, drawable.faceStart, drawable.faceEnd, renderer.builtinShaders.spriteRendererShader, blendMode,
                                ae3d::GfxDevice::DepthFunc::NoneWriteOff, ae3d::GfxDevice::CullMode::Off, ae3d::GfxDevice::FillMode::Solid, ae3d::GfxDevice::PrimitiveTopology::Triangles );
     }
 }
@@ -197,9 +108,17 @@ struct ae3d::SpriteRendererComponent::Impl
         static_assert( ae3d::SpriteRendererComponent::StorageAlign % alignof( ae3d::SpriteRendererComponent::Impl ) == 0, "Impl misaligned!");
     }
 
+    /// Where a sprite returned by SetTexture() is.
+    struct SpriteSlot
+    {
+        bool isTransparent;
+        int slot;
+    };
+
     RenderQueue opaqueRenderQueue;
     RenderQueue transparentRenderQueue;
     std::vector< SpriteInfo > spriteInfos;
+    std::vector< SpriteSlot > spriteSlots;
 };
 
 unsigned ae3d::SpriteRendererComponent::New()
@@ -282,39 +201,47 @@ void ae3d::SpriteRendererComponent::Clear()
 {
     m().opaqueRenderQueue.Clear();
     m().transparentRenderQueue.Clear();
+    m().spriteInfos.clear();
+    m().spriteSlots.clear();
 }
 
-void ae3d::SpriteRendererComponent::SetTexture( TextureBase* aTexture, const Vec3& position, const Vec3& dimensionPixels,
-                                                 const Vec4& tintColor )
+int ae3d::SpriteRendererComponent::SetTexture( TextureBase* aTexture, const Vec3& position, const Vec3& dimensionPixels,
+                                                const Vec4& tintColor )
 {
     if (aTexture == nullptr)
     {
         aTexture = Texture2D::GetDefaultTexture();
     }
     
-    Sprite sprite;
-    sprite.texture = aTexture;
-    sprite.position = position;
-    sprite.dimension = dimensionPixels;
-    sprite.tint = tintColor;
-
     m().spriteInfos.emplace_back( SpriteInfo{ aTexture->GetPath(), position.x, position.y, dimensionPixels.x, dimensionPixels.y, true } );
 
-    if (!aTexture->IsOpaque() || static_cast<int>(tintColor.w) != 1)
-    {
-        m().transparentRenderQueue.sprites.emplace_back( sprite );
-        m().transparentRenderQueue.isDirty = true;
-    }
-    else
+    const bool isTransparent = !aTexture->IsOpaque() || static_cast<int>(tintColor.w) != 1;
+    RenderQueue& queue = isTransparent ? m().transparentRenderQueue : m().opaqueRenderQueue;
+    const int slot = queue.batch.Add( aTexture, aTexture->GetID(), aTexture->GetScaleOffset(), position, dimensionPixels, tintColor );
+    m().spriteSlots.push_back( { isTransparent, slot } );
+
+    return static_cast< int >( m().spriteSlots.size() ) - 1;
+}
+
+void ae3d::SpriteRendererComponent::SetSpritePosition( int spriteIndex, const Vec3& position )
+{
+    if (spriteIndex < 0 || spriteIndex >= static_cast< int >( m().spriteSlots.size() ))
     {
-        m().opaqueRenderQueue.sprites.emplace_back( sprite );
-        m().opaqueRenderQueue.isDirty = true;
+        System::Print( "SpriteRendererComponent: invalid sprite index: %d\n", spriteIndex );
+        return;
     }
+
+    const Impl::SpriteSlot& spriteSlot = m().spriteSlots[ spriteIndex ];
+    RenderQueue& queue = spriteSlot.isTransparent ? m().transparentRenderQueue : m().opaqueRenderQueue;
+    queue.batch.SetPosition( spriteSlot.slot, position );
+
+    m().spriteInfos[ spriteIndex ].x = position.x;
+    m().spriteInfos[ spriteIndex ].y = position.y;
 }
 
 void ae3d::SpriteRendererComponent::Render( const float* localToClip )
 {
-    if (!isEnabled || (m().transparentRenderQueue.sprites.empty() && m().opaqueRenderQueue.sprites.empty()))
+    if (!isEnabled || (m().transparentRenderQueue.batch.IsEmpty() && m().opaqueRenderQueue.batch.IsEmpty()))
     {
         return;
     }
@@ -0,0 +1,343 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "AssetRegistry.hpp"
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "System.hpp"
+
+using namespace ae3d;
+
+namespace AssetRegistryGlobal
+{
+    struct Entry
+    {
+        std::function< void() > release;
+        std::string key;
+        std::size_t sizeInBytes = 0;
+        /// Position in the category's unreferenced list. Valid while isListed is true.
+        std::list< unsigned >::iterator unreferencedIt;
+        AssetRegistry::Category category = AssetRegistry::Category::Texture;
+        unsigned generation = 0;
+        int refCount = 0;
+        bool isAlive = false;
+        /// True if Find() finds this entry by its key.
+        bool isRegistered = false;
+        bool isListed = false;
+    };
+
+    struct CategoryState
+    {
+        std::unordered_map< std::string, unsigned > keyToIndex;
+        /// Unreferenced assets that can be evicted, least recently used first. Unregistered assets are first.
+        std::list< unsigned > unreferenced;
+        std::size_t usage = 0;
+        std::size_t budget = 0;
+        unsigned assetCount = 0;
+    };
+
+    struct PendingRelease
+    {
+        std::function< void() > release;
+        unsigned evictionFrame = 0;
+    };
+
+    std::vector< Entry > entries;
+    std::vector< unsigned > freeIndices;
+    CategoryState categories[ static_cast< int >( AssetRegistry::Category::Count ) ];
+    std::vector< PendingRelease > pendingReleases;
+    unsigned frame = 0;
+    unsigned framesInFlight = 3;
+}
+
+static AssetRegistryGlobal::Entry* GetEntry( AssetRegistry::Handle handle )
+{
+    if (handle.generation == 0 || handle.index >= AssetRegistryGlobal::entries.size())
+    {
+        return nullptr;
+    }
+
+    AssetRegistryGlobal::Entry& entry = AssetRegistryGlobal::entries[ handle.index ];
+    return (entry.isAlive && entry.generation == handle.generation) ? &entry : nullptr;
+}
+
+static AssetRegistryGlobal::CategoryState& GetCategory( AssetRegistry::Category category )
+{
+    return AssetRegistryGlobal::categories[ static_cast< int >( category ) ];
+}
+
+static void RemoveFromUnreferenced( AssetRegistryGlobal::Entry& entry )
+{
+    if (entry.isListed)
+    {
+        GetCategory( entry.category ).unreferenced.erase( entry.unreferencedIt );
+        entry.isListed = false;
+    }
+}
+
+// Entries that can't be evicted are not listed.
+static void AddToUnreferenced( AssetRegistryGlobal::Entry& entry, unsigned index )
+{
+    if (entry.isListed || entry.refCount > 0 || !entry.release)
+    {
+        return;
+    }
+
+    std::list< unsigned >& unreferenced = GetCategory( entry.category ).unreferenced;
+    entry.unreferencedIt = unreferenced.insert( entry.isRegistered ? std::end( unreferenced ) : std::begin( unreferenced ), index );
+    entry.isListed = true;
+}
+
+static void RemoveKey( AssetRegistryGlobal::Entry& entry, unsigned index )
+{
+    if (!entry.isRegistered)
+    {
+        return;
+    }
+
+    auto& keyToIndex = GetCategory( entry.category ).keyToIndex;
+    const auto it = keyToIndex.find( entry.key );
+
+    if (it != std::end( keyToIndex ) && it->second == index)
+    {
+        keyToIndex.erase( it );
+    }
+
+    entry.isRegistered = false;
+}
+
+static void Evict( unsigned index )
+{
+    AssetRegistryGlobal::Entry& entry = AssetRegistryGlobal::entries[ index ];
+    AssetRegistryGlobal::CategoryState& category = GetCategory( entry.category );
+
+    RemoveFromUnreferenced( entry );
+    RemoveKey( entry, index );
+    category.usage -= entry.sizeInBytes;
+    --category.assetCount;
+
+    AssetRegistryGlobal::PendingRelease pending;
+    pending.release = std::move( entry.release );
+    pending.evictionFrame = AssetRegistryGlobal::frame;
+    AssetRegistryGlobal::pendingReleases.push_back( std::move( pending ) );
+
+    entry.release = nullptr;
+    entry.key.clear();
+    entry.isAlive = false;
+    AssetRegistryGlobal::freeIndices.push_back( index );
+}
+
+AssetRegistry::Handle AssetRegistry::Register( Category category, const std::string& key, std::size_t sizeInBytes, const std::function< void() >& release )
+{
+    unsigned index = 0;
+
+    if (!AssetRegistryGlobal::freeIndices.empty())
+    {
+        index = AssetRegistryGlobal::freeIndices.back();
+        AssetRegistryGlobal::freeIndices.pop_back();
+    }
+    else
+    {
+        index = static_cast< unsigned >( AssetRegistryGlobal::entries.size() );
+        AssetRegistryGlobal::entries.emplace_back();
+    }
+
+    AssetRegistryGlobal::CategoryState& categoryState = GetCategory( category );
+    const auto oldIt = categoryState.keyToIndex.find( key );
+
+    if (oldIt != std::end( categoryState.keyToIndex ))
+    {
+        Handle oldHandle;
+        oldHandle.index = oldIt->second;
+        oldHandle.generation = AssetRegistryGlobal::entries[ oldIt->second ].generation;
+        Unregister( oldHandle );
+    }
+
+    AssetRegistryGlobal::Entry& entry = AssetRegistryGlobal::entries[ index ];
+    // Generation 0 is reserved for invalid handles.
+    entry.generation = entry.generation + 1 != 0 ? entry.generation + 1 : 1;
+    entry.release = release;
+    entry.key = key;
+    entry.sizeInBytes = sizeInBytes;
+    entry.category = category;
+    entry.refCount = 1;
+    entry.isAlive = true;
+    entry.isRegistered = true;
+    entry.isListed = false;
+
+    categoryState.keyToIndex[ key ] = index;
+    categoryState.usage += sizeInBytes;
+    ++categoryState.assetCount;
+
+    Handle handle;
+    handle.index = index;
+    handle.generation = entry.generation;
+    return handle;
+}
+
+AssetRegistry::Handle AssetRegistry::Find( Category category, const std::string& key )
+{
+    const auto& keyToIndex = GetCategory( category ).keyToIndex;
+    const auto it = keyToIndex.find( key );
+    Handle handle;
+
+    if (it != std::end( keyToIndex ))
+    {
+        handle.index = it->second;
+        handle.generation = AssetRegistryGlobal::entries[ it->second ].generation;
+    }
+
+    return handle;
+}
+
+bool AssetRegistry::IsValid( Handle handle )
+{
+    return GetEntry( handle ) != nullptr;
+}
+
+void AssetRegistry::AddRef( Handle handle )
+{
+    AssetRegistryGlobal::Entry* entry = GetEntry( handle );
+
+    if (entry != nullptr)
+    {
+        RemoveFromUnreferenced( *entry );
+        ++entry->refCount;
+    }
+}
+
+void AssetRegistry::Release( Handle handle )
+{
+    AssetRegistryGlobal::Entry* entry = GetEntry( handle );
+
+    if (entry == nullptr || entry->refCount == 0)
+    {
+        return;
+    }
+
+    --entry->refCount;
+    AddToUnreferenced( *entry, handle.index );
+}
+
+int AssetRegistry::GetRefCount( Handle handle )
+{
+    const AssetRegistryGlobal::Entry* entry = GetEntry( handle );
+    return entry != nullptr ? entry->refCount : 0;
+}
+
+void AssetRegistry::Unregister( Handle handle )
+{
+    AssetRegistryGlobal::Entry* entry = GetEntry( handle );
+
+    if (entry == nullptr)
+    {
+        return;
+    }
+
+    RemoveKey( *entry, handle.index );
+
+    // Moves to the front.
+    RemoveFromUnreferenced( *entry );
+    AddToUnreferenced( *entry, handle.index );
+}
+
+void AssetRegistry::SetSize( Handle handle, std::size_t sizeInBytes )
+{
+    AssetRegistryGlobal::Entry* entry = GetEntry( handle );
+
+    if (entry != nullptr)
+    {
+        AssetRegistryGlobal::CategoryState& category = GetCategory( entry->category );
+        category.usage = category.usage - entry->sizeInBytes + sizeInBytes;
+        entry->sizeInBytes = sizeInBytes;
+    }
+}
+
+std::size_t AssetRegistry::GetMemoryUsage( Category category )
+{
+    return GetCategory( category ).usage;
+}
+
+void AssetRegistry::SetBudget( Category category, std::size_t budgetInBytes )
+{
+    GetCategory( category ).budget = budgetInBytes;
+}
+
+std::size_t AssetRegistry::GetBudget( Category category )
+{
+    return GetCategory( category ).budget;
+}
+
+void AssetRegistry::SetFramesInFlight( unsigned frameCount )
+{
+    AssetRegistryGlobal::framesInFlight = frameCount;
+}
+
+void AssetRegistry::EndFrame()
+{
+    for (auto& category : AssetRegistryGlobal::categories)
+    {
+        while (!category.unreferenced.empty())
+        {
+            const unsigned index = category.unreferenced.front();
+
+            if (category.usage <= category.budget && AssetRegistryGlobal::entries[ index ].isRegistered)
+            {
+                break;
+            }
+
+            Evict( index );
+        }
+    }
+
+    ++AssetRegistryGlobal::frame;
+
+    // Release functions can register assets, so the due ones are taken out first.
+    std::vector< std::function< void() > > dueReleases;
+    auto& pendingReleases = AssetRegistryGlobal::pendingReleases;
+
+    for (auto it = std::begin( pendingReleases ); it != std::end( pendingReleases ); )
+    {
+        if (AssetRegistryGlobal::frame - it->evictionFrame >= AssetRegistryGlobal::framesInFlight)
+        {
+            dueReleases.push_back( std::move( it->release ) );
+            it = pendingReleases.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (auto& release : dueReleases)
+    {
+        release();
+    }
+}
+
+void AssetRegistry::ReleaseEvicted()
+{
+    std::vector< AssetRegistryGlobal::PendingRelease > pendingReleases;
+    pendingReleases.swap( AssetRegistryGlobal::pendingReleases );
+
+    for (auto& pending : pendingReleases)
+    {
+        pending.release();
+    }
+}
+
+void AssetRegistry::PrintMemoryUsage()
+{
+    const char* names[] = { "texture", "mesh", "audio", "font" };
+    static_assert( sizeof( names ) / sizeof( names[ 0 ] ) == static_cast< std::size_t >( Category::Count ), "names must match categories" );
+
+    for (int categoryIndex = 0; categoryIndex < static_cast< int >( Category::Count ); ++categoryIndex)
+    {
+        const AssetRegistryGlobal::CategoryState& category = AssetRegistryGlobal::categories[ categoryIndex ];
+        System::Print( "%s: %u KiB in %u assets, %u unreferenced, budget %u KiB\n", names[ categoryIndex ], (unsigned)(category.usage / 1024),
+                       category.assetCount, (unsigned)category.unreferenced.size(), (unsigned)(category.budget / 1024) );
+    }
+
+    System::Print( "%u assets waiting for release\n", (unsigned)AssetRegistryGlobal::pendingReleases.size() );
+}
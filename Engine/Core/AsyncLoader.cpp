@@ -0,0 +1,276 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "AsyncLoader.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ae3d;
+
+namespace AsyncLoaderGlobal
+{
+    struct Job
+    {
+        AsyncLoader::Handle handle = 0;
+        std::function< bool() > load;
+        std::function< bool( bool ) > finish;
+        bool loaded = false;
+    };
+
+    std::mutex mutex;
+    std::condition_variable jobQueued;
+    std::condition_variable jobLoaded;
+    std::deque< Job > queuedJobs;
+    std::deque< Job > loadedJobs;
+    std::vector< std::thread > workers;
+    /// State of each handle, indexed by handle - 1.
+    std::vector< AsyncLoader::State > states;
+    /// True for each handle whose load has run, indexed by handle - 1.
+    std::vector< bool > loadedStates;
+    int loadingJobCount = 0;
+    bool isQuitting = false;
+}
+
+static void SetState( AsyncLoader::Handle handle, AsyncLoader::State state )
+{
+    AsyncLoaderGlobal::states[ handle - 1 ] = state;
+}
+
+// Called with the mutex locked.
+static bool IsLoaded( AsyncLoader::Handle handle )
+{
+    return handle == 0 || handle > AsyncLoaderGlobal::states.size() || AsyncLoaderGlobal::states[ handle - 1 ] != AsyncLoader::State::Pending ||
+           AsyncLoaderGlobal::loadedStates[ handle - 1 ] || AsyncLoaderGlobal::workers.empty();
+}
+
+// Finish can queue new loads, so it's called without holding the lock.
+static void FinishJob( const AsyncLoaderGlobal::Job& job )
+{
+    const bool isReady = job.finish ? job.finish( job.loaded ) : job.loaded;
+
+    std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+    SetState( job.handle, isReady ? AsyncLoader::State::Ready : AsyncLoader::State::Failed );
+}
+
+static void WorkerMain()
+{
+    std::unique_lock< std::mutex > lock( AsyncLoaderGlobal::mutex );
+
+    while (true)
+    {
+        AsyncLoaderGlobal::jobQueued.wait( lock, [] { return AsyncLoaderGlobal::isQuitting || !AsyncLoaderGlobal::queuedJobs.empty(); } );
+
+        if (AsyncLoaderGlobal::isQuitting)
+        {
+            return;
+        }
+
+        AsyncLoaderGlobal::Job job = std::move( AsyncLoaderGlobal::queuedJobs.front() );
+        AsyncLoaderGlobal::queuedJobs.pop_front();
+        ++AsyncLoaderGlobal::loadingJobCount;
+
+        lock.unlock();
+        job.loaded = job.load();
+        lock.lock();
+
+        --AsyncLoaderGlobal::loadingJobCount;
+        AsyncLoaderGlobal::loadedStates[ job.handle - 1 ] = true;
+        AsyncLoaderGlobal::loadedJobs.push_back( std::move( job ) );
+        AsyncLoaderGlobal::jobLoaded.notify_all();
+    }
+}
+
+void ae3d::AsyncLoader::Init( unsigned workerCount )
+{
+    if (!AsyncLoaderGlobal::workers.empty())
+    {
+        return;
+    }
+
+    if (workerCount == 0)
+    {
+        const unsigned hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 2 ? hardwareThreads - 1 : 1;
+    }
+
+    AsyncLoaderGlobal::isQuitting = false;
+
+    for (unsigned w = 0; w < workerCount; ++w)
+    {
+        AsyncLoaderGlobal::workers.push_back( std::thread( WorkerMain ) );
+    }
+}
+
+void ae3d::AsyncLoader::Deinit()
+{
+    {
+        std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+        AsyncLoaderGlobal::isQuitting = true;
+    }
+
+    AsyncLoaderGlobal::jobQueued.notify_all();
+
+    for (auto& worker : AsyncLoaderGlobal::workers)
+    {
+        worker.join();
+    }
+
+    AsyncLoaderGlobal::workers.clear();
+
+    for (const auto& job : AsyncLoaderGlobal::queuedJobs)
+    {
+        SetState( job.handle, State::Failed );
+    }
+
+    for (const auto& job : AsyncLoaderGlobal::loadedJobs)
+    {
+        SetState( job.handle, State::Failed );
+    }
+
+    AsyncLoaderGlobal::queuedJobs.clear();
+    AsyncLoaderGlobal::loadedJobs.clear();
+}
+
+AsyncLoader::Handle ae3d::AsyncLoader::Queue( const std::function< bool() >& load, const std::function< bool( bool ) >& finish )
+{
+    Init( 0 );
+
+    AsyncLoaderGlobal::Job job;
+    job.load = load;
+    job.finish = finish;
+    Handle handle = 0;
+
+    {
+        std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+        AsyncLoaderGlobal::states.push_back( State::Pending );
+        AsyncLoaderGlobal::loadedStates.push_back( !job.load );
+        handle = static_cast< Handle >( AsyncLoaderGlobal::states.size() );
+        job.handle = handle;
+
+        // Nothing to do on a worker, so the job can be finished in the next Update().
+        if (!job.load)
+        {
+            job.loaded = true;
+            AsyncLoaderGlobal::loadedJobs.push_back( std::move( job ) );
+            return handle;
+        }
+
+        AsyncLoaderGlobal::queuedJobs.push_back( std::move( job ) );
+    }
+
+    AsyncLoaderGlobal::jobQueued.notify_one();
+
+    return handle;
+}
+
+AsyncLoader::State ae3d::AsyncLoader::GetState( Handle handle )
+{
+    std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+    return (handle == 0 || handle > AsyncLoaderGlobal::states.size()) ? State::Invalid : AsyncLoaderGlobal::states[ handle - 1 ];
+}
+
+int ae3d::AsyncLoader::GetPendingCount()
+{
+    std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+    return static_cast< int >( AsyncLoaderGlobal::queuedJobs.size() + AsyncLoaderGlobal::loadedJobs.size() ) + AsyncLoaderGlobal::loadingJobCount;
+}
+
+int ae3d::AsyncLoader::Update( float budgetMs )
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    int finishedCount = 0;
+
+    while (true)
+    {
+        AsyncLoaderGlobal::Job job;
+
+        {
+            std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+
+            if (AsyncLoaderGlobal::loadedJobs.empty())
+            {
+                break;
+            }
+
+            job = std::move( AsyncLoaderGlobal::loadedJobs.front() );
+            AsyncLoaderGlobal::loadedJobs.pop_front();
+        }
+
+        FinishJob( job );
+        ++finishedCount;
+
+        const std::chrono::duration< float, std::milli > elapsed = std::chrono::steady_clock::now() - startTime;
+
+        if (elapsed.count() >= budgetMs)
+        {
+            break;
+        }
+    }
+
+    return finishedCount;
+}
+
+void ae3d::AsyncLoader::Wait()
+{
+    std::unique_lock< std::mutex > lock( AsyncLoaderGlobal::mutex );
+    AsyncLoaderGlobal::jobLoaded.wait( lock, [] { return (AsyncLoaderGlobal::queuedJobs.empty() && AsyncLoaderGlobal::loadingJobCount == 0) || AsyncLoaderGlobal::workers.empty(); } );
+}
+
+void ae3d::AsyncLoader::Wait( const std::vector< Handle >& handles )
+{
+    std::unique_lock< std::mutex > lock( AsyncLoaderGlobal::mutex );
+
+    for (const Handle handle : handles)
+    {
+        AsyncLoaderGlobal::jobLoaded.wait( lock, [handle] { return IsLoaded( handle ); } );
+    }
+}
+
+void ae3d::AsyncLoader::Finish( const std::vector< Handle >& handles )
+{
+    Wait( handles );
+
+    for (const Handle handle : handles)
+    {
+        AsyncLoaderGlobal::Job job;
+
+        {
+            std::lock_guard< std::mutex > lock( AsyncLoaderGlobal::mutex );
+            const auto it = std::find_if( std::begin( AsyncLoaderGlobal::loadedJobs ), std::end( AsyncLoaderGlobal::loadedJobs ),
+                                          [handle]( const AsyncLoaderGlobal::Job& loadedJob ) { return loadedJob.handle == handle; } );
+
+            // Already finished, dropped by Deinit() or not a handle.
+            if (it == std::end( AsyncLoaderGlobal::loadedJobs ))
+            {
+                continue;
+            }
+
+            job = std::move( *it );
+            AsyncLoaderGlobal::loadedJobs.erase( it );
+        }
+
+        FinishJob( job );
+    }
+}
+
+void ae3d::AsyncLoader::Flush()
+{
+    while (GetPendingCount() > 0)
+    {
+        {
+            std::unique_lock< std::mutex > lock( AsyncLoaderGlobal::mutex );
+            AsyncLoaderGlobal::jobLoaded.wait( lock, [] { return !AsyncLoaderGlobal::loadedJobs.empty() || AsyncLoaderGlobal::workers.empty(); } );
+
+            if (AsyncLoaderGlobal::loadedJobs.empty())
+            {
+                return;
+            }
+        }
+
+        Update( 1000000.0f );
+    }
+}
@@ -7,6 +7,7 @@
 #define STB_VORBIS_HEADER_ONLY
 #include "stb_vorbis.c"
 #include "Array.hpp"
+#include "AssetRegistry.hpp"
 #include "FileSystem.hpp"
 #include "FileWatcher.hpp"
 #include "System.hpp"
@@ -19,6 +20,8 @@ struct ClipInfo
     ALuint srcID = 0;
     std::string path;
     float lengthInSeconds = 0;
+    /// Clip ids are indices, so clips are only accounted in AssetRegistry, not evicted.
+    ae3d::AssetRegistry::Handle assetHandle;
 };
 
 namespace AudioGlobal
@@ -223,6 +226,13 @@ void LoadWav( const ae3d::FileSystem::FileContentsData& clipData, ClipInfo& info
 }
 }
 
+static std::size_t GetBufferSize( ALuint bufID )
+{
+    ALint size = 0;
+    alGetBufferi( bufID, AL_SIZE, &size );
+    return static_cast< std::size_t >( size );
+}
+
 void AudioReload( const std::string& path )
 {
     for (ClipInfo *it = AudioGlobal::clips.elements; it != AudioGlobal::clips.elements + AudioGlobal::clips.count; ++it)
@@ -243,6 +253,8 @@ void AudioReload( const std::string& path )
             {
                 ae3d::System::Print( "Unhandled file format %s\n", extension.c_str() );
             }
+
+            ae3d::AssetRegistry::SetSize( it->assetHandle, GetBufferSize( it->bufID ) );
         }
     }
 }
@@ -308,8 +320,6 @@ unsigned ae3d::AudioSystem::GetClipIdForData( const FileSystem::FileContentsData
     alGenBuffers( 1, &info.bufID );
     alGenSources( 1, &info.srcID );
 
-    AudioGlobal::clips.Add( info );
-
     const std::string extension = clipData.path.substr( clipData.path.length() - 3, clipData.path.length() );
     
     if (extension == "wav" || extension == "WAV")
@@ -330,6 +340,9 @@ unsigned ae3d::AudioSystem::GetClipIdForData( const FileSystem::FileContentsData
     alSourcei( info.srcID, AL_BUFFER, info.bufID );
     alSourcef( info.srcID, AL_GAIN, 1.0f );
 
+    info.assetHandle = AssetRegistry::Register( AssetRegistry::Category::Audio, clipData.path, GetBufferSize( info.bufID ), nullptr );
+    AudioGlobal::clips.Add( info );
+
     fileWatcher.AddFile( clipData.path, AudioReload );
 
     return clipId;
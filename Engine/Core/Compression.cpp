@@ -0,0 +1,389 @@
+#include "Compression.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// LZ4 block format: a sequence is a token, literals and a match. Token's high 4 bits are literal length and low 4 bits
+// are match length - MinMatch. Lengths of 15 or more continue in the following bytes. Match offset is a little-endian
+// uint16. The last sequence has only literals. Last LastLiterals bytes are literals and the last match starts at
+// least MatchFindLimit bytes before the end, as in the reference implementation, so any LZ4 decoder reads the output.
+
+namespace
+{
+    const std::size_t MinMatch = 4;
+    const std::size_t LastLiterals = 5;
+    const std::size_t MatchFindLimit = 12;
+    const std::size_t MaxOffset = 65535;
+    const unsigned FastHashBits = 12;
+    const unsigned HighHashBits = 16;
+    const int HighMaxAttempts = 256;
+
+    uint32_t Read32( const unsigned char* p )
+    {
+        uint32_t value;
+        std::memcpy( &value, p, sizeof( value ) );
+        return value;
+    }
+
+    uint32_t Hash( uint32_t value, unsigned bits )
+    {
+        return (value * 2654435761u) >> (32 - bits);
+    }
+
+    std::size_t CountMatch( const unsigned char* earlier, const unsigned char* current, const unsigned char* currentEnd )
+    {
+        const unsigned char* start = current;
+
+        while (current < currentEnd && *current == *earlier)
+        {
+            ++current;
+            ++earlier;
+        }
+
+        return static_cast< std::size_t >( current - start );
+    }
+
+    std::size_t GetLengthBytes( std::size_t length )
+    {
+        return length >= 15 ? (length - 15) / 255 + 1 : 0;
+    }
+
+    void WriteLength( std::size_t length, unsigned char*& ioDestination )
+    {
+        for (length -= 15; length >= 255; length -= 255)
+        {
+            *ioDestination++ = 255;
+        }
+
+        *ioDestination++ = static_cast< unsigned char >( length );
+    }
+
+    // Writes a sequence. matchLength is 0 for the last sequence.
+    bool WriteSequence( const unsigned char* literals, std::size_t literalLength, std::size_t offset, std::size_t matchLength,
+                        unsigned char* destination, std::size_t destinationCapacity, std::size_t& ioPosition )
+    {
+        const std::size_t matchCode = matchLength > 0 ? matchLength - MinMatch : 0;
+        const std::size_t size = 1 + GetLengthBytes( literalLength ) + literalLength + (matchLength > 0 ? 2 + GetLengthBytes( matchCode ) : 0);
+
+        if (size > destinationCapacity - ioPosition)
+        {
+            return false;
+        }
+
+        unsigned char* out = destination + ioPosition;
+        unsigned char* token = out++;
+        *token = static_cast< unsigned char >( std::min< std::size_t >( literalLength, 15 ) << 4 );
+
+        if (literalLength >= 15)
+        {
+            WriteLength( literalLength, out );
+        }
+
+        if (literalLength > 0)
+        {
+            std::memcpy( out, literals, literalLength );
+            out += literalLength;
+        }
+
+        if (matchLength > 0)
+        {
+            *out++ = static_cast< unsigned char >( offset & 0xFF );
+            *out++ = static_cast< unsigned char >( offset >> 8 );
+            *token |= static_cast< unsigned char >( std::min< std::size_t >( matchCode, 15 ) );
+
+            if (matchCode >= 15)
+            {
+                WriteLength( matchCode, out );
+            }
+        }
+
+        ioPosition = static_cast< std::size_t >( out - destination );
+        return true;
+    }
+
+    std::size_t CompressFast( const unsigned char* source, std::size_t sourceSize, unsigned char* destination, std::size_t destinationCapacity )
+    {
+        std::size_t outPosition = 0;
+        std::size_t anchor = 0;
+
+        if (sourceSize > MatchFindLimit)
+        {
+            uint32_t table[ 1 << FastHashBits ] = {};
+            const std::size_t matchLimit = sourceSize - LastLiterals;
+            std::size_t position = 0;
+
+            while (position + MatchFindLimit < sourceSize)
+            {
+                const uint32_t hash = Hash( Read32( source + position ), FastHashBits );
+                std::size_t candidate = table[ hash ];
+                table[ hash ] = static_cast< uint32_t >( position );
+
+                if (candidate >= position || position - candidate > MaxOffset || Read32( source + candidate ) != Read32( source + position ))
+                {
+                    // Skips faster through data that doesn't compress.
+                    position += 1 + ((position - anchor) >> 6);
+                    continue;
+                }
+
+                while (position > anchor && candidate > 0 && source[ position - 1 ] == source[ candidate - 1 ])
+                {
+                    --position;
+                    --candidate;
+                }
+
+                const std::size_t matchLength = MinMatch + CountMatch( source + candidate + MinMatch, source + position + MinMatch, source + matchLimit );
+
+                if (!WriteSequence( source + anchor, position - anchor, position - candidate, matchLength, destination, destinationCapacity, outPosition ))
+                {
+                    return 0;
+                }
+
+                position += matchLength;
+                anchor = position;
+
+                if (position + MatchFindLimit < sourceSize)
+                {
+                    table[ Hash( Read32( source + position - 2 ), FastHashBits ) ] = static_cast< uint32_t >( position - 2 );
+                }
+            }
+        }
+
+        if (!WriteSequence( source + anchor, sourceSize - anchor, 0, 0, destination, destinationCapacity, outPosition ))
+        {
+            return 0;
+        }
+
+        return outPosition;
+    }
+
+    struct HashChain
+    {
+        explicit HashChain( std::size_t sourceSize ) : heads( 1 << HighHashBits, -1 ), previous( sourceSize, -1 ) {}
+
+        void Insert( const unsigned char* source, std::size_t position )
+        {
+            const uint32_t hash = Hash( Read32( source + position ), HighHashBits );
+            previous[ position ] = heads[ hash ];
+            heads[ hash ] = static_cast< int64_t >( position );
+        }
+
+        // \return Length of the longest match at position, or 0 if there is none.
+        std::size_t FindLongest( const unsigned char* source, std::size_t position, std::size_t matchLimit, std::size_t& outCandidate ) const
+        {
+            std::size_t longest = 0;
+            int attempts = HighMaxAttempts;
+
+            for (int64_t candidate = heads[ Hash( Read32( source + position ), HighHashBits ) ];
+                 candidate >= 0 && position - static_cast< std::size_t >( candidate ) <= MaxOffset && attempts > 0;
+                 candidate = previous[ static_cast< std::size_t >( candidate ) ], --attempts)
+            {
+                const unsigned char* match = source + candidate;
+
+                if (position + longest < matchLimit && match[ longest ] == source[ position + longest ] && Read32( match ) == Read32( source + position ))
+                {
+                    const std::size_t length = MinMatch + CountMatch( match + MinMatch, source + position + MinMatch, source + matchLimit );
+
+                    if (length > longest)
+                    {
+                        longest = length;
+                        outCandidate = static_cast< std::size_t >( candidate );
+                    }
+                }
+            }
+
+            return longest;
+        }
+
+        std::vector< int64_t > heads;
+        std::vector< int64_t > previous;
+    };
+
+    std::size_t CompressHigh( const unsigned char* source, std::size_t sourceSize, unsigned char* destination, std::size_t destinationCapacity )
+    {
+        std::size_t outPosition = 0;
+        std::size_t anchor = 0;
+
+        if (sourceSize > MatchFindLimit)
+        {
+            HashChain chain( sourceSize );
+            const std::size_t matchLimit = sourceSize - LastLiterals;
+            std::size_t nextInsert = 0;
+            std::size_t position = 0;
+
+            while (position + MatchFindLimit < sourceSize)
+            {
+                for (; nextInsert < position; ++nextInsert)
+                {
+                    chain.Insert( source, nextInsert );
+                }
+
+                std::size_t candidate = 0;
+                std::size_t matchLength = chain.FindLongest( source, position, matchLimit, candidate );
+
+                if (matchLength < MinMatch)
+                {
+                    ++position;
+                    continue;
+                }
+
+                // Emits a literal instead if a longer match starts at the next byte.
+                while (position + 1 + MatchFindLimit < sourceSize)
+                {
+                    chain.Insert( source, nextInsert++ );
+                    std::size_t nextCandidate = 0;
+                    const std::size_t nextLength = chain.FindLongest( source, position + 1, matchLimit, nextCandidate );
+
+                    if (nextLength <= matchLength)
+                    {
+                        break;
+                    }
+
+                    ++position;
+                    matchLength = nextLength;
+                    candidate = nextCandidate;
+                }
+
+                if (!WriteSequence( source + anchor, position - anchor, position - candidate, matchLength, destination, destinationCapacity, outPosition ))
+                {
+                    return 0;
+                }
+
+                position += matchLength;
+                anchor = position;
+            }
+        }
+
+        if (!WriteSequence( source + anchor, sourceSize - anchor, 0, 0, destination, destinationCapacity, outPosition ))
+        {
+            return 0;
+        }
+
+        return outPosition;
+    }
+
+    bool ReadLength( const unsigned char* source, std::size_t sourceSize, std::size_t maxLength, std::size_t& ioPosition, std::size_t& ioLength )
+    {
+        unsigned char byte = 255;
+
+        while (byte == 255)
+        {
+            if (ioPosition >= sourceSize)
+            {
+                return false;
+            }
+
+            byte = source[ ioPosition++ ];
+            ioLength += byte;
+
+            if (ioLength > maxLength)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+std::size_t ae3d::Compression::GetMaxCompressedSize( std::size_t sourceSize )
+{
+    return sourceSize + sourceSize / 255 + 16;
+}
+
+std::size_t ae3d::Compression::Compress( const unsigned char* source, std::size_t sourceSize, unsigned char* destination, std::size_t destinationCapacity, Level level )
+{
+    if (level == Level::High)
+    {
+        return CompressHigh( source, sourceSize, destination, destinationCapacity );
+    }
+
+    return CompressFast( source, sourceSize, destination, destinationCapacity );
+}
+
+bool ae3d::Compression::Decompress( const unsigned char* source, std::size_t sourceSize, unsigned char* destination, std::size_t destinationSize )
+{
+    std::size_t inPosition = 0;
+    std::size_t outPosition = 0;
+
+    while (inPosition < sourceSize)
+    {
+        const unsigned char token = source[ inPosition++ ];
+        std::size_t literalLength = token >> 4;
+
+        if (literalLength == 15 && !ReadLength( source, sourceSize, destinationSize, inPosition, literalLength ))
+        {
+            return false;
+        }
+
+        if (literalLength > sourceSize - inPosition || literalLength > destinationSize - outPosition)
+        {
+            return false;
+        }
+
+        // Short literals are copied as 16 bytes when both buffers have room. Bytes past the literals are overwritten later.
+        if (literalLength <= 16 && sourceSize - inPosition >= 16 && destinationSize - outPosition >= 16)
+        {
+            std::memcpy( destination + outPosition, source + inPosition, 16 );
+        }
+        else if (literalLength > 0)
+        {
+            std::memcpy( destination + outPosition, source + inPosition, literalLength );
+        }
+
+        inPosition += literalLength;
+        outPosition += literalLength;
+
+        if (inPosition == sourceSize)
+        {
+            return outPosition == destinationSize;
+        }
+
+        if (sourceSize - inPosition < 2)
+        {
+            return false;
+        }
+
+        const std::size_t offset = source[ inPosition ] | (source[ inPosition + 1 ] << 8);
+        inPosition += 2;
+        std::size_t matchLength = token & 15;
+
+        if (matchLength == 15 && !ReadLength( source, sourceSize, destinationSize, inPosition, matchLength ))
+        {
+            return false;
+        }
+
+        matchLength += MinMatch;
+
+        if (offset == 0 || offset > outPosition || matchLength > destinationSize - outPosition)
+        {
+            return false;
+        }
+
+        const std::size_t matchPosition = outPosition - offset;
+
+        // Matches that don't overlap their 16-byte copies are copied in 16-byte chunks when destination has room.
+        if (offset >= 16 && destinationSize - outPosition >= matchLength + 16)
+        {
+            for (std::size_t i = 0; i < matchLength; i += 16)
+            {
+                std::memcpy( destination + outPosition + i, destination + matchPosition + i, 16 );
+            }
+
+            outPosition += matchLength;
+            continue;
+        }
+
+        // Overlapping matches repeat the bytes between match and output. Each copy doubles the distance it can copy.
+
+        while (matchLength > 0)
+        {
+            const std::size_t copyLength = std::min( outPosition - matchPosition, matchLength );
+            std::memcpy( destination + outPosition, destination + matchPosition, copyLength );
+            outPosition += copyLength;
+            matchLength -= copyLength;
+        }
+    }
+
+    return false;
+}
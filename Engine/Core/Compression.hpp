@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ae3d
+{
+    /// LZ4 block format codec. Both levels produce data that Decompress() and other LZ4 block decoders read.
+    /// Used by .pak files, see PakFormat.hpp.
+    namespace Compression
+    {
+        enum class Level
+        {
+            /// Greedy search in a small hash table. Compresses quickly.
+            Fast,
+            /// Searches hash chains and defers matches by one byte when the next match is longer. Compresses slowly for a better ratio. Decompresses as fast as Fast.
+            High
+        };
+
+        /// \return Size of a destination buffer that is large enough for any source of sourceSize bytes.
+        std::size_t GetMaxCompressedSize( std::size_t sourceSize );
+
+        /// Compresses source into destination.
+        /// \param source Data to compress.
+        /// \param sourceSize Size of source in bytes.
+        /// \param destination Receives compressed data.
+        /// \param destinationCapacity Size of destination in bytes.
+        /// \param level Compression level.
+        /// \return Compressed size in bytes, or 0 if destination is too small.
+        std::size_t Compress( const unsigned char* source, std::size_t sourceSize, unsigned char* destination, std::size_t destinationCapacity, Level level );
+
+        /// Decompresses source into destination. Never reads or writes outside the buffers, even if source is corrupted.
+        /// \param source Compressed data.
+        /// \param sourceSize Size of source in bytes.
+        /// \param destination Receives decompressed data.
+        /// \param destinationSize Decompressed size in bytes.
+        /// \return True if source is valid and decompresses into exactly destinationSize bytes.
+        bool Decompress( const unsigned char* source, std::size_t sourceSize, unsigned char* destination, std::size_t destinationSize );
+    }
+}
@@ -1,8 +1,28 @@
 #include "FileSystem.hpp"
+#include "Compression.hpp"
+#include "PakFormat.hpp"
 #include "System.hpp"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
 #include <vector>
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #if VK_USE_PLATFORM_ANDROID_KHR
 #include <android/asset_manager.h>
 #endif
@@ -28,29 +48,462 @@ const char* GetFullPath( const char* fileName )
 #else
 const char* GetFullPath( const char* fileName )
 {
-    static std::string fName;
+    // Thread-local because AsyncLoader workers read files.
+    static thread_local std::string fName;
     fName = fileName;
     std::replace( std::begin( fName ), std::end( fName ), '\\', '/' );
     return fName.c_str();
 }
 #endif
 
+// Mapped .pak file. Entries are read in place.
 struct PakFile
 {
-    struct FileEntry
+    std::string path;
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+    const ae3d::Pak::Header* header = nullptr;
+    const uint32_t* buckets = nullptr;
+    const ae3d::Pak::Entry* entries = nullptr;
+    const char* paths = nullptr;
+};
+
+// Threads that help ReadPakEntry() callers decompress blocks. They are started by the first read that spans many blocks
+// and kept until exit, so reads don't create threads.
+class BlockReaderPool
+{
+public:
+    ~BlockReaderPool()
+    {
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            isQuitting = true;
+        }
+
+        jobQueued.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // Runs readBlocks on the calling thread and on at most threadCount - 1 workers. readBlocks must return when there are no blocks left.
+    void Run( const std::function< void() >& readBlocks, uint64_t threadCount )
+    {
+        // Jobs of this call are identified by the address of their counter.
+        int pendingCount = 0;
+
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+
+            if (workers.empty())
+            {
+                const unsigned hardwareThreads = std::thread::hardware_concurrency();
+
+                for (unsigned w = 1; w < hardwareThreads; ++w)
+                {
+                    workers.push_back( std::thread( &BlockReaderPool::WorkerMain, this ) );
+                }
+            }
+
+            for (uint64_t t = 1; t < threadCount && t <= workers.size(); ++t)
+            {
+                jobs.push_back( Job{ &readBlocks, &pendingCount } );
+                ++pendingCount;
+            }
+        }
+
+        jobQueued.notify_all();
+        readBlocks();
+
+        std::unique_lock< std::mutex > lock( mutex );
+
+        // Blocks are done when the caller returns, so jobs that no worker has started are not needed.
+        const auto firstRemoved = std::remove_if( std::begin( jobs ), std::end( jobs ), [&]( const Job& job ) { return job.pendingCount == &pendingCount; } );
+        pendingCount -= static_cast< int >( std::end( jobs ) - firstRemoved );
+        jobs.erase( firstRemoved, std::end( jobs ) );
+        jobDone.wait( lock, [&] { return pendingCount == 0; } );
+    }
+
+private:
+    struct Job
     {
-        std::string path;
-        std::vector< unsigned char > contents;
+        const std::function< void() >* readBlocks;
+        int* pendingCount;
     };
 
-    std::vector< FileEntry > entries;
-    std::string path;
+    void WorkerMain()
+    {
+        std::unique_lock< std::mutex > lock( mutex );
+
+        while (true)
+        {
+            jobQueued.wait( lock, [this] { return isQuitting || !jobs.empty(); } );
+
+            if (isQuitting)
+            {
+                return;
+            }
+
+            const Job job = jobs.front();
+            jobs.pop_front();
+
+            lock.unlock();
+            (*job.readBlocks)();
+            lock.lock();
+
+            --*job.pendingCount;
+            jobDone.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable jobQueued;
+    std::condition_variable jobDone;
+    std::deque< Job > jobs;
+    std::vector< std::thread > workers;
+    bool isQuitting = false;
 };
 
 namespace Global
 {
-    PakFile pakFiles[ 5 ];
-	unsigned packFileCount = 0;
+    // Searched in load order.
+    std::vector< PakFile > pakFiles;
+    // Guards pakFiles, because AsyncLoader workers search it while the main thread can load .pak files.
+    std::mutex pakFilesMutex;
+    // ReadPakEntry() uses one thread per this many compressed blocks.
+    const uint64_t blocksPerThread = 4;
+    BlockReaderPool blockReaders;
+}
+
+// Maps a file read-only. An empty file is mapped to null.
+static bool MapFile( const char* path, const unsigned char*& outData, std::size_t& outSize )
+{
+    outData = nullptr;
+    outSize = 0;
+#if _WIN32
+    const HANDLE file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx( file, &fileSize ))
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    if (fileSize.QuadPart == 0)
+    {
+        CloseHandle( file );
+        return true;
+    }
+
+    // The view keeps the mapping and the file open.
+    const HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    outData = mapping ? static_cast< const unsigned char* >( MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) ) : nullptr;
+
+    if (mapping)
+    {
+        CloseHandle( mapping );
+    }
+
+    CloseHandle( file );
+
+    if (outData == nullptr)
+    {
+        return false;
+    }
+
+    outSize = static_cast< std::size_t >( fileSize.QuadPart );
+#else
+    const int file = open( path, O_RDONLY );
+
+    if (file == -1)
+    {
+        return false;
+    }
+
+    struct stat fileStat;
+
+    if (fstat( file, &fileStat ) == -1)
+    {
+        close( file );
+        return false;
+    }
+
+    if (fileStat.st_size == 0)
+    {
+        close( file );
+        return true;
+    }
+
+    void* data = mmap( nullptr, static_cast< std::size_t >( fileStat.st_size ), PROT_READ, MAP_PRIVATE, file, 0 );
+    // The mapping stays valid after the file is closed.
+    close( file );
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    outData = static_cast< const unsigned char* >( data );
+    outSize = static_cast< std::size_t >( fileStat.st_size );
+#endif
+    return true;
+}
+
+static void UnmapFile( const unsigned char* data, std::size_t size )
+{
+    if (data == nullptr)
+    {
+        return;
+    }
+
+#if _WIN32
+    (void)size;
+    UnmapViewOfFile( data );
+#else
+    munmap( const_cast< unsigned char* >( data ), size );
+#endif
+}
+
+// Checks that the table of contents and every entry are inside the file.
+static bool ReadTableOfContents( PakFile& pakFile )
+{
+    if (pakFile.size < sizeof( ae3d::Pak::Header ))
+    {
+        return false;
+    }
+
+    const ae3d::Pak::Header* header = reinterpret_cast< const ae3d::Pak::Header* >( pakFile.data );
+
+    if (std::memcmp( header->magic, ae3d::Pak::Magic, sizeof( header->magic ) ) != 0 || header->version != ae3d::Pak::Version ||
+        (header->bucketCount & (header->bucketCount - 1)) != 0 || header->bucketCount < header->entryCount ||
+        (header->entryCount > 0 && header->bucketCount == 0))
+    {
+        return false;
+    }
+
+    const uint64_t bucketsOffset = sizeof( ae3d::Pak::Header );
+    const uint64_t entriesOffset = bucketsOffset + uint64_t{ header->bucketCount } * sizeof( uint32_t );
+    const uint64_t entriesEnd = entriesOffset + uint64_t{ header->entryCount } * sizeof( ae3d::Pak::Entry );
+
+    if (entriesOffset % alignof( ae3d::Pak::Entry ) != 0 || entriesEnd > pakFile.size ||
+        header->pathsOffset < entriesEnd || (uint64_t)header->pathsOffset + header->pathsSize > pakFile.size)
+    {
+        return false;
+    }
+
+    pakFile.header = header;
+    pakFile.buckets = reinterpret_cast< const uint32_t* >( pakFile.data + bucketsOffset );
+    pakFile.entries = reinterpret_cast< const ae3d::Pak::Entry* >( pakFile.data + entriesOffset );
+    pakFile.paths = reinterpret_cast< const char* >( pakFile.data + header->pathsOffset );
+
+    for (uint32_t b = 0; b < header->bucketCount; ++b)
+    {
+        if (pakFile.buckets[ b ] > header->entryCount)
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t e = 0; e < header->entryCount; ++e)
+    {
+        const ae3d::Pak::Entry& entry = pakFile.entries[ e ];
+
+        if (entry.offset > pakFile.size || entry.storedSize > pakFile.size - entry.offset ||
+            entry.pathOffset > header->pathsSize || entry.pathLength > header->pathsSize - entry.pathOffset)
+        {
+            return false;
+        }
+
+        if (entry.compression == ae3d::Pak::CompressionLevel::None)
+        {
+            if (entry.storedSize != entry.size)
+            {
+                return false;
+            }
+        }
+        else if (entry.compression > ae3d::Pak::CompressionLevel::High || header->blockSize == 0 ||
+                 entry.storedSize / sizeof( uint64_t ) < ae3d::Pak::GetBlockCount( entry.size, header->blockSize ))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static const ae3d::Pak::Entry* FindEntry( const PakFile& pakFile, const std::string& path, uint64_t pathHash )
+{
+    const uint32_t bucketCount = pakFile.header->bucketCount;
+
+    for (uint32_t probe = 0; probe < bucketCount; ++probe)
+    {
+        const uint32_t entryIndex = pakFile.buckets[ (pathHash + probe) & (bucketCount - 1) ];
+
+        if (entryIndex == 0)
+        {
+            return nullptr;
+        }
+
+        const ae3d::Pak::Entry& entry = pakFile.entries[ entryIndex - 1 ];
+
+        if (entry.pathHash == pathHash && entry.pathLength == path.size() && std::memcmp( pakFile.paths + entry.pathOffset, path.data(), path.size() ) == 0)
+        {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+ae3d::FileSystem::PakEntry ae3d::FileSystem::FindPakEntry( const char* path )
+{
+    PakEntry outEntry;
+    std::lock_guard< std::mutex > lock( Global::pakFilesMutex );
+
+    if (path == nullptr || Global::pakFiles.empty())
+    {
+        return outEntry;
+    }
+
+    std::string entryPath = path;
+    std::replace( std::begin( entryPath ), std::end( entryPath ), '\\', '/' );
+    const uint64_t pathHash = Pak::HashPath( entryPath.data(), entryPath.size() );
+
+    for (const auto& pakFile : Global::pakFiles)
+    {
+        const Pak::Entry* entry = FindEntry( pakFile, entryPath, pathHash );
+
+        if (entry != nullptr)
+        {
+            const bool isCompressed = entry->compression != Pak::CompressionLevel::None;
+            outEntry.storedData = pakFile.data + entry->offset;
+            outEntry.storedSize = static_cast< std::size_t >( entry->storedSize );
+            outEntry.data = isCompressed ? nullptr : outEntry.storedData;
+            outEntry.size = static_cast< std::size_t >( entry->size );
+            outEntry.blockSize = isCompressed ? pakFile.header->blockSize : 0;
+            outEntry.isFound = true;
+            return outEntry;
+        }
+    }
+
+    return outEntry;
+}
+
+// Decompresses a block of a compressed entry, or copies it if it's stored as is.
+static bool ReadBlock( const ae3d::FileSystem::PakEntry& entry, uint64_t block, unsigned char* destination )
+{
+    const uint64_t blockCount = ae3d::Pak::GetBlockCount( entry.size, entry.blockSize );
+    const uint64_t blocksSize = entry.storedSize - blockCount * sizeof( uint64_t );
+    const unsigned char* blocks = entry.storedData + blockCount * sizeof( uint64_t );
+
+    uint64_t blockStart = 0;
+    uint64_t blockEnd = 0;
+
+    if (block > 0)
+    {
+        std::memcpy( &blockStart, entry.storedData + (block - 1) * sizeof( uint64_t ), sizeof( uint64_t ) );
+    }
+
+    std::memcpy( &blockEnd, entry.storedData + block * sizeof( uint64_t ), sizeof( uint64_t ) );
+
+    if (blockEnd < blockStart || blockEnd > blocksSize)
+    {
+        return false;
+    }
+
+    const std::size_t storedSize = blockEnd - blockStart;
+    const std::size_t size = static_cast< std::size_t >( std::min< uint64_t >( entry.blockSize, entry.size - block * entry.blockSize ) );
+
+    if (storedSize == size)
+    {
+        std::memcpy( destination, blocks + blockStart, size );
+        return true;
+    }
+
+    return ae3d::Compression::Decompress( blocks + blockStart, storedSize, destination, size );
+}
+
+std::size_t ae3d::FileSystem::ReadPakEntry( const PakEntry& entry, std::size_t offset, unsigned char* destination, std::size_t destinationSize )
+{
+    if (!entry.isFound || destination == nullptr || offset >= entry.size)
+    {
+        return 0;
+    }
+
+    const std::size_t readSize = std::min( destinationSize, entry.size - offset );
+
+    if (entry.blockSize == 0)
+    {
+        std::memcpy( destination, entry.storedData + offset, readSize );
+        return readSize;
+    }
+
+    const uint64_t firstBlock = offset / entry.blockSize;
+    const uint64_t endBlock = (offset + readSize + entry.blockSize - 1) / entry.blockSize;
+    std::atomic< uint64_t > nextBlock( firstBlock );
+    std::atomic< bool > isCorrupted( false );
+
+    auto readBlocks = [&]()
+    {
+        // Blocks that are only partly inside destination are decompressed here first.
+        std::vector< unsigned char > partialBlock;
+
+        for (uint64_t block = nextBlock++; block < endBlock && !isCorrupted; block = nextBlock++)
+        {
+            const std::size_t blockStart = block * entry.blockSize;
+            const std::size_t blockEnd = std::min< std::size_t >( blockStart + entry.blockSize, entry.size );
+
+            if (blockStart >= offset && blockEnd <= offset + readSize)
+            {
+                if (!ReadBlock( entry, block, destination + blockStart - offset ))
+                {
+                    isCorrupted = true;
+                }
+
+                continue;
+            }
+
+            partialBlock.resize( blockEnd - blockStart );
+
+            if (!ReadBlock( entry, block, partialBlock.data() ))
+            {
+                isCorrupted = true;
+                continue;
+            }
+
+            const std::size_t copyStart = std::max( blockStart, offset );
+            const std::size_t copyEnd = std::min( blockEnd, offset + readSize );
+            std::memcpy( destination + copyStart - offset, partialBlock.data() + copyStart - blockStart, copyEnd - copyStart );
+        }
+    };
+
+    const uint64_t threadCount = (endBlock - firstBlock + Global::blocksPerThread - 1) / Global::blocksPerThread;
+
+    if (threadCount > 1)
+    {
+        Global::blockReaders.Run( readBlocks, threadCount );
+    }
+    else
+    {
+        readBlocks();
+    }
+
+    if (isCorrupted)
+    {
+        System::Print( "ReadPakEntry: Compressed data is corrupted.\n" );
+        return 0;
+    }
+
+    return readSize;
 }
 
 #if VK_USE_PLATFORM_ANDROID_KHR
@@ -82,17 +535,13 @@ ae3d::FileSystem::FileContentsData ae3d::FileSystem::FileContents( const char* p
         outData.pathWithoutBundle = path;
 #endif
 
-    for (const auto& pakFile : Global::pakFiles)
+    const PakEntry pakEntry = FindPakEntry( path );
+
+    if (pakEntry.isFound)
     {
-        for (const auto& entry : pakFile.entries)
-        {
-            if (entry.path == outData.path)
-            {
-                outData.data = entry.contents;
-                outData.isLoaded = true;
-                return outData;
-            }
-        }
+        outData.data.resize( pakEntry.size );
+        outData.isLoaded = pakEntry.size == 0 || ReadPakEntry( pakEntry, 0, outData.data.data(), outData.data.size() ) == pakEntry.size;
+        return outData;
     }
 
     std::ifstream in( outData.path.c_str(), std::ifstream::ate | std::ifstream::binary );
@@ -113,6 +562,253 @@ ae3d::FileSystem::FileContentsData ae3d::FileSystem::FileContents( const char* p
 }
 #endif
 
+ae3d::FileSystem::FileView::FileView( FileView&& other )
+{
+    *this = std::move( other );
+}
+
+ae3d::FileSystem::FileView& ae3d::FileSystem::FileView::operator=( FileView&& other )
+{
+    if (this != &other)
+    {
+        Release();
+        path = std::move( other.path );
+        // Moving the vector keeps its buffer, so data stays valid.
+        ownedData = std::move( other.ownedData );
+        data = other.data;
+        size = other.size;
+        mappedData = other.mappedData;
+        mappedSize = other.mappedSize;
+        isLoaded = other.isLoaded;
+
+        other.ownedData.clear();
+        other.data = nullptr;
+        other.size = 0;
+        other.mappedData = nullptr;
+        other.mappedSize = 0;
+        other.isLoaded = false;
+    }
+
+    return *this;
+}
+
+ae3d::FileSystem::FileView::~FileView()
+{
+    Release();
+}
+
+void ae3d::FileSystem::FileView::Release()
+{
+    UnmapFile( mappedData, mappedSize );
+    mappedData = nullptr;
+    mappedSize = 0;
+    ownedData.clear();
+    data = nullptr;
+    size = 0;
+    isLoaded = false;
+}
+
+ae3d::FileSystem::FileView ae3d::FileSystem::OpenFileView( const char* path )
+{
+    FileView outView;
+    outView.path = path == nullptr ? "" : std::string( GetFullPath( path ) );
+
+    const PakEntry pakEntry = FindPakEntry( path );
+
+    if (pakEntry.isFound)
+    {
+        if (pakEntry.blockSize == 0)
+        {
+            outView.data = pakEntry.data;
+        }
+        else
+        {
+            outView.ownedData.resize( pakEntry.size );
+
+            if (ReadPakEntry( pakEntry, 0, outView.ownedData.data(), outView.ownedData.size() ) != pakEntry.size)
+            {
+                outView.ownedData.clear();
+                return outView;
+            }
+
+            outView.data = outView.ownedData.data();
+        }
+
+        outView.size = pakEntry.size;
+        outView.isLoaded = true;
+        return outView;
+    }
+
+#if VK_USE_PLATFORM_ANDROID_KHR
+    AAsset* asset = path != nullptr ? AAssetManager_open( assetManager, path, AASSET_MODE_BUFFER ) : nullptr;
+
+    if (asset != nullptr)
+    {
+        outView.ownedData.resize( AAsset_getLength( asset ) );
+        AAsset_read( asset, outView.ownedData.data(), outView.ownedData.size() );
+        AAsset_close( asset );
+        outView.data = outView.ownedData.data();
+        outView.size = outView.ownedData.size();
+        outView.isLoaded = true;
+    }
+#else
+    outView.isLoaded = MapFile( outView.path.c_str(), outView.mappedData, outView.mappedSize );
+    outView.data = outView.mappedData;
+    outView.size = outView.mappedSize;
+#endif
+
+    if (!outView.isLoaded)
+    {
+        System::Print( "FileSystem: Could not open %s.\n", outView.path.c_str() );
+    }
+
+    return outView;
+}
+
+ae3d::FileSystem::FileReader::~FileReader()
+{
+    Close();
+}
+
+bool ae3d::FileSystem::FileReader::Open( const char* path )
+{
+    Close();
+
+    pakEntry = FindPakEntry( path );
+
+    if (pakEntry.isFound)
+    {
+        size = pakEntry.size;
+        isOpen = true;
+        return true;
+    }
+
+    if (path == nullptr)
+    {
+        return false;
+    }
+
+#if VK_USE_PLATFORM_ANDROID_KHR
+    AAsset* androidAsset = AAssetManager_open( assetManager, path, AASSET_MODE_STREAMING );
+
+    if (androidAsset != nullptr)
+    {
+        asset = androidAsset;
+        size = static_cast< std::size_t >( AAsset_getLength64( androidAsset ) );
+        isOpen = true;
+    }
+#else
+    file = std::fopen( GetFullPath( path ), "rb" );
+
+    if (file != nullptr && std::fseek( file, 0, SEEK_END ) == 0)
+    {
+#if _WIN32
+        const long long fileSize = _ftelli64( file );
+#else
+        const off_t fileSize = ftello( file );
+#endif
+        std::rewind( file );
+
+        if (fileSize >= 0)
+        {
+            size = static_cast< std::size_t >( fileSize );
+            isOpen = true;
+        }
+    }
+#endif
+
+    if (!isOpen)
+    {
+        System::Print( "FileSystem: Could not open %s.\n", path );
+        Close();
+    }
+
+    return isOpen;
+}
+
+void ae3d::FileSystem::FileReader::Close()
+{
+    if (file != nullptr)
+    {
+        std::fclose( file );
+        file = nullptr;
+    }
+
+#if VK_USE_PLATFORM_ANDROID_KHR
+    if (asset != nullptr)
+    {
+        AAsset_close( static_cast< AAsset* >( asset ) );
+        asset = nullptr;
+    }
+#endif
+
+    pakEntry = PakEntry();
+    size = 0;
+    position = 0;
+    isOpen = false;
+}
+
+std::size_t ae3d::FileSystem::FileReader::Read( unsigned char* destination, std::size_t destinationSize )
+{
+    if (!isOpen || destination == nullptr || position >= size)
+    {
+        return 0;
+    }
+
+    std::size_t readSize = std::min( destinationSize, size - position );
+
+    if (pakEntry.isFound)
+    {
+        readSize = ReadPakEntry( pakEntry, position, destination, readSize );
+    }
+#if VK_USE_PLATFORM_ANDROID_KHR
+    else
+    {
+        const int androidReadSize = AAsset_read( static_cast< AAsset* >( asset ), destination, readSize );
+        readSize = androidReadSize > 0 ? static_cast< std::size_t >( androidReadSize ) : 0;
+    }
+#else
+    else
+    {
+        readSize = std::fread( destination, 1, readSize, file );
+    }
+#endif
+
+    position += readSize;
+    return readSize;
+}
+
+bool ae3d::FileSystem::FileReader::Seek( std::size_t offset )
+{
+    if (!isOpen || offset > size)
+    {
+        return false;
+    }
+
+    if (!pakEntry.isFound)
+    {
+#if VK_USE_PLATFORM_ANDROID_KHR
+        if (AAsset_seek64( static_cast< AAsset* >( asset ), static_cast< off64_t >( offset ), SEEK_SET ) == -1)
+        {
+            return false;
+        }
+#elif _WIN32
+        if (_fseeki64( file, static_cast< long long >( offset ), SEEK_SET ) != 0)
+        {
+            return false;
+        }
+#else
+        if (fseeko( file, static_cast< off_t >( offset ), SEEK_SET ) != 0)
+        {
+            return false;
+        }
+#endif
+    }
+
+    position = offset;
+    return true;
+}
+
 void ae3d::FileSystem::LoadPakFile( const char* path )
 {
     if (path == nullptr)
@@ -121,45 +817,46 @@ void ae3d::FileSystem::LoadPakFile( const char* path )
         return;
     }
 
-    unsigned entryCount = 0;
-    std::ifstream ifs( path );
-    if (!ifs.is_open())
+    std::lock_guard< std::mutex > lock( Global::pakFilesMutex );
+
+    for (const auto& pakFile : Global::pakFiles)
     {
-        System::Print( "LoadPakFile: Could not open %s\n", path );
-        return;
+        if (pakFile.path == path)
+        {
+            return;
+        }
     }
 
-    ifs.read( (char*)&entryCount, 4 );
-    auto& pakFile = Global::pakFiles[ Global::packFileCount ];
-	++Global::packFileCount;
-    pakFile.entries.resize( entryCount );
+    PakFile pakFile;
     pakFile.path = path;
 
-    for (unsigned i = 0; i < entryCount; ++i)
+    if (!MapFile( path, pakFile.data, pakFile.size ))
+    {
+        System::Print( "LoadPakFile: Could not open %s\n", path );
+        return;
+    }
+
+    if (!ReadTableOfContents( pakFile ))
     {
-        auto& entry = pakFile.entries[i];
-        char entryPath[ 128 ];
-        ifs.read( &entryPath[ 0 ], 128 );
-        entry.path = entryPath;
-        unsigned entrySize = 0;
-        ifs.read( (char*)&entrySize, 4 );
-        entry.contents.resize( entrySize );
-        ifs.read( (char*)entry.contents.data(), entrySize );
+        System::Print( "LoadPakFile: %s is corrupted or old format. Rebuild it with CombineFiles.\n", path );
+        UnmapFile( pakFile.data, pakFile.size );
+        return;
     }
+
+    Global::pakFiles.push_back( pakFile );
 }
 
 void ae3d::FileSystem::UnloadPakFile( const char* path )
 {
-    int i = 0;
+    std::lock_guard< std::mutex > lock( Global::pakFilesMutex );
 
-    for (const PakFile& pakFile : Global::pakFiles)
+    for (auto it = std::begin( Global::pakFiles ); it != std::end( Global::pakFiles ); ++it)
     {
-        if (pakFile.path == std::string( path ))
+        if (path != nullptr && it->path == path)
         {
-			// FIXME: Do something here.
-            //Global::pakFiles.erase( std::begin( Global::pakFiles ) + i );
+            UnmapFile( it->data, it->size );
+            Global::pakFiles.erase( it );
             return;
         }
-        ++i;
     }
 }
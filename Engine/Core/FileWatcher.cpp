@@ -1,57 +1,170 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "FileWatcher.hpp"
-#include <ctime>
+#include <algorithm>
 #include <sys/stat.h>
+#if __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 ae3d::FileWatcher fileWatcher;
 
-void ae3d::FileWatcher::AddFile( const std::string& path, void(*updateFunc)(const std::string&) )
+static std::time_t GetModificationTime( const std::string& path )
 {
-    pathToEntry[ path ] = Entry();
-    pathToEntry[ path ].path = path;
-    pathToEntry[ path ].updateFunc = updateFunc;
-
     struct stat inode;
+    return stat( path.c_str(), &inode ) != -1 ? inode.st_mtime : 0;
+}
 
-    if (stat( path.c_str(), &inode ) != -1)
+ae3d::FileWatcher::~FileWatcher()
+{
+#if __linux__
+    if (notifyFile != -1)
     {
-#if _MSC_VER
-        tm timeinfo;
-        localtime_s( &timeinfo, &inode.st_mtime );
-        tm* timeinfo2 = &timeinfo;
-#else
-        tm* timeinfo2 = std::localtime( &inode.st_mtime );
-#endif
-        pathToEntry[ path ].hour = timeinfo2->tm_hour;
-        pathToEntry[ path ].minute = timeinfo2->tm_min;
-        pathToEntry[ path ].second = timeinfo2->tm_sec;
+        close( notifyFile );
     }
+#endif
 }
 
-void ae3d::FileWatcher::Poll()
+void ae3d::FileWatcher::AddFile( const std::string& path, void(*updateFunc)(const std::string&) )
 {
-    struct stat inode = {};
+    const bool isWatched = pathToEntry.find( path ) != std::end( pathToEntry );
+    Entry& entry = pathToEntry[ path ];
+    entry.path = path;
+    entry.updateFunc = updateFunc;
+    entry.modificationTime = GetModificationTime( path );
+
+    if (!isWatched)
+    {
+        WatchDirectory( entry );
+
+        if (entry.isPolled)
+        {
+            polledPaths.push_back( path );
+        }
+    }
+}
 
-    for (auto& entry : pathToEntry)
+void ae3d::FileWatcher::WatchDirectory( Entry& entry )
+{
+#if __linux__
+    if (notifyFile == -1)
     {
-        if (stat( entry.second.path.c_str(), &inode ) != -1)
+        notifyFile = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+
+        if (notifyFile == -1)
         {
-#if _MSC_VER
-            tm timeinfo;
-            localtime_s( &timeinfo, &inode.st_mtime );
-            tm* timeinfo2 = &timeinfo;
+            return;
+        }
+    }
+
+    const std::size_t slash = entry.path.find_last_of( '/' );
+    const std::string prefix = slash == std::string::npos ? "" : entry.path.substr( 0, slash + 1 );
+    // Editors often save by writing a new file and renaming it over the old one, so the directory is watched instead of the file.
+    const int watch = inotify_add_watch( notifyFile, prefix.empty() ? "." : prefix.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_ATTRIB );
+
+    if (watch == -1)
+    {
+        return;
+    }
+
+    std::vector< std::string >& prefixes = watchToPrefixes[ watch ];
+
+    if (std::find( std::begin( prefixes ), std::end( prefixes ), prefix ) == std::end( prefixes ))
+    {
+        prefixes.push_back( prefix );
+    }
+
+    entry.isPolled = false;
 #else
-            tm* timeinfo2 = std::localtime( &inode.st_mtime );
+    (void)entry;
 #endif
+}
 
-            if (timeinfo2->tm_hour != entry.second.hour || timeinfo2->tm_min != entry.second.minute || timeinfo2->tm_sec != entry.second.second)
+void ae3d::FileWatcher::ReadNotifications( std::chrono::steady_clock::time_point now )
+{
+#if __linux__
+    if (notifyFile == -1)
+    {
+        return;
+    }
+
+    alignas( inotify_event ) char buffer[ 4096 ];
+    ssize_t length = 0;
+
+    while ((length = read( notifyFile, buffer, sizeof( buffer ) )) > 0)
+    {
+        for (ssize_t offset = 0; offset < length; )
+        {
+            const inotify_event* event = reinterpret_cast< const inotify_event* >( buffer + offset );
+            offset += static_cast< ssize_t >( sizeof( inotify_event ) + event->len );
+
+            // Events were lost, so any file could have changed.
+            if ((event->mask & IN_Q_OVERFLOW) != 0)
             {
-                entry.second.updateFunc( entry.second.path );
-                entry.second.hour = timeinfo2->tm_hour;
-                entry.second.minute = timeinfo2->tm_min;
-                entry.second.second = timeinfo2->tm_sec;
+                for (const auto& entry : pathToEntry)
+                {
+                    if (!entry.second.isPolled)
+                    {
+                        pathToChangeTime[ entry.first ] = now;
+                    }
+                }
+
+                continue;
+            }
+
+            const auto prefixes = watchToPrefixes.find( event->wd );
+
+            if (event->len == 0 || prefixes == std::end( watchToPrefixes ))
+            {
+                continue;
+            }
+
+            for (const auto& prefix : prefixes->second)
+            {
+                const std::string path = prefix + event->name;
+
+                if (pathToEntry.find( path ) != std::end( pathToEntry ))
+                {
+                    pathToChangeTime[ path ] = now;
+                }
             }
         }
     }
+#else
+    (void)now;
+#endif
+}
+
+void ae3d::FileWatcher::Poll()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    ReadNotifications( now );
+
+    for (const auto& path : polledPaths)
+    {
+        Entry& entry = pathToEntry[ path ];
+        const std::time_t modificationTime = GetModificationTime( path );
+
+        if (modificationTime != entry.modificationTime)
+        {
+            entry.modificationTime = modificationTime;
+            pathToChangeTime[ path ] = now;
+        }
+    }
+
+    for (auto it = std::begin( pathToChangeTime ); it != std::end( pathToChangeTime ); )
+    {
+        if (now - it->second < debounceTime)
+        {
+            ++it;
+            continue;
+        }
+
+        // updateFunc can add files.
+        const std::string path = it->first;
+        it = pathToChangeTime.erase( it );
+        pathToEntry[ path ].updateFunc( path );
+    }
 }
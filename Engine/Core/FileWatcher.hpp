@@ -1,28 +1,57 @@
 #pragma once
 
+#include <chrono>
+#include <ctime>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace ae3d
 {
-    /** Keeps track of files and calls updateFunc when they have changed on disk. This enables asset hotloading. */
+    /** Keeps track of files and calls updateFunc when they have changed on disk. This enables asset hotloading.
+        On Linux changes are reported by inotify, so Poll() cost doesn't depend on the number of watched files.
+        On other platforms, or if inotify can't watch a file's directory, Poll() compares modification times of watched files. */
     class FileWatcher
     {
     public:
+        FileWatcher() = default;
+        FileWatcher( const FileWatcher& ) = delete;
+        FileWatcher& operator=( const FileWatcher& ) = delete;
+
+        /// Stops watching.
+        ~FileWatcher();
+
         void AddFile( const std::string& path, void(*updateFunc)(const std::string&)  );
-        // Scans for all watched file modification timestamps and calls updateFunc if they have been updated.
+
+        /// Calls updateFunc for files that have changed and have not changed again during the debounce time.
         void Poll();
 
+        /// \param milliseconds A file is reported this long after its last change, so a save that writes many times reloads once. Default is 100.
+        void SetDebounceTime( int milliseconds ) { debounceTime = std::chrono::milliseconds( milliseconds ); }
+
     private:
         struct Entry
         {
-            int hour = 0;
-            int minute = 0;
-            int second = 0;
+            std::time_t modificationTime = 0;
             std::string path;
             void(*updateFunc)(const std::string&) = nullptr;
+            /// True if the directory is not watched by inotify.
+            bool isPolled = true;
         };
-        
+
+        void WatchDirectory( Entry& entry );
+        void ReadNotifications( std::chrono::steady_clock::time_point now );
+
         std::map< std::string, Entry > pathToEntry;
-    };    
+        /// Files whose modification time Poll() compares.
+        std::vector< std::string > polledPaths;
+        /// Changed files and time of their last change.
+        std::map< std::string, std::chrono::steady_clock::time_point > pathToChangeTime;
+        std::chrono::milliseconds debounceTime = std::chrono::milliseconds( 100 );
+#if __linux__
+        int notifyFile = -1;
+        /// Path prefixes of watched directories. A directory can be watched by multiple prefixes, e.g. "a/" and "./a/".
+        std::map< int, std::vector< std::string > > watchToPrefixes;
+#endif
+    };
 }
@@ -4,6 +4,7 @@
 #include <sstream>
 #include <string>
 #include "Array.hpp"
+#include "AssetRegistry.hpp"
 #include "FileSystem.hpp"
 #include "System.hpp"
 #include "Texture2D.hpp"
@@ -162,6 +163,12 @@ void ae3d::Font::LoadBMFont( Texture2D* fontTex, const FileSystem::FileContentsD
     {
         LoadBMFontMetaBinary( metaData );
     }
+
+    // Glyphs are stored in Font objects, so fonts are only accounted, not evicted.
+    if (!AssetRegistry::IsValid( AssetRegistry::Find( AssetRegistry::Category::Font, metaData.path ) ))
+    {
+        AssetRegistry::Register( AssetRegistry::Category::Font, metaData.path, sizeof( chars ), nullptr );
+    }
 }
 
 void ae3d::Font::LoadBMFontMetaText( const FileSystem::FileContentsData& metaData )
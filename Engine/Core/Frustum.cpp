@@ -85,17 +85,36 @@ void Frustum::Update( const Vec3& cameraPosition, const Vec3& cameraDirection )
 {
     const Vec3 zAxis = cameraDirection;
     UpdateCornersAndCenters( cameraPosition, zAxis );
+    UpdatePlanes( zAxis );
+}
+
+void Frustum::SetCombined( const Frustum& left, const Frustum& right )
+{
+    zNear = left.zNear;
+    zFar = left.zFar;
+    nearHeight = left.nearHeight;
+    farHeight = left.farHeight;
     
-    enum FrustumPlane
-    {
-        FARP = 0,
-        NEARP,
-        BOTTOM,
-        TOP,
-        LEFT,
-        RIGHT
-    };
+    // Outer edges come from the eye on that side, so the side planes enclose both eyes.
+    nearTopLeft     = left.nearTopLeft;
+    nearBottomLeft  = left.nearBottomLeft;
+    farTopLeft      = left.farTopLeft;
+    farBottomLeft   = left.farBottomLeft;
+    nearTopRight    = right.nearTopRight;
+    nearBottomRight = right.nearBottomRight;
+    farTopRight     = right.farTopRight;
+    farBottomRight  = right.farBottomRight;
     
+    nearCenter = (left.nearCenter + right.nearCenter) * 0.5f;
+    farCenter  = (left.farCenter + right.farCenter) * 0.5f;
+    nearWidth  = (nearTopRight - nearTopLeft).Length() * 0.5f;
+    farWidth   = (farTopRight - farTopLeft).Length() * 0.5f;
+
+    UpdatePlanes( left.planes[ FrustumPlane::FARP ].normal );
+}
+
+void Frustum::UpdatePlanes( const Vec3& zAxis )
+{
     planes[ FrustumPlane::TOP ].a = nearTopRight;
     planes[ FrustumPlane::TOP ].b = nearTopLeft;
     planes[ FrustumPlane::TOP ].c = farTopLeft;
@@ -153,6 +172,34 @@ bool Frustum::BoxInFrustum( const Vec3& min, const Vec3& max ) const
     return result;
 }
 
+bool Frustum::SphereInFrustum( const Vec3& center, float radius ) const
+{
+    for (unsigned p = 0; p < 6; ++p)
+    {
+        if (planes[ p ].Distance( center ) < -radius)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+unsigned Frustum::BoxInFrustums( const Frustum* frustums, unsigned frustumCount, unsigned testMask, const Vec3& min, const Vec3& max )
+{
+    unsigned result = 0;
+
+    for (unsigned f = 0; f < frustumCount && f < 32; ++f)
+    {
+        if ((testMask & (1u << f)) != 0 && frustums[ f ].BoxInFrustum( min, max ))
+        {
+            result |= 1u << f;
+        }
+    }
+
+    return result;
+}
+
 const Vec3& Frustum::NearTopLeft() const { return nearTopLeft; }
 const Vec3& Frustum::NearTopRight() const { return nearTopRight; }
 const Vec3& Frustum::NearBottomLeft() const { return nearBottomLeft; }
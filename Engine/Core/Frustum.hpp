@@ -36,6 +36,28 @@ public:
      \return False, if the box is not in the frustum.
      */
     bool BoxInFrustum( const Vec3& min, const Vec3& max ) const;
+
+    /**
+     Tests a sphere against the frustum.
+
+     \param center Sphere's center.
+     \param radius Sphere's radius.
+     \return True, if part of the sphere is in the frustum.
+     \return False, if the sphere is not in the frustum.
+     */
+    bool SphereInFrustum( const Vec3& center, float radius ) const;
+
+    /**
+     Tests AABB against multiple frustums in one call, eg. every camera in the scene.
+     
+     \param frustums Frustums.
+     \param frustumCount Frustum count. Max 32.
+     \param testMask Bit n must be set for frustums[ n ] to be tested.
+     \param min AABB's minimum corner.
+     \param max AABB's maximum corner.
+     \return Bitmask where bit n is set if part of the box is in frustums[ n ].
+     */
+    static unsigned BoxInFrustums( const Frustum* frustums, unsigned frustumCount, unsigned testMask, const Vec3& min, const Vec3& max );
     
     /**
      Sets values from which the frustum is calculated.
@@ -69,6 +91,16 @@ public:
      \param cameraDirection Camera's direction
      */
     void Update( const Vec3& cameraPosition, const Vec3& cameraDirection );
+
+    /**
+     Makes this frustum enclose two frustums that have the same orientation and
+     projection but different origin, like stereo eyes. Objects inside either
+     eye are inside the combined frustum.
+
+     \param left Left eye frustum.
+     \param right Right eye frustum.
+     */
+    void SetCombined( const Frustum& left, const Frustum& right );
     
     /// \return Near clip plane.
     float NearClipPlane() const;
@@ -80,7 +112,18 @@ public:
     Vec3 Centroid() const;
     
 private:
+    enum FrustumPlane
+    {
+        FARP = 0,
+        NEARP,
+        BOTTOM,
+        TOP,
+        LEFT,
+        RIGHT
+    };
+
     void UpdateCornersAndCenters( const Vec3& cameraPosition, const Vec3& zAxis );
+    void UpdatePlanes( const Vec3& zAxis );
     
     // Near clipping plane coordinates
     Vec3 nearTopLeft;
@@ -1,5 +1,10 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include <cmath>
+#include "Frustum.hpp"
+#include "Matrix.hpp"
+#include "MeshCluster.hpp"
+#include "MeshLod.hpp"
 #include "Vec3.hpp"
 
 using namespace ae3d;
@@ -93,4 +98,90 @@ namespace MathUtil
     {
         return 1 + static_cast< int >(floor( log2( Max( width, height ) ) ));
     }
+
+    int SelectLod( const float* lodErrors, int lodCount, float errorScale, int currentLod, float maxError )
+    {
+        const float Hysteresis = 0.25f;
+        int lod = 0;
+        float maxCoarserError = maxError;
+
+        if (currentLod >= 0 && currentLod < lodCount && lodErrors[ currentLod ] * errorScale <= maxError * (1 + Hysteresis))
+        {
+            lod = currentLod;
+            maxCoarserError = maxError * (1 - Hysteresis);
+        }
+
+        while (lod + 1 < lodCount && lodErrors[ lod + 1 ] * errorScale <= maxCoarserError)
+        {
+            ++lod;
+        }
+
+        return lod;
+    }
+
+    bool IsClusterBackFacing( const MeshCluster& cluster, const Vec3& localCameraPosition )
+    {
+        if (cluster.coneCutoff <= 0)
+        {
+            return false;
+        }
+
+        // Every face normal n is within angle a of the cone axis and every point p within the sphere,
+        // so dot( n, p - camera ) >= |v| * cos( t + a ) - radius, where v = center - camera and t is
+        // the angle between v and the cone axis. If that is >= 0, every face is back-facing.
+        const Vec3 v = cluster.center - localCameraPosition;
+        const float distance = v.Length();
+
+        if (distance <= cluster.radius)
+        {
+            return false;
+        }
+
+        const float cosT = Vec3::Dot( cluster.coneAxis, v ) / distance;
+        const float sinT = std::sqrt( std::fmax( 0.0f, 1 - cosT * cosT ) );
+        const float sinA = std::sqrt( std::fmax( 0.0f, 1 - cluster.coneCutoff * cluster.coneCutoff ) );
+
+        return distance * (cosT * cluster.coneCutoff - sinT * sinA) >= cluster.radius;
+    }
+
+    void CullClusters( const MeshCluster* clusters, unsigned clusterCount, const Frustum& frustum, const Matrix44& localToWorld,
+                       const Vec3* localCameraPosition, std::vector< unsigned >& outFaceRanges )
+    {
+        // Bounding spheres are scaled by the largest axis scale, so they stay conservative under non-uniform scaling.
+        const Vec3 xAxis( localToWorld.m[ 0 ], localToWorld.m[ 1 ], localToWorld.m[ 2 ] );
+        const Vec3 yAxis( localToWorld.m[ 4 ], localToWorld.m[ 5 ], localToWorld.m[ 6 ] );
+        const Vec3 zAxis( localToWorld.m[ 8 ], localToWorld.m[ 9 ], localToWorld.m[ 10 ] );
+        const float scale = std::sqrt( std::fmax( std::fmax( Vec3::Dot( xAxis, xAxis ), Vec3::Dot( yAxis, yAxis ) ), Vec3::Dot( zAxis, zAxis ) ) );
+        const std::size_t firstRange = outFaceRanges.size();
+
+        for (unsigned c = 0; c < clusterCount; ++c)
+        {
+            const MeshCluster& cluster = clusters[ c ];
+
+            if (localCameraPosition != nullptr && IsClusterBackFacing( cluster, *localCameraPosition ))
+            {
+                continue;
+            }
+
+            Vec3 worldCenter;
+            Matrix44::TransformPoint( cluster.center, localToWorld, &worldCenter );
+
+            if (!frustum.SphereInFrustum( worldCenter, cluster.radius * scale ))
+            {
+                continue;
+            }
+
+            const std::size_t rangeCount = outFaceRanges.size();
+
+            if (rangeCount > firstRange && outFaceRanges[ rangeCount - 1 ] == cluster.firstFace)
+            {
+                outFaceRanges[ rangeCount - 1 ] = cluster.firstFace + cluster.faceCount;
+            }
+            else
+            {
+                outFaceRanges.push_back( cluster.firstFace );
+                outFaceRanges.push_back( cluster.firstFace + cluster.faceCount );
+            }
+        }
+    }
 }
@@ -1,46 +1,86 @@
 #include "Mesh.hpp"
+#include <algorithm>
 #include <vector>
 #include <cstdint>
+#include <cstring>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include "AssetRegistry.hpp"
+#include "AsyncLoader.hpp"
 #include "FileSystem.hpp"
 #include "FileWatcher.hpp"
 #include "Matrix.hpp"
+#include "Statistics.hpp"
 #include "SubMesh.hpp"
 #include "System.hpp"
 #include "VertexBuffer.hpp"
+#include "VertexQuantization.hpp"
 
 using namespace ae3d;
 
 extern ae3d::FileWatcher fileWatcher;
 
-struct ae3d::Mesh::Impl
+// Loaded mesh data. Immutable after loading and shared by all meshes loaded from the same path.
+struct MeshAsset
 {
-    Impl() noexcept
+    MeshAsset() = default;
+    MeshAsset( const MeshAsset& ) = delete;
+    MeshAsset& operator=( const MeshAsset& ) = delete;
+
+    ~MeshAsset()
     {
-        static_assert( sizeof( ae3d::Mesh::Impl ) <= ae3d::Mesh::StorageSize, "Impl too big!");
-        static_assert( ae3d::Mesh::StorageAlign % alignof( ae3d::Mesh::Impl ) == 0, "Impl misaligned!");
+        ::Statistics::DecResidentMeshCpuBytes( cpuBytes );
+#if RENDERER_VULKAN
+        for (auto& subMesh : subMeshes)
+        {
+            subMesh.vertexBuffer.Release();
+        }
+#endif
     }
-    
+
+    std::string path;
     Vec3 aabbMin;
     Vec3 aabbMax;
     std::vector< SubMesh > subMeshes;
-    std::string path;
+    /// Counted in Statistics while the asset is alive.
+    std::size_t cpuBytes = 0;
 };
 
-struct MeshCacheEntry
+struct ae3d::Mesh::Impl
 {
-    std::string path;
-    Vec3 aabbMin;
-    Vec3 aabbMax;
-    std::vector< SubMesh > subMeshes;    
+    Impl() noexcept
+    {
+        static_assert( sizeof( ae3d::Mesh::Impl ) <= ae3d::Mesh::StorageSize, "Impl too big!");
+        static_assert( ae3d::Mesh::StorageAlign % alignof( ae3d::Mesh::Impl ) == 0, "Impl misaligned!");
+    }
+
+    const MeshAsset& GetAsset() const
+    {
+        static const MeshAsset emptyAsset;
+        return asset ? *asset : emptyAsset;
+    }
+
+    std::shared_ptr< MeshAsset > asset;
 };
 
 namespace
 {
 
-std::vector< MeshCacheEntry > gMeshCache;
+// An asset is owned by its AssetRegistry release function, so it stays cached after its last Mesh goes away until AssetRegistry evicts it.
+struct CachedMesh
+{
+    std::weak_ptr< MeshAsset > asset;
+    /// Shared by meshes that use the asset. Releases the asset's AssetRegistry reference when the last mesh goes away.
+    std::weak_ptr< MeshAsset > users;
+    AssetRegistry::Handle handle;
+};
+
+// Evicted entries are removed on the next load.
+std::unordered_map< std::string, CachedMesh > gMeshCache;
 std::vector< Mesh* > gMeshInstances;
+Mesh::CpuData gCpuData = Mesh::CpuData::All;
 
 struct membuf : std::streambuf
 {
@@ -58,241 +98,403 @@ struct imemstream : virtual membuf, std::istream
         , std::istream( static_cast<std::streambuf*>(this) ) {
     }
 };
+
+// .ae3d version 2 is a chunked format. The file starts with FileHeaderV2 followed by
+// chunkCount ChunkV2 entries. Chunk offsets are from the beginning of the file and aligned
+// to ChunkAlignment, so vertex and index chunks can be used in place without parsing.
+const unsigned ChunkAlignment = 16;
+
+struct FileHeaderV2
+{
+    char magic[ 4 ]; // "ae3d"
+    uint32_t version;
+    uint32_t chunkCount;
+    uint32_t reserved;
+};
+
+struct ChunkV2
+{
+    uint32_t type;
+    uint32_t subMeshIndex;
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct MeshChunkV2
+{
+    Vec3 aabbMin;
+    Vec3 aabbMax;
+    uint32_t subMeshCount;
+};
+
+// Followed by nameLength characters.
+struct SubMeshChunkV2
+{
+    Vec3 aabbMin;
+    Vec3 aabbMax;
+    uint32_t vertexFormat; // 0: PTNTC, 1: PTN, 2: PTNTC_Skinned, 3-5: the same in Quantization formats
+    uint32_t vertexCount;
+    uint32_t faceCount;
+    uint32_t indexSize; // 2 or 4
+    uint32_t jointCount;
+    uint32_t nameLength;
+};
+
+static_assert( sizeof( FileHeaderV2 ) == 16, "ae3d v2 header size changed" );
+static_assert( sizeof( ChunkV2 ) == 16, "ae3d v2 chunk size changed" );
+static_assert( sizeof( MeshChunkV2 ) == 28, "ae3d v2 mesh chunk size changed" );
+static_assert( sizeof( SubMeshChunkV2 ) == 48, "ae3d v2 submesh chunk size changed" );
+
+constexpr uint32_t MakeChunkType( char a, char b, char c, char d )
+{
+    return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
 }
 
-void AddUniqueInstance( Mesh* mesh )
+const uint32_t MeshChunkType = MakeChunkType( 'M', 'E', 'S', 'H' );
+const uint32_t SubMeshChunkType = MakeChunkType( 'S', 'U', 'B', 'M' );
+const uint32_t VertexChunkType = MakeChunkType( 'V', 'E', 'R', 'T' );
+const uint32_t IndexChunkType = MakeChunkType( 'I', 'N', 'D', 'X' );
+const uint32_t JointChunkType = MakeChunkType( 'J', 'O', 'I', 'N' );
+// Array of MeshCluster. Optional.
+const uint32_t ClusterChunkType = MakeChunkType( 'C', 'L', 'U', 'S' );
+// Array of MeshLod, starting with LOD 0. Optional. SubMeshChunkV2::faceCount includes every LOD.
+const uint32_t LodChunkType = MakeChunkType( 'L', 'O', 'D', 'S' );
+}
+
+static bool ReadJoints( std::istream& is, unsigned jointCount, std::vector< Joint >& outJoints, const std::string& path )
 {
-    bool found = false;
-    
-    for (auto instance : gMeshInstances)
+    outJoints.resize( jointCount );
+
+    for (size_t j = 0; j < outJoints.size(); ++j)
     {
-        if (instance == mesh)
+        is.read( (char*)&outJoints[ j ].globalBindposeInverse, sizeof( ae3d::Matrix44 ) );
+        is.read( (char*)&outJoints[ j ].parentIndex, 4 );
+        int jointNameLength;
+        is.read( (char*)&jointNameLength, sizeof( int ) );
+
+        if (jointNameLength < 0 || jointNameLength > 127)
         {
-            found = true;
+            System::Print( "Mesh %s has a joint with too long name, max is 127.\n", path.c_str() );
+            return false;
         }
-    }
-    
-    if (!found)
-    {
-        gMeshInstances.push_back( mesh );
-    }
-}
 
-void MeshReload( const std::string& path )
-{
-    // Invalidates cache
-    for (std::size_t i = 0; i < gMeshCache.size(); ++i)
-    {
-        if (gMeshCache[ i ].path == path)
+        is.read( outJoints[ j ].name, jointNameLength );
+        outJoints[ j ].name[ jointNameLength ] = 0;
+        int animLength;
+        is.read( (char*)&animLength, sizeof( int ) );
+
+        if (!is || animLength < 0)
         {
-            gMeshCache.erase( std::begin( gMeshCache ) + i );
-            break;
+            return false;
         }
+
+        outJoints[ j ].animTransforms.resize( animLength );
+        is.read( (char*)outJoints[ j ].animTransforms.data(), outJoints[ j ].animTransforms.size() * sizeof( ae3d::Matrix44 ) );
     }
-    
-    for (auto instance : gMeshInstances)
+
+    return true;
+}
+
+static void SetSubMeshDebugName( SubMesh& subMesh, const std::string& path )
+{
+    const std::size_t pos = path.find_last_of( '/' );
+    std::string shortPath = path;
+
+    if (pos != std::string::npos)
     {
-        if (instance->GetPath() == path)
-        {
-            instance->Load( FileSystem::FileContents( path.c_str() ) );
-        }
+        shortPath = path.substr( pos );
     }
+
+    std::string subMeshDebugName = shortPath + std::string( ":" ) + subMesh.name;
+    subMesh.vertexBuffer.SetDebugName( subMeshDebugName.c_str() );
 }
 
-ae3d::Mesh::Mesh()
+static bool IsVersion2( const unsigned char* data, std::size_t size )
 {
-    new(&_storage)Impl();
+    return size >= sizeof( FileHeaderV2 ) && std::memcmp( data, "ae3d", 4 ) == 0;
 }
 
-ae3d::Mesh::~Mesh()
+template< typename Vertex >
+static void CopyPositions( const Vertex* vertices, std::size_t vertexCount, std::vector< Vec3 >& outPositions )
 {
-    reinterpret_cast< Impl* >(&_storage)->~Impl();
+    outPositions.resize( vertexCount );
+
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        outPositions[ v ] = vertices[ v ].position;
+    }
 }
 
-ae3d::Mesh::Mesh( const Mesh& other )
+template< typename Vertex >
+static void ReleaseVertices( std::vector< Vertex >& vertices, std::vector< Vec3 >& outPositions )
 {
-    new(&_storage)Impl();
-    reinterpret_cast<Impl&>(_storage) = reinterpret_cast<Impl const&>(other._storage);
+    if (gCpuData == Mesh::CpuData::Positions && !vertices.empty())
+    {
+        CopyPositions( vertices.data(), vertices.size(), outPositions );
+    }
+
+    std::vector< Vertex >().swap( vertices );
 }
 
-ae3d::Mesh& ae3d::Mesh::operator=( const Mesh& other )
+// Drops CPU copies that have been uploaded to the vertex buffer, according to gCpuData.
+static void ReleaseCpuData( SubMesh& subMesh )
 {
-    if (this == &other)
+    if (gCpuData == Mesh::CpuData::All)
     {
-        return *this;
+        return;
     }
 
-    new(&_storage)Impl();
-    reinterpret_cast<Impl&>(_storage) = reinterpret_cast<Impl const&>(other._storage);
-    return *this;
+    ReleaseVertices( subMesh.verticesPTNTC, subMesh.positions );
+    ReleaseVertices( subMesh.verticesPTN, subMesh.positions );
+    ReleaseVertices( subMesh.verticesPTNTC_Skinned, subMesh.positions );
+
+    if (gCpuData == Mesh::CpuData::None)
+    {
+        std::vector< VertexBuffer::Face >().swap( subMesh.indices );
+        std::vector< VertexBuffer::Face32 >().swap( subMesh.indices32 );
+    }
 }
 
-const char* ae3d::Mesh::GetPath() const
+static void Dequantize( const Quantization::VertexPTN& in, const Vec3& aabbMin, const Vec3& aabbMax, VertexBuffer::VertexPTN& out )
 {
-    return m().path.c_str();
+    out.position = Quantization::DequantizePosition( in.position, aabbMin, aabbMax );
+    out.u = Quantization::HalfToFloat( in.uv[ 0 ] );
+    out.v = Quantization::HalfToFloat( in.uv[ 1 ] );
+    out.normal = Quantization::OctahedralDecode( in.normal );
 }
 
-const Vec3& ae3d::Mesh::GetAABBMin() const
+template< typename QuantizedVertex, typename Vertex >
+static void DequantizePTNTC( const QuantizedVertex& in, const Vec3& aabbMin, const Vec3& aabbMax, Vertex& out )
 {
-    return m().aabbMin;
+    out.position = Quantization::DequantizePosition( in.position, aabbMin, aabbMax );
+    out.u = Quantization::HalfToFloat( in.uv[ 0 ] );
+    out.v = Quantization::HalfToFloat( in.uv[ 1 ] );
+    out.normal = Quantization::OctahedralDecode( in.normal );
+    const Vec3 tangent = Quantization::OctahedralDecode( in.tangent );
+    out.tangent = Vec4( tangent.x, tangent.y, tangent.z, in.position[ 3 ] < 0 ? -1.0f : 1.0f );
+    out.color = Vec4( Quantization::Unorm8ToFloat( in.color[ 0 ] ), Quantization::Unorm8ToFloat( in.color[ 1 ] ),
+                      Quantization::Unorm8ToFloat( in.color[ 2 ] ), Quantization::Unorm8ToFloat( in.color[ 3 ] ) );
 }
 
-const Vec3& ae3d::Mesh::GetAABBMax() const
+static void Dequantize( const Quantization::VertexPTNTC& in, const Vec3& aabbMin, const Vec3& aabbMax, VertexBuffer::VertexPTNTC& out )
 {
-    return m().aabbMax;
+    DequantizePTNTC( in, aabbMin, aabbMax, out );
 }
 
-const Vec3& ae3d::Mesh::GetSubMeshAABBMin( unsigned subMeshIndex ) const
+static void Dequantize( const Quantization::VertexPTNTC_Skinned& in, const Vec3& aabbMin, const Vec3& aabbMax, VertexBuffer::VertexPTNTC_Skinned& out )
 {
-    return m().subMeshes[ subMeshIndex < m().subMeshes.size() ? subMeshIndex : 0 ].aabbMin;
+    DequantizePTNTC( in, aabbMin, aabbMax, out );
+    out.weights = Vec4( Quantization::Unorm8ToFloat( in.weights[ 0 ] ), Quantization::Unorm8ToFloat( in.weights[ 1 ] ),
+                        Quantization::Unorm8ToFloat( in.weights[ 2 ] ), Quantization::Unorm8ToFloat( in.weights[ 3 ] ) );
+
+    for (int i = 0; i < 4; ++i)
+    {
+        out.bones[ i ] = in.bones[ i ];
+    }
 }
 
-const Vec3& ae3d::Mesh::GetSubMeshAABBMax( unsigned subMeshIndex ) const
+template< typename QuantizedVertex, typename Vertex >
+static void DequantizeVertices( const void* vertices, unsigned vertexCount, const Vec3& aabbMin, const Vec3& aabbMax, std::vector< Vertex >& outVertices )
 {
-    return m().subMeshes[ subMeshIndex < m().subMeshes.size() ? subMeshIndex : 0 ].aabbMax;
+    const QuantizedVertex* quantizedVertices = static_cast< const QuantizedVertex* >( vertices );
+    outVertices.resize( vertexCount );
+
+    for (unsigned v = 0; v < vertexCount; ++v)
+    {
+        Dequantize( quantizedVertices[ v ], aabbMin, aabbMax, outVertices[ v ] );
+    }
 }
 
-const char* ae3d::Mesh::GetSubMeshName( unsigned index ) const
+template< typename Vertex >
+static void UploadVertices( SubMesh& subMesh, const std::vector< Vertex >& vertices )
 {
-    return m().subMeshes[ index < m().subMeshes.size() ? index : 0 ].name.c_str();
+    if (subMesh.indices32.empty())
+    {
+        subMesh.vertexBuffer.Generate( subMesh.indices.data(), static_cast< int >( subMesh.indices.size() ), vertices.data(), static_cast< int >( vertices.size() ) );
+    }
+    else
+    {
+        subMesh.vertexBuffer.Generate( subMesh.indices32.data(), static_cast< int >( subMesh.indices32.size() ), vertices.data(), static_cast< int >( vertices.size() ) );
+    }
 }
 
-ae3d::SubMesh* ae3d::Mesh::GetSubMeshes( int& outCount )
+#if RENDERER_VULKAN
+template< typename QuantizedVertex, typename Face >
+static void UploadQuantizedVertices( SubMesh& subMesh, const std::vector< Face >& faces )
 {
-	outCount = (int)m().subMeshes.size();
-    return m().subMeshes.data();
+    subMesh.vertexBuffer.Generate( faces.data(), static_cast< int >( faces.size() ), reinterpret_cast< const QuantizedVertex* >( subMesh.quantizedVertices.data() ),
+                                   static_cast< int >( subMesh.quantizedVertices.size() / sizeof( QuantizedVertex ) ), subMesh.aabbMin, subMesh.aabbMax );
 }
 
-void ae3d::Mesh::GetSubMeshFlattenedTriangles( unsigned subMeshIndex, Array< Vec3 >& outTriangles ) const
+template< typename QuantizedVertex >
+static void UploadQuantizedVertices( SubMesh& subMesh )
 {
-    if (subMeshIndex >= m().subMeshes.size())
+    if (subMesh.indices32.empty())
     {
-        System::Print( "Invalid submesh index in GetSubMeshFlattenedTriangles\n" );
-        return;
+        UploadQuantizedVertices< QuantizedVertex >( subMesh, subMesh.indices );
     }
-    
-    auto& subMesh = m().subMeshes[ subMeshIndex ];
-    const int faceCount = subMesh.vertexBuffer.GetFaceCount();
-    outTriangles.Allocate( faceCount * 3 );
-    
-    if (!subMesh.verticesPTNTC.empty())
+    else
     {
-        for (int faceIndex = 0; faceIndex < faceCount / 3; ++faceIndex)
-        {
-            const auto& face = subMesh.indices[ faceIndex ];
-            outTriangles[ faceIndex * 3 + 0 ] = subMesh.verticesPTNTC.at( face.a ).position;
-            outTriangles[ faceIndex * 3 + 1 ] = subMesh.verticesPTNTC.at( face.b ).position;
-            outTriangles[ faceIndex * 3 + 2 ] = subMesh.verticesPTNTC.at( face.c ).position;
-        }
+        UploadQuantizedVertices< QuantizedVertex >( subMesh, subMesh.indices32 );
     }
-    else if (!subMesh.verticesPTN.empty())
+}
+#endif
+
+// Uploads a submesh that was loaded without uploading, then drops CPU copies according to gCpuData. Called on the render thread.
+static void UploadSubMesh( SubMesh& subMesh, const std::string& path )
+{
+#if RENDERER_VULKAN
+    if (!subMesh.quantizedVertices.empty())
     {
-        for (int faceIndex = 0; faceIndex < faceCount; ++faceIndex)
+        if (!subMesh.verticesPTNTC.empty())
+        {
+            UploadQuantizedVertices< Quantization::VertexPTNTC >( subMesh );
+        }
+        else if (!subMesh.verticesPTN.empty())
         {
-            const auto& face = subMesh.indices[ faceIndex ];
-            outTriangles[ faceIndex * 3 + 0 ] = subMesh.verticesPTN.at( face.a ).position;
-            outTriangles[ faceIndex * 3 + 1 ] = subMesh.verticesPTN.at( face.b ).position;
-            outTriangles[ faceIndex * 3 + 2 ] = subMesh.verticesPTN.at( face.c ).position;
+            UploadQuantizedVertices< Quantization::VertexPTN >( subMesh );
         }
+        else
+        {
+            UploadQuantizedVertices< Quantization::VertexPTNTC_Skinned >( subMesh );
+        }
+
+        std::vector< unsigned char >().swap( subMesh.quantizedVertices );
     }
     else
+#endif
+    if (!subMesh.verticesPTNTC.empty())
+    {
+        UploadVertices( subMesh, subMesh.verticesPTNTC );
+    }
+    else if (!subMesh.verticesPTN.empty())
     {
-        System::Print("Empty vertex data in subMesh!\n");
+        UploadVertices( subMesh, subMesh.verticesPTN );
     }
+    else if (!subMesh.verticesPTNTC_Skinned.empty())
+    {
+        UploadVertices( subMesh, subMesh.verticesPTNTC_Skinned );
+    }
+
+    ReleaseCpuData( subMesh );
+    SetSubMeshDebugName( subMesh, path );
 }
 
-unsigned ae3d::Mesh::GetSubMeshCount() const
+// Keeps the CPU copies that gCpuData asks for. Without uploading, keeps everything for UploadSubMesh().
+template< typename Vertex >
+static void KeepCpuData( SubMesh& subMesh, const void* faces, unsigned indexSize, unsigned faceCount, const Vertex* vertices, unsigned vertexCount,
+                         bool uploadToGpu, std::vector< Vertex >& outVertices )
 {
-    return (unsigned)m().subMeshes.size();
+    if (uploadToGpu && gCpuData == Mesh::CpuData::None)
+    {
+        return;
+    }
+
+    if (indexSize == 4)
+    {
+        const VertexBuffer::Face32* faces32 = static_cast< const VertexBuffer::Face32* >( faces );
+        subMesh.indices32.assign( faces32, faces32 + faceCount );
+    }
+    else
+    {
+        const VertexBuffer::Face* faces16 = static_cast< const VertexBuffer::Face* >( faces );
+        subMesh.indices.assign( faces16, faces16 + faceCount );
+    }
+
+    if (!uploadToGpu || gCpuData == Mesh::CpuData::All)
+    {
+        outVertices.assign( vertices, vertices + vertexCount );
+    }
+    else if (gCpuData == Mesh::CpuData::Positions)
+    {
+        CopyPositions( vertices, vertexCount, subMesh.positions );
+    }
 }
 
-ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& meshData )
+// Uploads straight from the file data, then keeps the CPU copies that gCpuData asks for.
+template< typename Vertex >
+static void GenerateSubMesh( SubMesh& subMesh, const void* faces, unsigned indexSize, unsigned faceCount, const Vertex* vertices, unsigned vertexCount,
+                             bool uploadToGpu, std::vector< Vertex >& outVertices )
 {
-    for (const auto& entry : gMeshCache)
+    if (uploadToGpu && indexSize == 4)
     {
-        if (entry.path == meshData.path)
-        {
-            m().aabbMin = entry.aabbMin;
-            m().aabbMax = entry.aabbMax;
-            m().subMeshes = entry.subMeshes;
-            m().path = entry.path;
+        subMesh.vertexBuffer.Generate( static_cast< const VertexBuffer::Face32* >( faces ), static_cast< int >( faceCount ), vertices, static_cast< int >( vertexCount ) );
+    }
+    else if (uploadToGpu)
+    {
+        subMesh.vertexBuffer.Generate( static_cast< const VertexBuffer::Face* >( faces ), static_cast< int >( faceCount ), vertices, static_cast< int >( vertexCount ) );
+    }
 
-            AddUniqueInstance( this );
-            
-            return LoadResult::Success;
-        }
+    KeepCpuData( subMesh, faces, indexSize, faceCount, vertices, vertexCount, uploadToGpu, outVertices );
+}
+
+// Vulkan uploads quantized vertices as they are and vertex shaders decode them. Other renderers upload decoded vertices.
+// CPU copies are always decoded.
+template< typename QuantizedVertex, typename Vertex >
+static void GenerateQuantizedSubMesh( SubMesh& subMesh, const void* faces, unsigned indexSize, unsigned faceCount, const void* vertices, unsigned vertexCount,
+                                      bool uploadToGpu, std::vector< Vertex >& outVertices )
+{
+    std::vector< Vertex > decoded;
+#if RENDERER_VULKAN
+    const QuantizedVertex* quantizedVertices = static_cast< const QuantizedVertex* >( vertices );
+
+    if (uploadToGpu && indexSize == 4)
+    {
+        subMesh.vertexBuffer.Generate( static_cast< const VertexBuffer::Face32* >( faces ), static_cast< int >( faceCount ), quantizedVertices,
+                                       static_cast< int >( vertexCount ), subMesh.aabbMin, subMesh.aabbMax );
     }
-    
-    if (!meshData.isLoaded)
+    else if (uploadToGpu)
     {
-        const float s = 1;
-        
-        const VertexBuffer::VertexPTC vertices[ 8 ] =
-        {
-            { Vec3( -s, -s, s ), 0, 0 },
-            { Vec3( s, -s, s ), 0, 0 },
-            { Vec3( s, -s, -s ), 0, 0 },
-            { Vec3( -s, -s, -s ), 0, 0 },
-            { Vec3( -s, s, s ), 0, 0 },
-            { Vec3( s, s, s ), 0, 0 },
-            { Vec3( s, s, -s ), 0, 0 },
-            { Vec3( -s, s, -s ), 0, 0 }
-        };
-        
-        const VertexBuffer::Face indices[ 12 ] =
-        {
-            { 0, 4, 1 },
-            { 4, 5, 1 },
-            { 1, 5, 2 },
-            { 2, 5, 6 },
-            { 2, 6, 3 },
-            { 3, 6, 7 },
-            { 3, 7, 0 },
-            { 0, 7, 4 },
-            { 4, 7, 5 },
-            { 5, 7, 6 },
-            { 3, 0, 2 },
-            { 2, 0, 1 }
-        };
-        
-        m().subMeshes.resize( 1 );
-        auto& firstSubMesh = m().subMeshes[ 0 ];
-        firstSubMesh.vertexBuffer.Generate( indices, 12, vertices, 8, VertexBuffer::Storage::GPU );
-        firstSubMesh.vertexBuffer.SetDebugName( "default mesh" );
-        firstSubMesh.aabbMin = {-s, -s, -s};
-        firstSubMesh.aabbMax = { s,  s, s };
-        return LoadResult::FileNotFound;
+        subMesh.vertexBuffer.Generate( static_cast< const VertexBuffer::Face* >( faces ), static_cast< int >( faceCount ), quantizedVertices,
+                                       static_cast< int >( vertexCount ), subMesh.aabbMin, subMesh.aabbMax );
     }
-    
+    else
+    {
+        const unsigned char* bytes = static_cast< const unsigned char* >( vertices );
+        subMesh.quantizedVertices.assign( bytes, bytes + vertexCount * sizeof( QuantizedVertex ) );
+    }
+
+    if (!uploadToGpu || gCpuData != Mesh::CpuData::None)
+    {
+        DequantizeVertices< QuantizedVertex >( vertices, vertexCount, subMesh.aabbMin, subMesh.aabbMax, decoded );
+    }
+
+    KeepCpuData( subMesh, faces, indexSize, faceCount, decoded.data(), vertexCount, uploadToGpu, outVertices );
+#else
+    DequantizeVertices< QuantizedVertex >( vertices, vertexCount, subMesh.aabbMin, subMesh.aabbMax, decoded );
+    GenerateSubMesh( subMesh, faces, indexSize, faceCount, decoded.data(), vertexCount, uploadToGpu, outVertices );
+#endif
+}
+
+// Without uploadToGpu, doesn't touch the GPU or gCpuData, so it can run on a worker thread. Submeshes must then be passed to UploadSubMesh().
+static Mesh::LoadResult LoadVersion1( const unsigned char* data, std::size_t size, const std::string& path, bool uploadToGpu, Vec3& outAabbMin, Vec3& outAabbMax, std::vector< SubMesh >& outSubMeshes )
+{
     uint8_t magic[ 2 ];
 
-    imemstream is( (const char*)meshData.data.data(), meshData.data.size() );
+    imemstream is( (const char*)data, size );
     is.read( (char*)&magic[ 0 ], sizeof( magic ) );
 
     if (magic[ 0 ] != 'a' || magic[ 1 ] != '9')
     {
-        System::Print( "%s is corrupted or old format: Wrong magic number!\n", meshData.path.c_str() );
-        return LoadResult::Corrupted;
+        System::Print( "%s is corrupted or old format: Wrong magic number!\n", path.c_str() );
+        return Mesh::LoadResult::Corrupted;
     }
 
-    is.read( (char*)&m().aabbMin, sizeof( m().aabbMin ) );
-    is.read( (char*)&m().aabbMax, sizeof( m().aabbMax ) );
-
-    const auto& aabbMin = m().aabbMin;
-    const auto& aabbMax = m().aabbMax;
+    is.read( (char*)&outAabbMin, sizeof( outAabbMin ) );
+    is.read( (char*)&outAabbMax, sizeof( outAabbMax ) );
 
-    if (aabbMin.x > aabbMax.x || aabbMin.y > aabbMax.y || aabbMin.z > aabbMax.z)
+    if (outAabbMin.x > outAabbMax.x || outAabbMin.y > outAabbMax.y || outAabbMin.z > outAabbMax.z)
     {
-        return LoadResult::Corrupted;
+        return Mesh::LoadResult::Corrupted;
     }
     
     uint16_t meshCount;
     is.read( (char*)&meshCount, sizeof( meshCount ) );
 
-    m().subMeshes.clear();
-    m().subMeshes.resize( meshCount );
+    outSubMeshes.clear();
+    outSubMeshes.resize( meshCount );
 
-    for (auto& subMesh : m().subMeshes)
+    for (auto& subMesh : outSubMeshes)
     {
         is.read( (char*)&subMesh.aabbMin, sizeof( subMesh.aabbMin ) );
         is.read( (char*)&subMesh.aabbMax, sizeof( subMesh.aabbMax ) );
@@ -315,7 +517,7 @@ ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& mes
             try { subMesh.verticesPTNTC.resize( vertexCount ); }
             catch (std::bad_alloc&)
             {
-                return LoadResult::OutOfMemory;
+                return Mesh::LoadResult::OutOfMemory;
             }
         
             is.read( (char*)&subMesh.verticesPTNTC[ 0 ].position.x, vertexCount * sizeof( VertexBuffer::VertexPTNTC ) );
@@ -325,7 +527,7 @@ ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& mes
             try { subMesh.verticesPTN.resize( vertexCount ); }
             catch (std::bad_alloc&)
             {
-                return LoadResult::OutOfMemory;
+                return Mesh::LoadResult::OutOfMemory;
             }
             
             is.read( (char*)&subMesh.verticesPTN[ 0 ].position.x, vertexCount * sizeof( VertexBuffer::VertexPTN ) );
@@ -335,15 +537,15 @@ ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& mes
             try { subMesh.verticesPTNTC_Skinned.resize( vertexCount ); }
             catch (std::bad_alloc&)
             {
-                return LoadResult::OutOfMemory;
+                return Mesh::LoadResult::OutOfMemory;
             }
             
             is.read( (char*)&subMesh.verticesPTNTC_Skinned[ 0 ].position.x, vertexCount * sizeof( VertexBuffer::VertexPTNTC_Skinned ) );
         }
         else
         {
-            System::Print( "Mesh %s submesh %s has invalid vertex format %d. Only 0 and 1 are valid!\n", meshData.path.c_str(), subMesh.name.c_str(), vertexFormat );
-            return LoadResult::Corrupted;
+            System::Print( "Mesh %s submesh %s has invalid vertex format %d. Only 0 and 1 are valid!\n", path.c_str(), subMesh.name.c_str(), vertexFormat );
+            return Mesh::LoadResult::Corrupted;
         }
 
         uint16_t faceCount = 0;
@@ -352,67 +554,26 @@ ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& mes
         try { subMesh.indices.resize( faceCount ); }
         catch (std::bad_alloc&)
         {
-            return LoadResult::OutOfMemory;
+            return Mesh::LoadResult::OutOfMemory;
         }
 
         is.read( (char*)&subMesh.indices[ 0 ], faceCount * sizeof( VertexBuffer::Face ) );
 
-        if (vertexFormat == 0)
-        {
-            subMesh.vertexBuffer.Generate( subMesh.indices.data(), static_cast< int >( subMesh.indices.size() ), subMesh.verticesPTNTC.data(), static_cast< int >( subMesh.verticesPTNTC.size() ) );
-        }
-        else if (vertexFormat == 1)
-        {
-            subMesh.vertexBuffer.Generate( subMesh.indices.data(), static_cast< int >( subMesh.indices.size() ), subMesh.verticesPTN.data(), static_cast< int >( subMesh.verticesPTN.size() ) );
-        }
-        else if (vertexFormat == 2)
-        {
-            subMesh.vertexBuffer.Generate( subMesh.indices.data(), static_cast< int >( subMesh.indices.size() ), subMesh.verticesPTNTC_Skinned.data(), static_cast< int >( subMesh.verticesPTNTC_Skinned.size() ) );
-        }
-        else
-        {
-            ae3d::System::Assert( false, "unhandled vertex format" );
-        }
-
         if (vertexFormat == 2)
         {
             uint16_t jointCount = 0;
             is.read( (char*)&jointCount, sizeof( jointCount ) );
 
-            subMesh.joints.resize( jointCount );
-            
-            for (size_t j = 0; j < subMesh.joints.size(); ++j)
+            if (!ReadJoints( is, jointCount, subMesh.joints, path ))
             {
-                is.read( (char*)&subMesh.joints[ j ].globalBindposeInverse, sizeof( ae3d::Matrix44 ) );
-                is.read( (char*)&subMesh.joints[ j ].parentIndex, 4 );
-                int jointNameLength;
-                is.read( (char*)&jointNameLength, sizeof( int ) );
-                
-                if (jointNameLength > 128)
-                {
-                    System::Print( "Mesh %s has a joint with too long name, max is 128.\n", meshData.path.c_str() );
-                    return LoadResult::Corrupted;
-                }
-
-                is.read( subMesh.joints[ j ].name, jointNameLength );
-                subMesh.joints[ j ].name[ jointNameLength ] = 0;
-                int animLength;
-                is.read( (char*)&animLength, sizeof( int ) );
-                subMesh.joints[ j ].animTransforms.resize( animLength );
-                is.read( (char*)subMesh.joints[ j ].animTransforms.data(), subMesh.joints[ j ].animTransforms.size() * sizeof( ae3d::Matrix44 ) );
+                return Mesh::LoadResult::Corrupted;
             }
         }
-        
-        const std::size_t pos = meshData.path.find_last_of( '/' );
-        std::string shortPath = meshData.path;
-        
-        if (pos != std::string::npos)
+
+        if (uploadToGpu)
         {
-            shortPath = meshData.path.substr( pos );
+            UploadSubMesh( subMesh, path );
         }
-
-        std::string subMeshDebugName = shortPath + std::string( ":" ) + subMesh.name;
-        subMesh.vertexBuffer.SetDebugName( subMeshDebugName.c_str() );
     }
     
     uint8_t terminator = 0;
@@ -420,21 +581,774 @@ ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& mes
 
     if (terminator != 100)
     {
-        return LoadResult::Corrupted;
+        return Mesh::LoadResult::Corrupted;
     }
 
-    MeshCacheEntry cacheEntry;
-    cacheEntry.path = meshData.path;
-    cacheEntry.aabbMin = m().aabbMin;
-    cacheEntry.aabbMax = m().aabbMax;
-    cacheEntry.subMeshes = m().subMeshes;
-    gMeshCache.push_back( cacheEntry );
+    return Mesh::LoadResult::Success;
+}
 
-    AddUniqueInstance( this );
+// Without uploadToGpu, doesn't touch the GPU or gCpuData, so it can run on a worker thread. Submeshes must then be passed to UploadSubMesh().
+static Mesh::LoadResult LoadVersion2( const unsigned char* data, std::size_t dataSize, const std::string& path, bool uploadToGpu, Vec3& outAabbMin, Vec3& outAabbMax,
+                                      std::vector< SubMesh >& outSubMeshes )
+{
+    const FileHeaderV2* header = reinterpret_cast< const FileHeaderV2* >( data );
 
-    fileWatcher.AddFile( meshData.path, MeshReload );
-    
-    m().path = meshData.path;
-    
-    return LoadResult::Success;
+    if (header->version != 2)
+    {
+        System::Print( "%s has unsupported version %u\n", path.c_str(), header->version );
+        return Mesh::LoadResult::Corrupted;
+    }
+
+    if (header->chunkCount > (dataSize - sizeof( FileHeaderV2 )) / sizeof( ChunkV2 ))
+    {
+        return Mesh::LoadResult::Corrupted;
+    }
+
+    const ChunkV2* chunks = reinterpret_cast< const ChunkV2* >( data + sizeof( FileHeaderV2 ) );
+
+    for (uint32_t c = 0; c < header->chunkCount; ++c)
+    {
+        if (chunks[ c ].offset % ChunkAlignment != 0 || chunks[ c ].offset > dataSize || chunks[ c ].size > dataSize - chunks[ c ].offset)
+        {
+            System::Print( "%s has an invalid chunk %u\n", path.c_str(), c );
+            return Mesh::LoadResult::Corrupted;
+        }
+    }
+
+    const MeshChunkV2* meshChunk = nullptr;
+
+    for (uint32_t c = 0; c < header->chunkCount; ++c)
+    {
+        if (chunks[ c ].type == MeshChunkType && chunks[ c ].size >= sizeof( MeshChunkV2 ))
+        {
+            meshChunk = reinterpret_cast< const MeshChunkV2* >( data + chunks[ c ].offset );
+        }
+    }
+
+    if (meshChunk == nullptr)
+    {
+        System::Print( "%s doesn't have a mesh chunk\n", path.c_str() );
+        return Mesh::LoadResult::Corrupted;
+    }
+
+    outAabbMin = meshChunk->aabbMin;
+    outAabbMax = meshChunk->aabbMax;
+
+    if (outAabbMin.x > outAabbMax.x || outAabbMin.y > outAabbMax.y || outAabbMin.z > outAabbMax.z)
+    {
+        return Mesh::LoadResult::Corrupted;
+    }
+
+    struct SubMeshChunks
+    {
+        const ChunkV2* subMesh = nullptr;
+        const ChunkV2* vertices = nullptr;
+        const ChunkV2* indices = nullptr;
+        const ChunkV2* joints = nullptr;
+        const ChunkV2* clusters = nullptr;
+        const ChunkV2* lods = nullptr;
+    };
+
+    std::vector< SubMeshChunks > subMeshChunks( meshChunk->subMeshCount );
+
+    for (uint32_t c = 0; c < header->chunkCount; ++c)
+    {
+        const ChunkV2& chunk = chunks[ c ];
+
+        if (chunk.type == MeshChunkType)
+        {
+            continue;
+        }
+
+        if (chunk.subMeshIndex >= subMeshChunks.size())
+        {
+            return Mesh::LoadResult::Corrupted;
+        }
+
+        // Unknown chunk types are skipped so that newer files can add data.
+        if (chunk.type == SubMeshChunkType)
+        {
+            subMeshChunks[ chunk.subMeshIndex ].subMesh = &chunk;
+        }
+        else if (chunk.type == VertexChunkType)
+        {
+            subMeshChunks[ chunk.subMeshIndex ].vertices = &chunk;
+        }
+        else if (chunk.type == IndexChunkType)
+        {
+            subMeshChunks[ chunk.subMeshIndex ].indices = &chunk;
+        }
+        else if (chunk.type == JointChunkType)
+        {
+            subMeshChunks[ chunk.subMeshIndex ].joints = &chunk;
+        }
+        else if (chunk.type == ClusterChunkType)
+        {
+            subMeshChunks[ chunk.subMeshIndex ].clusters = &chunk;
+        }
+        else if (chunk.type == LodChunkType)
+        {
+            subMeshChunks[ chunk.subMeshIndex ].lods = &chunk;
+        }
+    }
+
+    outSubMeshes.clear();
+
+    try { outSubMeshes.resize( subMeshChunks.size() ); }
+    catch (std::bad_alloc&)
+    {
+        return Mesh::LoadResult::OutOfMemory;
+    }
+
+    for (std::size_t subMeshIndex = 0; subMeshIndex < outSubMeshes.size(); ++subMeshIndex)
+    {
+        const SubMeshChunks& chunksForSubMesh = subMeshChunks[ subMeshIndex ];
+
+        if (chunksForSubMesh.subMesh == nullptr || chunksForSubMesh.vertices == nullptr || chunksForSubMesh.indices == nullptr ||
+            chunksForSubMesh.subMesh->size < sizeof( SubMeshChunkV2 ))
+        {
+            System::Print( "%s submesh %u is missing chunks\n", path.c_str(), (unsigned)subMeshIndex );
+            return Mesh::LoadResult::Corrupted;
+        }
+
+        const SubMeshChunkV2* desc = reinterpret_cast< const SubMeshChunkV2* >( data + chunksForSubMesh.subMesh->offset );
+        SubMesh& subMesh = outSubMeshes[ subMeshIndex ];
+        subMesh.aabbMin = desc->aabbMin;
+        subMesh.aabbMax = desc->aabbMax;
+
+        if (desc->nameLength > chunksForSubMesh.subMesh->size - sizeof( SubMeshChunkV2 ))
+        {
+            return Mesh::LoadResult::Corrupted;
+        }
+
+        subMesh.name.assign( reinterpret_cast< const char* >( desc + 1 ), desc->nameLength );
+
+        const std::size_t vertexStrides[ 6 ] = { sizeof( VertexBuffer::VertexPTNTC ), sizeof( VertexBuffer::VertexPTN ), sizeof( VertexBuffer::VertexPTNTC_Skinned ),
+                                                 sizeof( Quantization::VertexPTNTC ), sizeof( Quantization::VertexPTN ), sizeof( Quantization::VertexPTNTC_Skinned ) };
+
+        if (desc->vertexFormat > 5)
+        {
+            System::Print( "Mesh %s submesh %s has invalid vertex format %u. Only 0 - 5 are valid!\n", path.c_str(), subMesh.name.c_str(), desc->vertexFormat );
+            return Mesh::LoadResult::Corrupted;
+        }
+
+        if ((desc->indexSize != 2 && desc->indexSize != 4) ||
+            (uint64_t)desc->vertexCount * vertexStrides[ desc->vertexFormat ] != chunksForSubMesh.vertices->size ||
+            (uint64_t)desc->faceCount * 3 * desc->indexSize != chunksForSubMesh.indices->size)
+        {
+            System::Print( "Mesh %s submesh %s has invalid vertex or index data size\n", path.c_str(), subMesh.name.c_str() );
+            return Mesh::LoadResult::Corrupted;
+        }
+
+        const void* vertices = data + chunksForSubMesh.vertices->offset;
+        const void* faces = data + chunksForSubMesh.indices->offset;
+
+        try
+        {
+            if (desc->vertexFormat == 0)
+            {
+                GenerateSubMesh( subMesh, faces, desc->indexSize, desc->faceCount, static_cast< const VertexBuffer::VertexPTNTC* >( vertices ), desc->vertexCount, uploadToGpu, subMesh.verticesPTNTC );
+            }
+            else if (desc->vertexFormat == 1)
+            {
+                GenerateSubMesh( subMesh, faces, desc->indexSize, desc->faceCount, static_cast< const VertexBuffer::VertexPTN* >( vertices ), desc->vertexCount, uploadToGpu, subMesh.verticesPTN );
+            }
+            else if (desc->vertexFormat == 2)
+            {
+                GenerateSubMesh( subMesh, faces, desc->indexSize, desc->faceCount, static_cast< const VertexBuffer::VertexPTNTC_Skinned* >( vertices ), desc->vertexCount, uploadToGpu, subMesh.verticesPTNTC_Skinned );
+            }
+            else if (desc->vertexFormat == 3)
+            {
+                GenerateQuantizedSubMesh< Quantization::VertexPTNTC >( subMesh, faces, desc->indexSize, desc->faceCount, vertices, desc->vertexCount, uploadToGpu, subMesh.verticesPTNTC );
+            }
+            else if (desc->vertexFormat == 4)
+            {
+                GenerateQuantizedSubMesh< Quantization::VertexPTN >( subMesh, faces, desc->indexSize, desc->faceCount, vertices, desc->vertexCount, uploadToGpu, subMesh.verticesPTN );
+            }
+            else
+            {
+                GenerateQuantizedSubMesh< Quantization::VertexPTNTC_Skinned >( subMesh, faces, desc->indexSize, desc->faceCount, vertices, desc->vertexCount, uploadToGpu, subMesh.verticesPTNTC_Skinned );
+            }
+        }
+        catch (std::bad_alloc&)
+        {
+            return Mesh::LoadResult::OutOfMemory;
+        }
+
+        if (chunksForSubMesh.joints != nullptr)
+        {
+            imemstream is( reinterpret_cast< const char* >( data + chunksForSubMesh.joints->offset ), chunksForSubMesh.joints->size );
+
+            if (!ReadJoints( is, desc->jointCount, subMesh.joints, path ))
+            {
+                return Mesh::LoadResult::Corrupted;
+            }
+        }
+
+        if (chunksForSubMesh.clusters != nullptr)
+        {
+            if (chunksForSubMesh.clusters->size % sizeof( MeshCluster ) != 0)
+            {
+                System::Print( "Mesh %s submesh %s has invalid cluster data size\n", path.c_str(), subMesh.name.c_str() );
+                return Mesh::LoadResult::Corrupted;
+            }
+
+            const MeshCluster* clusters = reinterpret_cast< const MeshCluster* >( data + chunksForSubMesh.clusters->offset );
+
+            try
+            {
+                subMesh.clusters.assign( clusters, clusters + chunksForSubMesh.clusters->size / sizeof( MeshCluster ) );
+            }
+            catch (std::bad_alloc&)
+            {
+                return Mesh::LoadResult::OutOfMemory;
+            }
+
+            for (const auto& cluster : subMesh.clusters)
+            {
+                if (cluster.firstFace > desc->faceCount || cluster.faceCount > desc->faceCount - cluster.firstFace)
+                {
+                    System::Print( "Mesh %s submesh %s has a cluster outside its faces\n", path.c_str(), subMesh.name.c_str() );
+                    return Mesh::LoadResult::Corrupted;
+                }
+            }
+        }
+
+        if (chunksForSubMesh.lods != nullptr)
+        {
+            if (chunksForSubMesh.lods->size % sizeof( MeshLod ) != 0 || chunksForSubMesh.lods->size == 0)
+            {
+                System::Print( "Mesh %s submesh %s has invalid LOD data size\n", path.c_str(), subMesh.name.c_str() );
+                return Mesh::LoadResult::Corrupted;
+            }
+
+            const MeshLod* lods = reinterpret_cast< const MeshLod* >( data + chunksForSubMesh.lods->offset );
+
+            try
+            {
+                subMesh.lods.assign( lods, lods + chunksForSubMesh.lods->size / sizeof( MeshLod ) );
+            }
+            catch (std::bad_alloc&)
+            {
+                return Mesh::LoadResult::OutOfMemory;
+            }
+
+            for (const auto& lod : subMesh.lods)
+            {
+                if (lod.firstFace > desc->faceCount || lod.faceCount > desc->faceCount - lod.firstFace || lod.faceCount == 0)
+                {
+                    System::Print( "Mesh %s submesh %s has a LOD outside its faces\n", path.c_str(), subMesh.name.c_str() );
+                    return Mesh::LoadResult::Corrupted;
+                }
+            }
+
+            if (subMesh.lods[ 0 ].firstFace != 0)
+            {
+                System::Print( "Mesh %s submesh %s LOD 0 doesn't start from the first face\n", path.c_str(), subMesh.name.c_str() );
+                return Mesh::LoadResult::Corrupted;
+            }
+        }
+
+        if (uploadToGpu)
+        {
+            SetSubMeshDebugName( subMesh, path );
+        }
+    }
+
+    return Mesh::LoadResult::Success;
+}
+
+void AddUniqueInstance( Mesh* mesh )
+{
+    bool found = false;
+    
+    for (auto instance : gMeshInstances)
+    {
+        if (instance == mesh)
+        {
+            found = true;
+        }
+    }
+    
+    if (!found)
+    {
+        gMeshInstances.push_back( mesh );
+    }
+}
+
+static void RemoveExpiredCacheEntries()
+{
+    for (auto it = std::begin( gMeshCache ); it != std::end( gMeshCache ); )
+    {
+        if (!AssetRegistry::IsValid( it->second.handle ))
+        {
+            it = gMeshCache.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+static std::size_t GetMemoryUsage( const MeshAsset& asset )
+{
+    std::size_t bytes = sizeof( MeshAsset ) + asset.path.capacity() + asset.subMeshes.capacity() * sizeof( SubMesh );
+
+    for (const auto& subMesh : asset.subMeshes)
+    {
+        bytes += subMesh.name.capacity();
+        bytes += subMesh.verticesPTNTC.capacity() * sizeof( VertexBuffer::VertexPTNTC );
+        bytes += subMesh.verticesPTNTC_Skinned.capacity() * sizeof( VertexBuffer::VertexPTNTC_Skinned );
+        bytes += subMesh.verticesPTN.capacity() * sizeof( VertexBuffer::VertexPTN );
+        bytes += subMesh.indices.capacity() * sizeof( VertexBuffer::Face );
+        bytes += subMesh.indices32.capacity() * sizeof( VertexBuffer::Face32 );
+        bytes += subMesh.positions.capacity() * sizeof( Vec3 );
+        bytes += subMesh.joints.capacity() * sizeof( Joint );
+        bytes += subMesh.clusters.capacity() * sizeof( MeshCluster );
+        bytes += subMesh.lods.capacity() * sizeof( MeshLod );
+
+        for (const auto& joint : subMesh.joints)
+        {
+            bytes += joint.animTransforms.capacity() * sizeof( Matrix44 );
+        }
+    }
+
+    return bytes;
+}
+
+// Returns the users pointer of a cached asset. If the asset has no users, it's referenced again.
+static std::shared_ptr< MeshAsset > ShareAsset( CachedMesh& entry )
+{
+    std::shared_ptr< MeshAsset > users = entry.users.lock();
+    std::shared_ptr< MeshAsset > asset = entry.asset.lock();
+
+    if (users || !asset)
+    {
+        return users;
+    }
+
+    const AssetRegistry::Handle handle = entry.handle;
+    AssetRegistry::AddRef( handle );
+
+    try { users.reset( asset.get(), [handle]( MeshAsset* ) { AssetRegistry::Release( handle ); } ); }
+    catch (std::bad_alloc&)
+    {
+        return users;
+    }
+
+    entry.users = users;
+    return users;
+}
+
+static std::shared_ptr< MeshAsset > FindCachedAsset( const std::string& path )
+{
+    auto cacheIt = gMeshCache.find( path );
+    return (cacheIt != std::end( gMeshCache ) && AssetRegistry::IsValid( cacheIt->second.handle )) ? ShareAsset( cacheIt->second ) : std::shared_ptr< MeshAsset >();
+}
+
+void MeshReload( const std::string& path );
+
+// Makes a loaded asset available to later loads of the same path. Returns the pointer that meshes share.
+static std::shared_ptr< MeshAsset > AddToCache( const std::shared_ptr< MeshAsset >& asset, const std::string& path )
+{
+    asset->path = path;
+    asset->cpuBytes = ::GetMemoryUsage( *asset );
+    ::Statistics::IncResidentMeshCpuBytes( asset->cpuBytes );
+
+    RemoveExpiredCacheEntries();
+
+    std::shared_ptr< MeshAsset > owner = asset;
+    CachedMesh& entry = gMeshCache[ path ];
+    entry.asset = asset;
+    entry.users.reset();
+    entry.handle = AssetRegistry::Register( AssetRegistry::Category::Mesh, path, asset->cpuBytes, [owner]() mutable { owner.reset(); } );
+    // ShareAsset() adds the reference.
+    AssetRegistry::Release( entry.handle );
+
+    fileWatcher.AddFile( path, MeshReload );
+
+    return ShareAsset( entry );
+}
+
+// Cube that is used when a mesh file is not found and while a mesh is being loaded asynchronously.
+static std::shared_ptr< MeshAsset > GetDefaultAsset()
+{
+    static std::weak_ptr< MeshAsset > defaultAsset;
+    std::shared_ptr< MeshAsset > asset = defaultAsset.lock();
+
+    if (asset)
+    {
+        return asset;
+    }
+
+    asset.reset( new MeshAsset() );
+
+    const float s = 1;
+    
+    const VertexBuffer::VertexPTC vertices[ 8 ] =
+    {
+        { Vec3( -s, -s, s ), 0, 0 },
+        { Vec3( s, -s, s ), 0, 0 },
+        { Vec3( s, -s, -s ), 0, 0 },
+        { Vec3( -s, -s, -s ), 0, 0 },
+        { Vec3( -s, s, s ), 0, 0 },
+        { Vec3( s, s, s ), 0, 0 },
+        { Vec3( s, s, -s ), 0, 0 },
+        { Vec3( -s, s, -s ), 0, 0 }
+    };
+    
+    const VertexBuffer::Face indices[ 12 ] =
+    {
+        { 0, 4, 1 },
+        { 4, 5, 1 },
+        { 1, 5, 2 },
+        { 2, 5, 6 },
+        { 2, 6, 3 },
+        { 3, 6, 7 },
+        { 3, 7, 0 },
+        { 0, 7, 4 },
+        { 4, 7, 5 },
+        { 5, 7, 6 },
+        { 3, 0, 2 },
+        { 2, 0, 1 }
+    };
+    
+    asset->subMeshes.resize( 1 );
+    auto& firstSubMesh = asset->subMeshes[ 0 ];
+    firstSubMesh.vertexBuffer.Generate( indices, 12, vertices, 8, VertexBuffer::Storage::GPU );
+    firstSubMesh.vertexBuffer.SetDebugName( "default mesh" );
+    firstSubMesh.aabbMin = {-s, -s, -s};
+    firstSubMesh.aabbMax = { s,  s, s };
+    defaultAsset = asset;
+    return asset;
+}
+
+void ae3d::System::Statistics::PrintMeshMemoryUsage()
+{
+    std::size_t totalBytes = 0;
+
+    for (const auto& entry : gMeshCache)
+    {
+        std::shared_ptr< MeshAsset > asset = entry.second.asset.lock();
+
+        if (asset && AssetRegistry::IsValid( entry.second.handle ))
+        {
+            const std::size_t bytes = asset->cpuBytes;
+            totalBytes += bytes;
+            System::Print( "%s: %u KiB, %ld users\n", entry.first.c_str(), (unsigned)(bytes / 1024), entry.second.users.use_count() );
+        }
+    }
+
+    System::Print( "mesh total: %u KiB\n", (unsigned)(totalBytes / 1024) );
+}
+
+void MeshReload( const std::string& path )
+{
+    // Invalidates cache. Meshes keep using the old data until they are reloaded below, then it's evicted.
+    auto cacheIt = gMeshCache.find( path );
+
+    if (cacheIt != std::end( gMeshCache ))
+    {
+        AssetRegistry::Unregister( cacheIt->second.handle );
+        gMeshCache.erase( cacheIt );
+    }
+
+    for (auto instance : gMeshInstances)
+    {
+        if (instance->GetPath() == path)
+        {
+            instance->Load( FileSystem::OpenFileView( path.c_str() ) );
+        }
+    }
+}
+
+ae3d::Mesh::Mesh()
+{
+    new(&_storage)Impl();
+}
+
+ae3d::Mesh::~Mesh()
+{
+    reinterpret_cast< Impl* >(&_storage)->~Impl();
+}
+
+ae3d::Mesh::Mesh( const Mesh& other )
+{
+    new(&_storage)Impl();
+    reinterpret_cast<Impl&>(_storage) = reinterpret_cast<Impl const&>(other._storage);
+}
+
+ae3d::Mesh& ae3d::Mesh::operator=( const Mesh& other )
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    reinterpret_cast<Impl&>(_storage) = reinterpret_cast<Impl const&>(other._storage);
+    return *this;
+}
+
+const char* ae3d::Mesh::GetPath() const
+{
+    return m().GetAsset().path.c_str();
+}
+
+const Vec3& ae3d::Mesh::GetAABBMin() const
+{
+    return m().GetAsset().aabbMin;
+}
+
+const Vec3& ae3d::Mesh::GetAABBMax() const
+{
+    return m().GetAsset().aabbMax;
+}
+
+const Vec3& ae3d::Mesh::GetSubMeshAABBMin( unsigned subMeshIndex ) const
+{
+    const auto& subMeshes = m().GetAsset().subMeshes;
+    return subMeshes[ subMeshIndex < subMeshes.size() ? subMeshIndex : 0 ].aabbMin;
+}
+
+const Vec3& ae3d::Mesh::GetSubMeshAABBMax( unsigned subMeshIndex ) const
+{
+    const auto& subMeshes = m().GetAsset().subMeshes;
+    return subMeshes[ subMeshIndex < subMeshes.size() ? subMeshIndex : 0 ].aabbMax;
+}
+
+const char* ae3d::Mesh::GetSubMeshName( unsigned index ) const
+{
+    const auto& subMeshes = m().GetAsset().subMeshes;
+    return subMeshes[ index < subMeshes.size() ? index : 0 ].name.c_str();
+}
+
+std::size_t ae3d::Mesh::GetMemoryUsage() const
+{
+    return m().GetAsset().cpuBytes;
+}
+
+void ae3d::Mesh::SetCpuData( CpuData cpuData )
+{
+    gCpuData = cpuData;
+}
+
+ae3d::SubMesh* ae3d::Mesh::GetSubMeshes( int& outCount )
+{
+    if (!m().asset)
+    {
+        outCount = 0;
+        return nullptr;
+    }
+
+	outCount = (int)m().asset->subMeshes.size();
+    return m().asset->subMeshes.data();
+}
+
+static const Vec3& GetPosition( const Vec3& position )
+{
+    return position;
+}
+
+template< typename Vertex >
+static const Vec3& GetPosition( const Vertex& vertex )
+{
+    return vertex.position;
+}
+
+template< typename Vertex >
+static void GetFlattenedTriangles( const std::vector< VertexBuffer::Face >& faces, const std::vector< VertexBuffer::Face32 >& faces32, std::size_t faceCount,
+                                   const std::vector< Vertex >& vertices, Array< Vec3 >& outTriangles )
+{
+    faceCount = std::min( faceCount, faces.size() + faces32.size() );
+    outTriangles.Allocate( static_cast< unsigned >( faceCount * 3 ) );
+
+    for (std::size_t faceIndex = 0; faceIndex < faces.size() && faceIndex < faceCount; ++faceIndex)
+    {
+        const auto& face = faces[ faceIndex ];
+        outTriangles[ faceIndex * 3 + 0 ] = GetPosition( vertices.at( face.a ) );
+        outTriangles[ faceIndex * 3 + 1 ] = GetPosition( vertices.at( face.b ) );
+        outTriangles[ faceIndex * 3 + 2 ] = GetPosition( vertices.at( face.c ) );
+    }
+
+    for (std::size_t faceIndex = 0; faceIndex < faces32.size() && faceIndex < faceCount; ++faceIndex)
+    {
+        const auto& face = faces32[ faceIndex ];
+        outTriangles[ faceIndex * 3 + 0 ] = GetPosition( vertices.at( face.a ) );
+        outTriangles[ faceIndex * 3 + 1 ] = GetPosition( vertices.at( face.b ) );
+        outTriangles[ faceIndex * 3 + 2 ] = GetPosition( vertices.at( face.c ) );
+    }
+}
+
+void ae3d::Mesh::GetSubMeshFlattenedTriangles( unsigned subMeshIndex, Array< Vec3 >& outTriangles ) const
+{
+    if (subMeshIndex >= m().GetAsset().subMeshes.size())
+    {
+        System::Print( "Invalid submesh index in GetSubMeshFlattenedTriangles\n" );
+        return;
+    }
+    
+    const auto& subMesh = m().GetAsset().subMeshes[ subMeshIndex ];
+    // Coarser LODs follow LOD 0 in the index buffer.
+    const std::size_t faceCount = subMesh.lods.empty() ? subMesh.indices.size() + subMesh.indices32.size() : subMesh.lods[ 0 ].faceCount;
+    
+    if (!subMesh.positions.empty())
+    {
+        GetFlattenedTriangles( subMesh.indices, subMesh.indices32, faceCount, subMesh.positions, outTriangles );
+    }
+    else if (!subMesh.verticesPTNTC.empty())
+    {
+        GetFlattenedTriangles( subMesh.indices, subMesh.indices32, faceCount, subMesh.verticesPTNTC, outTriangles );
+    }
+    else if (!subMesh.verticesPTN.empty())
+    {
+        GetFlattenedTriangles( subMesh.indices, subMesh.indices32, faceCount, subMesh.verticesPTN, outTriangles );
+    }
+    else if (!subMesh.verticesPTNTC_Skinned.empty())
+    {
+        GetFlattenedTriangles( subMesh.indices, subMesh.indices32, faceCount, subMesh.verticesPTNTC_Skinned, outTriangles );
+    }
+    else
+    {
+        System::Print( "Mesh %s has no CPU vertex data. Load it after Mesh::SetCpuData( CpuData::All ) or CpuData::Positions.\n", GetPath() );
+    }
+}
+
+unsigned ae3d::Mesh::GetSubMeshCount() const
+{
+    return (unsigned)m().GetAsset().subMeshes.size();
+}
+
+ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileContentsData& meshData )
+{
+    return Load( meshData.data.data(), meshData.data.size(), meshData.path.c_str(), meshData.isLoaded );
+}
+
+ae3d::Mesh::LoadResult ae3d::Mesh::Load( const FileSystem::FileView& meshData )
+{
+    return Load( meshData.GetData(), meshData.GetSize(), meshData.GetPath().c_str(), meshData.IsLoaded() );
+}
+
+ae3d::Mesh::LoadResult ae3d::Mesh::Load( const unsigned char* data, std::size_t size, const char* path, bool isLoaded )
+{
+    std::shared_ptr< MeshAsset > cachedAsset = FindCachedAsset( path );
+
+    if (cachedAsset)
+    {
+        m().asset = cachedAsset;
+        AddUniqueInstance( this );
+
+        return LoadResult::Success;
+    }
+
+    if (!isLoaded)
+    {
+        m().asset = GetDefaultAsset();
+        return LoadResult::FileNotFound;
+    }
+
+    std::shared_ptr< MeshAsset > asset;
+
+    // Not using make_shared because it would keep the asset's memory allocated until the cache entry is removed.
+    try { asset.reset( new MeshAsset() ); }
+    catch (std::bad_alloc&)
+    {
+        return LoadResult::OutOfMemory;
+    }
+
+    const LoadResult result = IsVersion2( data, size ) ?
+        LoadVersion2( data, size, path, true, asset->aabbMin, asset->aabbMax, asset->subMeshes ) :
+        LoadVersion1( data, size, path, true, asset->aabbMin, asset->aabbMax, asset->subMeshes );
+
+    if (result != LoadResult::Success)
+    {
+        return result;
+    }
+
+    m().asset = AddToCache( asset, path );
+    AddUniqueInstance( this );
+    
+    return LoadResult::Success;
+}
+
+ae3d::AsyncLoader::Handle ae3d::Mesh::LoadAsync( const char* path )
+{
+    std::string meshPath = path != nullptr ? path : "";
+    std::replace( std::begin( meshPath ), std::end( meshPath ), '\\', '/' );
+    std::shared_ptr< MeshAsset > cachedAsset = FindCachedAsset( meshPath );
+
+    if (cachedAsset)
+    {
+        m().asset = cachedAsset;
+        AddUniqueInstance( this );
+        return AsyncLoader::Queue( nullptr, nullptr );
+    }
+
+    if (!m().asset)
+    {
+        m().asset = GetDefaultAsset();
+    }
+
+    // Written by the worker and read by finish after it.
+    struct Job
+    {
+        std::shared_ptr< MeshAsset > asset;
+        std::string path;
+    };
+
+    std::shared_ptr< Job > job = std::make_shared< Job >();
+    Mesh* mesh = this;
+
+    auto load = [job, meshPath]()
+    {
+        const FileSystem::FileView meshData = FileSystem::OpenFileView( meshPath.c_str() );
+        job->path = meshData.GetPath();
+
+        if (!meshData.IsLoaded())
+        {
+            return false;
+        }
+
+        try { job->asset.reset( new MeshAsset() ); }
+        catch (std::bad_alloc&)
+        {
+            return false;
+        }
+
+        const LoadResult result = IsVersion2( meshData.GetData(), meshData.GetSize() ) ?
+            LoadVersion2( meshData.GetData(), meshData.GetSize(), meshData.GetPath(), false, job->asset->aabbMin, job->asset->aabbMax, job->asset->subMeshes ) :
+            LoadVersion1( meshData.GetData(), meshData.GetSize(), meshData.GetPath(), false, job->asset->aabbMin, job->asset->aabbMax, job->asset->subMeshes );
+
+        return result == LoadResult::Success;
+    };
+
+    auto finish = [job, mesh]( bool loaded )
+    {
+        if (!loaded)
+        {
+            System::Print( "Could not load mesh %s\n", job->path.c_str() );
+            return false;
+        }
+
+        // Another load of the same path may have finished first.
+        std::shared_ptr< MeshAsset > asset = FindCachedAsset( job->path );
+
+        if (!asset)
+        {
+            asset = job->asset;
+
+            for (auto& subMesh : asset->subMeshes)
+            {
+                UploadSubMesh( subMesh, job->path );
+            }
+
+            asset = AddToCache( asset, job->path );
+        }
+
+        mesh->m().asset = asset;
+        AddUniqueInstance( mesh );
+        return true;
+    };
+
+    return AsyncLoader::Queue( load, finish );
 }
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "Vec3.hpp"
+
+namespace ae3d
+{
+    class Frustum;
+    struct Matrix44;
+
+    /// Triangle cluster of a submesh. The cluster's faces are contiguous in the submesh's index buffer.
+    /// Layout matches the CLUS chunk in .ae3d files.
+    struct MeshCluster
+    {
+        /// Bounding sphere center in mesh-local space.
+        Vec3 center;
+        /// Bounding sphere radius.
+        float radius;
+        /// Average face normal.
+        Vec3 coneAxis;
+        /// Cosine of the angle between coneAxis and the face normal furthest from it. <= 0 disables backface culling.
+        float coneCutoff;
+        unsigned firstFace;
+        unsigned faceCount;
+    };
+
+    static_assert( sizeof( MeshCluster ) == 40, "ae3d cluster size changed" );
+}
+
+namespace MathUtil
+{
+    /// Culls clusters against a frustum and, if a camera position is given, against their normal cones.
+    /// Adjacent visible clusters are merged.
+    /// \param clusters Clusters, ordered by firstFace.
+    /// \param clusterCount Cluster count.
+    /// \param frustum Frustum in world space.
+    /// \param localToWorld Local-to-World matrix.
+    /// \param localCameraPosition Camera position in mesh-local space or null to skip backface culling.
+    /// \param outFaceRanges Visible [startFace, endFace) pairs are appended to this.
+    void CullClusters( const ae3d::MeshCluster* clusters, unsigned clusterCount, const ae3d::Frustum& frustum, const ae3d::Matrix44& localToWorld,
+                       const ae3d::Vec3* localCameraPosition, std::vector< unsigned >& outFaceRanges );
+
+    /// \param cluster Cluster.
+    /// \param localCameraPosition Camera position in mesh-local space.
+    /// \return True, if every face of the cluster is back-facing when seen from localCameraPosition.
+    bool IsClusterBackFacing( const ae3d::MeshCluster& cluster, const ae3d::Vec3& localCameraPosition );
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+namespace ae3d
+{
+    /// Detail level of a submesh. Levels share the submesh's vertex buffer and their faces are stored
+    /// one after another in its index buffer. Layout matches the LODS chunk in .ae3d files.
+    struct MeshLod
+    {
+        unsigned firstFace;
+        unsigned faceCount;
+        /// Largest distance the simplified surface moved, in mesh-local units. 0 for the original mesh.
+        float error;
+    };
+
+    static_assert( sizeof( MeshLod ) == 12, "ae3d LOD size changed" );
+}
+
+namespace MathUtil
+{
+    /// Selects the coarsest LOD whose error is at most maxError on screen. A LOD stays selected
+    /// until its error grows past maxError by a margin, and a coarser LOD is selected only when its
+    /// error is below maxError by a margin, so objects near a threshold don't switch every frame.
+    /// \param lodErrors Errors in mesh-local units, increasing.
+    /// \param lodCount LOD count.
+    /// \param errorScale Converts a LOD error into screen units, e.g. pixels.
+    /// \param currentLod Currently selected LOD or -1 if none.
+    /// \param maxError Largest acceptable error in screen units.
+    /// \return Selected LOD.
+    int SelectLod( const float* lodErrors, int lodCount, float errorScale, int currentLod, float maxError );
+}
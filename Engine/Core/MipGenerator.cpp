@@ -0,0 +1,503 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "MipGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if !SIMD_SSE3 && (defined( __ARM_NEON ) || defined( __ARM_NEON__ ))
+#define SIMD_NEON 1
+#endif
+
+#if SIMD_SSE3
+#include <xmmintrin.h>
+#elif SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace ae3d;
+
+// Filters operate on one RGBA pixel at a time, so a pixel is one SIMD register.
+#if SIMD_SSE3
+typedef __m128 Float4;
+
+static inline Float4 Load4( const float* p ) { return _mm_loadu_ps( p ); }
+static inline void Store4( float* p, Float4 v ) { _mm_storeu_ps( p, v ); }
+static inline Float4 Splat4( float f ) { return _mm_set1_ps( f ); }
+static inline Float4 Add4( Float4 a, Float4 b ) { return _mm_add_ps( a, b ); }
+static inline Float4 Mul4( Float4 a, Float4 b ) { return _mm_mul_ps( a, b ); }
+static inline Float4 MulAdd4( Float4 sum, Float4 a, Float4 b ) { return _mm_add_ps( sum, _mm_mul_ps( a, b ) ); }
+static inline Float4 Saturate4( Float4 v ) { return _mm_min_ps( _mm_max_ps( v, _mm_setzero_ps() ), _mm_set1_ps( 1 ) ); }
+#elif SIMD_NEON
+typedef float32x4_t Float4;
+
+static inline Float4 Load4( const float* p ) { return vld1q_f32( p ); }
+static inline void Store4( float* p, Float4 v ) { vst1q_f32( p, v ); }
+static inline Float4 Splat4( float f ) { return vdupq_n_f32( f ); }
+static inline Float4 Add4( Float4 a, Float4 b ) { return vaddq_f32( a, b ); }
+static inline Float4 Mul4( Float4 a, Float4 b ) { return vmulq_f32( a, b ); }
+static inline Float4 MulAdd4( Float4 sum, Float4 a, Float4 b ) { return vmlaq_f32( sum, a, b ); }
+static inline Float4 Saturate4( Float4 v ) { return vminq_f32( vmaxq_f32( v, vdupq_n_f32( 0 ) ), vdupq_n_f32( 1 ) ); }
+#else
+struct Float4
+{
+    float v[ 4 ];
+};
+
+static inline Float4 Load4( const float* p ) { return Float4 { { p[ 0 ], p[ 1 ], p[ 2 ], p[ 3 ] } }; }
+static inline void Store4( float* p, Float4 v ) { std::memcpy( p, v.v, sizeof( v.v ) ); }
+static inline Float4 Splat4( float f ) { return Float4 { { f, f, f, f } }; }
+static inline Float4 Add4( Float4 a, Float4 b ) { return Float4 { { a.v[ 0 ] + b.v[ 0 ], a.v[ 1 ] + b.v[ 1 ], a.v[ 2 ] + b.v[ 2 ], a.v[ 3 ] + b.v[ 3 ] } }; }
+static inline Float4 Mul4( Float4 a, Float4 b ) { return Float4 { { a.v[ 0 ] * b.v[ 0 ], a.v[ 1 ] * b.v[ 1 ], a.v[ 2 ] * b.v[ 2 ], a.v[ 3 ] * b.v[ 3 ] } }; }
+
+static inline Float4 MulAdd4( Float4 sum, Float4 a, Float4 b )
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        sum.v[ i ] += a.v[ i ] * b.v[ i ];
+    }
+
+    return sum;
+}
+
+static inline Float4 Saturate4( Float4 v )
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        v.v[ i ] = std::min( std::max( v.v[ i ], 0.0f ), 1.0f );
+    }
+
+    return v;
+}
+#endif
+
+namespace
+{
+    struct SRGBTables
+    {
+        float toLinear[ 256 ];
+        float unormToFloat[ 256 ];
+        /// Linear value where sRGB code i changes to i + 1.
+        float codeThresholds[ 255 ];
+        /// sRGB code of linear value i / 4096. Values up to (i + 1) / 4096 have this code or the next one.
+        unsigned char codeLowerBounds[ 4096 ];
+    };
+
+    /// Source pixel indices and weights of each destination pixel along one axis.
+    struct FilterTaps
+    {
+        std::vector< int > sourceIndices;
+        std::vector< float > weights;
+        int tapCount = 0;
+    };
+
+    /// Level that is downsampled. Level 0 is converted from RGBA8 one row at a time when rows are read, so it's never stored in float.
+    struct SourceLevel
+    {
+        const float* pixels = nullptr;
+        const unsigned char* pixels8 = nullptr;
+        const float* colorToFloat = nullptr;
+        const float* alphaToFloat = nullptr;
+        int width = 0;
+        int height = 0;
+        std::vector< float > rows[ 2 ];
+    };
+}
+
+static float SRGBToLinear( float c )
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow( (c + 0.055f) / 1.055f, 2.4f );
+}
+
+static SRGBTables CreateSRGBTables()
+{
+    SRGBTables tables;
+
+    for (int i = 0; i < 256; ++i)
+    {
+        tables.toLinear[ i ] = SRGBToLinear( i / 255.0f );
+        tables.unormToFloat[ i ] = i / 255.0f;
+    }
+
+    for (int i = 0; i < 255; ++i)
+    {
+        tables.codeThresholds[ i ] = SRGBToLinear( (i + 0.5f) / 255.0f );
+    }
+
+    int code = 0;
+
+    for (int i = 0; i < 4096; ++i)
+    {
+        while (code < 255 && i / 4096.0f >= tables.codeThresholds[ code ])
+        {
+            ++code;
+        }
+
+        tables.codeLowerBounds[ i ] = static_cast< unsigned char >( code );
+    }
+
+    return tables;
+}
+
+static const SRGBTables& GetSRGBTables()
+{
+    // Function-local statics are initialized only once even if worker threads call this at the same time.
+    static const SRGBTables tables = CreateSRGBTables();
+    return tables;
+}
+
+// Exact: the table gives a code that is at most one less than the correct one.
+static unsigned char LinearToSRGB8( float linear, const SRGBTables& tables )
+{
+    int code = tables.codeLowerBounds[ std::min( static_cast< int >( linear * 4096 ), 4095 ) ];
+
+    while (code < 255 && linear >= tables.codeThresholds[ code ])
+    {
+        ++code;
+    }
+
+    return static_cast< unsigned char >( code );
+}
+
+static float Sinc( float x )
+{
+    if (std::fabs( x ) < 0.0001f)
+    {
+        return 1;
+    }
+
+    x *= 3.14159265f;
+    return std::sin( x ) / x;
+}
+
+// Modified Bessel function of the first kind, order 0.
+static float BesselI0( float x )
+{
+    float sum = 1;
+    float term = 1;
+
+    for (int k = 1; k < 50 && term > sum * 1e-7f; ++k)
+    {
+        const float halfXOverK = x / (2.0f * k);
+        term *= halfXOverK * halfXOverK;
+        sum += term;
+    }
+
+    return sum;
+}
+
+static float Kaiser( float x, float width )
+{
+    const float alpha = 4;
+    const float t = x / width;
+
+    return t * t < 1 ? BesselI0( alpha * std::sqrt( 1 - t * t ) ) / BesselI0( alpha ) : 0;
+}
+
+static int ResolveIndex( int index, int size, bool isWrapped )
+{
+    if (isWrapped)
+    {
+        index %= size;
+        return index < 0 ? index + size : index;
+    }
+
+    return std::min( std::max( index, 0 ), size - 1 );
+}
+
+// A destination pixel covers sourceSize / destinationSize source pixels, which is more than 2 when sourceSize is odd.
+// Box weights are the covered areas of source pixels. Kaiser radius is 3 destination pixels.
+static void ComputeTaps( int sourceSize, int destinationSize, MipGenerator::Filter filter, bool isWrapped, FilterTaps& outTaps )
+{
+    const float scale = static_cast< float >( sourceSize ) / destinationSize;
+    const float kaiserWidth = 3;
+    const float radius = filter == MipGenerator::Filter::Box ? scale * 0.5f : kaiserWidth * scale;
+
+    outTaps.tapCount = 0;
+
+    for (int d = 0; d < destinationSize; ++d)
+    {
+        const float center = (d + 0.5f) * scale;
+        const int first = static_cast< int >( std::floor( center - radius ) );
+        const int last = static_cast< int >( std::ceil( center + radius ) ) - 1;
+        outTaps.tapCount = std::max( outTaps.tapCount, last - first + 1 );
+    }
+
+    outTaps.sourceIndices.resize( destinationSize * outTaps.tapCount );
+    outTaps.weights.resize( destinationSize * outTaps.tapCount );
+
+    for (int d = 0; d < destinationSize; ++d)
+    {
+        const float center = (d + 0.5f) * scale;
+        const int first = static_cast< int >( std::floor( center - radius ) );
+        int* indices = &outTaps.sourceIndices[ d * outTaps.tapCount ];
+        float* weights = &outTaps.weights[ d * outTaps.tapCount ];
+        float weightSum = 0;
+
+        for (int t = 0; t < outTaps.tapCount; ++t)
+        {
+            const int s = first + t;
+            float weight = 0;
+
+            if (filter == MipGenerator::Filter::Box)
+            {
+                weight = std::max( 0.0f, std::min( s + 1.0f, center + radius ) - std::max( static_cast< float >( s ), center - radius ) );
+            }
+            else
+            {
+                const float x = (s + 0.5f - center) / scale;
+                weight = Sinc( x ) * Kaiser( x, kaiserWidth );
+            }
+
+            indices[ t ] = ResolveIndex( s, sourceSize, isWrapped );
+            weights[ t ] = weight;
+            weightSum += weight;
+        }
+
+        for (int t = 0; t < outTaps.tapCount; ++t)
+        {
+            weights[ t ] /= weightSum;
+        }
+    }
+}
+
+// \param rowSlot Rows returned with different slots stay valid at the same time.
+static const float* GetRow( SourceLevel& source, int y, int rowSlot )
+{
+    if (source.pixels8 == nullptr)
+    {
+        return source.pixels + y * source.width * 4;
+    }
+
+    std::vector< float >& row = source.rows[ rowSlot ];
+    row.resize( source.width * 4 );
+    const unsigned char* pixels = source.pixels8 + y * source.width * 4;
+
+    for (int i = 0; i < source.width * 4; i += 4)
+    {
+        row[ i + 0 ] = source.colorToFloat[ pixels[ i + 0 ] ];
+        row[ i + 1 ] = source.colorToFloat[ pixels[ i + 1 ] ];
+        row[ i + 2 ] = source.colorToFloat[ pixels[ i + 2 ] ];
+        row[ i + 3 ] = source.alphaToFloat[ pixels[ i + 3 ] ];
+    }
+
+    return row.data();
+}
+
+// Fast path for Box when both dimensions are even.
+static void Downsample2x2( SourceLevel& source, int destinationWidth, int destinationHeight, float* destination )
+{
+    const Float4 quarter = Splat4( 0.25f );
+
+    for (int y = 0; y < destinationHeight; ++y)
+    {
+        const float* row0 = GetRow( source, y * 2, 0 );
+        const float* row1 = GetRow( source, y * 2 + 1, 1 );
+        float* destinationRow = destination + y * destinationWidth * 4;
+
+        for (int x = 0; x < destinationWidth; ++x)
+        {
+            const Float4 top = Add4( Load4( row0 + x * 8 ), Load4( row0 + x * 8 + 4 ) );
+            const Float4 bottom = Add4( Load4( row1 + x * 8 ), Load4( row1 + x * 8 + 4 ) );
+            Store4( destinationRow + x * 4, Mul4( Add4( top, bottom ), quarter ) );
+        }
+    }
+}
+
+// Separable: filters rows into scratch and then columns of scratch into destination.
+static void Downsample( SourceLevel& source, const FilterTaps& horizontalTaps, const FilterTaps& verticalTaps,
+                        int destinationWidth, int destinationHeight, std::vector< float >& scratch, float* destination )
+{
+    scratch.resize( destinationWidth * source.height * 4 );
+
+    for (int y = 0; y < source.height; ++y)
+    {
+        const float* sourceRow = GetRow( source, y, 0 );
+        float* scratchRow = scratch.data() + y * destinationWidth * 4;
+
+        for (int x = 0; x < destinationWidth; ++x)
+        {
+            const int* indices = &horizontalTaps.sourceIndices[ x * horizontalTaps.tapCount ];
+            const float* weights = &horizontalTaps.weights[ x * horizontalTaps.tapCount ];
+            Float4 sum = Splat4( 0 );
+
+            for (int t = 0; t < horizontalTaps.tapCount; ++t)
+            {
+                sum = MulAdd4( sum, Load4( sourceRow + indices[ t ] * 4 ), Splat4( weights[ t ] ) );
+            }
+
+            Store4( scratchRow + x * 4, sum );
+        }
+    }
+
+    for (int y = 0; y < destinationHeight; ++y)
+    {
+        const int* indices = &verticalTaps.sourceIndices[ y * verticalTaps.tapCount ];
+        const float* weights = &verticalTaps.weights[ y * verticalTaps.tapCount ];
+        float* destinationRow = destination + y * destinationWidth * 4;
+
+        for (int x = 0; x < destinationWidth; ++x)
+        {
+            Float4 sum = Splat4( 0 );
+
+            for (int t = 0; t < verticalTaps.tapCount; ++t)
+            {
+                sum = MulAdd4( sum, Load4( scratch.data() + (indices[ t ] * destinationWidth + x) * 4 ), Splat4( weights[ t ] ) );
+            }
+
+            // Kaiser's negative lobes can overshoot.
+            Store4( destinationRow + x * 4, Saturate4( sum ) );
+        }
+    }
+}
+
+// Scale for alpha that makes the fraction of pixels that pass the cutoff closest to targetCoverage.
+static float GetAlphaScale( const float* pixels, int pixelCount, float alphaCutoff, float targetCoverage )
+{
+    const int binCount = 1024;
+    std::vector< unsigned > histogram( binCount );
+
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        ++histogram[ std::min( static_cast< int >( pixels[ i * 4 + 3 ] * binCount ), binCount - 1 ) ];
+    }
+
+    // Adds bins from the most opaque down while that brings the count closer to the target.
+    const float targetCount = targetCoverage * pixelCount;
+    float count = 0;
+    int bin = binCount;
+
+    while (bin > 0 && count + histogram[ bin - 1 ] * 0.5f < targetCount)
+    {
+        --bin;
+        count += histogram[ bin ];
+    }
+
+    if (bin == binCount)
+    {
+        return 1;
+    }
+
+    const float threshold = std::max( static_cast< float >( bin ), 0.5f ) / binCount;
+    return alphaCutoff / threshold;
+}
+
+static void Quantize( const float* pixels, int pixelCount, bool isSRGB, float alphaScale, const SRGBTables& tables, unsigned char* outPixels )
+{
+    for (int i = 0; i < pixelCount * 4; i += 4)
+    {
+        if (isSRGB)
+        {
+            outPixels[ i + 0 ] = LinearToSRGB8( pixels[ i + 0 ], tables );
+            outPixels[ i + 1 ] = LinearToSRGB8( pixels[ i + 1 ], tables );
+            outPixels[ i + 2 ] = LinearToSRGB8( pixels[ i + 2 ], tables );
+        }
+        else
+        {
+            outPixels[ i + 0 ] = static_cast< unsigned char >( pixels[ i + 0 ] * 255 + 0.5f );
+            outPixels[ i + 1 ] = static_cast< unsigned char >( pixels[ i + 1 ] * 255 + 0.5f );
+            outPixels[ i + 2 ] = static_cast< unsigned char >( pixels[ i + 2 ] * 255 + 0.5f );
+        }
+
+        outPixels[ i + 3 ] = static_cast< unsigned char >( std::min( pixels[ i + 3 ] * alphaScale, 1.0f ) * 255 + 0.5f );
+    }
+}
+
+int MipGenerator::GetMipCount( int width, int height )
+{
+    int count = 1;
+
+    while (width > 1 || height > 1)
+    {
+        width = std::max( width / 2, 1 );
+        height = std::max( height / 2, 1 );
+        ++count;
+    }
+
+    return count;
+}
+
+std::size_t MipGenerator::GetMipOffset( int width, int height, int mipIndex )
+{
+    std::size_t offset = 0;
+
+    for (int i = 0; i < mipIndex; ++i)
+    {
+        offset += static_cast< std::size_t >( width ) * height * 4;
+        width = std::max( width / 2, 1 );
+        height = std::max( height / 2, 1 );
+    }
+
+    return offset;
+}
+
+std::size_t MipGenerator::GetMipChainSize( int width, int height )
+{
+    return GetMipOffset( width, height, GetMipCount( width, height ) );
+}
+
+void MipGenerator::Generate( const unsigned char* pixels, int width, int height, const Settings& settings, unsigned char* outMipChain )
+{
+    const int pixelCount = width * height;
+    std::memcpy( outMipChain, pixels, static_cast< std::size_t >( pixelCount ) * 4 );
+
+    const int mipCount = GetMipCount( width, height );
+
+    if (mipCount == 1)
+    {
+        return;
+    }
+
+    const SRGBTables& tables = GetSRGBTables();
+    int coveredCount = 0;
+
+    for (int i = 0; i < pixelCount && settings.alphaCutoff > 0; ++i)
+    {
+        coveredCount += tables.unormToFloat[ pixels[ i * 4 + 3 ] ] >= settings.alphaCutoff ? 1 : 0;
+    }
+
+    const float coverage = static_cast< float >( coveredCount ) / pixelCount;
+
+    // Levels are filtered from the previous level in float, so rounding errors don't accumulate.
+    SourceLevel source;
+    source.pixels8 = pixels;
+    source.colorToFloat = settings.isSRGB ? tables.toLinear : tables.unormToFloat;
+    source.alphaToFloat = tables.unormToFloat;
+    source.width = width;
+    source.height = height;
+
+    std::vector< float > level;
+    std::vector< float > nextLevel;
+    std::vector< float > scratch;
+    FilterTaps horizontalTaps;
+    FilterTaps verticalTaps;
+
+    for (int mipIndex = 1; mipIndex < mipCount; ++mipIndex)
+    {
+        const int nextWidth = std::max( source.width / 2, 1 );
+        const int nextHeight = std::max( source.height / 2, 1 );
+        nextLevel.resize( nextWidth * nextHeight * 4 );
+
+        if (settings.filter == Filter::Box && source.width % 2 == 0 && source.height % 2 == 0)
+        {
+            Downsample2x2( source, nextWidth, nextHeight, nextLevel.data() );
+        }
+        else
+        {
+            ComputeTaps( source.width, nextWidth, settings.filter, settings.isWrapped, horizontalTaps );
+            ComputeTaps( source.height, nextHeight, settings.filter, settings.isWrapped, verticalTaps );
+            Downsample( source, horizontalTaps, verticalTaps, nextWidth, nextHeight, scratch, nextLevel.data() );
+        }
+
+        // The scale is not applied to nextLevel because the following levels are filtered from it.
+        const float alphaScale = settings.alphaCutoff > 0 ? GetAlphaScale( nextLevel.data(), nextWidth * nextHeight, settings.alphaCutoff, coverage ) : 1;
+        Quantize( nextLevel.data(), nextWidth * nextHeight, settings.isSRGB, alphaScale, tables, outMipChain + GetMipOffset( width, height, mipIndex ) );
+
+        level.swap( nextLevel );
+        source.pixels = level.data();
+        source.pixels8 = nullptr;
+        source.width = nextWidth;
+        source.height = nextHeight;
+    }
+}
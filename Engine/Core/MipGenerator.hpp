@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ae3d
+{
+    /// Generates mipmap chains of RGBA8 images on the CPU. Level dimensions are max( 1, previous / 2 ) like in Vulkan, D3D12 and Metal,
+    /// and odd dimensions are filtered with 3 or more taps so non-power-of-two images don't shift. Uses SSE when SIMD_SSE3 is defined
+    /// and NEON on ARM. Doesn't use global state, so images can be processed on worker threads and in offline tools.
+    namespace MipGenerator
+    {
+        enum class Filter
+        {
+            /// Averages pixels covered by the destination pixel.
+            Box,
+            /// Kaiser-windowed sinc. Sharper than Box, slower.
+            Kaiser
+        };
+
+        struct Settings
+        {
+            Filter filter = Filter::Box;
+            /// If true, RGB is converted to linear before filtering and back to sRGB after it. Alpha is always linear.
+            bool isSRGB = false;
+            /// If true, filters sample across edges to the opposite side like TextureWrap::Repeat, otherwise edges are clamped.
+            bool isWrapped = false;
+            /// If greater than 0, alpha of each level is scaled so that the fraction of pixels whose alpha is >= alphaCutoff is the
+            /// same as in level 0. Keeps alpha-tested textures from thinning out in the distance.
+            float alphaCutoff = 0;
+        };
+
+        /// \return Number of levels including level 0 in a full mip chain of an image.
+        int GetMipCount( int width, int height );
+
+        /// \return Offset of a level in bytes in a mip chain written by Generate().
+        std::size_t GetMipOffset( int width, int height, int mipIndex );
+
+        /// \return Size of a full RGBA8 mip chain in bytes.
+        std::size_t GetMipChainSize( int width, int height );
+
+        /// Generates a full mip chain.
+        /// \param pixels RGBA8 image, rows are not padded.
+        /// \param width Width in pixels.
+        /// \param height Height in pixels.
+        /// \param settings Settings.
+        /// \param outMipChain Receives GetMipChainSize() bytes: all levels starting from a copy of pixels, each at GetMipOffset().
+        void Generate( const unsigned char* pixels, int width, int height, const Settings& settings, unsigned char* outMipChain );
+    }
+}
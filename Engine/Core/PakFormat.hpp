@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ae3d
+{
+    /// .pak file layout. Written by Tools/CombineFiles and read by FileSystem. All values are little-endian.
+    /// The table of contents is at the beginning of the file: PakHeader, bucketCount buckets, entryCount
+    /// PakEntry records and entry paths. Entry data follows, each entry starting at a multiple of dataAlignment.
+    /// Buckets form an open-addressing hash table of paths with linear probing. A bucket holds an entry index + 1, or 0 if empty.
+    /// Compressed entries are split into blocks of blockSize uncompressed bytes that are compressed independently, so they can be
+    /// decompressed in parallel or starting at any block. Their data starts with a uint64 end offset of each block, relative to the
+    /// end of the offsets, followed by blocks in LZ4 block format. A block whose stored size equals its uncompressed size is stored as is.
+    namespace Pak
+    {
+        const char Magic[ 4 ] = { 'a', 'e', 'p', 'k' };
+        const uint32_t Version = 3;
+        const uint32_t DataAlignment = 16;
+        const uint32_t BlockSize = 64 * 1024;
+
+        enum class CompressionLevel : uint32_t
+        {
+            None = 0,
+            /// Compressed with ae3d::Compression::Level::Fast. For data that is loaded often.
+            Fast = 1,
+            /// Compressed with ae3d::Compression::Level::High. For data that is loaded rarely, or only once. Decompresses as fast as Fast.
+            High = 2
+        };
+
+        struct Header
+        {
+            char magic[ 4 ];
+            uint32_t version;
+            uint32_t entryCount;
+            /// Power of two, or 0 if there are no entries.
+            uint32_t bucketCount;
+            uint32_t dataAlignment;
+            /// Offset of entry paths from the beginning of the file. Paths are not null-terminated.
+            uint32_t pathsOffset;
+            uint32_t pathsSize;
+            /// Uncompressed size of a compressed entry's blocks. Last block can be smaller.
+            uint32_t blockSize;
+        };
+
+        struct Entry
+        {
+            uint64_t pathHash;
+            /// Offset of data from the beginning of the file.
+            uint64_t offset;
+            /// Uncompressed size.
+            uint64_t size;
+            /// Size of data in the file. Same as size if the entry is not compressed.
+            uint64_t storedSize;
+            /// Offset of path from Header::pathsOffset.
+            uint32_t pathOffset;
+            uint32_t pathLength;
+            CompressionLevel compression;
+            uint32_t reserved;
+        };
+
+        static_assert( sizeof( Header ) == 32, "pak header size changed" );
+        static_assert( sizeof( Entry ) == 48, "pak entry size changed" );
+
+        /// \return FNV-1a hash of path.
+        inline uint64_t HashPath( const char* path, std::size_t length )
+        {
+            uint64_t hash = 14695981039346656037ull;
+
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                hash ^= static_cast< unsigned char >( path[ i ] );
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        /// \return Number of blocks in a compressed entry.
+        inline uint64_t GetBlockCount( uint64_t size, uint32_t blockSize )
+        {
+            return (size + blockSize - 1) / blockSize;
+        }
+
+        /// \return Bucket count that keeps the table at most half full.
+        inline uint32_t GetBucketCount( uint32_t entryCount )
+        {
+            uint32_t bucketCount = entryCount > 0 ? 1 : 0;
+
+            while (bucketCount < entryCount * 2)
+            {
+                bucketCount *= 2;
+            }
+
+            return bucketCount;
+        }
+    }
+}
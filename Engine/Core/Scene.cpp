@@ -2,10 +2,12 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "Scene.hpp"
 #include <algorithm>
+#include <chrono>
 #include <locale>
 #include <string>
 #include <sstream>
 #include <vector>
+#include "AsyncLoader.hpp"
 #include "AudioSourceComponent.hpp"
 #include "AudioSystem.hpp"
 #include "CameraComponent.hpp"
@@ -33,6 +35,9 @@
 using namespace ae3d;
 extern Renderer renderer;
 float GetVRFov();
+#if defined( AE3D_OPENVR )
+Vec3 GetVREyePosition( int eye );
+#endif
 void BeginOffscreen();
 void EndOffscreen();
 std::string GetSerialized( ae3d::TextRendererComponent* component );
@@ -166,8 +171,61 @@ void SetupCameraForDirectionalShadowCasting( const Vec3& lightDirection, const F
     outCamera.SetProjection( viewMinLS.x, viewMaxLS.x, viewMinLS.y, viewMaxLS.y, -viewMaxLS.z, -viewMinLS.z );
 }
 
+static void GetCameraFrustum( GameObject* cameraGo, Frustum& outFrustum )
+{
+    CameraComponent* camera = cameraGo->GetComponent< CameraComponent >();
+    TransformComponent* cameraTransform = cameraGo->GetComponent< TransformComponent >();
+
+#if defined( AE3D_OPENVR )
+    // Both eyes share one visibility result, so the frustum must enclose both of them.
+    const Matrix44& view = cameraTransform->GetVrView();
+    const Vec3 viewDir = Vec3( view.m[ 2 ], view.m[ 6 ], view.m[ 10 ] ).Normalized();
+    Frustum eyeFrustums[ 2 ];
+
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        eyeFrustums[ eye ].SetProjection( GetVRFov(), camera->GetAspect(), camera->GetNear(), camera->GetFar() );
+        eyeFrustums[ eye ].Update( GetVREyePosition( eye ), viewDir );
+    }
+
+    outFrustum.SetCombined( eyeFrustums[ 0 ], eyeFrustums[ 1 ] );
+#else
+    if (camera->GetProjectionType() == CameraComponent::ProjectionType::Perspective)
+    {
+        outFrustum.SetProjection( camera->GetFovDegrees(), camera->GetAspect(), camera->GetNear(), camera->GetFar() );
+    }
+    else
+    {
+        outFrustum.SetProjection( camera->GetLeft(), camera->GetRight(), camera->GetBottom(), camera->GetTop(), camera->GetNear(), camera->GetFar() );
+    }
+
+    Matrix44 view;
+    cameraTransform->GetWorldRotation().GetMatrix( view );
+    const Vec3 viewDir = Vec3( view.m[ 2 ], view.m[ 6 ], view.m[ 10 ] ).Normalized();
+    outFrustum.Update( cameraTransform->GetWorldPosition(), viewDir );
+#endif
+}
+
+ae3d::Scene::~Scene()
+{
+    // Game objects remove themselves when they're destroyed, so the ones still here are alive.
+    for (auto gameObject : gameObjects)
+    {
+        if (gameObject != nullptr)
+        {
+            auto& scenes = gameObject->scenes;
+            scenes.erase( std::remove( std::begin( scenes ), std::end( scenes ), this ), std::end( scenes ) );
+        }
+    }
+}
+
 void ae3d::Scene::Add( GameObject* gameObject )
 {
+    if (gameObject == nullptr)
+    {
+        return;
+    }
+
     for (const auto& go : gameObjects)
     {
         if (go == gameObject)
@@ -182,51 +240,121 @@ void ae3d::Scene::Add( GameObject* gameObject )
     }
 
     gameObjects[ nextFreeGameObject++ ] = gameObject;
+
+    // Every scene keeps its own layer lists, so a game object can be in many scenes.
+    gameObject->scenes.push_back( this );
+
+    if (gameObject->isEnabled)
+    {
+        AddToLayers( gameObject, gameObject->layer );
+    }
 }
 
 void ae3d::Scene::Remove( GameObject* gameObject )
 {
     for (std::size_t i = 0; i < gameObjects.size(); ++i)
     {
-        if (gameObject == gameObjects[ i ])
+        if (gameObject != nullptr && gameObject == gameObjects[ i ])
         {
             gameObjects.erase( std::begin( gameObjects ) + i );
+
+            if (gameObject->isEnabled)
+            {
+                RemoveFromLayers( gameObject, gameObject->layer );
+            }
+
+            auto& scenes = gameObject->scenes;
+            scenes.erase( std::remove( std::begin( scenes ), std::end( scenes ), this ), std::end( scenes ) );
             return;
         }
     }
 }
 
-void ae3d::Scene::RenderDepthAndNormalsForAllCameras( std::vector< GameObject* >& cameras )
+void ae3d::Scene::AddToLayers( GameObject* gameObject, unsigned layer )
 {
-    Statistics::BeginDepthNormalsProfiling();
+    for (unsigned layerIndex = 0; layerIndex < LayerCount; ++layerIndex)
+    {
+        if ((layer & (1u << layerIndex)) != 0)
+        {
+            LayerList& layerList = layerLists[ layerIndex ];
+            layerList.slots[ gameObject ] = layerList.gameObjects.size();
+            layerList.gameObjects.push_back( gameObject );
+        }
+    }
+}
 
-    for (auto camera : cameras)
+void ae3d::Scene::RemoveFromLayers( GameObject* gameObject, unsigned layer )
+{
+    for (unsigned layerIndex = 0; layerIndex < LayerCount; ++layerIndex)
     {
-        CameraComponent* cameraComponent = camera->GetComponent< CameraComponent >();
+        if ((layer & (1u << layerIndex)) == 0)
+        {
+            continue;
+        }
 
-        if (cameraComponent->GetDepthNormalsTexture().GetID() != 0)
+        LayerList& layerList = layerLists[ layerIndex ];
+        const auto slot = layerList.slots.find( gameObject );
+
+        if (slot == std::end( layerList.slots ))
         {
-            std::vector< unsigned > gameObjectsWithMeshRenderer;
-            gameObjectsWithMeshRenderer.reserve( gameObjects.size() );
-            int i = -1;
+            continue;
+        }
 
-            for (auto gameObject : gameObjects)
-            {
-                ++i;
+        layerList.gameObjects[ slot->second ] = nullptr;
+        layerList.slots.erase( slot );
+        ++layerList.removedCount;
 
-                if (gameObject == nullptr || (gameObject->GetLayer() & cameraComponent->GetLayerMask()) == 0 || !gameObject->IsEnabled())
-                {
-                    continue;
-                }
+        if (layerList.removedCount <= layerList.gameObjects.size() / 2)
+        {
+            continue;
+        }
 
-                auto meshRenderer = gameObject->GetComponent< MeshRendererComponent >();
+        // Compacting keeps the add order because sprites and text are drawn in it.
+        auto& layerGameObjects = layerList.gameObjects;
+        layerGameObjects.erase( std::remove( std::begin( layerGameObjects ), std::end( layerGameObjects ), nullptr ), std::end( layerGameObjects ) );
+        layerList.removedCount = 0;
 
-                if (meshRenderer)
-                {
-                    gameObjectsWithMeshRenderer.push_back( i );
-                }
+        for (std::size_t i = 0; i < layerGameObjects.size(); ++i)
+        {
+            layerList.slots[ layerGameObjects[ i ] ] = i;
+        }
+    }
+}
+
+void ae3d::Scene::GetGameObjectsInLayers( unsigned layerMask, std::vector< GameObject* >& outGameObjects ) const
+{
+    outGameObjects.clear();
+
+    for (unsigned layerIndex = 0; layerIndex < LayerCount; ++layerIndex)
+    {
+        const unsigned layerBit = 1u << layerIndex;
+
+        if ((layerMask & layerBit) == 0)
+        {
+            continue;
+        }
+
+        for (auto gameObject : layerLists[ layerIndex ].gameObjects)
+        {
+            // Objects in many layers are returned only from the lowest layer in the mask.
+            if (gameObject != nullptr && (gameObject->GetLayer() & layerMask & (layerBit - 1)) == 0)
+            {
+                outGameObjects.push_back( gameObject );
             }
+        }
+    }
+}
 
+void ae3d::Scene::RenderDepthAndNormalsForAllCameras( std::vector< GameObject* >& cameras )
+{
+    Statistics::BeginDepthNormalsProfiling();
+
+    for (auto camera : cameras)
+    {
+        CameraComponent* cameraComponent = camera->GetComponent< CameraComponent >();
+
+        if (cameraComponent->GetDepthNormalsTexture().GetID() != 0)
+        {
             Frustum frustum;
 
             if (cameraComponent->GetProjectionType() == CameraComponent::ProjectionType::Perspective)
@@ -246,14 +374,24 @@ void ae3d::Scene::RenderDepthAndNormalsForAllCameras( std::vector< GameObject* >
             const Vec3 viewDir = Vec3( view.m[ 2 ], view.m[ 6 ], view.m[ 10 ] ).Normalized();
             frustum.Update( position, viewDir );
 
-            RenderDepthAndNormals( cameraComponent, view, gameObjectsWithMeshRenderer, 0, frustum );
+            std::vector< GameObject* > culledMeshRenderers;
+            const std::vector< GameObject* >* visibleMeshRenderers = GetVisibleMeshRenderers( camera );
+
+            if (visibleMeshRenderers == nullptr)
+            {
+                CollectVisibleMeshRenderers( cameraComponent, frustum, culledMeshRenderers );
+                visibleMeshRenderers = &culledMeshRenderers;
+            }
+
+            RenderDepthAndNormals( cameraComponent, view, *visibleMeshRenderers, 0, frustum );
 
             int goWithPointLightIndex = 0;
             int goWithSpotLightIndex = 0;
-            
-            for (auto gameObject : gameObjects)
+            GetGameObjectsInLayers( cameraComponent->GetLayerMask(), layerGameObjectsScratch );
+
+            for (auto gameObject : layerGameObjectsScratch)
             {
-                if (gameObject == nullptr || (gameObject->GetLayer() & cameraComponent->GetLayerMask()) == 0 || !gameObject->IsEnabled())
+                if (!gameObject->IsEnabled())
                 {
                     continue;
                 }
@@ -510,7 +648,15 @@ void ae3d::Scene::Render()
 
     BubbleSort( cameras.data(), (int)cameras.size() );
     BubbleSort( rtCameras.data(), (int)rtCameras.size() );
-    
+
+#if defined( AE3D_OPENVR )
+    // Right eye reuses the visibility that was resolved for both eyes when rendering the left eye.
+    if (VRGlobal::eye == 0)
+#endif
+    {
+        CullViews( rtCameras, cameras );
+    }
+
     if (someLightCastsShadow)
     {
         RenderShadowMaps( rtCameras );
@@ -655,19 +801,15 @@ void ae3d::Scene::RenderWithCamera( GameObject* cameraGo, int cubeMapFace, const
     const Vec3 viewDir = Vec3( view.m[2], view.m[6], view.m[10] ).Normalized();
     frustum.Update( position, viewDir );
 
-    std::vector< unsigned > gameObjectsWithMeshRenderer;
-    gameObjectsWithMeshRenderer.reserve( gameObjects.size() );
-    int gameObjectIndex = -1;
-    
     GfxDeviceGlobal::perObjectUboStruct.lightColor = Vec4( 0, 0, 0, 1 );
     GfxDeviceGlobal::perObjectUboStruct.minAmbient = ambientColor.x;
     GfxDeviceGlobal::perObjectUboStruct.lightType = PerObjectUboStruct::LightType::Empty;
-    
-    for (auto gameObject : gameObjects)
+
+    GetGameObjectsInLayers( camera->GetLayerMask(), layerGameObjectsScratch );
+
+    for (auto gameObject : layerGameObjectsScratch)
     {
-        ++gameObjectIndex;
-        
-        if (gameObject == nullptr || (gameObject->GetLayer() & camera->GetLayerMask()) == 0 || !gameObject->IsEnabled())
+        if (!gameObject->IsEnabled())
         {
             continue;
         }
@@ -712,26 +854,20 @@ void ae3d::Scene::RenderWithCamera( GameObject* cameraGo, int cubeMapFace, const
             Matrix44::Multiply( transform ? transform->GetLocalToWorldMatrix() : Matrix44::identity, camera->GetProjection(), localToClip );
             textRenderer->Render( localToClip.m );
         }
-        
-        auto meshRenderer = gameObject->GetComponent< MeshRendererComponent >();
-
-        if (meshRenderer)
-        {
-            gameObjectsWithMeshRenderer.push_back( gameObjectIndex );
-        }
     }
 
-    auto meshSorterByMesh = [&](unsigned j, unsigned k)
+    std::vector< GameObject* > culledMeshRenderers;
+    const std::vector< GameObject* >* visibleMeshRenderers = GetVisibleMeshRenderers( cameraGo );
+
+    if (visibleMeshRenderers == nullptr)
     {
-        return gameObjects[ j ]->GetComponent< MeshRendererComponent >()->GetMesh() <
-               gameObjects[ k ]->GetComponent< MeshRendererComponent >()->GetMesh();
-    };
+        CollectVisibleMeshRenderers( camera, frustum, culledMeshRenderers );
+        visibleMeshRenderers = &culledMeshRenderers;
+    }
 
-    std::sort( std::begin( gameObjectsWithMeshRenderer ), std::end( gameObjectsWithMeshRenderer ), meshSorterByMesh );
-    
-    for (auto j : gameObjectsWithMeshRenderer)
+    for (auto gameObject : *visibleMeshRenderers)
     {
-        auto transform = gameObjects[ j ]->GetComponent< TransformComponent >();
+        auto transform = gameObject->GetComponent< TransformComponent >();
         auto meshLocalToWorld = transform ? transform->GetLocalToWorldMatrix() : Matrix44::identity;
 
         Matrix44 localToView;
@@ -739,14 +875,15 @@ void ae3d::Scene::RenderWithCamera( GameObject* cameraGo, int cubeMapFace, const
         Matrix44::Multiply( meshLocalToWorld, view, localToView );
         Matrix44::Multiply( localToView, camera->GetProjection(), localToClip );
 
-        auto* meshRenderer = gameObjects[ j ]->GetComponent< MeshRendererComponent >();
-        meshRenderer->Cull( frustum, meshLocalToWorld );
+        auto* meshRenderer = gameObject->GetComponent< MeshRendererComponent >();
+        meshRenderer->SelectLod( *camera, position, meshLocalToWorld, camera->GetViewport()[ 3 ], false );
+        meshRenderer->CullSubMeshes( frustum, meshLocalToWorld, camera->GetProjectionType() == CameraComponent::ProjectionType::Perspective ? &position : nullptr );
         meshRenderer->Render( localToView, localToClip, meshLocalToWorld, SceneGlobal::shadowCameraViewMatrix, SceneGlobal::shadowCameraProjectionMatrix, nullptr, nullptr, MeshRendererComponent::RenderType::Opaque );
     }
 
-    for (auto j : gameObjectsWithMeshRenderer)
+    for (auto gameObject : *visibleMeshRenderers)
     {
-        auto transform = gameObjects[ j ]->GetComponent< TransformComponent >();
+        auto transform = gameObject->GetComponent< TransformComponent >();
         auto meshLocalToWorld = transform ? transform->GetLocalToWorldMatrix() : Matrix44::identity;
         
         Matrix44 localToView;
@@ -754,7 +891,7 @@ void ae3d::Scene::RenderWithCamera( GameObject* cameraGo, int cubeMapFace, const
         Matrix44::Multiply( meshLocalToWorld, view, localToView );
         Matrix44::Multiply( localToView, camera->GetProjection(), localToClip );
         
-        gameObjects[ j ]->GetComponent< MeshRendererComponent >()->Render( localToView, localToClip, meshLocalToWorld, SceneGlobal::shadowCameraViewMatrix, SceneGlobal::shadowCameraProjectionMatrix, nullptr, nullptr, MeshRendererComponent::RenderType::Transparent );
+        gameObject->GetComponent< MeshRendererComponent >()->Render( localToView, localToClip, meshLocalToWorld, SceneGlobal::shadowCameraViewMatrix, SceneGlobal::shadowCameraProjectionMatrix, nullptr, nullptr, MeshRendererComponent::RenderType::Transparent );
     }
 
     GfxDevice::PopGroupMarker();
@@ -772,7 +909,7 @@ void ae3d::Scene::RenderWithCamera( GameObject* cameraGo, int cubeMapFace, const
 #endif
 }
 
-void ae3d::Scene::RenderDepthAndNormals( CameraComponent* camera, const Matrix44& worldToView, std::vector< unsigned > gameObjectsWithMeshRenderer,
+void ae3d::Scene::RenderDepthAndNormals( CameraComponent* camera, const Matrix44& worldToView, const std::vector< GameObject* >& gameObjectsWithMeshRenderer,
                                          int cubeMapFace, const Frustum& frustum )
 {
 #if RENDERER_METAL
@@ -790,9 +927,13 @@ void ae3d::Scene::RenderDepthAndNormals( CameraComponent* camera, const Matrix44
 #endif
     GfxDevice::PushGroupMarker( "DepthNormal" );
 
-    for (auto j : gameObjectsWithMeshRenderer)
+    Matrix44 viewToWorld;
+    Matrix44::Invert( worldToView, viewToWorld );
+    const Vec3 cameraPosition( viewToWorld.m[ 12 ], viewToWorld.m[ 13 ], viewToWorld.m[ 14 ] );
+
+    for (auto gameObject : gameObjectsWithMeshRenderer)
     {
-        auto transform = gameObjects[ j ]->GetComponent< TransformComponent >();
+        auto transform = gameObject->GetComponent< TransformComponent >();
         auto meshLocalToWorld = transform ? transform->GetLocalToWorldMatrix() : Matrix44::identity;
         
         Matrix44 localToView;
@@ -800,9 +941,11 @@ void ae3d::Scene::RenderDepthAndNormals( CameraComponent* camera, const Matrix44
         Matrix44::Multiply( meshLocalToWorld, worldToView, localToView );
         Matrix44::Multiply( localToView, camera->GetProjection(), localToClip );
         
-        auto meshRenderer = gameObjects[ j ]->GetComponent< MeshRendererComponent >();
+        auto meshRenderer = gameObject->GetComponent< MeshRendererComponent >();
 
-        meshRenderer->Cull( frustum, meshLocalToWorld );
+        meshRenderer->SelectLod( *camera, cameraPosition, meshLocalToWorld, camera->GetViewport()[ 3 ], false );
+        // The depth pass camera position is not in world space yet, so clusters are only frustum culled.
+        meshRenderer->CullSubMeshes( frustum, meshLocalToWorld, nullptr );
         meshRenderer->Render( localToView, localToClip, meshLocalToWorld, SceneGlobal::shadowCameraViewMatrix, SceneGlobal::shadowCameraProjectionMatrix, &renderer.builtinShaders.depthNormalsShader, &renderer.builtinShaders.depthNormalsShader, MeshRendererComponent::RenderType::Opaque );
         meshRenderer->Render( localToView, localToClip, meshLocalToWorld, SceneGlobal::shadowCameraViewMatrix, SceneGlobal::shadowCameraProjectionMatrix, &renderer.builtinShaders.depthNormalsShader,
                              &renderer.builtinShaders.depthNormalsShader, MeshRendererComponent::RenderType::Transparent );
@@ -913,6 +1056,7 @@ void ae3d::Scene::RenderShadowsWithCamera( GameObject* cameraGo, int cubeMapFace
 
         auto* meshRenderer = gameObjects[ j ]->GetComponent< MeshRendererComponent >();
         
+        meshRenderer->SelectLod( *camera, cameraTransform->GetWorldPosition(), meshLocalToWorld, viewport[ 3 ], true );
         meshRenderer->Cull( frustum, meshLocalToWorld );
         meshRenderer->Render( localToView, localToClip, meshLocalToWorld, SceneGlobal::shadowCameraViewMatrix, SceneGlobal::shadowCameraProjectionMatrix, &renderer.builtinShaders.momentsShader,
                              &renderer.builtinShaders.momentsSkinShader, MeshRendererComponent::RenderType::Opaque );
@@ -928,6 +1072,152 @@ void ae3d::Scene::RenderShadowsWithCamera( GameObject* cameraGo, int cubeMapFace
 #endif
 }
 
+void ae3d::Scene::CullViews( const std::vector< GameObject* >& rtCameras, const std::vector< GameObject* >& cameras )
+{
+    // Cube map cameras move between faces while rendering, so they are culled per face.
+    cullViewCameras.clear();
+
+    for (auto rtCamera : rtCameras)
+    {
+        if (cullViewCameras.size() < MaxCullViews && !rtCamera->GetComponent< CameraComponent >()->GetTargetTexture()->IsCube())
+        {
+            cullViewCameras.push_back( rtCamera );
+        }
+    }
+
+    for (auto camera : cameras)
+    {
+        if (cullViewCameras.size() < MaxCullViews)
+        {
+            cullViewCameras.push_back( camera );
+        }
+    }
+
+    const unsigned viewCount = (unsigned)cullViewCameras.size();
+    Frustum frustums[ MaxCullViews ];
+    unsigned layerMasks[ MaxCullViews ];
+    unsigned allViewsLayerMask = 0;
+
+    cullViewMeshRenderers.resize( viewCount );
+
+    for (unsigned viewIndex = 0; viewIndex < viewCount; ++viewIndex)
+    {
+        GetCameraFrustum( cullViewCameras[ viewIndex ], frustums[ viewIndex ] );
+        layerMasks[ viewIndex ] = cullViewCameras[ viewIndex ]->GetComponent< CameraComponent >()->GetLayerMask();
+        allViewsLayerMask |= layerMasks[ viewIndex ];
+        cullViewMeshRenderers[ viewIndex ].clear();
+    }
+
+    GetGameObjectsInLayers( allViewsLayerMask, layerGameObjectsScratch );
+
+    // Every object's bounds are transformed once and tested against all views.
+    for (auto gameObject : layerGameObjectsScratch)
+    {
+        if (!gameObject->IsEnabled())
+        {
+            continue;
+        }
+
+        auto meshRenderer = gameObject->GetComponent< MeshRendererComponent >();
+
+        if (meshRenderer == nullptr || meshRenderer->GetMesh() == nullptr)
+        {
+            continue;
+        }
+
+        unsigned testMask = 0;
+
+        for (unsigned viewIndex = 0; viewIndex < viewCount; ++viewIndex)
+        {
+            if ((gameObject->GetLayer() & layerMasks[ viewIndex ]) != 0)
+            {
+                testMask |= 1u << viewIndex;
+            }
+        }
+
+        if (testMask == 0)
+        {
+            continue;
+        }
+
+        auto transform = gameObject->GetComponent< TransformComponent >();
+        Vec3 aabbMinWorld, aabbMaxWorld;
+        meshRenderer->GetWorldAABB( transform ? transform->GetLocalToWorldMatrix() : Matrix44::identity, aabbMinWorld, aabbMaxWorld );
+
+        const unsigned visibilityMask = Frustum::BoxInFrustums( frustums, viewCount, testMask, aabbMinWorld, aabbMaxWorld );
+
+        for (unsigned viewIndex = 0; viewIndex < viewCount; ++viewIndex)
+        {
+            if ((visibilityMask & (1u << viewIndex)) != 0)
+            {
+                cullViewMeshRenderers[ viewIndex ].push_back( gameObject );
+            }
+        }
+    }
+
+    auto meshSorterByMesh = [](const GameObject* j, const GameObject* k)
+    {
+        return j->GetComponent< MeshRendererComponent >()->GetMesh() <
+               k->GetComponent< MeshRendererComponent >()->GetMesh();
+    };
+
+    for (auto& visibleMeshRenderers : cullViewMeshRenderers)
+    {
+        std::sort( std::begin( visibleMeshRenderers ), std::end( visibleMeshRenderers ), meshSorterByMesh );
+    }
+}
+
+const std::vector< GameObject* >* ae3d::Scene::GetVisibleMeshRenderers( const GameObject* cameraGo ) const
+{
+    for (std::size_t viewIndex = 0; viewIndex < cullViewCameras.size(); ++viewIndex)
+    {
+        if (cullViewCameras[ viewIndex ] == cameraGo)
+        {
+            return &cullViewMeshRenderers[ viewIndex ];
+        }
+    }
+
+    return nullptr;
+}
+
+void ae3d::Scene::CollectVisibleMeshRenderers( CameraComponent* camera, const Frustum& frustum, std::vector< GameObject* >& outGameObjects ) const
+{
+    GetGameObjectsInLayers( camera->GetLayerMask(), layerGameObjectsScratch );
+    outGameObjects.clear();
+
+    for (auto gameObject : layerGameObjectsScratch)
+    {
+        if (!gameObject->IsEnabled())
+        {
+            continue;
+        }
+
+        auto meshRenderer = gameObject->GetComponent< MeshRendererComponent >();
+
+        if (meshRenderer == nullptr || meshRenderer->GetMesh() == nullptr)
+        {
+            continue;
+        }
+
+        auto transform = gameObject->GetComponent< TransformComponent >();
+        Vec3 aabbMinWorld, aabbMaxWorld;
+        meshRenderer->GetWorldAABB( transform ? transform->GetLocalToWorldMatrix() : Matrix44::identity, aabbMinWorld, aabbMaxWorld );
+
+        if (frustum.BoxInFrustum( aabbMinWorld, aabbMaxWorld ))
+        {
+            outGameObjects.push_back( gameObject );
+        }
+    }
+
+    auto meshSorterByMesh = [](const GameObject* j, const GameObject* k)
+    {
+        return j->GetComponent< MeshRendererComponent >()->GetMesh() <
+               k->GetComponent< MeshRendererComponent >()->GetMesh();
+    };
+
+    std::sort( std::begin( outGameObjects ), std::end( outGameObjects ), meshSorterByMesh );
+}
+
 void ae3d::Scene::SetSkybox( TextureCube* skyTexture )
 {
     skybox = skyTexture;
@@ -986,6 +1276,92 @@ std::string ae3d::Scene::GetSerialized() const
     return outSerialized;
 }
 
+// Reads a texture2d line's name and path. Uses the line's compressed texture path if it has one for this platform.
+static void ParseTexture2D( std::stringstream& lineStream, std::string& outName, std::string& outPath )
+{
+    lineStream >> outName >> outPath;
+    
+    if (!lineStream.eof())
+    {
+        std::string compressedTexturePath;
+        lineStream >> compressedTexturePath;
+        
+#if !TARGET_OS_IPHONE
+        if (compressedTexturePath.find( ".dds" ) != std::string::npos)
+        {
+            outPath = compressedTexturePath;
+        }
+        else if (!lineStream.eof())
+        {
+            lineStream >> compressedTexturePath;
+            
+            if (compressedTexturePath.find( ".dds" ) != std::string::npos)
+            {
+                outPath = compressedTexturePath;
+            }
+        }
+#endif
+#if TARGET_OS_IPHONE
+        // FIXME: Temporarily disabled because sponza.scene refers non-existing files.
+        /*if (compressedTexturePath.find( ".astc" ) != std::string::npos)
+        {
+            outPath = compressedTexturePath;
+        }
+        else if (!lineStream.eof())
+        {
+            lineStream >> compressedTexturePath;
+            
+            if (compressedTexturePath.find( ".astc" ) != std::string::npos)
+            {
+                outPath = compressedTexturePath;
+            }
+        }*/
+#endif
+    }
+}
+
+// Starts loading textures that texture2d and sprite lines refer to, so that they are decoded on AsyncLoader worker threads
+// while the rest of the scene is parsed. Returns the handles of the loads.
+static std::vector< ae3d::AsyncLoader::Handle > QueueTextureLoads( const std::string& sceneText, std::map< std::string, ae3d::Texture2D* >& outTexture2Ds )
+{
+    std::stringstream stream( sceneText );
+    std::string line;
+    std::vector< ae3d::AsyncLoader::Handle > handles;
+
+    while (std::getline( stream, line ))
+    {
+        std::stringstream lineStream( line );
+        std::string token;
+        lineStream >> token;
+
+        if (token == "texture2d")
+        {
+            std::string name;
+            std::string path;
+            ParseTexture2D( lineStream, name, path );
+
+            const ae3d::ColorSpace colorSpace = path.find( "_n." ) != std::string::npos ? ae3d::ColorSpace::Linear : ae3d::ColorSpace::SRGB;
+            outTexture2Ds[ name ] = new ae3d::Texture2D();
+            handles.push_back( outTexture2Ds[ name ]->LoadAsync( path.c_str(), ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Linear, ae3d::Mipmaps::Generate, colorSpace, ae3d::Anisotropy::k1 ) );
+        }
+        else if (token == "sprite")
+        {
+            std::string spritePath;
+            lineStream >> spritePath;
+
+            // Game objects can share a sprite.
+            if (outTexture2Ds.find( spritePath ) == std::end( outTexture2Ds ))
+            {
+                outTexture2Ds[ spritePath ] = new ae3d::Texture2D();
+                handles.push_back( outTexture2Ds[ spritePath ]->LoadAsync( spritePath.c_str(), ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Linear, ae3d::Mipmaps::Generate,
+                                                                           ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 ) );
+            }
+        }
+    }
+
+    return handles;
+}
+
 ae3d::Scene::DeserializeResult ae3d::Scene::Deserialize( const FileSystem::FileContentsData& serialized, std::vector< GameObject >& outGameObjects,
                                                         std::map< std::string, Texture2D* >& outTexture2Ds,
                                                         std::map< std::string, Material* >& outMaterials,
@@ -995,8 +1371,23 @@ ae3d::Scene::DeserializeResult ae3d::Scene::Deserialize( const FileSystem::FileC
 
     outGameObjects.clear();
 
-    std::stringstream stream( std::string( std::begin( serialized.data ), std::end( serialized.data ) ) );
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::string sceneText( std::begin( serialized.data ), std::end( serialized.data ) );
+    const std::vector< AsyncLoader::Handle > textureLoads = QueueTextureLoads( sceneText, outTexture2Ds );
+
+    std::stringstream stream( sceneText );
     std::string line;
+
+    // Sprite textures are set after their textures have been loaded because SpriteRendererComponent reads their opacity.
+    struct SpriteLine
+    {
+        std::size_t gameObjectIndex;
+        std::string path;
+        float x;
+        float y;
+    };
+
+    std::vector< SpriteLine > spriteLines;
     
     std::string currentMaterialName;
     
@@ -1371,7 +1762,7 @@ ae3d::Scene::DeserializeResult ae3d::Scene::Deserialize( const FileSystem::FileC
             Mesh* mesh = new Mesh();
             outMeshes.Add( mesh );
 
-            outMeshes[ outMeshes.count - 1 ]->Load( FileSystem::FileContents( meshFile.c_str() ) );
+            outMeshes[ outMeshes.count - 1 ]->Load( FileSystem::OpenFileView( meshFile.c_str() ) );
 			meshRenderer->SetMesh( outMeshes[ outMeshes.count - 1 ] );
 
             meshRenderer->SetMaterial( tempMaterial, 0 );
@@ -1404,10 +1795,7 @@ ae3d::Scene::DeserializeResult ae3d::Scene::Deserialize( const FileSystem::FileC
             float x, y, width, height;
             lineStream >> spritePath >> x >> y >> width >> height;
 
-            outTexture2Ds[ spritePath ] = new Texture2D();
-            outTexture2Ds[ spritePath ]->Load( FileSystem::FileContents( spritePath.c_str() ), TextureWrap::Repeat, TextureFilter::Linear, Mipmaps::Generate, ColorSpace::SRGB, Anisotropy::k1 );
-
-            outGameObjects.back().GetComponent< SpriteRendererComponent >()->SetTexture( outTexture2Ds[ spritePath ], Vec3( x, y, 0 ), Vec3( x, y, 1 ), Vec4( 1, 1, 1, 1 ) );
+            spriteLines.push_back( SpriteLine{ outGameObjects.size() - 1, spritePath, x, y } );
         }
         else if (token == "position")
         {
@@ -1465,59 +1853,7 @@ ae3d::Scene::DeserializeResult ae3d::Scene::Deserialize( const FileSystem::FileC
         }
         else if (token == "texture2d")
         {
-            std::string name;
-            std::string path;
-            
-            lineStream >> name >> path;
-            
-            if (!lineStream.eof())
-            {
-                std::string compressedTexturePath;
-                lineStream >> compressedTexturePath;
-                
-#if !TARGET_OS_IPHONE
-                if (compressedTexturePath.find( ".dds" ) != std::string::npos)
-                {
-                    path = compressedTexturePath;
-                }
-                else if (!lineStream.eof())
-                {
-                    lineStream >> compressedTexturePath;
-                    
-                    if (compressedTexturePath.find( ".dds" ) != std::string::npos)
-                    {
-                        path = compressedTexturePath;
-                    }
-                }
-#endif
-#if TARGET_OS_IPHONE
-                // FIXME: Temporarily disabled because sponza.scene refers non-existing files.
-                /*if (compressedTexturePath.find( ".astc" ) != std::string::npos)
-                {
-                    path = compressedTexturePath;
-                }
-                else if (!lineStream.eof())
-                {
-                    lineStream >> compressedTexturePath;
-                    
-                    if (compressedTexturePath.find( ".astc" ) != std::string::npos)
-                    {
-                        path = compressedTexturePath;
-                    }
-                }*/
-#endif
-            }
-
-            outTexture2Ds[ name ] = new Texture2D();
-
-            if (path.find( "_n." ) != std::string::npos)
-            {
-                outTexture2Ds[ name ]->Load( FileSystem::FileContents( path.c_str() ), TextureWrap::Repeat, TextureFilter::Linear, Mipmaps::Generate, ColorSpace::Linear, Anisotropy::k1 );
-            }
-            else
-            {
-                outTexture2Ds[ name ]->Load( FileSystem::FileContents( path.c_str() ), TextureWrap::Repeat, TextureFilter::Linear, Mipmaps::Generate, ColorSpace::SRGB, Anisotropy::k1 );
-            }
+            // Loaded by QueueTextureLoads().
         }
         else if (token == "material")
         {
@@ -1683,6 +2019,29 @@ ae3d::Scene::DeserializeResult ae3d::Scene::Deserialize( const FileSystem::FileC
         }
     }
 
+    const auto parseEndTime = std::chrono::steady_clock::now();
+
+    // Loads that were queued before this call are left for AsyncLoader::Update().
+    AsyncLoader::Wait( textureLoads );
+
+    const auto decodeEndTime = std::chrono::steady_clock::now();
+
+    Texture2D::BeginUploadBatch();
+    AsyncLoader::Finish( textureLoads );
+    Texture2D::EndUploadBatch();
+
+    const auto uploadEndTime = std::chrono::steady_clock::now();
+
+    for (const auto& spriteLine : spriteLines)
+    {
+        outGameObjects[ spriteLine.gameObjectIndex ].GetComponent< SpriteRendererComponent >()->SetTexture( outTexture2Ds[ spriteLine.path ],
+            Vec3( spriteLine.x, spriteLine.y, 0 ), Vec3( spriteLine.x, spriteLine.y, 1 ), Vec4( 1, 1, 1, 1 ) );
+    }
+
+    Statistics::SetSceneLoadTimes( static_cast< int >( textureLoads.size() ), std::chrono::duration< float, std::milli >( parseEndTime - startTime ).count(),
+                                   std::chrono::duration< float, std::milli >( decodeEndTime - parseEndTime ).count(),
+                                   std::chrono::duration< float, std::milli >( uploadEndTime - decodeEndTime ).count() );
+
     for (const auto& go : outGameObjects)
     {
         const auto mr = go.GetComponent< MeshRendererComponent >();
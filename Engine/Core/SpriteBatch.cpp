@@ -0,0 +1,171 @@
+#include "SpriteBatch.hpp"
+#include <algorithm>
+#include <utility>
+
+int ae3d::SpriteBatch::Add( TextureBase* texture, unsigned textureId, const Vec4& scaleOffset, const Vec3& position, const Vec3& dimension, const Vec4& tint )
+{
+    int slot;
+
+    if (freeSlots.empty())
+    {
+        slot = static_cast< int >( slots.size() );
+        slots.emplace_back();
+        vertices.resize( vertices.size() + 4 );
+    }
+    else
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    Slot& s = slots[ slot ];
+    s.texture = texture;
+    s.textureId = textureId;
+    s.scaleOffset = scaleOffset;
+    s.dimension = dimension;
+    s.tint = tint;
+    s.isUsed = true;
+
+    WriteVertices( slot, position );
+    ++spriteCount;
+    areFacesChanged = true;
+
+    return slot;
+}
+
+void ae3d::SpriteBatch::SetPosition( int slot, const Vec3& position )
+{
+    if (slot >= 0 && slot < static_cast< int >( slots.size() ) && slots[ slot ].isUsed)
+    {
+        WriteVertices( slot, position );
+    }
+}
+
+void ae3d::SpriteBatch::Remove( int slot )
+{
+    if (slot < 0 || slot >= static_cast< int >( slots.size() ) || !slots[ slot ].isUsed)
+    {
+        return;
+    }
+
+    slots[ slot ].isUsed = false;
+    slots[ slot ].texture = nullptr;
+    freeSlots.push_back( slot );
+    --spriteCount;
+    areFacesChanged = true;
+}
+
+void ae3d::SpriteBatch::Clear()
+{
+    slots.clear();
+    freeSlots.clear();
+    changedSlots.clear();
+    changedVertexRanges.clear();
+    vertices.clear();
+    faces.clear();
+    drawRanges.clear();
+    spriteCount = 0;
+    areFacesChanged = false;
+}
+
+void ae3d::SpriteBatch::WriteVertices( int slot, const Vec3& position )
+{
+    Slot& s = slots[ slot ];
+    VertexBuffer::VertexPTC* quad = &vertices[ slot * 4 ];
+
+    quad[ 0 ].position = position;
+    quad[ 1 ].position = position + Vec3( s.dimension.x, 0, 0 );
+    quad[ 2 ].position = position + Vec3( s.dimension.x, s.dimension.y, 0 );
+    quad[ 3 ].position = position + Vec3( 0, s.dimension.y, 0 );
+
+    const float u0 = s.scaleOffset.z;
+    const float u1 = s.scaleOffset.x + s.scaleOffset.z;
+    const float v0 = s.scaleOffset.w;
+    const float v1 = s.scaleOffset.y + s.scaleOffset.w;
+
+    quad[ 0 ].u = u0;
+    quad[ 0 ].v = v0;
+    quad[ 1 ].u = u1;
+    quad[ 1 ].v = v0;
+    quad[ 2 ].u = u1;
+    quad[ 2 ].v = v1;
+    quad[ 3 ].u = u0;
+    quad[ 3 ].v = v1;
+
+    for (int v = 0; v < 4; ++v)
+    {
+        quad[ v ].color = s.tint;
+    }
+
+    if (!s.isChanged)
+    {
+        s.isChanged = true;
+        changedSlots.push_back( slot );
+    }
+}
+
+bool ae3d::SpriteBatch::Update()
+{
+    // Neighbouring slots are merged, so a batch that was just filled is uploaded with one copy.
+    std::sort( changedSlots.begin(), changedSlots.end() );
+    changedVertexRanges.clear();
+
+    for (int slot : changedSlots)
+    {
+        slots[ slot ].isChanged = false;
+
+        if (!changedVertexRanges.empty() && changedVertexRanges.back().firstVertex + changedVertexRanges.back().vertexCount == slot * 4)
+        {
+            changedVertexRanges.back().vertexCount += 4;
+        }
+        else
+        {
+            changedVertexRanges.push_back( { slot * 4, 4 } );
+        }
+    }
+
+    changedSlots.clear();
+
+    if (!areFacesChanged)
+    {
+        return false;
+    }
+
+    // Moving a sprite doesn't change faces, so they're only sorted when sprites are added or removed.
+    std::vector< std::pair< unsigned, int > > order;
+    order.reserve( spriteCount );
+
+    for (std::size_t slot = 0; slot < slots.size(); ++slot)
+    {
+        if (slots[ slot ].isUsed)
+        {
+            order.emplace_back( slots[ slot ].textureId, static_cast< int >( slot ) );
+        }
+    }
+
+    std::sort( order.begin(), order.end() );
+
+    faces.resize( order.size() * 2 );
+    drawRanges.clear();
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        const int slot = order[ i ].second;
+        const unsigned firstVertex = static_cast< unsigned >( slot ) * 4;
+        faces[ i * 2 + 0 ] = VertexBuffer::Face32( firstVertex + 0, firstVertex + 1, firstVertex + 2 );
+        faces[ i * 2 + 1 ] = VertexBuffer::Face32( firstVertex + 2, firstVertex + 3, firstVertex + 0 );
+
+        if (drawRanges.empty() || drawRanges.back().texture != slots[ slot ].texture)
+        {
+            DrawRange range;
+            range.texture = slots[ slot ].texture;
+            range.faceStart = static_cast< int >( i ) * 2;
+            drawRanges.push_back( range );
+        }
+
+        drawRanges.back().faceEnd = static_cast< int >( i ) * 2 + 2;
+    }
+
+    areFacesChanged = false;
+    return true;
+}
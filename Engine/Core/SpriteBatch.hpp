@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "Vec3.hpp"
+#include "VertexBuffer.hpp"
+
+namespace ae3d
+{
+    class TextureBase;
+
+    /// Keeps sprite quads in stable slots of a vertex array, so moving a sprite rewrites only its 4 vertices. Faces are grouped by texture
+    /// into draw ranges, which are rebuilt only when sprites are added or removed. Indices are 32-bit, so a batch can hold more than 16384
+    /// sprites. Doesn't own graphics API objects: the owner uploads changed vertex ranges and faces after Update().
+    class SpriteBatch
+    {
+    public:
+        /// Faces that are drawn with one texture.
+        struct DrawRange
+        {
+            TextureBase* texture = nullptr;
+            int faceStart = 0;
+            int faceEnd = 0;
+        };
+
+        /// Vertices that changed since the previous Update().
+        struct VertexRange
+        {
+            int firstVertex;
+            int vertexCount;
+        };
+
+        /// Adds a sprite into a free slot.
+        /// \param texture Texture.
+        /// \param textureId Texture's ID. Draw ranges are ordered by it.
+        /// \param scaleOffset Texture's UV scale in xy and offset in zw.
+        /// \param position Position of the bottom left corner.
+        /// \param dimension Width and height.
+        /// \param tint Vertex color.
+        /// \return Slot that identifies the sprite until it's removed.
+        int Add( TextureBase* texture, unsigned textureId, const Vec4& scaleOffset, const Vec3& position, const Vec3& dimension, const Vec4& tint );
+
+        /// Moves a sprite. Only its vertices are uploaded again.
+        /// \param slot Slot returned by Add().
+        /// \param position Position of the bottom left corner.
+        void SetPosition( int slot, const Vec3& position );
+
+        /// Removes a sprite. Its slot is reused by a later Add().
+        /// \param slot Slot returned by Add().
+        void Remove( int slot );
+
+        /// Removes all sprites.
+        void Clear();
+
+        /// \return True if there are no sprites.
+        bool IsEmpty() const { return spriteCount == 0; }
+
+        /// \return Sprite count.
+        int GetSpriteCount() const { return spriteCount; }
+
+        /// Rebuilds faces and draw ranges if sprites were added or removed and merges slots whose vertices changed into vertex ranges.
+        /// \return True if faces changed. They must be uploaded again.
+        bool Update();
+
+        /// \return Vertex ranges that changed before the latest Update().
+        const std::vector< VertexRange >& GetChangedVertexRanges() const { return changedVertexRanges; }
+
+        /// \return Vertices of all slots, 4 per slot. Removed slots keep their old vertices, but no face uses them.
+        const std::vector< VertexBuffer::VertexPTC >& GetVertices() const { return vertices; }
+
+        /// \return Faces of all sprites, 2 per sprite, grouped by texture.
+        const std::vector< VertexBuffer::Face32 >& GetFaces() const { return faces; }
+
+        /// \return Draw ranges ordered by texture ID.
+        const std::vector< DrawRange >& GetDrawRanges() const { return drawRanges; }
+
+    private:
+        struct Slot
+        {
+            TextureBase* texture = nullptr;
+            unsigned textureId = 0;
+            Vec4 scaleOffset;
+            Vec3 dimension;
+            Vec4 tint;
+            bool isUsed = false;
+            bool isChanged = false;
+        };
+
+        void WriteVertices( int slot, const Vec3& position );
+
+        std::vector< Slot > slots;
+        std::vector< int > freeSlots;
+        std::vector< int > changedSlots;
+        std::vector< VertexRange > changedVertexRanges;
+        std::vector< VertexBuffer::VertexPTC > vertices;
+        std::vector< VertexBuffer::Face32 > faces;
+        std::vector< DrawRange > drawRanges;
+        int spriteCount = 0;
+        bool areFacesChanged = false;
+    };
+}
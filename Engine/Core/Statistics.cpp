@@ -13,8 +13,10 @@ namespace Statistics
     int allocCalls = 0;
     int totalAllocCalls = 0;
     int triangleCount = 0;
+    int meshLodTriangleCounts[ MaxMeshLods ] = {};
     int psoBindCount = 0;
     int queueSubmitCalls = 0;
+    std::size_t residentMeshCpuBytes = 0;
     float depthNormalsTimeMS = 0;
     float depthNormalsTimeGpuMS = 0;
     float shadowMapTimeMS = 0;
@@ -23,6 +25,10 @@ namespace Statistics
     float presentTimeMS = 0;
     float sceneAABBTimeMS = 0;
     float lightCullerTimeGpuMS = 0;
+    int sceneLoadTextureCount = 0;
+    float sceneLoadParseTimeMS = 0;
+    float sceneLoadDecodeWaitTimeMS = 0;
+    float sceneLoadUploadTimeMS = 0;
     std::chrono::time_point< std::chrono::steady_clock > startFrameTimePoint;
     std::chrono::time_point< std::chrono::steady_clock > startShadowMapTimePoint;
     std::chrono::time_point< std::chrono::steady_clock > startDepthNormalsTimePoint;
@@ -40,6 +46,31 @@ int Statistics::GetTriangleCount()
     return triangleCount;
 }
 
+void Statistics::IncMeshLodTriangleCount( int lod, int triangles )
+{
+    meshLodTriangleCounts[ lod < MaxMeshLods ? lod : MaxMeshLods - 1 ] += triangles;
+}
+
+int Statistics::GetMeshLodTriangleCount( int lod )
+{
+    return (lod >= 0 && lod < MaxMeshLods) ? meshLodTriangleCounts[ lod ] : 0;
+}
+
+void Statistics::IncResidentMeshCpuBytes( std::size_t bytes )
+{
+    residentMeshCpuBytes += bytes;
+}
+
+void Statistics::DecResidentMeshCpuBytes( std::size_t bytes )
+{
+    residentMeshCpuBytes -= bytes;
+}
+
+std::size_t Statistics::GetResidentMeshCpuBytes()
+{
+    return residentMeshCpuBytes;
+}
+
 float Statistics::GetPresentTimeMS()
 {
     return presentTimeMS;
@@ -257,6 +288,12 @@ void Statistics::ResetFrameStatistics()
     createConstantBufferCalls = 0;
     allocCalls = 0;
     triangleCount = 0;
+
+    for (int lod = 0; lod < MaxMeshLods; ++lod)
+    {
+        meshLodTriangleCounts[ lod ] = 0;
+    }
+
     psoBindCount = 0;
     queueSubmitCalls = 0;
 
@@ -285,6 +322,34 @@ void Statistics::EndSceneAABB()
     Statistics::sceneAABBTimeMS = static_cast< float >(tDiff);
 }
 
+void Statistics::SetSceneLoadTimes( int textureCount, float parseMS, float decodeWaitMS, float uploadMS )
+{
+    sceneLoadTextureCount = textureCount;
+    sceneLoadParseTimeMS = parseMS;
+    sceneLoadDecodeWaitTimeMS = decodeWaitMS;
+    sceneLoadUploadTimeMS = uploadMS;
+}
+
+int Statistics::GetSceneLoadTextureCount()
+{
+    return sceneLoadTextureCount;
+}
+
+float Statistics::GetSceneLoadParseTimeMS()
+{
+    return sceneLoadParseTimeMS;
+}
+
+float Statistics::GetSceneLoadDecodeWaitTimeMS()
+{
+    return sceneLoadDecodeWaitTimeMS;
+}
+
+float Statistics::GetSceneLoadUploadTimeMS()
+{
+    return sceneLoadUploadTimeMS;
+}
+
 void UpdateFrameTiming()
 {
     Statistics::EndFrameTimeProfiling();
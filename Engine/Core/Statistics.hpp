@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+
 namespace Statistics
 {
+    /// Triangle counts are kept for this many mesh LODs. Coarser LODs are counted as the last one.
+    const int MaxMeshLods = 8;
+
     void BeginLightCullerProfiling();
     void EndLightCullerProfiling();
 
@@ -31,6 +36,8 @@ namespace Statistics
     
     void IncTriangleCount( int triangles );
     int GetTriangleCount();
+    void IncMeshLodTriangleCount( int lod, int triangles );
+    int GetMeshLodTriangleCount( int lod );
     void IncCreateConstantBufferCalls();
     int GetCreateConstantBufferCalls();
     void IncDrawCalls();
@@ -55,4 +62,13 @@ namespace Statistics
     void SetDepthNormalsGpuTime( float timeMS );
     void SetShadowMapGpuTime( float timeMS );
     void SetLightCullerTimeGpuMS( float timeMS );
+    /// Stages of the last Scene::Deserialize(). Parsing overlaps texture decoding, decode wait is the time spent waiting for decoding after parsing.
+    void SetSceneLoadTimes( int textureCount, float parseMS, float decodeWaitMS, float uploadMS );
+    int GetSceneLoadTextureCount();
+    float GetSceneLoadParseTimeMS();
+    float GetSceneLoadDecodeWaitTimeMS();
+    float GetSceneLoadUploadTimeMS();
+    void IncResidentMeshCpuBytes( std::size_t bytes );
+    void DecResidentMeshCpuBytes( std::size_t bytes );
+    std::size_t GetResidentMeshCpuBytes();
 }
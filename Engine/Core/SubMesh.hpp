@@ -2,6 +2,8 @@
 
 #include <string>
 #include <vector>
+#include "MeshCluster.hpp"
+#include "MeshLod.hpp"
 #include "VertexBuffer.hpp"
 #include "Vec3.hpp"
 
@@ -24,7 +26,19 @@ namespace ae3d
         std::vector< VertexBuffer::VertexPTNTC > verticesPTNTC;
         std::vector< VertexBuffer::VertexPTNTC_Skinned > verticesPTNTC_Skinned;
         std::vector< VertexBuffer::VertexPTN > verticesPTN;
+#if RENDERER_VULKAN
+        /// Quantized vertices of a submesh that was loaded without uploading. One of the vertex vectors has them decoded.
+        std::vector< unsigned char > quantizedVertices;
+#endif
         std::vector< VertexBuffer::Face > indices;
+        /// Used instead of indices when the submesh has more than 65535 vertices.
+        std::vector< VertexBuffer::Face32 > indices32;
+        /// Used instead of vertices when only positions are kept, see Mesh::CpuData.
+        std::vector< Vec3 > positions;
         std::vector< Joint > joints;
+        /// LOD 0 faces split into clusters for per-cluster culling. Empty if the file has no clusters.
+        std::vector< MeshCluster > clusters;
+        /// Detail levels, starting with LOD 0. Empty if the file has only one level, which then uses every face.
+        std::vector< MeshLod > lods;
     };
 }
@@ -10,6 +10,8 @@
 #endif
 #include <stdarg.h>
 #include <assert.h>
+#include "AssetRegistry.hpp"
+#include "AsyncLoader.hpp"
 #include "AudioSystem.hpp"
 #include "GfxDevice.hpp"
 #include "FileWatcher.hpp"
@@ -66,12 +68,14 @@ void ae3d::System::BeginFrame()
 void ae3d::System::EndFrame()
 {
     GfxDevice::PresentDrawable();
+    AssetRegistry::EndFrame();
 }
 
 #endif
 
 void ae3d::System::Deinit()
 {
+    AsyncLoader::Deinit();
     GfxDevice::ReleaseGPUObjects();
     AudioSystem::Deinit();
 }
@@ -268,6 +272,11 @@ void ae3d::System::ReloadChangedAssets()
     fileWatcher.Poll();
 }
 
+void ae3d::System::FinishAsyncLoads( float budgetMs )
+{
+    AsyncLoader::Update( budgetMs );
+}
+
 int ae3d::System::Statistics::GetDrawCallCount()
 {
     return ::Statistics::GetDrawCalls();
@@ -0,0 +1,163 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "TextureChannels.hpp"
+
+using namespace ae3d;
+
+// Same test as CompressTexture uses to choose BC5: unit length vectors pointing out of the surface.
+static bool IsNormalMap( const unsigned char* rgba, std::size_t pixelCount )
+{
+    std::size_t normalCount = 0;
+
+    for (std::size_t i = 0; i < pixelCount; ++i)
+    {
+        const float x = rgba[ i * 4 + 0 ] / 127.5f - 1;
+        const float y = rgba[ i * 4 + 1 ] / 127.5f - 1;
+        const float z = rgba[ i * 4 + 2 ] / 127.5f - 1;
+        const float lengthSquared = x * x + y * y + z * z;
+        normalCount += (z > 0 && lengthSquared > 0.8f && lengthSquared < 1.2f) ? 1 : 0;
+    }
+
+    return normalCount >= pixelCount - pixelCount / 20;
+}
+
+TextureChannels::Layout TextureChannels::Analyze( const unsigned char* rgba, std::size_t pixelCount, bool isSRGB )
+{
+    Layout layout;
+
+    if (pixelCount == 0)
+    {
+        return layout;
+    }
+
+    bool isConstant[ 4 ] = { true, true, true, true };
+    // isEqual[ c ][ k ] is true if channel c equals channel k < c in every pixel.
+    bool isEqual[ 4 ][ 4 ] = {};
+
+    for (int c = 1; c < 4; ++c)
+    {
+        for (int k = 0; k < c; ++k)
+        {
+            // sRGB formats decode RGB but not alpha, and mipmaps are filtered in different spaces, so they can't be shared.
+            isEqual[ c ][ k ] = !isSRGB || c != 3;
+        }
+    }
+
+    for (std::size_t i = 1; i < pixelCount; ++i)
+    {
+        const unsigned char* pixel = rgba + i * 4;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            isConstant[ c ] &= pixel[ c ] == rgba[ c ];
+
+            for (int k = 0; k < c; ++k)
+            {
+                isEqual[ c ][ k ] &= pixel[ c ] == pixel[ k ];
+            }
+        }
+    }
+
+    for (int c = 1; c < 4; ++c)
+    {
+        for (int k = 0; k < c; ++k)
+        {
+            isEqual[ c ][ k ] &= rgba[ c ] == rgba[ k ];
+        }
+    }
+
+    const Swizzle storedSwizzles[ 4 ] = { Swizzle::R, Swizzle::G, Swizzle::B, Swizzle::A };
+    Swizzle swizzle[ 4 ];
+    int sourceChannels[ 4 ] = {};
+    int storedCount = 0;
+
+    for (int c = 0; c < 4; ++c)
+    {
+        if (isConstant[ c ] && (rgba[ c ] == 0 || rgba[ c ] == 255))
+        {
+            swizzle[ c ] = rgba[ c ] == 0 ? Swizzle::Zero : Swizzle::One;
+            continue;
+        }
+
+        int duplicateOf = -1;
+
+        for (int k = 0; k < c && duplicateOf == -1; ++k)
+        {
+            if (isEqual[ c ][ k ] && swizzle[ k ] != Swizzle::Zero && swizzle[ k ] != Swizzle::One)
+            {
+                duplicateOf = k;
+            }
+        }
+
+        if (duplicateOf != -1)
+        {
+            swizzle[ c ] = swizzle[ duplicateOf ];
+            continue;
+        }
+
+        if (isSRGB && c == 3 && storedCount > 0)
+        {
+            // A varying alpha next to color would be decoded as sRGB.
+            return layout;
+        }
+
+        swizzle[ c ] = storedSwizzles[ storedCount ];
+        sourceChannels[ storedCount ] = c;
+        ++storedCount;
+    }
+
+    if (isSRGB && storedCount == 1 && sourceChannels[ 0 ] == 3)
+    {
+        // Color is constant black or white but alpha varies: alpha can't be stored in an sRGB format.
+        return layout;
+    }
+
+    if (storedCount == 0)
+    {
+        // Every channel is 0 or 255. Stores R anyway, because the image needs some format.
+        sourceChannels[ 0 ] = 0;
+        storedCount = 1;
+    }
+
+    if (storedCount == 3 && !isSRGB && sourceChannels[ 2 ] == 2 && swizzle[ 3 ] == Swizzle::One && IsNormalMap( rgba, pixelCount ))
+    {
+        layout.channelCount = 2;
+        layout.sourceChannels[ 0 ] = 0;
+        layout.sourceChannels[ 1 ] = 1;
+        layout.swizzle[ 0 ] = Swizzle::R;
+        layout.swizzle[ 1 ] = Swizzle::G;
+        // Same as sampling BC5.
+        layout.swizzle[ 2 ] = Swizzle::Zero;
+        layout.swizzle[ 3 ] = Swizzle::One;
+        layout.isNormalMap = true;
+        return layout;
+    }
+
+    if (storedCount > 2)
+    {
+        return layout;
+    }
+
+    layout.channelCount = storedCount;
+
+    for (int c = 0; c < 4; ++c)
+    {
+        layout.sourceChannels[ c ] = c < storedCount ? sourceChannels[ c ] : 0;
+        layout.swizzle[ c ] = swizzle[ c ];
+    }
+
+    return layout;
+}
+
+void TextureChannels::Pack( const unsigned char* rgba, std::size_t pixelCount, const Layout& layout, unsigned char* outPixels )
+{
+    const std::size_t channelCount = (std::size_t)layout.channelCount;
+
+    for (std::size_t i = 0; i < pixelCount; ++i)
+    {
+        for (std::size_t s = 0; s < channelCount; ++s)
+        {
+            outPixels[ i * channelCount + s ] = rgba[ i * 4 + layout.sourceChannels[ s ] ];
+        }
+    }
+}
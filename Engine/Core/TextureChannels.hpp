@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ae3d
+{
+    /// Finds RGBA8 images that can be stored with fewer channels, e.g. roughness, metallic and AO maps whose channels are duplicates
+    /// or constants, and tangent-space normal maps whose Z can be reconstructed from X and Y. Such images are stored as R8 or RG8 and
+    /// a swizzle rebuilds their RGBA when sampling, so materials don't need to know. Doesn't use global state, so images can be
+    /// processed on worker threads and in offline tools.
+    namespace TextureChannels
+    {
+        /// Source of a sampled component: a stored channel or a constant.
+        enum class Swizzle { R, G, B, A, Zero, One };
+
+        struct Layout
+        {
+            /// Stored channels per pixel: 1, 2 or 4.
+            int channelCount = 4;
+            /// RGBA channel of the original image that each stored channel is copied from.
+            int sourceChannels[ 4 ] = { 0, 1, 2, 3 };
+            /// How sampling rebuilds the original R, G, B and A from stored channels.
+            Swizzle swizzle[ 4 ] = { Swizzle::R, Swizzle::G, Swizzle::B, Swizzle::A };
+            /// True if B of a tangent-space normal map is not stored. Shaders reconstruct it from R and G.
+            bool isNormalMap = false;
+        };
+
+        /// Finds the fewest channels from which the image can be rebuilt. Duplicate channels and channels that are always 0 or 255 are
+        /// rebuilt exactly. In sRGB images alpha is only rebuilt from constants, because sRGB formats would decode a stored alpha.
+        /// \param rgba RGBA8 image.
+        /// \param pixelCount Pixel count.
+        /// \param isSRGB True if RGB is sRGB. Only linear images are checked for normal maps.
+        /// \return Layout. channelCount is 4 if the image can't be reduced.
+        Layout Analyze( const unsigned char* rgba, std::size_t pixelCount, bool isSRGB );
+
+        /// Copies stored channels of an image or a mip chain.
+        /// \param rgba RGBA8 pixels.
+        /// \param pixelCount Pixel count.
+        /// \param layout Layout returned by Analyze() for the image or the mip chain's level 0.
+        /// \param outPixels Receives pixelCount * layout.channelCount bytes.
+        void Pack( const unsigned char* rgba, std::size_t pixelCount, const Layout& layout, unsigned char* outPixels );
+    }
+}
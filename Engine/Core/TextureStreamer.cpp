@@ -0,0 +1,386 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "TextureStreamer.hpp"
+#include <algorithm>
+#include "AsyncLoader.hpp"
+
+using namespace ae3d;
+
+namespace TextureStreamerGlobal
+{
+    struct Entry
+    {
+        TextureStreamer::Description description;
+        /// Size of resident mip levels.
+        std::size_t residentSize = 0;
+        /// Largest size reported in reportedFrame.
+        float screenSize = 0;
+        unsigned reportedFrame = 0;
+        unsigned generation = 0;
+        int residentMip = 0;
+        /// Mip levels from this to the least detailed are never evicted.
+        int initialMip = 0;
+        /// Most detailed mip level that can be loaded. Raised when a load fails so that it's not retried every frame.
+        int availableMip = 0;
+        /// Mip level that is being loaded, or -1.
+        int pendingMip = -1;
+        bool isAlive = false;
+    };
+
+    std::vector< Entry > entries;
+    std::vector< unsigned > freeIndices;
+    std::size_t budget = 256 * 1024 * 1024;
+    /// Size of resident mip levels and of pending loads.
+    std::size_t usage = 0;
+    /// Starts at 1 so that textures that have never been reported have an older reportedFrame.
+    unsigned frame = 1;
+    int maxPendingLoads = 4;
+    int pendingCount = 0;
+    int initialMipSize = 64;
+    bool isEnabled = false;
+}
+
+static TextureStreamerGlobal::Entry* GetEntry( TextureStreamer::Handle handle )
+{
+    if (handle.generation == 0 || handle.index >= TextureStreamerGlobal::entries.size())
+    {
+        return nullptr;
+    }
+
+    TextureStreamerGlobal::Entry& entry = TextureStreamerGlobal::entries[ handle.index ];
+    return (entry.isAlive && entry.generation == handle.generation) ? &entry : nullptr;
+}
+
+static std::size_t GetMipRangeSize( const TextureStreamerGlobal::Entry& entry, int firstMip, int endMip )
+{
+    std::size_t size = 0;
+
+    for (int mip = firstMip; mip < endMip; ++mip)
+    {
+        size += entry.description.mipSizes[ mip ];
+    }
+
+    return size;
+}
+
+// Mip level that the texture needs this frame. Textures that were not reported need only their initial levels.
+static int GetNeededMip( const TextureStreamerGlobal::Entry& entry )
+{
+    if (entry.reportedFrame != TextureStreamerGlobal::frame)
+    {
+        return entry.initialMip;
+    }
+
+    const int desiredMip = TextureStreamer::GetDesiredMip( entry.description.width, entry.description.height, (int)entry.description.mipSizes.size(), entry.screenSize );
+    return std::max( std::min( desiredMip, entry.initialMip ), entry.availableMip );
+}
+
+void TextureStreamer::SetEnabled( bool enable )
+{
+    TextureStreamerGlobal::isEnabled = enable;
+}
+
+bool TextureStreamer::IsEnabled()
+{
+    return TextureStreamerGlobal::isEnabled;
+}
+
+void TextureStreamer::SetInitialMipSize( int pixels )
+{
+    TextureStreamerGlobal::initialMipSize = std::max( pixels, 1 );
+}
+
+int TextureStreamer::GetInitialResidentMip( int width, int height, int mipCount )
+{
+    const int maxSide = std::max( width, height );
+    int mip = 0;
+
+    while (mip + 1 < mipCount && (maxSide >> mip) > TextureStreamerGlobal::initialMipSize)
+    {
+        ++mip;
+    }
+
+    return mip;
+}
+
+int TextureStreamer::GetDesiredMip( int width, int height, int mipCount, float screenSizeInPixels )
+{
+    const int maxSide = std::max( width, height );
+    int mip = 0;
+
+    while (mip + 1 < mipCount && (maxSide >> (mip + 1)) >= screenSizeInPixels)
+    {
+        ++mip;
+    }
+
+    return mip;
+}
+
+TextureStreamer::Handle TextureStreamer::Register( const Description& description )
+{
+    unsigned index = 0;
+
+    if (!TextureStreamerGlobal::freeIndices.empty())
+    {
+        index = TextureStreamerGlobal::freeIndices.back();
+        TextureStreamerGlobal::freeIndices.pop_back();
+    }
+    else
+    {
+        index = (unsigned)TextureStreamerGlobal::entries.size();
+        TextureStreamerGlobal::entries.push_back( TextureStreamerGlobal::Entry() );
+    }
+
+    TextureStreamerGlobal::Entry& entry = TextureStreamerGlobal::entries[ index ];
+    const int mipCount = (int)description.mipSizes.size();
+    entry.description = description;
+    entry.residentMip = std::max( std::min( description.residentMip, mipCount - 1 ), 0 );
+    entry.initialMip = entry.residentMip;
+    entry.availableMip = 0;
+    entry.pendingMip = -1;
+    entry.screenSize = 0;
+    entry.reportedFrame = 0;
+    entry.residentSize = GetMipRangeSize( entry, entry.residentMip, mipCount );
+    entry.isAlive = true;
+    ++entry.generation;
+
+    // Generation 0 is reserved for invalid handles.
+    if (entry.generation == 0)
+    {
+        ++entry.generation;
+    }
+
+    TextureStreamerGlobal::usage += entry.residentSize;
+
+    Handle handle;
+    handle.index = index;
+    handle.generation = entry.generation;
+    return handle;
+}
+
+void TextureStreamer::Unregister( Handle handle )
+{
+    TextureStreamerGlobal::Entry* entry = GetEntry( handle );
+
+    if (entry == nullptr)
+    {
+        return;
+    }
+
+    TextureStreamerGlobal::usage -= entry->residentSize;
+    entry->description = Description();
+    entry->residentSize = 0;
+    entry->isAlive = false;
+    TextureStreamerGlobal::freeIndices.push_back( handle.index );
+}
+
+bool TextureStreamer::IsValid( Handle handle )
+{
+    return GetEntry( handle ) != nullptr;
+}
+
+void TextureStreamer::ReportScreenSize( Handle handle, float screenSizeInPixels )
+{
+    TextureStreamerGlobal::Entry* entry = GetEntry( handle );
+
+    if (entry == nullptr)
+    {
+        return;
+    }
+
+    if (entry->reportedFrame != TextureStreamerGlobal::frame)
+    {
+        entry->reportedFrame = TextureStreamerGlobal::frame;
+        entry->screenSize = screenSizeInPixels;
+    }
+    else
+    {
+        entry->screenSize = std::max( entry->screenSize, screenSizeInPixels );
+    }
+}
+
+int TextureStreamer::GetResidentMip( Handle handle )
+{
+    const TextureStreamerGlobal::Entry* entry = GetEntry( handle );
+    return entry != nullptr ? entry->residentMip : -1;
+}
+
+void TextureStreamer::SetBudget( std::size_t budgetInBytes )
+{
+    TextureStreamerGlobal::budget = budgetInBytes;
+}
+
+std::size_t TextureStreamer::GetBudget()
+{
+    return TextureStreamerGlobal::budget;
+}
+
+std::size_t TextureStreamer::GetMemoryUsage()
+{
+    return TextureStreamerGlobal::usage;
+}
+
+void TextureStreamer::SetMaxPendingLoads( int loadCount )
+{
+    TextureStreamerGlobal::maxPendingLoads = std::max( loadCount, 1 );
+}
+
+int TextureStreamer::GetPendingCount()
+{
+    return TextureStreamerGlobal::pendingCount;
+}
+
+// Evicts mip levels that textures don't need this frame until usage plus sizeInBytes fits in the budget.
+// Victims are in eviction order and nextVictim is the first one that can still have levels to evict.
+static bool EvictUntilFits( std::size_t sizeInBytes, const std::vector< unsigned >& victims, std::size_t& nextVictim )
+{
+    while (TextureStreamerGlobal::usage + sizeInBytes > TextureStreamerGlobal::budget && nextVictim < victims.size())
+    {
+        TextureStreamerGlobal::Entry& entry = TextureStreamerGlobal::entries[ victims[ nextVictim ] ];
+        const int neededMip = GetNeededMip( entry );
+        const int oldResidentMip = entry.residentMip;
+
+        while (entry.residentMip < neededMip && TextureStreamerGlobal::usage + sizeInBytes > TextureStreamerGlobal::budget)
+        {
+            const std::size_t mipSize = entry.description.mipSizes[ entry.residentMip ];
+            entry.residentSize -= mipSize;
+            TextureStreamerGlobal::usage -= mipSize;
+            ++entry.residentMip;
+        }
+
+        if (entry.residentMip != oldResidentMip)
+        {
+            entry.description.setResidentMip( entry.residentMip );
+        }
+
+        if (entry.residentMip == neededMip)
+        {
+            ++nextVictim;
+        }
+    }
+
+    return TextureStreamerGlobal::usage + sizeInBytes <= TextureStreamerGlobal::budget;
+}
+
+static void QueueLoad( unsigned index, int mip )
+{
+    TextureStreamerGlobal::Entry& entry = TextureStreamerGlobal::entries[ index ];
+    const std::size_t mipSize = entry.description.mipSizes[ mip ];
+    entry.pendingMip = mip;
+    TextureStreamerGlobal::usage += mipSize;
+    ++TextureStreamerGlobal::pendingCount;
+
+    TextureStreamer::Handle handle;
+    handle.index = index;
+    handle.generation = entry.generation;
+
+    // Copied so that the worker doesn't read the entry, which Register() can move.
+    const std::function< bool( int ) > loadMip = entry.description.loadMip;
+
+    AsyncLoader::Queue( [loadMip, mip]() { return loadMip( mip ); },
+        [handle, mip, mipSize]( bool loaded )
+        {
+            --TextureStreamerGlobal::pendingCount;
+            TextureStreamerGlobal::Entry* pendingEntry = GetEntry( handle );
+
+            if (pendingEntry == nullptr || !loaded)
+            {
+                TextureStreamerGlobal::usage -= mipSize;
+
+                if (pendingEntry != nullptr)
+                {
+                    pendingEntry->pendingMip = -1;
+                    pendingEntry->availableMip = mip + 1;
+                }
+
+                return false;
+            }
+
+            pendingEntry->pendingMip = -1;
+            pendingEntry->residentMip = mip;
+            pendingEntry->residentSize += mipSize;
+            pendingEntry->description.setResidentMip( mip );
+            return true;
+        } );
+}
+
+void TextureStreamer::Update()
+{
+    std::vector< unsigned > victims;
+    std::vector< unsigned > candidates;
+
+    for (unsigned index = 0; index < (unsigned)TextureStreamerGlobal::entries.size(); ++index)
+    {
+        const TextureStreamerGlobal::Entry& entry = TextureStreamerGlobal::entries[ index ];
+
+        if (!entry.isAlive || entry.pendingMip != -1)
+        {
+            continue;
+        }
+
+        const int neededMip = GetNeededMip( entry );
+
+        if (entry.residentMip < neededMip)
+        {
+            victims.push_back( index );
+        }
+        else if (entry.residentMip > neededMip)
+        {
+            candidates.push_back( index );
+        }
+    }
+
+    // Textures that were drawn least recently lose their levels first, then those with the most unneeded levels.
+    std::sort( std::begin( victims ), std::end( victims ), []( unsigned a, unsigned b )
+    {
+        const TextureStreamerGlobal::Entry& entryA = TextureStreamerGlobal::entries[ a ];
+        const TextureStreamerGlobal::Entry& entryB = TextureStreamerGlobal::entries[ b ];
+
+        if (entryA.reportedFrame != entryB.reportedFrame)
+        {
+            return entryA.reportedFrame < entryB.reportedFrame;
+        }
+
+        return GetNeededMip( entryA ) - entryA.residentMip > GetNeededMip( entryB ) - entryB.residentMip;
+    } );
+
+    // The blurriest textures load first, then those that are largest on screen.
+    std::sort( std::begin( candidates ), std::end( candidates ), []( unsigned a, unsigned b )
+    {
+        const TextureStreamerGlobal::Entry& entryA = TextureStreamerGlobal::entries[ a ];
+        const TextureStreamerGlobal::Entry& entryB = TextureStreamerGlobal::entries[ b ];
+        const int missingA = entryA.residentMip - GetNeededMip( entryA );
+        const int missingB = entryB.residentMip - GetNeededMip( entryB );
+
+        if (missingA != missingB)
+        {
+            return missingA > missingB;
+        }
+
+        return entryA.screenSize > entryB.screenSize;
+    } );
+
+    std::size_t nextVictim = 0;
+
+    // The budget can have been lowered.
+    EvictUntilFits( 0, victims, nextVictim );
+
+    for (unsigned index : candidates)
+    {
+        if (TextureStreamerGlobal::pendingCount >= TextureStreamerGlobal::maxPendingLoads)
+        {
+            break;
+        }
+
+        const int mip = TextureStreamerGlobal::entries[ index ].residentMip - 1;
+
+        if (!EvictUntilFits( TextureStreamerGlobal::entries[ index ].description.mipSizes[ mip ], victims, nextVictim ))
+        {
+            break;
+        }
+
+        QueueLoad( index, mip );
+    }
+
+    ++TextureStreamerGlobal::frame;
+}
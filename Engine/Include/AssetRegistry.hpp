@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace ae3d
+{
+    /**
+      Keeps track of loaded assets, their reference counts and memory usage by category. Assets whose reference count drops to 0
+      stay cached so that loading them again is cheap, but when a category's memory usage is over its budget, EndFrame() evicts
+      unreferenced assets in least-recently-used order. An evicted asset is released a few frames later, when the GPU is done with it.
+      Texture2D and Mesh register assets they load. Doesn't need a window or GPU by itself.
+    */
+    namespace AssetRegistry
+    {
+        /// Asset category. Memory usage and budget are per category.
+        enum class Category { Texture, Mesh, Audio, Font, Count };
+
+        /// Identifies a registered asset. Handles of evicted assets are never valid again.
+        struct Handle
+        {
+            unsigned index = 0;
+            /// 0 means an invalid handle.
+            unsigned generation = 0;
+        };
+
+        /// Registers an asset. Its reference count is 1.
+        /// \param category Category.
+        /// \param key Identifies the asset in Find(), e.g. path and load parameters. A key that is already registered is remapped to the new asset.
+        /// \param sizeInBytes Memory usage.
+        /// \param release Releases the asset's memory. Called by EndFrame() after eviction. If empty, the asset is never evicted.
+        /// \return Handle.
+        Handle Register( Category category, const std::string& key, std::size_t sizeInBytes, const std::function< void() >& release );
+
+        /// \return Handle of the asset registered with key, or an invalid handle if it's not registered or has been evicted.
+        Handle Find( Category category, const std::string& key );
+
+        /// \return True if the asset has been registered and not evicted.
+        bool IsValid( Handle handle );
+
+        /// Increments the reference count. Does nothing if the handle is not valid.
+        void AddRef( Handle handle );
+
+        /// Decrements the reference count. At 0 the asset can be evicted. Does nothing if the handle is not valid.
+        void Release( Handle handle );
+
+        /// \return Reference count, or 0 if the handle is not valid.
+        int GetRefCount( Handle handle );
+
+        /// Removes the asset from Find(), for example because its file was reloaded. It's evicted in EndFrame() when it's unreferenced.
+        void Unregister( Handle handle );
+
+        /// \param sizeInBytes New memory usage, e.g. after reloading.
+        void SetSize( Handle handle, std::size_t sizeInBytes );
+
+        /// \return Memory usage of registered assets that have not been evicted.
+        std::size_t GetMemoryUsage( Category category );
+
+        /// \param budgetInBytes EndFrame() evicts unreferenced assets while usage is over this. Default is 0, which evicts all unreferenced assets.
+        void SetBudget( Category category, std::size_t budgetInBytes );
+
+        /// \return Budget in bytes.
+        std::size_t GetBudget( Category category );
+
+        /// \param frameCount Evicted assets are released after this many EndFrame() calls. Default is 3.
+        void SetFramesInFlight( unsigned frameCount );
+
+        /// Evicts unreferenced assets of categories that are over budget and releases assets that were evicted frames in flight ago.
+        /// Called by the renderer after presenting a frame.
+        void EndFrame();
+
+        /// Releases evicted assets now. Call only when the GPU is idle.
+        void ReleaseEvicted();
+
+        /// Prints memory usage, budget and asset count of each category.
+        void PrintMemoryUsage();
+    }
+}
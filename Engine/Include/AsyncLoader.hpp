@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace ae3d
+{
+    /**
+      Loads assets in the background. Loads read and decode files on worker threads and are finished on the
+      thread that calls Update(), which must be the render thread because finishing creates GPU objects.
+      Mesh::LoadAsync() and Texture2D::LoadAsync() use this. Doesn't need a window or GPU by itself.
+    */
+    namespace AsyncLoader
+    {
+        /// Identifies a load. 0 is never a valid handle.
+        typedef unsigned Handle;
+
+        /// Load state.
+        enum class State { Invalid, Pending, Ready, Failed };
+
+        /// Starts worker threads. Called by the first Queue() if not called before.
+        /// \param workerCount Worker thread count. 0 uses one less than the hardware thread count, but at least 1.
+        void Init( unsigned workerCount );
+
+        /// Stops worker threads. Loads that have not been finished are dropped and marked as failed. Called by System::Deinit().
+        void Deinit();
+
+        /// Queues a load.
+        /// \param load Runs on a worker thread. Must not use the GPU. Returns false if loading failed. Can be empty, then finish runs in the next Update().
+        /// \param finish Runs in Update() after load. Gets load's result and returns false if loading failed. Can be empty.
+        /// \return Load handle.
+        Handle Queue( const std::function< bool() >& load, const std::function< bool( bool loaded ) >& finish );
+
+        /// \param handle Load handle.
+        /// \return Load state. Invalid if the handle was not returned by Queue().
+        State GetState( Handle handle );
+
+        /// \return Number of loads that have been queued but not finished.
+        int GetPendingCount();
+
+        /// Finishes loads that have been loaded on worker threads. Call once per frame on the render thread.
+        /// \param budgetMs Stops finishing loads after this many milliseconds. At least one load is finished if any are ready.
+        /// \return Number of finished loads.
+        int Update( float budgetMs );
+
+        /// Waits until worker threads have loaded all queued loads, without finishing them. Finish them with Update() or Flush().
+        void Wait();
+
+        /// Waits until worker threads have loaded the given loads, without finishing them. Other loads are not waited for.
+        /// \param handles Load handles.
+        void Wait( const std::vector< Handle >& handles );
+
+        /// Waits until the given loads have been loaded and finishes them, in the order of handles. Other loads are left for Update(). Call on the render thread.
+        /// \param handles Load handles. Loads that have already been finished are skipped.
+        void Finish( const std::vector< Handle >& handles );
+
+        /// Waits until all queued loads have been loaded and finishes them. Call on the render thread.
+        void Flush();
+    }
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
 #include <string>
 #include <vector>
 
@@ -23,17 +25,148 @@ namespace ae3d
             bool isLoaded = false;
         };
 
+        /// File inside a loaded .pak file. Stored bytes are read in place from the mapped .pak file, so they are valid until it's unloaded.
+        struct PakEntry
+        {
+            /// Entry bytes if the entry is not compressed, otherwise null. ReadPakEntry() reads any entry.
+            const unsigned char* data = nullptr;
+            /// Uncompressed size in bytes.
+            std::size_t size = 0;
+            /// Bytes in the .pak file. Same as data if the entry is not compressed.
+            const unsigned char* storedData = nullptr;
+            /// Size of storedData in bytes.
+            std::size_t storedSize = 0;
+            /// Uncompressed size of independently compressed blocks, or 0 if the entry is not compressed.
+            unsigned blockSize = 0;
+            /// True if the file was found in a loaded .pak file.
+            bool isFound = false;
+        };
+
+        /// Read-only file contents that are not copied. Points into a loaded .pak file or into a memory-mapped file.
+        /// Compressed .pak entries and Android assets are read into memory owned by the view. A view into a .pak file
+        /// is valid until the .pak file is unloaded, other views until they are destroyed.
+        class FileView
+        {
+        public:
+            FileView() = default;
+            FileView( const FileView& ) = delete;
+            FileView& operator=( const FileView& ) = delete;
+            FileView( FileView&& other );
+            FileView& operator=( FileView&& other );
+
+            /// Unmaps the file.
+            ~FileView();
+
+            /// \return File contents, or null if the file is empty or was not found.
+            const unsigned char* GetData() const { return data; }
+
+            /// \return Size in bytes.
+            std::size_t GetSize() const { return size; }
+
+            /// \return File path.
+            const std::string& GetPath() const { return path; }
+
+            /// \return True if the file was found.
+            bool IsLoaded() const { return isLoaded; }
+
+            /// \return True if contents were not read into memory owned by the view.
+            bool IsInPlace() const { return ownedData.empty(); }
+
+        private:
+            friend FileView OpenFileView( const char* path );
+
+            void Release();
+
+            std::string path;
+            std::vector< unsigned char > ownedData;
+            const unsigned char* data = nullptr;
+            std::size_t size = 0;
+            /// Memory-mapped file that the view unmaps.
+            const unsigned char* mappedData = nullptr;
+            std::size_t mappedSize = 0;
+            bool isLoaded = false;
+        };
+
+        /// Reads a file in chunks, so large files don't have to fit in memory. Compressed .pak entries are decompressed a chunk at a time.
+        /// Chunks whose size is a multiple of PakEntry::blockSize decompress every block once.
+        class FileReader
+        {
+        public:
+            FileReader() = default;
+            FileReader( const FileReader& ) = delete;
+            FileReader& operator=( const FileReader& ) = delete;
+
+            /// Closes the file.
+            ~FileReader();
+
+            /// Opens a file. Searches first in loaded .pak files, like FileContents(). Closes the previously opened file.
+            /// \param path Path.
+            /// \return True if the file was opened.
+            bool Open( const char* path );
+
+            /// Closes the file.
+            void Close();
+
+            /// Reads the next chunk.
+            /// \param destination Receives min( destinationSize, GetSize() - GetPosition() ) bytes.
+            /// \param destinationSize Size of destination in bytes.
+            /// \return Number of bytes read. 0 at the end of the file or if it could not be read.
+            std::size_t Read( unsigned char* destination, std::size_t destinationSize );
+
+            /// \param offset Position of the next Read().
+            /// \return False if the file is not open or offset is past the end.
+            bool Seek( std::size_t offset );
+
+            /// \return File size in bytes.
+            std::size_t GetSize() const { return size; }
+
+            /// \return Position of the next Read().
+            std::size_t GetPosition() const { return position; }
+
+            /// \return True if a file is open.
+            bool IsOpen() const { return isOpen; }
+
+        private:
+            PakEntry pakEntry;
+            std::FILE* file = nullptr;
+            /// AAsset on Android.
+            void* asset = nullptr;
+            std::size_t size = 0;
+            std::size_t position = 0;
+            bool isOpen = false;
+        };
+
         /**
-        Reads file contents.
+        Reads file contents. Can be called from AsyncLoader worker threads, also while .pak files are loaded. A .pak file must not be unloaded while loads are pending.
 
         \param path Path.
         */
         FileContentsData FileContents( const char* path );
 
-        /// \param path .pak file path. After this call FileContents() searches first in all loaded .pak files and if the file is not found, it's loaded without .pak file.
+        /// Opens file contents without copying them. Can be called from AsyncLoader worker threads, like FileContents().
+        /// \param path Path. Searches first in loaded .pak files.
+        /// \return View. IsLoaded() is false if the file was not found.
+        FileView OpenFileView( const char* path );
+
+        /// Finds a file in loaded .pak files without copying it. Files are found by their path hash, so the cost doesn't depend on the entry count.
+        /// \param path Path as it was given to CombineFiles.
+        /// \return Entry. If the file is in multiple .pak files, the entry in the first loaded one.
+        PakEntry FindPakEntry( const char* path );
+
+        /// Copies or decompresses a part of a .pak entry into a caller-provided buffer. If the part spans many compressed blocks,
+        /// they are decompressed in parallel on the calling thread and worker threads that are started by the first such read. Reading an entry in chunks with increasing offsets streams it without allocating the whole entry.
+        /// \param entry Entry found by FindPakEntry().
+        /// \param offset Offset into uncompressed contents.
+        /// \param destination Receives min( destinationSize, entry.size - offset ) bytes.
+        /// \param destinationSize Size of destination in bytes.
+        /// \return Number of bytes written. 0 if offset is at or past the end, or if compressed data is corrupted.
+        std::size_t ReadPakEntry( const PakEntry& entry, std::size_t offset, unsigned char* destination, std::size_t destinationSize );
+
+        /// \param path .pak file path. The file is memory-mapped. After this call FileContents() searches first in all loaded .pak files and if the file is not found, it's loaded without .pak file.
         void LoadPakFile( const char* path );
 
-        /// \param path .pak file. If it was loaded, it's unloaded and FileContents() does not search files inside it.
+        /// \param path .pak file. If it was loaded, it's unmapped and FileContents() does not search files inside it. Invalidates its PakEntry data
+        /// and views, so it must not be called while AsyncLoader loads are pending.
         void UnloadPakFile( const char* path );
     }
 }
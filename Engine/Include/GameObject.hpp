@@ -1,9 +1,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace ae3d
 {
+    class Scene;
+
     /// GameObject is composed of components that define its behavior.
     class GameObject
     {
@@ -56,9 +59,12 @@ namespace ae3d
         /// Constructor.
         GameObject() = default;
 
-        /// Copy constructor.
+        /// Copy constructor. The copy is not added into the scenes of other.
         GameObject( const GameObject& other );
 
+        /// Destructor. Removes the game object from scenes it was added to.
+        ~GameObject();
+
         /// \param go Other game object.
         GameObject& operator=( const GameObject& go );
 
@@ -66,7 +72,7 @@ namespace ae3d
         void SetName( const char* aName ) { name = aName; }
         
         /// \param enabled True if the game object should be rendered, false otherwise.
-        void SetEnabled( bool enabled ) { isEnabled = enabled; }
+        void SetEnabled( bool enabled );
         
         /// \return True if this game object and all its parents are enabled.
         bool IsEnabled() const;
@@ -75,7 +81,7 @@ namespace ae3d
         const char* GetName() const { return name.c_str(); }
         
         /// \param aLayer Layer for controlling camera visibility etc. Must be power of two (2, 4, 8 etc.)
-        void SetLayer( unsigned aLayer ) { layer = aLayer; }
+        void SetLayer( unsigned aLayer );
 
         /// \return Layer.
         unsigned GetLayer() const { return layer; }
@@ -84,6 +90,8 @@ namespace ae3d
         std::string GetSerialized() const;
 
     private:
+        friend class Scene;
+
         struct ComponentEntry
         {
             int type = -1;
@@ -96,6 +104,8 @@ namespace ae3d
         unsigned nextFreeComponentIndex = 0;
         ComponentEntry components[ MaxComponents ];
         std::string name;
+        /// Scenes this game object was added to. Their layer lists are updated when layer or enabled state changes. Not copied.
+        std::vector< Scene* > scenes;
         unsigned layer = 1;
         bool isEnabled = true;
     };
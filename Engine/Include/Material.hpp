@@ -25,6 +25,10 @@ namespace ae3d
         /// Applies the uniforms into the shader. Called internally.
         void Apply();
 
+        /// Reports how large the material's 2D textures are drawn, so that streamed textures load the mip levels they need. Called internally.
+        /// \param screenSizeInPixels Screen size of the mesh that uses the material.
+        void ReportTextureScreenSize( float screenSizeInPixels ) const;
+
         /// \return True, if backfaces are culled.
         bool IsBackFaceCulled() const { return cullBackFaces; }
 
@@ -1,13 +1,16 @@
 #pragma once
 
+#include <cstddef>
 #include <type_traits>
 #include "Array.hpp"
+#include "AsyncLoader.hpp"
 
 namespace ae3d
 {
     namespace FileSystem
     {
         struct FileContentsData;
+        class FileView;
     }
 
     struct SubMesh;
@@ -20,6 +23,17 @@ namespace ae3d
         /// Result of loading the mesh.
         enum class LoadResult { Success, Corrupted, OutOfMemory, FileNotFound };
 
+        /// CPU-side copies of vertex and index data that are kept after they have been uploaded to the GPU.
+        enum class CpuData
+        {
+            All, ///< Full vertices and indices. Default.
+            Positions, ///< Vertex positions and indices. Enough for GetSubMeshFlattenedTriangles().
+            None ///< Nothing. GetSubMeshFlattenedTriangles() returns no triangles.
+        };
+
+        /// \param cpuData CPU data that meshes loaded after this call keep. Meshes that are already loaded or cached are not affected.
+        static void SetCpuData( CpuData cpuData );
+
         /// Constructor.
         Mesh();
 
@@ -38,6 +52,17 @@ namespace ae3d
         /// \param meshData Data from .ae3d mesh file.
         /// \return Load result.
         LoadResult Load( const FileSystem::FileContentsData& meshData );
+
+        /// Loads a mesh without copying the file.
+        /// \param meshData View of .ae3d mesh file. Can be closed after this call.
+        /// \return Load result.
+        LoadResult Load( const FileSystem::FileView& meshData );
+
+        /// Loads a mesh in the background. The file is read and parsed by AsyncLoader worker threads and uploaded in AsyncLoader::Update().
+        /// Until then the mesh keeps its previous data, or is a cube if it had none. The mesh must not be destroyed before the load has finished.
+        /// \param path Path to .ae3d mesh file.
+        /// \return Load handle. Its state becomes Ready when the mesh has been loaded, or Failed if the file was not found or is invalid.
+        AsyncLoader::Handle LoadAsync( const char* path );
         
         /// \return Axis-aligned bounding box minimum in local coordinates.
         const Vec3& GetAABBMin() const;
@@ -64,9 +89,14 @@ namespace ae3d
         /// \param index Submesh index.
         /// \return Submesh name. If index is invalid, returns first submesh's name.
         const char* GetSubMeshName( unsigned index ) const;
+
+        /// \return Bytes of CPU memory used by this mesh's vertex, index and joint data. Meshes loaded from the same path share the data.
+        std::size_t GetMemoryUsage() const;
         
       private:
         friend class MeshRendererComponent;
+
+        LoadResult Load( const unsigned char* data, std::size_t size, const char* path, bool isLoaded );
         
         struct Impl;
         Impl& m() { return reinterpret_cast<Impl&>(_storage); }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include "Array.hpp"
 
 namespace ae3d
@@ -31,7 +32,7 @@ namespace ae3d
         class Material* GetMaterial( int subMeshIndex );
 
         /// \param material Material.
-        /// \param subMeshIndex Sub mesh index.
+        /// \param subMeshIndex Sub mesh index. Can be past the mesh's current submesh count if the mesh is being loaded asynchronously.
         void SetMaterial( Material* material, unsigned subMeshIndex );
 
         /// \param aMesh Mesh.
@@ -51,6 +52,15 @@ namespace ae3d
 
         /// \param enable True, if the mesh will be rendered as a wireframe.
         void EnableWireframe( bool enable ) { isWireframe = enable; }
+
+        /// \param bias Multiplies LOD errors projected on screen. Higher values select coarser LODs sooner. Defaults to 1.
+        void SetLodBias( float bias ) { lodBias = bias; }
+
+        /// \param bias LOD bias for shadow maps. Defaults to 2.
+        void SetShadowLodBias( float bias ) { shadowLodBias = bias; }
+
+        /// \return LOD selected for the most recently rendered camera. 0 is the most detailed.
+        int GetLod() const { return lod; }
         
     private:
         friend class GameObject;
@@ -67,6 +77,10 @@ namespace ae3d
         /// \return Component at index or null if index is invalid.
         static MeshRendererComponent* Get( unsigned index );
         
+        /// Adds submesh materials and culling state up to subMeshCount, keeping existing materials.
+        /// \param subMeshCount Submesh count.
+        void GrowSubMeshArrays( int subMeshCount );
+
         /// Applies skin
         /// \param subMeshIndex Submesh index
         void ApplySkin( unsigned subMeshIndex );
@@ -74,6 +88,26 @@ namespace ae3d
         /// \param cameraFrustum cameraFrustum
         /// \param localToWorld Local-to-World matrix
         void Cull( const class Frustum& cameraFrustum, const struct Matrix44& localToWorld );
+
+        /// Culls only submeshes and their clusters. Used when the whole mesh has already been found visible.
+        /// \param cameraFrustum cameraFrustum
+        /// \param localToWorld Local-to-World matrix
+        /// \param cameraPosition Perspective camera's position in world space for culling back-facing clusters, or null.
+        void CullSubMeshes( const Frustum& cameraFrustum, const Matrix44& localToWorld, const struct Vec3* cameraPosition );
+
+        /// Selects a LOD by the camera's distance and projection and reports the mesh's screen size to streamed textures of its materials.
+        /// Must be called before culling and rendering.
+        /// \param camera Camera. Remembers the LOD per camera.
+        /// \param cameraPosition Camera's position in world space.
+        /// \param localToWorld Local-to-World matrix
+        /// \param viewportHeight Height of the camera's viewport or render target in pixels.
+        /// \param isShadowPass True, if rendering a shadow map. Uses the shadow LOD bias.
+        void SelectLod( const class CameraComponent& camera, const Vec3& cameraPosition, const Matrix44& localToWorld, int viewportHeight, bool isShadowPass );
+
+        /// \param localToWorld Local-to-World matrix
+        /// \param outMin Mesh AABB's minimum corner in world space.
+        /// \param outMax Mesh AABB's maximum corner in world space.
+        void GetWorldAABB( const Matrix44& localToWorld, struct Vec3& outMin, Vec3& outMax ) const;
         
         /// \param localToView Model-view matrix.
         /// \param localToClip Model-view-projection matrix.
@@ -90,6 +124,23 @@ namespace ae3d
         Mesh* mesh = nullptr;
         Array< Material* > materials;
         Array< bool > isSubMeshCulled;
+        /// Visible [startFace, endFace) pairs of all submeshes after cluster culling.
+        std::vector< unsigned > visibleFaceRanges;
+        /// Index of a submesh's first pair in visibleFaceRanges or -1 if the submesh has no clusters and is drawn whole.
+        Array< int > firstVisibleFaceRange;
+        Array< int > visibleFaceRangeCount;
+
+        struct CameraLod
+        {
+            const CameraComponent* camera;
+            int lod;
+        };
+
+        /// LOD selected for each camera, used for hysteresis.
+        std::vector< CameraLod > cameraLods;
+        float lodBias = 1;
+        float shadowLodBias = 2;
+        int lod = 0;
         GameObject* gameObject = nullptr;
         int animFrame = 0;
         bool isCulled = false;
@@ -26,6 +26,7 @@ namespace ae3d
         /// \param target Target to resolve to.
         void ResolveTo( RenderTexture* target );
         
+        /// Calling again recreates the texture. On Vulkan the old objects are destroyed when the GPU has finished using them.
         /// \param width Width.
         /// \param height Height.
         /// \param dataType Data type.
@@ -65,6 +66,8 @@ namespace ae3d
 
 #if RENDERER_VULKAN
         void CreateRenderPass();
+        /// Destroys the objects created by Create2D() or CreateCube() when the GPU has finished using them. Keeps the render pass because the PSO cache refers to it.
+        void ReleaseObjects();
 
         VkFramebuffer frameBuffer = VK_NULL_HANDLE;
 
@@ -3,6 +3,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include "Array.hpp"
 #include "Vec3.hpp"
 
@@ -19,8 +20,11 @@ namespace ae3d
     public:
         /// Result of GetSerialized.
         enum class DeserializeResult { Success, ParseError };
+
+        /// Destructor. Detaches game objects that are still in the scene. Game objects remove themselves from scenes when they're destroyed.
+        ~Scene();
         
-        /// Adds a game object into the scene if it does not exist there already.
+        /// Adds a game object into the scene if it does not exist there already. A game object can be in many scenes.
         void Add( class GameObject* gameObject );
         
         /// Ends the rendering. Called after scene.Render() and UI/line rendering etc.
@@ -38,10 +42,16 @@ namespace ae3d
         /// \param skyTexture Skybox texture.
         void SetSkybox( class TextureCube* skyTexture );
         
+        /// \param layerMask Layers, usually a camera's layer mask.
+        /// \param outGameObjects Returns enabled game objects in the layers, each object once, in the order they were added to a layer. Parents' enabled state is not checked.
+        void GetGameObjectsInLayers( unsigned layerMask, std::vector< GameObject* >& outGameObjects ) const;
+
         /// \return Scene's contents in a textual format that can be saved into file etc.
         std::string GetSerialized() const;
 
         /// Deserializes a scene additively from file contents. Must be called after renderer is initialized.
+        /// Textures are decoded on AsyncLoader worker threads while meshes and the rest of the scene are parsed, and uploaded in one batch
+        /// at the end. AsyncLoader loads that were queued before this call are not waited for. Stage times are kept in Statistics.
         /// \param serialized Serialized scene contents.
         /// \param outGameObjects Returns game objects that were created from serialized scene contents.
         /// \param outTexture2Ds Returns texture 2Ds that were created from serialized scene contents. Caller is responsible for freeing the memory.
@@ -54,16 +64,49 @@ namespace ae3d
                                        Array< class Mesh* >& outMeshes ) const;
         
     private:
+        friend class GameObject;
+
         void RenderWithCamera( GameObject* cameraGo, int cubeMapFace, const char* debugGroupName );
         void RenderShadowsWithCamera( GameObject* cameraGo, int cubeMapFace );
         void RenderShadowMaps( std::vector< GameObject* >& cameras );
         void RenderRTCameras( std::vector< GameObject* >& rtCameras );
         void RenderDepthAndNormalsForAllCameras( std::vector< GameObject* >& cameras );
-        void RenderDepthAndNormals( class CameraComponent* camera, const struct Matrix44& view, std::vector< unsigned > gameObjectsWithMeshRenderer,
+        void RenderDepthAndNormals( class CameraComponent* camera, const struct Matrix44& view, const std::vector< GameObject* >& gameObjectsWithMeshRenderer,
                                     int cubeMapFace, const class Frustum& frustum );
         void GenerateAABB();
+        void CullViews( const std::vector< GameObject* >& rtCameras, const std::vector< GameObject* >& cameras );
+        void CollectVisibleMeshRenderers( CameraComponent* camera, const Frustum& frustum, std::vector< GameObject* >& outGameObjects ) const;
+        const std::vector< GameObject* >* GetVisibleMeshRenderers( const GameObject* cameraGo ) const;
+
+        /// Adds an enabled game object into the lists of every bit in layer.
+        void AddToLayers( GameObject* gameObject, unsigned layer );
+        /// Removes a game object from the lists of every bit in layer.
+        void RemoveFromLayers( GameObject* gameObject, unsigned layer );
+
+        /// Max number of cameras that are culled in the shared pass. Others are culled separately.
+        static const unsigned MaxCullViews = 32;
+        /// Number of bits in a layer mask.
+        static const unsigned LayerCount = 32;
 
         std::vector< GameObject* > gameObjects;
+        /// Cameras culled in CullViews(). Index is the camera's bit in the visibility mask.
+        std::vector< GameObject* > cullViewCameras;
+        /// For every cullViewCameras entry, visible game objects with a mesh renderer, sorted by mesh.
+        std::vector< std::vector< GameObject* > > cullViewMeshRenderers;
+        /// Enabled game objects of a layer bit, in the order they were added.
+        struct LayerList
+        {
+            /// Removed game objects leave a null slot until more than half of the slots are null.
+            std::vector< GameObject* > gameObjects;
+            /// Index of each game object in gameObjects, so removing doesn't search.
+            std::unordered_map< const GameObject*, std::size_t > slots;
+            std::size_t removedCount = 0;
+        };
+
+        /// Lists by layer bit. Updated by Add(), Remove(), GameObject::SetLayer() and GameObject::SetEnabled().
+        LayerList layerLists[ LayerCount ];
+        /// Filled by GetGameObjectsInLayers() for a camera or a pass and reused, so rendering doesn't allocate every frame.
+        mutable std::vector< GameObject* > layerGameObjectsScratch;
         unsigned nextFreeGameObject = 0;
         TextureCube* skybox = nullptr;
         Vec3 aabbMin;
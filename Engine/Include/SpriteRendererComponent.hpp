@@ -47,7 +47,7 @@ namespace ae3d
         /// \return Textual representation of component.
         std::string GetSerialized() const;
 
-        /// Removes all textures that were added using SetTexture.
+        /// Removes all textures that were added using SetTexture. Their sprite indices become invalid.
         void Clear();
 
         /// \return Sprite info for index.
@@ -61,8 +61,18 @@ namespace ae3d
           \param position Position relative to the component's transform.
           \param dimensionPixels Dimension in pixels.
           \param tintColor Tint color in range 0-1.
+          \return Sprite index for SetSpritePosition() and GetSpriteInfo().
          */
-        void SetTexture( class TextureBase* texture, const struct Vec3& position, const Vec3& dimensionPixels, const struct Vec4& tintColor );
+        int SetTexture( class TextureBase* texture, const struct Vec3& position, const Vec3& dimensionPixels, const struct Vec4& tintColor );
+
+        /**
+          Moves a sprite. Only the moved sprite's vertices are uploaded again, so moving a few sprites is cheap even if
+          the component has hundreds of thousands.
+
+          \param spriteIndex Index returned by SetTexture().
+          \param position Position relative to the component's transform.
+         */
+        void SetSpritePosition( int spriteIndex, const Vec3& position );
 
     private:
         friend class GameObject;
@@ -77,7 +77,10 @@
  
    Aether3D internals almost never read raw files, all file access is abstracted by FileSystem to allow file contents to come from various sources.
    CombineFiles creates .pak files that contain contents of multiple files. You run it with command <code>CombineFiles inputFile outputFile</code> where
-   inputFile is just a text file containing a list of file paths, each on their own line.
+   inputFile is just a text file containing a list of file paths, each on their own line. FileSystem::LoadPakFile() memory-maps .pak files
+   and finds files by their path hash, so files are read in place and lookup cost doesn't depend on the file count.
+   CombineFiles compresses files by their type: text files like .scene and .obj with a high ratio, files that are already compressed like .png and .ogg
+   not at all, and other files with a fast level. Uncompressed files are still read in place. FileSystem::ReadPakEntry() decompresses into a caller-provided buffer.
 
    \subsection SDF_Generator
 
@@ -190,9 +193,14 @@ namespace ae3d
         */
         void Print( const char* format, ... );
 
-        /// Reloads assets that have been changed on disk. Relatively slow operation, so avoid calling too often.
+        /// Reloads assets that have been changed on disk. An asset is reloaded after its file has not changed for 100 ms.
+        /// On Linux only changed files are checked. On other platforms every loaded asset's file is checked, so avoid calling too often.
         void ReloadChangedAssets();
 
+        /// Finishes meshes and textures loaded by LoadAsync(). Call once per frame before rendering.
+        /// \param budgetMs Stops after this many milliseconds, so loads are spread over frames. At least one load is finished if any are ready.
+        void FinishAsyncLoads( float budgetMs );
+
         /// Tests internal functionality.
         void RunUnitTests();
 
@@ -206,6 +214,8 @@ namespace ae3d
             int GetBarrierCallCount();
             int GetFenceCallCount();
             void GetGpuMemoryUsage( unsigned& outUsedMBytes, unsigned& outBudgetMBytes );
+            /// Prints CPU memory usage and user count of each unique loaded mesh.
+            void PrintMeshMemoryUsage();
         }
     }
 }
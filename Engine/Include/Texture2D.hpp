@@ -1,6 +1,9 @@
 #pragma once
 
+#include "AssetRegistry.hpp"
+#include "AsyncLoader.hpp"
 #include "TextureBase.hpp"
+#include "TextureStreamer.hpp"
 
 namespace DDSLoader
 {
@@ -14,6 +17,9 @@ namespace ae3d
         struct FileContentsData;
     }
 
+    /// Image that Texture2D::LoadAsync() decoded on a worker thread. Defined in TextureCommon.cpp.
+    struct DecodedImage;
+
     enum class TextureLayout
     {
         General, ShaderRead
@@ -44,19 +50,48 @@ namespace ae3d
         /// \param colorSpace Color space.
         /// \param anisotropy Anisotropy. Value range is 1-16 depending on support. On Metal the value is bucketed into 1, 2, 4, 8 and 16.
         void Load( const FileSystem::FileContentsData& textureData, TextureWrap wrap, TextureFilter filter, Mipmaps mipmaps, ColorSpace colorSpace, Anisotropy anisotropy );
+
+        /// Loads a texture in the background. The file is read and png, tga, jpg, bmp and gif images are decoded by AsyncLoader worker threads,
+        /// and the texture is created in AsyncLoader::Update(). Until then the texture keeps its previous image, or is the default texture if it had none.
+        /// The texture must not be destroyed before the load has finished.
+        /// \param path Path to texture file. File format must be dds, png, tga, jpg, bmp or bmp.
+        /// \param wrap Wrap mode.
+        /// \param filter Filter mode.
+        /// \param mipmaps Mipmaps.
+        /// \param colorSpace Color space.
+        /// \param anisotropy Anisotropy.
+        /// \return Load handle. Its state becomes Ready when the texture has been created, or Failed if the file was not found.
+        AsyncLoader::Handle LoadAsync( const char* path, TextureWrap wrap, TextureFilter filter, Mipmaps mipmaps, ColorSpace colorSpace, Anisotropy anisotropy );
         
         /// \param atlasTextureData Atlas texture image data. File format must be dds, png, tga, jpg, bmp or bmp.
-        /// \param atlasMetaData Atlas metadata. Format is Ogre/CEGUI. Example atlas tool: Texture Packer.
+        /// \param atlasMetaData Atlas metadata. Format is Ogre/CEGUI .xml, or a binary index written by Tools/AtlasIndexer. Example atlas tool: Texture Packer.
+        ///                      Parsed on the first call for its path and cached, so loading more sprites from the same atlas doesn't parse it again.
         /// \param textureName Name of the texture in atlas.
         /// \param wrap Wrap mode.
         /// \param filter Filter mode.
         /// \param colorSpace Color space.
         /// \param anisotropy Anisotropy. Value range is 1-16 depending on support. On Metal the value is bucketed into 1, 2, 4, 8 and 16.
         void LoadFromAtlas( const FileSystem::FileContentsData& atlasTextureData, const FileSystem::FileContentsData& atlasMetaData, const char* textureName, TextureWrap wrap, TextureFilter filter, ColorSpace colorSpace, Anisotropy anisotropy );
+
+        /// Like the overload above, but reads the atlas metadata only if it has not been parsed yet, so loading more sprites from an atlas doesn't read the file again.
+        /// \param atlasTextureData Atlas texture image data. File format must be dds, png, tga, jpg, bmp or bmp.
+        /// \param atlasMetaDataPath Path of atlas metadata. Format is Ogre/CEGUI .xml, or a binary index written by Tools/AtlasIndexer.
+        /// \param textureName Name of the texture in atlas.
+        /// \param wrap Wrap mode.
+        /// \param filter Filter mode.
+        /// \param colorSpace Color space.
+        /// \param anisotropy Anisotropy. Value range is 1-16 depending on support. On Metal the value is bucketed into 1, 2, 4, 8 and 16.
+        void LoadFromAtlas( const FileSystem::FileContentsData& atlasTextureData, const char* atlasMetaDataPath, const char* textureName, TextureWrap wrap, TextureFilter filter, ColorSpace colorSpace, Anisotropy anisotropy );
         
+        /// Reports how large this texture is drawn this frame, see TextureStreamer::ReportScreenSize(). Does nothing if the texture is not streamed.
+        /// \param screenSizeInPixels Screen size of the texture's larger side.
+        void ReportScreenSize( float screenSizeInPixels ) const;
+
 #if RENDERER_VULKAN
-        VkImageView& GetView() { return view; }
-        VkImage& GetImage() { return image; }
+        /// \return View of the image. Streamed textures return the view of their current image.
+        VkImageView& GetView();
+        /// \return Image. Streamed textures return their current image.
+        VkImage& GetImage();
         void LoadFromData( const void* imageData, int width, int height, int channels, const char* debugName, VkImageUsageFlags usageFlags );
         VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL;
 #else
@@ -67,26 +102,48 @@ namespace ae3d
         /// \param debugName Null-terminated string of texture's debug name that is visible in graphics debugging tools
         void LoadFromData( const void* imageData, int width, int height, int channels, const char* debugName );
 #endif
+        /// Releases this texture's reference to its image and makes this the default texture. An unreferenced image is released
+        /// when AssetRegistry's texture budget is exceeded. Copies of this texture must not be used after this.
+        void Unload();
+
+        /// Starts batching GPU uploads. Textures that are loaded until EndUploadBatch() are uploaded with one submit instead of
+        /// waiting for the GPU after each one. They must not be drawn before EndUploadBatch(). Only Vulkan batches, other renderers upload immediately.
+        /// Vulkan also batches TextureCubes that are loaded from a .dds cube map.
+        static void BeginUploadBatch();
+
+        /// Submits uploads that were batched since BeginUploadBatch() and waits for them.
+        static void EndUploadBatch();
+
         /// Destroys all textures. Called internally at exit.
         static void DestroyTextures();
 
     private:
-        /// \param path Path.
-        void LoadDDS( const char* path );
+        /// Loads a texture from file contents, or from decoded if it has the image already. Takes decoded's pixels and mipmaps.
+        void Load( const FileSystem::FileContentsData& textureData, DecodedImage* decoded, TextureWrap wrap, TextureFilter filter, Mipmaps mipmaps, ColorSpace colorSpace, Anisotropy anisotropy );
+
+        /// \param textureData Texture data.
+        /// \param decoded File that LoadAsync() mapped, or null.
+        void LoadDDS( const FileSystem::FileContentsData& textureData, const DecodedImage* decoded );
         
         /**
           Loads texture from stb_image.c supported formats.
 
           \param textureData Texture data.
+          \param decoded Pixels that LoadAsync() decoded, or null.
           */
-        void LoadSTB( const FileSystem::FileContentsData& textureData );
+        void LoadSTB( const FileSystem::FileContentsData& textureData, DecodedImage* decoded );
 #if RENDERER_METAL
         void LoadPVRv2( const char* path );
         void LoadPVRv3( const char* path );
 #endif
+        /// Image in AssetRegistry. Load() references it, copies of this texture don't.
+        AssetRegistry::Handle assetHandle;
+        /// Mip streaming of the image. Copies of this texture share it.
+        TextureStreamer::Handle streamHandle;
 #if RENDERER_VULKAN
         void CreateVulkanObjects( const DDSLoader::Output& mipChain, VkFormat format );
-        void CreateVulkanObjects( void* data, int bytesPerPixel, VkFormat format, VkImageUsageFlags usageFlags );
+        void CreateStreamedImage( const DDSLoader::Output& mipChain, VkFormat format, int residentMip );
+        void CreateVulkanObjects( void* data, int bytesPerPixel, VkFormat format, VkImageUsageFlags usageFlags, DecodedImage* decoded );
         VkImage image = VK_NULL_HANDLE;
         VkImageView view = VK_NULL_HANDLE;
         VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #if RENDERER_METAL
 #import <Metal/Metal.h>
@@ -61,7 +62,20 @@ namespace ae3d
         k8
     };
 
-    std::string GetCacheHash( const std::string& path, ae3d::TextureWrap wrap, ae3d::TextureFilter filter, ae3d::Mipmaps mipmaps, ae3d::ColorSpace colorSpace, ae3d::Anisotropy anisotropy );
+    /// Identifies a texture file loaded with given settings in the texture cache.
+    struct TextureCacheKey
+    {
+        /// FNV-1a hash of the path in the upper 56 bits, settings in the lower 8 bits.
+        std::uint64_t value = 0;
+
+        /// \return Hash of the path. Same for all settings.
+        std::uint64_t GetPathHash() const { return value >> 8; }
+
+        bool operator==( const TextureCacheKey& other ) const { return value == other.value; }
+    };
+
+    /// \return Cache key of a texture. Doesn't allocate.
+    TextureCacheKey GetCacheKey( const std::string& path, ae3d::TextureWrap wrap, ae3d::TextureFilter filter, ae3d::Mipmaps mipmaps, ae3d::ColorSpace colorSpace, ae3d::Anisotropy anisotropy );
 
     /// Base class for textures.
     class TextureBase
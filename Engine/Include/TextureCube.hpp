@@ -2,6 +2,11 @@
 
 #include "TextureBase.hpp"
 
+namespace DDSLoader
+{
+    struct Output;
+}
+
 namespace ae3d
 {
     namespace FileSystem
@@ -27,6 +32,10 @@ namespace ae3d
           \param filter Filtering mode.
           \param mipmaps Should mipmaps be generated and used.
           \param colorSpace Color space.
+
+          On Vulkan, if negX is a .dds cube map, all faces and their mipmaps are loaded from it and the other faces can be empty.
+          Its faces and mipmaps are uploaded with one copy. Tools/CubeMapFilter makes such cube maps with GGX-prefiltered mipmaps
+          for image-based lighting; load them with Mipmaps::Generate to keep the prefiltered levels.
          */
         void Load( const FileSystem::FileContentsData& negX, const FileSystem::FileContentsData& posX,
                    const FileSystem::FileContentsData& negY, const FileSystem::FileContentsData& posY,
@@ -60,6 +69,7 @@ namespace ae3d
     private:
         std::string posXpath, posYpath, negXpath, negYpath, posZpath, negZpath;
 #if RENDERER_VULKAN
+        void LoadDDS( const DDSLoader::Output& cubeMap, VkFormat format, const std::string& path );
         VkImage image = VK_NULL_HANDLE;
         VkImageView view = VK_NULL_HANDLE;
         VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace ae3d
+{
+    /**
+      Streams mip levels of textures under a memory budget. A registered texture starts with only its least detailed mip levels resident.
+      Renderers report how large textures are on screen, and Update() streams in the next mip level of textures whose resident mip levels
+      are blurrier than their screen size needs, blurriest first. Mip levels are read on AsyncLoader worker threads and made resident in
+      AsyncLoader::Update(). When a load would go over the budget, mip levels that are not needed are evicted, first from textures that
+      were drawn least recently. Texture2D streams .dds textures on Vulkan when this is enabled. Doesn't need a window or GPU by itself,
+      the residency backend is given as callbacks.
+    */
+    namespace TextureStreamer
+    {
+        /// Identifies a registered texture. Handles of unregistered textures are never valid again.
+        struct Handle
+        {
+            unsigned index = 0;
+            /// 0 means an invalid handle.
+            unsigned generation = 0;
+        };
+
+        /// Streamed texture.
+        struct Description
+        {
+            /// Width of mip level 0 in pixels.
+            int width = 0;
+            /// Height of mip level 0 in pixels.
+            int height = 0;
+            /// Size of each mip level in bytes. Mip level count is the element count.
+            std::vector< std::size_t > mipSizes;
+            /// Most detailed mip level that is resident when registering. It and less detailed levels are never evicted.
+            int residentMip = 0;
+            /// Runs on a worker thread. Reads a mip level. Returns false if reading failed. Must not use the GPU.
+            /// Objects that it uses must stay alive until it returns, even if the texture is unregistered.
+            std::function< bool( int mipLevel ) > loadMip;
+            /// Runs on the thread that calls Update() and AsyncLoader::Update(). Makes mipLevel the most detailed resident mip level,
+            /// by uploading the level that loadMip read or by releasing levels more detailed than mipLevel.
+            std::function< void( int mipLevel ) > setResidentMip;
+        };
+
+        /// \param enable Texture2D streams textures that it loads after this. Default is false.
+        void SetEnabled( bool enable );
+
+        /// \return True if Texture2D streams textures.
+        bool IsEnabled();
+
+        /// \param pixels Texture2D loads mip levels up to this size up front. Default is 64.
+        void SetInitialMipSize( int pixels );
+
+        /// \param width Width of mip level 0 in pixels.
+        /// \param height Height of mip level 0 in pixels.
+        /// \param mipCount Mip level count.
+        /// \return Most detailed mip level whose larger side is at most the initial mip size. 0 if the texture is smaller.
+        int GetInitialResidentMip( int width, int height, int mipCount );
+
+        /// Registers a texture. Its mip levels from residentMip to the least detailed are resident.
+        /// \param description Texture.
+        /// \return Handle.
+        Handle Register( const Description& description );
+
+        /// Stops streaming a texture. Does not call setResidentMip, the caller releases the texture. A pending load is dropped when it finishes.
+        void Unregister( Handle handle );
+
+        /// \return True if the texture has been registered and not unregistered.
+        bool IsValid( Handle handle );
+
+        /// Reports that a texture is drawn this frame. Can be called many times per frame, the largest size is used.
+        /// \param handle Texture. Does nothing if the handle is not valid.
+        /// \param screenSizeInPixels Size on screen of the texture's larger side, e.g. the screen size of a mesh that the texture is mapped once across.
+        void ReportScreenSize( Handle handle, float screenSizeInPixels );
+
+        /// \param screenSizeInPixels Size on screen of the texture's larger side.
+        /// \return Mip level whose larger side is at least the screen size, or 0.
+        int GetDesiredMip( int width, int height, int mipCount, float screenSizeInPixels );
+
+        /// \return Most detailed resident mip level, or -1 if the handle is not valid.
+        int GetResidentMip( Handle handle );
+
+        /// \param budgetInBytes Update() keeps resident mip levels under this. Default is 256 MiB. Initial mip levels are resident even if they go over it.
+        void SetBudget( std::size_t budgetInBytes );
+
+        /// \return Budget in bytes.
+        std::size_t GetBudget();
+
+        /// \return Size of resident mip levels and of pending loads in bytes.
+        std::size_t GetMemoryUsage();
+
+        /// \param loadCount Update() doesn't start new loads while this many are pending. Default is 4.
+        void SetMaxPendingLoads( int loadCount );
+
+        /// \return Number of loads that have been started but not finished.
+        int GetPendingCount();
+
+        /// Evicts mip levels that are over the budget and starts loads of the blurriest textures that were reported this frame.
+        /// Called by the renderer after presenting a frame.
+        void Update();
+    }
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "Vec3.hpp"
+
+namespace ae3d
+{
+    /**
+      Compact vertex encodings used in .ae3d files. Positions are snorm16 relative to the submesh AABB,
+      normals and tangents are octahedral snorm16, texture coordinates are half floats,
+      colors and skin weights are unorm8 and bone indices are uint8. Converters write them with -quantize.
+      Vulkan uploads them as they are and vertex shaders decode them. D3D12 and Metal decode them in Mesh::Load.
+    */
+    namespace Quantization
+    {
+        /// Quantized VertexPTNTC, 24 bytes instead of 64.
+        struct VertexPTNTC
+        {
+            /// Snorm16 relative to submesh AABB. position[ 3 ] is tangent handedness, +32767 or -32767.
+            int16_t position[ 4 ];
+            /// Half floats.
+            uint16_t uv[ 2 ];
+            /// Octahedral snorm16.
+            int16_t normal[ 2 ];
+            /// Octahedral snorm16.
+            int16_t tangent[ 2 ];
+            /// Unorm8.
+            uint8_t color[ 4 ];
+        };
+
+        /// Quantized VertexPTN, 16 bytes instead of 32.
+        struct VertexPTN
+        {
+            /// Snorm16 relative to submesh AABB. position[ 3 ] is unused.
+            int16_t position[ 4 ];
+            /// Half floats.
+            uint16_t uv[ 2 ];
+            /// Octahedral snorm16.
+            int16_t normal[ 2 ];
+        };
+
+        /// Quantized VertexPTNTC_Skinned, 32 bytes instead of 96. Supports up to 256 joints.
+        struct VertexPTNTC_Skinned
+        {
+            /// Snorm16 relative to submesh AABB. position[ 3 ] is tangent handedness, +32767 or -32767.
+            int16_t position[ 4 ];
+            /// Half floats.
+            uint16_t uv[ 2 ];
+            /// Octahedral snorm16.
+            int16_t normal[ 2 ];
+            /// Octahedral snorm16.
+            int16_t tangent[ 2 ];
+            /// Unorm8.
+            uint8_t color[ 4 ];
+            /// Unorm8.
+            uint8_t weights[ 4 ];
+            /// Joint indices.
+            uint8_t bones[ 4 ];
+        };
+
+        static_assert( sizeof( VertexPTNTC ) == 24, "Quantized PTNTC size changed" );
+        static_assert( sizeof( VertexPTN ) == 16, "Quantized PTN size changed" );
+        static_assert( sizeof( VertexPTNTC_Skinned ) == 32, "Quantized PTNTC_Skinned size changed" );
+
+        /// \param f Value. Rounded to nearest even, overflows to infinity.
+        /// \return f as a half float.
+        inline uint16_t FloatToHalf( float f )
+        {
+            uint32_t bits;
+            memcpy( &bits, &f, sizeof( bits ) );
+
+            const uint32_t sign = (bits >> 16) & 0x8000;
+            const uint32_t floatExponent = (bits >> 23) & 0xFF;
+            uint32_t mantissa = bits & 0x7FFFFF;
+
+            if (floatExponent == 0xFF)
+            {
+                return (uint16_t)(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+            }
+
+            const int exponent = (int)floatExponent - 127 + 15;
+
+            if (exponent >= 31)
+            {
+                return (uint16_t)(sign | 0x7C00);
+            }
+
+            if (exponent <= 0)
+            {
+                if (exponent < -10)
+                {
+                    return (uint16_t)sign;
+                }
+
+                // Denormal.
+                mantissa |= 0x800000;
+                const uint32_t shift = (uint32_t)(14 - exponent);
+                uint32_t half = mantissa >> shift;
+                const uint32_t remainder = mantissa & ((1u << shift) - 1);
+                const uint32_t halfway = 1u << (shift - 1);
+
+                if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+                {
+                    ++half;
+                }
+
+                return (uint16_t)(sign | half);
+            }
+
+            uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+            const uint32_t remainder = mantissa & 0x1FFF;
+
+            // A carry into the exponent is the correctly rounded result.
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0))
+            {
+                ++half;
+            }
+
+            return (uint16_t)(sign | half);
+        }
+
+        /// \param half Half float.
+        /// \return half as a float.
+        inline float HalfToFloat( uint16_t half )
+        {
+            const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+            const uint32_t exponent = (half >> 10) & 0x1F;
+            const uint32_t mantissa = half & 0x3FF;
+
+            if (exponent == 0)
+            {
+                const float denormal = ldexpf( (float)mantissa, -24 );
+                return sign != 0 ? -denormal : denormal;
+            }
+
+            const uint32_t bits = exponent == 31 ? (sign | 0x7F800000 | (mantissa << 13)) : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+            float f;
+            memcpy( &f, &bits, sizeof( f ) );
+            return f;
+        }
+
+        /// \param f Value, clamped to [-1, 1].
+        /// \return f as snorm16.
+        inline int16_t FloatToSnorm16( float f )
+        {
+            f = f < -1 ? -1 : (f > 1 ? 1 : f);
+            return (int16_t)(f * 32767.0f + (f < 0 ? -0.5f : 0.5f));
+        }
+
+        /// \param s Snorm16.
+        /// \return s as a float in [-1, 1].
+        inline float Snorm16ToFloat( int16_t s )
+        {
+            const float f = s / 32767.0f;
+            return f < -1 ? -1 : f;
+        }
+
+        /// \param f Value, clamped to [0, 1].
+        /// \return f as unorm8.
+        inline uint8_t FloatToUnorm8( float f )
+        {
+            f = f < 0 ? 0 : (f > 1 ? 1 : f);
+            return (uint8_t)(f * 255.0f + 0.5f);
+        }
+
+        /// \param u Unorm8.
+        /// \return u as a float in [0, 1].
+        inline float Unorm8ToFloat( uint8_t u )
+        {
+            return u / 255.0f;
+        }
+
+        /// \param position Position inside [aabbMin, aabbMax].
+        /// \param aabbMin AABB min.
+        /// \param aabbMax AABB max.
+        /// \param outPosition Snorm16 position relative to the AABB.
+        inline void QuantizePosition( const Vec3& position, const Vec3& aabbMin, const Vec3& aabbMax, int16_t outPosition[ 3 ] )
+        {
+            const float p[ 3 ] = { position.x, position.y, position.z };
+            const float mins[ 3 ] = { aabbMin.x, aabbMin.y, aabbMin.z };
+            const float maxs[ 3 ] = { aabbMax.x, aabbMax.y, aabbMax.z };
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const float extent = maxs[ i ] - mins[ i ];
+                outPosition[ i ] = FloatToSnorm16( extent > 0 ? (p[ i ] - mins[ i ]) / extent * 2 - 1 : 0 );
+            }
+        }
+
+        /// \param position Snorm16 position relative to the AABB.
+        /// \param aabbMin AABB min.
+        /// \param aabbMax AABB max.
+        /// \return Position.
+        inline Vec3 DequantizePosition( const int16_t position[ 3 ], const Vec3& aabbMin, const Vec3& aabbMax )
+        {
+            const Vec3 halfExtent = (aabbMax - aabbMin) * 0.5f;
+            return Vec3( aabbMin.x + (Snorm16ToFloat( position[ 0 ] ) + 1) * halfExtent.x,
+                         aabbMin.y + (Snorm16ToFloat( position[ 1 ] ) + 1) * halfExtent.y,
+                         aabbMin.z + (Snorm16ToFloat( position[ 2 ] ) + 1) * halfExtent.z );
+        }
+
+        /// Vertex shaders decode positions as snorm * scale + offset, which equals DequantizePosition().
+        /// \param aabbMin AABB min.
+        /// \param aabbMax AABB max.
+        /// \param outScale Half of the AABB extent.
+        /// \param outOffset AABB center.
+        inline void GetPositionScaleOffset( const Vec3& aabbMin, const Vec3& aabbMax, Vec3& outScale, Vec3& outOffset )
+        {
+            outScale = (aabbMax - aabbMin) * 0.5f;
+            outOffset = aabbMin + outScale;
+        }
+
+        /// \param n Unit vector.
+        /// \param outEncoded Octahedral snorm16 encoding of n.
+        inline void OctahedralEncode( const Vec3& n, int16_t outEncoded[ 2 ] )
+        {
+            const float l1 = fabsf( n.x ) + fabsf( n.y ) + fabsf( n.z );
+
+            if (l1 == 0)
+            {
+                outEncoded[ 0 ] = outEncoded[ 1 ] = 0;
+                return;
+            }
+
+            float x = n.x / l1;
+            float y = n.y / l1;
+
+            if (n.z < 0)
+            {
+                const float ox = x;
+                x = (1 - fabsf( y )) * (ox >= 0 ? 1 : -1);
+                y = (1 - fabsf( ox )) * (y >= 0 ? 1 : -1);
+            }
+
+            outEncoded[ 0 ] = FloatToSnorm16( x );
+            outEncoded[ 1 ] = FloatToSnorm16( y );
+        }
+
+        /// \param encoded Octahedral snorm16.
+        /// \return Unit vector.
+        inline Vec3 OctahedralDecode( const int16_t encoded[ 2 ] )
+        {
+            float x = Snorm16ToFloat( encoded[ 0 ] );
+            float y = Snorm16ToFloat( encoded[ 1 ] );
+            const float z = 1 - fabsf( x ) - fabsf( y );
+
+            if (z < 0)
+            {
+                const float ox = x;
+                x = (1 - fabsf( y )) * (ox >= 0 ? 1 : -1);
+                y = (1 - fabsf( ox )) * (y >= 0 ? 1 : -1);
+            }
+
+            return Vec3( x, y, z ).Normalized();
+        }
+    }
+}
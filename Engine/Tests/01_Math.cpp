@@ -4,6 +4,7 @@
 #include "Matrix.hpp"
 #include "Quaternion.hpp"
 #include "Vec3.hpp"
+#include "VertexQuantization.hpp"
 
 using namespace ae3d;
 
@@ -398,6 +399,92 @@ bool TestArray4()
     return arr2[ 0 ] == 666;
 }
 
+bool TestQuantization()
+{
+    using namespace Quantization;
+
+    // Half floats have 11 significant bits, so round-trip relative error is at most 2^-11.
+    for (float f = -1000; f <= 1000; f += 0.37f)
+    {
+        if (std::abs( HalfToFloat( FloatToHalf( f ) ) - f ) > std::abs( f ) / 2048.0f + 1e-7f)
+        {
+            std::cerr << "Half round-trip error too big for " << f << std::endl;
+            return false;
+        }
+    }
+
+    if (HalfToFloat( FloatToHalf( 1e-6f ) ) <= 0 || HalfToFloat( FloatToHalf( 1e6f ) ) != HUGE_VALF || HalfToFloat( FloatToHalf( -2 ) ) != -2)
+    {
+        std::cerr << "Half denormal, overflow or sign failed" << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i <= 1000; ++i)
+    {
+        const float f = i / 500.0f - 1;
+
+        if (std::abs( Snorm16ToFloat( FloatToSnorm16( f ) ) - f ) > 0.5f / 32767 + 1e-7f ||
+            std::abs( Unorm8ToFloat( FloatToUnorm8( i / 1000.0f ) ) - i / 1000.0f ) > 0.5f / 255 + 1e-7f)
+        {
+            std::cerr << "Snorm16 or unorm8 round-trip error too big for " << f << std::endl;
+            return false;
+        }
+    }
+
+    // Position error is at most half a step of the AABB extent divided into 65534 steps.
+    const Vec3 aabbMin( -10, 0, 5 );
+    const Vec3 aabbMax( 30, 0.5f, 5 );
+    Vec3 scale, offset;
+    GetPositionScaleOffset( aabbMin, aabbMax, scale, offset );
+
+    for (int i = 0; i <= 100; ++i)
+    {
+        const Vec3 position = aabbMin + (aabbMax - aabbMin) * (i / 100.0f);
+        int16_t quantized[ 3 ];
+        QuantizePosition( position, aabbMin, aabbMax, quantized );
+        const Vec3 result = DequantizePosition( quantized, aabbMin, aabbMax );
+
+        if (std::abs( result.x - position.x ) > 40 / 65534.0f + 1e-5f || std::abs( result.y - position.y ) > 0.5f / 65534.0f + 1e-6f ||
+            result.z != position.z)
+        {
+            std::cerr << "Position round-trip error too big" << std::endl;
+            return false;
+        }
+
+        // Vertex shader decoding.
+        const Vec3 shaderResult( Snorm16ToFloat( quantized[ 0 ] ) * scale.x + offset.x, Snorm16ToFloat( quantized[ 1 ] ) * scale.y + offset.y,
+                                 Snorm16ToFloat( quantized[ 2 ] ) * scale.z + offset.z );
+
+        if (std::abs( shaderResult.x - result.x ) > 1e-5f || std::abs( shaderResult.y - result.y ) > 1e-6f || shaderResult.z != result.z)
+        {
+            std::cerr << "Position scale and offset don't match DequantizePosition" << std::endl;
+            return false;
+        }
+    }
+
+    // Octahedral snorm16 normals are within 0.05 degrees, including float rounding in the dot product.
+    const float minCosAngle = std::cos( 0.05f * 3.14159265f / 180 );
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        const float z = i / 999.5f - 1;
+        const float angle = i * 2.39996323f;
+        const float r = std::sqrt( std::max( 0.0f, 1 - z * z ) );
+        const Vec3 n( r * std::cos( angle ), r * std::sin( angle ), z );
+
+        int16_t encoded[ 2 ];
+        OctahedralEncode( n, encoded );
+
+        if (Vec3::Dot( n, OctahedralDecode( encoded ) ) < minCosAngle)
+        {
+            std::cerr << "Octahedral round-trip error too big for " << n.x << ", " << n.y << ", " << n.z << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
 int main()
 {
     bool result = true;
@@ -412,6 +499,7 @@ int main()
     result &= TestArray2();
     result &= TestArray3();
     result &= TestArray4();
+    result &= TestQuantization();
 
     assert( result && "Math tests failed!" );
     
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <vector>
 #include "AudioClip.hpp"
 #include "CameraComponent.hpp"
 #include "DirectionalLightComponent.hpp"
@@ -9,6 +10,7 @@
 #include "MeshRendererComponent.hpp"
 #include "PointLightComponent.hpp"
 #include "RenderTexture.hpp"
+#include "Scene.hpp"
 #include "Texture2D.hpp"
 #include "TextureCube.hpp"
 #include "SpriteRendererComponent.hpp"
@@ -260,6 +262,101 @@ bool TestGameObjectEnabling()
     return true;
 }
 
+static bool HasGameObjects( const Scene& scene, unsigned layerMask, const std::vector< GameObject* >& expected, const char* step )
+{
+    std::vector< GameObject* > gameObjects;
+    scene.GetGameObjectsInLayers( layerMask, gameObjects );
+
+    if (gameObjects != expected)
+    {
+        System::Print( "layer %u has wrong game objects after %s\n", layerMask, step );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestSceneLayers()
+{
+    GameObject a, b, c;
+    bool success = true;
+
+    {
+        Scene scene;
+        scene.Add( &a );
+        scene.Add( &b );
+        scene.Add( &c );
+        success &= HasGameObjects( scene, 1, { &a, &b, &c }, "adding" );
+
+        b.SetEnabled( false );
+        success &= HasGameObjects( scene, 1, { &a, &c }, "disabling" );
+
+        // Enabled objects are added after the others.
+        b.SetEnabled( true );
+        success &= HasGameObjects( scene, 1, { &a, &c, &b }, "enabling" );
+
+        a.SetLayer( 2 );
+        success &= HasGameObjects( scene, 1, { &c, &b }, "moving to another layer" );
+        success &= HasGameObjects( scene, 2, { &a }, "moving to another layer" );
+
+        // An object in many layers is returned once.
+        c.SetLayer( 1 | 2 );
+        success &= HasGameObjects( scene, 1 | 2, { &b, &c, &a }, "adding into two layers" );
+        success &= HasGameObjects( scene, 2, { &a, &c }, "adding into two layers" );
+
+        a.SetEnabled( false );
+        a.SetLayer( 4 );
+        success &= HasGameObjects( scene, 2 | 4, { &c }, "changing the layer of a disabled object" );
+
+        scene.Remove( &b );
+        success &= HasGameObjects( scene, 1, { &c }, "removing" );
+
+        // Removed objects in an unaffected scene stay.
+        Scene otherScene;
+        otherScene.Add( &b );
+        success &= HasGameObjects( otherScene, 1, { &b }, "adding into another scene" );
+        success &= HasGameObjects( scene, 1, { &c }, "adding into another scene" );
+    }
+
+    // Scenes are destroyed, so these must not touch them.
+    a.SetLayer( 8 );
+    a.SetEnabled( true );
+
+    if (a.GetLayer() != 8 || !a.IsEnabled())
+    {
+        System::Print( "layer or enabled state was not kept after scene was destroyed\n" );
+        success = false;
+    }
+
+    // Removing most objects compacts the layer list, which must keep the order.
+    GameObject many[ 10 ];
+    Scene scene;
+    std::vector< GameObject* > odd;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        scene.Add( &many[ i ] );
+
+        if (i % 2 == 1)
+        {
+            odd.push_back( &many[ i ] );
+        }
+    }
+
+    for (int i = 0; i < 10; i += 2)
+    {
+        many[ i ].SetEnabled( false );
+    }
+
+    many[ 1 ].SetEnabled( false );
+    many[ 1 ].SetEnabled( true );
+    odd.erase( std::begin( odd ) );
+    odd.push_back( &many[ 1 ] );
+    success &= HasGameObjects( scene, 1, odd, "compacting" );
+
+    return success;
+}
+
 int main()
 {
     Window::Create( 512, 512, WindowCreateFlags::Empty );
@@ -276,6 +373,7 @@ int main()
     success &= TestAddition();
     success &= TestGameObjectCopying();
     success &= TestGameObjectEnabling();
+    success &= TestSceneLayers();
     TestMissingFiles();
 
     return success ? 0 : 1;
@@ -0,0 +1,319 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Array.hpp"
+#include "FileSystem.hpp"
+#include "Mesh.hpp"
+#include "System.hpp"
+#include "Vec3.hpp"
+#include "VertexQuantization.hpp"
+#include "Window.hpp"
+
+// Measures Mesh::Load for large .ae3d v1 and v2 files that are built in memory
+// and tests that meshes loaded from the same path share their data and that CPU copies can be released.
+
+using namespace ae3d;
+
+struct VertexPTN
+{
+    float position[ 3 ];
+    float u, v;
+    float normal[ 3 ];
+};
+
+template< typename T >
+void Append( std::vector< unsigned char >& bytes, const T& value )
+{
+    const unsigned char* p = reinterpret_cast< const unsigned char* >( &value );
+    bytes.insert( bytes.end(), p, p + sizeof( T ) );
+}
+
+void Append( std::vector< unsigned char >& bytes, const void* data, std::size_t size )
+{
+    const unsigned char* p = static_cast< const unsigned char* >( data );
+    bytes.insert( bytes.end(), p, p + size );
+}
+
+void PadTo16( std::vector< unsigned char >& bytes )
+{
+    bytes.resize( (bytes.size() + 15) & ~std::size_t( 15 ), 0 );
+}
+
+// Grid of gridSize * gridSize vertices on the XZ plane.
+void MakeGrid( unsigned gridSize, std::vector< VertexPTN >& outVertices, std::vector< uint32_t >& outIndices )
+{
+    outVertices.resize( gridSize * gridSize );
+
+    for (unsigned z = 0; z < gridSize; ++z)
+    {
+        for (unsigned x = 0; x < gridSize; ++x)
+        {
+            VertexPTN& vertex = outVertices[ z * gridSize + x ];
+            vertex.position[ 0 ] = (float)x;
+            vertex.position[ 1 ] = 0;
+            vertex.position[ 2 ] = (float)z;
+            vertex.u = x / (float)gridSize;
+            vertex.v = z / (float)gridSize;
+            vertex.normal[ 0 ] = 0;
+            vertex.normal[ 1 ] = 1;
+            vertex.normal[ 2 ] = 0;
+        }
+    }
+
+    outIndices.clear();
+
+    for (unsigned z = 0; z < gridSize - 1; ++z)
+    {
+        for (unsigned x = 0; x < gridSize - 1; ++x)
+        {
+            const uint32_t i = z * gridSize + x;
+            const uint32_t quad[ 6 ] = { i, i + gridSize, i + 1, i + 1, i + gridSize, i + gridSize + 1 };
+            outIndices.insert( outIndices.end(), quad, quad + 6 );
+        }
+    }
+}
+
+std::vector< unsigned char > MakeVersion1( const std::vector< VertexPTN >& vertices, const std::vector< uint32_t >& indices, float extent )
+{
+    std::vector< unsigned char > bytes;
+    bytes.push_back( 'a' );
+    bytes.push_back( '9' );
+    const Vec3 aabbMin( 0, 0, 0 );
+    const Vec3 aabbMax( extent, 0, extent );
+    Append( bytes, aabbMin );
+    Append( bytes, aabbMax );
+    Append( bytes, uint16_t( 1 ) );
+    Append( bytes, aabbMin );
+    Append( bytes, aabbMax );
+    Append( bytes, uint16_t( 4 ) );
+    Append( bytes, "grid", 4 );
+    Append( bytes, uint16_t( vertices.size() ) );
+    Append( bytes, uint8_t( 1 ) );
+    Append( bytes, vertices.data(), vertices.size() * sizeof( VertexPTN ) );
+    Append( bytes, uint16_t( indices.size() / 3 ) );
+
+    for (uint32_t index : indices)
+    {
+        Append( bytes, uint16_t( index ) );
+    }
+
+    Append( bytes, uint8_t( 100 ) );
+    return bytes;
+}
+
+std::vector< unsigned char > MakeVersion2( const std::vector< VertexPTN >& vertices, const std::vector< uint32_t >& indices, float extent, bool quantize )
+{
+    const bool wideIndices = vertices.size() > 65535;
+    const uint32_t chunkCount = 4;
+    const uint32_t tableEnd = 16 + chunkCount * 16;
+
+    std::vector< unsigned char > bytes;
+    Append( bytes, "ae3d", 4 );
+    Append( bytes, uint32_t( 2 ) );
+    Append( bytes, chunkCount );
+    Append( bytes, uint32_t( 0 ) );
+    bytes.resize( tableEnd, 0 );
+
+    const Vec3 aabbMin( 0, 0, 0 );
+    const Vec3 aabbMax( extent, 0, extent );
+    uint32_t chunkOffsets[ chunkCount ];
+
+    chunkOffsets[ 0 ] = (uint32_t)bytes.size();
+    Append( bytes, aabbMin );
+    Append( bytes, aabbMax );
+    Append( bytes, uint32_t( 1 ) );
+    PadTo16( bytes );
+
+    chunkOffsets[ 1 ] = (uint32_t)bytes.size();
+    Append( bytes, aabbMin );
+    Append( bytes, aabbMax );
+    Append( bytes, uint32_t( quantize ? 4 : 1 ) ); // PTN
+    Append( bytes, uint32_t( vertices.size() ) );
+    Append( bytes, uint32_t( indices.size() / 3 ) );
+    Append( bytes, uint32_t( wideIndices ? 4 : 2 ) );
+    Append( bytes, uint32_t( 0 ) );
+    Append( bytes, uint32_t( 4 ) );
+    Append( bytes, "grid", 4 );
+    PadTo16( bytes );
+
+    chunkOffsets[ 2 ] = (uint32_t)bytes.size();
+
+    if (quantize)
+    {
+        for (const VertexPTN& vertex : vertices)
+        {
+            Quantization::VertexPTN quantized;
+            Quantization::QuantizePosition( Vec3( vertex.position[ 0 ], vertex.position[ 1 ], vertex.position[ 2 ] ), aabbMin, aabbMax, quantized.position );
+            quantized.position[ 3 ] = 0;
+            quantized.uv[ 0 ] = Quantization::FloatToHalf( vertex.u );
+            quantized.uv[ 1 ] = Quantization::FloatToHalf( vertex.v );
+            Quantization::OctahedralEncode( Vec3( vertex.normal[ 0 ], vertex.normal[ 1 ], vertex.normal[ 2 ] ), quantized.normal );
+            Append( bytes, quantized );
+        }
+    }
+    else
+    {
+        Append( bytes, vertices.data(), vertices.size() * sizeof( VertexPTN ) );
+    }
+
+    const uint32_t vertexChunkSize = (uint32_t)bytes.size() - chunkOffsets[ 2 ];
+    PadTo16( bytes );
+
+    chunkOffsets[ 3 ] = (uint32_t)bytes.size();
+
+    for (uint32_t index : indices)
+    {
+        if (wideIndices)
+        {
+            Append( bytes, index );
+        }
+        else
+        {
+            Append( bytes, uint16_t( index ) );
+        }
+    }
+
+    const uint32_t chunkSizes[ chunkCount ] = { 28, 48 + 4, vertexChunkSize,
+                                                uint32_t( indices.size() * (wideIndices ? 4 : 2) ) };
+    const char* chunkTypes[ chunkCount ] = { "MESH", "SUBM", "VERT", "INDX" };
+
+    for (uint32_t c = 0; c < chunkCount; ++c)
+    {
+        const uint32_t entry[ 4 ] = { 0, 0, chunkOffsets[ c ], chunkSizes[ c ] };
+        std::memcpy( &bytes[ 16 + c * 16 ], entry, sizeof( entry ) );
+        std::memcpy( &bytes[ 16 + c * 16 ], chunkTypes[ c ], 4 );
+    }
+
+    return bytes;
+}
+
+bool BenchmarkLoad( const char* label, const std::vector< unsigned char >& bytes, unsigned expectedFaceCount, int iterations )
+{
+    double totalMs = 0;
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        // Unique paths bypass the mesh cache.
+        FileSystem::FileContentsData contents;
+        contents.data = bytes;
+        contents.path = std::string( label ) + std::to_string( i ) + ".ae3d";
+        contents.isLoaded = true;
+
+        Mesh mesh;
+        const auto start = std::chrono::high_resolution_clock::now();
+        const Mesh::LoadResult result = mesh.Load( contents );
+        const auto end = std::chrono::high_resolution_clock::now();
+        totalMs += std::chrono::duration< double, std::milli >( end - start ).count();
+
+        if (result != Mesh::LoadResult::Success || mesh.GetSubMeshCount() != 1)
+        {
+            System::Print( "%s failed to load\n", label );
+            return false;
+        }
+    }
+
+    System::Print( "%s: %u triangles, %.2f MiB, %.3f ms per load\n", label, expectedFaceCount, bytes.size() / (1024.0 * 1024.0), totalMs / iterations );
+    return true;
+}
+
+bool TestSharedMeshData( const std::vector< unsigned char >& bytes )
+{
+    FileSystem::FileContentsData contents;
+    contents.data = bytes;
+    contents.path = "shared.ae3d";
+    contents.isLoaded = true;
+
+    FileSystem::FileContentsData corruptedContents = contents;
+    corruptedContents.data.assign( 16, 0 );
+
+    {
+        Mesh mesh1;
+        Mesh mesh2;
+
+        // mesh2 must get its data from mesh1, because its own data is corrupted.
+        if (mesh1.Load( contents ) != Mesh::LoadResult::Success || mesh2.Load( corruptedContents ) != Mesh::LoadResult::Success ||
+            mesh1.GetMemoryUsage() != mesh2.GetMemoryUsage() || mesh1.GetMemoryUsage() < bytes.size())
+        {
+            System::Print( "Mesh data was not shared\n" );
+            return false;
+        }
+
+        System::Statistics::PrintMeshMemoryUsage();
+    }
+
+    // The last user went away, so the data must not be cached anymore.
+    Mesh mesh3;
+
+    if (mesh3.Load( corruptedContents ) != Mesh::LoadResult::Corrupted)
+    {
+        System::Print( "Mesh data was not released\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestCpuData( const std::vector< unsigned char >& bytes, unsigned faceCount )
+{
+    const Mesh::CpuData policies[ 3 ] = { Mesh::CpuData::All, Mesh::CpuData::Positions, Mesh::CpuData::None };
+    const unsigned expectedVertexCounts[ 3 ] = { faceCount * 3, faceCount * 3, 0 };
+    const char* paths[ 3 ] = { "cpu_all.ae3d", "cpu_positions.ae3d", "cpu_none.ae3d" };
+    std::size_t previousMemoryUsage = ~std::size_t( 0 );
+    bool success = true;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        FileSystem::FileContentsData contents;
+        contents.data = bytes;
+        contents.path = paths[ i ];
+        contents.isLoaded = true;
+
+        Mesh::SetCpuData( policies[ i ] );
+        Mesh mesh;
+        mesh.Load( contents );
+
+        Array< Vec3 > triangles;
+        mesh.GetSubMeshFlattenedTriangles( 0, triangles );
+
+        if (triangles.count != expectedVertexCounts[ i ] || mesh.GetMemoryUsage() >= previousMemoryUsage)
+        {
+            System::Print( "CPU data policy %d failed\n", i );
+            success = false;
+        }
+
+        System::Print( "%s: %u KiB\n", paths[ i ], (unsigned)(mesh.GetMemoryUsage() / 1024) );
+        previousMemoryUsage = mesh.GetMemoryUsage();
+    }
+
+    Mesh::SetCpuData( Mesh::CpuData::All );
+    return success;
+}
+
+int main()
+{
+    Window::Create( 512, 512, WindowCreateFlags::Empty );
+    System::LoadBuiltinAssets();
+
+    bool success = true;
+
+    std::vector< VertexPTN > vertices;
+    std::vector< uint32_t > indices;
+
+    // v1 stores face count in 16 bits, so this is about the largest grid both versions can store.
+    MakeGrid( 181, vertices, indices );
+    success &= BenchmarkLoad( "v1 181x181", MakeVersion1( vertices, indices, 180 ), (unsigned)indices.size() / 3, 20 );
+    success &= BenchmarkLoad( "v2 181x181", MakeVersion2( vertices, indices, 180, false ), (unsigned)indices.size() / 3, 20 );
+    success &= BenchmarkLoad( "v2 quantized 181x181", MakeVersion2( vertices, indices, 180, true ), (unsigned)indices.size() / 3, 20 );
+    success &= TestSharedMeshData( MakeVersion2( vertices, indices, 180, false ) );
+    success &= TestCpuData( MakeVersion1( vertices, indices, 180 ), (unsigned)indices.size() / 3 );
+    success &= TestCpuData( MakeVersion2( vertices, indices, 180, false ), (unsigned)indices.size() / 3 );
+
+    // Needs 32-bit indices.
+    MakeGrid( 1024, vertices, indices );
+    success &= BenchmarkLoad( "v2 1024x1024", MakeVersion2( vertices, indices, 1023, false ), (unsigned)indices.size() / 3, 4 );
+    success &= BenchmarkLoad( "v2 quantized 1024x1024", MakeVersion2( vertices, indices, 1023, true ), (unsigned)indices.size() / 3, 4 );
+
+    return success ? 0 : 1;
+}
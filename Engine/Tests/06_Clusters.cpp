@@ -0,0 +1,269 @@
+// Tests cluster generation in Tools/common.hpp and per-cluster culling. Doesn't need a window or GPU.
+#include <iostream>
+#include <cassert>
+#include "../../Tools/common.hpp"
+#include "Frustum.hpp"
+#include "MeshCluster.hpp"
+
+static_assert( sizeof( Cluster ) == sizeof( ae3d::MeshCluster ), "Tool and engine cluster layouts differ" );
+
+// UV sphere with outward normals and counter-clockwise faces when seen from outside.
+static Mesh MakeSphere( int rings, int segments )
+{
+    Mesh mesh;
+
+    for (int r = 0; r <= rings; ++r)
+    {
+        const float theta = 3.14159265f * r / rings;
+
+        for (int s = 0; s <= segments; ++s)
+        {
+            const float phi = 2 * 3.14159265f * s / segments;
+            VertexPTNTC_Skinned vertex = {};
+            vertex.normal = ae3d::Vec3( std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi ) );
+            vertex.position = vertex.normal;
+            vertex.texCoord = TexCoord( s / (float)segments, r / (float)rings );
+            mesh.interleavedVertices.push_back( vertex );
+        }
+    }
+
+    for (int r = 0; r < rings; ++r)
+    {
+        for (int s = 0; s < segments; ++s)
+        {
+            const unsigned short i0 = (unsigned short)(r * (segments + 1) + s);
+            const unsigned short i1 = (unsigned short)(i0 + segments + 1);
+
+            if (r != 0)
+            {
+                mesh.indices.push_back( { i0, (unsigned short)(i0 + 1), i1 } );
+            }
+
+            if (r != rings - 1)
+            {
+                mesh.indices.push_back( { (unsigned short)(i0 + 1), (unsigned short)(i1 + 1), i1 } );
+            }
+        }
+    }
+
+    mesh.aabbMin = ae3d::Vec3( -1, -1, -1 );
+    mesh.aabbMax = ae3d::Vec3( 1, 1, 1 );
+    return mesh;
+}
+
+static ae3d::Vec3 FaceNormal( const Mesh& mesh, const VertexInd& face )
+{
+    const ae3d::Vec3& a = mesh.interleavedVertices[ face.a ].position;
+    const ae3d::Vec3& b = mesh.interleavedVertices[ face.b ].position;
+    const ae3d::Vec3& c = mesh.interleavedVertices[ face.c ].position;
+    return ae3d::Vec3::Cross( b - a, c - a ).Normalized();
+}
+
+static bool SameFace( const VertexInd& f1, const VertexInd& f2 )
+{
+    return f1.a == f2.a && f1.b == f2.b && f1.c == f2.c;
+}
+
+bool TestClusterGeneration()
+{
+    Mesh mesh = MakeSphere( 48, 96 );
+    const std::vector< VertexInd > originalIndices = mesh.indices;
+    mesh.BuildClusters();
+
+    if (mesh.indices.size() != originalIndices.size())
+    {
+        std::cerr << "Clustering changed the face count!" << std::endl;
+        return false;
+    }
+
+    std::vector< VertexInd > sortedOriginal = originalIndices;
+    std::vector< VertexInd > sortedClustered = mesh.indices;
+    auto less = []( const VertexInd& f1, const VertexInd& f2 ) { return f1.a != f2.a ? f1.a < f2.a : (f1.b != f2.b ? f1.b < f2.b : f1.c < f2.c); };
+    std::sort( sortedOriginal.begin(), sortedOriginal.end(), less );
+    std::sort( sortedClustered.begin(), sortedClustered.end(), less );
+
+    if (!std::equal( sortedOriginal.begin(), sortedOriginal.end(), sortedClustered.begin(), SameFace ))
+    {
+        std::cerr << "Clustering lost or duplicated faces!" << std::endl;
+        return false;
+    }
+
+    uint32_t nextFace = 0;
+    float radiusSum = 0;
+
+    for (const auto& cluster : mesh.clusters)
+    {
+        if (cluster.firstFace != nextFace || cluster.faceCount == 0 || cluster.faceCount > MaxClusterFaces)
+        {
+            std::cerr << "Cluster face range is invalid!" << std::endl;
+            return false;
+        }
+
+        nextFace += cluster.faceCount;
+        radiusSum += cluster.radius;
+        std::vector< unsigned short > vertices;
+
+        for (uint32_t f = cluster.firstFace; f < cluster.firstFace + cluster.faceCount; ++f)
+        {
+            const VertexInd& face = mesh.indices[ f ];
+
+            for (unsigned short v : { face.a, face.b, face.c })
+            {
+                if ((mesh.interleavedVertices[ v ].position - cluster.center).Length() > cluster.radius)
+                {
+                    std::cerr << "Cluster bounding sphere doesn't contain its vertices!" << std::endl;
+                    return false;
+                }
+
+                vertices.push_back( v );
+            }
+
+            if (ae3d::Vec3::Dot( FaceNormal( mesh, face ), cluster.coneAxis ) < cluster.coneCutoff)
+            {
+                std::cerr << "Cluster normal cone doesn't contain its face normals!" << std::endl;
+                return false;
+            }
+        }
+
+        std::sort( vertices.begin(), vertices.end() );
+
+        if (std::unique( vertices.begin(), vertices.end() ) - vertices.begin() > (int)MaxClusterVertices)
+        {
+            std::cerr << "Cluster has too many vertices!" << std::endl;
+            return false;
+        }
+    }
+
+    if (nextFace != mesh.indices.size())
+    {
+        std::cerr << "Clusters don't cover every face!" << std::endl;
+        return false;
+    }
+
+    // Compact clusters on a smooth mesh have tight cones and are much smaller than the mesh.
+    const float averageFaces = mesh.indices.size() / (float)mesh.clusters.size();
+    const float averageRadius = radiusSum / mesh.clusters.size();
+
+    if (averageFaces < 64 || averageRadius > 0.4f)
+    {
+        std::cerr << "Clusters are too small or too spread out: " << averageFaces << " faces, radius " << averageRadius << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool IsFaceInRanges( unsigned face, const std::vector< unsigned >& ranges )
+{
+    for (std::size_t r = 0; r < ranges.size(); r += 2)
+    {
+        if (face >= ranges[ r ] && face < ranges[ r + 1 ])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TestClusterCulling()
+{
+    Mesh mesh = MakeSphere( 48, 96 );
+    mesh.BuildClusters();
+
+    // The engine reads CLUS chunks written from these in place.
+    const ae3d::MeshCluster* clusters = reinterpret_cast< const ae3d::MeshCluster* >( mesh.clusters.data() );
+    const unsigned clusterCount = (unsigned)mesh.clusters.size();
+
+    // Looks at the sphere from +z. The frustum looks towards -zAxis.
+    const ae3d::Vec3 cameraPosition( 0, 0, 5 );
+    ae3d::Frustum frustum;
+    frustum.SetProjection( 45, 1, 0.1f, 100 );
+    frustum.Update( cameraPosition, ae3d::Vec3( 0, 0, 1 ) );
+
+    std::vector< unsigned > frustumRanges;
+    MathUtil::CullClusters( clusters, clusterCount, frustum, ae3d::Matrix44::identity, nullptr, frustumRanges );
+
+    if (frustumRanges.size() != 2 || frustumRanges[ 0 ] != 0 || frustumRanges[ 1 ] != mesh.indices.size())
+    {
+        std::cerr << "Frustum culling removed clusters of a fully visible mesh or didn't merge ranges!" << std::endl;
+        return false;
+    }
+
+    std::vector< unsigned > ranges;
+    MathUtil::CullClusters( clusters, clusterCount, frustum, ae3d::Matrix44::identity, &cameraPosition, ranges );
+    unsigned drawnFaces = 0;
+
+    for (std::size_t r = 0; r < ranges.size(); r += 2)
+    {
+        if (ranges[ r ] >= ranges[ r + 1 ] || (r > 0 && ranges[ r ] <= ranges[ r - 1 ]))
+        {
+            std::cerr << "Face ranges are not ordered and merged!" << std::endl;
+            return false;
+        }
+
+        drawnFaces += ranges[ r + 1 ] - ranges[ r ];
+    }
+
+    for (unsigned f = 0; f < mesh.indices.size(); ++f)
+    {
+        const ae3d::Vec3& a = mesh.interleavedVertices[ mesh.indices[ f ].a ].position;
+
+        if (ae3d::Vec3::Dot( FaceNormal( mesh, mesh.indices[ f ] ), cameraPosition - a ) > 0 && !IsFaceInRanges( f, ranges ))
+        {
+            std::cerr << "Backface culling removed a front-facing face!" << std::endl;
+            return false;
+        }
+    }
+
+    if (drawnFaces > mesh.indices.size() * 0.7f)
+    {
+        std::cerr << "Backface culling removed too few faces: " << drawnFaces << " / " << mesh.indices.size() << std::endl;
+        return false;
+    }
+
+    // Moves the sphere behind the camera.
+    ae3d::Matrix44 localToWorld;
+    localToWorld.SetTranslation( ae3d::Vec3( 0, 0, 10 ) );
+    ranges.clear();
+    MathUtil::CullClusters( clusters, clusterCount, frustum, localToWorld, nullptr, ranges );
+
+    if (!ranges.empty())
+    {
+        std::cerr << "Frustum culling didn't remove clusters behind the camera!" << std::endl;
+        return false;
+    }
+
+    // Scales and moves the sphere so that only its left side is inside the frustum.
+    localToWorld.MakeIdentity();
+    localToWorld.Scale( 20, 20, 20 );
+    localToWorld.SetTranslation( ae3d::Vec3( 25, 0, -20 ) );
+    ranges.clear();
+    MathUtil::CullClusters( clusters, clusterCount, frustum, localToWorld, nullptr, ranges );
+    drawnFaces = 0;
+
+    for (std::size_t r = 0; r < ranges.size(); r += 2)
+    {
+        drawnFaces += ranges[ r + 1 ] - ranges[ r ];
+    }
+
+    if (drawnFaces == 0 || drawnFaces > mesh.indices.size() / 2)
+    {
+        std::cerr << "Frustum culling of a partially visible mesh drew " << drawnFaces << " / " << mesh.indices.size() << " faces" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestClusterGeneration();
+    result &= TestClusterCulling();
+
+    assert( result && "Cluster tests failed!" );
+
+    return result ? 0 : 1;
+}
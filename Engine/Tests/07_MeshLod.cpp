@@ -0,0 +1,203 @@
+// Tests LOD generation in Tools/common.hpp and LOD selection. Doesn't need a window or GPU.
+#include <iostream>
+#include <cassert>
+#include "../../Tools/common.hpp"
+#include "MeshLod.hpp"
+
+static_assert( sizeof( Lod ) == sizeof( ae3d::MeshLod ), "Tool and engine LOD layouts differ" );
+
+// UV sphere with outward normals and counter-clockwise faces when seen from outside.
+// Vertices in columns 0 and segments share positions and form a texture coordinate seam.
+static Mesh MakeSphere( int rings, int segments )
+{
+    Mesh mesh;
+
+    for (int r = 0; r <= rings; ++r)
+    {
+        const float theta = 3.14159265f * r / rings;
+
+        for (int s = 0; s <= segments; ++s)
+        {
+            const float phi = 2 * 3.14159265f * s / segments;
+            VertexPTNTC_Skinned vertex = {};
+            vertex.normal = ae3d::Vec3( std::sin( theta ) * std::cos( phi ), std::cos( theta ), std::sin( theta ) * std::sin( phi ) );
+            vertex.position = vertex.normal;
+            vertex.texCoord = TexCoord( s / (float)segments, r / (float)rings );
+            mesh.interleavedVertices.push_back( vertex );
+        }
+    }
+
+    for (int r = 0; r < rings; ++r)
+    {
+        for (int s = 0; s < segments; ++s)
+        {
+            const unsigned short i0 = (unsigned short)(r * (segments + 1) + s);
+            const unsigned short i1 = (unsigned short)(i0 + segments + 1);
+
+            if (r != 0)
+            {
+                mesh.indices.push_back( { i0, (unsigned short)(i0 + 1), i1 } );
+            }
+
+            if (r != rings - 1)
+            {
+                mesh.indices.push_back( { (unsigned short)(i0 + 1), (unsigned short)(i1 + 1), i1 } );
+            }
+        }
+    }
+
+    mesh.aabbMin = ae3d::Vec3( -1, -1, -1 );
+    mesh.aabbMax = ae3d::Vec3( 1, 1, 1 );
+    return mesh;
+}
+
+static bool UsesVertex( const Mesh& mesh, const Lod& lod, unsigned short vertex )
+{
+    for (uint32_t f = lod.firstFace; f < lod.firstFace + lod.faceCount; ++f)
+    {
+        const VertexInd& face = mesh.indices[ f ];
+
+        if (face.a == vertex || face.b == vertex || face.c == vertex)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TestLodGeneration()
+{
+    const int rings = 32;
+    const int segments = 64;
+    Mesh mesh = MakeSphere( rings, segments );
+    const std::size_t originalFaceCount = mesh.indices.size();
+    mesh.GenerateLods( 3 );
+
+    if (mesh.lods.size() != 4)
+    {
+        std::cerr << "Expected 4 LODs, got " << mesh.lods.size() << std::endl;
+        return false;
+    }
+
+    if (mesh.lods[ 0 ].firstFace != 0 || mesh.lods[ 0 ].faceCount != originalFaceCount || mesh.lods[ 0 ].error != 0)
+    {
+        std::cerr << "LOD 0 is not the original mesh!" << std::endl;
+        return false;
+    }
+
+    uint32_t nextFace = 0;
+
+    for (std::size_t l = 0; l < mesh.lods.size(); ++l)
+    {
+        const Lod& lod = mesh.lods[ l ];
+
+        if (lod.firstFace != nextFace || lod.faceCount == 0)
+        {
+            std::cerr << "LOD " << l << " face range is invalid!" << std::endl;
+            return false;
+        }
+
+        nextFace += lod.faceCount;
+
+        if (l > 0 && (lod.faceCount > mesh.lods[ l - 1 ].faceCount * 0.6f || lod.error < mesh.lods[ l - 1 ].error))
+        {
+            std::cerr << "LOD " << l << " has " << lod.faceCount << " faces and error " << lod.error << ", previous has "
+                      << mesh.lods[ l - 1 ].faceCount << " faces and error " << mesh.lods[ l - 1 ].error << std::endl;
+            return false;
+        }
+
+        for (uint32_t f = lod.firstFace; f < lod.firstFace + lod.faceCount; ++f)
+        {
+            const VertexInd& face = mesh.indices[ f ];
+
+            if (face.a >= mesh.interleavedVertices.size() || face.b >= mesh.interleavedVertices.size() || face.c >= mesh.interleavedVertices.size() ||
+                face.a == face.b || face.b == face.c || face.a == face.c)
+            {
+                std::cerr << "LOD " << l << " has an invalid face!" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    if (nextFace != mesh.indices.size())
+    {
+        std::cerr << "LODs don't cover every face!" << std::endl;
+        return false;
+    }
+
+    if (mesh.lods[ 1 ].error <= 0 || mesh.lods.back().error > 0.5f)
+    {
+        std::cerr << "LOD errors are out of range: " << mesh.lods[ 1 ].error << ", " << mesh.lods.back().error << std::endl;
+        return false;
+    }
+
+    // Seam vertices are locked, so every LOD keeps them and the texture coordinate seam doesn't crack.
+    for (const Lod& lod : mesh.lods)
+    {
+        for (int r = 1; r < rings; ++r)
+        {
+            for (int s : { 0, segments })
+            {
+                if (!UsesVertex( mesh, lod, (unsigned short)(r * (segments + 1) + s) ))
+                {
+                    std::cerr << "A LOD lost a seam vertex!" << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool TestLodSelection()
+{
+    const float errors[] = { 0, 1, 2, 4 };
+    const int lodCount = 4;
+    const float maxError = 1;
+
+    // Without a current LOD, selects the coarsest LOD within maxError.
+    if (MathUtil::SelectLod( errors, lodCount, 1.0f, -1, maxError ) != 1 ||
+        MathUtil::SelectLod( errors, lodCount, 0.2f, -1, maxError ) != 3 ||
+        MathUtil::SelectLod( errors, lodCount, 1.2f, -1, maxError ) != 0)
+    {
+        std::cerr << "LOD selection without hysteresis failed!" << std::endl;
+        return false;
+    }
+
+    // Keeps the current LOD while it's slightly over maxError.
+    if (MathUtil::SelectLod( errors, lodCount, 1.2f, 1, maxError ) != 1)
+    {
+        std::cerr << "LOD selection switched to a finer LOD too early!" << std::endl;
+        return false;
+    }
+
+    // Switches to a coarser LOD only when it's clearly under maxError.
+    if (MathUtil::SelectLod( errors, lodCount, 0.2f, 2, maxError ) != 2 ||
+        MathUtil::SelectLod( errors, lodCount, 0.15f, 2, maxError ) != 3)
+    {
+        std::cerr << "LOD selection switched to a coarser LOD too early or not at all!" << std::endl;
+        return false;
+    }
+
+    if (MathUtil::SelectLod( errors, lodCount, 2.0f, 3, maxError ) != 0)
+    {
+        std::cerr << "LOD selection didn't leave a LOD whose error is too large!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestLodGeneration();
+    result &= TestLodSelection();
+
+    assert( result && "LOD tests failed!" );
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+// Tests AsyncLoader with loads that don't read files. Doesn't need a window or GPU.
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "AsyncLoader.hpp"
+
+using namespace ae3d;
+
+bool TestLoadAndFinish()
+{
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic< bool > loadedOnWorker( false );
+    bool finishedOnMain = false;
+    int result = 0;
+
+    const AsyncLoader::Handle handle = AsyncLoader::Queue(
+        [&]() { loadedOnWorker = std::this_thread::get_id() != mainThread; result = 42; return true; },
+        [&]( bool loaded ) { finishedOnMain = loaded && std::this_thread::get_id() == mainThread && result == 42; return true; } );
+
+    if (handle == 0 || AsyncLoader::GetState( handle ) != AsyncLoader::State::Pending)
+    {
+        std::cerr << "Queued load is not pending!" << std::endl;
+        return false;
+    }
+
+    AsyncLoader::Flush();
+
+    if (AsyncLoader::GetState( handle ) != AsyncLoader::State::Ready || !loadedOnWorker || !finishedOnMain)
+    {
+        std::cerr << "Load didn't run on a worker and finish on the calling thread!" << std::endl;
+        return false;
+    }
+
+    if (AsyncLoader::GetPendingCount() != 0)
+    {
+        std::cerr << "Flush left pending loads!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestFailure()
+{
+    bool finishSawFailure = false;
+    const AsyncLoader::Handle loadFails = AsyncLoader::Queue( []() { return false; }, [&]( bool loaded ) { finishSawFailure = !loaded; return loaded; } );
+    const AsyncLoader::Handle finishFails = AsyncLoader::Queue( []() { return true; }, []( bool ) { return false; } );
+    const AsyncLoader::Handle noFinish = AsyncLoader::Queue( []() { return false; }, nullptr );
+    AsyncLoader::Flush();
+
+    if (AsyncLoader::GetState( loadFails ) != AsyncLoader::State::Failed || !finishSawFailure ||
+        AsyncLoader::GetState( finishFails ) != AsyncLoader::State::Failed ||
+        AsyncLoader::GetState( noFinish ) != AsyncLoader::State::Failed)
+    {
+        std::cerr << "Failed loads are not marked as failed!" << std::endl;
+        return false;
+    }
+
+    if (AsyncLoader::GetState( 0 ) != AsyncLoader::State::Invalid || AsyncLoader::GetState( noFinish + 1000 ) != AsyncLoader::State::Invalid)
+    {
+        std::cerr << "Unknown handles are not invalid!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestBudget()
+{
+    const int loadCount = 8;
+    std::atomic< int > loadedCount( 0 );
+    AsyncLoader::Handle handles[ loadCount ];
+
+    for (int i = 0; i < loadCount; ++i)
+    {
+        handles[ i ] = AsyncLoader::Queue( [&]() { ++loadedCount; return true; },
+                                           []( bool ) { std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) ); return true; } );
+    }
+
+    while (loadedCount < loadCount)
+    {
+        std::this_thread::yield();
+    }
+
+    // A worker increments loadedCount just before handing the load over.
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+
+    // Each finish takes longer than the budget, so each update finishes one load.
+    for (int i = 0; i < loadCount; ++i)
+    {
+        if (AsyncLoader::Update( 1 ) != 1 || AsyncLoader::GetState( handles[ i ] ) != AsyncLoader::State::Ready)
+        {
+            std::cerr << "Update didn't stop at its budget!" << std::endl;
+            return false;
+        }
+    }
+
+    if (AsyncLoader::Update( 1 ) != 0)
+    {
+        std::cerr << "Update finished loads that didn't exist!" << std::endl;
+        return false;
+    }
+
+    // Without a load function the load is finished in the next update.
+    const AsyncLoader::Handle handle = AsyncLoader::Queue( nullptr, nullptr );
+
+    if (AsyncLoader::Update( 1 ) != 1 || AsyncLoader::GetState( handle ) != AsyncLoader::State::Ready)
+    {
+        std::cerr << "Load without a load function was not finished!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestWait()
+{
+    const int loadCount = 4;
+    std::atomic< int > loadedCount( 0 );
+    int finishedCount = 0;
+    AsyncLoader::Handle handles[ loadCount ];
+
+    for (int i = 0; i < loadCount; ++i)
+    {
+        handles[ i ] = AsyncLoader::Queue( [&]() { std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) ); ++loadedCount; return true; },
+                                           [&]( bool ) { ++finishedCount; return true; } );
+    }
+
+    AsyncLoader::Wait();
+
+    if (loadedCount != loadCount || finishedCount != 0 || AsyncLoader::GetState( handles[ 0 ] ) != AsyncLoader::State::Pending)
+    {
+        std::cerr << "Wait didn't wait for loads or finished them!" << std::endl;
+        return false;
+    }
+
+    AsyncLoader::Flush();
+
+    if (finishedCount != loadCount || AsyncLoader::GetState( handles[ loadCount - 1 ] ) != AsyncLoader::State::Ready)
+    {
+        std::cerr << "Loads were not finished after Wait!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestFinishHandles()
+{
+    std::atomic< bool > isOtherLoadBlocked( true );
+    bool isOtherFinished = false;
+    int finishedCount = 0;
+
+    // Started before the waited loads and still loading while they are finished.
+    const AsyncLoader::Handle other = AsyncLoader::Queue( [&]() { while (isOtherLoadBlocked) { std::this_thread::yield(); } return true; },
+                                                          [&]( bool ) { isOtherFinished = true; return true; } );
+    std::vector< AsyncLoader::Handle > handles;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        handles.push_back( AsyncLoader::Queue( []() { std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) ); return true; },
+                                               [&]( bool ) { ++finishedCount; return true; } ) );
+    }
+
+    AsyncLoader::Wait( handles );
+
+    if (finishedCount != 0 || AsyncLoader::GetState( handles[ 0 ] ) != AsyncLoader::State::Pending)
+    {
+        std::cerr << "Wait with handles finished loads!" << std::endl;
+        return false;
+    }
+
+    AsyncLoader::Finish( handles );
+
+    if (finishedCount != 3 || AsyncLoader::GetState( handles[ 2 ] ) != AsyncLoader::State::Ready || isOtherFinished ||
+        AsyncLoader::GetState( other ) != AsyncLoader::State::Pending)
+    {
+        std::cerr << "Finish didn't finish only the given loads!" << std::endl;
+        return false;
+    }
+
+    // Finished loads are skipped.
+    AsyncLoader::Finish( handles );
+    isOtherLoadBlocked = false;
+    AsyncLoader::Flush();
+
+    if (finishedCount != 3 || !isOtherFinished || AsyncLoader::GetState( other ) != AsyncLoader::State::Ready)
+    {
+        std::cerr << "Loads were finished twice or the other load was lost!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestDeinit()
+{
+    bool finished = false;
+    const AsyncLoader::Handle handle = AsyncLoader::Queue( []() { return true; }, [&]( bool ) { finished = true; return true; } );
+    AsyncLoader::Deinit();
+
+    if (finished || AsyncLoader::GetState( handle ) != AsyncLoader::State::Failed || AsyncLoader::GetPendingCount() != 0)
+    {
+        std::cerr << "Deinit didn't drop unfinished loads!" << std::endl;
+        return false;
+    }
+
+    // Queue starts workers again.
+    const AsyncLoader::Handle afterDeinit = AsyncLoader::Queue( []() { return true; }, nullptr );
+    AsyncLoader::Flush();
+
+    if (AsyncLoader::GetState( afterDeinit ) != AsyncLoader::State::Ready)
+    {
+        std::cerr << "Loading after Deinit failed!" << std::endl;
+        return false;
+    }
+
+    AsyncLoader::Deinit();
+    return true;
+}
+
+int main()
+{
+    AsyncLoader::Init( 2 );
+
+    bool result = true;
+
+    result &= TestLoadAndFinish();
+    result &= TestFailure();
+    result &= TestBudget();
+    result &= TestWait();
+    result &= TestFinishHandles();
+    result &= TestDeinit();
+
+    assert( result && "AsyncLoader tests failed!" );
+
+    return result ? 0 : 1;
+}
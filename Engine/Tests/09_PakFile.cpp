@@ -0,0 +1,332 @@
+// Tests .pak files and their compression written by Tools/CombineFiles and read by FileSystem. Doesn't need a window or GPU.
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../../Tools/CombineFiles/PakWriter.hpp"
+#include "FileSystem.hpp"
+#include "System.hpp"
+
+void ae3d::System::Print( const char*, ... )
+{
+}
+
+static std::string MakeContents( int index )
+{
+    return std::string( static_cast< std::size_t >( index * 37 % 300 ), static_cast< char >( 'a' + index % 26 ) ) + std::to_string( index );
+}
+
+static std::string MakePath( int index )
+{
+    return "pak_test_" + std::to_string( index ) + ".txt";
+}
+
+static bool WriteFiles( int fileCount )
+{
+    for (int i = 0; i < fileCount; ++i)
+    {
+        std::ofstream ofs( MakePath( i ), std::ios::binary );
+        ofs << MakeContents( i );
+
+        if (!ofs)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void RemoveFiles( int fileCount )
+{
+    for (int i = 0; i < fileCount; ++i)
+    {
+        std::remove( MakePath( i ).c_str() );
+    }
+}
+
+bool TestReadEntries()
+{
+    const int fileCount = 1000;
+
+    if (!WriteFiles( fileCount ))
+    {
+        std::cerr << "Could not write test files!" << std::endl;
+        return false;
+    }
+
+    std::vector< std::string > paths;
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        paths.push_back( MakePath( i ) );
+    }
+
+    const bool written = WritePakFile( paths, "pak_test.pak", []( const std::string& ) { return ae3d::Pak::CompressionLevel::None; } );
+    // Files must come from the .pak file.
+    RemoveFiles( fileCount );
+
+    if (!written)
+    {
+        std::cerr << "Could not write the .pak file!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::LoadPakFile( "pak_test.pak" );
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        const std::string expected = MakeContents( i );
+        const ae3d::FileSystem::PakEntry entry = ae3d::FileSystem::FindPakEntry( paths[ i ].c_str() );
+
+        if (!entry.isFound || entry.size != expected.size() || expected.compare( 0, expected.size(), reinterpret_cast< const char* >( entry.data ), entry.size ) != 0)
+        {
+            std::cerr << "Entry " << paths[ i ] << " has wrong contents!" << std::endl;
+            return false;
+        }
+
+        if (reinterpret_cast< std::uintptr_t >( entry.data ) % ae3d::Pak::DataAlignment != 0)
+        {
+            std::cerr << "Entry " << paths[ i ] << " is not aligned!" << std::endl;
+            return false;
+        }
+    }
+
+    const ae3d::FileSystem::FileContentsData contents = ae3d::FileSystem::FileContents( paths[ 7 ].c_str() );
+
+    if (!contents.isLoaded || std::string( contents.data.begin(), contents.data.end() ) != MakeContents( 7 ))
+    {
+        std::cerr << "FileContents didn't read from the .pak file!" << std::endl;
+        return false;
+    }
+
+    if (ae3d::FileSystem::FindPakEntry( "pak_test_1000.txt" ).isFound || ae3d::FileSystem::FindPakEntry( "pak_test_1.tx" ).isFound)
+    {
+        std::cerr << "Found an entry that is not in the .pak file!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::UnloadPakFile( "pak_test.pak" );
+
+    if (ae3d::FileSystem::FindPakEntry( paths[ 0 ].c_str() ).isFound || ae3d::FileSystem::FileContents( paths[ 0 ].c_str() ).isLoaded)
+    {
+        std::cerr << "Found an entry after unloading the .pak file!" << std::endl;
+        return false;
+    }
+
+    std::remove( "pak_test.pak" );
+    return true;
+}
+
+static std::string ReadEntry( const char* path )
+{
+    const ae3d::FileSystem::PakEntry entry = ae3d::FileSystem::FindPakEntry( path );
+    return entry.isFound ? std::string( reinterpret_cast< const char* >( entry.data ), entry.size ) : std::string();
+}
+
+bool TestLoadOrderAndCorruption()
+{
+    // Both .pak files contain the same path with different contents.
+    const std::string path = MakePath( 0 );
+    std::ofstream( path, std::ios::binary ) << "first";
+    const bool writtenFirst = WritePakFile( { path }, "pak_test_first.pak" );
+    std::ofstream( path, std::ios::binary ) << "second";
+    const bool writtenSecond = WritePakFile( { path }, "pak_test_second.pak" );
+    std::remove( path.c_str() );
+
+    if (!writtenFirst || !writtenSecond)
+    {
+        std::cerr << "Could not write the .pak files!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::LoadPakFile( "pak_test_first.pak" );
+    ae3d::FileSystem::LoadPakFile( "pak_test_second.pak" );
+    const std::string fromFirst = ReadEntry( path.c_str() );
+    ae3d::FileSystem::UnloadPakFile( "pak_test_first.pak" );
+    const std::string fromSecond = ReadEntry( path.c_str() );
+    ae3d::FileSystem::UnloadPakFile( "pak_test_second.pak" );
+
+    if (fromFirst != "first" || fromSecond != "second")
+    {
+        std::cerr << "Entries were not found in load order: " << fromFirst << ", " << fromSecond << std::endl;
+        return false;
+    }
+
+    // Truncated files are rejected.
+    std::ifstream second( "pak_test_second.pak", std::ios::binary );
+    const std::string secondData( (std::istreambuf_iterator< char >( second )), std::istreambuf_iterator< char >() );
+    std::ofstream( "pak_test_truncated.pak", std::ios::binary ).write( secondData.data(), 40 );
+    ae3d::FileSystem::LoadPakFile( "pak_test_truncated.pak" );
+    const bool foundInTruncated = ae3d::FileSystem::FindPakEntry( path.c_str() ).isFound;
+    ae3d::FileSystem::UnloadPakFile( "pak_test_truncated.pak" );
+
+    std::remove( "pak_test_first.pak" );
+    std::remove( "pak_test_second.pak" );
+    std::remove( "pak_test_truncated.pak" );
+
+    if (foundInTruncated)
+    {
+        std::cerr << "A truncated .pak file was loaded!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static std::vector< unsigned char > MakeCompressibleContents( std::size_t size )
+{
+    // Looks like vertex data: repeating layout with slowly changing values.
+    std::vector< unsigned char > contents( size );
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        contents[ i ] = static_cast< unsigned char >( i % 32 < 16 ? (i / 32) % 7 : i % 3 );
+    }
+
+    return contents;
+}
+
+static std::vector< unsigned char > MakeRandomContents( std::size_t size )
+{
+    std::vector< unsigned char > contents( size );
+    std::srand( 1 );
+
+    for (auto& value : contents)
+    {
+        value = static_cast< unsigned char >( std::rand() );
+    }
+
+    return contents;
+}
+
+static bool ReadsInChunks( const ae3d::FileSystem::PakEntry& entry, const std::vector< unsigned char >& expected, std::size_t chunkSize )
+{
+    std::vector< unsigned char > chunk( chunkSize );
+    std::vector< unsigned char > contents;
+
+    for (std::size_t offset = 0; offset < entry.size; offset += chunkSize)
+    {
+        const std::size_t readSize = ae3d::FileSystem::ReadPakEntry( entry, offset, chunk.data(), chunk.size() );
+
+        if (readSize != std::min( chunkSize, entry.size - offset ))
+        {
+            return false;
+        }
+
+        contents.insert( contents.end(), chunk.begin(), chunk.begin() + readSize );
+    }
+
+    return contents == expected;
+}
+
+bool TestCompressedEntries()
+{
+    // Not a multiple of the block size, so the last block is partial.
+    const std::vector< unsigned char > mesh = MakeCompressibleContents( 20 * ae3d::Pak::BlockSize + 1234 );
+    const std::vector< unsigned char > text = MakeCompressibleContents( 3 * ae3d::Pak::BlockSize );
+    const std::vector< unsigned char > noise = MakeRandomContents( 2 * ae3d::Pak::BlockSize + 5 );
+    const std::vector< std::string > paths = { "pak_test_mesh.ae3d", "pak_test_text.txt", "pak_test_image.png", "pak_test_noise.bin" };
+    const std::vector< unsigned char >* contents[] = { &mesh, &text, &noise, &noise };
+
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        std::ofstream( paths[ i ], std::ios::binary ).write( reinterpret_cast< const char* >( contents[ i ]->data() ), contents[ i ]->size() );
+    }
+
+    const bool written = WritePakFile( paths, "pak_test_compressed.pak" );
+
+    for (const auto& path : paths)
+    {
+        std::remove( path.c_str() );
+    }
+
+    if (!written)
+    {
+        std::cerr << "Could not write the compressed .pak file!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::LoadPakFile( "pak_test_compressed.pak" );
+    const ae3d::FileSystem::PakEntry meshEntry = ae3d::FileSystem::FindPakEntry( paths[ 0 ].c_str() );
+    const ae3d::FileSystem::PakEntry textEntry = ae3d::FileSystem::FindPakEntry( paths[ 1 ].c_str() );
+    const ae3d::FileSystem::PakEntry imageEntry = ae3d::FileSystem::FindPakEntry( paths[ 2 ].c_str() );
+    const ae3d::FileSystem::PakEntry noiseEntry = ae3d::FileSystem::FindPakEntry( paths[ 3 ].c_str() );
+
+    // Already compressed file types and data that doesn't compress are stored as is and read in place.
+    if (meshEntry.blockSize == 0 || meshEntry.data != nullptr || meshEntry.storedSize >= mesh.size() / 2 || textEntry.blockSize == 0 ||
+        imageEntry.blockSize != 0 || imageEntry.data == nullptr || noiseEntry.blockSize != 0 || noiseEntry.data == nullptr)
+    {
+        std::cerr << "Entries were not compressed by their type!" << std::endl;
+        return false;
+    }
+
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        const ae3d::FileSystem::FileContentsData fileContents = ae3d::FileSystem::FileContents( paths[ i ].c_str() );
+
+        if (!fileContents.isLoaded || fileContents.data != *contents[ i ])
+        {
+            std::cerr << "Entry " << paths[ i ] << " has wrong contents!" << std::endl;
+            return false;
+        }
+    }
+
+    // Chunks that start and end inside blocks and chunks that span many blocks.
+    if (!ReadsInChunks( meshEntry, mesh, 10000 ) || !ReadsInChunks( meshEntry, mesh, 5 * ae3d::Pak::BlockSize + 7 ) || !ReadsInChunks( noiseEntry, noise, 10000 ))
+    {
+        std::cerr << "Reading entries in chunks failed!" << std::endl;
+        return false;
+    }
+
+    unsigned char byte = 0;
+
+    if (ae3d::FileSystem::ReadPakEntry( meshEntry, mesh.size(), &byte, 1 ) != 0)
+    {
+        std::cerr << "Read past the end of an entry!" << std::endl;
+        return false;
+    }
+
+    // Corrupted blocks are detected when they are read.
+    const std::size_t blockCount = static_cast< std::size_t >( ae3d::Pak::GetBlockCount( meshEntry.size, meshEntry.blockSize ) );
+    std::vector< unsigned char > corrupted( meshEntry.storedData, meshEntry.storedData + meshEntry.storedSize );
+    ae3d::FileSystem::PakEntry corruptedEntry = meshEntry;
+    corruptedEntry.storedData = corrupted.data();
+    std::vector< unsigned char > result( mesh.size() );
+
+    std::memset( corrupted.data() + blockCount * sizeof( uint64_t ), 0xFF, 64 );
+    const std::size_t corruptedBlockSize = ae3d::FileSystem::ReadPakEntry( corruptedEntry, 0, result.data(), result.size() );
+
+    const uint64_t hugeOffset = ~0ull;
+    std::memcpy( corrupted.data() + sizeof( uint64_t ), &hugeOffset, sizeof( hugeOffset ) );
+    const std::size_t corruptedOffsetSize = ae3d::FileSystem::ReadPakEntry( corruptedEntry, ae3d::Pak::BlockSize, result.data(), result.size() );
+
+    ae3d::FileSystem::UnloadPakFile( "pak_test_compressed.pak" );
+    std::remove( "pak_test_compressed.pak" );
+
+    if (corruptedBlockSize != 0 || corruptedOffsetSize != 0)
+    {
+        std::cerr << "Corrupted compressed data was read!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestReadEntries();
+    result &= TestLoadOrderAndCorruption();
+    result &= TestCompressedEntries();
+
+    assert( result && "Pak file tests failed!" );
+
+    return result ? 0 : 1;
+}
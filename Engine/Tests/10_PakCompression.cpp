@@ -0,0 +1,244 @@
+// Measures load throughput of compressed .pak files against uncompressed ones. Doesn't need a window or GPU.
+// On Linux the .pak file is evicted from the page cache before the first read, so it's read from disk.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../../Tools/CombineFiles/PakWriter.hpp"
+#include "FileSystem.hpp"
+#include "System.hpp"
+#if __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void ae3d::System::Print( const char*, ... )
+{
+}
+
+struct TestFile
+{
+    std::string path;
+    std::vector< unsigned char > contents;
+};
+
+template< typename T >
+static void Append( std::vector< unsigned char >& bytes, const T& value )
+{
+    const unsigned char* p = reinterpret_cast< const unsigned char* >( &value );
+    bytes.insert( bytes.end(), p, p + sizeof( T ) );
+}
+
+// Position, UV and normal of a wavy grid.
+static std::vector< unsigned char > MakeMesh( int gridSize )
+{
+    std::vector< unsigned char > bytes;
+
+    for (int z = 0; z < gridSize; ++z)
+    {
+        for (int x = 0; x < gridSize; ++x)
+        {
+            const float y = std::sin( x * 0.1f ) * std::cos( z * 0.1f );
+            const float vertex[ 8 ] = { (float)x, y, (float)z, x / (float)gridSize, z / (float)gridSize, 0, 1, 0 };
+            Append( bytes, vertex );
+        }
+    }
+
+    return bytes;
+}
+
+// RGBA gradient with some noise.
+static std::vector< unsigned char > MakeImage( int size )
+{
+    std::vector< unsigned char > bytes( size * size * 4 );
+
+    for (int i = 0; i < size * size; ++i)
+    {
+        const int x = i % size;
+        const int y = i / size;
+        bytes[ i * 4 + 0 ] = static_cast< unsigned char >( x + (std::rand() & 3) );
+        bytes[ i * 4 + 1 ] = static_cast< unsigned char >( y );
+        bytes[ i * 4 + 2 ] = static_cast< unsigned char >( (x ^ y) & 0xF0 );
+        bytes[ i * 4 + 3 ] = 255;
+    }
+
+    return bytes;
+}
+
+static std::vector< unsigned char > MakeText( int lineCount )
+{
+    std::string text;
+
+    for (int i = 0; i < lineCount; ++i)
+    {
+        text += "v " + std::to_string( (i % 1000) * 0.25f ) + " " + std::to_string( i / 1000 ) + " 0.000000\n";
+    }
+
+    return std::vector< unsigned char >( text.begin(), text.end() );
+}
+
+static std::vector< unsigned char > MakeNoise( std::size_t size )
+{
+    std::vector< unsigned char > bytes( size );
+
+    for (auto& value : bytes)
+    {
+        value = static_cast< unsigned char >( std::rand() );
+    }
+
+    return bytes;
+}
+
+static void EvictFromPageCache( const char* path )
+{
+#if __linux__
+    const int file = open( path, O_RDONLY );
+
+    if (file != -1)
+    {
+        // Pages must be written before they can be evicted.
+        fdatasync( file );
+        posix_fadvise( file, 0, 0, POSIX_FADV_DONTNEED );
+        close( file );
+    }
+#else
+    (void)path;
+#endif
+}
+
+static long GetFileSize( const char* path )
+{
+    std::ifstream ifs( path, std::ios::binary | std::ios::ate );
+    return ifs.is_open() ? static_cast< long >( ifs.tellg() ) : 0;
+}
+
+static ae3d::Pak::CompressionLevel StoreAll( const std::string& )
+{
+    return ae3d::Pak::CompressionLevel::None;
+}
+
+static ae3d::Pak::CompressionLevel CompressAllFast( const std::string& )
+{
+    return ae3d::Pak::CompressionLevel::Fast;
+}
+
+static ae3d::Pak::CompressionLevel CompressAllHigh( const std::string& )
+{
+    return ae3d::Pak::CompressionLevel::High;
+}
+
+// Reads every entry into a caller-provided buffer and returns milliseconds.
+static double ReadEntries( const std::vector< TestFile >& files, std::vector< unsigned char >& buffer, bool& outIsValid )
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (const auto& file : files)
+    {
+        const ae3d::FileSystem::PakEntry entry = ae3d::FileSystem::FindPakEntry( file.path.c_str() );
+        outIsValid &= entry.isFound && ae3d::FileSystem::ReadPakEntry( entry, 0, buffer.data(), buffer.size() ) == file.contents.size();
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    for (const auto& file : files)
+    {
+        const ae3d::FileSystem::PakEntry entry = ae3d::FileSystem::FindPakEntry( file.path.c_str() );
+        ae3d::FileSystem::ReadPakEntry( entry, 0, buffer.data(), buffer.size() );
+        outIsValid &= std::equal( file.contents.begin(), file.contents.end(), buffer.begin() );
+    }
+
+    return std::chrono::duration< double, std::milli >( end - start ).count();
+}
+
+int main()
+{
+    std::srand( 1 );
+
+    std::vector< TestFile > files;
+    files.push_back( { "bench_mesh.ae3d", MakeMesh( 600 ) } );
+    files.push_back( { "bench_image.tga", MakeImage( 1024 ) } );
+    files.push_back( { "bench_scene.obj", MakeText( 150000 ) } );
+    files.push_back( { "bench_noise.bin", MakeNoise( 2 * 1024 * 1024 ) } );
+
+    std::vector< std::string > paths;
+    std::size_t totalSize = 0;
+    std::size_t largestSize = 0;
+
+    for (const auto& file : files)
+    {
+        std::ofstream( file.path, std::ios::binary ).write( reinterpret_cast< const char* >( file.contents.data() ), file.contents.size() );
+        paths.push_back( file.path );
+        totalSize += file.contents.size();
+        largestSize = std::max( largestSize, file.contents.size() );
+    }
+
+    struct Variant
+    {
+        const char* name;
+        const char* pakPath;
+        ae3d::Pak::CompressionLevel (*getCompression)( const std::string& );
+    };
+
+    const Variant variants[] =
+    {
+        { "uncompressed", "bench_none.pak", StoreAll },
+        { "fast", "bench_fast.pak", CompressAllFast },
+        { "high", "bench_high.pak", CompressAllHigh },
+        { "by file type", "bench_type.pak", GetPakCompression },
+    };
+
+    const int iterations = 10;
+    const double mib = 1024.0 * 1024.0;
+    std::vector< unsigned char > buffer( largestSize );
+    bool isValid = true;
+
+    std::printf( "%.2f MiB in %u files\n", totalSize / mib, (unsigned)files.size() );
+
+    for (const auto& variant : variants)
+    {
+        const auto writeStart = std::chrono::high_resolution_clock::now();
+
+        if (!WritePakFile( paths, variant.pakPath, variant.getCompression ))
+        {
+            std::printf( "Could not write %s\n", variant.pakPath );
+            isValid = false;
+            continue;
+        }
+
+        const auto writeEnd = std::chrono::high_resolution_clock::now();
+        const double writeMs = std::chrono::duration< double, std::milli >( writeEnd - writeStart ).count();
+
+        EvictFromPageCache( variant.pakPath );
+        ae3d::FileSystem::LoadPakFile( variant.pakPath );
+        const double coldMs = ReadEntries( files, buffer, isValid );
+        double warmMs = 0;
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            warmMs += ReadEntries( files, buffer, isValid );
+        }
+
+        warmMs /= iterations;
+        ae3d::FileSystem::UnloadPakFile( variant.pakPath );
+
+        const long pakSize = GetFileSize( variant.pakPath );
+        std::printf( "%-12s: %7.2f MiB (%5.1f %%), written in %8.1f ms, cold read %7.2f ms (%7.1f MiB/s), warm read %7.2f ms (%7.1f MiB/s)\n",
+                     variant.name, pakSize / mib, 100.0 * pakSize / totalSize, writeMs, coldMs, totalSize / mib / (coldMs / 1000), warmMs, totalSize / mib / (warmMs / 1000) );
+        std::remove( variant.pakPath );
+    }
+
+    for (const auto& path : paths)
+    {
+        std::remove( path.c_str() );
+    }
+
+    if (!isValid)
+    {
+        std::printf( "Read entries have wrong contents!\n" );
+    }
+
+    return isValid ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Tests FileSystem::FileView and FileSystem::FileReader with plain files and .pak files. Doesn't need a window or GPU.
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../Tools/CombineFiles/PakWriter.hpp"
+#include "FileSystem.hpp"
+#include "System.hpp"
+
+void ae3d::System::Print( const char*, ... )
+{
+}
+
+static std::vector< unsigned char > MakeContents( std::size_t size )
+{
+    std::vector< unsigned char > contents( size );
+
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        contents[ i ] = static_cast< unsigned char >( (i / 64) % 5 + i % 3 );
+    }
+
+    return contents;
+}
+
+static void WriteFile( const char* path, const std::vector< unsigned char >& contents )
+{
+    std::ofstream( path, std::ios::binary ).write( reinterpret_cast< const char* >( contents.data() ), contents.size() );
+}
+
+static bool HasContents( const ae3d::FileSystem::FileView& view, const std::vector< unsigned char >& expected )
+{
+    return view.IsLoaded() && view.GetSize() == expected.size() && (expected.empty() || std::equal( expected.begin(), expected.end(), view.GetData() ));
+}
+
+static bool ReadsInChunks( const char* path, const std::vector< unsigned char >& expected, std::size_t chunkSize )
+{
+    ae3d::FileSystem::FileReader reader;
+
+    if (!reader.Open( path ) || reader.GetSize() != expected.size())
+    {
+        return false;
+    }
+
+    std::vector< unsigned char > chunk( chunkSize );
+    std::vector< unsigned char > contents;
+    std::size_t readSize = 0;
+
+    while ((readSize = reader.Read( chunk.data(), chunk.size() )) > 0)
+    {
+        contents.insert( contents.end(), chunk.begin(), chunk.begin() + readSize );
+    }
+
+    if (contents != expected || reader.GetPosition() != expected.size())
+    {
+        return false;
+    }
+
+    // Reads the last byte again.
+    unsigned char lastByte = 0;
+    return expected.empty() || (reader.Seek( expected.size() - 1 ) && reader.Read( &lastByte, 1 ) == 1 && lastByte == expected.back() && !reader.Seek( expected.size() + 1 ));
+}
+
+bool TestPlainFiles()
+{
+    const std::vector< unsigned char > contents = MakeContents( 100000 );
+    WriteFile( "view_test.bin", contents );
+    WriteFile( "view_test_empty.bin", {} );
+
+    ae3d::FileSystem::FileView view = ae3d::FileSystem::OpenFileView( "view_test.bin" );
+    const ae3d::FileSystem::FileView emptyView = ae3d::FileSystem::OpenFileView( "view_test_empty.bin" );
+    const ae3d::FileSystem::FileView missingView = ae3d::FileSystem::OpenFileView( "view_test_missing.bin" );
+
+    if (!HasContents( view, contents ) || !view.IsInPlace() || !HasContents( emptyView, {} ) || missingView.IsLoaded())
+    {
+        std::cerr << "Views of plain files are wrong!" << std::endl;
+        return false;
+    }
+
+    // Moving keeps the mapping.
+    const unsigned char* data = view.GetData();
+    ae3d::FileSystem::FileView movedView = std::move( view );
+
+    if (movedView.GetData() != data || !HasContents( movedView, contents ) || view.IsLoaded() || view.GetData() != nullptr)
+    {
+        std::cerr << "Moving a view failed!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::FileReader missingReader;
+
+    if (!ReadsInChunks( "view_test.bin", contents, 4096 ) || !ReadsInChunks( "view_test.bin", contents, 1000000 ) ||
+        !ReadsInChunks( "view_test_empty.bin", {}, 16 ) || missingReader.Open( "view_test_missing.bin" ) || missingReader.IsOpen())
+    {
+        std::cerr << "Reading plain files in chunks failed!" << std::endl;
+        return false;
+    }
+
+    std::remove( "view_test.bin" );
+    std::remove( "view_test_empty.bin" );
+    return true;
+}
+
+bool TestPakFiles()
+{
+    const std::vector< unsigned char > stored = MakeContents( 3000 );
+    const std::vector< unsigned char > compressed = MakeContents( 5 * ae3d::Pak::BlockSize + 100 );
+    WriteFile( "view_test_stored.png", stored );
+    WriteFile( "view_test_compressed.ae3d", compressed );
+
+    const bool written = WritePakFile( { "view_test_stored.png", "view_test_compressed.ae3d" }, "view_test.pak" );
+    std::remove( "view_test_stored.png" );
+    std::remove( "view_test_compressed.ae3d" );
+
+    if (!written)
+    {
+        std::cerr << "Could not write the .pak file!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::LoadPakFile( "view_test.pak" );
+
+    // Uncompressed entries are read in place from the mapped .pak file.
+    const ae3d::FileSystem::FileView storedView = ae3d::FileSystem::OpenFileView( "view_test_stored.png" );
+    const ae3d::FileSystem::FileView compressedView = ae3d::FileSystem::OpenFileView( "view_test_compressed.ae3d" );
+
+    if (!HasContents( storedView, stored ) || !storedView.IsInPlace() || storedView.GetData() != ae3d::FileSystem::FindPakEntry( "view_test_stored.png" ).data ||
+        !HasContents( compressedView, compressed ) || compressedView.IsInPlace())
+    {
+        std::cerr << "Views of .pak entries are wrong!" << std::endl;
+        return false;
+    }
+
+    // Chunks that are and are not multiples of the block size.
+    if (!ReadsInChunks( "view_test_stored.png", stored, 1000 ) || !ReadsInChunks( "view_test_compressed.ae3d", compressed, ae3d::Pak::BlockSize ) ||
+        !ReadsInChunks( "view_test_compressed.ae3d", compressed, 12345 ))
+    {
+        std::cerr << "Reading .pak entries in chunks failed!" << std::endl;
+        return false;
+    }
+
+    ae3d::FileSystem::UnloadPakFile( "view_test.pak" );
+    std::remove( "view_test.pak" );
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestPlainFiles();
+    result &= TestPakFiles();
+
+    assert( result && "FileView tests failed!" );
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// Tests that FileWatcher reports changed files once after they stop changing. Doesn't need a window or GPU.
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#if _WIN32
+#include <sys/utime.h>
+#define utime _utime
+#define utimbuf _utimbuf
+#else
+#include <utime.h>
+#endif
+#include "FileWatcher.hpp"
+
+namespace
+{
+    std::vector< std::string > changedPaths;
+}
+
+static void OnChanged( const std::string& path )
+{
+    changedPaths.push_back( path );
+}
+
+// Modification times of polled files have a resolution of a second, so files are made older than the writes in tests.
+static void WriteOldFile( const char* path )
+{
+    std::ofstream( path ) << "original";
+    const std::time_t past = std::time( nullptr ) - 60;
+    utimbuf times = { past, past };
+    utime( path, &times );
+}
+
+static void Sleep( int milliseconds )
+{
+    std::this_thread::sleep_for( std::chrono::milliseconds( milliseconds ) );
+}
+
+bool TestDebounce()
+{
+    WriteOldFile( "watch_test_a.txt" );
+    WriteOldFile( "watch_test_b.txt" );
+
+    ae3d::FileWatcher watcher;
+    watcher.SetDebounceTime( 200 );
+    watcher.AddFile( "watch_test_a.txt", OnChanged );
+    watcher.AddFile( "watch_test_b.txt", OnChanged );
+    watcher.Poll();
+
+    if (!changedPaths.empty())
+    {
+        std::cerr << "Files were reported before they changed!" << std::endl;
+        return false;
+    }
+
+    // Many writes are reported once after they stop.
+    for (int i = 0; i < 5; ++i)
+    {
+        std::ofstream( "watch_test_a.txt" ) << "change " << i;
+        watcher.Poll();
+    }
+
+    const bool reportedTooEarly = !changedPaths.empty();
+    Sleep( 300 );
+    watcher.Poll();
+    watcher.Poll();
+
+    if (reportedTooEarly || changedPaths.size() != 1 || changedPaths[ 0 ] != "watch_test_a.txt")
+    {
+        std::cerr << "Changes were not reported once after they stopped!" << std::endl;
+        return false;
+    }
+
+    // Replacing a file by renaming another file over it is a change.
+    changedPaths.clear();
+    std::ofstream( "watch_test_b.tmp" ) << "renamed";
+    std::remove( "watch_test_b.txt" );
+    std::rename( "watch_test_b.tmp", "watch_test_b.txt" );
+    // Changes are timed from the poll that sees them.
+    watcher.Poll();
+    Sleep( 300 );
+    watcher.Poll();
+
+    std::remove( "watch_test_a.txt" );
+    std::remove( "watch_test_b.txt" );
+
+    if (changedPaths.size() != 1 || changedPaths[ 0 ] != "watch_test_b.txt")
+    {
+        std::cerr << "Renamed file was not reported!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestManyFiles()
+{
+    const int fileCount = 2000;
+    std::vector< std::string > paths;
+    ae3d::FileWatcher watcher;
+    watcher.SetDebounceTime( 0 );
+
+    for (int i = 0; i < fileCount; ++i)
+    {
+        paths.push_back( "watch_test_many_" + std::to_string( i ) + ".txt" );
+        WriteOldFile( paths.back().c_str() );
+        watcher.AddFile( paths.back(), OnChanged );
+    }
+
+    // Creating the files was a change.
+    watcher.Poll();
+    changedPaths.clear();
+
+    const int pollCount = 100;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < pollCount; ++i)
+    {
+        watcher.Poll();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "Poll with " << fileCount << " watched files: " << std::chrono::duration< double, std::micro >( end - start ).count() / pollCount << " us" << std::endl;
+
+    std::ofstream( paths[ 1234 ] ) << "changed";
+    watcher.Poll();
+
+    for (const auto& path : paths)
+    {
+        std::remove( path.c_str() );
+    }
+
+    if (changedPaths.size() != 1 || changedPaths[ 0 ] != paths[ 1234 ])
+    {
+        std::cerr << "Changed file was not found among many files!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestDebounce();
+    result &= TestManyFiles();
+
+    assert( result && "FileWatcher tests failed!" );
+
+    return result ? 0 : 1;
+}
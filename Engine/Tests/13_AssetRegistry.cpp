@@ -0,0 +1,193 @@
+// Tests AssetRegistry reference counting, budget eviction and deferred release. Doesn't need a window or GPU.
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "AssetRegistry.hpp"
+#include "System.hpp"
+
+using namespace ae3d;
+
+void ae3d::System::Print( const char*, ... )
+{
+}
+
+namespace
+{
+    std::vector< std::string > releasedAssets;
+}
+
+static AssetRegistry::Handle RegisterReleasable( AssetRegistry::Category category, const std::string& key, std::size_t size )
+{
+    return AssetRegistry::Register( category, key, size, [key]() { releasedAssets.push_back( key ); } );
+}
+
+bool TestRefCounts()
+{
+    const AssetRegistry::Handle handle = RegisterReleasable( AssetRegistry::Category::Texture, "ref.png", 100 );
+    AssetRegistry::AddRef( handle );
+
+    if (AssetRegistry::GetRefCount( handle ) != 2 || AssetRegistry::Find( AssetRegistry::Category::Texture, "ref.png" ).index != handle.index ||
+        AssetRegistry::IsValid( AssetRegistry::Find( AssetRegistry::Category::Mesh, "ref.png" ) ))
+    {
+        std::cerr << "Registering failed!" << std::endl;
+        return false;
+    }
+
+    // Referenced assets are not evicted even with a budget of 0.
+    AssetRegistry::Release( handle );
+    AssetRegistry::EndFrame();
+
+    if (!AssetRegistry::IsValid( handle ) || AssetRegistry::GetMemoryUsage( AssetRegistry::Category::Texture ) != 100)
+    {
+        std::cerr << "Referenced asset was evicted!" << std::endl;
+        return false;
+    }
+
+    AssetRegistry::Release( handle );
+    AssetRegistry::EndFrame();
+
+    if (AssetRegistry::IsValid( handle ) || AssetRegistry::GetMemoryUsage( AssetRegistry::Category::Texture ) != 0 ||
+        AssetRegistry::IsValid( AssetRegistry::Find( AssetRegistry::Category::Texture, "ref.png" ) ))
+    {
+        std::cerr << "Unreferenced asset was not evicted!" << std::endl;
+        return false;
+    }
+
+    // The evicted handle's slot is reused, but the handle stays invalid.
+    const AssetRegistry::Handle reused = RegisterReleasable( AssetRegistry::Category::Texture, "reused.png", 10 );
+    const bool isStale = reused.index == handle.index && !AssetRegistry::IsValid( handle ) && AssetRegistry::GetRefCount( handle ) == 0;
+    AssetRegistry::Release( reused );
+    AssetRegistry::ReleaseEvicted();
+    AssetRegistry::EndFrame();
+    AssetRegistry::ReleaseEvicted();
+    releasedAssets.clear();
+
+    if (!isStale)
+    {
+        std::cerr << "Stale handle is valid!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestBudget()
+{
+    AssetRegistry::SetFramesInFlight( 0 );
+    AssetRegistry::SetBudget( AssetRegistry::Category::Mesh, 150 );
+
+    const AssetRegistry::Handle a = RegisterReleasable( AssetRegistry::Category::Mesh, "a", 100 );
+    const AssetRegistry::Handle b = RegisterReleasable( AssetRegistry::Category::Mesh, "b", 100 );
+    const AssetRegistry::Handle c = RegisterReleasable( AssetRegistry::Category::Mesh, "c", 100 );
+    // Never evicted because it can't be released.
+    const AssetRegistry::Handle pinned = AssetRegistry::Register( AssetRegistry::Category::Mesh, "pinned", 10, nullptr );
+    // Other categories have their own budget.
+    const AssetRegistry::Handle clip = RegisterReleasable( AssetRegistry::Category::Audio, "clip.wav", 1000 );
+    AssetRegistry::SetBudget( AssetRegistry::Category::Audio, 1000 );
+
+    AssetRegistry::Release( a );
+    AssetRegistry::Release( b );
+    AssetRegistry::Release( c );
+    AssetRegistry::Release( pinned );
+    AssetRegistry::Release( clip );
+
+    // b was used again, so a is the least recently used.
+    AssetRegistry::AddRef( a );
+    AssetRegistry::Release( a );
+    AssetRegistry::AddRef( b );
+    AssetRegistry::Release( b );
+
+    AssetRegistry::EndFrame();
+
+    if (releasedAssets.size() != 2 || releasedAssets[ 0 ] != "c" || releasedAssets[ 1 ] != "a" || !AssetRegistry::IsValid( b ) ||
+        !AssetRegistry::IsValid( pinned ) || !AssetRegistry::IsValid( clip ) || AssetRegistry::GetMemoryUsage( AssetRegistry::Category::Mesh ) != 110)
+    {
+        std::cerr << "Least recently used assets were not evicted!" << std::endl;
+        return false;
+    }
+
+    releasedAssets.clear();
+    AssetRegistry::SetBudget( AssetRegistry::Category::Mesh, 0 );
+    AssetRegistry::SetBudget( AssetRegistry::Category::Audio, 0 );
+    AssetRegistry::EndFrame();
+
+    if (releasedAssets.size() != 2 || AssetRegistry::GetMemoryUsage( AssetRegistry::Category::Mesh ) != 10 || !AssetRegistry::IsValid( pinned ))
+    {
+        std::cerr << "Lowering the budget did not evict!" << std::endl;
+        return false;
+    }
+
+    releasedAssets.clear();
+    return true;
+}
+
+bool TestDeferredRelease()
+{
+    AssetRegistry::SetFramesInFlight( 2 );
+
+    const AssetRegistry::Handle handle = RegisterReleasable( AssetRegistry::Category::Texture, "deferred.png", 100 );
+    AssetRegistry::Release( handle );
+    AssetRegistry::EndFrame();
+
+    // Evicted, but the GPU may still use it.
+    const bool isReleasedEarly = !releasedAssets.empty();
+    const bool isEvicted = !AssetRegistry::IsValid( handle ) && AssetRegistry::GetMemoryUsage( AssetRegistry::Category::Texture ) == 0;
+    AssetRegistry::EndFrame();
+
+    if (isReleasedEarly || !isEvicted || releasedAssets.size() != 1)
+    {
+        std::cerr << "Release was not deferred by frames in flight!" << std::endl;
+        return false;
+    }
+
+    releasedAssets.clear();
+    return true;
+}
+
+bool TestUnregister()
+{
+    AssetRegistry::SetFramesInFlight( 0 );
+    AssetRegistry::SetBudget( AssetRegistry::Category::Font, 1000 );
+
+    const AssetRegistry::Handle old = RegisterReleasable( AssetRegistry::Category::Font, "font.fnt", 100 );
+    // Reloading registers the same key again.
+    const AssetRegistry::Handle reloaded = RegisterReleasable( AssetRegistry::Category::Font, "font.fnt", 120 );
+    AssetRegistry::EndFrame();
+
+    if (AssetRegistry::Find( AssetRegistry::Category::Font, "font.fnt" ).generation != reloaded.generation || !AssetRegistry::IsValid( old ) || !releasedAssets.empty())
+    {
+        std::cerr << "Reregistering a key failed!" << std::endl;
+        return false;
+    }
+
+    // Unregistered assets are evicted when unreferenced even if under budget.
+    AssetRegistry::Release( old );
+    AssetRegistry::Release( reloaded );
+    AssetRegistry::EndFrame();
+
+    if (AssetRegistry::IsValid( old ) || !AssetRegistry::IsValid( reloaded ) || AssetRegistry::GetMemoryUsage( AssetRegistry::Category::Font ) != 120)
+    {
+        std::cerr << "Unregistered asset was not evicted!" << std::endl;
+        return false;
+    }
+
+    AssetRegistry::SetBudget( AssetRegistry::Category::Font, 0 );
+    AssetRegistry::EndFrame();
+    releasedAssets.clear();
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestRefCounts();
+    result &= TestBudget();
+    result &= TestDeferredRelease();
+    result &= TestUnregister();
+
+    assert( result && "AssetRegistry tests failed!" );
+
+    return result ? 0 : 1;
+}
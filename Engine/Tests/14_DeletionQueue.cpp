@@ -0,0 +1,391 @@
+// Tests that DeletionQueue destroys objects only after their frame's fence has signalled and that nothing leaks.
+// Needs a Vulkan driver but no window, so it can be run with a software driver, for example:
+// VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./14_DeletionQueue
+// If VK_LAYER_KHRONOS_validation is installed, objects that are still alive when the device is destroyed fail the test.
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "DeletionQueueVulkan.hpp"
+#include "System.hpp"
+
+using namespace ae3d;
+
+namespace GfxDeviceGlobal
+{
+    VkDevice device = VK_NULL_HANDLE;
+}
+
+void ae3d::System::Assert( bool condition, const char* message )
+{
+    if (!condition)
+    {
+        std::cerr << "Assertion failed: " << message << std::endl;
+    }
+
+    assert( condition );
+}
+
+namespace
+{
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkDebugUtilsMessengerEXT messenger = VK_NULL_HANDLE;
+    unsigned validationErrorCount = 0;
+}
+
+static VKAPI_ATTR VkBool32 VKAPI_CALL ValidationCallback( VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT,
+                                                           const VkDebugUtilsMessengerCallbackDataEXT* callbackData, void* )
+{
+    if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+    {
+        std::cerr << callbackData->pMessage << std::endl;
+        ++validationErrorCount;
+    }
+
+    return VK_FALSE;
+}
+
+static bool HasValidationLayer()
+{
+    std::uint32_t layerCount = 0;
+    vkEnumerateInstanceLayerProperties( &layerCount, nullptr );
+    std::vector< VkLayerProperties > layers( layerCount );
+    vkEnumerateInstanceLayerProperties( &layerCount, layers.data() );
+
+    for (const auto& layer : layers)
+    {
+        if (std::strcmp( layer.layerName, "VK_LAYER_KHRONOS_validation" ) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool CreateDevice( bool useValidation )
+{
+    const char* layerName = "VK_LAYER_KHRONOS_validation";
+    const char* extensionName = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "DeletionQueue test";
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+    instanceInfo.enabledLayerCount = useValidation ? 1 : 0;
+    instanceInfo.ppEnabledLayerNames = &layerName;
+    instanceInfo.enabledExtensionCount = useValidation ? 1 : 0;
+    instanceInfo.ppEnabledExtensionNames = &extensionName;
+
+    if (vkCreateInstance( &instanceInfo, nullptr, &instance ) != VK_SUCCESS)
+    {
+        std::cerr << "Could not create Vulkan instance!" << std::endl;
+        return false;
+    }
+
+    if (useValidation)
+    {
+        VkDebugUtilsMessengerCreateInfoEXT messengerInfo = {};
+        messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+        messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+        messengerInfo.pfnUserCallback = ValidationCallback;
+
+        auto createMessenger = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr( instance, "vkCreateDebugUtilsMessengerEXT" );
+
+        if (createMessenger != nullptr)
+        {
+            createMessenger( instance, &messengerInfo, nullptr, &messenger );
+        }
+    }
+
+    std::uint32_t physicalDeviceCount = 1;
+    vkEnumeratePhysicalDevices( instance, &physicalDeviceCount, &physicalDevice );
+
+    if (physicalDeviceCount == 0)
+    {
+        std::cerr << "No Vulkan devices!" << std::endl;
+        return false;
+    }
+
+    std::uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, nullptr );
+    std::vector< VkQueueFamilyProperties > queueFamilies( queueFamilyCount );
+    vkGetPhysicalDeviceQueueFamilyProperties( physicalDevice, &queueFamilyCount, queueFamilies.data() );
+
+    std::uint32_t queueFamilyIndex = 0;
+
+    while (queueFamilyIndex < queueFamilyCount && (queueFamilies[ queueFamilyIndex ].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0)
+    {
+        ++queueFamilyIndex;
+    }
+
+    if (queueFamilyIndex == queueFamilyCount)
+    {
+        std::cerr << "No graphics queue!" << std::endl;
+        return false;
+    }
+
+    const float queuePriority = 1;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = queueFamilyIndex;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &queuePriority;
+
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+
+    if (vkCreateDevice( physicalDevice, &deviceInfo, nullptr, &GfxDeviceGlobal::device ) != VK_SUCCESS)
+    {
+        std::cerr << "Could not create Vulkan device!" << std::endl;
+        return false;
+    }
+
+    vkGetDeviceQueue( GfxDeviceGlobal::device, queueFamilyIndex, 0, &queue );
+    return true;
+}
+
+static VkDeviceMemory AllocateMemory( const VkMemoryRequirements& requirements )
+{
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties( physicalDevice, &properties );
+
+    std::uint32_t typeIndex = 0;
+
+    while (typeIndex < properties.memoryTypeCount && (requirements.memoryTypeBits & (1u << typeIndex)) == 0)
+    {
+        ++typeIndex;
+    }
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = typeIndex;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult err = vkAllocateMemory( GfxDeviceGlobal::device, &allocateInfo, nullptr, &memory );
+    System::Assert( err == VK_SUCCESS, "vkAllocateMemory" );
+    return memory;
+}
+
+// Creates a buffer, an image with a view and a sampler, and releases them with their memory. That's 6 objects.
+static void CreateAndReleaseObjects()
+{
+    const VkDevice device = GfxDeviceGlobal::device;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = 64 * 1024;
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkResult err = vkCreateBuffer( device, &bufferInfo, nullptr, &buffer );
+    System::Assert( err == VK_SUCCESS, "vkCreateBuffer" );
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements( device, buffer, &requirements );
+    VkDeviceMemory bufferMemory = AllocateMemory( requirements );
+    vkBindBufferMemory( device, buffer, bufferMemory, 0 );
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+    imageInfo.extent = { 64, 64, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image = VK_NULL_HANDLE;
+    err = vkCreateImage( device, &imageInfo, nullptr, &image );
+    System::Assert( err == VK_SUCCESS, "vkCreateImage" );
+
+    vkGetImageMemoryRequirements( device, image, &requirements );
+    VkDeviceMemory imageMemory = AllocateMemory( requirements );
+    vkBindImageMemory( device, image, imageMemory, 0 );
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = imageInfo.format;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    VkImageView view = VK_NULL_HANDLE;
+    err = vkCreateImageView( device, &viewInfo, nullptr, &view );
+    System::Assert( err == VK_SUCCESS, "vkCreateImageView" );
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.maxAnisotropy = 1;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    err = vkCreateSampler( device, &samplerInfo, nullptr, &sampler );
+    System::Assert( err == VK_SUCCESS, "vkCreateSampler" );
+
+    DeletionQueue::ReleaseBuffer( buffer );
+    DeletionQueue::ReleaseMemory( bufferMemory );
+    DeletionQueue::ReleaseImageView( view );
+    DeletionQueue::ReleaseImage( image );
+    DeletionQueue::ReleaseMemory( imageMemory );
+    DeletionQueue::ReleaseSampler( sampler );
+    DeletionQueue::ReleaseBuffer( VK_NULL_HANDLE ); // Ignored.
+}
+
+static void SubmitFrame()
+{
+    VkResult err = vkQueueSubmit( queue, 0, nullptr, DeletionQueue::GetFrameFence() );
+    System::Assert( err == VK_SUCCESS, "vkQueueSubmit" );
+}
+
+bool TestFenceWait()
+{
+    CreateAndReleaseObjects();
+    const std::uint64_t releaseFrame = DeletionQueue::GetFrameIndex();
+    const VkFence fence = DeletionQueue::GetFrameFence();
+
+    // The fence has not been submitted, so it can't have signalled.
+    DeletionQueue::EndFrame( queue );
+
+    if (DeletionQueue::GetPendingCount() != 6 || DeletionQueue::GetCompletedFrameCount() > releaseFrame)
+    {
+        std::cerr << "Objects were destroyed before their fence signalled!" << std::endl;
+        return false;
+    }
+
+    vkQueueSubmit( queue, 0, nullptr, fence );
+    vkWaitForFences( GfxDeviceGlobal::device, 1, &fence, VK_TRUE, UINT64_MAX );
+    DeletionQueue::EndFrame( queue );
+
+    if (DeletionQueue::GetPendingCount() != 0 || DeletionQueue::GetCompletedFrameCount() <= releaseFrame)
+    {
+        std::cerr << "Objects were not destroyed after their fence signalled!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestFrames()
+{
+    const int frameCount = 300;
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        CreateAndReleaseObjects();
+        SubmitFrame();
+        DeletionQueue::EndFrame( queue );
+
+        // Objects can only be pending for frames that have not completed.
+        const std::uint64_t framesInFlight = DeletionQueue::GetFrameIndex() - DeletionQueue::GetCompletedFrameCount();
+
+        if (DeletionQueue::GetPendingCount() > framesInFlight * 6)
+        {
+            std::cerr << "Objects of completed frames were not destroyed!" << std::endl;
+            return false;
+        }
+    }
+
+    vkQueueWaitIdle( queue );
+    DeletionQueue::EndFrame( queue );
+
+    if (DeletionQueue::GetPendingCount() != 0 || DeletionQueue::GetCompletedFrameCount() != DeletionQueue::GetFrameIndex() - 1)
+    {
+        std::cerr << "Objects of all frames were not destroyed!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestFrameWithoutFence()
+{
+    // EndFrame() submits a fence itself.
+    CreateAndReleaseObjects();
+    DeletionQueue::EndFrame( queue );
+    vkQueueWaitIdle( queue );
+    DeletionQueue::EndFrame( queue );
+
+    if (DeletionQueue::GetPendingCount() != 0)
+    {
+        std::cerr << "Objects released without a frame fence were not destroyed!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestReleaseAll()
+{
+    CreateAndReleaseObjects();
+    SubmitFrame();
+    DeletionQueue::EndFrame( queue );
+    CreateAndReleaseObjects();
+
+    vkDeviceWaitIdle( GfxDeviceGlobal::device );
+    DeletionQueue::ReleaseAll();
+
+    if (DeletionQueue::GetPendingCount() != 0)
+    {
+        std::cerr << "ReleaseAll() did not destroy all objects!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    const bool useValidation = HasValidationLayer();
+
+    if (!CreateDevice( useValidation ))
+    {
+        return 1;
+    }
+
+    bool result = true;
+
+    result &= TestFenceWait();
+    result &= TestFrames();
+    result &= TestFrameWithoutFence();
+    result &= TestReleaseAll();
+
+    // The validation layer reports objects that are still alive.
+    vkDestroyDevice( GfxDeviceGlobal::device, nullptr );
+
+    if (messenger != VK_NULL_HANDLE)
+    {
+        auto destroyMessenger = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr( instance, "vkDestroyDebugUtilsMessengerEXT" );
+        destroyMessenger( instance, messenger, nullptr );
+    }
+
+    vkDestroyInstance( instance, nullptr );
+
+    if (validationErrorCount > 0)
+    {
+        std::cerr << validationErrorCount << " validation errors!" << std::endl;
+        result = false;
+    }
+
+    if (!useValidation)
+    {
+        std::cout << "VK_LAYER_KHRONOS_validation not found, leaks of destroyed objects were not checked." << std::endl;
+    }
+
+    assert( result && "DeletionQueue tests failed!" );
+
+    return result ? 0 : 1;
+}
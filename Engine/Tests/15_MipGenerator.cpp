@@ -0,0 +1,295 @@
+// Tests MipGenerator filtering of non-power-of-two images, sRGB and alpha coverage, and measures it against a naive scalar loop.
+// Doesn't need a window or GPU. Build with and without -DSIMD_SSE3 to compare the kernels.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "MipGenerator.hpp"
+
+using namespace ae3d;
+
+static std::vector< unsigned char > MakeImage( int width, int height, unsigned char r, unsigned char g, unsigned char b, unsigned char a )
+{
+    std::vector< unsigned char > pixels( width * height * 4 );
+
+    for (std::size_t i = 0; i < pixels.size(); i += 4)
+    {
+        pixels[ i + 0 ] = r;
+        pixels[ i + 1 ] = g;
+        pixels[ i + 2 ] = b;
+        pixels[ i + 3 ] = a;
+    }
+
+    return pixels;
+}
+
+static std::vector< unsigned char > Generate( const std::vector< unsigned char >& pixels, int width, int height, const MipGenerator::Settings& settings )
+{
+    std::vector< unsigned char > mipChain( MipGenerator::GetMipChainSize( width, height ) );
+    MipGenerator::Generate( pixels.data(), width, height, settings, mipChain.data() );
+    return mipChain;
+}
+
+static float GetCoverage( const unsigned char* pixels, int pixelCount, float alphaCutoff )
+{
+    int coveredCount = 0;
+
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        coveredCount += pixels[ i * 4 + 3 ] / 255.0f >= alphaCutoff ? 1 : 0;
+    }
+
+    return static_cast< float >( coveredCount ) / pixelCount;
+}
+
+bool TestNPOT()
+{
+    if (MipGenerator::GetMipCount( 5, 3 ) != 3 || MipGenerator::GetMipCount( 1, 1 ) != 1 || MipGenerator::GetMipCount( 640, 480 ) != 10 ||
+        MipGenerator::GetMipOffset( 5, 3, 2 ) != (5 * 3 + 2 * 1) * 4 || MipGenerator::GetMipChainSize( 5, 3 ) != (5 * 3 + 2 * 1 + 1) * 4)
+    {
+        std::printf( "Wrong mip count or size!\n" );
+        return false;
+    }
+
+    // Constant images stay constant with every filter and edge mode.
+    const std::vector< unsigned char > constant = MakeImage( 37, 11, 10, 128, 250, 77 );
+
+    for (int variant = 0; variant < 4; ++variant)
+    {
+        MipGenerator::Settings settings;
+        settings.filter = variant / 2 == 0 ? MipGenerator::Filter::Box : MipGenerator::Filter::Kaiser;
+        settings.isWrapped = variant % 2 == 1;
+        settings.isSRGB = true;
+        const std::vector< unsigned char > mipChain = Generate( constant, 37, 11, settings );
+
+        for (std::size_t i = 0; i < mipChain.size(); i += 4)
+        {
+            if (mipChain[ i ] != 10 || mipChain[ i + 1 ] != 128 || mipChain[ i + 2 ] != 250 || mipChain[ i + 3 ] != 77)
+            {
+                std::printf( "Constant image changed at byte %u with filter variant %d!\n", (unsigned)i, variant );
+                return false;
+            }
+        }
+    }
+
+    // A ramp of 5 pixels goes to 2 pixels that cover 2.5 source pixels each, so the ramp's middle pixel is split between them.
+    std::vector< unsigned char > ramp = MakeImage( 5, 1, 0, 0, 0, 255 );
+
+    for (int x = 0; x < 5; ++x)
+    {
+        ramp[ x * 4 ] = static_cast< unsigned char >( x * 50 );
+    }
+
+    const std::vector< unsigned char > rampChain = Generate( ramp, 5, 1, MipGenerator::Settings() );
+    const unsigned char* level1 = &rampChain[ MipGenerator::GetMipOffset( 5, 1, 1 ) ];
+    const unsigned char* level2 = &rampChain[ MipGenerator::GetMipOffset( 5, 1, 2 ) ];
+
+    if (level1[ 0 ] != 40 || level1[ 4 ] != 160 || level2[ 0 ] != 100)
+    {
+        std::printf( "Odd width was not filtered by coverage: %d %d %d!\n", level1[ 0 ], level1[ 4 ], level2[ 0 ] );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestSRGB()
+{
+    // Black and white average to linear 0.5, which is sRGB 188, not 128.
+    std::vector< unsigned char > checker = MakeImage( 2, 2, 0, 0, 0, 255 );
+    checker[ 4 ] = checker[ 5 ] = checker[ 6 ] = 255;
+    checker[ 8 ] = checker[ 9 ] = checker[ 10 ] = 255;
+
+    MipGenerator::Settings settings;
+    settings.isSRGB = true;
+    const std::vector< unsigned char > checkerChain = Generate( checker, 2, 2, settings );
+
+    if (checkerChain[ 16 ] != 188 || checkerChain[ 19 ] != 255)
+    {
+        std::printf( "sRGB average is %d, expected 188!\n", checkerChain[ 16 ] );
+        return false;
+    }
+
+    // Every code goes through linear and back unchanged.
+    std::vector< unsigned char > codes( 2 * 512 * 4 );
+
+    for (int y = 0; y < 512; ++y)
+    {
+        for (int x = 0; x < 2; ++x)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                codes[ (y * 2 + x) * 4 + c ] = static_cast< unsigned char >( y / 2 );
+            }
+        }
+    }
+
+    const std::vector< unsigned char > codeChain = Generate( codes, 2, 512, settings );
+    const unsigned char* codeLevel = &codeChain[ MipGenerator::GetMipOffset( 2, 512, 1 ) ];
+
+    for (int y = 0; y < 256; ++y)
+    {
+        if (codeLevel[ y * 4 ] != y || codeLevel[ y * 4 + 3 ] != y)
+        {
+            std::printf( "sRGB code %d changed to %d!\n", y, codeLevel[ y * 4 ] );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TestAlphaCoverage()
+{
+    const int size = 256;
+    const float alphaCutoff = 0.5f;
+    std::vector< unsigned char > foliage = MakeImage( size, size, 40, 120, 30, 0 );
+    std::srand( 1 );
+
+    // Mostly transparent with sparse opaque leaves, like foliage.
+    for (int i = 0; i < size * size; ++i)
+    {
+        const float r = static_cast< float >( std::rand() ) / RAND_MAX;
+        foliage[ i * 4 + 3 ] = static_cast< unsigned char >( r * r * r * 255 );
+    }
+
+    const float coverage = GetCoverage( foliage.data(), size * size, alphaCutoff );
+
+    MipGenerator::Settings settings;
+    const std::vector< unsigned char > plainChain = Generate( foliage, size, size, settings );
+    settings.alphaCutoff = alphaCutoff;
+    const std::vector< unsigned char > preservedChain = Generate( foliage, size, size, settings );
+
+    for (int mipIndex = 1; mipIndex <= 4; ++mipIndex)
+    {
+        const int mipSize = size >> mipIndex;
+        const std::size_t offset = MipGenerator::GetMipOffset( size, size, mipIndex );
+        const float plainCoverage = GetCoverage( &plainChain[ offset ], mipSize * mipSize, alphaCutoff );
+        const float preservedCoverage = GetCoverage( &preservedChain[ offset ], mipSize * mipSize, alphaCutoff );
+
+        std::printf( "Mip %d alpha coverage: %.3f without preservation, %.3f with, level 0: %.3f\n", mipIndex, plainCoverage, preservedCoverage, coverage );
+
+        if (std::fabs( preservedCoverage - coverage ) > 0.02f)
+        {
+            std::printf( "Alpha coverage was not preserved!\n" );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// What a simple loader would do: averages 2x2 blocks of the previous 8-bit level converting each channel with std::pow().
+static void GenerateNaive( const unsigned char* pixels, int width, int height, unsigned char* outMipChain )
+{
+    std::copy( pixels, pixels + width * height * 4, outMipChain );
+    const unsigned char* source = outMipChain;
+    unsigned char* destination = outMipChain + width * height * 4;
+
+    while (width > 1 || height > 1)
+    {
+        const int nextWidth = std::max( width / 2, 1 );
+        const int nextHeight = std::max( height / 2, 1 );
+
+        for (int y = 0; y < nextHeight; ++y)
+        {
+            for (int x = 0; x < nextWidth; ++x)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    float sum = 0;
+
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        const int sourceX = std::min( x * 2 + i % 2, width - 1 );
+                        const int sourceY = std::min( y * 2 + i / 2, height - 1 );
+                        const float value = source[ (sourceY * width + sourceX) * 4 + c ] / 255.0f;
+                        sum += c == 3 ? value : std::pow( value, 2.2f );
+                    }
+
+                    const float average = sum / 4;
+                    destination[ (y * nextWidth + x) * 4 + c ] = static_cast< unsigned char >( (c == 3 ? average : std::pow( average, 1 / 2.2f )) * 255 + 0.5f );
+                }
+            }
+        }
+
+        source = destination;
+        destination += nextWidth * nextHeight * 4;
+        width = nextWidth;
+        height = nextHeight;
+    }
+}
+
+template< typename Function >
+static double MeasureMs( Function function, int iterations )
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        function();
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration< double, std::milli >( end - start ).count() / iterations;
+}
+
+void Benchmark()
+{
+    const int width = 2048;
+    const int height = 2048;
+    const int iterations = 3;
+    std::vector< unsigned char > pixels( width * height * 4 );
+    std::srand( 2 );
+
+    for (auto& pixel : pixels)
+    {
+        pixel = static_cast< unsigned char >( std::rand() );
+    }
+
+    std::vector< unsigned char > mipChain( MipGenerator::GetMipChainSize( width, height ) );
+    MipGenerator::Settings settings;
+    settings.isSRGB = true;
+
+    const double naiveMs = MeasureMs( [&]() { GenerateNaive( pixels.data(), width, height, mipChain.data() ); }, iterations );
+    const double boxMs = MeasureMs( [&]() { MipGenerator::Generate( pixels.data(), width, height, settings, mipChain.data() ); }, iterations );
+    settings.alphaCutoff = 0.5f;
+    const double coverageMs = MeasureMs( [&]() { MipGenerator::Generate( pixels.data(), width, height, settings, mipChain.data() ); }, iterations );
+    settings.alphaCutoff = 0;
+    settings.filter = MipGenerator::Filter::Kaiser;
+    const double kaiserMs = MeasureMs( [&]() { MipGenerator::Generate( pixels.data(), width, height, settings, mipChain.data() ); }, iterations );
+
+#if SIMD_SSE3
+    const char* kernel = "SSE";
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+    const char* kernel = "NEON";
+#else
+    const char* kernel = "scalar";
+#endif
+    std::printf( "%dx%d sRGB mip chain, %s kernel:\n", width, height, kernel );
+    std::printf( "naive 2x2 with pow: %8.2f ms\n", naiveMs );
+    std::printf( "box:                %8.2f ms (%.1fx)\n", boxMs, naiveMs / boxMs );
+    std::printf( "box with coverage:  %8.2f ms (%.1fx)\n", coverageMs, naiveMs / coverageMs );
+    std::printf( "kaiser:             %8.2f ms (%.1fx)\n", kaiserMs, naiveMs / kaiserMs );
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestNPOT();
+    result &= TestSRGB();
+    result &= TestAlphaCoverage();
+
+    if (!result)
+    {
+        std::printf( "MipGenerator tests failed!\n" );
+        return 1;
+    }
+
+    Benchmark();
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+// Tests the offline BC1/BC3/BC4/BC5/BC7 compressor in Tools/TextureCompressor by decoding its blocks and measuring PSNR.
+// Doesn't need a window or GPU.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../../Tools/TextureCompressor/BCEncoder.hpp"
+
+static const char* formatNames[] = { "BC1", "BC3", "BC4", "BC5", "BC7" };
+static const char* qualityNames[] = { "fast", "normal", "high" };
+
+// Smooth gradients with noise, edges and an alpha ramp, like a photo with a cutout.
+static std::vector< unsigned char > MakePhoto( int width, int height )
+{
+    std::vector< unsigned char > pixels( width * height * 4 );
+    std::srand( 3 );
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int noise = std::rand() % 9 - 4;
+            const bool isEdge = ((x / 16) + (y / 16)) % 2 == 0;
+            unsigned char* pixel = &pixels[ (y * width + x) * 4 ];
+            pixel[ 0 ] = static_cast< unsigned char >( std::min( std::max( x * 255 / width + noise, 0 ), 255 ) );
+            pixel[ 1 ] = static_cast< unsigned char >( std::min( std::max( (isEdge ? 200 : 60) + noise, 0 ), 255 ) );
+            pixel[ 2 ] = static_cast< unsigned char >( std::min( std::max( static_cast< int >( 128 + 100 * std::sin( x * 0.1f + y * 0.05f ) ) + noise, 0 ), 255 ) );
+            pixel[ 3 ] = static_cast< unsigned char >( y * 255 / height );
+        }
+    }
+
+    return pixels;
+}
+
+// Bumps stored as a tangent-space normal map.
+static std::vector< unsigned char > MakeNormalMap( int width, int height )
+{
+    std::vector< unsigned char > pixels( width * height * 4 );
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const float nx = 0.5f * std::sin( x * 0.2f );
+            const float ny = 0.5f * std::cos( y * 0.15f );
+            const float nz = std::sqrt( 1 - nx * nx - ny * ny );
+            unsigned char* pixel = &pixels[ (y * width + x) * 4 ];
+            pixel[ 0 ] = static_cast< unsigned char >( (nx * 0.5f + 0.5f) * 255 + 0.5f );
+            pixel[ 1 ] = static_cast< unsigned char >( (ny * 0.5f + 0.5f) * 255 + 0.5f );
+            pixel[ 2 ] = static_cast< unsigned char >( (nz * 0.5f + 0.5f) * 255 + 0.5f );
+            pixel[ 3 ] = 255;
+        }
+    }
+
+    return pixels;
+}
+
+static double Compress( const std::vector< unsigned char >& pixels, int width, int height, BCFormat format, BCQuality quality )
+{
+    const std::vector< unsigned char > blocks = CompressBC( pixels.data(), width, height, format, quality );
+
+    if (blocks.size() != static_cast< std::size_t >( (width + 3) / 4 ) * ((height + 3) / 4) * GetBCBlockSize( format ))
+    {
+        std::printf( "Wrong compressed size!\n" );
+        return 0;
+    }
+
+    const std::vector< unsigned char > decompressed = DecompressBC( blocks.data(), width, height, format );
+    return GetPSNR( pixels.data(), decompressed.data(), width * height, GetBCChannelCount( format ) );
+}
+
+bool TestQuality()
+{
+    // Not a multiple of 4, so edge blocks are partial.
+    const int width = 130;
+    const int height = 66;
+    const std::vector< unsigned char > photo = MakePhoto( width, height );
+    const std::vector< unsigned char > normalMap = MakeNormalMap( width, height );
+    // Lowest acceptable PSNR in dB for fast quality.
+    const double minPSNRs[] = { 35, 35, 48, 46, 35 };
+    bool result = true;
+
+    for (int f = 0; f < 5; ++f)
+    {
+        const BCFormat format = static_cast< BCFormat >( f );
+        const std::vector< unsigned char >& pixels = (format == BCFormat::BC5) ? normalMap : photo;
+        double previousPSNR = 0;
+
+        for (int q = 0; q < 3; ++q)
+        {
+            const double psnr = Compress( pixels, width, height, format, static_cast< BCQuality >( q ) );
+            std::printf( "%s %-6s PSNR: %.2f dB\n", formatNames[ f ], qualityNames[ q ], psnr );
+
+            if (psnr < minPSNRs[ f ] || psnr < previousPSNR - 0.01)
+            {
+                std::printf( "%s %s PSNR is too low!\n", formatNames[ f ], qualityNames[ q ] );
+                result = false;
+            }
+
+            previousPSNR = psnr;
+        }
+    }
+
+    // BC7 only uses mode 6, whose indices are shared by color and alpha, so it's compared on an opaque image against BC1.
+    std::vector< unsigned char > opaquePhoto = photo;
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        opaquePhoto[ i * 4 + 3 ] = 255;
+    }
+
+    const double bc1PSNR = Compress( opaquePhoto, width, height, BCFormat::BC1, BCQuality::High );
+    const double bc7PSNR = Compress( opaquePhoto, width, height, BCFormat::BC7, BCQuality::High );
+    std::printf( "Opaque image PSNR: BC1 %.2f dB, BC7 %.2f dB\n", bc1PSNR, bc7PSNR );
+
+    if (bc7PSNR < bc1PSNR + 3)
+    {
+        std::printf( "BC7 should have better quality than BC1!\n" );
+        result = false;
+    }
+
+    return result;
+}
+
+bool TestExactBlocks()
+{
+    // Colors that 565 represents exactly, and any 8-bit value in BC4 and BC7, come back unchanged.
+    std::vector< unsigned char > pixels( 8 * 4 * 4 );
+
+    for (int i = 0; i < 32; ++i)
+    {
+        const bool isLeft = (i % 8) < 4;
+        pixels[ i * 4 + 0 ] = isLeft ? 255 : 0;
+        pixels[ i * 4 + 1 ] = isLeft ? 130 : 36;
+        pixels[ i * 4 + 2 ] = isLeft ? 0 : 99;
+        pixels[ i * 4 + 3 ] = isLeft ? 255 : 17;
+    }
+
+    const double bc1PSNR = Compress( pixels, 8, 4, BCFormat::BC1, BCQuality::Fast );
+    const double bc4PSNR = Compress( pixels, 8, 4, BCFormat::BC4, BCQuality::Fast );
+    const double bc7PSNR = Compress( pixels, 8, 4, BCFormat::BC7, BCQuality::Fast );
+
+    if (bc4PSNR != 99 || bc7PSNR < 50)
+    {
+        std::printf( "Constant blocks changed: BC4 %.2f dB, BC7 %.2f dB!\n", bc4PSNR, bc7PSNR );
+        return false;
+    }
+
+    // Only the left block is exact in 565, the right one is rounded.
+    const std::vector< unsigned char > blocks = CompressBC( pixels.data(), 8, 4, BCFormat::BC1, BCQuality::Fast );
+    const std::vector< unsigned char > decompressed = DecompressBC( blocks.data(), 8, 4, BCFormat::BC1 );
+
+    if (decompressed[ 0 ] != 255 || decompressed[ 1 ] != 130 || decompressed[ 2 ] != 0 || decompressed[ 3 ] != 255 || bc1PSNR < 40)
+    {
+        std::printf( "BC1 constant block changed to %d %d %d %d!\n", decompressed[ 0 ], decompressed[ 1 ], decompressed[ 2 ], decompressed[ 3 ] );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestFormatChoice()
+{
+    const int size = 16;
+    std::vector< unsigned char > gray( size * size * 4, 255 );
+    std::vector< unsigned char > color = MakePhoto( size, size );
+    std::vector< unsigned char > withAlpha = color;
+
+    for (int i = 0; i < size * size; ++i)
+    {
+        gray[ i * 4 + 0 ] = gray[ i * 4 + 1 ] = gray[ i * 4 + 2 ] = static_cast< unsigned char >( i );
+        color[ i * 4 + 3 ] = 255;
+    }
+
+    const BCFormat grayFormat = ChooseBCFormat( gray.data(), size * size );
+    const BCFormat normalMapFormat = ChooseBCFormat( MakeNormalMap( size, size ).data(), size * size );
+    const BCFormat alphaFormat = ChooseBCFormat( withAlpha.data(), size * size );
+    const BCFormat colorFormat = ChooseBCFormat( color.data(), size * size );
+
+    if (grayFormat != BCFormat::BC4 || normalMapFormat != BCFormat::BC5 || alphaFormat != BCFormat::BC3 || colorFormat != BCFormat::BC1)
+    {
+        std::printf( "Wrong formats chosen: gray %s, normal map %s, alpha %s, color %s!\n", formatNames[ static_cast< int >( grayFormat ) ],
+                     formatNames[ static_cast< int >( normalMapFormat ) ], formatNames[ static_cast< int >( alphaFormat ) ], formatNames[ static_cast< int >( colorFormat ) ] );
+        return false;
+    }
+
+    return true;
+}
+
+void Benchmark()
+{
+    const int size = 1024;
+    const std::vector< unsigned char > photo = MakePhoto( size, size );
+
+    std::printf( "%dx%d on %u threads:\n", size, size, std::thread::hardware_concurrency() );
+
+    for (int f = 0; f < 5; ++f)
+    {
+        for (int q = 0; q < 3; ++q)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const std::vector< unsigned char > blocks = CompressBC( photo.data(), size, size, static_cast< BCFormat >( f ), static_cast< BCQuality >( q ) );
+            const double ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+            std::printf( "%s %-6s %8.2f ms, %6.1f Mpixels/s\n", formatNames[ f ], qualityNames[ q ], ms, size * size / (ms * 1000) );
+        }
+    }
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestQuality();
+    result &= TestExactBlocks();
+    result &= TestFormatChoice();
+
+    if (!result)
+    {
+        std::printf( "Texture compression tests failed!\n" );
+        return 1;
+    }
+
+    Benchmark();
+
+    return 0;
+}
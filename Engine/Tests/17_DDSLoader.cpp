@@ -0,0 +1,291 @@
+// Tests DDSLoader with DX10 and legacy headers, texture arrays, cube maps and non-power-of-two sizes, and that files are not copied when
+// loaded from a FileView. Doesn't need a window or GPU.
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "DDSLoader.hpp"
+#include "FileSystem.hpp"
+#include "System.hpp"
+
+void ae3d::System::Print( const char*, ... )
+{
+}
+
+static void AppendUint( std::vector< unsigned char >& contents, std::uint32_t value )
+{
+    const unsigned char* bytes = reinterpret_cast< const unsigned char* >( &value );
+    contents.insert( contents.end(), bytes, bytes + 4 );
+}
+
+// Writes a header with a FourCC and an optional DX10 header. Level m of layer l is filled with byte l * 16 + m.
+static std::vector< unsigned char > MakeDDS( int width, int height, int mipCount, const char* fourCC, std::uint32_t caps2,
+                                             std::uint32_t dxgiFormat, std::uint32_t miscFlag, std::uint32_t arraySize, DDSLoader::Format format, int layerCount )
+{
+    std::vector< unsigned char > contents;
+    contents.insert( contents.end(), { 'D', 'D', 'S', ' ' } );
+    AppendUint( contents, 124 );
+    AppendUint( contents, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 );
+    AppendUint( contents, height );
+    AppendUint( contents, width );
+    AppendUint( contents, 0 );
+    AppendUint( contents, 0 );
+    AppendUint( contents, mipCount );
+
+    for (int i = 0; i < 11; ++i)
+    {
+        AppendUint( contents, 0 );
+    }
+
+    AppendUint( contents, 32 );
+    AppendUint( contents, 0x4 );
+    contents.insert( contents.end(), fourCC, fourCC + 4 );
+
+    for (int i = 0; i < 5; ++i)
+    {
+        AppendUint( contents, 0 );
+    }
+
+    AppendUint( contents, 0x1000 );
+    AppendUint( contents, caps2 );
+
+    for (int i = 0; i < 3; ++i)
+    {
+        AppendUint( contents, 0 );
+    }
+
+    if (std::memcmp( fourCC, "DX10", 4 ) == 0)
+    {
+        AppendUint( contents, dxgiFormat );
+        AppendUint( contents, 3 );
+        AppendUint( contents, miscFlag );
+        AppendUint( contents, arraySize );
+        AppendUint( contents, 0 );
+    }
+
+    for (int layer = 0; layer < layerCount; ++layer)
+    {
+        for (int mipIndex = 0; mipIndex < mipCount; ++mipIndex)
+        {
+            contents.insert( contents.end(), DDSLoader::GetMipSize( format, width, height, mipIndex ), static_cast< unsigned char >( layer * 16 + mipIndex ) );
+        }
+    }
+
+    return contents;
+}
+
+// Checks that each level's offset points to its fill byte and that levels are back to back.
+static bool HasLayout( const DDSLoader::Output& output, int width, int height, std::size_t headerSize )
+{
+    std::size_t offset = headerSize;
+
+    for (int layer = 0; layer < output.layerCount; ++layer)
+    {
+        for (int mipIndex = 0; mipIndex < output.mipCount; ++mipIndex)
+        {
+            const int dataOffset = output.dataOffsets[ layer * output.mipCount + mipIndex ];
+
+            if (dataOffset != static_cast< int >( offset ) || output.data[ dataOffset ] != layer * 16 + mipIndex)
+            {
+                std::printf( "Wrong offset %d for layer %d mip %d, expected %u!\n", dataOffset, layer, mipIndex, (unsigned)offset );
+                return false;
+            }
+
+            offset += DDSLoader::GetMipSize( output.format, width, height, mipIndex );
+        }
+    }
+
+    return offset == output.dataSize;
+}
+
+bool TestMipSizes()
+{
+    // Odd sizes are rounded up to whole blocks, and levels smaller than a block still take one.
+    if (DDSLoader::GetMipSize( DDSLoader::Format::BC1, 130, 66, 0 ) != 33 * 17 * 8 || DDSLoader::GetMipSize( DDSLoader::Format::BC7, 130, 66, 1 ) != 17 * 9 * 16 ||
+        DDSLoader::GetMipSize( DDSLoader::Format::BC4U, 130, 66, 7 ) != 8 || DDSLoader::GetMipSize( DDSLoader::Format::BC5U, 5, 3, 2 ) != 16 ||
+        DDSLoader::GetBlockSize( DDSLoader::Format::BC4S ) != 8 || DDSLoader::GetBlockSize( DDSLoader::Format::BC6HU ) != 16 ||
+        DDSLoader::GetMipSize( DDSLoader::Format::RGBA16F, 130, 66, 1 ) != 65 * 33 * 8 || DDSLoader::GetMipSize( DDSLoader::Format::RGBA16F, 130, 66, 7 ) != 8)
+    {
+        std::printf( "Wrong mip size!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestDX10()
+{
+    const struct { std::uint32_t dxgiFormat; DDSLoader::Format format; bool isSRGB; bool isOpaque; } formats[] =
+    {
+        { 72, DDSLoader::Format::BC1, true, true },
+        { 77, DDSLoader::Format::BC3, false, false },
+        { 80, DDSLoader::Format::BC4U, false, true },
+        { 84, DDSLoader::Format::BC5S, false, true },
+        { 95, DDSLoader::Format::BC6HU, false, true },
+        { 96, DDSLoader::Format::BC6HS, false, true },
+        { 98, DDSLoader::Format::BC7, false, false },
+        { 99, DDSLoader::Format::BC7, true, false },
+        { 10, DDSLoader::Format::RGBA16F, false, true },
+    };
+
+    for (const auto& expected : formats)
+    {
+        const std::vector< unsigned char > contents = MakeDDS( 130, 66, 8, "DX10", 0, expected.dxgiFormat, 0, 1, expected.format, 1 );
+        DDSLoader::Output output;
+        int width = 0, height = 0;
+        bool opaque = false;
+
+        if (DDSLoader::Load( contents.data(), contents.size(), "test.dds", width, height, opaque, output ) != DDSLoader::LoadResult::Success ||
+            output.format != expected.format || output.isSRGB != expected.isSRGB || opaque != expected.isOpaque || width != 130 || height != 66 ||
+            output.mipCount != 8 || output.layerCount != 1 || output.isCube || output.data != contents.data() || !HasLayout( output, width, height, 148 ))
+        {
+            std::printf( "DXGI format %u was not loaded correctly!\n", expected.dxgiFormat );
+            return false;
+        }
+    }
+
+    // Unsupported formats and 3D textures are rejected.
+    const std::vector< unsigned char > rgba = MakeDDS( 4, 4, 1, "DX10", 0, 28, 0, 1, DDSLoader::Format::BC1, 1 );
+    std::vector< unsigned char > volume = MakeDDS( 4, 4, 1, "DX10", 0, 71, 0, 1, DDSLoader::Format::BC1, 1 );
+    volume[ 132 ] = 4;
+    DDSLoader::Output output;
+    int width, height;
+    bool opaque;
+
+    if (DDSLoader::Load( rgba.data(), rgba.size(), "rgba.dds", width, height, opaque, output ) == DDSLoader::LoadResult::Success ||
+        DDSLoader::Load( volume.data(), volume.size(), "volume.dds", width, height, opaque, output ) == DDSLoader::LoadResult::Success)
+    {
+        std::printf( "Unsupported DX10 file was loaded!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestArraysAndCubeMaps()
+{
+    DDSLoader::Output output;
+    int width, height;
+    bool opaque;
+
+    const std::vector< unsigned char > array = MakeDDS( 20, 12, 5, "DX10", 0, 71, 0, 3, DDSLoader::Format::BC1, 3 );
+
+    if (DDSLoader::Load( array.data(), array.size(), "array.dds", width, height, opaque, output ) != DDSLoader::LoadResult::Success ||
+        output.layerCount != 3 || output.isCube || !HasLayout( output, width, height, 148 ))
+    {
+        std::printf( "Texture array was not loaded correctly!\n" );
+        return false;
+    }
+
+    const std::vector< unsigned char > cubeArray = MakeDDS( 16, 16, 5, "DX10", 0, 98, 0x4, 2, DDSLoader::Format::BC7, 12 );
+
+    if (DDSLoader::Load( cubeArray.data(), cubeArray.size(), "cubearray.dds", width, height, opaque, output ) != DDSLoader::LoadResult::Success ||
+        output.layerCount != 12 || !output.isCube || !HasLayout( output, width, height, 148 ))
+    {
+        std::printf( "DX10 cube map array was not loaded correctly!\n" );
+        return false;
+    }
+
+    const std::uint32_t allFaces = 0x200 | 0x400 | 0x800 | 0x1000 | 0x2000 | 0x4000 | 0x8000;
+    const std::vector< unsigned char > legacyCube = MakeDDS( 8, 8, 4, "DXT1", allFaces, 0, 0, 0, DDSLoader::Format::BC1, 6 );
+
+    if (DDSLoader::Load( legacyCube.data(), legacyCube.size(), "cube.dds", width, height, opaque, output ) != DDSLoader::LoadResult::Success ||
+        output.layerCount != 6 || !output.isCube || output.format != DDSLoader::Format::BC1 || !HasLayout( output, width, height, 128 ))
+    {
+        std::printf( "Legacy cube map was not loaded correctly!\n" );
+        return false;
+    }
+
+    const std::vector< unsigned char > partialCube = MakeDDS( 8, 8, 4, "DXT1", 0x200 | 0x400, 0, 0, 0, DDSLoader::Format::BC1, 6 );
+
+    if (DDSLoader::Load( partialCube.data(), partialCube.size(), "partial.dds", width, height, opaque, output ) == DDSLoader::LoadResult::Success)
+    {
+        std::printf( "Cube map without all faces was loaded!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestTruncated()
+{
+    DDSLoader::Output output;
+    int width, height;
+    bool opaque;
+
+    const std::vector< unsigned char > cube = MakeDDS( 64, 64, 7, "DX10", 0, 83, 0x4, 1, DDSLoader::Format::BC5U, 6 );
+
+    for (std::size_t size : { std::size_t( 0 ), std::size_t( 100 ), std::size_t( 140 ), cube.size() / 2, cube.size() - 1 })
+    {
+        if (DDSLoader::Load( cube.data(), size, "truncated.dds", width, height, opaque, output ) == DDSLoader::LoadResult::Success)
+        {
+            std::printf( "File truncated to %u bytes was loaded!\n", (unsigned)size );
+            return false;
+        }
+    }
+
+    std::vector< unsigned char > huge = MakeDDS( 4, 4, 1, "DXT1", 0, 0, 0, 0, DDSLoader::Format::BC1, 1 );
+    huge[ 12 ] = huge[ 13 ] = huge[ 14 ] = huge[ 15 ] = 0xFF;
+
+    if (DDSLoader::Load( huge.data(), huge.size(), "huge.dds", width, height, opaque, output ) == DDSLoader::LoadResult::Success)
+    {
+        std::printf( "File with a corrupted height was loaded!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestFiles()
+{
+    const std::vector< unsigned char > bc4 = MakeDDS( 37, 19, 6, "DX10", 0, 80, 0, 1, DDSLoader::Format::BC4U, 1 );
+    std::ofstream( "test_dds_loader.dds", std::ios::binary ).write( reinterpret_cast< const char* >( bc4.data() ), bc4.size() );
+
+    DDSLoader::Output viewOutput;
+    int viewWidth, viewHeight;
+    bool viewOpaque;
+    const ae3d::FileSystem::FileView view = ae3d::FileSystem::OpenFileView( "test_dds_loader.dds" );
+
+    if (DDSLoader::Load( view, viewWidth, viewHeight, viewOpaque, viewOutput ) != DDSLoader::LoadResult::Success || viewOutput.format != DDSLoader::Format::BC4U ||
+        viewOutput.mipCount != 6 || viewOutput.data != view.GetData() || viewOutput.imageData.count != 0 || !HasLayout( viewOutput, viewWidth, viewHeight, 148 ))
+    {
+        std::printf( "File view was not loaded in place!\n" );
+        return false;
+    }
+
+    DDSLoader::Output copyOutput;
+    int copyWidth, copyHeight;
+    bool copyOpaque;
+    const ae3d::FileSystem::FileContentsData contents = ae3d::FileSystem::FileContents( "test_dds_loader.dds" );
+
+    if (DDSLoader::Load( contents, copyWidth, copyHeight, copyOpaque, copyOutput ) != DDSLoader::LoadResult::Success ||
+        copyOutput.data != copyOutput.imageData.elements || copyOutput.imageData.count != contents.data.size() ||
+        std::memcmp( copyOutput.data, view.GetData(), view.GetSize() ) != 0 || !HasLayout( copyOutput, copyWidth, copyHeight, 148 ))
+    {
+        std::printf( "File contents were not copied!\n" );
+        return false;
+    }
+
+    std::remove( "test_dds_loader.dds" );
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestMipSizes();
+    result &= TestDX10();
+    result &= TestArraysAndCubeMaps();
+    result &= TestTruncated();
+    result &= TestFiles();
+
+    if (!result)
+    {
+        std::printf( "DDSLoader tests failed!\n" );
+        return 1;
+    }
+
+    return 0;
+}
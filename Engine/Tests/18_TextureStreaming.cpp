@@ -0,0 +1,311 @@
+// Tests TextureStreamer load priority, budget eviction and failed loads with a simulated residency backend. Doesn't need a window or GPU.
+#include <atomic>
+#include <iostream>
+#include <vector>
+#include "AsyncLoader.hpp"
+#include "TextureStreamer.hpp"
+
+using namespace ae3d;
+
+namespace
+{
+    // Simulated GPU texture: the backend's view of which mip levels are resident.
+    struct SimulatedTexture
+    {
+        TextureStreamer::Handle handle;
+        int residentMip = 0;
+        int loadCount = 0;
+        /// Loads of this and more detailed mip levels fail.
+        int missingMip = -1;
+    };
+
+    std::atomic< int > workerLoadCount( 0 );
+}
+
+static std::vector< std::size_t > GetMipSizes( int size, int& outMipCount )
+{
+    std::vector< std::size_t > mipSizes;
+
+    for (int mipSize = size; mipSize > 0; mipSize /= 2)
+    {
+        mipSizes.push_back( (std::size_t)mipSize * mipSize * 4 );
+    }
+
+    outMipCount = (int)mipSizes.size();
+    return mipSizes;
+}
+
+static std::size_t GetSize( int size, int firstMip )
+{
+    int mipCount = 0;
+    const std::vector< std::size_t > mipSizes = GetMipSizes( size, mipCount );
+    std::size_t sum = 0;
+
+    for (int mip = firstMip; mip < mipCount; ++mip)
+    {
+        sum += mipSizes[ mip ];
+    }
+
+    return sum;
+}
+
+static void Register( SimulatedTexture& texture, int size )
+{
+    TextureStreamer::Description description;
+    int mipCount = 0;
+    description.width = size;
+    description.height = size;
+    description.mipSizes = GetMipSizes( size, mipCount );
+    description.residentMip = TextureStreamer::GetInitialResidentMip( size, size, mipCount );
+    const int missingMip = texture.missingMip;
+
+    description.loadMip = [missingMip]( int mipLevel )
+    {
+        ++workerLoadCount;
+        return mipLevel > missingMip;
+    };
+
+    description.setResidentMip = [&texture]( int mipLevel )
+    {
+        if (mipLevel < texture.residentMip)
+        {
+            ++texture.loadCount;
+        }
+
+        texture.residentMip = mipLevel;
+    };
+
+    texture.residentMip = description.residentMip;
+    texture.handle = TextureStreamer::Register( description );
+}
+
+// Renders a frame: reports screen sizes, updates the streamer and waits for loads to finish.
+static void RunFrame( const std::vector< SimulatedTexture* >& textures, const std::vector< float >& screenSizes )
+{
+    for (std::size_t i = 0; i < textures.size(); ++i)
+    {
+        if (screenSizes[ i ] > 0)
+        {
+            TextureStreamer::ReportScreenSize( textures[ i ]->handle, screenSizes[ i ] );
+        }
+    }
+
+    TextureStreamer::Update();
+    AsyncLoader::Flush();
+}
+
+bool TestMips()
+{
+    TextureStreamer::SetInitialMipSize( 64 );
+
+    if (TextureStreamer::GetInitialResidentMip( 1024, 1024, 11 ) != 4 || TextureStreamer::GetInitialResidentMip( 32, 32, 6 ) != 0 ||
+        TextureStreamer::GetInitialResidentMip( 1024, 256, 11 ) != 4 || TextureStreamer::GetInitialResidentMip( 1024, 1024, 1 ) != 0)
+    {
+        std::cerr << "Wrong initial mip!" << std::endl;
+        return false;
+    }
+
+    // A 1024 texture drawn 300 pixels wide needs mip 1 (512), drawn 256 pixels wide it needs mip 2 (256).
+    if (TextureStreamer::GetDesiredMip( 1024, 1024, 11, 300 ) != 1 || TextureStreamer::GetDesiredMip( 1024, 1024, 11, 256 ) != 2 ||
+        TextureStreamer::GetDesiredMip( 1024, 1024, 11, 2000 ) != 0 || TextureStreamer::GetDesiredMip( 1024, 1024, 11, 0.1f ) != 10)
+    {
+        std::cerr << "Wrong desired mip!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestPriority()
+{
+    TextureStreamer::SetBudget( 64 * 1024 * 1024 );
+    TextureStreamer::SetMaxPendingLoads( 1 );
+
+    SimulatedTexture near, far, hidden;
+    Register( near, 1024 );
+    Register( far, 1024 );
+    Register( hidden, 1024 );
+
+    if (near.residentMip != 4 || TextureStreamer::GetMemoryUsage() != 3 * GetSize( 1024, 4 ))
+    {
+        std::cerr << "Registering didn't keep only the initial mips resident!" << std::endl;
+        return false;
+    }
+
+    const std::vector< SimulatedTexture* > textures = { &near, &far, &hidden };
+    const std::vector< float > screenSizes = { 1000, 200, 0 };
+
+    // The near texture is 4 levels too blurry and the far texture 2 levels, so the near texture loads first.
+    RunFrame( textures, screenSizes );
+
+    if (near.residentMip != 3 || far.residentMip != 4)
+    {
+        std::cerr << "Blurriest texture was not loaded first!" << std::endl;
+        return false;
+    }
+
+    RunFrame( textures, screenSizes );
+
+    // Both are 2 levels too blurry now, the larger one on screen loads first.
+    RunFrame( textures, screenSizes );
+
+    if (near.residentMip != 1 || far.residentMip != 4)
+    {
+        std::cerr << "Larger texture on screen was not loaded first!" << std::endl;
+        return false;
+    }
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        RunFrame( textures, screenSizes );
+    }
+
+    if (near.residentMip != 0 || far.residentMip != 2 || hidden.residentMip != 4 || hidden.loadCount != 0 ||
+        TextureStreamer::GetMemoryUsage() != GetSize( 1024, 0 ) + GetSize( 1024, 2 ) + GetSize( 1024, 4 ))
+    {
+        std::cerr << "Textures didn't stream to their desired mips!" << std::endl;
+        return false;
+    }
+
+    TextureStreamer::Unregister( near.handle );
+    TextureStreamer::Unregister( far.handle );
+    TextureStreamer::Unregister( hidden.handle );
+
+    if (TextureStreamer::GetMemoryUsage() != 0 || TextureStreamer::IsValid( near.handle ))
+    {
+        std::cerr << "Unregistering failed!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestBudget()
+{
+    TextureStreamer::SetMaxPendingLoads( 4 );
+
+    SimulatedTexture first, second;
+    Register( first, 1024 );
+    Register( second, 1024 );
+
+    // Room for one full texture and the initial mips of the other.
+    TextureStreamer::SetBudget( GetSize( 1024, 0 ) + GetSize( 1024, 4 ) );
+
+    const std::vector< SimulatedTexture* > textures = { &first, &second };
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        RunFrame( textures, { 1024, 0 } );
+    }
+
+    if (first.residentMip != 0 || second.residentMip != 4 || TextureStreamer::GetMemoryUsage() > TextureStreamer::GetBudget())
+    {
+        std::cerr << "First texture didn't stream in!" << std::endl;
+        return false;
+    }
+
+    // The camera turns: the first texture's levels are evicted to make room for the second one.
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        RunFrame( textures, { 0, 1024 } );
+
+        if (TextureStreamer::GetMemoryUsage() > TextureStreamer::GetBudget())
+        {
+            std::cerr << "Streaming went over budget!" << std::endl;
+            return false;
+        }
+    }
+
+    if (first.residentMip != 4 || second.residentMip != 0)
+    {
+        std::cerr << "Unused levels were not evicted for a visible texture!" << std::endl;
+        return false;
+    }
+
+    // Both visible: textures that are needed this frame don't evict each other, so nothing changes.
+    const int loadCount = second.loadCount;
+
+    for (int frame = 0; frame < 5; ++frame)
+    {
+        RunFrame( textures, { 1024, 1024 } );
+    }
+
+    if (first.residentMip != 4 || second.residentMip != 0 || second.loadCount != loadCount)
+    {
+        std::cerr << "Visible textures thrashed!" << std::endl;
+        return false;
+    }
+
+    // A lower budget evicts levels that are not needed, but never the initial ones.
+    TextureStreamer::SetBudget( 0 );
+    RunFrame( textures, { 0, 0 } );
+
+    if (first.residentMip != 4 || second.residentMip != 4 || TextureStreamer::GetMemoryUsage() != 2 * GetSize( 1024, 4 ))
+    {
+        std::cerr << "Lowering the budget didn't evict!" << std::endl;
+        return false;
+    }
+
+    TextureStreamer::Unregister( first.handle );
+    TextureStreamer::Unregister( second.handle );
+    return true;
+}
+
+bool TestFailedLoads()
+{
+    TextureStreamer::SetBudget( 64 * 1024 * 1024 );
+
+    // Levels 0 and 1 are missing, e.g. the file was truncated.
+    SimulatedTexture texture;
+    texture.missingMip = 1;
+    Register( texture, 1024 );
+    workerLoadCount = 0;
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        RunFrame( { &texture }, { 1024 } );
+    }
+
+    if (texture.residentMip != 2 || workerLoadCount != 3 || TextureStreamer::GetMemoryUsage() != GetSize( 1024, 2 ))
+    {
+        std::cerr << "Failed load was retried or its memory was not freed! Loads: " << workerLoadCount << std::endl;
+        return false;
+    }
+
+    // Unregistering while a load is pending drops the load.
+    SimulatedTexture unregistered;
+    Register( unregistered, 1024 );
+    TextureStreamer::ReportScreenSize( unregistered.handle, 1024 );
+    TextureStreamer::Update();
+    TextureStreamer::Unregister( unregistered.handle );
+    AsyncLoader::Flush();
+
+    if (unregistered.residentMip != 4 || TextureStreamer::GetPendingCount() != 0 || TextureStreamer::GetMemoryUsage() != GetSize( 1024, 2 ))
+    {
+        std::cerr << "Load of an unregistered texture was not dropped!" << std::endl;
+        return false;
+    }
+
+    TextureStreamer::Unregister( texture.handle );
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestMips();
+    result &= TestPriority();
+    result &= TestBudget();
+    result &= TestFailedLoads();
+
+    AsyncLoader::Deinit();
+
+    if (!result)
+    {
+        std::cerr << "TextureStreamer tests failed!" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
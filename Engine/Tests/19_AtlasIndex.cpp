@@ -0,0 +1,195 @@
+// Tests AtlasIndex XML parsing, binary index round trip and compares cached lookups against scanning the metadata for each sprite. Doesn't need a window or GPU.
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "AtlasIndex.hpp"
+
+using namespace ae3d;
+
+static std::vector< unsigned char > ToData( const std::string& text )
+{
+    return std::vector< unsigned char >( text.begin(), text.end() );
+}
+
+static bool HasRect( const AtlasIndex& index, const char* name, int x, int y, int width, int height )
+{
+    const AtlasIndex::Rect* rect = index.Find( name );
+    return rect != nullptr && rect->x == x && rect->y == y && rect->width == width && rect->height == height;
+}
+
+// The way LoadFromAtlas found a sprite before the index: scan the whole metadata for the name.
+static bool ScanForSprite( const std::string& metaData, const std::string& spriteName, AtlasIndex::Rect& outRect )
+{
+    const std::string needle = "Name=\"" + spriteName + "\"";
+    const std::size_t pos = metaData.find( needle );
+
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+
+    const std::size_t tagEnd = metaData.find( '>', pos );
+    const std::size_t tagBegin = metaData.rfind( '<', pos );
+    AtlasIndex element;
+    const std::vector< unsigned char > elementData = ToData( metaData.substr( tagBegin, tagEnd - tagBegin + 1 ) );
+
+    if (!element.Load( elementData.data(), elementData.size() ))
+    {
+        return false;
+    }
+
+    outRect = *element.Find( spriteName );
+    return true;
+}
+
+bool TestXML()
+{
+    const std::string xml =
+        "<?xml version=\"1.0\" ?>\n"
+        "<Imageset Name=\"atlas\" Imagefile=\"atlas.png\">\n"
+        "    <Image Name=\"grass\" XPos=\"0\" YPos=\"0\" Width=\"64\" Height=\"32\" />\n"
+        "    <Image Height=\"16\" Width=\"8\" YPos=\"32\" XPos=\"64\" Name=\"rock\"/>\n"
+        "    <Image\n\tname='sky' xPos='128' yPos='64' width='256' height='128'/>\n"
+        "</Imageset>\n";
+
+    const std::vector< unsigned char > data = ToData( xml );
+    AtlasIndex index;
+
+    if (!index.Load( data.data(), data.size() ) || index.GetCount() != 3)
+    {
+        std::cerr << "Wrong sprite count: " << index.GetCount() << std::endl;
+        return false;
+    }
+
+    if (!HasRect( index, "grass", 0, 0, 64, 32 ) || !HasRect( index, "rock", 64, 32, 8, 16 ) || !HasRect( index, "sky", 128, 64, 256, 128 ))
+    {
+        std::cerr << "Wrong sprite rectangle!" << std::endl;
+        return false;
+    }
+
+    if (index.Find( "atlas" ) != nullptr || index.Find( "missing" ) != nullptr)
+    {
+        std::cerr << "Found a sprite that is not in the atlas!" << std::endl;
+        return false;
+    }
+
+    const std::vector< unsigned char > empty = ToData( "<Imageset Name=\"atlas\"></Imageset>" );
+
+    if (index.Load( empty.data(), empty.size() ) || index.GetCount() != 0)
+    {
+        std::cerr << "Metadata without sprites was accepted!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool TestBinary()
+{
+    AtlasIndex index;
+    AtlasIndex::Rect rect;
+    rect.x = 1;
+    rect.y = 2;
+    rect.width = 300;
+    rect.height = 4000;
+    index.Add( "b", rect );
+    rect.x = 65535;
+    index.Add( "a", rect );
+
+    std::vector< unsigned char > data;
+    index.WriteBinary( data );
+
+    AtlasIndex loaded;
+
+    if (!AtlasIndex::IsBinary( data.data(), data.size() ) || !loaded.Load( data.data(), data.size() ) || loaded.GetCount() != 2 ||
+        !HasRect( loaded, "a", 65535, 2, 300, 4000 ) || !HasRect( loaded, "b", 1, 2, 300, 4000 ))
+    {
+        std::cerr << "Binary index round trip failed!" << std::endl;
+        return false;
+    }
+
+    // Sorted by name so that the same atlas always writes the same file.
+    if (std::memcmp( data.data() + 14, "a", 1 ) != 0)
+    {
+        std::cerr << "Binary index is not sorted!" << std::endl;
+        return false;
+    }
+
+    for (std::size_t size = 12; size < data.size(); ++size)
+    {
+        if (loaded.Load( data.data(), size ))
+        {
+            std::cerr << "Truncated index of " << size << " bytes was accepted!" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TestLookupSpeed()
+{
+    const int spriteCount = 500;
+    std::string xml = "<Imageset Name=\"atlas\" Imagefile=\"atlas.png\">\n";
+
+    for (int i = 0; i < spriteCount; ++i)
+    {
+        xml += "    <Image Name=\"sprite" + std::to_string( i ) + "\" XPos=\"" + std::to_string( (i % 32) * 32 ) + "\" YPos=\"" +
+               std::to_string( (i / 32) * 32 ) + "\" Width=\"32\" Height=\"32\" />\n";
+    }
+
+    xml += "</Imageset>\n";
+
+    auto startTime = std::chrono::steady_clock::now();
+    int scanned = 0;
+
+    for (int i = 0; i < spriteCount; ++i)
+    {
+        AtlasIndex::Rect rect;
+        scanned += ScanForSprite( xml, "sprite" + std::to_string( i ), rect ) ? 1 : 0;
+    }
+
+    const auto scanTime = std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - startTime ).count();
+
+    startTime = std::chrono::steady_clock::now();
+    const std::vector< unsigned char > data = ToData( xml );
+    AtlasIndex index;
+    index.Load( data.data(), data.size() );
+    int found = 0;
+
+    for (int i = 0; i < spriteCount; ++i)
+    {
+        found += index.Find( "sprite" + std::to_string( i ) ) != nullptr ? 1 : 0;
+    }
+
+    const auto indexTime = std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now() - startTime ).count();
+
+    std::cout << spriteCount << " sprites: scanning for each sprite " << scanTime << " us, parsing once and looking up " << indexTime << " us" << std::endl;
+
+    if (scanned != spriteCount || found != spriteCount || !HasRect( index, "sprite33", 32, 32, 32, 32 ))
+    {
+        std::cerr << "Lookup didn't find all sprites!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool result = true;
+
+    result &= TestXML();
+    result &= TestBinary();
+    result &= TestLookupSpeed();
+
+    if (!result)
+    {
+        std::cerr << "AtlasIndex tests failed!" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
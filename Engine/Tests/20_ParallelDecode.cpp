@@ -0,0 +1,137 @@
+// Times decoding and mipmap generation of 200 textures one after another and on AsyncLoader worker threads, like Scene::Deserialize() does.
+// Images are uncompressed .tga files generated in memory. Doesn't need a window or GPU.
+// The speedup depends on the number of cores, so compare runs on the same machine. With one worker the parallel run can't be faster.
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "AsyncLoader.hpp"
+#include "MipGenerator.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.c"
+
+using namespace ae3d;
+
+namespace
+{
+    const int textureCount = 200;
+    const int textureSize = 512;
+
+    // What a worker produces for a texture.
+    struct Decoded
+    {
+        std::vector< unsigned char > mipChain;
+        bool isValid = false;
+    };
+}
+
+static std::vector< unsigned char > CreateTGA( int seed )
+{
+    std::vector< unsigned char > tga( 18 + textureSize * textureSize * 4 );
+    tga[ 2 ] = 2; // Uncompressed true-color.
+    tga[ 12 ] = textureSize & 0xFF;
+    tga[ 13 ] = textureSize >> 8;
+    tga[ 14 ] = textureSize & 0xFF;
+    tga[ 15 ] = textureSize >> 8;
+    tga[ 16 ] = 32;
+    tga[ 17 ] = 8; // Alpha bits.
+
+    std::uint32_t random = 2166136261u ^ (std::uint32_t)seed;
+
+    for (std::size_t i = 18; i < tga.size(); ++i)
+    {
+        random = random * 1664525u + 1013904223u;
+        tga[ i ] = (unsigned char)(((i / 4) % textureSize) + (random >> 28));
+    }
+
+    return tga;
+}
+
+static void Decode( const std::vector< unsigned char >& file, Decoded& outDecoded )
+{
+    int width = 0, height = 0, components = 0;
+    unsigned char* pixels = stbi_load_from_memory( file.data(), (int)file.size(), &width, &height, &components, 4 );
+
+    if (pixels == nullptr)
+    {
+        return;
+    }
+
+    MipGenerator::Settings settings;
+    settings.isSRGB = true;
+    outDecoded.mipChain.resize( MipGenerator::GetMipChainSize( width, height ) );
+    MipGenerator::Generate( pixels, width, height, settings, outDecoded.mipChain.data() );
+    outDecoded.isValid = width == textureSize && height == textureSize;
+    stbi_image_free( pixels );
+}
+
+static float GetElapsedMS( const std::chrono::steady_clock::time_point& startTime )
+{
+    return std::chrono::duration< float, std::milli >( std::chrono::steady_clock::now() - startTime ).count();
+}
+
+int main()
+{
+    std::vector< std::vector< unsigned char > > files;
+
+    for (int i = 0; i < textureCount; ++i)
+    {
+        files.push_back( CreateTGA( i ) );
+    }
+
+    std::vector< Decoded > serial( textureCount );
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < textureCount; ++i)
+    {
+        Decode( files[ i ], serial[ i ] );
+    }
+
+    const float serialMS = GetElapsedMS( startTime );
+
+    AsyncLoader::Init( 0 );
+
+    std::vector< Decoded > parallel( textureCount );
+    int finishedCount = 0;
+    startTime = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < textureCount; ++i)
+    {
+        Decoded* decoded = &parallel[ i ];
+        const std::vector< unsigned char >* file = &files[ i ];
+        AsyncLoader::Queue( [decoded, file]() { Decode( *file, *decoded ); return decoded->isValid; },
+                            [&finishedCount]( bool loaded ) { finishedCount += loaded ? 1 : 0; return loaded; } );
+    }
+
+    const float queueMS = GetElapsedMS( startTime );
+
+    AsyncLoader::Wait();
+    const float decodeMS = GetElapsedMS( startTime );
+
+    AsyncLoader::Flush();
+    const float totalMS = GetElapsedMS( startTime );
+
+    AsyncLoader::Deinit();
+
+    const unsigned workerCount = std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() - 1 : 1;
+    std::cout << textureCount << " textures of " << textureSize << "x" << textureSize << ": one after another " << serialMS << " ms, " << workerCount << " workers: queue " << queueMS
+              << " ms, decode " << decodeMS - queueMS << " ms, finish " << totalMS - decodeMS << " ms, speedup " << serialMS / totalMS << "x" << std::endl;
+
+    if (finishedCount != textureCount)
+    {
+        std::cerr << "Only " << finishedCount << " textures were decoded!" << std::endl;
+        return 1;
+    }
+
+    for (int i = 0; i < textureCount; ++i)
+    {
+        if (!serial[ i ].isValid || serial[ i ].mipChain != parallel[ i ].mipChain)
+        {
+            std::cerr << "Texture " << i << " was decoded differently on a worker!" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
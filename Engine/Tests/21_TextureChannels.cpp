@@ -0,0 +1,202 @@
+// Tests TextureChannels on a set of generated material textures: finds the expected layouts, checks that mip chains rebuilt from
+// the stored channels match the RGBA8 mip chains that Texture2D generates, and reports memory saved. Doesn't need a window or GPU.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MipGenerator.hpp"
+#include "TextureChannels.hpp"
+
+using namespace ae3d;
+
+namespace
+{
+    const int textureSize = 256;
+
+    struct Asset
+    {
+        std::string name;
+        bool isSRGB = false;
+        int expectedChannelCount = 4;
+        std::vector< unsigned char > pixels;
+    };
+}
+
+// Smooth patterns survive mipmapping like real textures. seed makes channels of the same asset differ.
+static unsigned char Pattern( int x, int y, int seed )
+{
+    return (unsigned char)(127.5f + 127.5f * std::sin( x * 0.05f * (seed + 1) + seed ) * std::cos( y * 0.07f + seed * 2 ));
+}
+
+static Asset CreateAsset( const std::string& name, bool isSRGB, int expectedChannelCount, unsigned char (*pixel)( int x, int y, int channel ) )
+{
+    Asset asset;
+    asset.name = name;
+    asset.isSRGB = isSRGB;
+    asset.expectedChannelCount = expectedChannelCount;
+    asset.pixels.resize( textureSize * textureSize * 4 );
+
+    for (int y = 0; y < textureSize; ++y)
+    {
+        for (int x = 0; x < textureSize; ++x)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                asset.pixels[ (y * textureSize + x) * 4 + c ] = pixel( x, y, c );
+            }
+        }
+    }
+
+    return asset;
+}
+
+static unsigned char Rebuild( const unsigned char* packed, const TextureChannels::Layout& layout, int channel )
+{
+    switch (layout.swizzle[ channel ])
+    {
+    case TextureChannels::Swizzle::R: return packed[ 0 ];
+    case TextureChannels::Swizzle::G: return packed[ 1 ];
+    case TextureChannels::Swizzle::B: return packed[ 2 ];
+    case TextureChannels::Swizzle::A: return packed[ 3 ];
+    case TextureChannels::Swizzle::Zero: return 0;
+    case TextureChannels::Swizzle::One: return 255;
+    }
+
+    return 0;
+}
+
+static bool TestAsset( const Asset& asset, std::size_t& outRGBASize, std::size_t& outReducedSize )
+{
+    const std::size_t pixelCount = (std::size_t)textureSize * textureSize;
+    const TextureChannels::Layout layout = TextureChannels::Analyze( asset.pixels.data(), pixelCount, asset.isSRGB );
+
+    if (layout.channelCount != asset.expectedChannelCount)
+    {
+        std::cerr << asset.name << ": expected " << asset.expectedChannelCount << " channels, got " << layout.channelCount << std::endl;
+        return false;
+    }
+
+    // Texture2D packs the whole mip chain with the layout of level 0.
+    MipGenerator::Settings settings;
+    settings.isSRGB = asset.isSRGB;
+    settings.isWrapped = true;
+    std::vector< unsigned char > mipChain( MipGenerator::GetMipChainSize( textureSize, textureSize ) );
+    MipGenerator::Generate( asset.pixels.data(), textureSize, textureSize, settings, mipChain.data() );
+
+    const std::size_t chainPixelCount = mipChain.size() / 4;
+    std::vector< unsigned char > packed( chainPixelCount * layout.channelCount );
+    TextureChannels::Pack( mipChain.data(), chainPixelCount, layout, packed.data() );
+
+    for (std::size_t i = 0; i < chainPixelCount; ++i)
+    {
+        const unsigned char* original = &mipChain[ i * 4 ];
+        const unsigned char* stored = &packed[ i * layout.channelCount ];
+
+        for (int c = 0; c < 4; ++c)
+        {
+            if (layout.isNormalMap && c == 2)
+            {
+                continue;
+            }
+
+            if (Rebuild( stored, layout, c ) != original[ c ])
+            {
+                std::cerr << asset.name << ": pixel " << i << " channel " << c << " is " << (int)Rebuild( stored, layout, c ) << " instead of " << (int)original[ c ] << std::endl;
+                return false;
+            }
+        }
+
+        // Reconstructs Z like Standard shaders do. Only level 0 has unit length normals.
+        if (layout.isNormalMap && i < pixelCount)
+        {
+            const float x = stored[ 0 ] / 127.5f - 1;
+            const float y = stored[ 1 ] / 127.5f - 1;
+            const float z = std::sqrt( std::max( 0.0f, 1 - x * x - y * y ) );
+
+            if (std::abs( z - (original[ 2 ] / 127.5f - 1) ) > 0.03f)
+            {
+                std::cerr << asset.name << ": reconstructed Z of pixel " << i << " is " << z << std::endl;
+                return false;
+            }
+        }
+    }
+
+    outRGBASize = mipChain.size();
+    outReducedSize = packed.size();
+    return true;
+}
+
+static unsigned char RoughnessPixel( int x, int y, int c ) { return c == 3 ? 255 : Pattern( x, y, 0 ); }
+static unsigned char MetallicPixel( int x, int y, int c ) { return c == 0 ? Pattern( x, y, 1 ) : (c == 3 ? 255 : 0); }
+static unsigned char MaskPixel( int x, int y, int c ) { return c == 3 ? Pattern( x, y, 2 ) : 255; }
+static unsigned char GrayAlbedoPixel( int x, int y, int c ) { return c == 3 ? 255 : Pattern( x, y, 3 ); }
+static unsigned char GrayAlphaPixel( int x, int y, int c ) { return c == 3 ? Pattern( x, y, 4 ) : Pattern( x, y, 5 ); }
+static unsigned char RoughnessMetallicPixel( int x, int y, int c ) { return c == 3 ? 255 : (c == 2 ? 0 : Pattern( x, y, c )); }
+static unsigned char OcclusionRoughnessMetallicPixel( int x, int y, int c ) { return c == 3 ? 255 : Pattern( x, y, c ); }
+static unsigned char ColorPixel( int x, int y, int c ) { return c == 3 ? 255 : Pattern( x, y, c + 6 ); }
+
+static unsigned char NormalPixel( int x, int y, int c )
+{
+    const float nx = std::sin( x * 0.1f ) * 0.5f;
+    const float ny = std::cos( y * 0.08f ) * 0.5f;
+    const float nz = std::sqrt( 1 - nx * nx - ny * ny );
+    const float n[ 4 ] = { nx, ny, nz, 1 };
+    return (unsigned char)std::lround( (n[ c ] + 1) * 127.5f );
+}
+
+int main()
+{
+    const std::vector< Asset > assets =
+    {
+        CreateAsset( "roughness", false, 1, RoughnessPixel ),
+        CreateAsset( "metallic", false, 1, MetallicPixel ),
+        CreateAsset( "alpha mask", false, 1, MaskPixel ),
+        CreateAsset( "gray albedo", true, 1, GrayAlbedoPixel ),
+        CreateAsset( "normal map", false, 2, NormalPixel ),
+        CreateAsset( "roughness+metallic", false, 2, RoughnessMetallicPixel ),
+        // Alpha would be decoded as sRGB next to color, so these keep RGBA.
+        CreateAsset( "gray albedo+alpha", true, 4, GrayAlphaPixel ),
+        CreateAsset( "occlusion+roughness+metallic", false, 4, OcclusionRoughnessMetallicPixel ),
+        CreateAsset( "color albedo", true, 4, ColorPixel ),
+    };
+
+    std::size_t totalRGBASize = 0;
+    std::size_t totalReducedSize = 0;
+    bool result = true;
+
+    for (const Asset& asset : assets)
+    {
+        std::size_t rgbaSize = 0, reducedSize = 0;
+
+        if (!TestAsset( asset, rgbaSize, reducedSize ))
+        {
+            result = false;
+            continue;
+        }
+
+        std::cout << asset.name << ": " << rgbaSize / 1024 << " KiB as RGBA8, " << reducedSize / 1024 << " KiB stored" << std::endl;
+        totalRGBASize += rgbaSize;
+        totalReducedSize += reducedSize;
+    }
+
+    if (!result)
+    {
+        std::cerr << "TextureChannels tests failed!" << std::endl;
+        return 1;
+    }
+
+    std::cout << assets.size() << " textures of " << textureSize << "x" << textureSize << " with mipmaps: " << totalRGBASize / 1024 << " KiB as RGBA8, "
+              << totalReducedSize / 1024 << " KiB stored, saved " << 100 * (totalRGBASize - totalReducedSize) / totalRGBASize << "%" << std::endl;
+
+    TextureChannels::Layout empty = TextureChannels::Analyze( nullptr, 0, false );
+
+    if (empty.channelCount != 4)
+    {
+        std::cerr << "Empty image was reduced!" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,313 @@
+// Tests FilterCubeMap's cube mapping, GGX prefiltering, irradiance SH and .dds output, and that DDSLoader loads the output as a
+// RGBA16F cube map. Doesn't need a window or GPU.
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "DDSLoader.hpp"
+#include "System.hpp"
+#include "../../Tools/CubeMapFilter/CubeMapFilter.hpp"
+
+void ae3d::System::Print( const char*, ... )
+{
+}
+
+static float HalfToFloat( std::uint16_t half )
+{
+    const float sign = (half & 0x8000) ? -1.0f : 1.0f;
+    const int exponent = (half >> 10) & 0x1F;
+    const int mantissa = half & 0x3FF;
+
+    if (exponent == 0)
+    {
+        return sign * std::ldexp( static_cast< float >( mantissa ), -24 );
+    }
+
+    return sign * std::ldexp( 1 + mantissa / 1024.0f, exponent - 15 );
+}
+
+static bool IsNear( float a, float b, float tolerance )
+{
+    return std::abs( a - b ) <= tolerance;
+}
+
+// Fills level 0 with radiance from a function of direction and makes its mip chain.
+template< typename Function >
+static CubeMipChain MakeEnvironment( int size, const Function& radiance )
+{
+    CubeLevel level;
+    level.size = size;
+
+    for (int face = 0; face < 6; ++face)
+    {
+        level.faces[ face ].resize( size * size * 3 );
+
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                float direction[ 3 ];
+                GetCubeDirection( face, (x + 0.5f) / size * 2 - 1, (y + 0.5f) / size * 2 - 1, direction );
+                Normalize( direction );
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    level.faces[ face ][ (y * size + x) * 3 + c ] = radiance( direction, c );
+                }
+            }
+        }
+    }
+
+    return DownsampleCube( level );
+}
+
+bool TestDirections()
+{
+    const float uvs[] = { -0.9f, -0.3f, 0, 0.4f, 0.8f };
+
+    for (int face = 0; face < 6; ++face)
+    {
+        for (float u : uvs)
+        {
+            for (float v : uvs)
+            {
+                float direction[ 3 ];
+                GetCubeDirection( face, u, v, direction );
+
+                float outU, outV;
+
+                if (GetCubeFace( direction, outU, outV ) != face || !IsNear( outU, u, 0.0001f ) || !IsNear( outV, v, 0.0001f ))
+                {
+                    std::printf( "Face %d u %f v %f did not map back to itself!\n", face, static_cast< double >( u ), static_cast< double >( v ) );
+                    return false;
+                }
+            }
+        }
+    }
+
+    // +Y face's top row looks towards -Z like in .dds cube maps.
+    float direction[ 3 ];
+    GetCubeDirection( 2, 0, -1, direction );
+
+    if (direction[ 1 ] <= 0 || !IsNear( direction[ 1 ], -direction[ 2 ], 0.0001f ) || direction[ 0 ] != 0)
+    {
+        std::printf( "Wrong +Y face orientation!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestEquirect()
+{
+    // Upper half is green and lower half blue. The center column is red, and it should end up in the middle of -Z.
+    const int width = 64, height = 32;
+    std::vector< float > rgb( width * height * 3 );
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            rgb[ (y * width + x) * 3 + 0 ] = (x >= width / 2 - 2 && x < width / 2 + 2) ? 1.0f : 0.0f;
+            rgb[ (y * width + x) * 3 + 1 ] = y < height / 2 ? 1.0f : 0.0f;
+            rgb[ (y * width + x) * 3 + 2 ] = y < height / 2 ? 0.0f : 1.0f;
+        }
+    }
+
+    const CubeLevel level = EquirectToCube( rgb.data(), width, height, 16 );
+    const std::size_t center = (8 * 16 + 8) * 3;
+
+    if (level.size != 16 || level.faces[ 2 ][ center + 1 ] != 1 || level.faces[ 3 ][ center + 2 ] != 1 ||
+        level.faces[ 5 ][ center ] < 0.5f || level.faces[ 4 ][ center ] != 0 || level.faces[ 0 ][ center ] != 0)
+    {
+        std::printf( "Equirectangular image was not mapped to the right faces!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestPrefilter()
+{
+    // Prefiltering can only average radiance, so a constant environment stays constant at every roughness.
+    const CubeMipChain chain = PrefilterGGX( MakeEnvironment( 32, []( const float*, int c ) { return 0.5f + c; } ), 32 );
+
+    if (chain.size() != 6 || chain.back().size != 1)
+    {
+        std::printf( "Wrong mip chain size %d!\n", static_cast< int >( chain.size() ) );
+        return false;
+    }
+
+    for (const CubeLevel& level : chain)
+    {
+        for (int face = 0; face < 6; ++face)
+        {
+            for (std::size_t i = 0; i < level.faces[ face ].size(); ++i)
+            {
+                if (!IsNear( level.faces[ face ][ i ], 0.5f + i % 3, 0.001f ))
+                {
+                    std::printf( "Level of size %d changed a constant environment!\n", level.size );
+                    return false;
+                }
+            }
+        }
+    }
+
+    // A bright +Y hemisphere leaks into the lower hemisphere only in rough levels.
+    const CubeMipChain sky = PrefilterGGX( MakeEnvironment( 32, []( const float* direction, int ) { return direction[ 1 ] > 0 ? 1.0f : 0.0f; } ), 64 );
+    const float down[ 3 ] = { 0, -1, 0 };
+    const float side[ 3 ] = { 1, -0.05f, 0 };
+    float smooth[ 3 ], rough[ 3 ], below[ 3 ];
+    SampleCube( sky, side, 1, smooth );
+    SampleCube( sky, side, static_cast< float >( sky.size() - 1 ), rough );
+    SampleCube( sky, down, static_cast< float >( sky.size() - 1 ), below );
+
+    if (smooth[ 0 ] >= rough[ 0 ] || below[ 0 ] >= rough[ 0 ])
+    {
+        std::printf( "Rough levels are not blurrier: smooth %f, rough %f, below %f\n", static_cast< double >( smooth[ 0 ] ), static_cast< double >( rough[ 0 ] ),
+                     static_cast< double >( below[ 0 ] ) );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestIrradiance()
+{
+    // Constant radiance 1 gives irradiance pi in every direction.
+    float coefficients[ 9 ][ 3 ];
+    ProjectIrradianceSH( MakeEnvironment( 32, []( const float*, int ) { return 1.0f; } )[ 0 ], coefficients );
+
+    const float directions[][ 3 ] = { { 1, 0, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0.577f, 0.577f, -0.577f } };
+
+    for (const auto& direction : directions)
+    {
+        float irradiance[ 3 ];
+        EvaluateSH( coefficients, direction, irradiance );
+
+        if (!IsNear( irradiance[ 0 ], cubePi, 0.01f ) || !IsNear( irradiance[ 2 ], cubePi, 0.01f ))
+        {
+            std::printf( "Constant irradiance is %f, expected %f!\n", static_cast< double >( irradiance[ 0 ] ), static_cast< double >( cubePi ) );
+            return false;
+        }
+    }
+
+    // Radiance 1 + y gives irradiance pi + 2pi/3 from above and pi - 2pi/3 from below.
+    ProjectIrradianceSH( MakeEnvironment( 32, []( const float* direction, int ) { return 1 + direction[ 1 ]; } )[ 0 ], coefficients );
+
+    const float up[ 3 ] = { 0, 1, 0 };
+    const float down[ 3 ] = { 0, -1, 0 };
+    float upIrradiance[ 3 ], downIrradiance[ 3 ];
+    EvaluateSH( coefficients, up, upIrradiance );
+    EvaluateSH( coefficients, down, downIrradiance );
+
+    if (!IsNear( upIrradiance[ 1 ], cubePi * 5 / 3, 0.02f ) || !IsNear( downIrradiance[ 1 ], cubePi / 3, 0.02f ))
+    {
+        std::printf( "Linear irradiance is %f from above and %f from below!\n", static_cast< double >( upIrradiance[ 1 ] ), static_cast< double >( downIrradiance[ 1 ] ) );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestHalfFloats()
+{
+    const float values[] = { 0, 1, -2.5f, 0.1f, 1000, 0.00003f };
+
+    for (float value : values)
+    {
+        if (!IsNear( HalfToFloat( FloatToHalf( value ) ), value, std::abs( value ) / 1024 + 0.0000001f ))
+        {
+            std::printf( "%f did not survive a half float round trip!\n", static_cast< double >( value ) );
+            return false;
+        }
+    }
+
+    if (FloatToHalf( 100000 ) != 0x7BFF || FloatToHalf( NAN ) != 0 || FloatToHalf( 1 ) != 0x3C00)
+    {
+        std::printf( "Wrong half float clamping!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+bool TestDDSOutput()
+{
+    const CubeMipChain chain = MakeEnvironment( 16, []( const float* direction, int c ) { return direction[ c ] * 0.5f + 0.5f; } );
+    const char* path = "22_CubeMapFilter.dds";
+
+    if (!WriteCubeDDSFile( path, chain ))
+    {
+        std::printf( "Could not write %s!\n", path );
+        return false;
+    }
+
+    std::ifstream file( path, std::ios::binary );
+    const std::vector< unsigned char > contents( (std::istreambuf_iterator< char >( file )), std::istreambuf_iterator< char >() );
+    std::remove( path );
+
+    DDSLoader::Output output;
+    int width = 0, height = 0;
+    bool opaque = false;
+
+    if (DDSLoader::Load( contents.data(), contents.size(), path, width, height, opaque, output ) != DDSLoader::LoadResult::Success ||
+        output.format != DDSLoader::Format::RGBA16F || !output.isCube || output.layerCount != 6 || output.mipCount != 5 || width != 16 || height != 16 ||
+        output.dataOffsets.count != 30)
+    {
+        std::printf( "DDSLoader did not load the cube map!\n" );
+        return false;
+    }
+
+    // Level 1 of -Z keeps its pixels, and alpha is 1.
+    const std::uint16_t* pixels = reinterpret_cast< const std::uint16_t* >( output.data + output.dataOffsets[ 5 * output.mipCount + 1 ] );
+
+    for (int i = 0; i < 8 * 8; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            if (!IsNear( HalfToFloat( pixels[ i * 4 + c ] ), chain[ 1 ].faces[ 5 ][ i * 3 + c ], 0.001f ))
+            {
+                std::printf( "Wrong pixel %d in -Z level 1!\n", i );
+                return false;
+            }
+        }
+
+        if (pixels[ i * 4 + 3 ] != 0x3C00)
+        {
+            std::printf( "Wrong alpha!\n" );
+            return false;
+        }
+    }
+
+    const std::size_t lastOffset = output.dataOffsets[ 29 ] + DDSLoader::GetMipSize( output.format, width, height, 4 );
+
+    if (lastOffset != contents.size())
+    {
+        std::printf( "File has %d bytes, expected %d!\n", static_cast< int >( contents.size() ), static_cast< int >( lastOffset ) );
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    if (!TestDirections() || !TestEquirect() || !TestPrefilter() || !TestIrradiance() || !TestHalfFloats() || !TestDDSOutput())
+    {
+        return 1;
+    }
+
+    // Times the tool's work for a typical environment.
+    const auto startTime = std::chrono::steady_clock::now();
+    const CubeMipChain chain = PrefilterGGX( MakeEnvironment( 128, []( const float* direction, int c ) { return std::exp( direction[ c ] * 4 ); } ), 64 );
+    float coefficients[ 9 ][ 3 ];
+    ProjectIrradianceSH( chain[ 0 ], coefficients );
+    const float ms = std::chrono::duration< float, std::milli >( std::chrono::steady_clock::now() - startTime ).count();
+
+    std::printf( "Prefiltered a 128x128 cube map with %d levels and projected its irradiance in %.1f ms\n", static_cast< int >( chain.size() ), static_cast< double >( ms ) );
+    return 0;
+}
@@ -0,0 +1,310 @@
+// Tests SpriteBatch's slots, changed vertex ranges and per-texture draw ranges, and times 100k sprites of which 1% move every
+// frame against rebuilding all of them like SpriteRendererComponent used to. Doesn't need a window or GPU.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "SpriteBatch.hpp"
+
+using namespace ae3d;
+
+namespace
+{
+    const int spriteCount = 100000;
+    const int textureCount = 7;
+    const int frameCount = 100;
+    const int movedPerFrame = spriteCount / 100;
+
+    // Only compared, never dereferenced.
+    char textureStorage[ textureCount ];
+
+    TextureBase* GetTexture( int index )
+    {
+        return reinterpret_cast< TextureBase* >( &textureStorage[ index ] );
+    }
+
+    // Texture IDs are not in pointer order, so draw ranges must be sorted by ID.
+    unsigned GetTextureId( int index )
+    {
+        return static_cast< unsigned >( textureCount - index );
+    }
+
+    Vec3 GetPosition( int sprite, int frame )
+    {
+        return Vec3( static_cast< float >( (sprite * 7 + frame) % 1920 ), static_cast< float >( (sprite / 3 + frame * 5) % 1080 ), -0.5f );
+    }
+
+    struct Sprite
+    {
+        TextureBase* texture;
+        unsigned textureId;
+        Vec3 position;
+    };
+}
+
+static float GetElapsedMS( const std::chrono::steady_clock::time_point& startTime )
+{
+    return std::chrono::duration< float, std::milli >( std::chrono::steady_clock::now() - startTime ).count();
+}
+
+// Checks that draw ranges cover every sprite once with its texture and are ordered by texture ID.
+static bool HasValidDrawRanges( const SpriteBatch& batch, const std::vector< int >& slotTextures )
+{
+    const auto& ranges = batch.GetDrawRanges();
+    const auto& faces = batch.GetFaces();
+    std::vector< int > faceCountPerSlot( slotTextures.size() );
+    int expectedStart = 0;
+
+    for (std::size_t r = 0; r < ranges.size(); ++r)
+    {
+        if (ranges[ r ].faceStart != expectedStart || ranges[ r ].faceEnd <= ranges[ r ].faceStart)
+        {
+            std::printf( "Draw range %d has faces %d - %d, expected to start at %d!\n", static_cast< int >( r ), ranges[ r ].faceStart, ranges[ r ].faceEnd, expectedStart );
+            return false;
+        }
+
+        if (r > 0 && GetTextureId( static_cast< int >( reinterpret_cast< char* >( ranges[ r ].texture ) - textureStorage ) ) <=
+                     GetTextureId( static_cast< int >( reinterpret_cast< char* >( ranges[ r - 1 ].texture ) - textureStorage ) ))
+        {
+            std::printf( "Draw ranges are not ordered by texture ID!\n" );
+            return false;
+        }
+
+        for (int f = ranges[ r ].faceStart; f < ranges[ r ].faceEnd; ++f)
+        {
+            const int slot = static_cast< int >( faces[ f ].a / 4 );
+
+            if (faces[ f ].b / 4 != faces[ f ].a / 4 || faces[ f ].c / 4 != faces[ f ].a / 4 || slotTextures[ slot ] < 0 ||
+                GetTexture( slotTextures[ slot ] ) != ranges[ r ].texture)
+            {
+                std::printf( "Face %d uses a sprite with another texture!\n", f );
+                return false;
+            }
+
+            ++faceCountPerSlot[ slot ];
+        }
+
+        expectedStart = ranges[ r ].faceEnd;
+    }
+
+    for (std::size_t slot = 0; slot < slotTextures.size(); ++slot)
+    {
+        if (faceCountPerSlot[ slot ] != (slotTextures[ slot ] < 0 ? 0 : 2))
+        {
+            std::printf( "Slot %d has %d faces!\n", static_cast< int >( slot ), faceCountPerSlot[ slot ] );
+            return false;
+        }
+    }
+
+    return expectedStart == static_cast< int >( faces.size() );
+}
+
+bool TestSlots()
+{
+    SpriteBatch batch;
+    std::vector< int > slotTextures;
+
+    for (int i = 0; i < spriteCount; ++i)
+    {
+        const int texture = (i * 13) % textureCount;
+        const int slot = batch.Add( GetTexture( texture ), GetTextureId( texture ), Vec4( 0.5f, 0.25f, 0.5f, 0 ), GetPosition( i, 0 ), Vec3( 16, 8, 1 ), Vec4( 1, 1, 1, 1 ) );
+
+        if (slot != i)
+        {
+            std::printf( "Sprite %d got slot %d!\n", i, slot );
+            return false;
+        }
+
+        slotTextures.push_back( texture );
+    }
+
+    // Everything is new, so vertices are uploaded with one copy. Indices go past 16 bits.
+    if (!batch.Update() || batch.GetChangedVertexRanges().size() != 1 || batch.GetChangedVertexRanges()[ 0 ].vertexCount != spriteCount * 4 ||
+        batch.GetDrawRanges().size() != textureCount || batch.GetFaces().back().a < 65536 || !HasValidDrawRanges( batch, slotTextures ))
+    {
+        std::printf( "First update is wrong!\n" );
+        return false;
+    }
+
+    const std::vector< VertexBuffer::Face32 > facesBeforeMove = batch.GetFaces();
+
+    // Moving sprites 10, 11, 12 and 500 changes two vertex ranges and no faces.
+    const int moved[] = { 12, 500, 10, 11 };
+
+    for (int sprite : moved)
+    {
+        batch.SetPosition( sprite, Vec3( 100, 200, -0.5f ) );
+    }
+
+    batch.SetPosition( 11, Vec3( 300, 400, -0.5f ) );
+
+    if (batch.Update() || batch.GetChangedVertexRanges().size() != 2 || batch.GetChangedVertexRanges()[ 0 ].firstVertex != 40 ||
+        batch.GetChangedVertexRanges()[ 0 ].vertexCount != 12 || batch.GetChangedVertexRanges()[ 1 ].firstVertex != 2000 ||
+        batch.GetChangedVertexRanges()[ 1 ].vertexCount != 4 || batch.GetFaces().size() != facesBeforeMove.size() ||
+        std::memcmp( batch.GetFaces().data(), facesBeforeMove.data(), facesBeforeMove.size() * sizeof( VertexBuffer::Face32 ) ) != 0)
+    {
+        std::printf( "Moving sprites changed the wrong ranges or faces!\n" );
+        return false;
+    }
+
+    const VertexBuffer::VertexPTC* quad = &batch.GetVertices()[ 11 * 4 ];
+
+    if (quad[ 0 ].position.x != 300 || quad[ 0 ].position.y != 400 || quad[ 2 ].position.x != 316 || quad[ 2 ].position.y != 408 ||
+        quad[ 1 ].u != 1 || quad[ 2 ].v != 0.25f || quad[ 3 ].u != 0.5f)
+    {
+        std::printf( "Moved sprite has wrong vertices!\n" );
+        return false;
+    }
+
+    if (batch.Update() || !batch.GetChangedVertexRanges().empty())
+    {
+        std::printf( "Nothing changed, but Update() found changes!\n" );
+        return false;
+    }
+
+    // Removed slots are reused, and faces are rebuilt.
+    batch.Remove( 20 );
+    batch.Remove( 30 );
+    batch.Remove( 30 );
+    slotTextures[ 20 ] = -1;
+    slotTextures[ 30 ] = -1;
+
+    if (!batch.Update() || batch.GetSpriteCount() != spriteCount - 2 || !HasValidDrawRanges( batch, slotTextures ))
+    {
+        std::printf( "Removing sprites is wrong!\n" );
+        return false;
+    }
+
+    const int reused = batch.Add( GetTexture( 0 ), GetTextureId( 0 ), Vec4( 1, 1, 0, 0 ), Vec3( 0, 0, 0 ), Vec3( 4, 4, 1 ), Vec4( 1, 1, 1, 1 ) );
+    slotTextures[ reused ] = 0;
+
+    if ((reused != 20 && reused != 30) || !batch.Update() || batch.GetSpriteCount() != spriteCount - 1 || !HasValidDrawRanges( batch, slotTextures ))
+    {
+        std::printf( "Adding into a removed slot is wrong!\n" );
+        return false;
+    }
+
+    batch.Clear();
+
+    if (!batch.IsEmpty() || batch.Update() || !batch.GetFaces().empty() || !batch.GetDrawRanges().empty())
+    {
+        std::printf( "Clear() left sprites!\n" );
+        return false;
+    }
+
+    return true;
+}
+
+// What SpriteRendererComponent did before SpriteBatch: sorts sprites by texture and generates all vertices and faces.
+static void RebuildAll( std::vector< Sprite >& sprites, std::vector< VertexBuffer::VertexPTC >& vertices, std::vector< VertexBuffer::Face32 >& faces )
+{
+    std::sort( sprites.begin(), sprites.end(), []( const Sprite& a, const Sprite& b ) { return a.textureId < b.textureId; } );
+    vertices.resize( sprites.size() * 4 );
+    faces.resize( sprites.size() * 2 );
+
+    for (std::size_t i = 0; i < sprites.size(); ++i)
+    {
+        const Vec3& p = sprites[ i ].position;
+        vertices[ i * 4 + 0 ].position = p;
+        vertices[ i * 4 + 1 ].position = p + Vec3( 16, 0, 0 );
+        vertices[ i * 4 + 2 ].position = p + Vec3( 16, 8, 0 );
+        vertices[ i * 4 + 3 ].position = p + Vec3( 0, 8, 0 );
+
+        for (int v = 0; v < 4; ++v)
+        {
+            vertices[ i * 4 + v ].u = (v == 1 || v == 2) ? 1.0f : 0.0f;
+            vertices[ i * 4 + v ].v = v >= 2 ? 1.0f : 0.0f;
+            vertices[ i * 4 + v ].color = Vec4( 1, 1, 1, 1 );
+        }
+
+        const unsigned first = static_cast< unsigned >( i ) * 4;
+        faces[ i * 2 + 0 ] = VertexBuffer::Face32( first, first + 1, first + 2 );
+        faces[ i * 2 + 1 ] = VertexBuffer::Face32( first + 2, first + 3, first );
+    }
+}
+
+int main()
+{
+    if (!TestSlots())
+    {
+        return 1;
+    }
+
+    // Stands in for the mapped GPU buffer that changed ranges are copied into.
+    std::vector< VertexBuffer::VertexPTC > gpuVertices( spriteCount * 4 );
+    std::vector< VertexBuffer::Face32 > gpuFaces( spriteCount * 2 );
+
+    std::vector< Sprite > sprites( spriteCount );
+    SpriteBatch batch;
+
+    for (int i = 0; i < spriteCount; ++i)
+    {
+        const int texture = (i * 13) % textureCount;
+        sprites[ i ] = { GetTexture( texture ), GetTextureId( texture ), GetPosition( i, 0 ) };
+        batch.Add( GetTexture( texture ), GetTextureId( texture ), Vec4( 1, 1, 0, 0 ), GetPosition( i, 0 ), Vec3( 16, 8, 1 ), Vec4( 1, 1, 1, 1 ) );
+    }
+
+    batch.Update();
+
+    std::uint64_t rebuildBytes = 0;
+    std::vector< VertexBuffer::VertexPTC > vertices;
+    std::vector< VertexBuffer::Face32 > faces;
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int frame = 1; frame <= frameCount; ++frame)
+    {
+        for (int m = 0; m < movedPerFrame; ++m)
+        {
+            sprites[ (frame * 7919 + m * 97) % spriteCount ].position = GetPosition( m, frame );
+        }
+
+        RebuildAll( sprites, vertices, faces );
+        std::copy( vertices.begin(), vertices.end(), gpuVertices.begin() );
+        std::copy( faces.begin(), faces.end(), gpuFaces.begin() );
+        rebuildBytes += vertices.size() * sizeof( VertexBuffer::VertexPTC ) + faces.size() * sizeof( VertexBuffer::Face32 );
+    }
+
+    const float rebuildMS = GetElapsedMS( startTime ) / frameCount;
+
+    // The batch's first Update() uploads everything.
+    std::copy( batch.GetVertices().begin(), batch.GetVertices().end(), gpuVertices.begin() );
+    std::copy( batch.GetFaces().begin(), batch.GetFaces().end(), gpuFaces.begin() );
+
+    std::uint64_t incrementalBytes = 0;
+    startTime = std::chrono::steady_clock::now();
+
+    for (int frame = 1; frame <= frameCount; ++frame)
+    {
+        for (int m = 0; m < movedPerFrame; ++m)
+        {
+            batch.SetPosition( (frame * 7919 + m * 97) % spriteCount, GetPosition( m, frame ) );
+        }
+
+        if (batch.Update())
+        {
+            std::printf( "Moving sprites rebuilt faces!\n" );
+            return 1;
+        }
+
+        for (const auto& range : batch.GetChangedVertexRanges())
+        {
+            std::copy_n( &batch.GetVertices()[ range.firstVertex ], range.vertexCount, &gpuVertices[ range.firstVertex ] );
+            incrementalBytes += range.vertexCount * sizeof( VertexBuffer::VertexPTC );
+        }
+    }
+
+    const float incrementalMS = GetElapsedMS( startTime ) / frameCount;
+
+    if (std::memcmp( gpuVertices.data(), batch.GetVertices().data(), gpuVertices.size() * sizeof( VertexBuffer::VertexPTC ) ) != 0)
+    {
+        std::printf( "Uploaded vertices differ from the batch!\n" );
+        return 1;
+    }
+
+    std::printf( "%d sprites, %d moving per frame: rebuilding all %.2f ms and %.1f MB per frame, incremental %.3f ms and %.1f KB per frame, speedup %.0fx\n",
+                 spriteCount, movedPerFrame, static_cast< double >( rebuildMS ), static_cast< double >( rebuildBytes ) / frameCount / (1024 * 1024),
+                 static_cast< double >( incrementalMS ), static_cast< double >( incrementalBytes ) / frameCount / 1024, static_cast< double >( rebuildMS / incrementalMS ) );
+    return 0;
+}
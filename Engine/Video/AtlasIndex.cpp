@@ -0,0 +1,251 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "AtlasIndex.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace AtlasIndexGlobal
+{
+    const char magic[ 4 ] = { 'A', 'E', 'A', 'I' };
+    const std::uint32_t version = 1;
+}
+
+static std::uint32_t ReadUint( const unsigned char* data, int byteCount )
+{
+    std::uint32_t value = 0;
+
+    for (int i = 0; i < byteCount; ++i)
+    {
+        value |= static_cast< std::uint32_t >( data[ i ] ) << (i * 8);
+    }
+
+    return value;
+}
+
+static void WriteUint( std::vector< unsigned char >& outData, std::uint32_t value, int byteCount )
+{
+    for (int i = 0; i < byteCount; ++i)
+    {
+        outData.push_back( static_cast< unsigned char >( value >> (i * 8) ) );
+    }
+}
+
+static bool IsSpace( char c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool EqualsIgnoreCase( const char* a, std::size_t length, const char* b )
+{
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        if (b[ i ] == '\0' || std::tolower( (unsigned char)a[ i ] ) != std::tolower( (unsigned char)b[ i ] ))
+        {
+            return false;
+        }
+    }
+
+    return b[ length ] == '\0';
+}
+
+bool ae3d::AtlasIndex::IsBinary( const unsigned char* data, std::size_t dataSize )
+{
+    return dataSize >= 12 && std::memcmp( data, AtlasIndexGlobal::magic, 4 ) == 0;
+}
+
+bool ae3d::AtlasIndex::Load( const unsigned char* data, std::size_t dataSize )
+{
+    rects.clear();
+
+    if (IsBinary( data, dataSize ))
+    {
+        return LoadBinary( data, dataSize );
+    }
+
+    LoadXML( data, dataSize );
+    return !rects.empty();
+}
+
+bool ae3d::AtlasIndex::LoadBinary( const unsigned char* data, std::size_t dataSize )
+{
+    if (ReadUint( data + 4, 4 ) != AtlasIndexGlobal::version)
+    {
+        return false;
+    }
+
+    const std::uint32_t count = ReadUint( data + 8, 4 );
+    std::size_t offset = 12;
+    rects.reserve( count );
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (offset + 2 > dataSize)
+        {
+            rects.clear();
+            return false;
+        }
+
+        const std::size_t nameLength = ReadUint( data + offset, 2 );
+        offset += 2;
+
+        if (offset + nameLength + 8 > dataSize)
+        {
+            rects.clear();
+            return false;
+        }
+
+        Rect rect;
+        const unsigned char* values = data + offset + nameLength;
+        rect.x = (int)ReadUint( values + 0, 2 );
+        rect.y = (int)ReadUint( values + 2, 2 );
+        rect.width = (int)ReadUint( values + 4, 2 );
+        rect.height = (int)ReadUint( values + 6, 2 );
+        rects[ std::string( reinterpret_cast< const char* >( data + offset ), nameLength ) ] = rect;
+        offset += nameLength + 8;
+    }
+
+    return true;
+}
+
+// Reads attributes of each <Image> element. Attribute names are compared without case, so CEGUI 0.8's "name" and "xPos" work too.
+void ae3d::AtlasIndex::LoadXML( const unsigned char* data, std::size_t dataSize )
+{
+    const char* text = reinterpret_cast< const char* >( data );
+    const char* end = text + dataSize;
+    const char ImageTag[] = "<Image";
+    const std::size_t ImageTagLength = sizeof( ImageTag ) - 1;
+
+    for (const char* tag = std::search( text, end, ImageTag, ImageTag + ImageTagLength ); tag != end;
+         tag = std::search( tag + ImageTagLength, end, ImageTag, ImageTag + ImageTagLength ))
+    {
+        const char* pos = tag + ImageTagLength;
+
+        // Skips <Imageset> and other elements that begin with <Image.
+        if (pos == end || !IsSpace( *pos ))
+        {
+            continue;
+        }
+
+        std::string name;
+        Rect rect;
+        bool hasName = false;
+
+        while (pos != end && *pos != '>')
+        {
+            while (pos != end && IsSpace( *pos ))
+            {
+                ++pos;
+            }
+
+            const char* key = pos;
+
+            while (pos != end && *pos != '=' && *pos != '>' && !IsSpace( *pos ))
+            {
+                ++pos;
+            }
+
+            const std::size_t keyLength = (std::size_t)(pos - key);
+
+            if (pos == end || *pos != '=' || pos + 1 == end || (pos[ 1 ] != '"' && pos[ 1 ] != '\''))
+            {
+                // "/" of a self-closing element or a malformed attribute.
+                if (pos != end && *pos != '>')
+                {
+                    ++pos;
+                }
+
+                continue;
+            }
+
+            const char quote = pos[ 1 ];
+            const char* value = pos + 2;
+            const char* valueEnd = std::find( value, end, quote );
+
+            if (EqualsIgnoreCase( key, keyLength, "Name" ))
+            {
+                name.assign( value, valueEnd );
+                hasName = true;
+            }
+            else if (EqualsIgnoreCase( key, keyLength, "XPos" ))
+            {
+                rect.x = std::atoi( std::string( value, valueEnd ).c_str() );
+            }
+            else if (EqualsIgnoreCase( key, keyLength, "YPos" ))
+            {
+                rect.y = std::atoi( std::string( value, valueEnd ).c_str() );
+            }
+            else if (EqualsIgnoreCase( key, keyLength, "Width" ))
+            {
+                rect.width = std::atoi( std::string( value, valueEnd ).c_str() );
+            }
+            else if (EqualsIgnoreCase( key, keyLength, "Height" ))
+            {
+                rect.height = std::atoi( std::string( value, valueEnd ).c_str() );
+            }
+
+            pos = valueEnd == end ? end : valueEnd + 1;
+        }
+
+        if (hasName)
+        {
+            rects[ name ] = rect;
+        }
+
+        if (pos == end)
+        {
+            break;
+        }
+    }
+}
+
+void ae3d::AtlasIndex::Add( const std::string& name, const Rect& rect )
+{
+    rects[ name ] = rect;
+}
+
+const ae3d::AtlasIndex::Rect* ae3d::AtlasIndex::Find( const std::string& name ) const
+{
+    const auto it = rects.find( name );
+    return it != std::end( rects ) ? &it->second : nullptr;
+}
+
+void ae3d::AtlasIndex::WriteBinary( std::vector< unsigned char >& outData ) const
+{
+    std::vector< const std::pair< const std::string, Rect >* > sorted;
+    sorted.reserve( rects.size() );
+
+    for (const auto& nameAndRect : rects)
+    {
+        sorted.push_back( &nameAndRect );
+    }
+
+    std::sort( std::begin( sorted ), std::end( sorted ), []( const std::pair< const std::string, Rect >* a, const std::pair< const std::string, Rect >* b )
+    {
+        return a->first < b->first;
+    } );
+
+    outData.clear();
+
+    for (char c : AtlasIndexGlobal::magic)
+    {
+        outData.push_back( static_cast< unsigned char >( c ) );
+    }
+
+    WriteUint( outData, AtlasIndexGlobal::version, 4 );
+    WriteUint( outData, (std::uint32_t)sorted.size(), 4 );
+
+    for (const auto* nameAndRect : sorted)
+    {
+        const std::string& name = nameAndRect->first;
+        const std::size_t nameLength = std::min( name.size(), (std::size_t)0xFFFF );
+        WriteUint( outData, (std::uint32_t)nameLength, 2 );
+        outData.insert( std::end( outData ), name.begin(), name.begin() + nameLength );
+        WriteUint( outData, (std::uint32_t)nameAndRect->second.x, 2 );
+        WriteUint( outData, (std::uint32_t)nameAndRect->second.y, 2 );
+        WriteUint( outData, (std::uint32_t)nameAndRect->second.width, 2 );
+        WriteUint( outData, (std::uint32_t)nameAndRect->second.height, 2 );
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ae3d
+{
+    /**
+      Sprite rectangles of a texture atlas by name. Parsed once from Ogre/CEGUI .xml metadata, or from a binary index written by
+      Tools/AtlasIndexer, so that looking up a sprite doesn't scan the metadata. Texture2D::LoadFromAtlas() caches one per metadata file.
+      Doesn't need a window or GPU.
+
+      Binary index format, little-endian: "AEAI", uint32 version, uint32 sprite count, and for each sprite
+      uint16 name length, name without terminator and uint16 x, y, width, height in pixels.
+    */
+    class AtlasIndex
+    {
+    public:
+        /// Sprite rectangle in pixels. Origin is the atlas' top left corner.
+        struct Rect
+        {
+            int x = 0;
+            int y = 0;
+            int width = 0;
+            int height = 0;
+        };
+
+        /// Replaces sprites with those in data.
+        /// \param data Binary index, or .xml metadata with an <Image Name="" XPos="" YPos="" Width="" Height=""/> element for each sprite.
+        /// \param dataSize Size of data in bytes.
+        /// \return False if data is a truncated binary index or has no sprites.
+        bool Load( const unsigned char* data, std::size_t dataSize );
+
+        /// \param data Data.
+        /// \param dataSize Size of data in bytes.
+        /// \return True if data begins with the binary index header.
+        static bool IsBinary( const unsigned char* data, std::size_t dataSize );
+
+        /// Adds a sprite or replaces a sprite that has the same name.
+        /// \param name Name.
+        /// \param rect Rectangle.
+        void Add( const std::string& name, const Rect& rect );
+
+        /// \param name Sprite name.
+        /// \return Sprite's rectangle, or null if the atlas doesn't have it.
+        const Rect* Find( const std::string& name ) const;
+
+        /// \return Number of sprites.
+        std::size_t GetCount() const { return rects.size(); }
+
+        /// \param outData Receives the binary index. Sprites are sorted by name.
+        void WriteBinary( std::vector< unsigned char >& outData ) const;
+
+    private:
+        bool LoadBinary( const unsigned char* data, std::size_t dataSize );
+        void LoadXML( const unsigned char* data, std::size_t dataSize );
+
+        std::unordered_map< std::string, Rect > rects;
+    };
+}
@@ -9,6 +9,7 @@
 #include <string>
 #include <sstream>
 #include <cmath>
+#include "AssetRegistry.hpp"
 #include "ComputeShader.hpp"
 #include "DescriptorHeapManager.hpp"
 #include "Macros.hpp"
@@ -57,6 +58,15 @@ namespace ae3d
                 stm << "draw calls: " << ::Statistics::GetDrawCalls() << "\n";
                 stm << "barrier calls: " << ::Statistics::GetBarrierCalls() << "\n";
                 stm << "triangles: " << ::Statistics::GetTriangleCount() << "\n";
+                stm << "mesh triangles per LOD:";
+
+                for (int lod = 0; lod < ::Statistics::MaxMeshLods; ++lod)
+                {
+                    stm << " " << ::Statistics::GetMeshLodTriangleCount( lod );
+                }
+
+                stm << "\n";
+                stm << "mesh CPU memory: " << ::Statistics::GetResidentMeshCpuBytes() / 1024 << " KiB\n";
                 stm << "PSO binds: " << ::Statistics::GetPSOBindCalls() << "\n";
 
 				std::strcpy( outStr, stm.str().c_str() );
@@ -1350,6 +1360,7 @@ void ae3d::GfxDevice::GetGpuMemoryUsage( unsigned& outUsedMBytes, unsigned& outB
 
 void ae3d::GfxDevice::ReleaseGPUObjects()
 {
+    AssetRegistry::ReleaseEvicted();
     VertexBuffer::DestroyBuffers();
     DestroyShaders();
     DestroyComputeShaders();
@@ -1520,6 +1531,7 @@ void ae3d::GfxDevice::Present()
     }
 
     WaitForPreviousFrame();
+    AssetRegistry::EndFrame();
 
     hr = GfxDeviceGlobal::commandListAllocator->Reset();
     AE3D_CHECK_D3D( hr, "commandListAllocator Reset" );
@@ -3,6 +3,7 @@
 #include "Texture2D.hpp"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <d3d12.h>
 #include <d3dx12.h>
 #define STB_IMAGE_IMPLEMENTATION
@@ -17,7 +18,11 @@
 
 extern ae3d::FileWatcher fileWatcher;
 bool HasStbExtension( const std::string& path ); // Defined in TextureCommon.cpp
+unsigned char* LoadSTBPixels( const ae3d::FileSystem::FileContentsData& fileContents, ae3d::DecodedImage* decoded, int& outWidth, int& outHeight, int& outComponents ); // Defined in TextureCommon.cpp
+void FreeSTBPixels( unsigned char* pixels ); // Defined in TextureCommon.cpp
 void TexReload( const std::string& path ); // Defined in TextureCommon.cpp
+ae3d::Texture2D* FindCachedTexture( const ae3d::TextureCacheKey& key, const std::string& path ); // Defined in TextureCommon.cpp
+void CacheTexture( const ae3d::TextureCacheKey& key, const ae3d::Texture2D& texture ); // Defined in TextureCommon.cpp
 float GetFloatAnisotropy( ae3d::Anisotropy anisotropy );
 void TransitionResource( GpuResource& gpuResource, D3D12_RESOURCE_STATES newState );
 
@@ -26,7 +31,8 @@ struct Textures
     std::vector< ae3d::Texture2D* > pointers;
 };
 
-std::map< std::string, Textures > textures;
+// Copies of each cached texture by TextureCacheKey::value, updated on reload.
+std::unordered_map< std::uint64_t, Textures > textures;
 
 namespace MathUtil
 {
@@ -48,7 +54,6 @@ namespace Texture2DGlobal
     std::vector< ID3D12Resource* > uploadBuffers;
     ae3d::Texture2D defaultTexture;
     
-    std::map< std::string, ae3d::Texture2D > hashToCachedTexture;
 #if DEBUG
     std::map< std::string, std::size_t > pathToCachedTextureSizeInBytes;
     
@@ -120,6 +125,14 @@ void InitializeTexture( GpuResource& gpuResource, D3D12_SUBRESOURCE_DATA* subRes
     }
 }
 
+void ae3d::Texture2D::BeginUploadBatch()
+{
+}
+
+void ae3d::Texture2D::EndUploadBatch()
+{
+}
+
 void ae3d::Texture2D::SetLayout( ae3d::TextureLayout /* layout */ )
 {
 
@@ -263,7 +276,19 @@ void ae3d::Texture2D::LoadFromData( const void* imageData, int aWidth, int aHeig
     GfxDeviceGlobal::device->CreateShaderResourceView( gpuResource.resource, &srvDesc, srv );
 }
 
-void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+// CompressTexture stores grayscale images as BC4, so its red channel is also sampled as green and blue.
+static UINT GetDDSComponentMapping( DXGI_FORMAT format )
+{
+    if (format == DXGI_FORMAT_BC4_UNORM || format == DXGI_FORMAT_BC4_SNORM)
+    {
+        return D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING( D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0, D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+                                                        D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0, D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1 );
+    }
+
+    return D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+}
+
+void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, DecodedImage* decoded, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
 {
     filter = aFilter;
     wrap = aWrap;
@@ -278,13 +303,13 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
         return;
     }
     
-    const std::string cacheHash = GetCacheHash( fileContents.path, aWrap, aFilter, aMipmaps, aColorSpace, aAnisotropy );
-    const bool isCached = Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != Texture2DGlobal::hashToCachedTexture.end();
+    const TextureCacheKey cacheKey = GetCacheKey( fileContents.path, aWrap, aFilter, aMipmaps, aColorSpace, aAnisotropy );
+    const Texture2D* cachedTexture = FindCachedTexture( cacheKey, fileContents.path );
 
-    if (isCached && handle == 0)
+    if (cachedTexture != nullptr && handle == 0)
     {
-        *this = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        textures[ cacheHash ].pointers.push_back( this );
+        *this = *cachedTexture;
+        textures[ cacheKey.value ].pointers.push_back( this );
         return;
     }
     
@@ -298,11 +323,11 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
     
     if (HasStbExtension( fileContents.path ))
     {
-        LoadSTB( fileContents );
+        LoadSTB( fileContents, decoded );
     }
     else if (isDDS)
     {
-        LoadDDS( fileContents.path.c_str() );
+        LoadDDS( fileContents, decoded );
     }
     else
     {
@@ -311,7 +336,7 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
     
     srvDesc.Format = dxgiFormat;
     srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Shader4ComponentMapping = GetDDSComponentMapping( dxgiFormat );
     srvDesc.Texture2D.MipLevels = mipLevelCount; 
     srvDesc.Texture2D.MostDetailedMip = 0;
     srvDesc.Texture2D.PlaneSlice = 0;
@@ -324,18 +349,18 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
     
     GfxDeviceGlobal::device->CreateShaderResourceView( gpuResource.resource, &srvDesc, srv );
 
-    Texture2DGlobal::hashToCachedTexture[ cacheHash ] = *this;
+    CacheTexture( cacheKey, *this );
 
     if (oldHandle != 0)
     {
-        for (std::size_t i = 0; i < textures[ cacheHash ].pointers.size(); ++i)
+        for (std::size_t i = 0; i < textures[ cacheKey.value ].pointers.size(); ++i)
         {
-            *textures[ cacheHash ].pointers[ i ] = *this;
+            *textures[ cacheKey.value ].pointers[ i ] = *this;
         }
     }
     else
     {
-        textures[ cacheHash ].pointers.push_back( this );
+        textures[ cacheKey.value ].pointers.push_back( this );
     }
 
 #if DEBUG
@@ -344,58 +369,49 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
 #endif
 }
 
-void ae3d::Texture2D::LoadDDS( const char* aPath )
+DXGI_FORMAT GetDDSFormat( DDSLoader::Format format, ae3d::ColorSpace colorSpace, int& outBytesPerPixel )
+{
+    const bool isLinear = colorSpace == ae3d::ColorSpace::Linear;
+    // Block formats have 4x4 pixels in a block, so a row of blocks has 4 times this many bytes per pixel.
+    outBytesPerPixel = format == DDSLoader::Format::RGBA16F ? 8 : DDSLoader::GetBlockSize( format ) / 4;
+
+    switch (format)
+    {
+    case DDSLoader::Format::BC1: return isLinear ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC1_UNORM_SRGB;
+    case DDSLoader::Format::BC2: return isLinear ? DXGI_FORMAT_BC2_UNORM : DXGI_FORMAT_BC2_UNORM_SRGB;
+    case DDSLoader::Format::BC3: return isLinear ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC3_UNORM_SRGB;
+    case DDSLoader::Format::BC4U: return DXGI_FORMAT_BC4_UNORM;
+    case DDSLoader::Format::BC4S: return DXGI_FORMAT_BC4_SNORM;
+    case DDSLoader::Format::BC5U: return DXGI_FORMAT_BC5_UNORM;
+    case DDSLoader::Format::BC5S: return DXGI_FORMAT_BC5_SNORM;
+    case DDSLoader::Format::BC6HU: return DXGI_FORMAT_BC6H_UF16;
+    case DDSLoader::Format::BC6HS: return DXGI_FORMAT_BC6H_SF16;
+    case DDSLoader::Format::BC7: return isLinear ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_BC7_UNORM_SRGB;
+    case DDSLoader::Format::RGBA16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    default: return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+void ae3d::Texture2D::LoadDDS( const FileSystem::FileContentsData& fileContents, const DecodedImage* /*decoded*/ )
 {
     DDSLoader::Output ddsOutput;
-    auto fileContents = FileSystem::FileContents( aPath );
     const DDSLoader::LoadResult loadResult = DDSLoader::Load( fileContents, width, height, opaque, ddsOutput );
 
     if (loadResult != DDSLoader::LoadResult::Success)
     {
-        ae3d::System::Print( "DDS Loader could not load %s", aPath );
+        ae3d::System::Print( "DDS Loader could not load %s", fileContents.path.c_str() );
         return;
     }
 
-	mipLevelCount = ddsOutput.dataOffsets.count;
-    int bytesPerPixel = 2;
+	mipLevelCount = ddsOutput.mipCount;
+    int bytesPerPixel = 0;
 
-    if (ddsOutput.format == DDSLoader::Format::BC1)
-    {
-        dxgiFormat = (colorSpace == ColorSpace::Linear) ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC1_UNORM_SRGB;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC2)
-    {
-        dxgiFormat = (colorSpace == ColorSpace::Linear) ? DXGI_FORMAT_BC2_UNORM : DXGI_FORMAT_BC2_UNORM_SRGB;
-        bytesPerPixel = 4;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC3)
-    {
-        dxgiFormat = (colorSpace == ColorSpace::Linear) ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC3_UNORM_SRGB;
-        bytesPerPixel = 4;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC4U)
-    {
-        dxgiFormat = DXGI_FORMAT_BC4_UNORM;
-        bytesPerPixel = 2;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC4S)
-    {
-        dxgiFormat = DXGI_FORMAT_BC4_SNORM;
-        bytesPerPixel = 2;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC5S)
-    {
-        dxgiFormat = DXGI_FORMAT_BC5_SNORM;
-        bytesPerPixel = 4;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC5U)
-    {
-        dxgiFormat = DXGI_FORMAT_BC5_UNORM;
-        bytesPerPixel = 4;
-    }
-    else
+    dxgiFormat = GetDDSFormat( ddsOutput.format, colorSpace, bytesPerPixel );
+
+    if (dxgiFormat == DXGI_FORMAT_UNKNOWN)
     {
-        System::Assert( false, "Unhandled DDS format!" );
+        ae3d::System::Print( "%s has unsupported DDS format\n", fileContents.path.c_str() );
+        return;
     }
 
     D3D12_RESOURCE_DESC descTex = {};
@@ -422,7 +438,7 @@ void ae3d::Texture2D::LoadDDS( const char* aPath )
     AE3D_CHECK_D3D( hr, "Unable to create texture resource" );
 
     wchar_t wstr[ 128 ];
-    std::mbstowcs( wstr, aPath, 128 );
+    std::mbstowcs( wstr, fileContents.path.c_str(), 128 );
     gpuResource.resource->SetName( wstr );
     gpuResource.usageState = D3D12_RESOURCE_STATE_COPY_DEST;
     Texture2DGlobal::textures.push_back( gpuResource.resource );
@@ -448,10 +464,10 @@ void ae3d::Texture2D::LoadDDS( const char* aPath )
     InitializeTexture( gpuResource, texResources.data(), mipLevelCount );
 }
 
-void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents )
+void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents, DecodedImage* decoded )
 {
     int components;
-    unsigned char* data = stbi_load_from_memory( fileContents.data.data(), static_cast<int>(fileContents.data.size()), &width, &height, &components, 4 );
+    unsigned char* data = LoadSTBPixels( fileContents, decoded, width, height, components );
     System::Assert( width > 0 && height > 0, "Invalid texture dimension" );
 
     if (data == nullptr)
@@ -551,5 +567,5 @@ void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents
         InitializeTexture( gpuResource, texResources.data(), mipLevelCount );
     }
 
-    stbi_image_free( data );
+    FreeSTBPixels( data );
 }
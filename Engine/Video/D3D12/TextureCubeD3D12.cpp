@@ -13,6 +13,7 @@
 #include "System.hpp"
 
 bool HasStbExtension( const std::string& path ); // Defined in TextureCommon.cpp
+DXGI_FORMAT GetDDSFormat( DDSLoader::Format format, ae3d::ColorSpace colorSpace, int& outBytesPerPixel ); // Defined in Texture2D_D3D12.cpp
 void TransitionResource( GpuResource& gpuResource, D3D12_RESOURCE_STATES newState );
 void InitializeTexture( GpuResource& gpuResource, D3D12_SUBRESOURCE_DATA* subResources, int subResourceCount );
 
@@ -104,7 +105,7 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
             DDSLoader::Output ddsOutput;
             auto fileContents = FileSystem::FileContents( posX.path.c_str() );
             const DDSLoader::LoadResult loadResult = DDSLoader::Load( fileContents, width, height, opaque, ddsOutput );
-            mipLevelCount = mipmaps == Mipmaps::Generate ? ddsOutput.dataOffsets.count : 1;
+            mipLevelCount = mipmaps == Mipmaps::Generate ? ddsOutput.mipCount : 1;
 
             if (loadResult != DDSLoader::LoadResult::Success)
             {
@@ -112,43 +113,12 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
                 return;
             }
 
-            if (ddsOutput.format == DDSLoader::Format::BC1)
-            {
-                dxgiFormat = (colorSpace == ColorSpace::Linear) ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC1_UNORM_SRGB;
-            }
-            else if (ddsOutput.format == DDSLoader::Format::BC2)
-            {
-                dxgiFormat = (colorSpace == ColorSpace::Linear) ? DXGI_FORMAT_BC2_UNORM : DXGI_FORMAT_BC2_UNORM_SRGB;
-                bytesPerPixel = 4;
-            }
-            else if (ddsOutput.format == DDSLoader::Format::BC3)
-            {
-                dxgiFormat = (colorSpace == ColorSpace::Linear) ? DXGI_FORMAT_BC3_UNORM : DXGI_FORMAT_BC3_UNORM_SRGB;
-                bytesPerPixel = 4;
-            }
-            else if (ddsOutput.format == DDSLoader::Format::BC4U)
-            {
-                dxgiFormat = DXGI_FORMAT_BC4_UNORM;
-                bytesPerPixel = 2;
-            }
-            else if (ddsOutput.format == DDSLoader::Format::BC4S)
-            {
-                dxgiFormat = DXGI_FORMAT_BC4_SNORM;
-                bytesPerPixel = 2;
-            }
-            else if (ddsOutput.format == DDSLoader::Format::BC5S)
-            {
-                dxgiFormat = DXGI_FORMAT_BC5_SNORM;
-                bytesPerPixel = 4;
-            }
-            else if (ddsOutput.format == DDSLoader::Format::BC5U)
-            {
-                dxgiFormat = DXGI_FORMAT_BC5_UNORM;
-                bytesPerPixel = 4;
-            }
-            else
+            dxgiFormat = GetDDSFormat( ddsOutput.format, colorSpace, bytesPerPixel );
+
+            if (dxgiFormat == DXGI_FORMAT_UNKNOWN)
             {
-                System::Assert( false, "Unhandled DDS format!" );
+                ae3d::System::Print( "%s has unsupported DDS format\n", posX.path.c_str() );
+                return;
             }
         }
         else
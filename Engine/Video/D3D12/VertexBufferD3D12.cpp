@@ -30,7 +30,7 @@ void ae3d::VertexBuffer::DestroyBuffers()
 
 unsigned ae3d::VertexBuffer::GetIBSize() const
 {
-    return elementCount * 2;
+    return elementCount * (indexType == IndexType::UInt32 ? 4 : 2);
 }
 
 unsigned ae3d::VertexBuffer::GetStride() const
@@ -126,15 +126,21 @@ void ae3d::VertexBuffer::UploadVB( void* faces, void* vertices, unsigned ibSize
 
     indexBufferView.BufferLocation = vb->GetGPUVirtualAddress() + GetIBOffset();
     indexBufferView.SizeInBytes = GetIBSize();
-    indexBufferView.Format = DXGI_FORMAT_R16_UINT;
+    indexBufferView.Format = indexType == IndexType::UInt32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
 }
 
 void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount )
+{
+    GenerateDynamic( faceCount, vertexCount, IndexType::UInt16 );
+}
+
+void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount, IndexType aIndexType )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = aIndexType;
     elementCount = faceCount * 3;
 
-    const int ibSize = elementCount * 2;
+    const int ibSize = GetIBSize();
     ibOffset = sizeof( VertexPTNTC ) * vertexCount;
 
     D3D12_HEAP_PROPERTIES uploadProp = {};
@@ -189,7 +195,7 @@ void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount )
 
     indexBufferView.BufferLocation = vb->GetGPUVirtualAddress() + GetIBOffset();
     indexBufferView.SizeInBytes = GetIBSize();
-    indexBufferView.Format = DXGI_FORMAT_R16_UINT;
+    indexBufferView.Format = indexType == IndexType::UInt32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
 }
 
 void ae3d::VertexBuffer::UpdateDynamic( const Face* faces, int /*faceCount*/, const VertexPTC* vertices, int vertexCount )
@@ -213,9 +219,39 @@ void ae3d::VertexBuffer::UpdateDynamic( const Face* faces, int /*faceCount*/, co
     memcpy_s( mappedDynamic + ibOffset, ibSize, faces, ibSize );
 }
 
+void ae3d::VertexBuffer::UpdateDynamicVertices( const VertexPTC* vertices, int firstVertex, int vertexCount )
+{
+    System::Assert( mappedDynamic != nullptr, "Must call GenerateDynamic before UpdateDynamicVertices!" );
+    System::Assert( (firstVertex + vertexCount) * sizeof( VertexPTNTC ) <= static_cast< std::size_t >( ibOffset ), "Vertex buffer too small!" );
+
+    // Upload heap is write-combined, so vertices are written once and never read back.
+    VertexPTNTC* mapped = reinterpret_cast< VertexPTNTC* >( mappedDynamic ) + firstVertex;
+
+    for (int vertexInd = 0; vertexInd < vertexCount; ++vertexInd)
+    {
+        VertexPTNTC vertex;
+        vertex.position = vertices[ vertexInd ].position;
+        vertex.u = vertices[ vertexInd ].u;
+        vertex.v = vertices[ vertexInd ].v;
+        vertex.normal = Vec3( 0, 0, 1 );
+        vertex.tangent = Vec4( 1, 0, 0, 0 );
+        vertex.color = vertices[ vertexInd ].color;
+        mapped[ vertexInd ] = vertex;
+    }
+}
+
+void ae3d::VertexBuffer::UpdateDynamicFaces( const Face32* faces, int faceCount )
+{
+    System::Assert( mappedDynamic != nullptr, "Must call GenerateDynamic before UpdateDynamicFaces!" );
+    System::Assert( indexType == IndexType::UInt32, "Index buffer is not 32-bit!" );
+
+    memcpy_s( mappedDynamic + ibOffset, GetIBSize(), faces, faceCount * sizeof( Face32 ) );
+}
+
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTC* vertices, int vertexCount, Storage /*storage*/ )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
 
     const int ibSize = elementCount * 2;
@@ -239,9 +275,13 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
+    UploadVB( (void*)faces, vertices, vertexCount, GetIBSize() );
+}
 
-    const int ibSize = elementCount * 2;
+void ae3d::VertexBuffer::UploadVB( void* faces, const VertexPTN* vertices, int vertexCount, unsigned ibSize )
+{
     ibOffset = sizeof( VertexPTNTC ) * vertexCount;
 
     std::vector< VertexPTNTC > verticesPTNTC( vertexCount );
@@ -256,12 +296,13 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
         verticesPTNTC[ vertexInd ].color = Vec4( 1, 1, 1, 1 );
     }
 
-    UploadVB( (void*)faces, verticesPTNTC.data(), ibSize );
+    UploadVB( faces, verticesPTNTC.data(), ibSize );
 }
 
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
 
     const int ibSize = elementCount * 2;
@@ -273,6 +314,7 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
 {
     vertexFormat = VertexFormat::PTNTC_Skinned;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
 
     const int ibSize = elementCount * 2;
@@ -281,6 +323,34 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     UploadVB( (void*)faces, (void*)vertices, ibSize );
 }
 
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    UploadVB( (void*)faces, vertices, vertexCount, GetIBSize() );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    ibOffset = sizeof( VertexPTNTC ) * vertexCount;
+
+    UploadVB( (void*)faces, (void*)vertices, GetIBSize() );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC_Skinned;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    ibOffset = sizeof( VertexPTNTC_Skinned ) * vertexCount;
+
+    UploadVB( (void*)faces, (void*)vertices, GetIBSize() );
+}
+
 void ae3d::VertexBuffer::Bind() const
 {
 }
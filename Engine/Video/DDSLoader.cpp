@@ -3,6 +3,7 @@
 #include "DDSLoader.hpp"
 #include <string.h>
 #include <stdint.h>
+#include <string>
 #include "System.hpp"
 #include "FileSystem.hpp"
 
@@ -87,21 +88,32 @@
 ((pf.dwFlags & DDPF_FOURCC) && \
 (pf.dwFourCC == MAKEFOURCC('A', 'T', 'I', '2') ))
 
-unsigned MyMax( unsigned a, unsigned b )
-{
-    return (a > b ? a : b);
-}
-
-struct DDSInfo
-{
-    DDSInfo( int aDivSize, int aBlockBytes )
-    : divSize( aDivSize )
-    , blockBytes( aBlockBytes )
-    {}
-    
-    unsigned divSize;
-    unsigned blockBytes;
-};
+//  DDS_HEADER_DXT10.dxgiFormat
+#define DXGI_FORMAT_R16G16B16A16_FLOAT 10
+#define DXGI_FORMAT_BC1_TYPELESS    70
+#define DXGI_FORMAT_BC1_UNORM       71
+#define DXGI_FORMAT_BC1_UNORM_SRGB  72
+#define DXGI_FORMAT_BC2_TYPELESS    73
+#define DXGI_FORMAT_BC2_UNORM       74
+#define DXGI_FORMAT_BC2_UNORM_SRGB  75
+#define DXGI_FORMAT_BC3_TYPELESS    76
+#define DXGI_FORMAT_BC3_UNORM       77
+#define DXGI_FORMAT_BC3_UNORM_SRGB  78
+#define DXGI_FORMAT_BC4_TYPELESS    79
+#define DXGI_FORMAT_BC4_UNORM       80
+#define DXGI_FORMAT_BC4_SNORM       81
+#define DXGI_FORMAT_BC5_TYPELESS    82
+#define DXGI_FORMAT_BC5_UNORM       83
+#define DXGI_FORMAT_BC5_SNORM       84
+#define DXGI_FORMAT_BC6H_TYPELESS   94
+#define DXGI_FORMAT_BC6H_UF16       95
+#define DXGI_FORMAT_BC6H_SF16       96
+#define DXGI_FORMAT_BC7_TYPELESS    97
+#define DXGI_FORMAT_BC7_UNORM       98
+#define DXGI_FORMAT_BC7_UNORM_SRGB  99
+
+#define D3D10_RESOURCE_DIMENSION_TEXTURE2D 3
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
 
 /**
  DDS header structure.
@@ -148,18 +160,65 @@ union DDSHeader
     uint8_t data[ 128 ];
 };
 
-DDSInfo loadInfoDXT1 = { 4, 8 };
-DDSInfo loadInfoDXT3 = { 4, 16 };
-DDSInfo loadInfoDXT5 = { 4, 16 };
-DDSInfo loadInfoBC4 = { 4, 16 };
-DDSInfo loadInfoBC5 = { 4, 16 };
-DDSInfo loadInfoBC5_ATI2 = { 4, 16 };
+/**
+ Extended header that follows DDSHeader if the FourCC is DX10.
+ */
+struct DDSHeaderDX10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
 
-DDSLoader::LoadResult DDSLoader::Load( const ae3d::FileSystem::FileContentsData& fileContents, int& outWidth, int& outHeight, bool& outOpaque, Output& output )
+static DDSLoader::Format GetDX10Format( uint32_t dxgiFormat, bool& outSRGB )
 {
-    DDSHeader header;
-    int mipMapCount = 0;
+    outSRGB = dxgiFormat == DXGI_FORMAT_BC1_UNORM_SRGB || dxgiFormat == DXGI_FORMAT_BC2_UNORM_SRGB ||
+              dxgiFormat == DXGI_FORMAT_BC3_UNORM_SRGB || dxgiFormat == DXGI_FORMAT_BC7_UNORM_SRGB;
+
+    switch (dxgiFormat)
+    {
+    case DXGI_FORMAT_BC1_TYPELESS: case DXGI_FORMAT_BC1_UNORM: case DXGI_FORMAT_BC1_UNORM_SRGB: return DDSLoader::Format::BC1;
+    case DXGI_FORMAT_BC2_TYPELESS: case DXGI_FORMAT_BC2_UNORM: case DXGI_FORMAT_BC2_UNORM_SRGB: return DDSLoader::Format::BC2;
+    case DXGI_FORMAT_BC3_TYPELESS: case DXGI_FORMAT_BC3_UNORM: case DXGI_FORMAT_BC3_UNORM_SRGB: return DDSLoader::Format::BC3;
+    case DXGI_FORMAT_BC4_TYPELESS: case DXGI_FORMAT_BC4_UNORM: return DDSLoader::Format::BC4U;
+    case DXGI_FORMAT_BC4_SNORM: return DDSLoader::Format::BC4S;
+    case DXGI_FORMAT_BC5_TYPELESS: case DXGI_FORMAT_BC5_UNORM: return DDSLoader::Format::BC5U;
+    case DXGI_FORMAT_BC5_SNORM: return DDSLoader::Format::BC5S;
+    case DXGI_FORMAT_BC6H_TYPELESS: case DXGI_FORMAT_BC6H_UF16: return DDSLoader::Format::BC6HU;
+    case DXGI_FORMAT_BC6H_SF16: return DDSLoader::Format::BC6HS;
+    case DXGI_FORMAT_BC7_TYPELESS: case DXGI_FORMAT_BC7_UNORM: case DXGI_FORMAT_BC7_UNORM_SRGB: return DDSLoader::Format::BC7;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT: return DDSLoader::Format::RGBA16F;
+    default: return DDSLoader::Format::Invalid;
+    }
+}
+
+int DDSLoader::GetBlockSize( Format format )
+{
+    if (format == Format::RGBA16F)
+    {
+        return 128;
+    }
+
+    return (format == Format::BC1 || format == Format::BC4U || format == Format::BC4S) ? 8 : 16;
+}
 
+std::size_t DDSLoader::GetMipSize( Format format, int width, int height, int mipIndex )
+{
+    const std::size_t mipWidth = (width >> mipIndex) > 1 ? (width >> mipIndex) : 1;
+    const std::size_t mipHeight = (height >> mipIndex) > 1 ? (height >> mipIndex) : 1;
+
+    if (format == Format::RGBA16F)
+    {
+        return mipWidth * mipHeight * 8;
+    }
+
+    return ((mipWidth + 3) / 4) * ((mipHeight + 3) / 4) * GetBlockSize( format );
+}
+
+DDSLoader::LoadResult DDSLoader::Load( const ae3d::FileSystem::FileContentsData& fileContents, int& outWidth, int& outHeight, bool& outOpaque, Output& output )
+{
     if (!fileContents.isLoaded)
     {
         outWidth = 512;
@@ -167,29 +226,57 @@ DDSLoader::LoadResult DDSLoader::Load( const ae3d::FileSystem::FileContentsData&
         return LoadResult::FileNotFound;
     }
 
-    if (fileContents.data.size() < sizeof( header ) )
+    const LoadResult result = Load( fileContents.data.data(), fileContents.data.size(), fileContents.path.c_str(), outWidth, outHeight, outOpaque, output );
+
+    if (result == LoadResult::Success)
     {
-        ae3d::System::Print( "DDS loader error: Texture %s file length is less than DDS header length.\n", fileContents.path.c_str() );
+        output.imageData.Allocate( (int)fileContents.data.size() );
+        memcpy( output.imageData.elements, fileContents.data.data(), output.imageData.count );
+        output.data = output.imageData.elements;
+    }
+
+    return result;
+}
+
+DDSLoader::LoadResult DDSLoader::Load( const ae3d::FileSystem::FileView& fileView, int& outWidth, int& outHeight, bool& outOpaque, Output& output )
+{
+    if (!fileView.IsLoaded())
+    {
+        outWidth = 512;
+        outHeight = 512;
+        return LoadResult::FileNotFound;
+    }
+
+    return Load( fileView.GetData(), fileView.GetSize(), fileView.GetPath().c_str(), outWidth, outHeight, outOpaque, output );
+}
+
+DDSLoader::LoadResult DDSLoader::Load( const unsigned char* data, std::size_t dataSize, const char* path, int& outWidth, int& outHeight, bool& outOpaque, Output& output )
+{
+    DDSHeader header;
+
+    if (dataSize < sizeof( header ) )
+    {
+        ae3d::System::Print( "DDS loader error: Texture %s file length is less than DDS header length.\n", path );
         return LoadResult::FileNotFound;
     }
     
-    memcpy( &header, fileContents.data.data(), sizeof( header ) );
+    memcpy( &header, data, sizeof( header ) );
 
     if (header.sHeader.dwMagic != DDS_MAGIC)
     {
-        ae3d::System::Print( "DDSLoader: Wrong magic in file %s\n", fileContents.path.c_str() );
+        ae3d::System::Print( "DDSLoader: Wrong magic in file %s\n", path );
         return LoadResult::FileNotFound;
     }
     
     if (header.sHeader.dwSize != 124)
     {
-        ae3d::System::Print( "DDSLoader: Wrong header size in file %s\n", fileContents.path.c_str() );
+        ae3d::System::Print( "DDSLoader: Wrong header size in file %s\n", path );
         return LoadResult::FileNotFound;
     }
   
     if (!(header.sHeader.dwFlags & DDSD_PIXELFORMAT) || !(header.sHeader.dwFlags & DDSD_CAPS) )
     {
-        ae3d::System::Print( "DDS loader error: Texture %s doesn't contain pixelformat or caps.\n", fileContents.path.c_str() );
+        ae3d::System::Print( "DDS loader error: Texture %s doesn't contain pixelformat or caps.\n", path );
         outWidth    = 32;
         outHeight   = 32;
         outOpaque = true;
@@ -198,77 +285,75 @@ DDSLoader::LoadResult DDSLoader::Load( const ae3d::FileSystem::FileContentsData&
 
     const uint32_t xSize = header.sHeader.dwWidth;
     const uint32_t ySize = header.sHeader.dwHeight;
-    ae3d::System::Assert( !( xSize & (xSize - 1) ), "DDSLoader: Wrong image width" );
-    ae3d::System::Assert( !( ySize & (ySize - 1) ), "DDSLoader: Wrong image height" );
 
     outWidth  = xSize;
     outHeight = ySize;
-    DDSInfo* li = nullptr;
+    std::size_t fileOffset = sizeof( header );
+    output.layerCount = 1;
+    output.isCube = false;
+    output.isSRGB = false;
 
     if (PF_IS_DXT1( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoDXT1;
         outOpaque = true;
         output.format = DDSLoader::Format::BC1;
     }
     else if (PF_IS_DXT3( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoDXT3;
         outOpaque = false;
         output.format = DDSLoader::Format::BC2;
     }
     else if (PF_IS_DXT5( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoDXT5;
         outOpaque = false;
         output.format = DDSLoader::Format::BC3;
     }
-    else if (PF_IS_BC4U( header.sHeader.sPixelFormat ))
+    else if (PF_IS_BC4U( header.sHeader.sPixelFormat ) || PF_IS_BC5_ATI1( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoBC4;
         outOpaque = true;
         output.format = DDSLoader::Format::BC4U;
     }
     else if (PF_IS_BC4S( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoBC4;
         outOpaque = true;
         output.format = DDSLoader::Format::BC4S;
     }
     else if (PF_IS_BC5S( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoBC5;
         outOpaque = true;
         output.format = DDSLoader::Format::BC5S;
     }
-    else if (PF_IS_BC5U( header.sHeader.sPixelFormat ))
+    else if (PF_IS_BC5U( header.sHeader.sPixelFormat ) || PF_IS_BC5_ATI2( header.sHeader.sPixelFormat ))
     {
-        li = &loadInfoBC5;
         outOpaque = true;
         output.format = DDSLoader::Format::BC5U;
     }
-    else if (PF_IS_BC5_ATI1( header.sHeader.sPixelFormat ))
-    {
-        li = &loadInfoDXT1;
-        outOpaque = true;
-        output.format = DDSLoader::Format::BC4U;
-    }
-    else if (PF_IS_BC5_ATI2( header.sHeader.sPixelFormat ))
+    else if (PF_IS_DX10( header.sHeader.sPixelFormat ) && dataSize >= sizeof( header ) + sizeof( DDSHeaderDX10 ))
     {
-        li = &loadInfoBC5_ATI2;
-        outOpaque = true;
-        output.format = DDSLoader::Format::BC5U;
-    }
-    else if (PF_IS_DX10( header.sHeader.sPixelFormat ))
-    {
-        li = &loadInfoDXT5;
-        outOpaque = true;
-        output.format = DDSLoader::Format::BC5U;
+        DDSHeaderDX10 headerDX10;
+        memcpy( &headerDX10, data + sizeof( header ), sizeof( headerDX10 ) );
+        fileOffset += sizeof( headerDX10 );
+        output.format = GetDX10Format( headerDX10.dxgiFormat, output.isSRGB );
+        outOpaque = output.format != DDSLoader::Format::BC2 && output.format != DDSLoader::Format::BC3 && output.format != DDSLoader::Format::BC7;
+
+        // D3D11 allows at most 2048 array slices.
+        if (output.format == DDSLoader::Format::Invalid || headerDX10.resourceDimension != D3D10_RESOURCE_DIMENSION_TEXTURE2D || headerDX10.arraySize > 2048)
+        {
+            ae3d::System::Print( "DDS loader error: Texture %s has unsupported DXGI format %u, dimension %u or array size %u. Supported are BC1-BC7 and RGBA16F 2D textures.\n", path,
+                                 headerDX10.dxgiFormat, headerDX10.resourceDimension, headerDX10.arraySize );
+            outWidth    = 32;
+            outHeight   = 32;
+            outOpaque = true;
+            return LoadResult::UnknownPixelFormat;
+        }
+
+        output.isCube = (headerDX10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+        output.layerCount = (headerDX10.arraySize > 0 ? (int)headerDX10.arraySize : 1) * (output.isCube ? 6 : 1);
     }
     else
     {
         // (pf.dwFlags & DDPF_FOURCC) && pf.dwFourCC
-        ae3d::System::Print("DDS loader error: Texture %s has unknown pixelformat. Has FourCC: %d, FourCC: %d\n", fileContents.path.c_str(),
+        ae3d::System::Print("DDS loader error: Texture %s has unknown pixelformat. Has FourCC: %d, FourCC: %d\n", path,
                             (header.sHeader.dwFlags & DDPF_FOURCC), header.sHeader.sPixelFormat.dwFourCC );
         outWidth    = 32;
         outHeight   = 32;
@@ -276,40 +361,62 @@ DDSLoader::LoadResult DDSLoader::Load( const ae3d::FileSystem::FileContentsData&
         return LoadResult::UnknownPixelFormat;
     }
 
-    unsigned x = xSize;
-    unsigned y = ySize;
-    mipMapCount = (header.sHeader.dwFlags & DDSD_MIPMAPCOUNT) ? header.sHeader.dwMipMapCount : 1;
+    // Legacy headers store cube maps in caps. Only files with all six faces are supported.
+    if (header.sHeader.sCaps.dwCaps2 & DDSCAPS2_CUBEMAP)
+    {
+        const uint32_t allFaces = DDSCAPS2_CUBEMAP_POSITIVEX | DDSCAPS2_CUBEMAP_NEGATIVEX | DDSCAPS2_CUBEMAP_POSITIVEY |
+                                  DDSCAPS2_CUBEMAP_NEGATIVEY | DDSCAPS2_CUBEMAP_POSITIVEZ | DDSCAPS2_CUBEMAP_NEGATIVEZ;
 
-    std::size_t fileOffset = sizeof( header );
+        if ((header.sHeader.sCaps.dwCaps2 & allFaces) != allFaces)
+        {
+            ae3d::System::Print( "DDS loader error: Cube map %s doesn't have all faces.\n", path );
+            return LoadResult::UnknownPixelFormat;
+        }
 
-    std::size_t size = MyMax( li->divSize, x ) / li->divSize * MyMax( li->divSize, y ) / li->divSize * li->blockBytes;
-    // FIXME: A texture loaded from https://online-converting.com/image/convert2dds/ has dwPitchOrLinearSize set to 0, but otherwise seems to load correctly.
-    //ae3d::System::Assert( size == header.sHeader.dwPitchOrLinearSize, "DDSLoader: Wrong pitch or size" );
-    //ae3d::System::Assert( (header.sHeader.dwFlags & DDSD_LINEARSIZE) != 0, "DDSLoader: need flag DDSD_LINEARSIZE" );
-    
-    if (size == 0)
+        output.isCube = true;
+        output.layerCount = 6;
+    }
+
+    if (xSize == 0 || ySize == 0)
     {
-        ae3d::System::Print("DDS loader error: Texture %s contents are empty.\n", fileContents.path.c_str() );
+        ae3d::System::Print("DDS loader error: Texture %s contents are empty.\n", path );
         outWidth    = 32;
         outHeight   = 32;
         outOpaque = true;
         return LoadResult::FileNotFound;
     }
-    
-    output.imageData.Allocate( (int)fileContents.data.size() );
-    
-    memcpy( output.imageData.elements, fileContents.data.data(), output.imageData.count );
-    output.dataOffsets.Allocate( mipMapCount );
-    
-    for (int ix = 0; ix < mipMapCount; ++ix)
+
+    // D3D12 and Vulkan implementations support at most 16384, so bigger sizes are from a corrupted header.
+    if (xSize > 65536 || ySize > 65536)
     {
-        output.dataOffsets[ ix ] = (int)fileOffset;
-        
-        fileOffset += size;
-        x = (x + 1) >> 1;
-        y = (y + 1) >> 1;
-        size = MyMax( li->divSize, x ) / li->divSize * MyMax( li->divSize, y ) / li->divSize * li->blockBytes;
+        ae3d::System::Print( "DDS loader error: Texture %s has invalid size %ux%u.\n", path, xSize, ySize );
+        return LoadResult::UnknownPixelFormat;
     }
 
+    // At most 32 levels, enough for 2^31 pixels.
+    output.mipCount = ((header.sHeader.dwFlags & DDSD_MIPMAPCOUNT) && header.sHeader.dwMipMapCount > 0) ? (int)(header.sHeader.dwMipMapCount < 32 ? header.sHeader.dwMipMapCount : 32) : 1;
+    output.dataOffsets.Allocate( output.layerCount * output.mipCount );
+
+    // Each layer has its full mip chain before the next layer.
+    for (int layer = 0; layer < output.layerCount; ++layer)
+    {
+        for (int mipIndex = 0; mipIndex < output.mipCount; ++mipIndex)
+        {
+            output.dataOffsets[ layer * output.mipCount + mipIndex ] = (int)fileOffset;
+            fileOffset += GetMipSize( output.format, (int)xSize, (int)ySize, mipIndex );
+        }
+    }
+
+    // FIXME: A texture loaded from https://online-converting.com/image/convert2dds/ has dwPitchOrLinearSize set to 0, but otherwise seems to load correctly.
+    if (fileOffset > dataSize)
+    {
+        ae3d::System::Print( "DDS loader error: Texture %s is truncated. Its %d layers and %d mip levels need %u bytes, file has %u bytes.\n", path,
+                             output.layerCount, output.mipCount, (unsigned)fileOffset, (unsigned)dataSize );
+        return LoadResult::FileNotFound;
+    }
+
+    output.data = data;
+    output.dataSize = dataSize;
+
     return LoadResult::Success;
 }
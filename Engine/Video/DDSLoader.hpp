@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include "Array.hpp"
 
 namespace ae3d
@@ -7,6 +8,7 @@ namespace ae3d
 	namespace FileSystem
 	{
 		struct FileContentsData;
+		class FileView;
 	}
 }
 
@@ -15,16 +17,37 @@ namespace DDSLoader
 {
     /// Load result
     enum class LoadResult { Success, UnknownPixelFormat, FileNotFound };
-    /// Format
-    enum class Format { Invalid, BC1, BC2, BC3, BC4U, BC4S, BC5U, BC5S };
+    /// Format. BC6HU, BC6HS, BC7 and RGBA16F are only in files that have a DX10 header. RGBA16F is uncompressed half floats, e.g. prefiltered
+    /// cube maps from FilterCubeMap.
+    enum class Format { Invalid, BC1, BC2, BC3, BC4U, BC4S, BC5U, BC5S, BC6HU, BC6HS, BC7, RGBA16F };
 
     struct Output
     {
+        /// Copy of the file if it was loaded from FileContentsData, otherwise empty.
         Array< unsigned char > imageData;
-        Array< int > dataOffsets; // Mipmap offsets in imageData
+        /// Offsets of mip levels in data. Level m of layer l is at index l * mipCount + m.
+        Array< int > dataOffsets;
+        /// File contents. Points to imageData, or to the loaded memory if it was not copied.
+        const unsigned char* data = nullptr;
+        /// Size of data in bytes.
+        std::size_t dataSize = 0;
         Format format = Format::Invalid;
+        /// Mip levels in each layer.
+        int mipCount = 0;
+        /// Array slices, times 6 for cube maps. Cube faces are in order +X, -X, +Y, -Y, +Z, -Z.
+        int layerCount = 1;
+        /// True if layers are cube map faces.
+        bool isCube = false;
+        /// True if a DX10 header has an sRGB format.
+        bool isSRGB = false;
     };
- 
+
+    /// \return Size of a 4x4 block in bytes. RGBA16F isn't block compressed, but its 4x4 pixels have 128 bytes.
+    int GetBlockSize( Format format );
+
+    /// \return Size of a mip level in bytes.
+    std::size_t GetMipSize( Format format, int width, int height, int mipIndex );
+
     /**
      Loads a .dds file.
      
@@ -36,4 +59,11 @@ namespace DDSLoader
      \return Load result.
      */
     LoadResult Load( const ae3d::FileSystem::FileContentsData& fileContents, int& outWidth, int& outHeight, bool& outOpaque, Output& output );
+
+    /// Like Load() but doesn't copy the file. output.data points into fileView, so mip levels can be uploaded straight from the mapping.
+    /// fileView must outlive output.
+    LoadResult Load( const ae3d::FileSystem::FileView& fileView, int& outWidth, int& outHeight, bool& outOpaque, Output& output );
+
+    /// Like Load() but doesn't copy the file. output.data points into data, which must outlive output.
+    LoadResult Load( const unsigned char* data, std::size_t dataSize, const char* path, int& outWidth, int& outHeight, bool& outOpaque, Output& output );
 }
@@ -29,6 +29,8 @@ struct PerObjectUboStruct
     float f0 = 0.8f;
     ae3d::Vec4 tex0scaleOffset = ae3d::Vec4( 1, 1, 0, 0 );
     ae3d::Vec4 tilesXY = ae3d::Vec4( 0, 0, 0, 0 );
+    ae3d::Vec4 vertexScale = ae3d::Vec4( 1, 1, 1, 0 ); // Position scale of quantized vertices. w is 1 if normals and tangents are octahedral.
+    ae3d::Vec4 vertexOffset = ae3d::Vec4( 0, 0, 0, 0 ); // Position offset of quantized vertices.
     ae3d::Matrix44 boneMatrices[ 80 ];
     int isVR = 0;
 };
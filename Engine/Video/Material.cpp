@@ -75,6 +75,17 @@ void ae3d::Material::Apply()
     GfxDeviceGlobal::perObjectUboStruct.f0 = f0;
 }
 
+void ae3d::Material::ReportTextureScreenSize( float screenSizeInPixels ) const
+{
+    for (int slot = 0; slot < TEXTURE_SLOT_COUNT; ++slot)
+    {
+        if (tex2dSlots[ slot ])
+        {
+            tex2dSlots[ slot ]->ReportScreenSize( screenSizeInPixels );
+        }
+    }
+}
+
 void ae3d::Material::SetShader( Shader* aShader )
 {
     shader = aShader;
@@ -215,6 +215,16 @@ namespace ae3d
                 str += "\n";
                 str += "draw calls: ";
                 str += std::to_string( ::Statistics::GetDrawCalls() );
+                str += "\n";
+                str += "triangles: ";
+                str += std::to_string( ::Statistics::GetTriangleCount() );
+                str += "\nmesh triangles per LOD:";
+
+                for (int lod = 0; lod < ::Statistics::MaxMeshLods; ++lod)
+                {
+                    str += " " + std::to_string( ::Statistics::GetMeshLodTriangleCount( lod ) );
+                }
+
                 str += "\n";
                 str += "scene AABB: ";
                 str += std::to_string( ::Statistics::GetSceneAABBTimeMS() );
@@ -224,6 +234,9 @@ namespace ae3d
                 str += "textures: ";
                 str += std::to_string(tex2dMemoryUsage / (1024 * 1024));
                 str += " MiB\n";
+                str += "mesh CPU memory: ";
+                str += std::to_string( ::Statistics::GetResidentMeshCpuBytes() / 1024 );
+                str += " KiB\n";
                 std::strcpy( outStr, str.c_str() );
             }
         }
@@ -664,6 +677,11 @@ void ae3d::GfxDevice::Draw( VertexBuffer& vertexBuffer, int startIndex, int endI
 {
     Statistics::IncDrawCalls();
 
+    if (topology == PrimitiveTopology::Triangles)
+    {
+        Statistics::IncTriangleCount( endIndex - startIndex );
+    }
+
     for (int slot = 0; slot < 4; ++slot)
     {
         if (!textures[ slot ])
@@ -777,11 +795,12 @@ void ae3d::GfxDevice::Draw( VertexBuffer& vertexBuffer, int startIndex, int endI
     
     if (topology == PrimitiveTopology::Triangles)
     {
+        const bool is32BitIndices = vertexBuffer.GetIndexType() == VertexBuffer::IndexType::UInt32;
         [renderEncoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle
                                   indexCount:(endIndex - startIndex) * 3
-                               indexType:MTLIndexTypeUInt16
+                               indexType:is32BitIndices ? MTLIndexTypeUInt32 : MTLIndexTypeUInt16
                              indexBuffer:vertexBuffer.GetIndexBuffer()
-                       indexBufferOffset:startIndex * 2 * 3];
+                       indexBufferOffset:startIndex * (is32BitIndices ? 4 : 2) * 3];
     }
     else // MTLPrimitiveTypeLine
     {
@@ -15,6 +15,8 @@
 
 extern id <MTLCommandQueue> commandQueue;
 bool HasStbExtension( const std::string& path ); // Defined in TextureCommon.cpp
+unsigned char* LoadSTBPixels( const ae3d::FileSystem::FileContentsData& fileContents, ae3d::DecodedImage* decoded, int& outWidth, int& outHeight, int& outComponents ); // Defined in TextureCommon.cpp
+void FreeSTBPixels( unsigned char* pixels ); // Defined in TextureCommon.cpp
 int tex2dMemoryUsage = 0;
 
 namespace MathUtil
@@ -215,6 +217,14 @@ ae3d::Texture2D* ae3d::Texture2D::GetDefaultTexture()
     return &defaultTexture;
 }
 
+void ae3d::Texture2D::BeginUploadBatch()
+{
+}
+
+void ae3d::Texture2D::EndUploadBatch()
+{
+}
+
 void ae3d::Texture2D::CreateUAV( int aWidth, int aHeight, const char* debugName )
 {
     width = aWidth;
@@ -296,7 +306,41 @@ void ae3d::Texture2D::LoadFromData( const void* imageData, int aWidth, int aHeig
     }
 }
 
-void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+#if !TARGET_OS_IPHONE
+MTLPixelFormat GetDDSFormat( DDSLoader::Format format, ae3d::ColorSpace colorSpace )
+{
+    const bool isLinear = colorSpace == ae3d::ColorSpace::Linear;
+
+    switch (format)
+    {
+    case DDSLoader::Format::BC1: return isLinear ? MTLPixelFormatBC1_RGBA : MTLPixelFormatBC1_RGBA_sRGB;
+    case DDSLoader::Format::BC2: return isLinear ? MTLPixelFormatBC2_RGBA : MTLPixelFormatBC2_RGBA_sRGB;
+    case DDSLoader::Format::BC3: return isLinear ? MTLPixelFormatBC3_RGBA : MTLPixelFormatBC3_RGBA_sRGB;
+    case DDSLoader::Format::BC4U: return MTLPixelFormatBC4_RUnorm;
+    case DDSLoader::Format::BC4S: return MTLPixelFormatBC4_RSnorm;
+    case DDSLoader::Format::BC5U: return MTLPixelFormatBC5_RGUnorm;
+    case DDSLoader::Format::BC5S: return MTLPixelFormatBC5_RGSnorm;
+    case DDSLoader::Format::BC6HU: return MTLPixelFormatBC6H_RGBUfloat;
+    case DDSLoader::Format::BC6HS: return MTLPixelFormatBC6H_RGBFloat;
+    case DDSLoader::Format::BC7: return isLinear ? MTLPixelFormatBC7_RGBAUnorm : MTLPixelFormatBC7_RGBAUnorm_sRGB;
+    case DDSLoader::Format::RGBA16F: return MTLPixelFormatRGBA16Float;
+    default: return MTLPixelFormatInvalid;
+    }
+}
+
+/// \return Bytes in a row of 4x4 blocks, or in a row of pixels if the format is not block compressed.
+NSUInteger GetDDSBytesPerRow( DDSLoader::Format format, int width )
+{
+    if (format == DDSLoader::Format::RGBA16F)
+    {
+        return width * 8;
+    }
+
+    return ((width + 3) / 4) * DDSLoader::GetBlockSize( format );
+}
+#endif
+
+void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, DecodedImage* decoded, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
 {
     if (!fileContents.isLoaded)
     {
@@ -316,7 +360,7 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
 
     if (HasStbExtension( fileContents.path ))
     {
-        LoadSTB( fileContents );
+        LoadSTB( fileContents, decoded );
     }
     else if (isPVR)
     {
@@ -348,43 +392,12 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
             return;
         }
         
-        int multiplier = 2;
-        
-        MTLPixelFormat pixelFormat = MTLPixelFormatRGBA8Unorm;
-        
-        if (output.format == DDSLoader::Format::BC1)
-        {
-            pixelFormat = colorSpace == ColorSpace::Linear ? MTLPixelFormatBC1_RGBA : MTLPixelFormatBC1_RGBA_sRGB;
-        }
-        else if (output.format == DDSLoader::Format::BC2)
-        {
-            pixelFormat = colorSpace == ColorSpace::Linear ? MTLPixelFormatBC2_RGBA : MTLPixelFormatBC2_RGBA_sRGB;
-            multiplier = 4;
-        }
-        else if (output.format == DDSLoader::Format::BC3)
-        {
-            pixelFormat = colorSpace == ColorSpace::Linear ? MTLPixelFormatBC3_RGBA : MTLPixelFormatBC3_RGBA_sRGB;
-            multiplier = 4;
-        }
-        else if (output.format == DDSLoader::Format::BC4U)
-        {
-            pixelFormat = MTLPixelFormatBC4_RUnorm;
-            multiplier = 2;
-        }
-        else if (output.format == DDSLoader::Format::BC4S)
-        {
-            pixelFormat = MTLPixelFormatBC4_RSnorm;
-            multiplier = 2;
-        }
-        else if (output.format == DDSLoader::Format::BC5U)
-        {
-            pixelFormat = MTLPixelFormatBC5_RGUnorm;
-            multiplier = 4;
-        }
-        else if (output.format == DDSLoader::Format::BC5S)
+        const MTLPixelFormat pixelFormat = GetDDSFormat( output.format, colorSpace );
+
+        if (pixelFormat == MTLPixelFormatInvalid)
         {
-            pixelFormat = MTLPixelFormatBC5_RGSnorm;
-            multiplier = 4;
+            ae3d::System::Print( "%s has unsupported DDS format\n", fileContents.path.c_str() );
+            return;
         }
 
         MTLTextureDescriptor* textureDescriptor =
@@ -406,13 +419,13 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
             stagingTexture.label = [NSString stringWithUTF8String:fileContents.path.c_str()];
         }
 
-        mipLevelCount = mipmaps == Mipmaps::Generate ? output.dataOffsets.count : 1;
+        mipLevelCount = mipmaps == Mipmaps::Generate ? output.mipCount : 1;
 
         for (int mipIndex = 0; mipIndex < mipLevelCount; ++mipIndex)
         {
             const int mipWidth = MathUtil::Max( width >> mipIndex, 1 );
             const int mipHeight = MathUtil::Max( height >> mipIndex, 1 );
-            const int mipBytesPerRow = mipWidth <= 2 ? 8 : mipWidth * multiplier;
+            const NSUInteger mipBytesPerRow = GetDDSBytesPerRow( output.format, mipWidth );
             
             MTLRegion region = MTLRegionMake2D( 0, 0, mipWidth, mipHeight );
             [stagingTexture replaceRegion:region mipmapLevel:mipIndex withBytes:&output.imageData[ output.dataOffsets[ mipIndex ] ] bytesPerRow:mipBytesPerRow];
@@ -425,6 +438,16 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
                                                        mipmapped:(mipmaps == Mipmaps::None ? NO : YES)];
         textureDescriptor2.usage = MTLTextureUsageShaderRead;
         textureDescriptor2.storageMode = MTLStorageModePrivate;
+
+        // CompressTexture stores grayscale images as BC4, so its red channel is also sampled as green and blue. Older macOS versions sample it as red.
+        if (@available( macOS 10.15, * ))
+        {
+            if (pixelFormat == MTLPixelFormatBC4_RUnorm || pixelFormat == MTLPixelFormatBC4_RSnorm)
+            {
+                textureDescriptor2.swizzle = MTLTextureSwizzleChannelsMake( MTLTextureSwizzleRed, MTLTextureSwizzleRed, MTLTextureSwizzleRed, MTLTextureSwizzleOne );
+            }
+        }
+
         metalTexture = [GfxDevice::GetMetalDevice() newTextureWithDescriptor:textureDescriptor2];
         metalTexture.label = stagingTexture.label;
         
@@ -533,10 +556,10 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
     tex2dMemoryUsage += [metalTexture allocatedSize];
 }
 
-void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents )
+void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents, DecodedImage* decoded )
 {
     int components;
-    unsigned char* data = stbi_load_from_memory( &fileContents.data[ 0 ], static_cast<int>(fileContents.data.size()), &width, &height, &components, 4 );
+    unsigned char* data = LoadSTBPixels( fileContents, decoded, width, height, components );
     
     if (data == nullptr)
     {
@@ -606,7 +629,7 @@ void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents
         [commandBuffer waitUntilCompleted];
     }
 
-    stbi_image_free( data );
+    FreeSTBPixels( data );
 }
 
 void ae3d::Texture2D::LoadPVRv2( const char* path )
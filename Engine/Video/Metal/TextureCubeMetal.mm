@@ -12,6 +12,10 @@
 
 extern id <MTLCommandQueue> commandQueue;
 bool HasStbExtension( const std::string& path ); // Defined in TextureCommon.cpp
+#if !TARGET_OS_IPHONE
+MTLPixelFormat GetDDSFormat( DDSLoader::Format format, ae3d::ColorSpace colorSpace ); // Defined in Texture2DMetal.mm
+NSUInteger GetDDSBytesPerRow( DDSLoader::Format format, int width ); // Defined in Texture2DMetal.mm
+#endif
 static int textureCubeMemoryUsage = 0;
 ae3d::TextureCube defaultCube;
 
@@ -71,44 +75,13 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
             return;
         }
         
-        if (output.format == DDSLoader::Format::BC1)
-        {
-            pixelFormat = colorSpace == ColorSpace::Linear ? MTLPixelFormatBC1_RGBA : MTLPixelFormatBC1_RGBA_sRGB;
-            bytesPerRow = width * 2;
-        }
-        else if (output.format == DDSLoader::Format::BC2)
-        {
-            pixelFormat = colorSpace == ColorSpace::Linear ? MTLPixelFormatBC2_RGBA : MTLPixelFormatBC2_RGBA_sRGB;
-            bytesPerRow = width * 4;
-        }
-        else if (output.format == DDSLoader::Format::BC3)
-        {
-            pixelFormat = colorSpace == ColorSpace::Linear ? MTLPixelFormatBC3_RGBA : MTLPixelFormatBC3_RGBA_sRGB;
-            bytesPerRow = width * 4;
-        }
-        else if (output.format == DDSLoader::Format::BC4U)
-        {
-            pixelFormat = MTLPixelFormatBC4_RUnorm;
-            bytesPerRow = width * 2;
-        }
-        else if (output.format == DDSLoader::Format::BC4S)
-        {
-            pixelFormat = MTLPixelFormatBC4_RSnorm;
-            bytesPerRow = width * 2;
-        }
-        else if (output.format == DDSLoader::Format::BC5U)
-        {
-            pixelFormat = MTLPixelFormatBC5_RGUnorm;
-            bytesPerRow = width * 4;
-        }
-        else if (output.format == DDSLoader::Format::BC5S)
-        {
-            pixelFormat = MTLPixelFormatBC5_RGSnorm;
-            bytesPerRow = width * 4;
-        }
-        else
+        pixelFormat = GetDDSFormat( output.format, colorSpace );
+        bytesPerRow = GetDDSBytesPerRow( output.format, width );
+
+        if (pixelFormat == MTLPixelFormatInvalid)
         {
-            System::Assert( false, "Unhandled DDS compression" );
+            ae3d::System::Print( "%s has unsupported DDS format\n", fileContents[ 0 ]->path.c_str() );
+            return;
         }
 #endif
     }
@@ -23,6 +23,7 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     }
     
     vertexFormat = VertexFormat::PTC;
+    indexType = IndexType::UInt16;
     
     if (storage == Storage::GPU)
     {
@@ -216,7 +217,7 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     vertexBufferMemoryUsage += [colorBuffer allocatedSize];
 }
 
-void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+void ae3d::VertexBuffer::GenerateBuffers( const void* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
 {
     if (faceCount == 0)
     {
@@ -303,7 +304,7 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     weightBuffer.label = @"Weight buffer";
     
     indexBuffer = [GfxDevice::GetMetalDevice() newBufferWithBytes:faces
-                      length:sizeof( Face ) * faceCount
+                      length:faceCount * 3 * (indexType == IndexType::UInt32 ? 4 : 2)
                      options:MTLResourceCPUCacheModeDefaultCache];
     indexBuffer.label = @"Index buffer";
     
@@ -319,7 +320,19 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     vertexBufferMemoryUsage += [colorBuffer allocatedSize];
 }
 
-void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+{
+    indexType = IndexType::UInt16;
+    GenerateBuffers( faces, faceCount, vertices, vertexCount );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+{
+    indexType = IndexType::UInt32;
+    GenerateBuffers( faces, faceCount, vertices, vertexCount );
+}
+
+void ae3d::VertexBuffer::GenerateBuffers( const void* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
 {
     if (faceCount == 0)
     {
@@ -434,7 +447,7 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     weightBuffer.label = @"Weight buffer";
     
     indexBuffer = [GfxDevice::GetMetalDevice() newBufferWithBytes:faces
-                      length:sizeof( Face ) * faceCount
+                      length:faceCount * 3 * (indexType == IndexType::UInt32 ? 4 : 2)
                      options:MTLResourceCPUCacheModeDefaultCache];
     indexBuffer.label = @"Index buffer";
     
@@ -450,7 +463,19 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     vertexBufferMemoryUsage += [colorBuffer allocatedSize];
 }
 
-void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
+{
+    indexType = IndexType::UInt16;
+    GenerateBuffers( faces, faceCount, vertices, vertexCount );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
+{
+    indexType = IndexType::UInt32;
+    GenerateBuffers( faces, faceCount, vertices, vertexCount );
+}
+
+void ae3d::VertexBuffer::GenerateBuffers( const void* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
 {
     if (faceCount == 0)
     {
@@ -581,7 +606,7 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     boneBuffer.label = @"Bone buffer";
     
     indexBuffer = [GfxDevice::GetMetalDevice() newBufferWithBytes:faces
-                      length:sizeof( Face ) * faceCount
+                      length:faceCount * 3 * (indexType == IndexType::UInt32 ? 4 : 2)
                      options:MTLResourceCPUCacheModeDefaultCache];
     indexBuffer.label = @"Index buffer";
     
@@ -597,16 +622,34 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     vertexBufferMemoryUsage += [colorBuffer allocatedSize];
 }
 
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
+{
+    indexType = IndexType::UInt16;
+    GenerateBuffers( faces, faceCount, vertices, vertexCount );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
+{
+    indexType = IndexType::UInt32;
+    GenerateBuffers( faces, faceCount, vertices, vertexCount );
+}
+
 void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount )
+{
+    GenerateDynamic( faceCount, vertexCount, IndexType::UInt16 );
+}
+
+void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount, IndexType aIndexType )
 {
     vertexFormat = VertexFormat::PTC;
+    indexType = aIndexType;
     elementCount = faceCount * 3;
 
-    vertexBuffer = [GfxDevice::GetMetalDevice() newBufferWithLength:sizeof( VertexFormat::PTC ) * vertexCount
+    vertexBuffer = [GfxDevice::GetMetalDevice() newBufferWithLength:sizeof( VertexPTC ) * vertexCount
                               options:MTLResourceCPUCacheModeDefaultCache];
     vertexBuffer.label = @"Dynamic Vertex buffer";
     
-    indexBuffer = [GfxDevice::GetMetalDevice() newBufferWithLength:sizeof( Face ) * faceCount
+    indexBuffer = [GfxDevice::GetMetalDevice() newBufferWithLength:(indexType == IndexType::UInt32 ? sizeof( Face32 ) : sizeof( Face )) * faceCount
                  options:MTLResourceCPUCacheModeDefaultCache];
     indexBuffer.label = @"Dynamic Index buffer";
 
@@ -627,3 +670,14 @@ void ae3d::VertexBuffer::UpdateDynamic( const Face* faces, int faceCount, const
     memcpy( [vertexBuffer contents], vertices, sizeof( VertexPTC ) * vertexCount );
     memcpy( [indexBuffer contents], faces, sizeof( Face ) * faceCount );
 }
+
+void ae3d::VertexBuffer::UpdateDynamicVertices( const VertexPTC* vertices, int firstVertex, int vertexCount )
+{
+    memcpy( static_cast< VertexPTC* >( [vertexBuffer contents] ) + firstVertex, vertices, sizeof( VertexPTC ) * vertexCount );
+}
+
+void ae3d::VertexBuffer::UpdateDynamicFaces( const Face32* faces, int faceCount )
+{
+    System::Assert( indexType == IndexType::UInt32, "Index buffer is not 32-bit!" );
+    memcpy( [indexBuffer contents], faces, sizeof( Face32 ) * faceCount );
+}
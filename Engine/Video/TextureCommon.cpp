@@ -1,19 +1,33 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include <algorithm>
 #include <string>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
-#include <sstream>
 #include "Texture2D.hpp"
+#include "AsyncLoader.hpp"
+#include "AtlasIndex.hpp"
+#include "DDSLoader.hpp"
 #include "System.hpp"
 #include "FileSystem.hpp"
+#include "FileWatcher.hpp"
+#include "MipGenerator.hpp"
+#include "stb_image.c"
 
-#if defined( RENDERER_METAL ) || defined( RENDERER_VULKAN )
 namespace Texture2DGlobal
 {
-    std::map< std::string, ae3d::Texture2D > hashToCachedTexture;
+    // Loaded textures by TextureCacheKey::value.
+    std::unordered_map< std::uint64_t, ae3d::Texture2D > cachedTextures;
+    // Keys in cachedTextures by TextureCacheKey::GetPathHash(), so TexReload() finds the textures of a path without trying all settings.
+    std::unordered_map< std::uint64_t, std::vector< ae3d::TextureCacheKey > > pathHashToCacheKeys;
+    // Parsed atlas metadata by path, so that LoadFromAtlas() doesn't parse a file for every sprite.
+    std::unordered_map< std::string, ae3d::AtlasIndex > atlasIndices;
 }
-#endif
+
+extern ae3d::FileWatcher fileWatcher;
+const char* GetFullPath( const char* fileName ); // Defined in FileSystem.cpp
 
 // Checks for uncompressed formats in texture's file name.
 static const std::string extensions[] =
@@ -35,24 +49,104 @@ bool HasStbExtension( const std::string& path )
     return false;
 }
 
-void Tokenize( const std::string& str,
-              std::vector< std::string >& tokens,
-              const std::string& delimiters = " " )
+void FreeSTBPixels( unsigned char* pixels )
+{
+    stbi_image_free( pixels );
+}
+
+namespace ae3d
 {
-    // Skip delimiters at beginning.
-    std::string::size_type lastPos = str.find_first_not_of( delimiters, 0 );
-    // Find first "non-delimiter".
-    std::string::size_type pos = str.find_first_of( delimiters, lastPos );
-    
-    while (std::string::npos != pos || std::string::npos != lastPos)
+    // Image that Texture2D::LoadAsync() decoded or mapped on a worker thread and passes to Texture2D::Load().
+    struct DecodedImage
     {
-        // Found a token, add it to the vector.
-        tokens.push_back( str.substr( lastPos, pos - lastPos ) );
-        // Skip delimiters.  Note the "not_of"
-        lastPos = str.find_first_not_of( delimiters, pos );
-        // Find next "non-delimiter"
-        pos = str.find_first_of( delimiters, lastPos );
+        ~DecodedImage()
+        {
+            FreeSTBPixels( pixels );
+        }
+
+        // RGBA8 pixels. LoadSTBPixels() takes them.
+        unsigned char* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        int components = 0;
+        // Mipmaps of pixels. GenerateMipChain() takes them.
+        std::vector< unsigned char > mipChain;
+        // .dds file that was mapped instead of read into file contents.
+        FileSystem::FileView view;
+    };
+}
+
+// Decodes fileContents into RGBA8 pixels, or takes them from decoded. Free with FreeSTBPixels().
+unsigned char* LoadSTBPixels( const ae3d::FileSystem::FileContentsData& fileContents, ae3d::DecodedImage* decoded, int& outWidth, int& outHeight, int& outComponents )
+{
+    if (decoded != nullptr && decoded->pixels != nullptr)
+    {
+        outWidth = decoded->width;
+        outHeight = decoded->height;
+        outComponents = decoded->components;
+        unsigned char* pixels = decoded->pixels;
+        decoded->pixels = nullptr;
+        return pixels;
     }
+
+    return stbi_load_from_memory( fileContents.data.data(), static_cast< int >( fileContents.data.size() ), &outWidth, &outHeight, &outComponents, 4 );
+}
+
+bool HasDDSExtension( const std::string& path )
+{
+    return path.find( ".dds" ) != std::string::npos || path.find( ".DDS" ) != std::string::npos;
+}
+
+// Parses a .dds file without copying its data. If decoded has a mapped file, output points into the mapping, which is valid as long as decoded.
+DDSLoader::LoadResult LoadDDSContents( const ae3d::FileSystem::FileContentsData& fileContents, const ae3d::DecodedImage* decoded, int& outWidth, int& outHeight, bool& outOpaque, DDSLoader::Output& output )
+{
+    if (decoded != nullptr && decoded->view.IsLoaded())
+    {
+        return DDSLoader::Load( decoded->view, outWidth, outHeight, outOpaque, output );
+    }
+
+    return DDSLoader::Load( fileContents.data.data(), fileContents.data.size(), fileContents.path.c_str(), outWidth, outHeight, outOpaque, output );
+}
+
+// Can be called on worker threads.
+static void GenerateMips( const unsigned char* pixels, int width, int height, ae3d::TextureWrap wrap, ae3d::ColorSpace colorSpace, std::vector< unsigned char >& outMipChain )
+{
+    ae3d::MipGenerator::Settings settings;
+    settings.isSRGB = colorSpace == ae3d::ColorSpace::SRGB;
+    settings.isWrapped = wrap == ae3d::TextureWrap::Repeat;
+
+    outMipChain.resize( ae3d::MipGenerator::GetMipChainSize( width, height ) );
+    ae3d::MipGenerator::Generate( pixels, width, height, settings, outMipChain.data() );
+}
+
+// Generates a full mip chain of RGBA8 pixels, or takes it from decoded.
+void GenerateMipChain( const unsigned char* pixels, int width, int height, ae3d::TextureWrap wrap, ae3d::ColorSpace colorSpace, ae3d::DecodedImage* decoded, std::vector< unsigned char >& outMipChain )
+{
+    // Load() can have clamped the size.
+    if (decoded != nullptr && !decoded->mipChain.empty() && decoded->mipChain.size() == ae3d::MipGenerator::GetMipChainSize( width, height ))
+    {
+        outMipChain.swap( decoded->mipChain );
+        return;
+    }
+
+    GenerateMips( pixels, width, height, wrap, colorSpace, outMipChain );
+}
+
+void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+{
+    Load( fileContents, nullptr, aWrap, aFilter, aMipmaps, aColorSpace, aAnisotropy );
+}
+
+void ae3d::Texture2D::Unload()
+{
+    const AssetRegistry::Handle oldAssetHandle = assetHandle;
+    *this = *GetDefaultTexture();
+    AssetRegistry::Release( oldAssetHandle );
+}
+
+void ae3d::Texture2D::ReportScreenSize( float screenSizeInPixels ) const
+{
+    TextureStreamer::ReportScreenSize( streamHandle, screenSizeInPixels );
 }
 
 float GetFloatAnisotropy( ae3d::Anisotropy anisotropy )
@@ -78,165 +172,259 @@ float GetFloatAnisotropy( ae3d::Anisotropy anisotropy )
     return 1;
 }
 
-namespace Texture2DGlobal
+static std::uint64_t HashPath( const std::string& path )
 {
-    extern std::map< std::string, ae3d::Texture2D > hashToCachedTexture;
+    std::uint64_t hash = 14695981039346656037ull;
+
+    for (char c : path)
+    {
+        hash ^= static_cast< unsigned char >( c );
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
 }
 
 namespace ae3d
 {
-    std::string GetCacheHash( const std::string& path, ae3d::TextureWrap wrap, ae3d::TextureFilter filter, ae3d::Mipmaps mipmaps, ae3d::ColorSpace colorSpace, ae3d::Anisotropy anisotropy )
+    TextureCacheKey GetCacheKey( const std::string& path, ae3d::TextureWrap wrap, ae3d::TextureFilter filter, ae3d::Mipmaps mipmaps, ae3d::ColorSpace colorSpace, ae3d::Anisotropy anisotropy )
+    {
+        const std::uint64_t settings = static_cast< std::uint64_t >( wrap ) | (static_cast< std::uint64_t >( filter ) << 1) | (static_cast< std::uint64_t >( mipmaps ) << 2) |
+                                       (static_cast< std::uint64_t >( colorSpace ) << 3) | (static_cast< std::uint64_t >( anisotropy ) << 4);
+        TextureCacheKey key;
+        key.value = (HashPath( path ) << 8) | settings;
+        return key;
+    }
+}
+
+// Returns the cached texture of key, or null. Paths are compared because different paths can have the same hash. Doesn't allocate.
+ae3d::Texture2D* FindCachedTexture( const ae3d::TextureCacheKey& key, const std::string& path )
+{
+    const auto it = Texture2DGlobal::cachedTextures.find( key.value );
+    return (it != std::end( Texture2DGlobal::cachedTextures ) && it->second.GetPath() == path) ? &it->second : nullptr;
+}
+
+void CacheTexture( const ae3d::TextureCacheKey& key, const ae3d::Texture2D& texture )
+{
+    Texture2DGlobal::cachedTextures[ key.value ] = texture;
+    std::vector< ae3d::TextureCacheKey >& keys = Texture2DGlobal::pathHashToCacheKeys[ key.GetPathHash() ];
+
+    if (std::find( std::begin( keys ), std::end( keys ), key ) == std::end( keys ))
+    {
+        keys.push_back( key );
+    }
+}
+
+void EraseCachedTexture( const ae3d::TextureCacheKey& key )
+{
+    Texture2DGlobal::cachedTextures.erase( key.value );
+    const auto it = Texture2DGlobal::pathHashToCacheKeys.find( key.GetPathHash() );
+
+    if (it != std::end( Texture2DGlobal::pathHashToCacheKeys ))
     {
-        return path + std::to_string( static_cast<int>(wrap) ) + std::to_string( static_cast<int>(filter) ) +
-            std::to_string( static_cast<int>(mipmaps) ) + std::to_string( static_cast<int>(colorSpace) ) + std::to_string( static_cast< int >(anisotropy) );
+        it->second.erase( std::remove( std::begin( it->second ), std::end( it->second ), key ), std::end( it->second ) );
+
+        if (it->second.empty())
+        {
+            Texture2DGlobal::pathHashToCacheKeys.erase( it );
+        }
     }
 }
 
 void ClearPSOCache();
 
+// Reloads all cached textures of path, whatever settings they were loaded with.
 void TexReload( const std::string& path )
 {
-    std::string cacheHash = GetCacheHash( path, ae3d::TextureWrap::Clamp, ae3d::TextureFilter::Nearest, ae3d::Mipmaps::None, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
     ae3d::System::Print("reloading texture %s\n", path.c_str());
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    // Same as TextureCacheKey::GetPathHash().
+    const auto it = Texture2DGlobal::pathHashToCacheKeys.find( (HashPath( path ) << 8) >> 8 );
+
+    if (it == std::end( Texture2DGlobal::pathHashToCacheKeys ))
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        return;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Nearest, ae3d::Mipmaps::Generate, ae3d::ColorSpace::Linear, ae3d::Anisotropy::k1 );
+    // Load() can update the index.
+    const std::vector< ae3d::TextureCacheKey > keys = it->second;
+    const auto fileContents = ae3d::FileSystem::FileContents( path.c_str() );
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    for (const auto& key : keys)
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        ae3d::Texture2D* tex = FindCachedTexture( key, path );
+
+        if (tex != nullptr)
+        {
+            tex->Load( fileContents, tex->GetWrap(), tex->GetFilter(), tex->GetMipmaps(), tex->GetColorSpace(), tex->GetAnisotropy() );
+        }
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Nearest, ae3d::Mipmaps::None, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+#if RENDERER_D3D12
+    ClearPSOCache();
+#endif
+}
+
+static void AtlasReload( const std::string& path )
+{
+    Texture2DGlobal::atlasIndices.erase( path );
+}
+
+static const ae3d::AtlasIndex* GetAtlasIndex( const ae3d::FileSystem::FileContentsData& metaData )
+{
+    const auto it = Texture2DGlobal::atlasIndices.find( metaData.path );
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    if (it != std::end( Texture2DGlobal::atlasIndices ))
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        return &it->second;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Clamp, ae3d::TextureFilter::Linear, ae3d::Mipmaps::None, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+    const bool isBinary = ae3d::AtlasIndex::IsBinary( metaData.data.data(), metaData.data.size() );
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    if (!isBinary && metaData.path.find( ".xml" ) == std::string::npos && metaData.path.find( ".XML" ) == std::string::npos)
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        ae3d::System::Print( "Atlas meta data path %s extension is not .xml and it's not a binary atlas index!\n", metaData.path.c_str() );
+        return nullptr;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Linear, ae3d::Mipmaps::None, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+    ae3d::AtlasIndex index;
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    if (!index.Load( metaData.data.data(), metaData.data.size() ))
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        ae3d::System::Print( "Could not load atlas meta data %s.\n", metaData.path.c_str() );
+        return nullptr;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Clamp, ae3d::TextureFilter::Linear, ae3d::Mipmaps::Generate, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+    ae3d::AtlasIndex& cachedIndex = Texture2DGlobal::atlasIndices[ metaData.path ];
+    cachedIndex = std::move( index );
+    fileWatcher.AddFile( metaData.path, AtlasReload );
+    return &cachedIndex;
+}
+
+void ae3d::Texture2D::LoadFromAtlas( const FileSystem::FileContentsData& atlasTextureData, const FileSystem::FileContentsData& atlasMetaData, const char* textureName, TextureWrap aWrap, TextureFilter aFilter, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+{
+    Load( atlasTextureData, aWrap, aFilter, mipmaps, aColorSpace, aAnisotropy );
+
+    const AtlasIndex* atlasIndex = GetAtlasIndex( atlasMetaData );
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    if (atlasIndex == nullptr)
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        return;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Linear, ae3d::Mipmaps::Generate, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+    const AtlasIndex::Rect* rect = atlasIndex->Find( textureName );
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    if (rect == nullptr)
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        System::Print( "Atlas %s doesn't have %s.\n", atlasMetaData.path.c_str(), textureName );
+        return;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Repeat, ae3d::TextureFilter::Nearest, ae3d::Mipmaps::Generate, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+    scaleOffset.x = rect->width / static_cast< float >( width );
+    scaleOffset.y = rect->height / static_cast< float >( height );
+    scaleOffset.z = rect->x / static_cast< float >( width );
+    scaleOffset.w = rect->y / static_cast< float >( height );
+    width = rect->width;
+    height = rect->height;
+}
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+void ae3d::Texture2D::LoadFromAtlas( const FileSystem::FileContentsData& atlasTextureData, const char* atlasMetaDataPath, const char* textureName, TextureWrap aWrap, TextureFilter aFilter, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+{
+    if (atlasMetaDataPath == nullptr)
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        System::Print( "LoadFromAtlas: Atlas meta data path is null.\n" );
+        return;
     }
 
-    cacheHash = GetCacheHash( path, ae3d::TextureWrap::Clamp, ae3d::TextureFilter::Nearest, ae3d::Mipmaps::Generate, ae3d::ColorSpace::SRGB, ae3d::Anisotropy::k1 );
+    // Indices are cached by the path that FileContents() reports, so a cached index is found without reading the file.
+    const auto it = Texture2DGlobal::atlasIndices.find( GetFullPath( atlasMetaDataPath ) );
 
-    if (Texture2DGlobal::hashToCachedTexture.find( cacheHash ) != std::end( Texture2DGlobal::hashToCachedTexture ))
+    if (it != std::end( Texture2DGlobal::atlasIndices ))
     {
-        auto& tex = Texture2DGlobal::hashToCachedTexture[ cacheHash ];
-        tex.Load( ae3d::FileSystem::FileContents( path.c_str() ), tex.GetWrap(), tex.GetFilter(), tex.GetMipmaps(), tex.GetColorSpace(), tex.GetAnisotropy() );
+        FileSystem::FileContentsData cachedMetaData;
+        cachedMetaData.path = it->first;
+        cachedMetaData.isLoaded = true;
+        LoadFromAtlas( atlasTextureData, cachedMetaData, textureName, aWrap, aFilter, aColorSpace, aAnisotropy );
+        return;
     }
 
-#if RENDERER_D3D12
-    ClearPSOCache();
-#endif
+    LoadFromAtlas( atlasTextureData, FileSystem::FileContents( atlasMetaDataPath ), textureName, aWrap, aFilter, aColorSpace, aAnisotropy );
 }
 
-void ae3d::Texture2D::LoadFromAtlas( const FileSystem::FileContentsData& atlasTextureData, const FileSystem::FileContentsData& atlasMetaData, const char* textureName, TextureWrap aWrap, TextureFilter aFilter, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+ae3d::AsyncLoader::Handle ae3d::Texture2D::LoadAsync( const char* aPath, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
 {
-    Load( atlasTextureData, aWrap, aFilter, mipmaps, aColorSpace, aAnisotropy );
+    const bool usesPlaceholder = handle == 0;
 
-    const std::string metaStr = std::string( std::begin( atlasMetaData.data ), std::end( atlasMetaData.data ) );
-    std::stringstream metaStream( metaStr );
-
-    if (atlasMetaData.path.find( ".xml" ) == std::string::npos && atlasMetaData.path.find( ".XML" ) == std::string::npos)
+    if (usesPlaceholder)
     {
-        System::Print( "Atlas meta data path %s extension is not .xml!", atlasMetaData.path.c_str() );
-        return;
+        *this = *GetDefaultTexture();
     }
 
-    std::string line;
+    // Written by the worker and read by finish after it.
+    struct Job
+    {
+        FileSystem::FileContentsData contents;
+        DecodedImage decoded;
+    };
+
+    std::shared_ptr< Job > job = std::make_shared< Job >();
+    const std::string texturePath = aPath != nullptr ? aPath : "";
+    Texture2D* texture = this;
 
-    while (std::getline( metaStream, line ))
+    auto load = [job, texturePath, aWrap, aMipmaps, aColorSpace]()
     {
-        if (line.find( "<Image Name" ) == std::string::npos)
+#if RENDERER_VULKAN
+        // Compressed blocks are uploaded straight from the mapped file.
+        if (HasDDSExtension( texturePath ))
+        {
+            job->decoded.view = FileSystem::OpenFileView( texturePath.c_str() );
+            job->contents.path = job->decoded.view.GetPath();
+            job->contents.isLoaded = job->decoded.view.IsLoaded();
+            return job->contents.isLoaded;
+        }
+#endif
+        job->contents = FileSystem::FileContents( texturePath.c_str() );
+
+        if (job->contents.isLoaded && HasStbExtension( job->contents.path ))
+        {
+            // On failure LoadSTB() decodes again to report stb_image's reason, which is per thread.
+            DecodedImage& decoded = job->decoded;
+            decoded.pixels = stbi_load_from_memory( job->contents.data.data(), static_cast< int >( job->contents.data.size() ), &decoded.width, &decoded.height, &decoded.components, 4 );
+        }
+
+#if RENDERER_VULKAN
+        // Vulkan uploads mipmaps that were generated on the CPU.
+        if (job->decoded.pixels != nullptr && aMipmaps == Mipmaps::Generate)
         {
-            continue;
+            GenerateMips( job->decoded.pixels, job->decoded.width, job->decoded.height, aWrap, aColorSpace, job->decoded.mipChain );
         }
+#else
+        (void)aWrap;
+        (void)aMipmaps;
+        (void)aColorSpace;
+#endif
 
-        std::vector< std::string > tokens;
-        Tokenize( line, tokens, "\"" );
-        bool found = false;
+        return job->contents.isLoaded;
+    };
 
-        for (std::size_t t = 0; t < tokens.size(); ++t)
+    auto finish = [job, texture, usesPlaceholder, aWrap, aFilter, aMipmaps, aColorSpace, aAnisotropy]( bool loaded )
+    {
+        if (!loaded)
         {
-            if (tokens[ t ].find( "Name" ) != std::string::npos && tokens[ t + 1 ] == textureName)
-            {
-                found = true;
-            }
-
-            if (!found)
-            {
-                continue;
-            }
-
-            if (tokens[ t ].find( "XPos" ) != std::string::npos)
-            {
-                scaleOffset.z = std::stoi( tokens[ t + 1 ] ) / static_cast<float>(width);
-            }
-            else if (tokens[ t ].find( "YPos" ) != std::string::npos)
-            {
-                scaleOffset.w = std::stoi( tokens[ t + 1 ] ) / static_cast<float>(height);
-            }
-            else if (tokens[ t ].find( "Width" ) != std::string::npos)
-            {
-                const int w = std::stoi( tokens[ t + 1 ] );
-                scaleOffset.x = 1.0f / (static_cast<float>(width) / static_cast<float>(w));
-                width = w;
-            }
-            else if (tokens[ t ].find( "Height" ) != std::string::npos)
-            {
-                const int h = std::stoi( tokens[ t + 1 ] );
-                scaleOffset.y = 1.0f / (static_cast<float>(height) / static_cast<float>(h));
-                height = h;
-            }
+            return false;
         }
 
-        if (found)
+        // Doesn't release the placeholder, it's still the default texture.
+        if (usesPlaceholder)
         {
-            return;
+            *texture = Texture2D();
         }
-    }
+
+        // Pixels and mipmaps that Load() didn't take, for example because the texture was cached, are freed with the job.
+        texture->Load( job->contents, &job->decoded, aWrap, aFilter, aMipmaps, aColorSpace, aAnisotropy );
+
+        return true;
+    };
+
+    return AsyncLoader::Queue( load, finish );
 }
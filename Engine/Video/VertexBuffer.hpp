@@ -14,12 +14,20 @@
 
 namespace ae3d
 {
-    /// Contains a vertex and index buffer. Indices are 16-bit.
+    namespace Quantization
+    {
+        struct VertexPTNTC;
+        struct VertexPTN;
+        struct VertexPTNTC_Skinned;
+    }
+
+    /// Contains a vertex and index buffer. Indices are 16-bit, or 32-bit if the buffer was generated from Face32.
     class VertexBuffer
     {
     public:
         enum class Storage { CPU, GPU };
-        enum class VertexFormat { PTC, PTN, PTNTC, PTNTC_Skinned, Empty };
+        enum class VertexFormat { PTC, PTN, PTNTC, PTNTC_Skinned, PTNTC_Quantized, PTNTC_Skinned_Quantized, Empty };
+        enum class IndexType { UInt16, UInt32 };
 
         /// Triangle of 3 vertices.
         struct Face
@@ -35,6 +43,20 @@ namespace ae3d
             unsigned short a, b, c;
         };
 
+        /// Triangle of 3 vertices with 32-bit indices. Needed when there are more than 65535 vertices.
+        struct Face32
+        {
+            Face32() noexcept : a(0), b(0), c(0) {}
+
+            Face32( unsigned fa, unsigned fb, unsigned fc )
+            : a( fa )
+            , b( fb )
+            , c( fc )
+            {}
+
+            unsigned a, b, c;
+        };
+
         /// Vertex with position, texture coordinate and color.
         struct VertexPTC
         {
@@ -112,6 +134,9 @@ namespace ae3d
 
         VertexFormat GetVertexFormat() const { return vertexFormat; }
 
+        /// \return Index element type.
+        IndexType GetIndexType() const { return indexType; }
+
         /// \return True if the buffer contains geometry ready for rendering.
         bool IsGenerated() const { return elementCount != 0; }
 
@@ -135,6 +160,23 @@ namespace ae3d
         /// \param vertexCount Vertex count.
         void UpdateDynamic( const Face* faces, int faceCount, const VertexPTC* vertices, int vertexCount );
 
+        /// Generates a buffer whose parts can be updated with UpdateDynamicVertices() and UpdateDynamicFaces().
+        /// \param faceCount Face capacity.
+        /// \param vertexCount Vertex capacity.
+        /// \param indexType UInt32 is needed when there are more than 65535 vertices.
+        void GenerateDynamic( int faceCount, int vertexCount, IndexType indexType );
+
+        /// Updates a range of vertices. Other vertices keep their contents.
+        /// \param vertices Vertices.
+        /// \param firstVertex Index of the first updated vertex in the buffer.
+        /// \param vertexCount Vertex count.
+        void UpdateDynamicVertices( const VertexPTC* vertices, int firstVertex, int vertexCount );
+
+        /// Updates faces from the beginning of a buffer that was generated with IndexType::UInt32.
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        void UpdateDynamicFaces( const Face32* faces, int faceCount );
+
         /// Generates the buffer from supplied geometry.
         /// \param faces Faces.
         /// \param faceCount Face count.
@@ -156,6 +198,89 @@ namespace ae3d
         /// \param vertexCount Vertex count.
         void Generate( const Face* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount );
 
+        /// Generates the buffer from supplied geometry.
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        void Generate( const Face32* faces, int faceCount, const VertexPTN* vertices, int vertexCount );
+
+        /// Generates the buffer from supplied geometry.
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        void Generate( const Face32* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount );
+
+        /// Generates the buffer from supplied geometry.
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        void Generate( const Face32* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount );
+
+#if RENDERER_VULKAN
+        /// Generates the buffer from quantized vertices without decoding them. Vertex shaders decode them with GetVertexScale() and GetVertexOffset().
+        /// \param faces Faces.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        /// \param aabbMin AABB min that the positions are relative to.
+        /// \param aabbMax AABB max that the positions are relative to.
+        void Generate( const Face* faces, int faceCount, const Quantization::VertexPTN* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax );
+
+        /// Generates the buffer from quantized vertices without decoding them. Vertex shaders decode them with GetVertexScale() and GetVertexOffset().
+        /// \param faces Faces.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        /// \param aabbMin AABB min that the positions are relative to.
+        /// \param aabbMax AABB max that the positions are relative to.
+        void Generate( const Face* faces, int faceCount, const Quantization::VertexPTNTC* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax );
+
+        /// Generates the buffer from quantized vertices without decoding them. Vertex shaders decode them with GetVertexScale() and GetVertexOffset().
+        /// \param faces Faces.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        /// \param aabbMin AABB min that the positions are relative to.
+        /// \param aabbMax AABB max that the positions are relative to.
+        void Generate( const Face* faces, int faceCount, const Quantization::VertexPTNTC_Skinned* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax );
+
+        /// Generates the buffer from quantized vertices without decoding them. Vertex shaders decode them with GetVertexScale() and GetVertexOffset().
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        /// \param aabbMin AABB min that the positions are relative to.
+        /// \param aabbMax AABB max that the positions are relative to.
+        void Generate( const Face32* faces, int faceCount, const Quantization::VertexPTN* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax );
+
+        /// Generates the buffer from quantized vertices without decoding them. Vertex shaders decode them with GetVertexScale() and GetVertexOffset().
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        /// \param aabbMin AABB min that the positions are relative to.
+        /// \param aabbMax AABB max that the positions are relative to.
+        void Generate( const Face32* faces, int faceCount, const Quantization::VertexPTNTC* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax );
+
+        /// Generates the buffer from quantized vertices without decoding them. Vertex shaders decode them with GetVertexScale() and GetVertexOffset().
+        /// \param faces Faces with 32-bit indices.
+        /// \param faceCount Face count.
+        /// \param vertices Vertices.
+        /// \param vertexCount Vertex count.
+        /// \param aabbMin AABB min that the positions are relative to.
+        /// \param aabbMax AABB max that the positions are relative to.
+        void Generate( const Face32* faces, int faceCount, const Quantization::VertexPTNTC_Skinned* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax );
+
+        /// \return Position scale in xyz. w is 1 if normals and tangents are octahedral, 0 if the vertices are full precision.
+        const Vec4& GetVertexScale() const { return vertexScale; }
+
+        /// \return Position offset in xyz.
+        const Vec4& GetVertexOffset() const { return vertexOffset; }
+#endif
+
         /// Sets a graphics API debug name for the buffer, visible in debugging tools. Must be called after Generate().
         /// \param name Name
         void SetDebugName( const char* name );
@@ -181,6 +306,9 @@ namespace ae3d
         VkBuffer* GetVertexBuffer() { return &vertexBuffer; }
         VkBuffer* GetIndexBuffer() { return &indexBuffer; }
 
+        /// Destroys the buffers when the GPU has finished the frames that use them. The buffer can be generated again.
+        void Release();
+
 #endif
         /// Destroys graphics API objects.
         static void DestroyBuffers();
@@ -197,6 +325,7 @@ namespace ae3d
 
 #if RENDERER_D3D12
         void UploadVB( void* faces, void* vertices, unsigned ibSize );
+        void UploadVB( void* faces, const VertexPTN* vertices, int vertexCount, unsigned ibSize );
         // Index buffer is stored in the vertex buffer after vertex data.
         ID3D12Resource* vb = nullptr;
         D3D12_VERTEX_BUFFER_VIEW vertexBufferView = {};
@@ -207,12 +336,20 @@ namespace ae3d
 #endif
         int elementCount = 0;
         VertexFormat vertexFormat = VertexFormat::PTC;
+        IndexType indexType = IndexType::UInt16;
 #if RENDERER_METAL
+        void GenerateBuffers( const void* faces, int faceCount, const VertexPTN* vertices, int vertexCount );
+        void GenerateBuffers( const void* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount );
+        void GenerateBuffers( const void* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount );
+
         id<MTLBuffer> vertexBuffer;
         id<MTLBuffer> indexBuffer;
 #endif
 #if RENDERER_VULKAN
         void GenerateVertexBuffer( const void* vertexData, int vertexBufferSize, int vertexStride, const void* indexData, int indexBufferSize );
+        void GenerateVertexBuffer( const VertexPTN* vertices, int vertexCount, const void* indexData, int indexBufferSize );
+        void GenerateVertexBuffer( const Quantization::VertexPTN* vertices, int vertexCount, const void* indexData, int indexBufferSize );
+        void SetQuantizationBounds( const Vec3& aabbMin, const Vec3& aabbMax );
         void CreateInputState( int vertexStride );
 
         VkBuffer vertexBuffer = VK_NULL_HANDLE;
@@ -220,6 +357,8 @@ namespace ae3d
         VkPipelineVertexInputStateCreateInfo inputStateCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO, nullptr, 0, 0, nullptr, 0, nullptr };
         VkVertexInputBindingDescription bindingDescriptions;
         VkVertexInputAttributeDescription attributeDescriptions[ 7 ];
+        Vec4 vertexScale = Vec4( 1, 1, 1, 0 );
+        Vec4 vertexOffset = Vec4( 0, 0, 0, 0 );
 
         VkBuffer indexBuffer = VK_NULL_HANDLE;
         VkDeviceMemory indexMem = VK_NULL_HANDLE;
@@ -227,8 +366,8 @@ namespace ae3d
         struct Buffer
         {
             int size = 0;
-            VkDeviceMemory memory;
-            VkBuffer buffer;
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkBuffer buffer = VK_NULL_HANDLE;
             void* mappedData = nullptr;
         };
 
@@ -0,0 +1,242 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+#include "DeletionQueueVulkan.hpp"
+#include <utility>
+#include <vector>
+#include "Macros.hpp"
+#include "System.hpp"
+
+namespace GfxDeviceGlobal
+{
+    extern VkDevice device;
+}
+
+namespace DeletionQueueGlobal
+{
+    struct Frame
+    {
+        std::vector< VkFramebuffer > frameBuffers;
+        std::vector< VkRenderPass > renderPasses;
+        std::vector< VkImageView > views;
+        std::vector< VkImage > images;
+        std::vector< VkSampler > samplers;
+        std::vector< VkBuffer > buffers;
+        std::vector< VkDeviceMemory > memory;
+        std::uint64_t frameIndex = 0;
+        VkFence fence = VK_NULL_HANDLE;
+    };
+
+    /// Objects released in the frame that is being recorded.
+    Frame recording;
+    /// Ended frames, oldest first.
+    std::vector< Frame > pendingFrames;
+    /// Unsignalled fences that can be used for new frames.
+    std::vector< VkFence > freeFences;
+    std::uint64_t frameIndex = 0;
+    std::uint64_t completedFrameCount = 0;
+}
+
+static unsigned GetObjectCount( const DeletionQueueGlobal::Frame& frame )
+{
+    return static_cast< unsigned >( frame.frameBuffers.size() + frame.renderPasses.size() + frame.views.size() + frame.images.size() +
+                                    frame.samplers.size() + frame.buffers.size() + frame.memory.size() );
+}
+
+// Memory is freed last because the other objects can be bound to it.
+static void DestroyObjects( DeletionQueueGlobal::Frame& frame )
+{
+    const VkDevice device = GfxDeviceGlobal::device;
+
+    for (auto frameBuffer : frame.frameBuffers)
+    {
+        vkDestroyFramebuffer( device, frameBuffer, nullptr );
+    }
+
+    for (auto renderPass : frame.renderPasses)
+    {
+        vkDestroyRenderPass( device, renderPass, nullptr );
+    }
+
+    for (auto view : frame.views)
+    {
+        vkDestroyImageView( device, view, nullptr );
+    }
+
+    for (auto image : frame.images)
+    {
+        vkDestroyImage( device, image, nullptr );
+    }
+
+    for (auto sampler : frame.samplers)
+    {
+        vkDestroySampler( device, sampler, nullptr );
+    }
+
+    for (auto buffer : frame.buffers)
+    {
+        vkDestroyBuffer( device, buffer, nullptr );
+    }
+
+    for (auto memory : frame.memory)
+    {
+        vkFreeMemory( device, memory, nullptr );
+    }
+
+    frame.frameBuffers.clear();
+    frame.renderPasses.clear();
+    frame.views.clear();
+    frame.images.clear();
+    frame.samplers.clear();
+    frame.buffers.clear();
+    frame.memory.clear();
+}
+
+template< typename T >
+static void AddObject( std::vector< T >& objects, T object )
+{
+    if (object != VK_NULL_HANDLE)
+    {
+        objects.push_back( object );
+    }
+}
+
+void ae3d::DeletionQueue::ReleaseBuffer( VkBuffer buffer )
+{
+    AddObject( DeletionQueueGlobal::recording.buffers, buffer );
+}
+
+void ae3d::DeletionQueue::ReleaseMemory( VkDeviceMemory memory )
+{
+    AddObject( DeletionQueueGlobal::recording.memory, memory );
+}
+
+void ae3d::DeletionQueue::ReleaseImage( VkImage image )
+{
+    AddObject( DeletionQueueGlobal::recording.images, image );
+}
+
+void ae3d::DeletionQueue::ReleaseImageView( VkImageView view )
+{
+    AddObject( DeletionQueueGlobal::recording.views, view );
+}
+
+void ae3d::DeletionQueue::ReleaseSampler( VkSampler sampler )
+{
+    AddObject( DeletionQueueGlobal::recording.samplers, sampler );
+}
+
+void ae3d::DeletionQueue::ReleaseFramebuffer( VkFramebuffer frameBuffer )
+{
+    AddObject( DeletionQueueGlobal::recording.frameBuffers, frameBuffer );
+}
+
+void ae3d::DeletionQueue::ReleaseRenderPass( VkRenderPass renderPass )
+{
+    AddObject( DeletionQueueGlobal::recording.renderPasses, renderPass );
+}
+
+VkFence ae3d::DeletionQueue::GetFrameFence()
+{
+    DeletionQueueGlobal::Frame& recording = DeletionQueueGlobal::recording;
+
+    if (recording.fence != VK_NULL_HANDLE)
+    {
+        return recording.fence;
+    }
+
+    if (!DeletionQueueGlobal::freeFences.empty())
+    {
+        recording.fence = DeletionQueueGlobal::freeFences.back();
+        DeletionQueueGlobal::freeFences.pop_back();
+        return recording.fence;
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkResult err = vkCreateFence( GfxDeviceGlobal::device, &fenceInfo, nullptr, &recording.fence );
+    AE3D_CHECK_VULKAN( err, "vkCreateFence" );
+
+    return recording.fence;
+}
+
+void ae3d::DeletionQueue::EndFrame( VkQueue queue )
+{
+    DeletionQueueGlobal::Frame& recording = DeletionQueueGlobal::recording;
+
+    if (recording.fence == VK_NULL_HANDLE && GetObjectCount( recording ) > 0)
+    {
+        // Signals when all work that has been submitted to the queue has finished.
+        VkResult err = vkQueueSubmit( queue, 0, nullptr, GetFrameFence() );
+        AE3D_CHECK_VULKAN( err, "vkQueueSubmit for frame fence" );
+    }
+
+    if (recording.fence != VK_NULL_HANDLE)
+    {
+        recording.frameIndex = DeletionQueueGlobal::frameIndex;
+        DeletionQueueGlobal::pendingFrames.push_back( std::move( recording ) );
+        recording = DeletionQueueGlobal::Frame();
+    }
+
+    ++DeletionQueueGlobal::frameIndex;
+
+    auto& pendingFrames = DeletionQueueGlobal::pendingFrames;
+    std::size_t completedCount = 0;
+
+    while (completedCount < pendingFrames.size() && vkGetFenceStatus( GfxDeviceGlobal::device, pendingFrames[ completedCount ].fence ) == VK_SUCCESS)
+    {
+        DeletionQueueGlobal::Frame& frame = pendingFrames[ completedCount ];
+        DestroyObjects( frame );
+
+        VkResult err = vkResetFences( GfxDeviceGlobal::device, 1, &frame.fence );
+        AE3D_CHECK_VULKAN( err, "vkResetFences" );
+        DeletionQueueGlobal::freeFences.push_back( frame.fence );
+        DeletionQueueGlobal::completedFrameCount = frame.frameIndex + 1;
+
+        ++completedCount;
+    }
+
+    pendingFrames.erase( std::begin( pendingFrames ), std::begin( pendingFrames ) + completedCount );
+}
+
+void ae3d::DeletionQueue::ReleaseAll()
+{
+    for (auto& frame : DeletionQueueGlobal::pendingFrames)
+    {
+        DestroyObjects( frame );
+        vkDestroyFence( GfxDeviceGlobal::device, frame.fence, nullptr );
+    }
+
+    DestroyObjects( DeletionQueueGlobal::recording );
+    vkDestroyFence( GfxDeviceGlobal::device, DeletionQueueGlobal::recording.fence, nullptr );
+    DeletionQueueGlobal::recording.fence = VK_NULL_HANDLE;
+
+    for (auto fence : DeletionQueueGlobal::freeFences)
+    {
+        vkDestroyFence( GfxDeviceGlobal::device, fence, nullptr );
+    }
+
+    DeletionQueueGlobal::pendingFrames.clear();
+    DeletionQueueGlobal::freeFences.clear();
+}
+
+std::uint64_t ae3d::DeletionQueue::GetFrameIndex()
+{
+    return DeletionQueueGlobal::frameIndex;
+}
+
+std::uint64_t ae3d::DeletionQueue::GetCompletedFrameCount()
+{
+    return DeletionQueueGlobal::completedFrameCount;
+}
+
+unsigned ae3d::DeletionQueue::GetPendingCount()
+{
+    unsigned count = GetObjectCount( DeletionQueueGlobal::recording );
+
+    for (const auto& frame : DeletionQueueGlobal::pendingFrames)
+    {
+        count += GetObjectCount( frame );
+    }
+
+    return count;
+}
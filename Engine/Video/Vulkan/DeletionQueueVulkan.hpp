@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+namespace ae3d
+{
+    /**
+      Destroys Vulkan objects after the GPU has finished using them. Objects released in frame N are destroyed in a later
+      EndFrame() once frame N's fence has signalled, so resources can be destroyed and recreated at runtime without waiting
+      for the device to become idle. Uses GfxDeviceGlobal::device.
+    */
+    namespace DeletionQueue
+    {
+        /// Destroys the buffer when the current frame has finished on the GPU.
+        void ReleaseBuffer( VkBuffer buffer );
+
+        /// Frees the memory when the current frame has finished on the GPU. Objects bound to it must be released in the same frame.
+        void ReleaseMemory( VkDeviceMemory memory );
+
+        /// Destroys the image when the current frame has finished on the GPU.
+        void ReleaseImage( VkImage image );
+
+        /// Destroys the image view when the current frame has finished on the GPU.
+        void ReleaseImageView( VkImageView view );
+
+        /// Destroys the sampler when the current frame has finished on the GPU.
+        void ReleaseSampler( VkSampler sampler );
+
+        /// Destroys the frame buffer when the current frame has finished on the GPU.
+        void ReleaseFramebuffer( VkFramebuffer frameBuffer );
+
+        /// Destroys the render pass when the current frame has finished on the GPU.
+        void ReleaseRenderPass( VkRenderPass renderPass );
+
+        /// \return Fence that the frame's last vkQueueSubmit must signal. Same fence until EndFrame().
+        VkFence GetFrameFence();
+
+        /// Ends the current frame and destroys objects of frames whose fence has signalled. If GetFrameFence() was not called
+        /// and objects were released, submits the fence to queue without command buffers.
+        /// \param queue Queue that the frame was submitted to.
+        void EndFrame( VkQueue queue );
+
+        /// Destroys all released objects and fences. Call only when the device is idle.
+        void ReleaseAll();
+
+        /// \return Index of the frame that objects are currently released in.
+        std::uint64_t GetFrameIndex();
+
+        /// \return Objects released in frame N have been destroyed when this is greater than N.
+        std::uint64_t GetCompletedFrameCount();
+
+        /// \return Number of released objects that have not been destroyed yet.
+        unsigned GetPendingCount();
+    }
+}
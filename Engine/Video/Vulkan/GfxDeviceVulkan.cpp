@@ -8,6 +8,8 @@
 #include <string>
 #include <vulkan/vulkan.h>
 #include "Array.hpp"
+#include "AssetRegistry.hpp"
+#include "DeletionQueueVulkan.hpp"
 #include "FileSystem.hpp"
 #include "LightTiler.hpp"
 #include "Macros.hpp"
@@ -18,6 +20,7 @@
 #include "Statistics.hpp"
 #include "Texture2D.hpp"
 #include "TextureCube.hpp"
+#include "TextureStreamer.hpp"
 #include "VertexBuffer.hpp"
 #include "VulkanUtils.hpp"
 #include "VR.hpp"
@@ -124,7 +127,6 @@ namespace GfxDeviceGlobal
     VkFramebuffer frameBuffer0 = VK_NULL_HANDLE;
     VkImageView boundViews[ 13 ];
     VkSampler boundSamplers[ 2 ];
-    Array< VkBuffer > pendingFreeVBs;
     Array< Ubo > ubos;
 	unsigned currentUbo = 0;
     VkSampleCountFlagBits msaaSampleBits = VK_SAMPLE_COUNT_1_BIT;
@@ -160,6 +162,15 @@ namespace ae3d
                 str += "queue submit calls: " + std::to_string( ::Statistics::GetQueueSubmitCalls() ) + "\n";
                 str += "mem alloc calls: " + std::to_string( ::Statistics::GetAllocCalls() ) + " (frame), " + std::to_string( ::Statistics::GetTotalAllocCalls() ) + " (total)\n";
                 str += "triangles: " + std::to_string( ::Statistics::GetTriangleCount() ) + "\n";
+                str += "mesh triangles per LOD:";
+
+                for (int lod = 0; lod < ::Statistics::MaxMeshLods; ++lod)
+                {
+                    str += " " + std::to_string( ::Statistics::GetMeshLodTriangleCount( lod ) );
+                }
+
+                str += "\n";
+                str += "mesh CPU memory: " + std::to_string( ::Statistics::GetResidentMeshCpuBytes() / 1024 ) + " KiB\n";
 
 				std::strcpy( outStr, str.c_str() );
             }
@@ -1673,6 +1684,9 @@ namespace ae3d
         CreateDescriptorPool();
         CreateSemaphores();        
 
+        // DeletionQueue waits for the frame fence before destroying evicted assets.
+        AssetRegistry::SetFramesInFlight( 0 );
+
         GfxDevice::SetClearColor( 0, 0, 0 );
         GfxDevice::CreateUniformBuffers();
 
@@ -1997,6 +2011,8 @@ void ae3d::GfxDevice::Draw( VertexBuffer& vertexBuffer, int startIndex, int endI
     GfxDeviceGlobal::perObjectUboStruct.maxNumLightsPerTile = GfxDeviceGlobal::lightTiler.GetMaxNumLightsPerTile();
     GfxDeviceGlobal::perObjectUboStruct.tilesXY.x = (float)GfxDeviceGlobal::lightTiler.GetNumTilesX();
     GfxDeviceGlobal::perObjectUboStruct.tilesXY.y = (float)GfxDeviceGlobal::lightTiler.GetNumTilesY();
+    GfxDeviceGlobal::perObjectUboStruct.vertexScale = vertexBuffer.GetVertexScale();
+    GfxDeviceGlobal::perObjectUboStruct.vertexOffset = vertexBuffer.GetVertexOffset();
 
     UploadPerObjectUbo();
 
@@ -2013,7 +2029,8 @@ void ae3d::GfxDevice::Draw( VertexBuffer& vertexBuffer, int startIndex, int endI
 
     if (topology == PrimitiveTopology::Triangles)
     {
-        vkCmdBindIndexBuffer( GfxDeviceGlobal::currentCmdBuffer, *vertexBuffer.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT16 );
+        const VkIndexType indexType = vertexBuffer.GetIndexType() == VertexBuffer::IndexType::UInt32 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
+        vkCmdBindIndexBuffer( GfxDeviceGlobal::currentCmdBuffer, *vertexBuffer.GetIndexBuffer(), 0, indexType );
         vkCmdDrawIndexed( GfxDeviceGlobal::currentCmdBuffer, (endIndex - startIndex) * 3, 1, startIndex * 3, 0, 0 );
     }
     else if (topology == PrimitiveTopology::Lines)
@@ -2144,7 +2161,7 @@ void ae3d::GfxDevice::Present()
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &GfxDeviceGlobal::drawCmdBuffers[ GfxDeviceGlobal::currentBuffer ];
 
-    err = vkQueueSubmit( GfxDeviceGlobal::graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE );
+    err = vkQueueSubmit( GfxDeviceGlobal::graphicsQueue, 1, &submitInfo, DeletionQueue::GetFrameFence() );
     AE3D_CHECK_VULKAN( err, "vkQueueSubmit" );
 #endif
 
@@ -2183,12 +2200,9 @@ void ae3d::GfxDevice::Present()
     err = vkQueueWaitIdle( GfxDeviceGlobal::graphicsQueue );
     AE3D_CHECK_VULKAN( err, "vkQueueWaitIdle" );
 
-    for (unsigned i = 0; i < GfxDeviceGlobal::pendingFreeVBs.count; ++i)
-    {
-        vkDestroyBuffer( GfxDeviceGlobal::device, GfxDeviceGlobal::pendingFreeVBs[ i ], nullptr );
-    }
-
-    GfxDeviceGlobal::pendingFreeVBs.Allocate( 0 );
+    AssetRegistry::EndFrame();
+    TextureStreamer::Update();
+    DeletionQueue::EndFrame( GfxDeviceGlobal::graphicsQueue );
     Statistics::EndPresentTimeProfiling();
 }
 
@@ -2234,6 +2248,8 @@ void ae3d::GfxDevice::ReleaseGPUObjects()
         vkDestroyBuffer( GfxDeviceGlobal::device, GfxDeviceGlobal::ubos[ i ].ubo, nullptr );
     }
 
+    AssetRegistry::ReleaseEvicted();
+    DeletionQueue::ReleaseAll();
     Shader::DestroyShaders();
     ComputeShader::DestroyShaders();
     Texture2D::DestroyTextures();
@@ -113,6 +113,16 @@ float GetVRFov()
     return Global::vrFov;
 }
 
+Vec3 GetVREyePosition( int eye )
+{
+    Matrix44 view;
+    Matrix44::Multiply( Global::mat4HMDPose, eye == 0 ? Global::eyePosLeft : Global::eyePosRight, view );
+    Matrix44 eyeToWorld;
+    Matrix44::Invert( view, eyeToWorld );
+
+    return Vec3( eyeToWorld.m[ 12 ], eyeToWorld.m[ 13 ], eyeToWorld.m[ 14 ] );
+}
+
 bool CreateFrameBuffer( int width, int height, FramebufferDesc& outFramebufferDesc, const char* debugName )
 {
     outFramebufferDesc.width = width;
@@ -582,6 +592,7 @@ void ae3d::VR::SubmitFrame()
     GfxDeviceGlobal::renderPass = fbDesc.renderPass;
 
     int vrEye = 0;
+    VRGlobal::eye = vrEye;
     sceneRenderFunc( vrEye );
 
     vkCmdEndRenderPass( cmdBuffer );
@@ -655,6 +666,7 @@ void ae3d::VR::SubmitFrame()
     GfxDeviceGlobal::renderPass = fbDesc2.renderPass;
 
     vrEye = 1;
+    VRGlobal::eye = vrEye;
     sceneRenderFunc( vrEye );
 
     vkCmdEndRenderPass( cmdBuffer );
@@ -1,8 +1,10 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "RenderTexture.hpp"
+#include <algorithm>
 #include <vector>
 #include <string.h>
+#include "DeletionQueueVulkan.hpp"
 #include "GfxDevice.hpp"
 #include "Macros.hpp"
 #include "System.hpp"
@@ -68,6 +70,43 @@ void ae3d::RenderTexture::DestroyTextures()
     }
 }
 
+template< typename T >
+static void EraseObject( std::vector< T >& objects, T object )
+{
+    objects.erase( std::remove( std::begin( objects ), std::end( objects ), object ), std::end( objects ) );
+}
+
+void ae3d::RenderTexture::ReleaseObjects()
+{
+    if (frameBuffer == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    EraseObject( RenderTextureGlobal::fbsToReleaseAtExit, frameBuffer );
+    EraseObject( RenderTextureGlobal::imageViewsToReleaseAtExit, color.view );
+    EraseObject( RenderTextureGlobal::imageViewsToReleaseAtExit, depth.view );
+    EraseObject( RenderTextureGlobal::imagesToReleaseAtExit, color.image );
+    EraseObject( RenderTextureGlobal::imagesToReleaseAtExit, depth.image );
+    EraseObject( RenderTextureGlobal::memoryToReleaseAtExit, color.mem );
+    EraseObject( RenderTextureGlobal::memoryToReleaseAtExit, depth.mem );
+    EraseObject( RenderTextureGlobal::samplersToReleaseAtExit, sampler );
+
+    DeletionQueue::ReleaseFramebuffer( frameBuffer );
+    DeletionQueue::ReleaseImageView( color.view );
+    DeletionQueue::ReleaseImageView( depth.view );
+    DeletionQueue::ReleaseImage( color.image );
+    DeletionQueue::ReleaseImage( depth.image );
+    DeletionQueue::ReleaseMemory( color.mem );
+    DeletionQueue::ReleaseMemory( depth.mem );
+    DeletionQueue::ReleaseSampler( sampler );
+
+    frameBuffer = VK_NULL_HANDLE;
+    color = {};
+    depth = {};
+    sampler = VK_NULL_HANDLE;
+}
+
 static void CreateSampler( ae3d::TextureFilter filter, ae3d::TextureWrap wrap, VkSampler& outSampler, int mipLevelCount )
 {
     VkSamplerCreateInfo samplerInfo = {};
@@ -146,6 +185,8 @@ void ae3d::RenderTexture::Create2D( int aWidth, int aHeight, DataType aDataType,
     height = aHeight;
     wrap = aWrap;
     filter = aFilter;
+    ReleaseObjects();
+
     isCube = false;
     isRenderTexture = true;
     dataType = aDataType;
@@ -318,6 +359,8 @@ void ae3d::RenderTexture::CreateCube( int aDimension, DataType aDataType, Textur
     width = height = aDimension;
     wrap = aWrap;
     filter = aFilter;
+    ReleaseObjects();
+
     isCube = true;
     isRenderTexture = true;
     dataType = aDataType;
@@ -1,8 +1,12 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "Texture2D.hpp"
+#include <algorithm>
 #include <vector>
+#include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <cstdint>
 #include <cstring>
 #include <vulkan/vulkan.h>
@@ -10,25 +14,38 @@
 #include "stb_image.c"
 #include "Array.hpp"
 #include "DDSLoader.hpp"
+#include "DeletionQueueVulkan.hpp"
 #include "FileSystem.hpp"
+#include "FileWatcher.hpp"
 #include "Macros.hpp"
+#include "MipGenerator.hpp"
 #include "System.hpp"
 #include "Statistics.hpp"
+#include "TextureChannels.hpp"
 #include "VulkanUtils.hpp"
 
 bool HasStbExtension( const std::string& path ); // Defined in TextureCommon.cpp
+unsigned char* LoadSTBPixels( const ae3d::FileSystem::FileContentsData& fileContents, ae3d::DecodedImage* decoded, int& outWidth, int& outHeight, int& outComponents ); // Defined in TextureCommon.cpp
+void FreeSTBPixels( unsigned char* pixels ); // Defined in TextureCommon.cpp
+void GenerateMipChain( const unsigned char* pixels, int width, int height, ae3d::TextureWrap wrap, ae3d::ColorSpace colorSpace, ae3d::DecodedImage* decoded, std::vector< unsigned char >& outMipChain ); // Defined in TextureCommon.cpp
+DDSLoader::LoadResult LoadDDSContents( const ae3d::FileSystem::FileContentsData& fileContents, const ae3d::DecodedImage* decoded, int& outWidth, int& outHeight, bool& outOpaque, DDSLoader::Output& output ); // Defined in TextureCommon.cpp
+ae3d::Texture2D* FindCachedTexture( const ae3d::TextureCacheKey& key, const std::string& path ); // Defined in TextureCommon.cpp
+void CacheTexture( const ae3d::TextureCacheKey& key, const ae3d::Texture2D& texture ); // Defined in TextureCommon.cpp
+void EraseCachedTexture( const ae3d::TextureCacheKey& key ); // Defined in TextureCommon.cpp
+void TexReload( const std::string& path ); // Defined in TextureCommon.cpp
+
+extern ae3d::FileWatcher fileWatcher;
 float GetFloatAnisotropy( ae3d::Anisotropy anisotropy );
 
 namespace MathUtil
 {
-    int GetMipmapCount( int width, int height );
     int Max( int a, int b );
-    bool IsPowerOfTwo( unsigned i );
 }
 
 namespace GfxDeviceGlobal
 {
     extern VkDevice device;
+    extern VkPhysicalDevice physicalDevice;
     extern VkQueue graphicsQueue;
     extern VkPhysicalDeviceProperties properties;
     extern VkCommandBuffer texCmdBuffer;
@@ -43,6 +60,44 @@ namespace Texture2DGlobal
     std::vector< VkImage > imagesToReleaseAtExit;
     std::vector< VkImageView > imageViewsToReleaseAtExit;
     std::vector< VkDeviceMemory > memoryToReleaseAtExit;
+
+    /// Image of a streamed texture. It's replaced by a larger or smaller image when resident mip levels change,
+    /// so copies of the texture find it by their stream handle.
+    struct StreamedImage
+    {
+        std::string path;
+        /// File offset of each mip level.
+        std::vector< std::size_t > mipOffsets;
+        std::vector< std::size_t > mipSizes;
+        /// Mip level that was read on a worker thread.
+        std::vector< unsigned char > loadedMip;
+        ae3d::AssetRegistry::Handle assetHandle;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        int width = 0;
+        int height = 0;
+        /// Mip level 0 of image. Equals the mip level count before the first image is created.
+        int residentMip = 0;
+    };
+
+    /// Keys are TextureStreamer handle indices.
+    std::unordered_map< unsigned, std::shared_ptr< StreamedImage > > streamedImages;
+
+    /// Staging buffers of uploads that have been recorded into texCmdBuffer but not submitted.
+    std::vector< VkBuffer > pendingStagingBuffers;
+    std::vector< VkDeviceMemory > pendingStagingMemory;
+    VkDeviceSize pendingStagingSize = 0;
+    /// A batch is submitted early when its staging buffers grow over this.
+    const VkDeviceSize maxBatchStagingSize = 256 * 1024 * 1024;
+    bool isBatchingUploads = false;
+    /// True if texCmdBuffer has been begun for a batch and not submitted.
+    bool isRecordingBatch = false;
+    /// Signalled when texCmdBuffer's last submit has finished.
+    VkFence uploadFence = VK_NULL_HANDLE;
+    /// True if texCmdBuffer was submitted without waiting for it, so it can't be recorded before uploadFence has signalled.
+    bool isUploadInFlight = false;
 }
 
 void ae3d::Texture2D::DestroyTextures()
@@ -66,6 +121,433 @@ void ae3d::Texture2D::DestroyTextures()
     {
         vkFreeMemory( GfxDeviceGlobal::device, Texture2DGlobal::memoryToReleaseAtExit[ memoryIndex ], nullptr );
     }
+
+    vkDestroyFence( GfxDeviceGlobal::device, Texture2DGlobal::uploadFence, nullptr );
+    Texture2DGlobal::uploadFence = VK_NULL_HANDLE;
+    Texture2DGlobal::isUploadInFlight = false;
+    Texture2DGlobal::streamedImages.clear();
+}
+
+template< typename T >
+static void EraseObject( std::vector< T >& objects, T object )
+{
+    objects.erase( std::remove( std::begin( objects ), std::end( objects ), object ), std::end( objects ) );
+}
+
+// Destroys objects of a texture that AssetRegistry has evicted when the GPU has finished using them.
+static void DestroyTextureObjects( VkImage image, VkImageView view, VkDeviceMemory memory, VkSampler sampler )
+{
+    ae3d::DeletionQueue::ReleaseImageView( view );
+    ae3d::DeletionQueue::ReleaseImage( image );
+    ae3d::DeletionQueue::ReleaseMemory( memory );
+    ae3d::DeletionQueue::ReleaseSampler( sampler );
+
+    EraseObject( Texture2DGlobal::imageViewsToReleaseAtExit, view );
+    EraseObject( Texture2DGlobal::imagesToReleaseAtExit, image );
+    EraseObject( Texture2DGlobal::memoryToReleaseAtExit, memory );
+    EraseObject( Texture2DGlobal::samplersToReleaseAtExit, sampler );
+}
+
+// Waits until texCmdBuffer's last submit has finished if it was not waited for.
+static void WaitForUploads()
+{
+    if (!Texture2DGlobal::isUploadInFlight)
+    {
+        return;
+    }
+
+    VkResult err = vkWaitForFences( GfxDeviceGlobal::device, 1, &Texture2DGlobal::uploadFence, VK_TRUE, UINT64_MAX );
+    AE3D_CHECK_VULKAN( err, "vkWaitForFences in Texture2D" );
+    err = vkResetFences( GfxDeviceGlobal::device, 1, &Texture2DGlobal::uploadFence );
+    AE3D_CHECK_VULKAN( err, "vkResetFences in Texture2D" );
+    Texture2DGlobal::isUploadInFlight = false;
+}
+
+// Begins recording an upload into texCmdBuffer, unless a batch is already recording. Also used by TextureCube.
+void BeginTextureUpload()
+{
+    if (Texture2DGlobal::isRecordingBatch)
+    {
+        return;
+    }
+
+    WaitForUploads();
+
+    VkCommandBufferBeginInfo cmdBufInfo = {};
+    cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufInfo.pInheritanceInfo = nullptr;
+    cmdBufInfo.flags = 0;
+
+    VkResult err = vkBeginCommandBuffer( GfxDeviceGlobal::texCmdBuffer, &cmdBufInfo );
+    AE3D_CHECK_VULKAN( err, "vkBeginCommandBuffer in Texture2D" );
+
+    Texture2DGlobal::isRecordingBatch = Texture2DGlobal::isBatchingUploads;
+}
+
+// Submits recorded uploads and releases their staging buffers. If waitForGPU is false, the staging buffers are released through
+// DeletionQueue and the uploads finish before the frames that are submitted after them.
+static void SubmitUploads( bool waitForGPU )
+{
+    vkEndCommandBuffer( GfxDeviceGlobal::texCmdBuffer );
+
+    if (Texture2DGlobal::uploadFence == VK_NULL_HANDLE)
+    {
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkResult err = vkCreateFence( GfxDeviceGlobal::device, &fenceInfo, nullptr, &Texture2DGlobal::uploadFence );
+        AE3D_CHECK_VULKAN( err, "vkCreateFence in Texture2D" );
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &GfxDeviceGlobal::texCmdBuffer;
+
+    VkResult err = vkQueueSubmit( GfxDeviceGlobal::graphicsQueue, 1, &submitInfo, Texture2DGlobal::uploadFence );
+    AE3D_CHECK_VULKAN( err, "vkQueueSubmit in Texture2D" );
+    Texture2DGlobal::isUploadInFlight = true;
+
+    if (waitForGPU)
+    {
+        WaitForUploads();
+    }
+
+    for (std::size_t i = 0; i < Texture2DGlobal::pendingStagingBuffers.size(); ++i)
+    {
+        if (waitForGPU)
+        {
+            vkDestroyBuffer( GfxDeviceGlobal::device, Texture2DGlobal::pendingStagingBuffers[ i ], nullptr );
+            vkFreeMemory( GfxDeviceGlobal::device, Texture2DGlobal::pendingStagingMemory[ i ], nullptr );
+        }
+        else
+        {
+            ae3d::DeletionQueue::ReleaseBuffer( Texture2DGlobal::pendingStagingBuffers[ i ] );
+            ae3d::DeletionQueue::ReleaseMemory( Texture2DGlobal::pendingStagingMemory[ i ] );
+        }
+    }
+
+    Texture2DGlobal::pendingStagingBuffers.clear();
+    Texture2DGlobal::pendingStagingMemory.clear();
+    Texture2DGlobal::pendingStagingSize = 0;
+    Texture2DGlobal::isRecordingBatch = false;
+}
+
+// Adds an upload's staging buffer, if any, to the recorded uploads and submits them unless a batch is recording and has room.
+static void EndUpload( VkBuffer stagingBuffer, VkDeviceMemory stagingMemory, VkDeviceSize stagingSize, bool waitForGPU )
+{
+    if (stagingBuffer != VK_NULL_HANDLE)
+    {
+        Texture2DGlobal::pendingStagingBuffers.push_back( stagingBuffer );
+        Texture2DGlobal::pendingStagingMemory.push_back( stagingMemory );
+        Texture2DGlobal::pendingStagingSize += stagingSize;
+    }
+
+    if (!Texture2DGlobal::isRecordingBatch || Texture2DGlobal::pendingStagingSize > Texture2DGlobal::maxBatchStagingSize)
+    {
+        SubmitUploads( waitForGPU );
+    }
+}
+
+// Ends an upload that was begun with BeginTextureUpload(). The staging buffer is released when the upload has been submitted,
+// which is now unless a batch is recording.
+void EndTextureUpload( VkBuffer stagingBuffer, VkDeviceMemory stagingMemory, VkDeviceSize stagingSize )
+{
+    EndUpload( stagingBuffer, stagingMemory, stagingSize, true );
+}
+
+// Submits a recording batch and waits for texCmdBuffer so that it can be used for something else.
+void FlushTextureUploads()
+{
+    if (Texture2DGlobal::isRecordingBatch)
+    {
+        SubmitUploads( true );
+    }
+
+    WaitForUploads();
+}
+
+void ae3d::Texture2D::BeginUploadBatch()
+{
+    Texture2DGlobal::isBatchingUploads = true;
+}
+
+void ae3d::Texture2D::EndUploadBatch()
+{
+    FlushTextureUploads();
+    Texture2DGlobal::isBatchingUploads = false;
+}
+
+static VkSampler CreateSampler( ae3d::TextureFilter filter, ae3d::TextureWrap wrap, ae3d::Anisotropy anisotropy, int mipLevelCount )
+{
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = filter == ae3d::TextureFilter::Nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+    samplerInfo.minFilter = samplerInfo.magFilter;
+    samplerInfo.mipmapMode = filter == ae3d::TextureFilter::Nearest ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = wrap == ae3d::TextureWrap::Repeat ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = samplerInfo.addressModeU;
+    samplerInfo.addressModeW = samplerInfo.addressModeU;
+    samplerInfo.mipLodBias = 0;
+    samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+    samplerInfo.minLod = 0;
+    samplerInfo.maxLod = static_cast< float >(mipLevelCount);
+    samplerInfo.maxAnisotropy = GfxDeviceGlobal::deviceFeatures.samplerAnisotropy ? GetFloatAnisotropy( anisotropy ) : 1;
+    samplerInfo.anisotropyEnable = (anisotropy != ae3d::Anisotropy::k1 && GfxDeviceGlobal::deviceFeatures.samplerAnisotropy) ? VK_TRUE : VK_FALSE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkResult err = vkCreateSampler( GfxDeviceGlobal::device, &samplerInfo, nullptr, &sampler );
+    AE3D_CHECK_VULKAN( err, "vkCreateSampler" );
+    Texture2DGlobal::samplersToReleaseAtExit.push_back( sampler );
+
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)sampler, VK_OBJECT_TYPE_SAMPLER, "sampler" );
+    return sampler;
+}
+
+// CompressTexture stores grayscale images as BC4, so its red channel is also sampled as green and blue.
+static VkComponentMapping GetDDSComponents( VkFormat format )
+{
+    if (format == VK_FORMAT_BC4_UNORM_BLOCK || format == VK_FORMAT_BC4_SNORM_BLOCK)
+    {
+        return { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+    }
+
+    return { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+}
+
+// Replaces a streamed texture's image with one whose mip level 0 is newResidentMip. The first uploadCount levels are uploaded from levelData,
+// where they are contiguous, and the rest are copied from the old image on the GPU. Without uploads this evicts levels.
+static void ResizeStreamedImage( Texture2DGlobal::StreamedImage& streamed, int newResidentMip, const unsigned char* levelData, int uploadCount )
+{
+    const int mipCount = (int)streamed.mipSizes.size();
+    const int levelCount = mipCount - newResidentMip;
+    const int mipWidth = MathUtil::Max( streamed.width >> newResidentMip, 1 );
+    const int mipHeight = MathUtil::Max( streamed.height >> newResidentMip, 1 );
+
+    VkImageCreateInfo imageCreateInfo = {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = streamed.format;
+    imageCreateInfo.mipLevels = levelCount;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.extent = { (std::uint32_t)mipWidth, (std::uint32_t)mipHeight, 1 };
+    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    VkImage image = VK_NULL_HANDLE;
+    VkResult err = vkCreateImage( GfxDeviceGlobal::device, &imageCreateInfo, nullptr, &image );
+    AE3D_CHECK_VULKAN( err, "vkCreateImage" );
+    Texture2DGlobal::imagesToReleaseAtExit.push_back( image );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)image, VK_OBJECT_TYPE_IMAGE, streamed.path.c_str() );
+
+    VkMemoryRequirements memReqs = {};
+    vkGetImageMemoryRequirements( GfxDeviceGlobal::device, image, &memReqs );
+    const VkDeviceSize imageSize = memReqs.size;
+
+    VkMemoryAllocateInfo memAllocInfo = {};
+    memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memAllocInfo.allocationSize = memReqs.size;
+    memAllocInfo.memoryTypeIndex = ae3d::GetMemoryType( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    err = vkAllocateMemory( GfxDeviceGlobal::device, &memAllocInfo, nullptr, &memory );
+    AE3D_CHECK_VULKAN( err, "vkAllocateMemory" );
+    Statistics::IncAllocCalls();
+    Statistics::IncTotalAllocCalls();
+    Texture2DGlobal::memoryToReleaseAtExit.push_back( memory );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)memory, VK_OBJECT_TYPE_DEVICE_MEMORY, "tex2d streamed memory" );
+
+    err = vkBindImageMemory( GfxDeviceGlobal::device, image, memory, 0 );
+    AE3D_CHECK_VULKAN( err, "vkBindImageMemory" );
+
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    VkDeviceSize stagingSize = 0;
+
+    for (int level = 0; level < uploadCount; ++level)
+    {
+        stagingSize += streamed.mipSizes[ newResidentMip + level ];
+    }
+
+    if (uploadCount > 0)
+    {
+        VkBufferCreateInfo bufferCreateInfo = {};
+        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size = stagingSize;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        err = vkCreateBuffer( GfxDeviceGlobal::device, &bufferCreateInfo, nullptr, &stagingBuffer );
+        AE3D_CHECK_VULKAN( err, "vkCreateBuffer staging" );
+        debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)stagingBuffer, VK_OBJECT_TYPE_BUFFER, "stagingStreamed2D" );
+
+        vkGetBufferMemoryRequirements( GfxDeviceGlobal::device, stagingBuffer, &memReqs );
+
+        memAllocInfo.allocationSize = memReqs.size;
+        memAllocInfo.memoryTypeIndex = ae3d::GetMemoryType( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+        err = vkAllocateMemory( GfxDeviceGlobal::device, &memAllocInfo, nullptr, &stagingMemory );
+        AE3D_CHECK_VULKAN( err, "vkAllocateMemory" );
+
+        err = vkBindBufferMemory( GfxDeviceGlobal::device, stagingBuffer, stagingMemory, 0 );
+        AE3D_CHECK_VULKAN( err, "vkBindBufferMemory staging" );
+
+        void* stagingData;
+        err = vkMapMemory( GfxDeviceGlobal::device, stagingMemory, 0, memReqs.size, 0, &stagingData );
+        AE3D_CHECK_VULKAN( err, "vkMapMemory in Texture2D" );
+
+        std::memcpy( stagingData, levelData, stagingSize );
+
+        VkMappedMemoryRange flushRange = {};
+        flushRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        flushRange.memory = stagingMemory;
+        flushRange.offset = 0;
+        flushRange.size = VK_WHOLE_SIZE;
+        vkFlushMappedMemoryRanges( GfxDeviceGlobal::device, 1, &flushRange );
+
+        vkUnmapMemory( GfxDeviceGlobal::device, stagingMemory );
+    }
+
+    BeginTextureUpload();
+
+    VkImageMemoryBarrier barriers[ 2 ] = {};
+    barriers[ 0 ].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barriers[ 0 ].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[ 0 ].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barriers[ 0 ].srcAccessMask = 0;
+    barriers[ 0 ].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[ 0 ].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[ 0 ].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[ 0 ].image = image;
+    barriers[ 0 ].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, (std::uint32_t)levelCount, 0, 1 };
+
+    const bool hasOldImage = streamed.image != VK_NULL_HANDLE;
+    barriers[ 1 ] = barriers[ 0 ];
+    barriers[ 1 ].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[ 1 ].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[ 1 ].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[ 1 ].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[ 1 ].image = streamed.image;
+    barriers[ 1 ].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, (std::uint32_t)(mipCount - streamed.residentMip), 0, 1 };
+
+    vkCmdPipelineBarrier( GfxDeviceGlobal::texCmdBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                          hasOldImage ? 2 : 1, barriers );
+
+    if (uploadCount > 0)
+    {
+        Array< VkBufferImageCopy > bufferCopyRegions( uploadCount );
+        VkDeviceSize bufferOffset = 0;
+
+        for (int level = 0; level < uploadCount; ++level)
+        {
+            VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[ level ];
+            bufferCopyRegion = {};
+            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            bufferCopyRegion.imageSubresource.mipLevel = level;
+            bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+            bufferCopyRegion.imageSubresource.layerCount = 1;
+            bufferCopyRegion.imageExtent.width = MathUtil::Max( mipWidth >> level, 1 );
+            bufferCopyRegion.imageExtent.height = MathUtil::Max( mipHeight >> level, 1 );
+            bufferCopyRegion.imageExtent.depth = 1;
+            bufferCopyRegion.bufferOffset = bufferOffset;
+            bufferOffset += streamed.mipSizes[ newResidentMip + level ];
+        }
+
+        vkCmdCopyBufferToImage( GfxDeviceGlobal::texCmdBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, bufferCopyRegions.count, &bufferCopyRegions[ 0 ] );
+    }
+
+    if (hasOldImage && uploadCount < levelCount)
+    {
+        Array< VkImageCopy > imageCopyRegions( levelCount - uploadCount );
+
+        for (int level = uploadCount; level < levelCount; ++level)
+        {
+            VkImageCopy& imageCopyRegion = imageCopyRegions[ level - uploadCount ];
+            imageCopyRegion = {};
+            imageCopyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, (std::uint32_t)(newResidentMip + level - streamed.residentMip), 0, 1 };
+            imageCopyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, (std::uint32_t)level, 0, 1 };
+            imageCopyRegion.extent.width = MathUtil::Max( mipWidth >> level, 1 );
+            imageCopyRegion.extent.height = MathUtil::Max( mipHeight >> level, 1 );
+            imageCopyRegion.extent.depth = 1;
+        }
+
+        vkCmdCopyImage( GfxDeviceGlobal::texCmdBuffer, streamed.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        imageCopyRegions.count, &imageCopyRegions[ 0 ] );
+    }
+
+    barriers[ 0 ].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[ 0 ].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[ 0 ].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[ 0 ].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    vkCmdPipelineBarrier( GfxDeviceGlobal::texCmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, barriers );
+
+    // Frames that use the new image are submitted to the same queue after the copy, so it's not waited for.
+    EndUpload( stagingBuffer, stagingMemory, stagingSize, false );
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = streamed.format;
+    viewInfo.components = GetDDSComponents( streamed.format );
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, (std::uint32_t)levelCount, 0, 1 };
+    viewInfo.image = image;
+
+    VkImageView view = VK_NULL_HANDLE;
+    err = vkCreateImageView( GfxDeviceGlobal::device, &viewInfo, nullptr, &view );
+    AE3D_CHECK_VULKAN( err, "vkCreateImageView in Texture2D" );
+    Texture2DGlobal::imageViewsToReleaseAtExit.push_back( view );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)view, VK_OBJECT_TYPE_IMAGE_VIEW, streamed.path.c_str() );
+
+    // Frames that are still in flight can sample the old image.
+    if (hasOldImage)
+    {
+        DestroyTextureObjects( streamed.image, streamed.view, streamed.memory, VK_NULL_HANDLE );
+    }
+
+    streamed.image = image;
+    streamed.view = view;
+    streamed.memory = memory;
+    streamed.residentMip = newResidentMip;
+    ae3d::AssetRegistry::SetSize( streamed.assetHandle, static_cast< std::size_t >( imageSize ) );
+}
+
+// Destroys a streamed texture's current image when the GPU has finished using it and stops streaming it.
+static void ReleaseStreamedImage( ae3d::TextureStreamer::Handle handle, VkSampler sampler )
+{
+    const auto it = Texture2DGlobal::streamedImages.find( handle.index );
+
+    if (it != std::end( Texture2DGlobal::streamedImages ))
+    {
+        DestroyTextureObjects( it->second->image, it->second->view, it->second->memory, sampler );
+        Texture2DGlobal::streamedImages.erase( it );
+    }
+
+    ae3d::TextureStreamer::Unregister( handle );
+}
+
+static Texture2DGlobal::StreamedImage* GetStreamedImage( ae3d::TextureStreamer::Handle handle )
+{
+    if (!ae3d::TextureStreamer::IsValid( handle ))
+    {
+        return nullptr;
+    }
+
+    const auto it = Texture2DGlobal::streamedImages.find( handle.index );
+    return it != std::end( Texture2DGlobal::streamedImages ) ? it->second.get() : nullptr;
+}
+
+VkImageView& ae3d::Texture2D::GetView()
+{
+    Texture2DGlobal::StreamedImage* streamed = GetStreamedImage( streamHandle );
+    return streamed != nullptr ? streamed->view : view;
+}
+
+VkImage& ae3d::Texture2D::GetImage()
+{
+    Texture2DGlobal::StreamedImage* streamed = GetStreamedImage( streamHandle );
+    return streamed != nullptr ? streamed->image : image;
 }
 
 void ae3d::Texture2D::LoadFromData( const void* imageData, int aWidth, int aHeight, int channels, const char* debugName, VkImageUsageFlags usageFlags )
@@ -76,13 +558,13 @@ void ae3d::Texture2D::LoadFromData( const void* imageData, int aWidth, int aHeig
     filter = TextureFilter::Linear;
     opaque = channels == 3;
 
-    CreateVulkanObjects( const_cast< void* >( imageData ), 4, colorSpace == ColorSpace::Linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB, usageFlags );
+    CreateVulkanObjects( const_cast< void* >( imageData ), 4, colorSpace == ColorSpace::Linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB, usageFlags, nullptr );
 
     debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)view, VK_OBJECT_TYPE_IMAGE_VIEW, debugName );
     debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)image, VK_OBJECT_TYPE_IMAGE, debugName );
 }
 
-void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
+void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, DecodedImage* decoded, TextureWrap aWrap, TextureFilter aFilter, Mipmaps aMipmaps, ColorSpace aColorSpace, Anisotropy aAnisotropy )
 {
     filter = aFilter;
     wrap = aWrap;
@@ -101,39 +583,134 @@ void ae3d::Texture2D::Load( const FileSystem::FileContentsData& fileContents, Te
         anisotropy = Anisotropy::k4;
     }
 
+    const AssetRegistry::Handle oldAssetHandle = assetHandle;
+
     if (!fileContents.isLoaded)
     {
         *this = Texture2DGlobal::defaultTexture;
+        AssetRegistry::Release( oldAssetHandle );
+        return;
+    }
+
+    const TextureCacheKey cacheKey = GetCacheKey( fileContents.path, wrap, filter, mipmaps, colorSpace, anisotropy );
+    const Texture2D* cachedTexture = FindCachedTexture( cacheKey, fileContents.path );
+
+    // TexReload() loads the cached texture itself.
+    const bool isReload = cachedTexture == this;
+
+    // The cached texture can have been evicted.
+    if (cachedTexture != nullptr && !isReload && !AssetRegistry::IsValid( cachedTexture->assetHandle ))
+    {
+        EraseCachedTexture( cacheKey );
+        cachedTexture = nullptr;
+    }
+
+    if (cachedTexture != nullptr && !isReload)
+    {
+        *this = *cachedTexture;
+        AssetRegistry::AddRef( assetHandle );
+        AssetRegistry::Release( oldAssetHandle );
         return;
     }
 
+    // Objects of the old image are kept if loading fails.
+    const VkImage oldImage = image;
+    const VkImageView oldView = view;
+    const VkDeviceMemory oldMemory = deviceMemory;
+    const VkSampler oldSampler = sampler;
+    const TextureStreamer::Handle oldStreamHandle = streamHandle;
+    image = VK_NULL_HANDLE;
+    view = VK_NULL_HANDLE;
+    deviceMemory = VK_NULL_HANDLE;
+    sampler = VK_NULL_HANDLE;
+    streamHandle = TextureStreamer::Handle();
+
     const bool isDDS = fileContents.path.find( ".dds" ) != std::string::npos || fileContents.path.find( ".DDS" ) != std::string::npos;
 
     if (HasStbExtension( fileContents.path ))
     {
-        LoadSTB( fileContents );
+        LoadSTB( fileContents, decoded );
     }
     else if (isDDS && GfxDeviceGlobal::deviceFeatures.textureCompressionBC)
     {
-        LoadDDS( fileContents.path.c_str() );
+        LoadDDS( fileContents, decoded );
     }
     else
     {
         System::Print( "Unknown/unsupported texture file extension: %s\n", fileContents.path.c_str() );
     }
 
+    if (view == VK_NULL_HANDLE)
+    {
+        image = oldImage;
+        view = oldView;
+        deviceMemory = oldMemory;
+        sampler = oldSampler;
+        streamHandle = oldStreamHandle;
+        return;
+    }
+
     debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)view, VK_OBJECT_TYPE_IMAGE_VIEW, fileContents.path.c_str() );
     debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)image, VK_OBJECT_TYPE_IMAGE, fileContents.path.c_str() );
+
+    VkMemoryRequirements memReqs = {};
+    vkGetImageMemoryRequirements( GfxDeviceGlobal::device, image, &memReqs );
+
+    if (isReload)
+    {
+        // Copies of the texture still use the old image, which is released on eviction. The new image is destroyed at exit.
+        AssetRegistry::SetSize( assetHandle, static_cast< std::size_t >( memReqs.size ) );
+
+        if (streamHandle.generation != 0)
+        {
+            Texture2DGlobal::streamedImages[ streamHandle.index ]->assetHandle = assetHandle;
+        }
+
+        return;
+    }
+
+    const VkImage releasedImage = image;
+    const VkImageView releasedView = view;
+    const VkDeviceMemory releasedMemory = deviceMemory;
+    const VkSampler releasedSampler = sampler;
+    const TextureStreamer::Handle releasedStreamHandle = streamHandle;
+
+    // Settings are in the key so the same file with other settings is another asset.
+    const std::string assetKey = fileContents.path + "#" + std::to_string( cacheKey.value & 0xFF );
+    assetHandle = AssetRegistry::Register( AssetRegistry::Category::Texture, assetKey, static_cast< std::size_t >( memReqs.size ),
+        [releasedImage, releasedView, releasedMemory, releasedSampler, releasedStreamHandle]()
+        {
+            // A streamed texture's image has been replaced if its resident mip levels have changed.
+            if (releasedStreamHandle.generation != 0)
+            {
+                ReleaseStreamedImage( releasedStreamHandle, releasedSampler );
+            }
+            else
+            {
+                DestroyTextureObjects( releasedImage, releasedView, releasedMemory, releasedSampler );
+            }
+        } );
+
+    if (streamHandle.generation != 0)
+    {
+        Texture2DGlobal::streamedImages[ streamHandle.index ]->assetHandle = assetHandle;
+    }
+
+    CacheTexture( cacheKey, *this );
+    AssetRegistry::Release( oldAssetHandle );
+    fileWatcher.AddFile( fileContents.path, TexReload );
 }
 
 void ae3d::Texture2D::CreateVulkanObjects( const DDSLoader::Output& mipChain, VkFormat format )
 {
+    const int layerCount = mipChain.layerCount;
+
     VkImageCreateInfo imageCreateInfo = {};
     imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
     imageCreateInfo.format = format;
     imageCreateInfo.mipLevels = mipLevelCount;
-    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.arrayLayers = layerCount;
     imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -163,93 +740,72 @@ void ae3d::Texture2D::CreateVulkanObjects( const DDSLoader::Output& mipChain, Vk
     err = vkBindImageMemory( GfxDeviceGlobal::device, image, deviceMemory, 0 );
     AE3D_CHECK_VULKAN( err, "vkBindImageMemory" );
 
-    Array< VkBuffer > stagingBuffers( mipLevelCount );
-    Array< VkDeviceMemory > stagingMemory( mipLevelCount );
-    
-    for (int mipIndex = 0; mipIndex < mipLevelCount; ++mipIndex)
-    {
-        const std::int32_t mipWidth = MathUtil::Max( width >> mipIndex, 1 );
-        const std::int32_t mipHeight = MathUtil::Max( height >> mipIndex, 1 );
+    // Layers and their mip levels are contiguous in the file, so they are staged with one copy from the file's memory.
+    // Levels that are not used, because mipmaps are off, are staged but not copied into the image.
+    const int lastIndex = (layerCount - 1) * mipChain.mipCount + mipLevelCount - 1;
+    const std::size_t firstOffset = mipChain.dataOffsets[ 0 ];
+    const VkDeviceSize stagingSize = mipChain.dataOffsets[ lastIndex ] + DDSLoader::GetMipSize( mipChain.format, width, height, mipLevelCount - 1 ) - firstOffset;
 
-        const VkDeviceSize bc1BlockSize = opaque ? 8 : 16;
-        VkDeviceSize imageSize = (mipWidth / 4) * (mipHeight / 4) * (format == VK_FORMAT_BC5_UNORM_BLOCK ? 16 : bc1BlockSize);
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = stagingSize;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    err = vkCreateBuffer( GfxDeviceGlobal::device, &bufferCreateInfo, nullptr, &stagingBuffer );
+    AE3D_CHECK_VULKAN( err, "vkCreateBuffer staging" );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)stagingBuffer, VK_OBJECT_TYPE_BUFFER, "stagingBuffer2D" );
 
-        // FIXME: This is a hack, figure out proper fix.
-        if (imageSize == 0)
-        {
-            imageSize = 16;
-        }
-        
-        VkBufferCreateInfo bufferCreateInfo = {};
-        bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferCreateInfo.size = imageSize;
-        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        err = vkCreateBuffer( GfxDeviceGlobal::device, &bufferCreateInfo, nullptr, &stagingBuffers[ mipIndex ] );
-        AE3D_CHECK_VULKAN( err, "vkCreateBuffer staging" );
-        debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)stagingBuffers[ mipIndex ], VK_OBJECT_TYPE_BUFFER, "stagingBuffer2D" );
+    vkGetBufferMemoryRequirements( GfxDeviceGlobal::device, stagingBuffer, &memReqs );
 
-        vkGetBufferMemoryRequirements( GfxDeviceGlobal::device, stagingBuffers[ mipIndex ], &memReqs );
+    memAllocInfo.allocationSize = memReqs.size;
+    memAllocInfo.memoryTypeIndex = GetMemoryType( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
 
-        memAllocInfo.allocationSize = memReqs.size;
-        memAllocInfo.memoryTypeIndex = GetMemoryType( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    err = vkAllocateMemory( GfxDeviceGlobal::device, &memAllocInfo, nullptr, &stagingMemory );
+    AE3D_CHECK_VULKAN( err, "vkAllocateMemory" );
 
-		err = vkAllocateMemory( GfxDeviceGlobal::device, &memAllocInfo, nullptr, &stagingMemory[ mipIndex ] );
-		AE3D_CHECK_VULKAN( err, "vkAllocateMemory" );
-		debug::SetObjectName( GfxDeviceGlobal::device, ( std::uint64_t )deviceMemory, VK_OBJECT_TYPE_DEVICE_MEMORY, "tex2d memory" );
+    err = vkBindBufferMemory( GfxDeviceGlobal::device, stagingBuffer, stagingMemory, 0 );
+    AE3D_CHECK_VULKAN( err, "vkBindBufferMemory staging" );
 
-        err = vkBindBufferMemory( GfxDeviceGlobal::device, stagingBuffers[ mipIndex ], stagingMemory[ mipIndex ], 0 );
-        AE3D_CHECK_VULKAN( err, "vkBindBufferMemory staging" );
+    void* stagingData;
+    err = vkMapMemory( GfxDeviceGlobal::device, stagingMemory, 0, memReqs.size, 0, &stagingData );
+    AE3D_CHECK_VULKAN( err, "vkMapMemory in Texture2D" );
 
-        void* stagingData;
-        err = vkMapMemory( GfxDeviceGlobal::device, stagingMemory[ mipIndex ], 0, memReqs.size, 0, &stagingData );
-        AE3D_CHECK_VULKAN( err, "vkMapMemory in Texture2D" );
-        VkDeviceSize amountToCopy = imageSize;
-        if (mipChain.dataOffsets[ mipIndex ] + imageSize >= (unsigned)mipChain.imageData.count)
-        {
-            amountToCopy = mipChain.imageData.count - mipChain.dataOffsets[ mipIndex ];
-        }
-        
-        std::memcpy( stagingData, &mipChain.imageData[ mipChain.dataOffsets[ mipIndex ] ], amountToCopy );
+    std::memcpy( stagingData, mipChain.data + firstOffset, stagingSize );
 
-        VkMappedMemoryRange flushRange = {};
-        flushRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        flushRange.memory = stagingMemory[ mipIndex ];
-        flushRange.offset = 0;
-        flushRange.size = VK_WHOLE_SIZE;
-        vkFlushMappedMemoryRanges( GfxDeviceGlobal::device, 1, &flushRange );
+    VkMappedMemoryRange flushRange = {};
+    flushRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    flushRange.memory = stagingMemory;
+    flushRange.offset = 0;
+    flushRange.size = VK_WHOLE_SIZE;
+    vkFlushMappedMemoryRanges( GfxDeviceGlobal::device, 1, &flushRange );
 
-        vkUnmapMemory( GfxDeviceGlobal::device, stagingMemory[ mipIndex ] );
-    }
+    vkUnmapMemory( GfxDeviceGlobal::device, stagingMemory );
 
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = format;
-    viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+    viewInfo.components = GetDDSComponents( format );
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layerCount;
     viewInfo.subresourceRange.levelCount = mipLevelCount;
     viewInfo.image = image;
     err = vkCreateImageView( GfxDeviceGlobal::device, &viewInfo, nullptr, &view );
     AE3D_CHECK_VULKAN( err, "vkCreateImageView in Texture2D" );
     Texture2DGlobal::imageViewsToReleaseAtExit.push_back( view );
 
-    VkCommandBufferBeginInfo cmdBufInfo = {};
-    cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    cmdBufInfo.flags = 0;
-
-    err = vkBeginCommandBuffer( GfxDeviceGlobal::texCmdBuffer, &cmdBufInfo );
-    AE3D_CHECK_VULKAN( err, "vkBeginCommandBuffer in Texture2D" );
+    BeginTextureUpload();
 
     VkImageSubresourceRange range = {};
     range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     range.baseMipLevel = 0;
     range.levelCount = mipLevelCount;
     range.baseArrayLayer = 0;
-    range.layerCount = 1;
+    range.layerCount = layerCount;
 
     VkImageMemoryBarrier imageMemoryBarrier = {};
     imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -271,47 +827,30 @@ void ae3d::Texture2D::CreateVulkanObjects( const DDSLoader::Output& mipChain, Vk
             0, nullptr,
             1, &imageMemoryBarrier );
 
-    for (int mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
-    {
-        const std::int32_t mipWidth = MathUtil::Max( width >> mipLevel, 1 );
-        const std::int32_t mipHeight = MathUtil::Max( height >> mipLevel, 1 );
+    Array< VkBufferImageCopy > bufferCopyRegions( layerCount * mipLevelCount );
 
-        VkBufferImageCopy bufferCopyRegion = {};
-        bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        bufferCopyRegion.imageSubresource.mipLevel = mipLevel;
-        bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-        bufferCopyRegion.imageSubresource.layerCount = 1;
-        bufferCopyRegion.imageExtent.width = mipWidth;
-        bufferCopyRegion.imageExtent.height = mipHeight;
-        bufferCopyRegion.imageExtent.depth = 1;
-        bufferCopyRegion.bufferOffset = 0;
-
-        vkCmdCopyBufferToImage( GfxDeviceGlobal::texCmdBuffer, stagingBuffers[ mipLevel ], image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion );
+    for (int layer = 0; layer < layerCount; ++layer)
+    {
+        for (int mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
+        {
+            VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[ layer * mipLevelCount + mipLevel ];
+            bufferCopyRegion = {};
+            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            bufferCopyRegion.imageSubresource.mipLevel = mipLevel;
+            bufferCopyRegion.imageSubresource.baseArrayLayer = layer;
+            bufferCopyRegion.imageSubresource.layerCount = 1;
+            bufferCopyRegion.imageExtent.width = MathUtil::Max( width >> mipLevel, 1 );
+            bufferCopyRegion.imageExtent.height = MathUtil::Max( height >> mipLevel, 1 );
+            bufferCopyRegion.imageExtent.depth = 1;
+            bufferCopyRegion.bufferOffset = mipChain.dataOffsets[ layer * mipChain.mipCount + mipLevel ] - firstOffset;
+        }
     }
 
-    imageMemoryBarrier = {};
-    imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imageMemoryBarrier.srcAccessMask = 0;
-    imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    imageMemoryBarrier.image = image;
-    imageMemoryBarrier.subresourceRange = range;
-    
-    vkCmdPipelineBarrier(
-        GfxDeviceGlobal::texCmdBuffer,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &imageMemoryBarrier );
+    vkCmdCopyBufferToImage( GfxDeviceGlobal::texCmdBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, bufferCopyRegions.count, &bufferCopyRegions[ 0 ] );
 
     imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
     vkCmdPipelineBarrier(
@@ -323,44 +862,11 @@ void ae3d::Texture2D::CreateVulkanObjects( const DDSLoader::Output& mipChain, Vk
             0, nullptr,
             1, &imageMemoryBarrier );
 
-    vkEndCommandBuffer( GfxDeviceGlobal::texCmdBuffer );
-
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &GfxDeviceGlobal::texCmdBuffer;
-
-    err = vkQueueSubmit( GfxDeviceGlobal::graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE );
-    AE3D_CHECK_VULKAN( err, "vkQueueSubmit in Texture2D" );
-
-    vkDeviceWaitIdle( GfxDeviceGlobal::device );
+    layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    for (int mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
-    {
-        vkDestroyBuffer( GfxDeviceGlobal::device, stagingBuffers[ mipLevel ], nullptr );
-        vkFreeMemory( GfxDeviceGlobal::device, stagingMemory[ mipLevel ], nullptr );
-    }
-    
-    VkSamplerCreateInfo samplerInfo = {};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = filter == ae3d::TextureFilter::Nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
-    samplerInfo.minFilter = samplerInfo.magFilter;
-    samplerInfo.mipmapMode = filter == ae3d::TextureFilter::Nearest ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.addressModeU = wrap == ae3d::TextureWrap::Repeat ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeV = samplerInfo.addressModeU;
-    samplerInfo.addressModeW = samplerInfo.addressModeU;
-    samplerInfo.mipLodBias = 0;
-    samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-    samplerInfo.minLod = 0;
-    samplerInfo.maxLod = static_cast< float >(mipLevelCount);
-    samplerInfo.maxAnisotropy = GfxDeviceGlobal::deviceFeatures.samplerAnisotropy ? GetFloatAnisotropy( anisotropy ) : 1;
-    samplerInfo.anisotropyEnable = (anisotropy != Anisotropy::k1 && GfxDeviceGlobal::deviceFeatures.samplerAnisotropy) ? VK_TRUE : VK_FALSE;
-    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
-    err = vkCreateSampler( GfxDeviceGlobal::device, &samplerInfo, nullptr, &sampler );
-    AE3D_CHECK_VULKAN( err, "vkCreateSampler" );
-    Texture2DGlobal::samplersToReleaseAtExit.push_back( sampler );
+    EndTextureUpload( stagingBuffer, stagingMemory, stagingSize );
 
-    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)sampler, VK_OBJECT_TYPE_SAMPLER, "sampler" );
+    sampler = CreateSampler( filter, wrap, anisotropy, mipLevelCount );
 }
 
 void ae3d::Texture2D::CreateUAV( int aWidth, int aHeight, const char* debugName )
@@ -370,6 +876,8 @@ void ae3d::Texture2D::CreateUAV( int aWidth, int aHeight, const char* debugName
 
 void ae3d::Texture2D::SetLayout( TextureLayout aLayout )
 {
+    FlushTextureUploads();
+
     VkCommandBufferBeginInfo cmdBufInfo = {};
     cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     cmdBufInfo.pInheritanceInfo = nullptr;
@@ -397,19 +905,77 @@ void ae3d::Texture2D::SetLayout( TextureLayout aLayout )
     vkDeviceWaitIdle( GfxDeviceGlobal::device );
 }
 
-void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkFormat format, VkImageUsageFlags usageFlags )
+// Returns an R8 or R8G8 format for images stored with fewer channels, or VK_FORMAT_UNDEFINED if the device can't filter it.
+static VkFormat GetReducedFormat( int channelCount, ae3d::ColorSpace colorSpace )
 {
-    if (!MathUtil::IsPowerOfTwo( width ) || !MathUtil::IsPowerOfTwo( height ))
+    if (channelCount > 2)
     {
-        if (mipmaps == Mipmaps::Generate)
-        {
-            System::Print( "Mipmaps not generated for %s because the dimension (%dx%d) is not power-of-two.\n", path.c_str(), width, height );
-        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    const bool isLinear = colorSpace == ae3d::ColorSpace::Linear;
+    const VkFormat format = channelCount == 1 ? (isLinear ? VK_FORMAT_R8_UNORM : VK_FORMAT_R8_SRGB) : (isLinear ? VK_FORMAT_R8G8_UNORM : VK_FORMAT_R8G8_SRGB);
+
+    // Support for the sRGB formats is optional.
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties( GfxDeviceGlobal::physicalDevice, format, &formatProperties );
+    const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    return (formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures ? format : VK_FORMAT_UNDEFINED;
+}
+
+static VkComponentSwizzle GetComponentSwizzle( ae3d::TextureChannels::Swizzle swizzle )
+{
+    switch (swizzle)
+    {
+    case ae3d::TextureChannels::Swizzle::R: return VK_COMPONENT_SWIZZLE_R;
+    case ae3d::TextureChannels::Swizzle::G: return VK_COMPONENT_SWIZZLE_G;
+    case ae3d::TextureChannels::Swizzle::B: return VK_COMPONENT_SWIZZLE_B;
+    case ae3d::TextureChannels::Swizzle::A: return VK_COMPONENT_SWIZZLE_A;
+    case ae3d::TextureChannels::Swizzle::Zero: return VK_COMPONENT_SWIZZLE_ZERO;
+    case ae3d::TextureChannels::Swizzle::One: return VK_COMPONENT_SWIZZLE_ONE;
+    }
+
+    return VK_COMPONENT_SWIZZLE_IDENTITY;
+}
+
+void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkFormat format, VkImageUsageFlags usageFlags, DecodedImage* decoded )
+{
+    // Mipmaps are generated on the CPU, so they are filtered in linear space and non-power-of-two textures get them too.
+    std::vector< unsigned char > mipChain;
 
+    if (mipmaps == Mipmaps::Generate && data != nullptr && bytesPerPixel == 4)
+    {
+        GenerateMipChain( static_cast< const unsigned char* >( data ), width, height, wrap, colorSpace, decoded, mipChain );
+    }
+    else
+    {
         mipmaps = Mipmaps::None;
     }
 
-    mipLevelCount = mipmaps == Mipmaps::Generate ? MathUtil::GetMipmapCount( width, height ) : 1;
+    mipLevelCount = mipmaps == Mipmaps::Generate ? MipGenerator::GetMipCount( width, height ) : 1;
+
+    // Images whose channels are duplicates or constants, like roughness masks and normal maps, are stored as R8 or R8G8
+    // and the view's swizzle rebuilds RGBA. Storage images are written by shaders, so they keep all channels.
+    TextureChannels::Layout channelLayout;
+    std::vector< unsigned char > packedPixels;
+
+    if (data != nullptr && bytesPerPixel == 4 && (usageFlags & VK_IMAGE_USAGE_STORAGE_BIT) == 0)
+    {
+        const unsigned char* pixels = mipChain.empty() ? static_cast< const unsigned char* >( data ) : mipChain.data();
+        const std::size_t pixelCount = mipChain.empty() ? (std::size_t)width * height : mipChain.size() / 4;
+        const TextureChannels::Layout analyzedLayout = TextureChannels::Analyze( pixels, (std::size_t)width * height, colorSpace == ColorSpace::SRGB );
+        const VkFormat reducedFormat = GetReducedFormat( analyzedLayout.channelCount, colorSpace );
+
+        if (reducedFormat != VK_FORMAT_UNDEFINED)
+        {
+            channelLayout = analyzedLayout;
+            packedPixels.resize( pixelCount * channelLayout.channelCount );
+            TextureChannels::Pack( pixels, pixelCount, channelLayout, packedPixels.data() );
+            bytesPerPixel = channelLayout.channelCount;
+            format = reducedFormat;
+        }
+    }
 
     VkImageCreateInfo imageCreateInfo = {};
     imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -448,7 +1014,7 @@ void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkForm
 
     VkBuffer stagingBuffer = VK_NULL_HANDLE;
 
-    VkDeviceSize imageSize = width * height * bytesPerPixel;
+    const VkDeviceSize imageSize = !packedPixels.empty() ? packedPixels.size() : (mipChain.empty() ? width * height * bytesPerPixel : mipChain.size());
 
     VkBufferCreateInfo bufferCreateInfo = {};
     bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -474,7 +1040,15 @@ void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkForm
     err = vkMapMemory( GfxDeviceGlobal::device, stagingMemory, 0, memReqs.size, 0, &stagingData );
     AE3D_CHECK_VULKAN( err, "vkMapMemory in Texture2D" );
     
-    if (data)
+    if (!packedPixels.empty())
+    {
+        std::memcpy( stagingData, packedPixels.data(), imageSize );
+    }
+    else if (!mipChain.empty())
+    {
+        std::memcpy( stagingData, mipChain.data(), imageSize );
+    }
+    else if (data)
     {
         std::memcpy( stagingData, data, imageSize );
     }
@@ -492,7 +1066,8 @@ void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkForm
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = format;
-    viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+    viewInfo.components = { GetComponentSwizzle( channelLayout.swizzle[ 0 ] ), GetComponentSwizzle( channelLayout.swizzle[ 1 ] ),
+                            GetComponentSwizzle( channelLayout.swizzle[ 2 ] ), GetComponentSwizzle( channelLayout.swizzle[ 3 ] ) };
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.baseArrayLayer = 0;
@@ -503,13 +1078,7 @@ void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkForm
     AE3D_CHECK_VULKAN( err, "vkCreateImageView in Texture2D" );
     Texture2DGlobal::imageViewsToReleaseAtExit.push_back( view );
 
-    VkCommandBufferBeginInfo cmdBufInfo = {};
-    cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    cmdBufInfo.pInheritanceInfo = nullptr;
-    cmdBufInfo.flags = 0;
-
-    err = vkBeginCommandBuffer( GfxDeviceGlobal::texCmdBuffer, &cmdBufInfo );
-    AE3D_CHECK_VULKAN( err, "vkBeginCommandBuffer in Texture2D" );
+    BeginTextureUpload();
 
     VkImageSubresourceRange range = {};
     range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -538,85 +1107,28 @@ void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkForm
             0, nullptr,
             1, &imageMemoryBarrier );
 
-    VkBufferImageCopy bufferCopyRegion = {};
-    bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    bufferCopyRegion.imageSubresource.mipLevel = 0;
-    bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-    bufferCopyRegion.imageSubresource.layerCount = 1;
-    bufferCopyRegion.imageExtent.width = width;
-    bufferCopyRegion.imageExtent.height = height;
-    bufferCopyRegion.imageExtent.depth = 1;
-    bufferCopyRegion.bufferOffset = 0;
+    Array< VkBufferImageCopy > bufferCopyRegions( mipLevelCount );
 
-    vkCmdCopyBufferToImage( GfxDeviceGlobal::texCmdBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopyRegion );
-
-    imageMemoryBarrier = {};
-    imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    imageMemoryBarrier.srcAccessMask = 0;
-    imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    imageMemoryBarrier.image = image;
-    imageMemoryBarrier.subresourceRange = range;
-
-    vkCmdPipelineBarrier(
-        GfxDeviceGlobal::texCmdBuffer,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &imageMemoryBarrier );
-
-    vkEndCommandBuffer( GfxDeviceGlobal::texCmdBuffer );
-
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &GfxDeviceGlobal::texCmdBuffer;
-
-    err = vkQueueSubmit( GfxDeviceGlobal::graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE );
-    AE3D_CHECK_VULKAN( err, "vkQueueSubmit in Texture2D" );
-
-    vkDeviceWaitIdle( GfxDeviceGlobal::device );
-
-    err = vkBeginCommandBuffer( GfxDeviceGlobal::texCmdBuffer, &cmdBufInfo );
-    AE3D_CHECK_VULKAN( err, "vkBeginCommandBuffer in Texture2D" );
-
-    for (int i = 1; i < mipLevelCount; ++i)
+    for (int mipIndex = 0; mipIndex < mipLevelCount; ++mipIndex)
     {
-        const std::int32_t mipWidth = MathUtil::Max( width >> i, 1 );
-        const std::int32_t mipHeight = MathUtil::Max( height >> i, 1 );
-
-        VkImageBlit imageBlit = {};
-        imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.srcSubresource.baseArrayLayer = 0;
-        imageBlit.srcSubresource.layerCount = 1;
-        imageBlit.srcSubresource.mipLevel = 0;
-        imageBlit.srcOffsets[ 0 ] = { 0, 0, 0 };
-        imageBlit.srcOffsets[ 1 ] = { width, height, 1 };
-
-        imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBlit.dstSubresource.baseArrayLayer = 0;
-        imageBlit.dstSubresource.layerCount = 1;
-        imageBlit.dstSubresource.mipLevel = i;
-        imageBlit.dstOffsets[ 0 ] = { 0, 0, 0 };
-        imageBlit.dstOffsets[ 1 ] = { mipWidth, mipHeight, 1 };
-
-        vkCmdBlitImage( GfxDeviceGlobal::texCmdBuffer, image, VK_IMAGE_LAYOUT_GENERAL, image,
-            VK_IMAGE_LAYOUT_GENERAL, 1, &imageBlit, VK_FILTER_LINEAR );
+        VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[ mipIndex ];
+        bufferCopyRegion = {};
+        bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        bufferCopyRegion.imageSubresource.mipLevel = mipIndex;
+        bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+        bufferCopyRegion.imageSubresource.layerCount = 1;
+        bufferCopyRegion.imageExtent.width = MathUtil::Max( width >> mipIndex, 1 );
+        bufferCopyRegion.imageExtent.height = MathUtil::Max( height >> mipIndex, 1 );
+        bufferCopyRegion.imageExtent.depth = 1;
+        bufferCopyRegion.bufferOffset = MipGenerator::GetMipOffset( width, height, mipIndex ) / 4 * bytesPerPixel;
     }
 
+    vkCmdCopyBufferToImage( GfxDeviceGlobal::texCmdBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevelCount, &bufferCopyRegions[ 0 ] );
+
     imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageMemoryBarrier.image = image;
-    imageMemoryBarrier.subresourceRange = range;
-    imageMemoryBarrier.subresourceRange.baseMipLevel = 0;
-    imageMemoryBarrier.subresourceRange.levelCount = mipLevelCount;
 
     vkCmdPipelineBarrier(
             GfxDeviceGlobal::texCmdBuffer,
@@ -636,113 +1148,144 @@ void ae3d::Texture2D::CreateVulkanObjects( void* data, int bytesPerPixel, VkForm
         layout = VK_IMAGE_LAYOUT_GENERAL;
     }
 
-    vkEndCommandBuffer( GfxDeviceGlobal::texCmdBuffer );
+    EndTextureUpload( stagingBuffer, stagingMemory, imageSize );
 
-    err = vkQueueSubmit( GfxDeviceGlobal::graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE );
-    AE3D_CHECK_VULKAN( err, "vkQueueSubmit in Texture2D" );
-
-    vkDeviceWaitIdle( GfxDeviceGlobal::device );
-    vkFreeMemory( GfxDeviceGlobal::device, stagingMemory, nullptr );
-    vkDestroyBuffer( GfxDeviceGlobal::device, stagingBuffer, nullptr );
+    sampler = CreateSampler( filter, wrap, anisotropy, mipLevelCount );
+}
 
-    VkSamplerCreateInfo samplerInfo = {};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = filter == ae3d::TextureFilter::Nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
-    samplerInfo.minFilter = samplerInfo.magFilter;
-    samplerInfo.mipmapMode = filter == ae3d::TextureFilter::Nearest ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.addressModeU = wrap == ae3d::TextureWrap::Repeat ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeV = samplerInfo.addressModeU;
-    samplerInfo.addressModeW = samplerInfo.addressModeU;
-    samplerInfo.mipLodBias = 0;
-    samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-    samplerInfo.minLod = 0;
-    samplerInfo.maxLod = static_cast< float >(mipLevelCount);
-    samplerInfo.maxAnisotropy = GfxDeviceGlobal::deviceFeatures.samplerAnisotropy ? GetFloatAnisotropy( anisotropy ) : 1;
-    samplerInfo.anisotropyEnable = (anisotropy != Anisotropy::k1 && GfxDeviceGlobal::deviceFeatures.samplerAnisotropy) ? VK_TRUE : VK_FALSE;
-    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
-    err = vkCreateSampler( GfxDeviceGlobal::device, &samplerInfo, nullptr, &sampler );
-    AE3D_CHECK_VULKAN( err, "vkCreateSampler" );
-    Texture2DGlobal::samplersToReleaseAtExit.push_back( sampler );
+VkFormat GetDDSFormat( DDSLoader::Format format, bool opaque, ae3d::ColorSpace colorSpace )
+{
+    const bool isLinear = colorSpace == ae3d::ColorSpace::Linear;
 
-    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)sampler, VK_OBJECT_TYPE_SAMPLER, "sampler" );
+    switch (format)
+    {
+    case DDSLoader::Format::BC1:
+        if (opaque)
+        {
+            return isLinear ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        }
+        return isLinear ? VK_FORMAT_BC1_RGBA_UNORM_BLOCK : VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    case DDSLoader::Format::BC2: return isLinear ? VK_FORMAT_BC2_UNORM_BLOCK : VK_FORMAT_BC2_SRGB_BLOCK;
+    case DDSLoader::Format::BC3: return isLinear ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK;
+    case DDSLoader::Format::BC4U: return VK_FORMAT_BC4_UNORM_BLOCK;
+    case DDSLoader::Format::BC4S: return VK_FORMAT_BC4_SNORM_BLOCK;
+    case DDSLoader::Format::BC5U: return VK_FORMAT_BC5_UNORM_BLOCK;
+    case DDSLoader::Format::BC5S: return VK_FORMAT_BC5_SNORM_BLOCK;
+    case DDSLoader::Format::BC6HU: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+    case DDSLoader::Format::BC6HS: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+    case DDSLoader::Format::BC7: return isLinear ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+    case DDSLoader::Format::RGBA16F: return VK_FORMAT_R16G16B16A16_SFLOAT;
+    default: return VK_FORMAT_UNDEFINED;
+    }
 }
 
-void ae3d::Texture2D::LoadDDS( const char* aPath )
+void ae3d::Texture2D::LoadDDS( const FileSystem::FileContentsData& fileContents, const DecodedImage* decoded )
 {
     DDSLoader::Output ddsOutput;
-    auto fileContents = FileSystem::FileContents( aPath );
-    const DDSLoader::LoadResult loadResult = DDSLoader::Load( fileContents, width, height, opaque, ddsOutput );
+    const DDSLoader::LoadResult loadResult = LoadDDSContents( fileContents, decoded, width, height, opaque, ddsOutput );
 
     if (loadResult != DDSLoader::LoadResult::Success)
     {
-        ae3d::System::Print( "DDS Loader could not load %s", aPath );
+        ae3d::System::Print( "DDS Loader could not load %s", fileContents.path.c_str() );
         return;
     }
 
     if (static_cast< int >( GfxDeviceGlobal::properties.limits.maxImageDimension2D ) < width ||
-        static_cast< int >( GfxDeviceGlobal::properties.limits.maxImageDimension2D ) < height)
+        static_cast< int >( GfxDeviceGlobal::properties.limits.maxImageDimension2D ) < height ||
+        static_cast< int >( GfxDeviceGlobal::properties.limits.maxImageArrayLayers ) < ddsOutput.layerCount)
     {
-        System::Print( "%s is too big (%dx%d), max supported size is %dx%d.\n", fileContents.path.c_str(), width, height,
-            GfxDeviceGlobal::properties.limits.maxImageDimension2D, GfxDeviceGlobal::properties.limits.maxImageDimension2D );
-        width = GfxDeviceGlobal::properties.limits.maxImageDimension2D;
-        height = GfxDeviceGlobal::properties.limits.maxImageDimension2D;
+        System::Print( "%s is too big (%dx%d, %d layers), max supported size is %dx%d, %d layers.\n", fileContents.path.c_str(), width, height, ddsOutput.layerCount,
+            GfxDeviceGlobal::properties.limits.maxImageDimension2D, GfxDeviceGlobal::properties.limits.maxImageDimension2D, GfxDeviceGlobal::properties.limits.maxImageArrayLayers );
+        return;
     }
 
-    mipLevelCount = mipmaps == Mipmaps::Generate ? ddsOutput.dataOffsets.count : 1;
+    mipLevelCount = mipmaps == Mipmaps::Generate ? ddsOutput.mipCount : 1;
 
-    VkFormat format = (colorSpace == ColorSpace::Linear) ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    const VkFormat format = GetDDSFormat( ddsOutput.format, opaque, colorSpace );
 
-    if (!opaque)
+    if (format == VK_FORMAT_UNDEFINED)
     {
-        format = (colorSpace == ColorSpace::Linear) ? VK_FORMAT_BC1_RGBA_UNORM_BLOCK : VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        ae3d::System::Print( "File: %s\n", fileContents.path.c_str()  );
+        ae3d::System::Assert( false, "Unhandled compression format!" );
+        return;
     }
 
-    if (ddsOutput.format == DDSLoader::Format::BC1)
-    {
-        // Nothing to do here, defaults to BC1
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC2)
-    {
-        format = (colorSpace == ColorSpace::Linear) ? VK_FORMAT_BC2_UNORM_BLOCK : VK_FORMAT_BC2_SRGB_BLOCK;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC3)
-    {
-        format = (colorSpace == ColorSpace::Linear) ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC4U)
-    {
-        format = VK_FORMAT_BC4_UNORM_BLOCK;
-    }
-    else if (ddsOutput.format == DDSLoader::Format::BC4S)
+    // Streamed levels are read again from the file, so textures that were not loaded from a file are not streamed.
+    const int residentMip = (TextureStreamer::IsEnabled() && ddsOutput.layerCount == 1) ? TextureStreamer::GetInitialResidentMip( width, height, mipLevelCount ) : 0;
+    FileSystem::FileReader reader;
+
+    if (residentMip > 0 && reader.Open( fileContents.path.c_str() ))
     {
-        format = VK_FORMAT_BC4_SNORM_BLOCK;
+        CreateStreamedImage( ddsOutput, format, residentMip );
     }
-    else if (ddsOutput.format == DDSLoader::Format::BC5U)
+    else
     {
-        format = VK_FORMAT_BC5_UNORM_BLOCK;
+        CreateVulkanObjects( ddsOutput, format );
     }
-    else if( ddsOutput.format == DDSLoader::Format::BC5S )
+}
+
+void ae3d::Texture2D::CreateStreamedImage( const DDSLoader::Output& mipChain, VkFormat format, int residentMip )
+{
+    std::shared_ptr< Texture2DGlobal::StreamedImage > streamed = std::make_shared< Texture2DGlobal::StreamedImage >();
+    streamed->path = path;
+    streamed->format = format;
+    streamed->width = width;
+    streamed->height = height;
+    streamed->residentMip = mipLevelCount;
+
+    for (int mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
     {
-        format = VK_FORMAT_BC5_SNORM_BLOCK;
+        streamed->mipOffsets.push_back( mipChain.dataOffsets[ mipLevel ] );
+        streamed->mipSizes.push_back( DDSLoader::GetMipSize( mipChain.format, width, height, mipLevel ) );
     }
-    else
+
+    // Levels of a layer are contiguous in the file.
+    ResizeStreamedImage( *streamed, residentMip, mipChain.data + mipChain.dataOffsets[ residentMip ], mipLevelCount - residentMip );
+
+    TextureStreamer::Description description;
+    description.width = width;
+    description.height = height;
+    description.mipSizes = streamed->mipSizes;
+    description.residentMip = residentMip;
+
+    description.loadMip = [streamed]( int mipLevel )
     {
-        ae3d::System::Print( "File: %s\n", aPath  );
-        ae3d::System::Assert( false, "Unhandled compression format!" );
-    }
-    
-    ae3d::System::Assert( ddsOutput.dataOffsets.count > 0, "DDS reader error: dataoffsets is empty" );
+        FileSystem::FileReader reader;
+
+        if (!reader.Open( streamed->path.c_str() ) || !reader.Seek( streamed->mipOffsets[ mipLevel ] ))
+        {
+            return false;
+        }
 
-    CreateVulkanObjects( ddsOutput, format );
+        streamed->loadedMip.resize( streamed->mipSizes[ mipLevel ] );
+        return reader.Read( streamed->loadedMip.data(), streamed->loadedMip.size() ) == streamed->loadedMip.size();
+    };
+
+    description.setResidentMip = [streamed]( int mipLevel )
+    {
+        // Loads make the next more detailed level resident.
+        const int uploadCount = mipLevel < streamed->residentMip ? 1 : 0;
+        ResizeStreamedImage( *streamed, mipLevel, streamed->loadedMip.data(), uploadCount );
+        std::vector< unsigned char >().swap( streamed->loadedMip );
+    };
+
+    streamHandle = TextureStreamer::Register( description );
+    Texture2DGlobal::streamedImages[ streamHandle.index ] = streamed;
+
+    image = streamed->image;
+    view = streamed->view;
+    deviceMemory = streamed->memory;
+    layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    sampler = CreateSampler( filter, wrap, anisotropy, mipLevelCount );
 }
 
-void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents )
+void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents, DecodedImage* decoded )
 {
     System::Assert( GfxDeviceGlobal::graphicsQueue != VK_NULL_HANDLE, "queue not initialized" );
     System::Assert( GfxDeviceGlobal::device != VK_NULL_HANDLE, "device not initialized" );
 
     int components;
-    unsigned char* data = stbi_load_from_memory( fileContents.data.data(), static_cast<int>(fileContents.data.size()), &width, &height, &components, 4 );
+    unsigned char* data = LoadSTBPixels( fileContents, decoded, width, height, components );
 
     if (data == nullptr)
     {
@@ -762,9 +1305,9 @@ void ae3d::Texture2D::LoadSTB( const FileSystem::FileContentsData& fileContents
 
     opaque = (components == 3 || components == 1);
 
-    CreateVulkanObjects( data, 4, colorSpace == ColorSpace::Linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT );
+    CreateVulkanObjects( data, 4, colorSpace == ColorSpace::Linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, decoded );
 
-    stbi_image_free( data );
+    FreeSTBPixels( data );
 }
 
 ae3d::Texture2D* ae3d::Texture2D::GetDefaultTexture()
@@ -12,6 +12,11 @@
 #include "VulkanUtils.hpp"
 
 bool HasStbExtension( const std::string& path ); // Defined in TextureCommon.cpp
+bool HasDDSExtension( const std::string& path ); // Defined in TextureCommon.cpp
+VkFormat GetDDSFormat( DDSLoader::Format format, bool opaque, ae3d::ColorSpace colorSpace ); // Defined in Texture2DVulkan.cpp
+void BeginTextureUpload(); // Defined in Texture2DVulkan.cpp
+void EndTextureUpload( VkBuffer stagingBuffer, VkDeviceMemory stagingMemory, VkDeviceSize stagingSize ); // Defined in Texture2DVulkan.cpp
+void FlushTextureUploads(); // Defined in Texture2DVulkan.cpp
 
 namespace MathUtil
 {
@@ -157,6 +162,22 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
     negYpath = negY.path;
     negZpath = negZ.path;
 
+    DDSLoader::Output cubeMap;
+
+    // RGBA16F cube maps from FilterCubeMap are not compressed, so they don't need BC support.
+    if (HasDDSExtension( negX.path ) &&
+        DDSLoader::Load( negX.data.data(), negX.data.size(), negX.path.c_str(), width, height, opaque, cubeMap ) == DDSLoader::LoadResult::Success &&
+        cubeMap.isCube && (GfxDeviceGlobal::deviceFeatures.textureCompressionBC || cubeMap.format == DDSLoader::Format::RGBA16F))
+    {
+        posXpath = negX.path;
+        posYpath = negX.path;
+        posZpath = negX.path;
+        negYpath = negX.path;
+        negZpath = negX.path;
+        LoadDDS( cubeMap, GetDDSFormat( cubeMap.format, opaque, colorSpace ), negX.path );
+        return;
+    }
+
     const std::string paths[] = { posX.path, negX.path, negY.path, posY.path, negZ.path, posZ.path };
     const std::vector< unsigned char >* datas[] = { &posX.data, &negX.data, &negY.data, &posY.data, &negZ.data, &posZ.data };
 
@@ -164,6 +185,9 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
     VkBuffer buffers[ 6 ];
     VkDeviceMemory deviceMemories[ 6 ];
 
+    // This path records into texCmdBuffer without the Texture2D upload helpers, so a recording batch is submitted first.
+    FlushTextureUploads();
+
     VkCommandBufferBeginInfo cmdBufInfo = {};
     cmdBufInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
  
@@ -285,7 +309,7 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
                 height = GfxDeviceGlobal::properties.limits.maxImageDimensionCube;
             }
 
-            mipLevelCount = mipmaps == Mipmaps::None ? 1 : ddsOutput[ face ].dataOffsets.count;
+            mipLevelCount = mipmaps == Mipmaps::None ? 1 : ddsOutput[ face ].mipCount;
         
             if (!opaque)
             {
@@ -665,3 +689,170 @@ void ae3d::TextureCube::Load( const FileSystem::FileContentsData& negX, const Fi
     TextureCubeGlobal::samplersToReleaseAtExit.push_back( sampler );
     debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)sampler, VK_OBJECT_TYPE_SAMPLER, "sampler" );
 }
+
+void ae3d::TextureCube::LoadDDS( const DDSLoader::Output& cubeMap, VkFormat format, const std::string& path )
+{
+    if (format == VK_FORMAT_UNDEFINED)
+    {
+        System::Print( "%s has an unhandled compression format!\n", path.c_str() );
+        return;
+    }
+
+    if (static_cast< int >( GfxDeviceGlobal::properties.limits.maxImageDimensionCube ) < width ||
+        static_cast< int >( GfxDeviceGlobal::properties.limits.maxImageDimensionCube ) < height)
+    {
+        System::Print( "%s is too big (%dx%d), max supported size is %dx%d.\n", path.c_str(), width, height,
+            GfxDeviceGlobal::properties.limits.maxImageDimensionCube, GfxDeviceGlobal::properties.limits.maxImageDimensionCube );
+        return;
+    }
+
+    mipLevelCount = mipmaps == Mipmaps::None ? 1 : cubeMap.mipCount;
+
+    VkImageCreateInfo imageCreateInfo = {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.arrayLayers = 6;
+    imageCreateInfo.extent = { (std::uint32_t)width, (std::uint32_t)height, 1 };
+    imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    imageCreateInfo.format = format;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.mipLevels = mipLevelCount;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    VkResult err = vkCreateImage( GfxDeviceGlobal::device, &imageCreateInfo, nullptr, &image );
+    AE3D_CHECK_VULKAN( err, "vkCreateImage in TextureCube" );
+
+    TextureCubeGlobal::imagesToReleaseAtExit.push_back( image );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)image, VK_OBJECT_TYPE_IMAGE, path.c_str() );
+
+    VkMemoryRequirements memReqs;
+    vkGetImageMemoryRequirements( GfxDeviceGlobal::device, image, &memReqs );
+
+    VkMemoryAllocateInfo memAllocInfo = {};
+    memAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    memAllocInfo.allocationSize = memReqs.size;
+    memAllocInfo.memoryTypeIndex = GetMemoryType( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+    err = vkAllocateMemory( GfxDeviceGlobal::device, &memAllocInfo, nullptr, &deviceMemory );
+    AE3D_CHECK_VULKAN( err, "vkAllocateMemory in TextureCube" );
+    TextureCubeGlobal::memoryToReleaseAtExit.push_back( deviceMemory );
+    debug::SetObjectName( GfxDeviceGlobal::device, ( std::uint64_t )deviceMemory, VK_OBJECT_TYPE_DEVICE_MEMORY, "cubemap dds memory" );
+    Statistics::IncAllocCalls();
+    Statistics::IncTotalAllocCalls();
+
+    err = vkBindImageMemory( GfxDeviceGlobal::device, image, deviceMemory, 0 );
+    AE3D_CHECK_VULKAN( err, "vkBindImageMemory in TextureCube" );
+
+    // Faces and their mip levels are contiguous in the file, so they are staged with one copy.
+    const int lastIndex = 5 * cubeMap.mipCount + mipLevelCount - 1;
+    const std::size_t firstOffset = cubeMap.dataOffsets[ 0 ];
+    const VkDeviceSize stagingSize = cubeMap.dataOffsets[ lastIndex ] + DDSLoader::GetMipSize( cubeMap.format, width, height, mipLevelCount - 1 ) - firstOffset;
+
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = stagingSize;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    err = vkCreateBuffer( GfxDeviceGlobal::device, &bufferCreateInfo, nullptr, &stagingBuffer );
+    AE3D_CHECK_VULKAN( err, "vkCreateBuffer staging" );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)stagingBuffer, VK_OBJECT_TYPE_BUFFER, "stagingDDSCube" );
+
+    vkGetBufferMemoryRequirements( GfxDeviceGlobal::device, stagingBuffer, &memReqs );
+
+    memAllocInfo.allocationSize = memReqs.size;
+    memAllocInfo.memoryTypeIndex = GetMemoryType( memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT );
+
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    err = vkAllocateMemory( GfxDeviceGlobal::device, &memAllocInfo, nullptr, &stagingMemory );
+    AE3D_CHECK_VULKAN( err, "vkAllocateMemory" );
+
+    err = vkBindBufferMemory( GfxDeviceGlobal::device, stagingBuffer, stagingMemory, 0 );
+    AE3D_CHECK_VULKAN( err, "vkBindBufferMemory staging" );
+
+    void* stagingData;
+    err = vkMapMemory( GfxDeviceGlobal::device, stagingMemory, 0, memReqs.size, 0, &stagingData );
+    AE3D_CHECK_VULKAN( err, "vkMapMemory in TextureCube" );
+
+    std::memcpy( stagingData, cubeMap.data + firstOffset, stagingSize );
+
+    VkMappedMemoryRange flushRange = {};
+    flushRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    flushRange.memory = stagingMemory;
+    flushRange.offset = 0;
+    flushRange.size = VK_WHOLE_SIZE;
+    vkFlushMappedMemoryRanges( GfxDeviceGlobal::device, 1, &flushRange );
+
+    vkUnmapMemory( GfxDeviceGlobal::device, stagingMemory );
+
+    // Joins the scene's Texture2D upload batch, if one is recording.
+    BeginTextureUpload();
+
+    SetImageLayout( GfxDeviceGlobal::texCmdBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 6, 0, mipLevelCount );
+
+    Array< VkBufferImageCopy > bufferCopyRegions( 6 * mipLevelCount );
+
+    for (int face = 0; face < 6; ++face)
+    {
+        // Load() puts the negY texture into layer 2 and posY into layer 3, so the file's Y faces are swapped the same way.
+        const int layer = face == 2 ? 3 : (face == 3 ? 2 : face);
+
+        for (int mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel)
+        {
+            VkBufferImageCopy& bufferCopyRegion = bufferCopyRegions[ face * mipLevelCount + mipLevel ];
+            bufferCopyRegion = {};
+            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            bufferCopyRegion.imageSubresource.mipLevel = mipLevel;
+            bufferCopyRegion.imageSubresource.baseArrayLayer = layer;
+            bufferCopyRegion.imageSubresource.layerCount = 1;
+            bufferCopyRegion.imageExtent.width = MathUtil::Max( width >> mipLevel, 1 );
+            bufferCopyRegion.imageExtent.height = MathUtil::Max( height >> mipLevel, 1 );
+            bufferCopyRegion.imageExtent.depth = 1;
+            bufferCopyRegion.bufferOffset = cubeMap.dataOffsets[ face * cubeMap.mipCount + mipLevel ] - firstOffset;
+        }
+    }
+
+    vkCmdCopyBufferToImage( GfxDeviceGlobal::texCmdBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, bufferCopyRegions.count, &bufferCopyRegions[ 0 ] );
+
+    SetImageLayout( GfxDeviceGlobal::texCmdBuffer, image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 6, 0, mipLevelCount );
+
+    EndTextureUpload( stagingBuffer, stagingMemory, stagingSize );
+
+    VkImageViewCreateInfo viewInfo = {};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+    viewInfo.format = format;
+    viewInfo.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY };
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 6;
+    viewInfo.subresourceRange.levelCount = mipLevelCount;
+    viewInfo.image = image;
+    err = vkCreateImageView( GfxDeviceGlobal::device, &viewInfo, nullptr, &view );
+    AE3D_CHECK_VULKAN( err, "vkCreateImageView in TextureCube" );
+    TextureCubeGlobal::imageViewsToReleaseAtExit.push_back( view );
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = filter == ae3d::TextureFilter::Nearest ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+    samplerInfo.minFilter = samplerInfo.magFilter;
+    samplerInfo.mipmapMode = filter == ae3d::TextureFilter::Nearest ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = wrap == ae3d::TextureWrap::Repeat ? VK_SAMPLER_ADDRESS_MODE_REPEAT : VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = samplerInfo.addressModeU;
+    samplerInfo.addressModeW = samplerInfo.addressModeU;
+    samplerInfo.mipLodBias = 0;
+    samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+    samplerInfo.minLod = 0;
+    samplerInfo.maxLod = static_cast< float >( mipLevelCount );
+    samplerInfo.maxAnisotropy = 1;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    err = vkCreateSampler( GfxDeviceGlobal::device, &samplerInfo, nullptr, &sampler );
+    AE3D_CHECK_VULKAN( err, "vkCreateSampler" );
+    TextureCubeGlobal::samplersToReleaseAtExit.push_back( sampler );
+    debug::SetObjectName( GfxDeviceGlobal::device, (std::uint64_t)sampler, VK_OBJECT_TYPE_SAMPLER, "sampler" );
+}
@@ -1,19 +1,22 @@
 // This is an independent project of an individual developer. Dear PVS-Studio, please check it.
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "VertexBuffer.hpp"
+#include <algorithm>
 #include <vector>
+#include <cstddef>
 #include <cstring>
 #include <cstdint>
 #include "Array.hpp"
+#include "DeletionQueueVulkan.hpp"
 #include "Macros.hpp"
 #include "Statistics.hpp"
 #include "System.hpp"
+#include "VertexQuantization.hpp"
 #include "VulkanUtils.hpp"
 
 namespace GfxDeviceGlobal
 {
     extern VkDevice device;
-    extern Array< VkBuffer > pendingFreeVBs;
     extern VkCommandPool cmdPool;
     extern VkQueue graphicsQueue;
 }
@@ -110,44 +113,45 @@ void CreateBuffer( VkBuffer& buffer, int bufferSize, VkDeviceMemory& memory, VkB
     AE3D_CHECK_VULKAN( err, "vkBindBufferMemory" );
 }
 
-void MarkForFreeing( VkBuffer vertexBuffer, VkDeviceMemory vertexMem, VkBuffer indexBuffer, VkDeviceMemory indexMem )
+// Destroys the buffer and frees its memory when the GPU has finished using them.
+static void ReleaseBuffer( VkBuffer& buffer, VkDeviceMemory& memory )
 {
-    for (std::size_t memoryIndex = 0; memoryIndex < VertexBufferGlobal::memoryToReleaseAtExit.size(); ++memoryIndex)
-    {
-        if (VertexBufferGlobal::memoryToReleaseAtExit[ memoryIndex ] == vertexMem)
-        {
-            VertexBufferGlobal::memoryToReleaseAtExit.erase( std::begin( VertexBufferGlobal::memoryToReleaseAtExit ) + memoryIndex );
-        }
-    }
+    auto& buffers = VertexBufferGlobal::buffersToReleaseAtExit;
+    auto& memories = VertexBufferGlobal::memoryToReleaseAtExit;
 
-    for (std::size_t memoryIndex = 0; memoryIndex < VertexBufferGlobal::memoryToReleaseAtExit.size(); ++memoryIndex)
+    if (buffer != VK_NULL_HANDLE)
     {
-        if (VertexBufferGlobal::memoryToReleaseAtExit[ memoryIndex ] == indexMem)
-        {
-            VertexBufferGlobal::memoryToReleaseAtExit.erase( std::begin( VertexBufferGlobal::memoryToReleaseAtExit ) + memoryIndex );
-        }
+        buffers.erase( std::remove( std::begin( buffers ), std::end( buffers ), buffer ), std::end( buffers ) );
+        ae3d::DeletionQueue::ReleaseBuffer( buffer );
     }
 
-    for (std::size_t bufferIndex = 0; bufferIndex < VertexBufferGlobal::buffersToReleaseAtExit.size(); ++bufferIndex)
+    if (memory != VK_NULL_HANDLE)
     {
-        if (VertexBufferGlobal::buffersToReleaseAtExit[ bufferIndex ] == vertexBuffer)
-        {
-            VertexBufferGlobal::buffersToReleaseAtExit.erase( std::begin( VertexBufferGlobal::buffersToReleaseAtExit ) + bufferIndex );
-        }
+        memories.erase( std::remove( std::begin( memories ), std::end( memories ), memory ), std::end( memories ) );
+        ae3d::DeletionQueue::ReleaseMemory( memory );
     }
 
-    for (std::size_t bufferIndex = 0; bufferIndex < VertexBufferGlobal::buffersToReleaseAtExit.size(); ++bufferIndex)
+    buffer = VK_NULL_HANDLE;
+    memory = VK_NULL_HANDLE;
+}
+
+void ae3d::VertexBuffer::Release()
+{
+    // Dynamic buffers use the staging buffers directly.
+    if (vertexMem != VK_NULL_HANDLE)
     {
-        if (VertexBufferGlobal::buffersToReleaseAtExit[ bufferIndex ] == indexBuffer)
-        {
-            VertexBufferGlobal::buffersToReleaseAtExit.erase( std::begin( VertexBufferGlobal::buffersToReleaseAtExit ) + bufferIndex );
-        }
+        ReleaseBuffer( vertexBuffer, vertexMem );
+        ReleaseBuffer( indexBuffer, indexMem );
     }
 
-    vkFreeMemory( GfxDeviceGlobal::device, vertexMem, nullptr );
-    vkFreeMemory( GfxDeviceGlobal::device, indexMem, nullptr );
-    GfxDeviceGlobal::pendingFreeVBs.Add( vertexBuffer );
-    GfxDeviceGlobal::pendingFreeVBs.Add( indexBuffer );
+    ReleaseBuffer( stagingBuffers.vertices.buffer, stagingBuffers.vertices.memory );
+    ReleaseBuffer( stagingBuffers.indices.buffer, stagingBuffers.indices.memory );
+    stagingBuffers.vertices.size = 0;
+    stagingBuffers.indices.size = 0;
+    stagingBuffers.vertices.mappedData = nullptr;
+    stagingBuffers.indices.mappedData = nullptr;
+    vertexBuffer = VK_NULL_HANDLE;
+    indexBuffer = VK_NULL_HANDLE;
 }
 
 void ae3d::VertexBuffer::GenerateVertexBuffer( const void* vertexData, int vertexBufferSize, int vertexStride, const void* indexData, int indexBufferSize )
@@ -156,9 +160,10 @@ void ae3d::VertexBuffer::GenerateVertexBuffer( const void* vertexData, int verte
     System::Assert( vertexData != nullptr, "vertexData not initialized" );
     System::Assert( indexData != nullptr, "indexData not initialized" );
 
-    if (vertexBuffer != VK_NULL_HANDLE)
+    if (vertexMem != VK_NULL_HANDLE)
     {
-        MarkForFreeing( vertexBuffer, vertexMem, indexBuffer, indexMem );
+        ReleaseBuffer( vertexBuffer, vertexMem );
+        ReleaseBuffer( indexBuffer, indexMem );
     }
 
     // Vertex buffer
@@ -166,6 +171,7 @@ void ae3d::VertexBuffer::GenerateVertexBuffer( const void* vertexData, int verte
 
     if (shouldCreateVertexBuffer)
     {
+        ReleaseBuffer( stagingBuffers.vertices.buffer, stagingBuffers.vertices.memory );
         stagingBuffers.vertices.size = vertexBufferSize;
         CreateBuffer( stagingBuffers.vertices.buffer, vertexBufferSize, stagingBuffers.vertices.memory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "staging vertex buffer" );
         VertexBufferGlobal::buffersToReleaseAtExit.push_back( stagingBuffers.vertices.buffer );
@@ -192,6 +198,7 @@ void ae3d::VertexBuffer::GenerateVertexBuffer( const void* vertexData, int verte
     
     if (shouldCreateIndexBuffer)
     {
+        ReleaseBuffer( stagingBuffers.indices.buffer, stagingBuffers.indices.memory );
         stagingBuffers.indices.size = indexBufferSize;
         CreateBuffer( stagingBuffers.indices.buffer, indexBufferSize, stagingBuffers.indices.memory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "staging index buffer" );
         VertexBufferGlobal::buffersToReleaseAtExit.push_back( stagingBuffers.indices.buffer );
@@ -223,6 +230,12 @@ void ae3d::VertexBuffer::CreateInputState( int vertexStride )
 
 	std::uint32_t attributeCount = 0;
 
+    if (vertexFormat != VertexFormat::PTNTC_Quantized && vertexFormat != VertexFormat::PTNTC_Skinned_Quantized)
+    {
+        vertexScale = Vec4( 1, 1, 1, 0 );
+        vertexOffset = Vec4( 0, 0, 0, 0 );
+    }
+
     if (vertexFormat == VertexFormat::PTC)
     {
 		attributeCount = 3;
@@ -347,6 +360,53 @@ void ae3d::VertexBuffer::CreateInputState( int vertexStride )
         attributeDescriptions[ 6 ].format = VK_FORMAT_R32G32B32A32_UINT;
         attributeDescriptions[ 6 ].offset = sizeof( float ) * 20;
     }
+    else if (vertexFormat == VertexFormat::PTNTC_Quantized || vertexFormat == VertexFormat::PTNTC_Skinned_Quantized)
+    {
+        // Quantization::VertexPTNTC_Skinned starts with the same members as Quantization::VertexPTNTC.
+        attributeCount = vertexFormat == VertexFormat::PTNTC_Quantized ? 5 : 7;
+
+        // Location 0 : Position, tangent handedness in .w
+        attributeDescriptions[ 0 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 0 ].location = posChannel;
+        attributeDescriptions[ 0 ].format = VK_FORMAT_R16G16B16A16_SNORM;
+        attributeDescriptions[ 0 ].offset = offsetof( Quantization::VertexPTNTC, position );
+
+        // Location 1 : TexCoord
+        attributeDescriptions[ 1 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 1 ].location = uvChannel;
+        attributeDescriptions[ 1 ].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[ 1 ].offset = offsetof( Quantization::VertexPTNTC, uv );
+
+        // Location 2 : Normal, octahedral
+        attributeDescriptions[ 2 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 2 ].location = normalChannel;
+        attributeDescriptions[ 2 ].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[ 2 ].offset = offsetof( Quantization::VertexPTNTC, normal );
+
+        // Location 3 : Tangent, octahedral
+        attributeDescriptions[ 3 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 3 ].location = tangentChannel;
+        attributeDescriptions[ 3 ].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[ 3 ].offset = offsetof( Quantization::VertexPTNTC, tangent );
+
+        // Location 4 : Color
+        attributeDescriptions[ 4 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 4 ].location = colorChannel;
+        attributeDescriptions[ 4 ].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attributeDescriptions[ 4 ].offset = offsetof( Quantization::VertexPTNTC, color );
+
+        // Location 5 : Weights
+        attributeDescriptions[ 5 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 5 ].location = 5;
+        attributeDescriptions[ 5 ].format = VK_FORMAT_R8G8B8A8_UNORM;
+        attributeDescriptions[ 5 ].offset = offsetof( Quantization::VertexPTNTC_Skinned, weights );
+
+        // Location 6 : Bones
+        attributeDescriptions[ 6 ].binding = VERTEX_BUFFER_BIND_ID;
+        attributeDescriptions[ 6 ].location = 6;
+        attributeDescriptions[ 6 ].format = VK_FORMAT_R8G8B8A8_UINT;
+        attributeDescriptions[ 6 ].offset = offsetof( Quantization::VertexPTNTC_Skinned, bones );
+    }
     else
     {
         System::Assert( false, "unhandled vertex format" );
@@ -361,18 +421,31 @@ void ae3d::VertexBuffer::CreateInputState( int vertexStride )
 }
 
 void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount )
+{
+    GenerateDynamic( faceCount, vertexCount, IndexType::UInt16 );
+}
+
+void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount, IndexType aIndexType )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = aIndexType;
     elementCount = faceCount * 3;
+    const int indexSize = indexType == IndexType::UInt32 ? 4 : 2;
+
+    Release();
 
     CreateBuffer( stagingBuffers.vertices.buffer, vertexCount * sizeof( VertexPTNTC ), stagingBuffers.vertices.memory, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "dynamic vertex buffer" );
     stagingBuffers.vertices.size = vertexCount * sizeof( VertexPTNTC );
+    VertexBufferGlobal::buffersToReleaseAtExit.push_back( stagingBuffers.vertices.buffer );
+    VertexBufferGlobal::memoryToReleaseAtExit.push_back( stagingBuffers.vertices.memory );
 
     VkResult err = vkMapMemory( GfxDeviceGlobal::device, stagingBuffers.vertices.memory, 0, stagingBuffers.vertices.size, 0, &stagingBuffers.vertices.mappedData );
     AE3D_CHECK_VULKAN( err, "vkMapMemory GenerateDynamic" );
 
-    CreateBuffer( stagingBuffers.indices.buffer, elementCount * 2, stagingBuffers.indices.memory, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "dynamic index buffer" );
-    stagingBuffers.indices.size = elementCount * 2;
+    CreateBuffer( stagingBuffers.indices.buffer, elementCount * indexSize, stagingBuffers.indices.memory, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "dynamic index buffer" );
+    stagingBuffers.indices.size = elementCount * indexSize;
+    VertexBufferGlobal::buffersToReleaseAtExit.push_back( stagingBuffers.indices.buffer );
+    VertexBufferGlobal::memoryToReleaseAtExit.push_back( stagingBuffers.indices.memory );
 
     err = vkMapMemory( GfxDeviceGlobal::device, stagingBuffers.indices.memory, 0, stagingBuffers.indices.size, 0, &stagingBuffers.indices.mappedData );
     AE3D_CHECK_VULKAN( err, "vkMapMemory GenerateDynamic" );
@@ -380,7 +453,11 @@ void ae3d::VertexBuffer::GenerateDynamic( int faceCount, int vertexCount )
     vertexBuffer = stagingBuffers.vertices.buffer;
     indexBuffer = stagingBuffers.indices.buffer;
 
-    verticesPTNTC.Allocate( vertexCount );
+    // Only UpdateDynamic() converts through verticesPTNTC. UpdateDynamicVertices() writes into the buffer.
+    if (indexType == IndexType::UInt16)
+    {
+        verticesPTNTC.Allocate( vertexCount );
+    }
 
     CreateInputState( sizeof( VertexPTNTC ) );
 }
@@ -407,9 +484,38 @@ void ae3d::VertexBuffer::UpdateDynamic( const Face* faces, int faceCount, const
     std::memcpy( stagingBuffers.vertices.mappedData, verticesPTNTC.elements, vertexCount * sizeof( VertexPTNTC ) );
 }
 
+void ae3d::VertexBuffer::UpdateDynamicVertices( const VertexPTC* vertices, int firstVertex, int vertexCount )
+{
+    System::Assert( stagingBuffers.vertices.mappedData != nullptr, "Vertex buffer not initialized!" );
+    System::Assert( (std::size_t)stagingBuffers.vertices.size >= (firstVertex + vertexCount) * sizeof( VertexPTNTC ), "Vertex buffer too small!" );
+
+    // The buffer is host-coherent, so vertices are converted straight into it.
+    VertexPTNTC* mapped = static_cast< VertexPTNTC* >( stagingBuffers.vertices.mappedData ) + firstVertex;
+
+    for (int vertexInd = 0; vertexInd < vertexCount; ++vertexInd)
+    {
+        mapped[ vertexInd ].position = vertices[ vertexInd ].position;
+        mapped[ vertexInd ].u = vertices[ vertexInd ].u;
+        mapped[ vertexInd ].v = vertices[ vertexInd ].v;
+        mapped[ vertexInd ].normal = Vec3( 0, 0, 1 );
+        mapped[ vertexInd ].tangent = Vec4( 1, 0, 0, 0 );
+        mapped[ vertexInd ].color = vertices[ vertexInd ].color;
+    }
+}
+
+void ae3d::VertexBuffer::UpdateDynamicFaces( const Face32* faces, int faceCount )
+{
+    System::Assert( stagingBuffers.indices.mappedData != nullptr, "Index buffer not initialized!" );
+    System::Assert( indexType == IndexType::UInt32, "Index buffer is not 32-bit!" );
+    System::Assert( (std::size_t)stagingBuffers.indices.size >= faceCount * sizeof( Face32 ), "Index buffer too small!" );
+
+    std::memcpy( stagingBuffers.indices.mappedData, faces, faceCount * sizeof( Face32 ) );
+}
+
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTC* vertices, int vertexCount, Storage /*storage*/ )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
 
     Array< VertexPTNTC > verticesPTNTC2;
@@ -428,11 +534,8 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
     GenerateVertexBuffer( static_cast< const void*>( verticesPTNTC2.elements ), vertexCount * sizeof( VertexPTNTC ), sizeof( VertexPTNTC ), static_cast< const void* >(faces), elementCount * 2 );
 }
 
-void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+void ae3d::VertexBuffer::GenerateVertexBuffer( const VertexPTN* vertices, int vertexCount, const void* indexData, int indexBufferSize )
 {
-    vertexFormat = VertexFormat::PTNTC;
-    elementCount = faceCount * 3;
-
     Array< VertexPTNTC > verticesPTNTC2;
     verticesPTNTC2.Allocate( vertexCount );
 
@@ -446,12 +549,21 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
         verticesPTNTC2[ vertexInd ].color = Vec4( 1, 1, 1, 1 );
     }
 
-    GenerateVertexBuffer( static_cast< const void*>( verticesPTNTC2.elements ), vertexCount * sizeof( VertexPTNTC ), sizeof( VertexPTNTC ), static_cast< const void* >( faces ), elementCount * 2 );
+    GenerateVertexBuffer( static_cast< const void*>( verticesPTNTC2.elements ), vertexCount * sizeof( VertexPTNTC ), sizeof( VertexPTNTC ), indexData, indexBufferSize );
+}
+
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt16;
+    elementCount = faceCount * 3;
+    GenerateVertexBuffer( vertices, vertexCount, static_cast< const void* >( faces ), elementCount * 2 );
 }
 
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
 {
     vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
     GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( VertexPTNTC ), sizeof( VertexPTNTC ), static_cast< const void*>( faces ), elementCount * 2 );
 }
@@ -459,6 +571,115 @@ void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Verte
 void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
 {
     vertexFormat = VertexFormat::PTNTC_Skinned;
+    indexType = IndexType::UInt16;
     elementCount = faceCount * 3;
     GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( VertexPTNTC_Skinned ), sizeof( VertexPTNTC_Skinned ), static_cast< const void*>( faces ), elementCount * 2 );
 }
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTN* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    GenerateVertexBuffer( vertices, vertexCount, static_cast< const void* >( faces ), elementCount * 4 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTNTC* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( VertexPTNTC ), sizeof( VertexPTNTC ), static_cast< const void*>( faces ), elementCount * 4 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const VertexPTNTC_Skinned* vertices, int vertexCount )
+{
+    vertexFormat = VertexFormat::PTNTC_Skinned;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( VertexPTNTC_Skinned ), sizeof( VertexPTNTC_Skinned ), static_cast< const void*>( faces ), elementCount * 4 );
+}
+
+void ae3d::VertexBuffer::SetQuantizationBounds( const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    Vec3 scale, offset;
+    Quantization::GetPositionScaleOffset( aabbMin, aabbMax, scale, offset );
+    vertexScale = Vec4( scale.x, scale.y, scale.z, 1 );
+    vertexOffset = Vec4( offset.x, offset.y, offset.z, 0 );
+}
+
+void ae3d::VertexBuffer::GenerateVertexBuffer( const Quantization::VertexPTN* vertices, int vertexCount, const void* indexData, int indexBufferSize )
+{
+    // Shaders read tangents and colors, so they are added like in the full precision PTN path.
+    Quantization::VertexPTNTC defaultVertex = {};
+    defaultVertex.position[ 3 ] = 32767;
+    Quantization::OctahedralEncode( Vec3( 1, 0, 0 ), defaultVertex.tangent );
+    defaultVertex.color[ 0 ] = defaultVertex.color[ 1 ] = defaultVertex.color[ 2 ] = defaultVertex.color[ 3 ] = 255;
+
+    Array< Quantization::VertexPTNTC > verticesPTNTC2;
+    verticesPTNTC2.Allocate( vertexCount );
+
+    for (unsigned vertexInd = 0; vertexInd < verticesPTNTC2.count; ++vertexInd)
+    {
+        verticesPTNTC2[ vertexInd ] = defaultVertex;
+        std::memcpy( verticesPTNTC2[ vertexInd ].position, vertices[ vertexInd ].position, sizeof( std::int16_t ) * 3 );
+        std::memcpy( verticesPTNTC2[ vertexInd ].uv, vertices[ vertexInd ].uv, sizeof( vertices[ vertexInd ].uv ) );
+        std::memcpy( verticesPTNTC2[ vertexInd ].normal, vertices[ vertexInd ].normal, sizeof( vertices[ vertexInd ].normal ) );
+    }
+
+    GenerateVertexBuffer( static_cast< const void*>( verticesPTNTC2.elements ), vertexCount * sizeof( Quantization::VertexPTNTC ), sizeof( Quantization::VertexPTNTC ), indexData, indexBufferSize );
+}
+
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Quantization::VertexPTN* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    vertexFormat = VertexFormat::PTNTC_Quantized;
+    indexType = IndexType::UInt16;
+    elementCount = faceCount * 3;
+    SetQuantizationBounds( aabbMin, aabbMax );
+    GenerateVertexBuffer( vertices, vertexCount, static_cast< const void* >( faces ), elementCount * 2 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Quantization::VertexPTNTC* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    vertexFormat = VertexFormat::PTNTC_Quantized;
+    indexType = IndexType::UInt16;
+    elementCount = faceCount * 3;
+    SetQuantizationBounds( aabbMin, aabbMax );
+    GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( Quantization::VertexPTNTC ), sizeof( Quantization::VertexPTNTC ), static_cast< const void*>( faces ), elementCount * 2 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face* faces, int faceCount, const Quantization::VertexPTNTC_Skinned* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    vertexFormat = VertexFormat::PTNTC_Skinned_Quantized;
+    indexType = IndexType::UInt16;
+    elementCount = faceCount * 3;
+    SetQuantizationBounds( aabbMin, aabbMax );
+    GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( Quantization::VertexPTNTC_Skinned ), sizeof( Quantization::VertexPTNTC_Skinned ), static_cast< const void*>( faces ), elementCount * 2 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const Quantization::VertexPTN* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    vertexFormat = VertexFormat::PTNTC_Quantized;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    SetQuantizationBounds( aabbMin, aabbMax );
+    GenerateVertexBuffer( vertices, vertexCount, static_cast< const void* >( faces ), elementCount * 4 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const Quantization::VertexPTNTC* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    vertexFormat = VertexFormat::PTNTC_Quantized;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    SetQuantizationBounds( aabbMin, aabbMax );
+    GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( Quantization::VertexPTNTC ), sizeof( Quantization::VertexPTNTC ), static_cast< const void*>( faces ), elementCount * 4 );
+}
+
+void ae3d::VertexBuffer::Generate( const Face32* faces, int faceCount, const Quantization::VertexPTNTC_Skinned* vertices, int vertexCount, const Vec3& aabbMin, const Vec3& aabbMax )
+{
+    vertexFormat = VertexFormat::PTNTC_Skinned_Quantized;
+    indexType = IndexType::UInt32;
+    elementCount = faceCount * 3;
+    SetQuantizationBounds( aabbMin, aabbMax );
+    GenerateVertexBuffer( static_cast< const void*>( vertices ), vertexCount * sizeof( Quantization::VertexPTNTC_Skinned ), sizeof( Quantization::VertexPTNTC_Skinned ), static_cast< const void*>( faces ), elementCount * 4 );
+}
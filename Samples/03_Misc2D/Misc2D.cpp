@@ -57,7 +57,7 @@ int main()
     Texture2D notLoadedTex;
 
     Texture2D spriteTexFromAtlas;
-    spriteTexFromAtlas.LoadFromAtlas( FileSystem::FileContents( "atlas_cegui.png" ), FileSystem::FileContents( "atlas_cegui.xml" ), "marble", TextureWrap::Repeat, TextureFilter::Nearest, ColorSpace::Linear, Anisotropy::k1 );
+    spriteTexFromAtlas.LoadFromAtlas( FileSystem::FileContents( "atlas_cegui.png" ), "atlas_cegui.xml", "marble", TextureWrap::Repeat, TextureFilter::Nearest, ColorSpace::Linear, Anisotropy::k1 );
 
     GameObject spriteContainer;
     spriteContainer.AddComponent<SpriteRendererComponent>();
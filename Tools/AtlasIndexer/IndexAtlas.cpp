@@ -0,0 +1,51 @@
+/**
+  Converts Ogre/CEGUI .xml atlas metadata into a binary atlas index that Texture2D::LoadFromAtlas() reads without parsing XML.
+
+  Usage: IndexAtlas input.xml output.atlas
+*/
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "AtlasIndex.hpp"
+
+int main( int argCount, char* args[] )
+{
+    if (argCount < 3)
+    {
+        std::cout << "Usage: IndexAtlas input.xml output.atlas" << std::endl;
+        return 1;
+    }
+
+    std::ifstream inFile( args[ 1 ], std::ios::binary );
+
+    if (!inFile)
+    {
+        std::cerr << "Could not open " << args[ 1 ] << std::endl;
+        return 1;
+    }
+
+    const std::vector< unsigned char > inData( (std::istreambuf_iterator< char >( inFile )), std::istreambuf_iterator< char >() );
+    ae3d::AtlasIndex index;
+
+    if (!index.Load( inData.data(), inData.size() ))
+    {
+        std::cerr << args[ 1 ] << " has no <Image> elements or is a truncated index." << std::endl;
+        return 1;
+    }
+
+    std::vector< unsigned char > outData;
+    index.WriteBinary( outData );
+
+    std::ofstream outFile( args[ 2 ], std::ios::binary );
+    outFile.write( reinterpret_cast< const char* >( outData.data() ), (std::streamsize)outData.size() );
+
+    if (!outFile)
+    {
+        std::cerr << "Could not write " << args[ 2 ] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << index.GetCount() << " sprites, " << outData.size() << " bytes (XML was " << inData.size() << " bytes)." << std::endl;
+    return 0;
+}
@@ -1,29 +1,19 @@
 /**
-  Combines files listed in input text file into one.
-  
+  Combines files listed in input text file into one .pak file.
+
   Usage: CombineFiles input.txt output
 
   Input file contains one path per line.
-  
-  Output file's first 4 bytes is the block count. After it blocks are followed where data is ordered like below:
-  offset      data
-      0       file name
-    128       file length
-    132       file contents
+
+  Output file starts with a table of contents that has a hash table of paths and each file's offset and size.
+  File contents follow, aligned to 16 bytes, so the engine can memory-map the output file and read files in place.
+  Layout is described in Engine/Core/PakFormat.hpp.
 */
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <list>
 #include <string>
 #include <vector>
-#include <cstring>
-
-struct FileMetaBlock
-{
-    std::string path;
-    unsigned dataSize;
-};
+#include "PakWriter.hpp"
 
 int main( int argCount, char* args[] )
 {
@@ -40,45 +30,21 @@ int main( int argCount, char* args[] )
         return 1;
     }
 
-    std::list< FileMetaBlock > fileList;
+    std::vector< std::string > paths;
     std::string line;
-    const unsigned MaxPathLength = 128;
 
     while (std::getline( fileListFile, line ))
     {
-        fileList.push_back( FileMetaBlock() );
-        fileList.back().path = line;
-        
-        if (line.length() > MaxPathLength)
+        if (!line.empty() && line.back() == '\r')
         {
-            std::cout << "Too long path in " << line << ". Max length is " << MaxPathLength << std::endl;
-            return 1;
+            line.pop_back();
         }
-    }
 
-    // 1st pass: Determine file sizes.    
-    for (auto& file : fileList)
-    {
-        std::ifstream ifs( file.path );
-        ifs.seekg( 0, std::ios::end );
-        file.dataSize = static_cast< unsigned >( ifs.tellg() );
-    }
-    
-    std::ofstream ofs( args[ 2 ], std::ios::out | std::ios::binary );
-    const unsigned listLength = static_cast< unsigned >( fileList.size() );
-    ofs.write( (char*)&listLength, 4 );
-
-    for (const auto& file : fileList)
-    {
-        char path[ MaxPathLength ] = { 0 };
-        std::strcpy( path, file.path.c_str() );
-        ofs.write( (char*)path, MaxPathLength );
-        ofs.write( (char*)&file.dataSize, 4 );
-        std::vector< unsigned char > data;
-        std::ifstream ifs( file.path );
-        data.assign( std::istreambuf_iterator< char >( ifs ), std::istreambuf_iterator< char >() );
-        ofs.write( (char*)data.data(), data.size() );
+        if (!line.empty())
+        {
+            paths.push_back( line );
+        }
     }
 
-    return 0;
+    return WritePakFile( paths, args[ 2 ] ) ? 0 : 1;
 }
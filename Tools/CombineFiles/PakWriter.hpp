@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../Engine/Core/Compression.hpp"
+#include "../../Engine/Core/PakFormat.hpp"
+
+static uint64_t AlignPakOffset( uint64_t offset )
+{
+    return (offset + ae3d::Pak::DataAlignment - 1) / ae3d::Pak::DataAlignment * ae3d::Pak::DataAlignment;
+}
+
+/// \return Compression for a file type. Files that are already compressed are stored as is, so they can be read in place.
+/// Text files are usually read once at load time, so they use the higher ratio.
+static ae3d::Pak::CompressionLevel GetPakCompression( const std::string& path )
+{
+    const std::size_t dot = path.find_last_of( '.' );
+    std::string extension = dot == std::string::npos ? "" : path.substr( dot + 1 );
+    std::transform( std::begin( extension ), std::end( extension ), std::begin( extension ), ::tolower );
+
+    const char* storedExtensions[] = { "png", "jpg", "jpeg", "ogg", "mp3", "astc", "ktx2", "zip", "pak" };
+    const char* highExtensions[] = { "scene", "obj", "mtl", "txt", "json", "xml", "fnt", "hlsl", "glsl", "vert", "frag", "comp", "metal", "material" };
+
+    for (const char* storedExtension : storedExtensions)
+    {
+        if (extension == storedExtension)
+        {
+            return ae3d::Pak::CompressionLevel::None;
+        }
+    }
+
+    for (const char* highExtension : highExtensions)
+    {
+        if (extension == highExtension)
+        {
+            return ae3d::Pak::CompressionLevel::High;
+        }
+    }
+
+    return ae3d::Pak::CompressionLevel::Fast;
+}
+
+/// Compresses blocks of entries on all cores. An entry is stored as is if compression doesn't save at least 1/16 of its size.
+/// \param contents Entry contents. Replaced with stored data.
+/// \param levels Compression of each entry. Set to None for entries that are stored as is.
+static void CompressPakEntries( std::vector< std::vector< unsigned char > >& contents, std::vector< ae3d::Pak::CompressionLevel >& levels )
+{
+    struct Block
+    {
+        std::size_t entry;
+        std::size_t start;
+        std::size_t size;
+        std::vector< unsigned char > data;
+    };
+
+    std::vector< Block > blocks;
+
+    for (std::size_t e = 0; e < contents.size(); ++e)
+    {
+        for (std::size_t start = 0; levels[ e ] != ae3d::Pak::CompressionLevel::None && start < contents[ e ].size(); start += ae3d::Pak::BlockSize)
+        {
+            blocks.push_back( { e, start, std::min< std::size_t >( ae3d::Pak::BlockSize, contents[ e ].size() - start ), {} } );
+        }
+    }
+
+    std::atomic< std::size_t > nextBlock( 0 );
+
+    auto compressBlocks = [&]()
+    {
+        for (std::size_t b = nextBlock++; b < blocks.size(); b = nextBlock++)
+        {
+            Block& block = blocks[ b ];
+            const unsigned char* source = contents[ block.entry ].data() + block.start;
+            const ae3d::Compression::Level level = levels[ block.entry ] == ae3d::Pak::CompressionLevel::High ? ae3d::Compression::Level::High : ae3d::Compression::Level::Fast;
+            // Blocks that don't get smaller are stored as is. Reader knows them by their size.
+            block.data.resize( block.size - 1 );
+            block.data.resize( block.size > 1 ? ae3d::Compression::Compress( source, block.size, block.data.data(), block.data.size(), level ) : 0 );
+
+            if (block.data.empty())
+            {
+                block.data.assign( source, source + block.size );
+            }
+        }
+    };
+
+    std::vector< std::thread > threads;
+
+    for (unsigned t = 1; t < std::thread::hardware_concurrency(); ++t)
+    {
+        threads.emplace_back( compressBlocks );
+    }
+
+    compressBlocks();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::size_t firstBlock = 0;
+
+    for (std::size_t e = 0; e < contents.size(); ++e)
+    {
+        if (levels[ e ] == ae3d::Pak::CompressionLevel::None)
+        {
+            continue;
+        }
+
+        const std::size_t blockCount = static_cast< std::size_t >( ae3d::Pak::GetBlockCount( contents[ e ].size(), ae3d::Pak::BlockSize ) );
+        std::vector< uint64_t > blockEnds( blockCount );
+        std::vector< unsigned char > stored;
+
+        for (std::size_t b = 0; b < blockCount; ++b)
+        {
+            const std::vector< unsigned char >& data = blocks[ firstBlock + b ].data;
+            stored.insert( std::end( stored ), std::begin( data ), std::end( data ) );
+            blockEnds[ b ] = stored.size();
+        }
+
+        firstBlock += blockCount;
+
+        const std::size_t storedSize = blockCount * sizeof( uint64_t ) + stored.size();
+
+        if (storedSize >= contents[ e ].size() - contents[ e ].size() / 16)
+        {
+            levels[ e ] = ae3d::Pak::CompressionLevel::None;
+            continue;
+        }
+
+        const unsigned char* blockEndBytes = reinterpret_cast< const unsigned char* >( blockEnds.data() );
+        stored.insert( std::begin( stored ), blockEndBytes, blockEndBytes + blockCount * sizeof( uint64_t ) );
+        contents[ e ].swap( stored );
+    }
+}
+
+/// Writes files into a .pak file. Layout is described in PakFormat.hpp.
+/// \param paths Paths of files to write. Backslashes are stored as slashes.
+/// \param outputPath Path of the .pak file.
+/// \param getCompression Returns compression for a path.
+/// \return True if the .pak file was written.
+static bool WritePakFile( const std::vector< std::string >& paths, const char* outputPath,
+                          ae3d::Pak::CompressionLevel (*getCompression)( const std::string& path ) = GetPakCompression )
+{
+    const uint32_t entryCount = static_cast< uint32_t >( paths.size() );
+    std::vector< ae3d::Pak::Entry > entries( entryCount );
+    std::vector< std::vector< unsigned char > > contents( entryCount );
+    std::vector< ae3d::Pak::CompressionLevel > levels( entryCount );
+    std::string entryPaths;
+
+    for (uint32_t e = 0; e < entryCount; ++e)
+    {
+        std::ifstream ifs( paths[ e ], std::ios::binary );
+
+        if (!ifs.is_open())
+        {
+            std::cout << "Could not open " << paths[ e ] << std::endl;
+            return false;
+        }
+
+        contents[ e ].assign( std::istreambuf_iterator< char >( ifs ), std::istreambuf_iterator< char >() );
+
+        std::string path = paths[ e ];
+        std::replace( std::begin( path ), std::end( path ), '\\', '/' );
+
+        entries[ e ].pathHash = ae3d::Pak::HashPath( path.data(), path.size() );
+        entries[ e ].size = contents[ e ].size();
+        entries[ e ].pathOffset = static_cast< uint32_t >( entryPaths.size() );
+        entries[ e ].pathLength = static_cast< uint32_t >( path.size() );
+        entryPaths += path;
+        levels[ e ] = getCompression( path );
+    }
+
+    CompressPakEntries( contents, levels );
+
+    for (uint32_t e = 0; e < entryCount; ++e)
+    {
+        entries[ e ].storedSize = contents[ e ].size();
+        entries[ e ].compression = levels[ e ];
+    }
+
+    ae3d::Pak::Header header = {};
+    std::copy( ae3d::Pak::Magic, ae3d::Pak::Magic + 4, header.magic );
+    header.version = ae3d::Pak::Version;
+    header.entryCount = entryCount;
+    header.bucketCount = ae3d::Pak::GetBucketCount( entryCount );
+    header.dataAlignment = ae3d::Pak::DataAlignment;
+    header.pathsOffset = static_cast< uint32_t >( sizeof( header ) + header.bucketCount * sizeof( uint32_t ) + entryCount * sizeof( ae3d::Pak::Entry ) );
+    header.pathsSize = static_cast< uint32_t >( entryPaths.size() );
+    header.blockSize = ae3d::Pak::BlockSize;
+
+    std::vector< uint32_t > buckets( header.bucketCount );
+
+    for (uint32_t e = 0; e < entryCount; ++e)
+    {
+        uint64_t bucket = entries[ e ].pathHash & (header.bucketCount - 1);
+
+        while (buckets[ bucket ] != 0)
+        {
+            const ae3d::Pak::Entry& other = entries[ buckets[ bucket ] - 1 ];
+
+            if (other.pathHash == entries[ e ].pathHash && entryPaths.compare( other.pathOffset, other.pathLength, entryPaths, entries[ e ].pathOffset, entries[ e ].pathLength ) == 0)
+            {
+                std::cout << paths[ e ] << " is listed more than once." << std::endl;
+                return false;
+            }
+
+            bucket = (bucket + 1) & (header.bucketCount - 1);
+        }
+
+        buckets[ bucket ] = e + 1;
+    }
+
+    uint64_t offset = AlignPakOffset( header.pathsOffset + header.pathsSize );
+
+    for (auto& entry : entries)
+    {
+        entry.offset = offset;
+        offset = AlignPakOffset( offset + entry.storedSize );
+    }
+
+    std::ofstream ofs( outputPath, std::ios::out | std::ios::binary );
+
+    if (!ofs.is_open())
+    {
+        std::cout << "Could not open " << outputPath << " for writing." << std::endl;
+        return false;
+    }
+
+    ofs.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    ofs.write( reinterpret_cast< const char* >( buckets.data() ), buckets.size() * sizeof( uint32_t ) );
+    ofs.write( reinterpret_cast< const char* >( entries.data() ), entries.size() * sizeof( ae3d::Pak::Entry ) );
+    ofs.write( entryPaths.data(), entryPaths.size() );
+
+    uint64_t position = header.pathsOffset + header.pathsSize;
+    const char padding[ ae3d::Pak::DataAlignment ] = {};
+
+    for (uint32_t e = 0; e < entryCount; ++e)
+    {
+        ofs.write( padding, static_cast< std::streamsize >( entries[ e ].offset - position ) );
+        ofs.write( reinterpret_cast< const char* >( contents[ e ].data() ), contents[ e ].size() );
+        position = entries[ e ].offset + entries[ e ].storedSize;
+    }
+
+    return ofs.good();
+}
@@ -0,0 +1,519 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+/// Mip level of a cube map. Pixels are linear RGB floats, rows from top to bottom. Faces are in order +X, -X, +Y, -Y, +Z, -Z like in .dds files.
+struct CubeLevel
+{
+    int size = 0;
+    std::vector< float > faces[ 6 ];
+};
+
+/// Levels starting from the largest. Each level is half the size of the previous one.
+typedef std::vector< CubeLevel > CubeMipChain;
+
+static const float cubePi = 3.14159265f;
+
+/// Calls function( index ) for each index in [0, count) on all cores.
+template< typename Function >
+static void ParallelFor( int count, const Function& function )
+{
+    std::atomic< int > nextIndex( 0 );
+
+    auto run = [&]()
+    {
+        for (int i = nextIndex++; i < count; i = nextIndex++)
+        {
+            function( i );
+        }
+    };
+
+    std::vector< std::thread > threads;
+
+    for (unsigned t = 1; t < std::thread::hardware_concurrency(); ++t)
+    {
+        threads.emplace_back( run );
+    }
+
+    run();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+static void Normalize( float v[ 3 ] )
+{
+    const float length = std::sqrt( v[ 0 ] * v[ 0 ] + v[ 1 ] * v[ 1 ] + v[ 2 ] * v[ 2 ] );
+    v[ 0 ] /= length;
+    v[ 1 ] /= length;
+    v[ 2 ] /= length;
+}
+
+/// Direction of a point on a face, like D3D, Vulkan and Metal map them.
+/// \param u Horizontal position in [-1, 1], left to right.
+/// \param v Vertical position in [-1, 1], top to bottom.
+/// \param outDirection Receives a unit vector.
+static void GetCubeDirection( int face, float u, float v, float outDirection[ 3 ] )
+{
+    const float directions[ 6 ][ 3 ] = { { 1, -v, -u }, { -1, -v, u }, { u, 1, v }, { u, -1, -v }, { u, -v, 1 }, { -u, -v, -1 } };
+    outDirection[ 0 ] = directions[ face ][ 0 ];
+    outDirection[ 1 ] = directions[ face ][ 1 ];
+    outDirection[ 2 ] = directions[ face ][ 2 ];
+    Normalize( outDirection );
+}
+
+/// Inverse of GetCubeDirection().
+/// \return Face.
+static int GetCubeFace( const float direction[ 3 ], float& outU, float& outV )
+{
+    const float x = direction[ 0 ], y = direction[ 1 ], z = direction[ 2 ];
+    const float ax = std::abs( x ), ay = std::abs( y ), az = std::abs( z );
+
+    if (ax >= ay && ax >= az)
+    {
+        outU = (x > 0 ? -z : z) / ax;
+        outV = -y / ax;
+        return x > 0 ? 0 : 1;
+    }
+
+    if (ay >= az)
+    {
+        outU = x / ay;
+        outV = (y > 0 ? z : -z) / ay;
+        return y > 0 ? 2 : 3;
+    }
+
+    outU = (z > 0 ? x : -x) / az;
+    outV = -y / az;
+    return z > 0 ? 4 : 5;
+}
+
+/// Bilinear sample. Edges are clamped to the face.
+static void SampleFace( const CubeLevel& level, int face, float u, float v, float outRGB[ 3 ] )
+{
+    const float px = std::min( std::max( (u + 1) * 0.5f * level.size - 0.5f, 0.0f ), level.size - 1.0f );
+    const float py = std::min( std::max( (v + 1) * 0.5f * level.size - 0.5f, 0.0f ), level.size - 1.0f );
+    const int x0 = static_cast< int >( px ), y0 = static_cast< int >( py );
+    const int x1 = std::min( x0 + 1, level.size - 1 ), y1 = std::min( y0 + 1, level.size - 1 );
+    const float fx = px - x0, fy = py - y0;
+    const float* pixels = level.faces[ face ].data();
+
+    for (int c = 0; c < 3; ++c)
+    {
+        const float top = pixels[ (y0 * level.size + x0) * 3 + c ] * (1 - fx) + pixels[ (y0 * level.size + x1) * 3 + c ] * fx;
+        const float bottom = pixels[ (y1 * level.size + x0) * 3 + c ] * (1 - fx) + pixels[ (y1 * level.size + x1) * 3 + c ] * fx;
+        outRGB[ c ] = top * (1 - fy) + bottom * fy;
+    }
+}
+
+/// Trilinear sample.
+static void SampleCube( const CubeMipChain& chain, const float direction[ 3 ], float lod, float outRGB[ 3 ] )
+{
+    float u, v;
+    const int face = GetCubeFace( direction, u, v );
+    lod = std::min( std::max( lod, 0.0f ), static_cast< float >( chain.size() - 1 ) );
+    const int mip0 = static_cast< int >( lod );
+    const int mip1 = std::min( mip0 + 1, static_cast< int >( chain.size() ) - 1 );
+    const float f = lod - mip0;
+
+    float rgb0[ 3 ], rgb1[ 3 ];
+    SampleFace( chain[ mip0 ], face, u, v, rgb0 );
+    SampleFace( chain[ mip1 ], face, u, v, rgb1 );
+
+    for (int c = 0; c < 3; ++c)
+    {
+        outRGB[ c ] = rgb0[ c ] * (1 - f) + rgb1[ c ] * f;
+    }
+}
+
+/// Resamples an equirectangular (latitude-longitude) image. Its top row is +Y, and its center column is -Z.
+/// \param rgb Linear RGB floats.
+/// \param size Face size in pixels.
+static CubeLevel EquirectToCube( const float* rgb, int width, int height, int size )
+{
+    CubeLevel level;
+    level.size = size;
+
+    for (int face = 0; face < 6; ++face)
+    {
+        level.faces[ face ].resize( static_cast< std::size_t >( size ) * size * 3 );
+    }
+
+    ParallelFor( 6 * size, [&]( int row )
+    {
+        const int face = row / size;
+        const int y = row % size;
+
+        for (int x = 0; x < size; ++x)
+        {
+            float sum[ 3 ] = {};
+
+            // 2x2 samples per pixel, so images larger than the cube map don't alias much.
+            for (int s = 0; s < 4; ++s)
+            {
+                float direction[ 3 ];
+                GetCubeDirection( face, (x + 0.25f + 0.5f * (s % 2)) / size * 2 - 1, (y + 0.25f + 0.5f * (s / 2)) / size * 2 - 1, direction );
+
+                const float longitude = std::atan2( direction[ 0 ], -direction[ 2 ] );
+                const float latitude = std::acos( std::min( std::max( direction[ 1 ], -1.0f ), 1.0f ) );
+                const float px = (0.5f + longitude / (2 * cubePi)) * width - 0.5f;
+                const float py = std::min( std::max( latitude / cubePi * height - 0.5f, 0.0f ), height - 1.0f );
+                const int x0 = static_cast< int >( std::floor( px ) ), y0 = static_cast< int >( py );
+                const int y1 = std::min( y0 + 1, height - 1 );
+                const float fx = px - x0, fy = py - y0;
+                // Wraps horizontally.
+                const int wx0 = ((x0 % width) + width) % width, wx1 = (wx0 + 1) % width;
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    const float top = rgb[ (y0 * width + wx0) * 3 + c ] * (1 - fx) + rgb[ (y0 * width + wx1) * 3 + c ] * fx;
+                    const float bottom = rgb[ (y1 * width + wx0) * 3 + c ] * (1 - fx) + rgb[ (y1 * width + wx1) * 3 + c ] * fx;
+                    sum[ c ] += (top * (1 - fy) + bottom * fy) * 0.25f;
+                }
+            }
+
+            std::copy( sum, sum + 3, &level.faces[ face ][ (static_cast< std::size_t >( y ) * size + x) * 3 ] );
+        }
+    } );
+
+    return level;
+}
+
+/// \return Mip chain down to 1x1 made by averaging 2x2 pixels. level0's size must be a power of two.
+static CubeMipChain DownsampleCube( const CubeLevel& level0 )
+{
+    CubeMipChain chain( 1, level0 );
+
+    while (chain.back().size > 1)
+    {
+        const CubeLevel& source = chain.back();
+        CubeLevel level;
+        level.size = source.size / 2;
+
+        for (int face = 0; face < 6; ++face)
+        {
+            level.faces[ face ].resize( static_cast< std::size_t >( level.size ) * level.size * 3 );
+
+            for (int y = 0; y < level.size; ++y)
+            {
+                for (int x = 0; x < level.size; ++x)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        const float* s = source.faces[ face ].data();
+                        const int w = source.size;
+                        level.faces[ face ][ (y * level.size + x) * 3 + c ] = 0.25f * (s[ ((2 * y) * w + 2 * x) * 3 + c ] + s[ ((2 * y) * w + 2 * x + 1) * 3 + c ] +
+                                                                                       s[ ((2 * y + 1) * w + 2 * x) * 3 + c ] + s[ ((2 * y + 1) * w + 2 * x + 1) * 3 + c ]);
+                    }
+                }
+            }
+        }
+
+        chain.push_back( level );
+    }
+
+    return chain;
+}
+
+/// \return Roughness that a level of PrefilterGGX() is filtered for. Shaders sample level roughness * (mipCount - 1).
+static float GetLevelRoughness( int mipIndex, int mipCount )
+{
+    return mipCount > 1 ? static_cast< float >( mipIndex ) / (mipCount - 1) : 0;
+}
+
+static float RadicalInverse( std::uint32_t bits )
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return static_cast< float >( bits ) * 2.3283064365386963e-10f;
+}
+
+/// Convolves each level with the GGX distribution of GetLevelRoughness(), assuming that the view direction equals the normal
+/// like split-sum image-based lighting does. Level 0 is a copy of the source. Samples are read from blurrier source levels
+/// the less likely they are, so few samples don't cause noise.
+/// \param source Mip chain from DownsampleCube().
+/// \param sampleCount Importance samples per pixel.
+static CubeMipChain PrefilterGGX( const CubeMipChain& source, int sampleCount )
+{
+    CubeMipChain chain = source;
+    const int mipCount = static_cast< int >( chain.size() );
+    const float sourceTexelSolidAngle = 4 * cubePi / (6.0f * source[ 0 ].size * source[ 0 ].size);
+
+    for (int mipIndex = 1; mipIndex < mipCount; ++mipIndex)
+    {
+        CubeLevel& level = chain[ mipIndex ];
+        const float roughness = GetLevelRoughness( mipIndex, mipCount );
+        const float a2 = roughness * roughness * roughness * roughness;
+
+        ParallelFor( 6 * level.size, [&]( int row )
+        {
+            const int face = row / level.size;
+            const int y = row % level.size;
+
+            for (int x = 0; x < level.size; ++x)
+            {
+                float n[ 3 ];
+                GetCubeDirection( face, (x + 0.5f) / level.size * 2 - 1, (y + 0.5f) / level.size * 2 - 1, n );
+
+                const float up[ 3 ] = { std::abs( n[ 2 ] ) < 0.999f ? 0.0f : 1.0f, 0.0f, std::abs( n[ 2 ] ) < 0.999f ? 1.0f : 0.0f };
+                float tangentX[ 3 ] = { up[ 1 ] * n[ 2 ] - up[ 2 ] * n[ 1 ], up[ 2 ] * n[ 0 ] - up[ 0 ] * n[ 2 ], up[ 0 ] * n[ 1 ] - up[ 1 ] * n[ 0 ] };
+                Normalize( tangentX );
+                const float tangentY[ 3 ] = { n[ 1 ] * tangentX[ 2 ] - n[ 2 ] * tangentX[ 1 ], n[ 2 ] * tangentX[ 0 ] - n[ 0 ] * tangentX[ 2 ], n[ 0 ] * tangentX[ 1 ] - n[ 1 ] * tangentX[ 0 ] };
+
+                float sum[ 3 ] = {};
+                float weightSum = 0;
+
+                for (int s = 0; s < sampleCount; ++s)
+                {
+                    const float phi = 2 * cubePi * (s + 0.5f) / sampleCount;
+                    const float xi = RadicalInverse( static_cast< std::uint32_t >( s ) );
+                    const float cosTheta = std::sqrt( (1 - xi) / (1 + (a2 - 1) * xi) );
+                    const float sinTheta = std::sqrt( 1 - cosTheta * cosTheta );
+                    const float hx = sinTheta * std::cos( phi ), hy = sinTheta * std::sin( phi );
+
+                    float h[ 3 ];
+                    float l[ 3 ];
+
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        h[ i ] = tangentX[ i ] * hx + tangentY[ i ] * hy + n[ i ] * cosTheta;
+                        l[ i ] = 2 * cosTheta * h[ i ] - n[ i ];
+                    }
+
+                    const float nDotL = n[ 0 ] * l[ 0 ] + n[ 1 ] * l[ 1 ] + n[ 2 ] * l[ 2 ];
+
+                    if (nDotL <= 0)
+                    {
+                        continue;
+                    }
+
+                    // pdf of L is D * NdotH / (4 * VdotH), and V = N.
+                    const float d = a2 / (cubePi * std::pow( cosTheta * cosTheta * (a2 - 1) + 1, 2.0f ));
+                    const float pdf = d / 4;
+                    const float sampleSolidAngle = 1 / (sampleCount * pdf + 0.0001f);
+                    const float lod = 0.5f * std::log2( sampleSolidAngle / sourceTexelSolidAngle ) + 1;
+
+                    float rgb[ 3 ];
+                    SampleCube( source, l, lod, rgb );
+
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        sum[ c ] += rgb[ c ] * nDotL;
+                    }
+
+                    weightSum += nDotL;
+                }
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    level.faces[ face ][ (static_cast< std::size_t >( y ) * level.size + x) * 3 + c ] = sum[ c ] / weightSum;
+                }
+            }
+        } );
+    }
+
+    return chain;
+}
+
+/// Real spherical harmonics basis of bands 0-2 in order Y00, Y1-1, Y10, Y11, Y2-2, Y2-1, Y20, Y21, Y22.
+static void GetSHBasis( const float direction[ 3 ], float outBasis[ 9 ] )
+{
+    const float x = direction[ 0 ], y = direction[ 1 ], z = direction[ 2 ];
+    outBasis[ 0 ] = 0.282095f;
+    outBasis[ 1 ] = 0.488603f * y;
+    outBasis[ 2 ] = 0.488603f * z;
+    outBasis[ 3 ] = 0.488603f * x;
+    outBasis[ 4 ] = 1.092548f * x * y;
+    outBasis[ 5 ] = 1.092548f * y * z;
+    outBasis[ 6 ] = 0.315392f * (3 * z * z - 1);
+    outBasis[ 7 ] = 1.092548f * x * z;
+    outBasis[ 8 ] = 0.546274f * (x * x - y * y);
+}
+
+/// Projects the cube map onto spherical harmonics and convolves them with a clamped cosine.
+/// \param outCoefficients Receives RGB coefficients in GetSHBasis() order. Irradiance in direction n is
+///                        sum( outCoefficients[ i ] * basis( n )[ i ] ), and Lambertian diffuse light is albedo / pi times that.
+static void ProjectIrradianceSH( const CubeLevel& level, float outCoefficients[ 9 ][ 3 ] )
+{
+    double sums[ 9 ][ 3 ] = {};
+    double weightSum = 0;
+
+    for (int face = 0; face < 6; ++face)
+    {
+        for (int y = 0; y < level.size; ++y)
+        {
+            for (int x = 0; x < level.size; ++x)
+            {
+                const float u = (x + 0.5f) / level.size * 2 - 1;
+                const float v = (y + 0.5f) / level.size * 2 - 1;
+                // Texels near face corners cover smaller solid angles.
+                const float solidAngle = 4.0f / (level.size * level.size * std::pow( 1 + u * u + v * v, 1.5f ));
+
+                float direction[ 3 ];
+                float basis[ 9 ];
+                GetCubeDirection( face, u, v, direction );
+                GetSHBasis( direction, basis );
+
+                for (int i = 0; i < 9; ++i)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        sums[ i ][ c ] += static_cast< double >( level.faces[ face ][ (static_cast< std::size_t >( y ) * level.size + x) * 3 + c ] * basis[ i ] * solidAngle );
+                    }
+                }
+
+                weightSum += static_cast< double >( solidAngle );
+            }
+        }
+    }
+
+    // Clamped cosine convolution per band.
+    const float bandScales[ 9 ] = { cubePi, 2 * cubePi / 3, 2 * cubePi / 3, 2 * cubePi / 3, cubePi / 4, cubePi / 4, cubePi / 4, cubePi / 4, cubePi / 4 };
+
+    for (int i = 0; i < 9; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            // Solid angles sum to 4 pi up to discretization error.
+            outCoefficients[ i ][ c ] = static_cast< float >( sums[ i ][ c ] * 4 * static_cast< double >( cubePi ) / weightSum ) * bandScales[ i ];
+        }
+    }
+}
+
+/// \return Irradiance in a direction.
+static void EvaluateSH( const float coefficients[ 9 ][ 3 ], const float direction[ 3 ], float outRGB[ 3 ] )
+{
+    float basis[ 9 ];
+    GetSHBasis( direction, basis );
+
+    for (int c = 0; c < 3; ++c)
+    {
+        outRGB[ c ] = 0;
+
+        for (int i = 0; i < 9; ++i)
+        {
+            outRGB[ c ] += coefficients[ i ][ c ] * basis[ i ];
+        }
+    }
+}
+
+/// \return Half float, rounded to nearest. Values that don't fit are clamped to the largest half, NaN becomes 0.
+static std::uint16_t FloatToHalf( float value )
+{
+    if (!(value == value))
+    {
+        return 0;
+    }
+
+    value = std::min( std::max( value, -65504.0f ), 65504.0f );
+    const std::uint16_t sign = value < 0 ? 0x8000 : 0;
+    const float magnitude = std::abs( value );
+
+    if (magnitude < 6.103515625e-05f)
+    {
+        // Subnormal, in units of 2^-24.
+        return static_cast< std::uint16_t >( sign | static_cast< std::uint16_t >( std::lround( magnitude * 16777216.0f ) ) );
+    }
+
+    int exponent;
+    const float mantissa = std::frexp( magnitude, &exponent ); // magnitude = mantissa * 2^exponent, mantissa in [0.5, 1)
+    int bits = ((exponent + 14) << 10) + static_cast< int >( std::lround( (mantissa * 2 - 1) * 1024 ) );
+    bits = std::min( bits, 0x7BFF );
+    return static_cast< std::uint16_t >( sign | bits );
+}
+
+static void WriteCubeDDSUint( std::ofstream& file, std::uint32_t value )
+{
+    file.write( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+}
+
+/// Writes a cube map into a .dds file that has a DX10 header and DXGI_FORMAT_R16G16B16A16_FLOAT pixels. Alpha is 1.
+/// Each face's levels are written before the next face.
+/// \return True if the file was written.
+static bool WriteCubeDDSFile( const char* path, const CubeMipChain& chain )
+{
+    std::ofstream file( path, std::ios::binary );
+
+    if (!file || chain.empty())
+    {
+        return false;
+    }
+
+    const std::uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PITCH = 0x8, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000;
+    const std::uint32_t DDPF_FOURCC = 0x4;
+    const std::uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+    const std::uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0x200 | 0x400 | 0x800 | 0x1000 | 0x2000 | 0x4000 | 0x8000;
+    const std::uint32_t DXGI_FORMAT_R16G16B16A16_FLOAT = 10, D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3, DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+    const std::uint32_t size = static_cast< std::uint32_t >( chain[ 0 ].size );
+
+    file.write( "DDS ", 4 );
+    WriteCubeDDSUint( file, 124 );
+    WriteCubeDDSUint( file, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PITCH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT );
+    WriteCubeDDSUint( file, size );
+    WriteCubeDDSUint( file, size );
+    WriteCubeDDSUint( file, size * 8 );
+    WriteCubeDDSUint( file, 0 );
+    WriteCubeDDSUint( file, static_cast< std::uint32_t >( chain.size() ) );
+
+    for (int i = 0; i < 11; ++i)
+    {
+        WriteCubeDDSUint( file, 0 );
+    }
+
+    WriteCubeDDSUint( file, 32 );
+    WriteCubeDDSUint( file, DDPF_FOURCC );
+    file.write( "DX10", 4 );
+
+    for (int i = 0; i < 5; ++i)
+    {
+        WriteCubeDDSUint( file, 0 );
+    }
+
+    WriteCubeDDSUint( file, DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | (chain.size() > 1 ? DDSCAPS_MIPMAP : 0) );
+    WriteCubeDDSUint( file, DDSCAPS2_CUBEMAP_ALLFACES );
+
+    for (int i = 0; i < 3; ++i)
+    {
+        WriteCubeDDSUint( file, 0 );
+    }
+
+    WriteCubeDDSUint( file, DXGI_FORMAT_R16G16B16A16_FLOAT );
+    WriteCubeDDSUint( file, D3D10_RESOURCE_DIMENSION_TEXTURE2D );
+    WriteCubeDDSUint( file, DDS_RESOURCE_MISC_TEXTURECUBE );
+    WriteCubeDDSUint( file, 1 );
+    WriteCubeDDSUint( file, 0 );
+
+    std::vector< std::uint16_t > halfs;
+
+    for (int face = 0; face < 6; ++face)
+    {
+        for (const CubeLevel& level : chain)
+        {
+            const std::size_t pixelCount = static_cast< std::size_t >( level.size ) * level.size;
+            halfs.resize( pixelCount * 4 );
+
+            for (std::size_t i = 0; i < pixelCount; ++i)
+            {
+                halfs[ i * 4 + 0 ] = FloatToHalf( level.faces[ face ][ i * 3 + 0 ] );
+                halfs[ i * 4 + 1 ] = FloatToHalf( level.faces[ face ][ i * 3 + 1 ] );
+                halfs[ i * 4 + 2 ] = FloatToHalf( level.faces[ face ][ i * 3 + 2 ] );
+                halfs[ i * 4 + 3 ] = 0x3C00;
+            }
+
+            file.write( reinterpret_cast< const char* >( halfs.data() ), static_cast< std::streamsize >( halfs.size() * sizeof( std::uint16_t ) ) );
+        }
+    }
+
+    return static_cast< bool >( file );
+}
@@ -0,0 +1,159 @@
+/**
+  Converts an environment image into a single .dds cube map for image-based lighting. Level 0 is the environment, and each
+  smaller level is prefiltered with GGX for roughness mipIndex / (mipCount - 1), so shaders sample level roughness * (mipCount - 1)
+  for specular light. Also writes irradiance spherical harmonics for diffuse light. Uses all cores.
+
+  Usage: FilterCubeMap input.hdr output.dds [-size 256] [-samples 128]
+         FilterCubeMap posx.hdr negx.hdr posy.hdr negy.hdr posz.hdr negz.hdr output.dds [-samples 128]
+
+  input.hdr is an equirectangular (latitude-longitude) image whose top row is +Y. Faces are square images whose size is a
+  power of two, in the same order as TextureCube::Load() takes them. Images can be .hdr or any other format stb_image loads.
+  -size sets the face size of a cube map made from an equirectangular image, default is 256. It must be a power of two.
+  -samples sets GGX importance samples per pixel, default is 128.
+
+  The cube map has RGBA16F pixels. Load it with Mipmaps::Generate to use the prefiltered levels. 9 RGB SH coefficients
+  are written as text into output.sh, see ProjectIrradianceSH() for their basis.
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CubeMapFilter.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.c"
+
+static bool IsPowerOfTwo( int i )
+{
+    return i > 0 && (i & (i - 1)) == 0;
+}
+
+int main( int argCount, char* args[] )
+{
+    std::vector< std::string > paths;
+    int size = 256;
+    int sampleCount = 128;
+
+    for (int i = 1; i < argCount; ++i)
+    {
+        const std::string option = args[ i ];
+        const std::string value = i + 1 < argCount ? args[ i + 1 ] : "";
+
+        if (option == "-size" && IsPowerOfTwo( std::atoi( value.c_str() ) ))
+        {
+            size = std::atoi( value.c_str() );
+            ++i;
+        }
+        else if (option == "-samples" && std::atoi( value.c_str() ) > 0)
+        {
+            sampleCount = std::atoi( value.c_str() );
+            ++i;
+        }
+        else if (option[ 0 ] != '-')
+        {
+            paths.push_back( option );
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    if (paths.size() != 2 && paths.size() != 7)
+    {
+        std::cout << "Usage: FilterCubeMap input.hdr output.dds [-size 256] [-samples 128]" << std::endl;
+        std::cout << "       FilterCubeMap posx.hdr negx.hdr posy.hdr negy.hdr posz.hdr negz.hdr output.dds [-samples 128]" << std::endl;
+        return 1;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    CubeLevel level0;
+
+    if (paths.size() == 2)
+    {
+        int width, height, components;
+        float* pixels = stbi_loadf( paths[ 0 ].c_str(), &width, &height, &components, 3 );
+
+        if (pixels == nullptr)
+        {
+            std::cerr << "Failed to load " << paths[ 0 ] << ". Reason: " << stbi_failure_reason() << std::endl;
+            return 1;
+        }
+
+        level0 = EquirectToCube( pixels, width, height, size );
+        stbi_image_free( pixels );
+    }
+    else
+    {
+        for (int face = 0; face < 6; ++face)
+        {
+            int width, height, components;
+            float* pixels = stbi_loadf( paths[ face ].c_str(), &width, &height, &components, 3 );
+
+            if (pixels == nullptr)
+            {
+                std::cerr << "Failed to load " << paths[ face ] << ". Reason: " << stbi_failure_reason() << std::endl;
+                return 1;
+            }
+
+            if (width != height || !IsPowerOfTwo( width ) || (face > 0 && width != level0.size))
+            {
+                std::cerr << paths[ face ] << " is " << width << "x" << height << ". Faces must be square, the same size and their size must be a power of two." << std::endl;
+                stbi_image_free( pixels );
+                return 1;
+            }
+
+            level0.size = width;
+            level0.faces[ face ].assign( pixels, pixels + width * height * 3 );
+            stbi_image_free( pixels );
+        }
+    }
+
+    const CubeMipChain chain = PrefilterGGX( DownsampleCube( level0 ), sampleCount );
+
+    float coefficients[ 9 ][ 3 ];
+    ProjectIrradianceSH( chain[ 0 ], coefficients );
+
+    const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+    const std::string& outPath = paths.back();
+
+    if (!WriteCubeDDSFile( outPath.c_str(), chain ))
+    {
+        std::cerr << "Could not write " << outPath << std::endl;
+        return 1;
+    }
+
+    const std::string shPath = outPath.substr( 0, outPath.rfind( '.' ) ) + ".sh";
+    FILE* shFile = std::fopen( shPath.c_str(), "w" );
+
+    if (shFile == nullptr)
+    {
+        std::cerr << "Could not write " << shPath << std::endl;
+        return 1;
+    }
+
+    std::fprintf( shFile, "# Irradiance SH, RGB per line: Y00 Y1-1 Y10 Y11 Y2-2 Y2-1 Y20 Y21 Y22\n" );
+
+    for (int i = 0; i < 9; ++i)
+    {
+        std::fprintf( shFile, "%f %f %f\n", static_cast< double >( coefficients[ i ][ 0 ] ), static_cast< double >( coefficients[ i ][ 1 ] ),
+                      static_cast< double >( coefficients[ i ][ 2 ] ) );
+    }
+
+    std::fclose( shFile );
+
+    const float up[ 3 ] = { 0, 1, 0 };
+    const float down[ 3 ] = { 0, -1, 0 };
+    float upIrradiance[ 3 ], downIrradiance[ 3 ];
+    EvaluateSH( coefficients, up, upIrradiance );
+    EvaluateSH( coefficients, down, downIrradiance );
+
+    std::printf( "Wrote %dx%d cube map with %d prefiltered mip levels into %s and irradiance SH into %s in %.2f s.\n", chain[ 0 ].size, chain[ 0 ].size,
+                 static_cast< int >( chain.size() ), outPath.c_str(), shPath.c_str(), seconds );
+    std::printf( "Irradiance from above: %.3f %.3f %.3f, from below: %.3f %.3f %.3f\n", static_cast< double >( upIrradiance[ 0 ] ), static_cast< double >( upIrradiance[ 1 ] ),
+                 static_cast< double >( upIrradiance[ 2 ] ), static_cast< double >( downIrradiance[ 0 ] ), static_cast< double >( downIrradiance[ 1 ] ),
+                 static_cast< double >( downIrradiance[ 2 ] ) );
+    return 0;
+}
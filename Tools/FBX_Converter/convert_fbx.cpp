@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstdlib>
 #include "fbxsdk.h"
 #include "../common.hpp"
 
@@ -653,9 +654,31 @@ void LoadFBX( const std::string& path )
 
 int main( int paramCount, char** params )
 {
-    if (paramCount != 2)
+    bool quantize = false;
+    unsigned lodCount = 0;
+    bool isValidParams = paramCount >= 2;
+
+    for (int p = 2; p < paramCount && isValidParams; ++p)
+    {
+        if (std::string( params[ p ] ) == "-quantize")
+        {
+            quantize = true;
+        }
+        else if (std::string( params[ p ] ) == "-lods" && p + 1 < paramCount)
+        {
+            lodCount = (unsigned)std::atoi( params[ ++p ] );
+        }
+        else
+        {
+            isValidParams = false;
+        }
+    }
+
+    if (!isValidParams)
     {
-        std::cerr << "Usage: ./convert_fbx file.fbx" << std::endl;
+        std::cerr << "Usage: ./convert_fbx file.fbx [-quantize] [-lods <count>]" << std::endl;
+        std::cerr << "  -quantize writes compact vertices that are smaller on disk. They are decoded into full precision when loaded." << std::endl;
+        std::cerr << "  -lods generates up to <count> simplified detail levels." << std::endl;
         return 1;
     }
 
@@ -682,6 +705,6 @@ int main( int paramCount, char** params )
     outFile = outFile.substr( 0, outFile.length() - 3 );
     outFile.append( "ae3d" );
 
-    WriteAe3d( outFile, VertexFormat::PTNTC );
+    WriteAe3d( outFile, VertexFormat::PTNTC, quantize, lodCount );
     return 0;
 }
@@ -0,0 +1,137 @@
+/**
+  Generates a mip chain of an image and writes it into an uncompressed RGBA8 .dds file.
+
+  Usage: GenerateMips input.png output.dds [-srgb] [-kaiser] [-wrap] [-alphacutoff value]
+
+  -srgb filters color in linear space, use it for albedo and other color textures.
+  -kaiser uses a sharper Kaiser filter instead of a box filter.
+  -wrap filters across edges, use it for textures that repeat.
+  -alphacutoff keeps the fraction of pixels whose alpha is at least value the same in all levels, use it for alpha-tested textures.
+
+  Uses the same generator as the engine, see Engine/Core/MipGenerator.hpp.
+*/
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MipGenerator.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.c"
+
+static void WriteUint( std::ofstream& file, std::uint32_t value )
+{
+    file.write( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+}
+
+static bool WriteDDS( const char* path, int width, int height, int mipCount, const std::vector< unsigned char >& mipChain )
+{
+    std::ofstream file( path, std::ios::binary );
+
+    if (!file)
+    {
+        return false;
+    }
+
+    const std::uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PITCH = 0x8, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000;
+    const std::uint32_t DDPF_ALPHAPIXELS = 0x1, DDPF_RGB = 0x40;
+    const std::uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+
+    file.write( "DDS ", 4 );
+    WriteUint( file, 124 );
+    WriteUint( file, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PITCH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT );
+    WriteUint( file, height );
+    WriteUint( file, width );
+    WriteUint( file, width * 4 );
+    WriteUint( file, 0 );
+    WriteUint( file, mipCount );
+
+    for (int i = 0; i < 11; ++i)
+    {
+        WriteUint( file, 0 );
+    }
+
+    // Pixel format: bytes are R, G, B, A.
+    WriteUint( file, 32 );
+    WriteUint( file, DDPF_RGB | DDPF_ALPHAPIXELS );
+    WriteUint( file, 0 );
+    WriteUint( file, 32 );
+    WriteUint( file, 0x000000FF );
+    WriteUint( file, 0x0000FF00 );
+    WriteUint( file, 0x00FF0000 );
+    WriteUint( file, 0xFF000000 );
+
+    WriteUint( file, DDSCAPS_COMPLEX | DDSCAPS_TEXTURE | DDSCAPS_MIPMAP );
+
+    for (int i = 0; i < 4; ++i)
+    {
+        WriteUint( file, 0 );
+    }
+
+    file.write( reinterpret_cast< const char* >( mipChain.data() ), mipChain.size() );
+    return static_cast< bool >( file );
+}
+
+int main( int argCount, char* args[] )
+{
+    if (argCount < 3)
+    {
+        std::cout << "Usage: GenerateMips input.png output.dds [-srgb] [-kaiser] [-wrap] [-alphacutoff value]" << std::endl;
+        return 1;
+    }
+
+    ae3d::MipGenerator::Settings settings;
+
+    for (int i = 3; i < argCount; ++i)
+    {
+        const std::string option = args[ i ];
+
+        if (option == "-srgb")
+        {
+            settings.isSRGB = true;
+        }
+        else if (option == "-kaiser")
+        {
+            settings.filter = ae3d::MipGenerator::Filter::Kaiser;
+        }
+        else if (option == "-wrap")
+        {
+            settings.isWrapped = true;
+        }
+        else if (option == "-alphacutoff" && i + 1 < argCount)
+        {
+            settings.alphaCutoff = static_cast< float >( std::atof( args[ ++i ] ) );
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    int width, height, components;
+    unsigned char* pixels = stbi_load( args[ 1 ], &width, &height, &components, 4 );
+
+    if (pixels == nullptr)
+    {
+        std::cerr << "Failed to load " << args[ 1 ] << ". Reason: " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+
+    std::vector< unsigned char > mipChain( ae3d::MipGenerator::GetMipChainSize( width, height ) );
+    ae3d::MipGenerator::Generate( pixels, width, height, settings, mipChain.data() );
+    stbi_image_free( pixels );
+
+    const int mipCount = ae3d::MipGenerator::GetMipCount( width, height );
+
+    if (!WriteDDS( args[ 2 ], width, height, mipCount, mipChain ))
+    {
+        std::cerr << "Could not write " << args[ 2 ] << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << width << "x" << height << " with " << mipCount << " mip levels into " << args[ 2 ] << std::endl;
+    return 0;
+}
@@ -2,6 +2,7 @@
 // PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
 #include "../common.hpp"
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <map>
 #include <iostream>
@@ -497,10 +498,32 @@ void LoadObj( const std::string& path )
 
 int main( int paramCount, char** params )
 {
-    if (paramCount != 3)
+    bool quantize = false;
+    unsigned lodCount = 0;
+    bool isValidParams = paramCount >= 3;
+
+    for (int p = 3; p < paramCount && isValidParams; ++p)
+    {
+        if (std::string( params[ p ] ) == "-quantize")
+        {
+            quantize = true;
+        }
+        else if (std::string( params[ p ] ) == "-lods" && p + 1 < paramCount)
+        {
+            lodCount = (unsigned)std::atoi( params[ ++p ] );
+        }
+        else
+        {
+            isValidParams = false;
+        }
+    }
+
+    if (!isValidParams)
     {
-        std::cerr << "Usage: ./convert_obj <vertexformat> file.obj" << std::endl;
+        std::cerr << "Usage: ./convert_obj <vertexformat> file.obj [-quantize] [-lods <count>]" << std::endl;
         std::cerr << "  where <vertexformat> is 0 for PTNTC and 1 for PTN." << std::endl;
+        std::cerr << "  -quantize writes compact vertices that are smaller on disk. They are decoded into full precision when loaded." << std::endl;
+        std::cerr << "  -lods generates up to <count> simplified detail levels." << std::endl;
         return 1;
     }
 
@@ -520,6 +543,6 @@ int main( int paramCount, char** params )
         vertexFormat = VertexFormat::PTN;
     }
     
-    WriteAe3d( outFile, vertexFormat );
+    WriteAe3d( outFile, vertexFormat, quantize, lodCount );
     return 0;
 }
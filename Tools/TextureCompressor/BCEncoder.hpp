@@ -0,0 +1,1093 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/// Block compressed formats. Blocks are 4x4 pixels. BC1 stores RGB, BC3 RGBA, BC4 R, BC5 RG and BC7 RGBA with better quality than BC1 and BC3.
+enum class BCFormat
+{
+    BC1,
+    BC3,
+    BC4,
+    BC5,
+    BC7
+};
+
+/// Higher qualities search endpoints longer.
+enum class BCQuality
+{
+    /// Endpoints from the bounding box of the block.
+    Fast,
+    /// Endpoints from the principal axis of the block, refined once.
+    Normal,
+    /// Like Normal, but refines more and searches endpoint rounding.
+    High
+};
+
+static int GetBCBlockSize( BCFormat format )
+{
+    return (format == BCFormat::BC1 || format == BCFormat::BC4) ? 8 : 16;
+}
+
+/// \return Number of channels starting from R that the format stores.
+static int GetBCChannelCount( BCFormat format )
+{
+    switch (format)
+    {
+    case BCFormat::BC1: return 3;
+    case BCFormat::BC4: return 1;
+    case BCFormat::BC5: return 2;
+    default: return 4;
+    }
+}
+
+/// Writes bits into a block starting from the least significant bit of the first byte.
+struct BCBitWriter
+{
+    void Write( unsigned value, int bitCount )
+    {
+        for (int i = 0; i < bitCount; ++i, ++position)
+        {
+            data[ position / 8 ] = static_cast< unsigned char >( data[ position / 8 ] | (((value >> i) & 1) << (position % 8)) );
+        }
+    }
+
+    unsigned char* data;
+    int position;
+};
+
+struct BCBitReader
+{
+    unsigned Read( int bitCount )
+    {
+        unsigned value = 0;
+
+        for (int i = 0; i < bitCount; ++i, ++position)
+        {
+            value |= ((data[ position / 8 ] >> (position % 8)) & 1u) << i;
+        }
+
+        return value;
+    }
+
+    const unsigned char* data;
+    int position;
+};
+
+static void GetBoundingBoxEndpoints( const float pixels[ 16 ][ 4 ], int channelCount, float outEndpoint0[ 4 ], float outEndpoint1[ 4 ] )
+{
+    for (int c = 0; c < channelCount; ++c)
+    {
+        outEndpoint0[ c ] = outEndpoint1[ c ] = pixels[ 0 ][ c ];
+
+        for (int i = 1; i < 16; ++i)
+        {
+            outEndpoint0[ c ] = std::min( outEndpoint0[ c ], pixels[ i ][ c ] );
+            outEndpoint1[ c ] = std::max( outEndpoint1[ c ], pixels[ i ][ c ] );
+        }
+    }
+}
+
+/// Endpoints are the extremes of pixels projected to the principal axis, which is found by power iteration on the covariance.
+static void GetPrincipalEndpoints( const float pixels[ 16 ][ 4 ], int channelCount, float outEndpoint0[ 4 ], float outEndpoint1[ 4 ] )
+{
+    float mean[ 4 ] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < channelCount; ++c)
+        {
+            mean[ c ] += pixels[ i ][ c ] / 16;
+        }
+    }
+
+    float covariance[ 4 ][ 4 ] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int r = 0; r < channelCount; ++r)
+        {
+            for (int c = 0; c < channelCount; ++c)
+            {
+                covariance[ r ][ c ] += (pixels[ i ][ r ] - mean[ r ]) * (pixels[ i ][ c ] - mean[ c ]);
+            }
+        }
+    }
+
+    float axis[ 4 ] = { 1, 1, 1, 1 };
+
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[ 4 ] = {};
+        float largest = 0;
+
+        for (int r = 0; r < channelCount; ++r)
+        {
+            for (int c = 0; c < channelCount; ++c)
+            {
+                next[ r ] += covariance[ r ][ c ] * axis[ c ];
+            }
+
+            largest = std::max( largest, std::fabs( next[ r ] ) );
+        }
+
+        if (largest < 1e-6f)
+        {
+            break;
+        }
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            axis[ c ] = next[ c ] / largest;
+        }
+    }
+
+    float lengthSquared = 0;
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        lengthSquared += axis[ c ] * axis[ c ];
+    }
+
+    float minT = 0;
+    float maxT = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = 0;
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            t += (pixels[ i ][ c ] - mean[ c ]) * axis[ c ];
+        }
+
+        t /= lengthSquared;
+        minT = std::min( minT, t );
+        maxT = std::max( maxT, t );
+    }
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        outEndpoint0[ c ] = mean[ c ] + axis[ c ] * minT;
+        outEndpoint1[ c ] = mean[ c ] + axis[ c ] * maxT;
+    }
+}
+
+/// Least-squares endpoints for fixed indices. Pixel i is approximated by endpoint0 + (endpoint1 - endpoint0) * weights[ indices[ i ] ].
+/// \return False if all pixels use the same weight, endpoints are unchanged then.
+static bool SolveEndpoints( const float pixels[ 16 ][ 4 ], int channelCount, const int indices[ 16 ], const float* weights, float outEndpoint0[ 4 ], float outEndpoint1[ 4 ] )
+{
+    float aa = 0, ab = 0, bb = 0;
+    float ax[ 4 ] = {};
+    float bx[ 4 ] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const float b = weights[ indices[ i ] ];
+        const float a = 1 - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for (int c = 0; c < channelCount; ++c)
+        {
+            ax[ c ] += a * pixels[ i ][ c ];
+            bx[ c ] += b * pixels[ i ][ c ];
+        }
+    }
+
+    const float determinant = aa * bb - ab * ab;
+
+    if (std::fabs( determinant ) < 1e-6f)
+    {
+        return false;
+    }
+
+    for (int c = 0; c < channelCount; ++c)
+    {
+        outEndpoint0[ c ] = std::min( std::max( (ax[ c ] * bb - bx[ c ] * ab) / determinant, 0.0f ), 255.0f );
+        outEndpoint1[ c ] = std::min( std::max( (bx[ c ] * aa - ax[ c ] * ab) / determinant, 0.0f ), 255.0f );
+    }
+
+    return true;
+}
+
+static std::uint16_t PackRGB565( const float color[ 4 ] )
+{
+    const int r = std::min( std::max( static_cast< int >( color[ 0 ] * 31 / 255 + 0.5f ), 0 ), 31 );
+    const int g = std::min( std::max( static_cast< int >( color[ 1 ] * 63 / 255 + 0.5f ), 0 ), 63 );
+    const int b = std::min( std::max( static_cast< int >( color[ 2 ] * 31 / 255 + 0.5f ), 0 ), 31 );
+
+    return static_cast< std::uint16_t >( (r << 11) | (g << 5) | b );
+}
+
+static void UnpackRGB565( std::uint16_t color, int outColor[ 3 ] )
+{
+    const int r = color >> 11;
+    const int g = (color >> 5) & 63;
+    const int b = color & 31;
+
+    outColor[ 0 ] = (r << 3) | (r >> 2);
+    outColor[ 1 ] = (g << 2) | (g >> 4);
+    outColor[ 2 ] = (b << 3) | (b >> 2);
+}
+
+/// Palette in four-color mode. Entries 2 and 3 are 1/3 and 2/3 of the way from color0 to color1.
+static void GetBC1Palette( std::uint16_t color0, std::uint16_t color1, int outPalette[ 4 ][ 3 ] )
+{
+    UnpackRGB565( color0, outPalette[ 0 ] );
+    UnpackRGB565( color1, outPalette[ 1 ] );
+
+    for (int c = 0; c < 3; ++c)
+    {
+        outPalette[ 2 ][ c ] = (2 * outPalette[ 0 ][ c ] + outPalette[ 1 ][ c ] + 1) / 3;
+        outPalette[ 3 ][ c ] = (outPalette[ 0 ][ c ] + 2 * outPalette[ 1 ][ c ] + 1) / 3;
+    }
+}
+
+/// \return Squared error.
+static float FitBC1Indices( const float pixels[ 16 ][ 4 ], std::uint16_t color0, std::uint16_t color1, int outIndices[ 16 ] )
+{
+    int palette[ 4 ][ 3 ];
+    GetBC1Palette( color0, color1, palette );
+
+    // Equal colors are decoded in three-color mode, where index 3 is transparent.
+    const int paletteSize = color0 == color1 ? 1 : 4;
+    float error = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float bestError = 1e30f;
+
+        for (int p = 0; p < paletteSize; ++p)
+        {
+            float pixelError = 0;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                const float difference = pixels[ i ][ c ] - palette[ p ][ c ];
+                pixelError += difference * difference;
+            }
+
+            if (pixelError < bestError)
+            {
+                bestError = pixelError;
+                outIndices[ i ] = p;
+            }
+        }
+
+        error += bestError;
+    }
+
+    return error;
+}
+
+/// Four-color mode needs color0 > color1, so colors are swapped if needed.
+static void WriteBC1Block( std::uint16_t color0, std::uint16_t color1, const int indices[ 16 ], unsigned char* outBlock )
+{
+    const int swappedIndices[ 4 ] = { 1, 0, 3, 2 };
+    const bool isSwapped = color0 < color1;
+
+    if (isSwapped)
+    {
+        std::swap( color0, color1 );
+    }
+
+    outBlock[ 0 ] = static_cast< unsigned char >( color0 & 0xFF );
+    outBlock[ 1 ] = static_cast< unsigned char >( color0 >> 8 );
+    outBlock[ 2 ] = static_cast< unsigned char >( color1 & 0xFF );
+    outBlock[ 3 ] = static_cast< unsigned char >( color1 >> 8 );
+
+    std::uint32_t packedIndices = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        packedIndices |= static_cast< std::uint32_t >( isSwapped ? swappedIndices[ indices[ i ] ] : indices[ i ] ) << (i * 2);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        outBlock[ 4 + i ] = static_cast< unsigned char >( packedIndices >> (i * 8) );
+    }
+}
+
+/// \param rgba 16 pixels, row by row. Alpha is ignored.
+static void EncodeBC1Block( const unsigned char rgba[ 64 ], BCQuality quality, unsigned char* outBlock )
+{
+    float pixels[ 16 ][ 4 ];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            pixels[ i ][ c ] = rgba[ i * 4 + c ];
+        }
+    }
+
+    float endpoint0[ 4 ];
+    float endpoint1[ 4 ];
+
+    if (quality == BCQuality::Fast)
+    {
+        GetBoundingBoxEndpoints( pixels, 3, endpoint0, endpoint1 );
+    }
+    else
+    {
+        GetPrincipalEndpoints( pixels, 3, endpoint0, endpoint1 );
+    }
+
+    std::uint16_t color0 = PackRGB565( endpoint0 );
+    std::uint16_t color1 = PackRGB565( endpoint1 );
+    int indices[ 16 ];
+    float error = FitBC1Indices( pixels, color0, color1, indices );
+
+    const float weights[ 4 ] = { 0, 1, 1.0f / 3, 2.0f / 3 };
+    const int iterationCount = quality == BCQuality::Fast ? 0 : (quality == BCQuality::Normal ? 1 : 4);
+
+    for (int iteration = 0; iteration < iterationCount && error > 0; ++iteration)
+    {
+        if (!SolveEndpoints( pixels, 3, indices, weights, endpoint0, endpoint1 ))
+        {
+            break;
+        }
+
+        const std::uint16_t refinedColor0 = PackRGB565( endpoint0 );
+        const std::uint16_t refinedColor1 = PackRGB565( endpoint1 );
+        int refinedIndices[ 16 ];
+        const float refinedError = FitBC1Indices( pixels, refinedColor0, refinedColor1, refinedIndices );
+
+        if (refinedError >= error)
+        {
+            break;
+        }
+
+        color0 = refinedColor0;
+        color1 = refinedColor1;
+        error = refinedError;
+        std::copy( refinedIndices, refinedIndices + 16, indices );
+    }
+
+    // Moves each channel of both colors one step at a time while the error gets lower.
+    const int channelShifts[ 3 ] = { 11, 5, 0 };
+    const int channelMaxValues[ 3 ] = { 31, 63, 31 };
+    bool isImproved = quality == BCQuality::High;
+
+    for (int pass = 0; pass < 4 && isImproved && error > 0; ++pass)
+    {
+        isImproved = false;
+
+        for (int candidate = 0; candidate < 12; ++candidate)
+        {
+            const int shift = channelShifts[ candidate / 4 ];
+            const int maxValue = channelMaxValues[ candidate / 4 ];
+            std::uint16_t colors[ 2 ] = { color0, color1 };
+            std::uint16_t& color = colors[ (candidate / 2) % 2 ];
+            const int value = ((color >> shift) & maxValue) + ((candidate & 1) ? 1 : -1);
+
+            if (value < 0 || value > maxValue)
+            {
+                continue;
+            }
+
+            color = static_cast< std::uint16_t >( (color & ~(maxValue << shift)) | (value << shift) );
+            int candidateIndices[ 16 ];
+            const float candidateError = FitBC1Indices( pixels, colors[ 0 ], colors[ 1 ], candidateIndices );
+
+            if (candidateError < error)
+            {
+                error = candidateError;
+                color0 = colors[ 0 ];
+                color1 = colors[ 1 ];
+                std::copy( candidateIndices, candidateIndices + 16, indices );
+                isImproved = true;
+            }
+        }
+    }
+
+    WriteBC1Block( color0, color1, indices, outBlock );
+}
+
+static void DecodeBC1Block( const unsigned char* block, unsigned char outRgba[ 64 ] )
+{
+    const std::uint16_t color0 = static_cast< std::uint16_t >( block[ 0 ] | (block[ 1 ] << 8) );
+    const std::uint16_t color1 = static_cast< std::uint16_t >( block[ 2 ] | (block[ 3 ] << 8) );
+    int palette[ 4 ][ 3 ];
+    GetBC1Palette( color0, color1, palette );
+    int alpha[ 4 ] = { 255, 255, 255, 255 };
+
+    if (color0 <= color1)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[ 2 ][ c ] = (palette[ 0 ][ c ] + palette[ 1 ][ c ]) / 2;
+            palette[ 3 ][ c ] = 0;
+        }
+
+        alpha[ 3 ] = 0;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int index = (block[ 4 + i / 4 ] >> ((i % 4) * 2)) & 3;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            outRgba[ i * 4 + c ] = static_cast< unsigned char >( palette[ index ][ c ] );
+        }
+
+        outRgba[ i * 4 + 3 ] = static_cast< unsigned char >( alpha[ index ] );
+    }
+}
+
+/// If value0 > value1, entries 2-7 are interpolated. Otherwise entries 2-5 are interpolated and 6 and 7 are 0 and 255.
+static void GetBC4Palette( int value0, int value1, int outPalette[ 8 ] )
+{
+    outPalette[ 0 ] = value0;
+    outPalette[ 1 ] = value1;
+
+    if (value0 > value1)
+    {
+        for (int i = 1; i < 7; ++i)
+        {
+            outPalette[ i + 1 ] = ((7 - i) * value0 + i * value1 + 3) / 7;
+        }
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+        {
+            outPalette[ i + 1 ] = ((5 - i) * value0 + i * value1 + 2) / 5;
+        }
+
+        outPalette[ 6 ] = 0;
+        outPalette[ 7 ] = 255;
+    }
+}
+
+/// \return Squared error.
+static int FitBC4Indices( const unsigned char values[ 16 ], int value0, int value1, int outIndices[ 16 ] )
+{
+    int palette[ 8 ];
+    GetBC4Palette( value0, value1, palette );
+    int error = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int bestError = 1 << 30;
+
+        for (int p = 0; p < 8; ++p)
+        {
+            const int difference = values[ i ] - palette[ p ];
+
+            if (difference * difference < bestError)
+            {
+                bestError = difference * difference;
+                outIndices[ i ] = p;
+            }
+        }
+
+        error += bestError;
+    }
+
+    return error;
+}
+
+/// \param values 16 values, row by row.
+static void EncodeBC4Block( const unsigned char values[ 16 ], BCQuality quality, unsigned char* outBlock )
+{
+    int minValue = 255, maxValue = 0;
+    int innerMin = 255, innerMax = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        minValue = std::min( minValue, static_cast< int >( values[ i ] ) );
+        maxValue = std::max( maxValue, static_cast< int >( values[ i ] ) );
+
+        if (values[ i ] != 0 && values[ i ] != 255)
+        {
+            innerMin = std::min( innerMin, static_cast< int >( values[ i ] ) );
+            innerMax = std::max( innerMax, static_cast< int >( values[ i ] ) );
+        }
+    }
+
+    int value0 = maxValue;
+    int value1 = minValue;
+    int indices[ 16 ];
+    int error = FitBC4Indices( values, value0, value1, indices );
+
+    // The six-value mode has 0 and 255 in its palette, so its endpoints only need to span the other values.
+    if (quality != BCQuality::Fast && innerMin <= innerMax)
+    {
+        int candidateIndices[ 16 ];
+        const int candidateError = FitBC4Indices( values, innerMin, innerMax, candidateIndices );
+
+        if (candidateError < error)
+        {
+            error = candidateError;
+            value0 = innerMin;
+            value1 = innerMax;
+            std::copy( candidateIndices, candidateIndices + 16, indices );
+        }
+    }
+
+    // Moves endpoints one step at a time while the error gets lower. Helps when the extremes are outliers.
+    bool isImproved = quality == BCQuality::High;
+
+    for (int pass = 0; pass < 8 && isImproved && error > 0; ++pass)
+    {
+        isImproved = false;
+
+        for (int candidate = 0; candidate < 4; ++candidate)
+        {
+            const int step = (candidate & 1) ? 1 : -1;
+            const int candidateValue0 = value0 + (candidate < 2 ? step : 0);
+            const int candidateValue1 = value1 + (candidate < 2 ? 0 : step);
+
+            // Keeps the mode, because swapping the order of the endpoints changes the palette.
+            if (candidateValue0 < 0 || candidateValue0 > 255 || candidateValue1 < 0 || candidateValue1 > 255 ||
+                (candidateValue0 > candidateValue1) != (value0 > value1))
+            {
+                continue;
+            }
+
+            int candidateIndices[ 16 ];
+            const int candidateError = FitBC4Indices( values, candidateValue0, candidateValue1, candidateIndices );
+
+            if (candidateError < error)
+            {
+                error = candidateError;
+                value0 = candidateValue0;
+                value1 = candidateValue1;
+                std::copy( candidateIndices, candidateIndices + 16, indices );
+                isImproved = true;
+            }
+        }
+    }
+
+    outBlock[ 0 ] = static_cast< unsigned char >( value0 );
+    outBlock[ 1 ] = static_cast< unsigned char >( value1 );
+    std::uint64_t packedIndices = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        packedIndices |= static_cast< std::uint64_t >( indices[ i ] ) << (i * 3);
+    }
+
+    for (int i = 0; i < 6; ++i)
+    {
+        outBlock[ 2 + i ] = static_cast< unsigned char >( packedIndices >> (i * 8) );
+    }
+}
+
+static void DecodeBC4Block( const unsigned char* block, unsigned char outValues[ 16 ], int stride )
+{
+    int palette[ 8 ];
+    GetBC4Palette( block[ 0 ], block[ 1 ], palette );
+    std::uint64_t packedIndices = 0;
+
+    for (int i = 0; i < 6; ++i)
+    {
+        packedIndices |= static_cast< std::uint64_t >( block[ 2 + i ] ) << (i * 8);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        outValues[ i * stride ] = static_cast< unsigned char >( palette[ (packedIndices >> (i * 3)) & 7 ] );
+    }
+}
+
+static const int bc7Weights4[ 16 ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+/// \return 8-bit value of a 7-bit mode 6 endpoint with its p-bit.
+static int GetBC7Value( int quantized, int pBit )
+{
+    return (quantized << 1) | pBit;
+}
+
+static int QuantizeBC7Channel( float value, int pBit )
+{
+    return std::min( std::max( static_cast< int >( (value - pBit) / 2 + 0.5f ), 0 ), 127 );
+}
+
+/// \return Squared error.
+static float FitBC7Indices( const float pixels[ 16 ][ 4 ], const int endpoint0[ 4 ], const int endpoint1[ 4 ], int outIndices[ 16 ] )
+{
+    int palette[ 16 ][ 4 ];
+
+    for (int w = 0; w < 16; ++w)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            palette[ w ][ c ] = ((64 - bc7Weights4[ w ]) * endpoint0[ c ] + bc7Weights4[ w ] * endpoint1[ c ] + 32) >> 6;
+        }
+    }
+
+    float error = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float bestError = 1e30f;
+
+        for (int w = 0; w < 16; ++w)
+        {
+            float pixelError = 0;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                const float difference = pixels[ i ][ c ] - palette[ w ][ c ];
+                pixelError += difference * difference;
+            }
+
+            if (pixelError < bestError)
+            {
+                bestError = pixelError;
+                outIndices[ i ] = w;
+            }
+        }
+
+        error += bestError;
+    }
+
+    return error;
+}
+
+struct BC7Mode6Endpoints
+{
+    int quantized[ 2 ][ 4 ];
+    int pBits[ 2 ];
+};
+
+/// Quantizes endpoints with the given p-bits, or with the p-bit closest to each endpoint if a p-bit is -1.
+static BC7Mode6Endpoints QuantizeBC7Endpoints( const float endpoint0[ 4 ], const float endpoint1[ 4 ], int pBit0, int pBit1 )
+{
+    BC7Mode6Endpoints endpoints;
+    const float* unquantized[ 2 ] = { endpoint0, endpoint1 };
+    const int pBits[ 2 ] = { pBit0, pBit1 };
+
+    for (int e = 0; e < 2; ++e)
+    {
+        float bestError = 1e30f;
+
+        for (int p = 0; p < 2; ++p)
+        {
+            if (pBits[ e ] != -1 && pBits[ e ] != p)
+            {
+                continue;
+            }
+
+            float error = 0;
+            int quantized[ 4 ];
+
+            for (int c = 0; c < 4; ++c)
+            {
+                quantized[ c ] = QuantizeBC7Channel( unquantized[ e ][ c ], p );
+                const float difference = unquantized[ e ][ c ] - GetBC7Value( quantized[ c ], p );
+                error += difference * difference;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                endpoints.pBits[ e ] = p;
+                std::copy( quantized, quantized + 4, endpoints.quantized[ e ] );
+            }
+        }
+    }
+
+    return endpoints;
+}
+
+static float FitBC7Mode6( const float pixels[ 16 ][ 4 ], const BC7Mode6Endpoints& endpoints, int outIndices[ 16 ] )
+{
+    int values[ 2 ][ 4 ];
+
+    for (int e = 0; e < 2; ++e)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            values[ e ][ c ] = GetBC7Value( endpoints.quantized[ e ][ c ], endpoints.pBits[ e ] );
+        }
+    }
+
+    return FitBC7Indices( pixels, values[ 0 ], values[ 1 ], outIndices );
+}
+
+/// Encodes all blocks in mode 6: one subset, 7-bit RGBA endpoints with a p-bit each and 4-bit indices.
+/// \param rgba 16 pixels, row by row.
+static void EncodeBC7Block( const unsigned char rgba[ 64 ], BCQuality quality, unsigned char* outBlock )
+{
+    float pixels[ 16 ][ 4 ];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            pixels[ i ][ c ] = rgba[ i * 4 + c ];
+        }
+    }
+
+    float endpoint0[ 4 ];
+    float endpoint1[ 4 ];
+
+    if (quality == BCQuality::Fast)
+    {
+        GetBoundingBoxEndpoints( pixels, 4, endpoint0, endpoint1 );
+    }
+    else
+    {
+        GetPrincipalEndpoints( pixels, 4, endpoint0, endpoint1 );
+    }
+
+    // High tries every p-bit combination, the others take the closest p-bits.
+    const int pBitCombinationCount = quality == BCQuality::High ? 4 : 1;
+    const int iterationCount = quality == BCQuality::Fast ? 0 : (quality == BCQuality::Normal ? 1 : 3);
+    float weights[ 16 ];
+
+    for (int w = 0; w < 16; ++w)
+    {
+        weights[ w ] = bc7Weights4[ w ] / 64.0f;
+    }
+
+    BC7Mode6Endpoints best = QuantizeBC7Endpoints( endpoint0, endpoint1, -1, -1 );
+    int indices[ 16 ];
+    float error = FitBC7Mode6( pixels, best, indices );
+
+    for (int iteration = 0; iteration <= iterationCount && error > 0; ++iteration)
+    {
+        if (iteration > 0 && !SolveEndpoints( pixels, 4, indices, weights, endpoint0, endpoint1 ))
+        {
+            break;
+        }
+
+        bool isImproved = false;
+
+        for (int combination = 0; combination < pBitCombinationCount; ++combination)
+        {
+            const BC7Mode6Endpoints candidate = pBitCombinationCount == 1 ? QuantizeBC7Endpoints( endpoint0, endpoint1, -1, -1 ) :
+                                                QuantizeBC7Endpoints( endpoint0, endpoint1, combination & 1, combination >> 1 );
+            int candidateIndices[ 16 ];
+            const float candidateError = FitBC7Mode6( pixels, candidate, candidateIndices );
+
+            if (candidateError < error)
+            {
+                error = candidateError;
+                best = candidate;
+                std::copy( candidateIndices, candidateIndices + 16, indices );
+                isImproved = true;
+            }
+        }
+
+        if (iteration > 0 && !isImproved)
+        {
+            break;
+        }
+    }
+
+    // Moves each channel of both endpoints one step at a time while the error gets lower.
+    bool isStepImproved = quality == BCQuality::High;
+
+    for (int pass = 0; pass < 4 && isStepImproved && error > 0; ++pass)
+    {
+        isStepImproved = false;
+
+        for (int candidate = 0; candidate < 16; ++candidate)
+        {
+            BC7Mode6Endpoints stepped = best;
+            int& value = stepped.quantized[ (candidate / 2) % 2 ][ candidate / 4 ];
+            value += (candidate & 1) ? 1 : -1;
+
+            if (value < 0 || value > 127)
+            {
+                continue;
+            }
+
+            int candidateIndices[ 16 ];
+            const float candidateError = FitBC7Mode6( pixels, stepped, candidateIndices );
+
+            if (candidateError < error)
+            {
+                error = candidateError;
+                best = stepped;
+                std::copy( candidateIndices, candidateIndices + 16, indices );
+                isStepImproved = true;
+            }
+        }
+    }
+
+    // The most significant bit of the first pixel's index is not stored, so it must be 0.
+    if (indices[ 0 ] >= 8)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            std::swap( best.quantized[ 0 ][ c ], best.quantized[ 1 ][ c ] );
+        }
+
+        std::swap( best.pBits[ 0 ], best.pBits[ 1 ] );
+
+        for (int i = 0; i < 16; ++i)
+        {
+            indices[ i ] = 15 - indices[ i ];
+        }
+    }
+
+    std::fill( outBlock, outBlock + 16, static_cast< unsigned char >( 0 ) );
+    BCBitWriter writer = { outBlock, 0 };
+    writer.Write( 1 << 6, 7 );
+
+    for (int c = 0; c < 4; ++c)
+    {
+        writer.Write( static_cast< unsigned >( best.quantized[ 0 ][ c ] ), 7 );
+        writer.Write( static_cast< unsigned >( best.quantized[ 1 ][ c ] ), 7 );
+    }
+
+    writer.Write( static_cast< unsigned >( best.pBits[ 0 ] ), 1 );
+    writer.Write( static_cast< unsigned >( best.pBits[ 1 ] ), 1 );
+
+    for (int i = 0; i < 16; ++i)
+    {
+        writer.Write( static_cast< unsigned >( indices[ i ] ), i == 0 ? 3 : 4 );
+    }
+}
+
+/// Decodes mode 6 blocks. Blocks in other modes are decoded as transparent black.
+static void DecodeBC7Block( const unsigned char* block, unsigned char outRgba[ 64 ] )
+{
+    std::fill( outRgba, outRgba + 64, static_cast< unsigned char >( 0 ) );
+
+    if (block[ 0 ] != (1 << 6) && (block[ 0 ] & 0x7F) != (1 << 6))
+    {
+        return;
+    }
+
+    BCBitReader reader = { block, 7 };
+    int endpoints[ 2 ][ 4 ];
+
+    for (int c = 0; c < 4; ++c)
+    {
+        endpoints[ 0 ][ c ] = static_cast< int >( reader.Read( 7 ) );
+        endpoints[ 1 ][ c ] = static_cast< int >( reader.Read( 7 ) );
+    }
+
+    const int pBit0 = static_cast< int >( reader.Read( 1 ) );
+    const int pBit1 = static_cast< int >( reader.Read( 1 ) );
+
+    for (int c = 0; c < 4; ++c)
+    {
+        endpoints[ 0 ][ c ] = GetBC7Value( endpoints[ 0 ][ c ], pBit0 );
+        endpoints[ 1 ][ c ] = GetBC7Value( endpoints[ 1 ][ c ], pBit1 );
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int weight = bc7Weights4[ reader.Read( i == 0 ? 3 : 4 ) ];
+
+        for (int c = 0; c < 4; ++c)
+        {
+            outRgba[ i * 4 + c ] = static_cast< unsigned char >( ((64 - weight) * endpoints[ 0 ][ c ] + weight * endpoints[ 1 ][ c ] + 32) >> 6 );
+        }
+    }
+}
+
+/// \param rgba 16 pixels, row by row.
+static void EncodeBCBlock( BCFormat format, BCQuality quality, const unsigned char rgba[ 64 ], unsigned char* outBlock )
+{
+    unsigned char channel[ 16 ];
+
+    switch (format)
+    {
+    case BCFormat::BC1:
+        EncodeBC1Block( rgba, quality, outBlock );
+        break;
+    case BCFormat::BC3:
+        for (int i = 0; i < 16; ++i)
+        {
+            channel[ i ] = rgba[ i * 4 + 3 ];
+        }
+
+        EncodeBC4Block( channel, quality, outBlock );
+        EncodeBC1Block( rgba, quality, outBlock + 8 );
+        break;
+    case BCFormat::BC4:
+    case BCFormat::BC5:
+        for (int c = 0; c < (format == BCFormat::BC4 ? 1 : 2); ++c)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                channel[ i ] = rgba[ i * 4 + c ];
+            }
+
+            EncodeBC4Block( channel, quality, outBlock + c * 8 );
+        }
+        break;
+    case BCFormat::BC7:
+        EncodeBC7Block( rgba, quality, outBlock );
+        break;
+    }
+}
+
+/// Decodes a block into RGBA like GPUs do. Channels that the format doesn't store are 0, alpha is 255.
+static void DecodeBCBlock( BCFormat format, const unsigned char* block, unsigned char outRgba[ 64 ] )
+{
+    switch (format)
+    {
+    case BCFormat::BC1:
+        DecodeBC1Block( block, outRgba );
+        break;
+    case BCFormat::BC3:
+        DecodeBC1Block( block + 8, outRgba );
+        DecodeBC4Block( block, outRgba + 3, 4 );
+        break;
+    case BCFormat::BC4:
+    case BCFormat::BC5:
+        for (int i = 0; i < 16; ++i)
+        {
+            outRgba[ i * 4 + 1 ] = 0;
+            outRgba[ i * 4 + 2 ] = 0;
+            outRgba[ i * 4 + 3 ] = 255;
+        }
+
+        DecodeBC4Block( block, outRgba, 4 );
+
+        if (format == BCFormat::BC5)
+        {
+            DecodeBC4Block( block + 8, outRgba + 1, 4 );
+        }
+        break;
+    case BCFormat::BC7:
+        DecodeBC7Block( block, outRgba );
+        break;
+    }
+}
+
+/// Compresses an RGBA8 image on all cores. Blocks on the right and bottom edges repeat the last column and row if the size is not a multiple of 4.
+/// \return Blocks row by row.
+static std::vector< unsigned char > CompressBC( const unsigned char* rgba, int width, int height, BCFormat format, BCQuality quality )
+{
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const int blockSize = GetBCBlockSize( format );
+    std::vector< unsigned char > blocks( static_cast< std::size_t >( blocksX ) * blocksY * blockSize );
+    std::atomic< int > nextBlockRow( 0 );
+
+    auto compressBlockRows = [&]()
+    {
+        unsigned char blockPixels[ 64 ];
+
+        for (int by = nextBlockRow++; by < blocksY; by = nextBlockRow++)
+        {
+            for (int bx = 0; bx < blocksX; ++bx)
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    const int x = std::min( bx * 4 + i % 4, width - 1 );
+                    const int y = std::min( by * 4 + i / 4, height - 1 );
+                    std::copy( rgba + (y * width + x) * 4, rgba + (y * width + x) * 4 + 4, blockPixels + i * 4 );
+                }
+
+                EncodeBCBlock( format, quality, blockPixels, &blocks[ (static_cast< std::size_t >( by ) * blocksX + bx) * blockSize ] );
+            }
+        }
+    };
+
+    std::vector< std::thread > threads;
+
+    for (unsigned t = 1; t < std::thread::hardware_concurrency(); ++t)
+    {
+        threads.emplace_back( compressBlockRows );
+    }
+
+    compressBlockRows();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    return blocks;
+}
+
+/// \return RGBA8 image.
+static std::vector< unsigned char > DecompressBC( const unsigned char* blocks, int width, int height, BCFormat format )
+{
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const int blockSize = GetBCBlockSize( format );
+    std::vector< unsigned char > rgba( static_cast< std::size_t >( width ) * height * 4 );
+    unsigned char blockPixels[ 64 ];
+
+    for (int by = 0; by < blocksY; ++by)
+    {
+        for (int bx = 0; bx < blocksX; ++bx)
+        {
+            DecodeBCBlock( format, blocks + (static_cast< std::size_t >( by ) * blocksX + bx) * blockSize, blockPixels );
+
+            for (int i = 0; i < 16; ++i)
+            {
+                const int x = bx * 4 + i % 4;
+                const int y = by * 4 + i / 4;
+
+                if (x < width && y < height)
+                {
+                    std::copy( blockPixels + i * 4, blockPixels + i * 4 + 4, &rgba[ (static_cast< std::size_t >( y ) * width + x) * 4 ] );
+                }
+            }
+        }
+    }
+
+    return rgba;
+}
+
+/// \return Peak signal-to-noise ratio in dB of the first channelCount channels of two RGBA8 images, or 99 if they are equal.
+static double GetPSNR( const unsigned char* rgba0, const unsigned char* rgba1, int pixelCount, int channelCount )
+{
+    double squaredError = 0;
+
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        for (int c = 0; c < channelCount; ++c)
+        {
+            const double difference = static_cast< double >( rgba0[ i * 4 + c ] ) - rgba1[ i * 4 + c ];
+            squaredError += difference * difference;
+        }
+    }
+
+    const double meanSquaredError = squaredError / (static_cast< double >( pixelCount ) * channelCount);
+    return meanSquaredError > 0 ? 10 * std::log10( 255.0 * 255.0 / meanSquaredError ) : 99;
+}
+
+/// \return BC3 if the image has alpha, BC4 if it's grayscale, BC5 if it looks like a tangent-space normal map and BC1 otherwise.
+static BCFormat ChooseBCFormat( const unsigned char* rgba, int pixelCount )
+{
+    bool isGray = true;
+    bool hasAlpha = false;
+    int normalCount = 0;
+
+    for (int i = 0; i < pixelCount; ++i)
+    {
+        const unsigned char* pixel = rgba + i * 4;
+        isGray &= pixel[ 0 ] == pixel[ 1 ] && pixel[ 1 ] == pixel[ 2 ];
+        hasAlpha |= pixel[ 3 ] < 255;
+
+        const float x = pixel[ 0 ] / 127.5f - 1;
+        const float y = pixel[ 1 ] / 127.5f - 1;
+        const float z = pixel[ 2 ] / 127.5f - 1;
+        const float lengthSquared = x * x + y * y + z * z;
+        normalCount += (z > 0 && lengthSquared > 0.8f && lengthSquared < 1.2f) ? 1 : 0;
+    }
+
+    if (hasAlpha)
+    {
+        return BCFormat::BC3;
+    }
+
+    if (isGray)
+    {
+        return BCFormat::BC4;
+    }
+
+    return normalCount >= pixelCount - pixelCount / 20 ? BCFormat::BC5 : BCFormat::BC1;
+}
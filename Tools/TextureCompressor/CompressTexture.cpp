@@ -0,0 +1,215 @@
+/**
+  Compresses an image and its mip levels into a block-compressed .dds file with a DX10 header. Uses all cores.
+
+  Usage: CompressTexture input.png output.dds [-format auto|bc1|bc3|bc4|bc5|bc7] [-quality fast|normal|high] [-srgb] [-nomips]
+
+  -format auto picks BC4 for grayscale images, BC5 for tangent-space normal maps, BC3 for images with alpha and BC1 for others.
+  -quality trades speed for quality, default is normal.
+  -srgb marks the texture as sRGB and filters its mip levels in linear space, use it for albedo and other color textures.
+  -nomips writes only level 0.
+
+  Prints PSNR of level 0 in dB so quality and formats can be compared.
+*/
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "BCEncoder.hpp"
+#include "MipGenerator.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.c"
+
+static const char* GetFormatName( BCFormat format )
+{
+    const char* names[] = { "BC1", "BC3", "BC4", "BC5", "BC7" };
+    return names[ static_cast< int >( format ) ];
+}
+
+static std::uint32_t GetDXGIFormat( BCFormat format, bool isSRGB )
+{
+    switch (format)
+    {
+    case BCFormat::BC1: return isSRGB ? 72 : 71;
+    case BCFormat::BC3: return isSRGB ? 78 : 77;
+    case BCFormat::BC4: return 80;
+    case BCFormat::BC5: return 83;
+    case BCFormat::BC7: return isSRGB ? 99 : 98;
+    }
+
+    return 0;
+}
+
+static void WriteDDSUint( std::ofstream& file, std::uint32_t value )
+{
+    file.write( reinterpret_cast< const char* >( &value ), sizeof( value ) );
+}
+
+/// Writes compressed levels into a .dds file that has a DX10 header.
+/// \param mipLevels Blocks of each level, starting from the largest.
+/// \return True if the file was written.
+static bool WriteBCDDSFile( const char* path, int width, int height, BCFormat format, bool isSRGB, const std::vector< std::vector< unsigned char > >& mipLevels )
+{
+    std::ofstream file( path, std::ios::binary );
+
+    if (!file || mipLevels.empty())
+    {
+        return false;
+    }
+
+    const std::uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+    const std::uint32_t DDPF_FOURCC = 0x4;
+    const std::uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+    const std::uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+    const bool hasMips = mipLevels.size() > 1;
+
+    file.write( "DDS ", 4 );
+    WriteDDSUint( file, 124 );
+    WriteDDSUint( file, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | (hasMips ? DDSD_MIPMAPCOUNT : 0) );
+    WriteDDSUint( file, static_cast< std::uint32_t >( height ) );
+    WriteDDSUint( file, static_cast< std::uint32_t >( width ) );
+    WriteDDSUint( file, static_cast< std::uint32_t >( mipLevels[ 0 ].size() ) );
+    WriteDDSUint( file, 0 );
+    WriteDDSUint( file, static_cast< std::uint32_t >( mipLevels.size() ) );
+
+    for (int i = 0; i < 11; ++i)
+    {
+        WriteDDSUint( file, 0 );
+    }
+
+    WriteDDSUint( file, 32 );
+    WriteDDSUint( file, DDPF_FOURCC );
+    file.write( "DX10", 4 );
+
+    for (int i = 0; i < 5; ++i)
+    {
+        WriteDDSUint( file, 0 );
+    }
+
+    WriteDDSUint( file, DDSCAPS_TEXTURE | (hasMips ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0) );
+
+    for (int i = 0; i < 4; ++i)
+    {
+        WriteDDSUint( file, 0 );
+    }
+
+    WriteDDSUint( file, GetDXGIFormat( format, isSRGB ) );
+    WriteDDSUint( file, D3D10_RESOURCE_DIMENSION_TEXTURE2D );
+    WriteDDSUint( file, 0 );
+    WriteDDSUint( file, 1 );
+    WriteDDSUint( file, 0 );
+
+    for (const auto& level : mipLevels)
+    {
+        file.write( reinterpret_cast< const char* >( level.data() ), level.size() );
+    }
+
+    return static_cast< bool >( file );
+}
+
+int main( int argCount, char* args[] )
+{
+    if (argCount < 3)
+    {
+        std::cout << "Usage: CompressTexture input.png output.dds [-format auto|bc1|bc3|bc4|bc5|bc7] [-quality fast|normal|high] [-srgb] [-nomips]" << std::endl;
+        return 1;
+    }
+
+    bool isFormatAuto = true;
+    BCFormat format = BCFormat::BC1;
+    BCQuality quality = BCQuality::Normal;
+    bool isSRGB = false;
+    bool generateMips = true;
+
+    for (int i = 3; i < argCount; ++i)
+    {
+        const std::string option = args[ i ];
+        const std::string value = i + 1 < argCount ? args[ i + 1 ] : "";
+
+        if (option == "-format" && (value == "auto" || value == "bc1" || value == "bc3" || value == "bc4" || value == "bc5" || value == "bc7"))
+        {
+            const BCFormat formats[] = { BCFormat::BC1, BCFormat::BC3, BCFormat::BC4, BCFormat::BC5, BCFormat::BC7 };
+            isFormatAuto = value == "auto";
+            format = isFormatAuto ? format : formats[ std::string( "13457" ).find( value[ 2 ] ) ];
+            ++i;
+        }
+        else if (option == "-quality" && (value == "fast" || value == "normal" || value == "high"))
+        {
+            quality = value == "fast" ? BCQuality::Fast : (value == "normal" ? BCQuality::Normal : BCQuality::High);
+            ++i;
+        }
+        else if (option == "-srgb")
+        {
+            isSRGB = true;
+        }
+        else if (option == "-nomips")
+        {
+            generateMips = false;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    int width, height, components;
+    unsigned char* pixels = stbi_load( args[ 1 ], &width, &height, &components, 4 );
+
+    if (pixels == nullptr)
+    {
+        std::cerr << "Failed to load " << args[ 1 ] << ". Reason: " << stbi_failure_reason() << std::endl;
+        return 1;
+    }
+
+    if (isFormatAuto)
+    {
+        format = ChooseBCFormat( pixels, width * height );
+    }
+
+    // Only color formats have sRGB variants.
+    isSRGB &= format == BCFormat::BC1 || format == BCFormat::BC3 || format == BCFormat::BC7;
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    ae3d::MipGenerator::Settings settings;
+    settings.isSRGB = isSRGB;
+    const int mipCount = generateMips ? ae3d::MipGenerator::GetMipCount( width, height ) : 1;
+    std::vector< unsigned char > mipChain( generateMips ? ae3d::MipGenerator::GetMipChainSize( width, height ) : width * height * 4 );
+
+    if (generateMips)
+    {
+        ae3d::MipGenerator::Generate( pixels, width, height, settings, mipChain.data() );
+    }
+    else
+    {
+        std::copy( pixels, pixels + width * height * 4, mipChain.begin() );
+    }
+
+    stbi_image_free( pixels );
+
+    std::vector< std::vector< unsigned char > > mipLevels;
+
+    for (int mipIndex = 0; mipIndex < mipCount; ++mipIndex)
+    {
+        const int mipWidth = std::max( width >> mipIndex, 1 );
+        const int mipHeight = std::max( height >> mipIndex, 1 );
+        mipLevels.push_back( CompressBC( &mipChain[ ae3d::MipGenerator::GetMipOffset( width, height, mipIndex ) ], mipWidth, mipHeight, format, quality ) );
+    }
+
+    const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - startTime ).count();
+
+    if (!WriteBCDDSFile( args[ 2 ], width, height, format, isSRGB, mipLevels ))
+    {
+        std::cerr << "Could not write " << args[ 2 ] << std::endl;
+        return 1;
+    }
+
+    const std::vector< unsigned char > decompressed = DecompressBC( mipLevels[ 0 ].data(), width, height, format );
+    const double psnr = GetPSNR( mipChain.data(), decompressed.data(), width * height, GetBCChannelCount( format ) );
+
+    std::printf( "Wrote %dx%d %s%s with %d mip levels into %s in %.2f s. Level 0 PSNR: %.2f dB\n", width, height, GetFormatName( format ),
+                 isSRGB ? " sRGB" : "", mipCount, args[ 2 ], seconds, psnr );
+    return 0;
+}
@@ -6,14 +6,18 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <string>
 #include <vector>
 #include "Matrix.hpp"
 #include "Vec3.hpp"
+#include "VertexQuantization.hpp"
 
 // Cache optimization code adapted from http://gameangst.com/wp-content/uploads/2009/03/forsythtriangleorderoptimizer.cpp
 
@@ -71,6 +75,64 @@ struct VertexInd
     unsigned short a, b, c;
 };
 
+// Triangle cluster. Written into CLUS chunks, layout matches ae3d::MeshCluster.
+struct Cluster
+{
+    ae3d::Vec3 center;
+    float radius;
+    ae3d::Vec3 coneAxis;
+    float coneCutoff; // Cosine of the cone's half-angle. <= 0 disables backface culling.
+    uint32_t firstFace;
+    uint32_t faceCount;
+};
+
+// Detail level. Written into LODS chunks, layout matches ae3d::MeshLod.
+struct Lod
+{
+    uint32_t firstFace;
+    uint32_t faceCount;
+    float error; // Largest collapse error in object space units.
+};
+
+// Symmetric 4x4 error quadric that sums squared distances to planes, see
+// Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics".
+struct Quadric
+{
+    void AddPlane( const ae3d::Vec3& normal, float distance, float weight )
+    {
+        const double a = normal.x, b = normal.y, c = normal.z, d = distance;
+        a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+        b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+        c2 += weight * c * c; cd += weight * c * d;
+        d2 += weight * d * d;
+        totalWeight += weight;
+    }
+
+    void Add( const Quadric& q )
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        totalWeight += q.totalWeight;
+    }
+
+    double Evaluate( const ae3d::Vec3& p ) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double result = x * x * a2 + 2 * x * y * ab + 2 * x * z * ac + 2 * x * ad +
+                              y * y * b2 + 2 * y * z * bc + 2 * y * bd +
+                              z * z * c2 + 2 * z * cd + d2;
+        return result > 0 ? result : 0;
+    }
+
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+    double totalWeight = 0;
+};
+
+const unsigned MaxClusterFaces = 124;
+const unsigned MaxClusterVertices = 64;
+
 enum class VertexFormat { PTNTC_Skinned, PTNTC, PTN };
 
 struct VertexPTNTC_Skinned
@@ -144,6 +206,8 @@ struct Mesh
     void CopyInterleavedVerticesToPTNTC();
     
     void OptimizeFaces(); // Implements https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+    void BuildClusters();
+    void GenerateLods( unsigned lodCount );
     bool ComputeVertexScores();
 
     bool AlmostEquals( const ae3d::Vec3& v1, const ae3d::Vec3& v2 ) const;
@@ -167,6 +231,10 @@ struct Mesh
     std::vector< VertexPTNTC > interleavedVerticesPTNTC;
     std::vector< VertexPTN > interleavedVerticesPTN;
     std::vector< VertexInd > indices;
+    // LOD 0 faces in indices are grouped by these.
+    std::vector< Cluster > clusters;
+    // Coarser detail levels are appended to indices. Empty if there's only one level.
+    std::vector< Lod > lods;
 
     // Used to calculate tangent-space handedness.
     std::vector< ae3d::Vec3 > bitangents;  // For faces.
@@ -312,6 +380,9 @@ bool Mesh::ComputeVertexScores()
 
 void Mesh::OptimizeFaces()
 {
+    static const bool areVertexScoresComputed = ComputeVertexScores();
+    (void)areVertexScoresComputed;
+
     verticesWithCachedata.resize( interleavedVertices.size() );
 
     for (std::size_t i = 0; i < interleavedVertices.size(); ++i)
@@ -637,6 +708,635 @@ void Mesh::SolveFaceNormals()
     }
 }
 
+// Returns an id for each vertex. Vertices with the same position have the same id.
+static std::vector< unsigned > WeldPositions( const std::vector< VertexPTNTC_Skinned >& vertices )
+{
+    std::vector< unsigned > sortedVertices( vertices.size() );
+
+    for (unsigned v = 0; v < vertices.size(); ++v)
+    {
+        sortedVertices[ v ] = v;
+    }
+
+    auto less = [&vertices]( unsigned a, unsigned b )
+    {
+        const ae3d::Vec3& pa = vertices[ a ].position;
+        const ae3d::Vec3& pb = vertices[ b ].position;
+        return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z);
+    };
+
+    std::sort( sortedVertices.begin(), sortedVertices.end(), less );
+    std::vector< unsigned > positionIds( vertices.size() );
+    unsigned id = 0;
+
+    for (std::size_t i = 0; i < sortedVertices.size(); ++i)
+    {
+        if (i > 0 && less( sortedVertices[ i - 1 ], sortedVertices[ i ] ))
+        {
+            ++id;
+        }
+
+        positionIds[ sortedVertices[ i ] ] = id;
+    }
+
+    return positionIds;
+}
+
+static void SolveClusterBounds( const std::vector< VertexPTNTC_Skinned >& vertices, const VertexInd* faces, Cluster& cluster )
+{
+    const float maxValue = 99999999.0f;
+    ae3d::Vec3 minCorner(  maxValue,  maxValue,  maxValue );
+    ae3d::Vec3 maxCorner( -maxValue, -maxValue, -maxValue );
+
+    for (uint32_t f = 0; f < cluster.faceCount; ++f)
+    {
+        for (unsigned short v : { faces[ f ].a, faces[ f ].b, faces[ f ].c })
+        {
+            minCorner = ae3d::Vec3::Min2( minCorner, vertices[ v ].position );
+            maxCorner = ae3d::Vec3::Max2( maxCorner, vertices[ v ].position );
+        }
+    }
+
+    cluster.center = (minCorner + maxCorner) * 0.5f;
+    cluster.radius = 0;
+
+    // Face normals are oriented by vertex normals, so the cone doesn't depend on the winding convention.
+    std::vector< ae3d::Vec3 > normals;
+    normals.reserve( cluster.faceCount );
+    ae3d::Vec3 axis;
+
+    for (uint32_t f = 0; f < cluster.faceCount; ++f)
+    {
+        const VertexPTNTC_Skinned& a = vertices[ faces[ f ].a ];
+        const VertexPTNTC_Skinned& b = vertices[ faces[ f ].b ];
+        const VertexPTNTC_Skinned& c = vertices[ faces[ f ].c ];
+
+        for (const VertexPTNTC_Skinned* vertex : { &a, &b, &c })
+        {
+            cluster.radius = std::max( cluster.radius, (vertex->position - cluster.center).Length() );
+        }
+
+        ae3d::Vec3 normal = ae3d::Vec3::Cross( b.position - a.position, c.position - a.position );
+        const float length = normal.Length();
+
+        // Degenerate faces are never rasterized.
+        if (length <= 0)
+        {
+            continue;
+        }
+
+        normal = normal * (1.0f / length);
+
+        if (ae3d::Vec3::Dot( normal, a.normal + b.normal + c.normal ) < 0)
+        {
+            normal = -normal;
+        }
+
+        normals.push_back( normal );
+        axis += normal;
+    }
+
+    cluster.coneAxis = ae3d::Vec3( 0, 0, 1 );
+    cluster.coneCutoff = -1;
+
+    if (axis.Length() < 0.0001f)
+    {
+        return;
+    }
+
+    cluster.coneAxis = axis.Normalized();
+    cluster.coneCutoff = 1;
+
+    for (const auto& normal : normals)
+    {
+        cluster.coneCutoff = std::min( cluster.coneCutoff, ae3d::Vec3::Dot( cluster.coneAxis, normal ) );
+    }
+
+    // Keeps the cone conservative when the file is read back.
+    cluster.coneCutoff -= 0.0001f;
+}
+
+/**
+ Groups faces into clusters of at most MaxClusterFaces faces and MaxClusterVertices vertices
+ for per-cluster culling, and reorders faces so that each cluster is contiguous.
+ Clusters grow breadth-first over faces sharing a vertex position, so UV and normal seams don't split them.
+ */
+void Mesh::BuildClusters()
+{
+    clusters.clear();
+
+    const std::size_t faceCount = indices.size();
+    const std::size_t vertexCount = interleavedVertices.size();
+
+    if (faceCount == 0)
+    {
+        return;
+    }
+
+    const std::vector< unsigned > positionIds = WeldPositions( interleavedVertices );
+
+    // Faces using each position, in compressed rows.
+    std::vector< unsigned > positionFaceStart( vertexCount + 1, 0 );
+
+    for (const auto& face : indices)
+    {
+        ++positionFaceStart[ positionIds[ face.a ] + 1 ];
+        ++positionFaceStart[ positionIds[ face.b ] + 1 ];
+        ++positionFaceStart[ positionIds[ face.c ] + 1 ];
+    }
+
+    for (std::size_t p = 0; p < vertexCount; ++p)
+    {
+        positionFaceStart[ p + 1 ] += positionFaceStart[ p ];
+    }
+
+    std::vector< unsigned > positionFaces( faceCount * 3 );
+    {
+        std::vector< unsigned > cursor( positionFaceStart.begin(), positionFaceStart.end() - 1 );
+
+        for (unsigned f = 0; f < faceCount; ++f)
+        {
+            positionFaces[ cursor[ positionIds[ indices[ f ].a ] ]++ ] = f;
+            positionFaces[ cursor[ positionIds[ indices[ f ].b ] ]++ ] = f;
+            positionFaces[ cursor[ positionIds[ indices[ f ].c ] ]++ ] = f;
+        }
+    }
+
+    std::vector< bool > isFaceAssigned( faceCount, false );
+    std::vector< unsigned > vertexCluster( vertexCount, std::numeric_limits< unsigned >::max() );
+    std::vector< unsigned > faceOrder;
+    faceOrder.reserve( faceCount );
+    std::vector< unsigned > frontier;
+    unsigned nextUnassignedFace = 0;
+
+    while (faceOrder.size() < faceCount)
+    {
+        const unsigned clusterIndex = (unsigned)clusters.size();
+        Cluster cluster = {};
+        cluster.firstFace = (uint32_t)faceOrder.size();
+        unsigned clusterVertexCount = 0;
+        std::size_t frontierHead = 0;
+        frontier.clear();
+
+        while (cluster.faceCount < MaxClusterFaces && faceOrder.size() < faceCount)
+        {
+            unsigned face = 0;
+            bool isFromFrontier = false;
+
+            while (frontierHead < frontier.size() && !isFromFrontier)
+            {
+                face = frontier[ frontierHead++ ];
+                isFromFrontier = !isFaceAssigned[ face ];
+            }
+
+            if (!isFromFrontier)
+            {
+                // Disconnected part, continues from the next face in cache-optimized order.
+                while (isFaceAssigned[ nextUnassignedFace ])
+                {
+                    ++nextUnassignedFace;
+                }
+
+                face = nextUnassignedFace;
+            }
+
+            const unsigned short faceVertices[ 3 ] = { indices[ face ].a, indices[ face ].b, indices[ face ].c };
+            unsigned newVertexCount = 0;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                const bool isDuplicate = (i > 0 && faceVertices[ i ] == faceVertices[ 0 ]) || (i > 1 && faceVertices[ i ] == faceVertices[ 1 ]);
+
+                if (vertexCluster[ faceVertices[ i ] ] != clusterIndex && !isDuplicate)
+                {
+                    ++newVertexCount;
+                }
+            }
+
+            if (clusterVertexCount + newVertexCount > MaxClusterVertices)
+            {
+                if (isFromFrontier)
+                {
+                    continue;
+                }
+
+                break;
+            }
+
+            clusterVertexCount += newVertexCount;
+            isFaceAssigned[ face ] = true;
+            faceOrder.push_back( face );
+            ++cluster.faceCount;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                vertexCluster[ faceVertices[ i ] ] = clusterIndex;
+                const unsigned position = positionIds[ faceVertices[ i ] ];
+
+                for (unsigned j = positionFaceStart[ position ]; j < positionFaceStart[ position + 1 ]; ++j)
+                {
+                    if (!isFaceAssigned[ positionFaces[ j ] ])
+                    {
+                        frontier.push_back( positionFaces[ j ] );
+                    }
+                }
+            }
+        }
+
+        clusters.push_back( cluster );
+    }
+
+    std::vector< VertexInd > clusteredIndices( faceCount );
+    std::vector< ae3d::Vec3 > clusteredNormals( fnormal.size() == faceCount ? faceCount : 0 );
+
+    for (std::size_t f = 0; f < faceCount; ++f)
+    {
+        clusteredIndices[ f ] = indices[ faceOrder[ f ] ];
+
+        if (!clusteredNormals.empty())
+        {
+            clusteredNormals[ f ] = fnormal[ faceOrder[ f ] ];
+        }
+    }
+
+    indices.swap( clusteredIndices );
+
+    if (!clusteredNormals.empty())
+    {
+        fnormal.swap( clusteredNormals );
+    }
+
+    // Quantized positions can move by half a step on each axis.
+    const float quantizationError = ((aabbMax - aabbMin) * (0.5f / 32767.0f)).Length();
+
+    for (auto& cluster : clusters)
+    {
+        SolveClusterBounds( interleavedVertices, &indices[ cluster.firstFace ], cluster );
+        cluster.radius += quantizationError;
+    }
+}
+
+static bool ContainsVertex( const VertexInd& face, unsigned short vertex )
+{
+    return face.a == vertex || face.b == vertex || face.c == vertex;
+}
+
+/**
+ Collapses edges until there are at most targetFaceCount faces or no edge can be collapsed.
+ A vertex is collapsed into one of its neighbors, so the result indexes the same vertex buffer.
+ \param vertices Vertices.
+ \param isLocked Vertices that must not be collapsed, e.g. on seams and borders.
+ \param quadrics Vertex quadrics. Collapsed vertices' quadrics are added to their targets.
+ \param faces Faces to simplify.
+ \param targetFaceCount Target face count.
+ \param inOutError Largest collapse error, in object space units.
+ \return Simplified faces.
+ */
+static std::vector< VertexInd > SimplifyFaces( const std::vector< VertexPTNTC_Skinned >& vertices, const std::vector< bool >& isLocked, std::vector< Quadric >& quadrics,
+                                               const std::vector< VertexInd >& faces, std::size_t targetFaceCount, float& inOutError )
+{
+    struct Collapse
+    {
+        double cost;
+        unsigned short from, to;
+    };
+
+    std::vector< VertexInd > result = faces;
+    std::vector< unsigned > vertexFaceStart;
+    std::vector< unsigned > vertexFaces;
+    std::vector< Collapse > collapses;
+    std::vector< unsigned short > collapseTarget( vertices.size() );
+    std::vector< bool > isTouched( vertices.size() );
+    std::vector< unsigned short > fromNeighbors, toNeighbors;
+
+    // Each pass collapses edges that don't share faces, so the collapses don't affect each other.
+    while (result.size() > targetFaceCount)
+    {
+        vertexFaceStart.assign( vertices.size() + 1, 0 );
+
+        for (const auto& face : result)
+        {
+            ++vertexFaceStart[ face.a + 1 ];
+            ++vertexFaceStart[ face.b + 1 ];
+            ++vertexFaceStart[ face.c + 1 ];
+        }
+
+        for (std::size_t v = 0; v < vertices.size(); ++v)
+        {
+            vertexFaceStart[ v + 1 ] += vertexFaceStart[ v ];
+        }
+
+        vertexFaces.resize( result.size() * 3 );
+        std::vector< unsigned > cursor( vertexFaceStart.begin(), vertexFaceStart.end() - 1 );
+
+        for (unsigned f = 0; f < result.size(); ++f)
+        {
+            vertexFaces[ cursor[ result[ f ].a ]++ ] = f;
+            vertexFaces[ cursor[ result[ f ].b ]++ ] = f;
+            vertexFaces[ cursor[ result[ f ].c ]++ ] = f;
+        }
+
+        collapses.clear();
+
+        for (const auto& face : result)
+        {
+            const unsigned short faceVertices[ 3 ] = { face.a, face.b, face.c };
+
+            for (int e = 0; e < 3; ++e)
+            {
+                const unsigned short v0 = faceVertices[ e ];
+                const unsigned short v1 = faceVertices[ (e + 1) % 3 ];
+
+                for (int direction = 0; direction < 2; ++direction)
+                {
+                    const unsigned short from = direction == 0 ? v0 : v1;
+                    const unsigned short to = direction == 0 ? v1 : v0;
+
+                    if (from != to && !isLocked[ from ])
+                    {
+                        Quadric q = quadrics[ from ];
+                        q.Add( quadrics[ to ] );
+                        collapses.push_back( { q.Evaluate( vertices[ to ].position ), from, to } );
+                    }
+                }
+            }
+        }
+
+        std::sort( collapses.begin(), collapses.end(), []( const Collapse& c1, const Collapse& c2 ) { return c1.cost < c2.cost; } );
+
+        for (std::size_t v = 0; v < vertices.size(); ++v)
+        {
+            collapseTarget[ v ] = (unsigned short)v;
+            isTouched[ v ] = false;
+        }
+
+        std::size_t removedFaceCount = 0;
+
+        for (const auto& collapse : collapses)
+        {
+            if (result.size() - removedFaceCount <= targetFaceCount)
+            {
+                break;
+            }
+
+            if (isTouched[ collapse.from ] || isTouched[ collapse.to ])
+            {
+                continue;
+            }
+
+            const ae3d::Vec3& toPosition = vertices[ collapse.to ].position;
+            bool isValid = true;
+            unsigned sharedFaceCount = 0;
+            fromNeighbors.clear();
+            toNeighbors.clear();
+
+            for (unsigned i = vertexFaceStart[ collapse.from ]; i < vertexFaceStart[ collapse.from + 1 ] && isValid; ++i)
+            {
+                const VertexInd& face = result[ vertexFaces[ i ] ];
+                fromNeighbors.insert( fromNeighbors.end(), { face.a, face.b, face.c } );
+
+                if (ContainsVertex( face, collapse.to ))
+                {
+                    ++sharedFaceCount;
+                    continue;
+                }
+
+                // Rejects collapses that flip or nearly flip a face.
+                const ae3d::Vec3 p[ 3 ] = { vertices[ face.a ].position, vertices[ face.b ].position, vertices[ face.c ].position };
+                const ae3d::Vec3 newP[ 3 ] = { face.a == collapse.from ? toPosition : p[ 0 ], face.b == collapse.from ? toPosition : p[ 1 ], face.c == collapse.from ? toPosition : p[ 2 ] };
+                const ae3d::Vec3 oldNormal = ae3d::Vec3::Cross( p[ 1 ] - p[ 0 ], p[ 2 ] - p[ 0 ] );
+                const ae3d::Vec3 newNormal = ae3d::Vec3::Cross( newP[ 1 ] - newP[ 0 ], newP[ 2 ] - newP[ 0 ] );
+                isValid = ae3d::Vec3::Dot( oldNormal, newNormal ) > 0.25f * oldNormal.Length() * newNormal.Length();
+            }
+
+            for (unsigned i = vertexFaceStart[ collapse.to ]; i < vertexFaceStart[ collapse.to + 1 ]; ++i)
+            {
+                const VertexInd& face = result[ vertexFaces[ i ] ];
+                toNeighbors.insert( toNeighbors.end(), { face.a, face.b, face.c } );
+            }
+
+            // Link condition: the only vertices adjacent to both ends are the ones opposite the edge.
+            // Otherwise the collapse would make the surface non-manifold.
+            std::sort( fromNeighbors.begin(), fromNeighbors.end() );
+            fromNeighbors.erase( std::unique( fromNeighbors.begin(), fromNeighbors.end() ), fromNeighbors.end() );
+            std::sort( toNeighbors.begin(), toNeighbors.end() );
+            toNeighbors.erase( std::unique( toNeighbors.begin(), toNeighbors.end() ), toNeighbors.end() );
+            std::vector< unsigned short > commonNeighbors;
+            std::set_intersection( fromNeighbors.begin(), fromNeighbors.end(), toNeighbors.begin(), toNeighbors.end(), std::back_inserter( commonNeighbors ) );
+
+            if (!isValid || sharedFaceCount == 0 || commonNeighbors.size() != sharedFaceCount + 2)
+            {
+                continue;
+            }
+
+            collapseTarget[ collapse.from ] = collapse.to;
+            removedFaceCount += sharedFaceCount;
+
+            for (unsigned short v : fromNeighbors)
+            {
+                isTouched[ v ] = true;
+            }
+
+            const double weight = quadrics[ collapse.from ].totalWeight + quadrics[ collapse.to ].totalWeight;
+            inOutError = std::max( inOutError, weight > 0 ? (float)std::sqrt( collapse.cost / weight ) : 0.0f );
+            quadrics[ collapse.to ].Add( quadrics[ collapse.from ] );
+        }
+
+        if (removedFaceCount == 0)
+        {
+            break;
+        }
+
+        std::size_t faceCount = 0;
+
+        for (const auto& face : result)
+        {
+            const VertexInd collapsed = { collapseTarget[ face.a ], collapseTarget[ face.b ], collapseTarget[ face.c ] };
+
+            if (collapsed.a != collapsed.b && collapsed.b != collapsed.c && collapsed.a != collapsed.c)
+            {
+                result[ faceCount++ ] = collapsed;
+            }
+        }
+
+        result.resize( faceCount );
+    }
+
+    return result;
+}
+
+/**
+ Generates up to lodCount coarser detail levels, each with about half the faces of the previous one,
+ and appends them to indices. Vertices on UV, normal and other attribute seams and on open borders are kept,
+ so the levels don't crack or stretch textures.
+ */
+void Mesh::GenerateLods( unsigned lodCount )
+{
+    lods.clear();
+
+    if (lodCount == 0 || indices.empty())
+    {
+        return;
+    }
+
+    const std::size_t vertexCount = interleavedVertices.size();
+    const std::vector< unsigned > positionIds = WeldPositions( interleavedVertices );
+
+    // Interleave() can duplicate vertices that differ only by their per-face tangent. Simplification uses one vertex of
+    // each duplicate set, so only real normal, texture coordinate, color and skin seams are locked.
+    auto hasSameAttributes = [this]( const VertexPTNTC_Skinned& v1, const VertexPTNTC_Skinned& v2 )
+    {
+        return AlmostEquals( v1.normal, v2.normal ) && AlmostEquals( v1.texCoord, v2.texCoord ) && AlmostEquals( v1.color, v2.color ) &&
+               AlmostEquals( v1.weights, v2.weights ) && std::equal( std::begin( v1.bones ), std::end( v1.bones ), std::begin( v2.bones ) );
+    };
+
+    std::vector< unsigned > sortedVertices( vertexCount );
+
+    for (unsigned v = 0; v < vertexCount; ++v)
+    {
+        sortedVertices[ v ] = v;
+    }
+
+    std::sort( sortedVertices.begin(), sortedVertices.end(), [&positionIds]( unsigned a, unsigned b )
+    {
+        return positionIds[ a ] != positionIds[ b ] ? positionIds[ a ] < positionIds[ b ] : a < b;
+    } );
+
+    std::vector< unsigned short > canonicalVertex( vertexCount );
+    std::vector< unsigned > positionVertexCount( vertexCount, 0 );
+
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        const unsigned short v = (unsigned short)sortedVertices[ i ];
+        canonicalVertex[ v ] = v;
+
+        for (std::size_t j = i; j > 0 && positionIds[ sortedVertices[ j - 1 ] ] == positionIds[ v ]; --j)
+        {
+            const unsigned short other = (unsigned short)sortedVertices[ j - 1 ];
+
+            if (canonicalVertex[ other ] == other && hasSameAttributes( interleavedVertices[ v ], interleavedVertices[ other ] ))
+            {
+                canonicalVertex[ v ] = other;
+                break;
+            }
+        }
+
+        if (canonicalVertex[ v ] == v)
+        {
+            ++positionVertexCount[ positionIds[ v ] ];
+        }
+    }
+
+    std::vector< bool > isLocked( vertexCount );
+
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        isLocked[ v ] = positionVertexCount[ positionIds[ v ] ] > 1;
+    }
+
+    std::vector< VertexInd > lodFaces = indices;
+
+    for (auto& face : lodFaces)
+    {
+        face.a = canonicalVertex[ face.a ];
+        face.b = canonicalVertex[ face.b ];
+        face.c = canonicalVertex[ face.c ];
+    }
+
+    // Edges used by only one face are on a border.
+    std::vector< uint64_t > edges;
+    edges.reserve( indices.size() * 3 );
+
+    for (const auto& face : indices)
+    {
+        const unsigned short faceVertices[ 3 ] = { face.a, face.b, face.c };
+
+        for (int e = 0; e < 3; ++e)
+        {
+            const uint64_t p0 = positionIds[ faceVertices[ e ] ];
+            const uint64_t p1 = positionIds[ faceVertices[ (e + 1) % 3 ] ];
+            edges.push_back( p0 < p1 ? (p0 << 32) | p1 : (p1 << 32) | p0 );
+        }
+    }
+
+    std::sort( edges.begin(), edges.end() );
+    std::vector< bool > isBorderPosition( vertexCount, false );
+
+    for (std::size_t e = 0; e < edges.size(); )
+    {
+        std::size_t next = e + 1;
+
+        while (next < edges.size() && edges[ next ] == edges[ e ])
+        {
+            ++next;
+        }
+
+        if (next - e == 1)
+        {
+            isBorderPosition[ edges[ e ] >> 32 ] = true;
+            isBorderPosition[ edges[ e ] & 0xFFFFFFFF ] = true;
+        }
+
+        e = next;
+    }
+
+    std::vector< Quadric > quadrics( vertexCount );
+
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        isLocked[ v ] = isLocked[ v ] || isBorderPosition[ positionIds[ v ] ];
+    }
+
+    for (const auto& face : lodFaces)
+    {
+        const ae3d::Vec3& p0 = interleavedVertices[ face.a ].position;
+        const ae3d::Vec3 normal = ae3d::Vec3::Cross( interleavedVertices[ face.b ].position - p0, interleavedVertices[ face.c ].position - p0 );
+        const float doubleArea = normal.Length();
+
+        if (doubleArea > 0)
+        {
+            const ae3d::Vec3 unitNormal = normal * (1.0f / doubleArea);
+
+            for (unsigned short v : { face.a, face.b, face.c })
+            {
+                quadrics[ v ].AddPlane( unitNormal, -ae3d::Vec3::Dot( unitNormal, p0 ), doubleArea * 0.5f );
+            }
+        }
+    }
+
+    std::vector< VertexInd > lodIndices;
+    float error = 0;
+    lods.push_back( { 0, (uint32_t)indices.size(), 0 } );
+
+    for (unsigned lod = 1; lod <= lodCount; ++lod)
+    {
+        std::vector< VertexInd > simplified = SimplifyFaces( interleavedVertices, isLocked, quadrics, lodFaces, lodFaces.size() / 2, error );
+
+        // Stops when seams and borders prevent meaningful simplification.
+        if (simplified.empty() || simplified.size() > lodFaces.size() * 9 / 10)
+        {
+            break;
+        }
+
+        // Reuses the cache optimizer, which operates on indices.
+        indices.swap( simplified );
+        OptimizeFaces();
+        indices.swap( simplified );
+
+        lods.push_back( { (uint32_t)(indices.size() + lodIndices.size()), (uint32_t)simplified.size(), error } );
+        lodIndices.insert( lodIndices.end(), simplified.begin(), simplified.end() );
+        lodFaces.swap( simplified );
+    }
+
+    if (lods.size() == 1)
+    {
+        lods.clear();
+        return;
+    }
+
+    indices.insert( indices.end(), lodIndices.begin(), lodIndices.end() );
+}
+
 /**
  Generates tangents for faces.
 
@@ -992,9 +1692,76 @@ bool Mesh::AlmostEquals( const TexCoord& t1, const TexCoord& t2 ) const
  (1)    terminator byte: 100
  */
 
+template< typename QuantizedVertex, typename Vertex >
+static void QuantizePTNTC( const Vertex& vertex, const ae3d::Vec3& aabbMin, const ae3d::Vec3& aabbMax, QuantizedVertex& outVertex )
+{
+    using namespace ae3d::Quantization;
+
+    QuantizePosition( vertex.position, aabbMin, aabbMax, outVertex.position );
+    outVertex.position[ 3 ] = vertex.tangent.w < 0 ? -32767 : 32767;
+    outVertex.uv[ 0 ] = FloatToHalf( vertex.texCoord.u );
+    outVertex.uv[ 1 ] = FloatToHalf( vertex.texCoord.v );
+    OctahedralEncode( vertex.normal, outVertex.normal );
+    OctahedralEncode( ae3d::Vec3( vertex.tangent.x, vertex.tangent.y, vertex.tangent.z ), outVertex.tangent );
+    outVertex.color[ 0 ] = FloatToUnorm8( vertex.color.x );
+    outVertex.color[ 1 ] = FloatToUnorm8( vertex.color.y );
+    outVertex.color[ 2 ] = FloatToUnorm8( vertex.color.z );
+    outVertex.color[ 3 ] = FloatToUnorm8( vertex.color.w );
+}
+
+static std::vector< ae3d::Quantization::VertexPTNTC > QuantizeVertices( const std::vector< VertexPTNTC >& vertices, const ae3d::Vec3& aabbMin, const ae3d::Vec3& aabbMax )
+{
+    std::vector< ae3d::Quantization::VertexPTNTC > outVertices( vertices.size() );
+
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        QuantizePTNTC( vertices[ v ], aabbMin, aabbMax, outVertices[ v ] );
+    }
+
+    return outVertices;
+}
+
+static std::vector< ae3d::Quantization::VertexPTNTC_Skinned > QuantizeVertices( const std::vector< VertexPTNTC_Skinned >& vertices, const ae3d::Vec3& aabbMin, const ae3d::Vec3& aabbMax )
+{
+    std::vector< ae3d::Quantization::VertexPTNTC_Skinned > outVertices( vertices.size() );
+
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        QuantizePTNTC( vertices[ v ], aabbMin, aabbMax, outVertices[ v ] );
+        const float weights[ 4 ] = { vertices[ v ].weights.x, vertices[ v ].weights.y, vertices[ v ].weights.z, vertices[ v ].weights.w };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            outVertices[ v ].weights[ i ] = ae3d::Quantization::FloatToUnorm8( weights[ i ] );
+            outVertices[ v ].bones[ i ] = (uint8_t)vertices[ v ].bones[ i ];
+        }
+    }
+
+    return outVertices;
+}
+
+static std::vector< ae3d::Quantization::VertexPTN > QuantizeVertices( const std::vector< VertexPTN >& vertices, const ae3d::Vec3& aabbMin, const ae3d::Vec3& aabbMax )
+{
+    std::vector< ae3d::Quantization::VertexPTN > outVertices( vertices.size() );
+
+    for (std::size_t v = 0; v < vertices.size(); ++v)
+    {
+        ae3d::Quantization::QuantizePosition( vertices[ v ].position, aabbMin, aabbMax, outVertices[ v ].position );
+        outVertices[ v ].position[ 3 ] = 0;
+        outVertices[ v ].uv[ 0 ] = ae3d::Quantization::FloatToHalf( vertices[ v ].texCoord.u );
+        outVertices[ v ].uv[ 1 ] = ae3d::Quantization::FloatToHalf( vertices[ v ].texCoord.v );
+        ae3d::Quantization::OctahedralEncode( vertices[ v ].normal, outVertices[ v ].normal );
+    }
+
+    return outVertices;
+}
+
 /// Writes a .ae3d model to a file.
 /// \param aOutFile File name to save the model into.
-void WriteAe3d( const std::string& aOutFile, VertexFormat vertexFormat )
+/// \param vertexFormat Vertex format. Meshes with joints are always written as PTNTC_Skinned.
+/// \param quantize Stores vertices in compact formats, see VertexQuantization.hpp.
+/// \param lodCount Number of simplified detail levels to generate in addition to the original mesh.
+void WriteAe3d( const std::string& aOutFile, VertexFormat vertexFormat, bool quantize, unsigned lodCount )
 {
     static_assert( sizeof( VertexPTNTC) == 64, "" );
     static_assert( sizeof( ae3d::Vec3 ) == 12, "" );
@@ -1033,6 +1800,9 @@ void WriteAe3d( const std::string& aOutFile, VertexFormat vertexFormat )
             gMeshes[ m ].SolveFaceTangents();
             gMeshes[ m ].SolveVertexTangents();
         }
+
+        gMeshes[ m ].BuildClusters();
+        gMeshes[ m ].GenerateLods( lodCount );
     }
 
     // Calculates model's AABB by finding extreme values from meshes' AABBs.
@@ -1046,97 +1816,206 @@ void WriteAe3d( const std::string& aOutFile, VertexFormat vertexFormat )
         aabbMax = ae3d::Vec3::Max2( aabbMax, gMeshes[ m ].aabbMax );
     }
 
-    // The file starts with identification bytes.
-    const char* gAe3dVersion = "a9";
-    ofs.write( gAe3dVersion, 2 );
+    // Version 2 layout: header, chunk table and chunks. Chunks start at 16-byte aligned
+    // offsets so that the engine can upload vertex and index chunks without parsing them.
+    struct Chunk
+    {
+        uint32_t type;
+        uint32_t subMeshIndex;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    auto chunkType = []( const char* name ) -> uint32_t
+    {
+        return (uint32_t)name[ 0 ] | ((uint32_t)name[ 1 ] << 8) | ((uint32_t)name[ 2 ] << 16) | ((uint32_t)name[ 3 ] << 24);
+    };
+
+    std::vector< Chunk > chunks;
+    std::vector< char > chunkData;
 
-    ofs.write( reinterpret_cast< char* >( &aabbMin.x ), 3 * 4 );
-    ofs.write( reinterpret_cast< char* >( &aabbMax.x ), 3 * 4 );
+    auto addChunk = [&]( const char* name, uint32_t subMeshIndex, const void* data, std::size_t size )
+    {
+        while (chunkData.size() % 16 != 0)
+        {
+            chunkData.push_back( 0 );
+        }
 
-    const std::size_t meshes = gMeshes.size();
-    // # of meshes.
-    ofs.write( reinterpret_cast< const char* >( &meshes ), 2 );
+        chunks.push_back( { chunkType( name ), subMeshIndex, (uint32_t)chunkData.size(), (uint32_t)size } );
+        chunkData.insert( chunkData.end(), (const char*)data, (const char*)data + size );
+    };
+
+    const uint32_t subMeshCount = (uint32_t)gMeshes.size();
 
-    for (std::size_t m = 0; m < meshes; ++m)
     {
-        assert( gMeshes[ m ].fnormal.size() == gMeshes[ m ].indices.size() );
+        std::vector< char > meshChunk( 2 * sizeof( ae3d::Vec3 ) + 4 );
+        std::memcpy( &meshChunk[ 0 ], &aabbMin.x, sizeof( ae3d::Vec3 ) );
+        std::memcpy( &meshChunk[ 12 ], &aabbMax.x, sizeof( ae3d::Vec3 ) );
+        std::memcpy( &meshChunk[ 24 ], &subMeshCount, 4 );
+        addChunk( "MESH", 0, meshChunk.data(), meshChunk.size() );
+    }
 
-        // AABB.
-        ofs.write( reinterpret_cast< char* >( &gMeshes[ m ].aabbMin.x ), 3 * 4 );
-        ofs.write( reinterpret_cast< char* >( &gMeshes[ m ].aabbMax.x ), 3 * 4 );
+    for (uint32_t m = 0; m < subMeshCount; ++m)
+    {
+        assert( gMeshes[ m ].fnormal.size() == (gMeshes[ m ].lods.empty() ? gMeshes[ m ].indices.size() : gMeshes[ m ].lods[ 0 ].faceCount) );
 
-        // Writes name's length.
-        const unsigned short nameLength = (unsigned short)gMeshes[ m ].name.length();
-        ofs.write( reinterpret_cast< char* >((char*)&nameLength ), 2 );
-        // Writes name.
-        ofs.write(reinterpret_cast<char*>((char*)gMeshes[m].name.data()),
-                  nameLength);
-        
-        // Writes # of vertices.
-        const unsigned short nVertices = (unsigned short)gMeshes[ m ].interleavedVertices.size();
-        ofs.write( reinterpret_cast< char* >((char*)&nVertices), 2 );
+        uint32_t format = 0;
+        const void* vertexData = nullptr;
+        std::size_t vertexDataSize = 0;
+        const ae3d::Vec3& subMeshMin = gMeshes[ m ].aabbMin;
+        const ae3d::Vec3& subMeshMax = gMeshes[ m ].aabbMax;
+        std::vector< ae3d::Quantization::VertexPTNTC > quantizedPTNTC;
+        std::vector< ae3d::Quantization::VertexPTN > quantizedPTN;
+        std::vector< ae3d::Quantization::VertexPTNTC_Skinned > quantizedSkinned;
 
-        // Writes vertex data.
         if (vertexFormat == VertexFormat::PTNTC_Skinned || !gMeshes[ m ].joints.empty())
         {
-            const unsigned char format = 2;
-            ofs.write( (char*)&format, 1 );
-
-            ofs.write( (char*)&gMeshes[ m ].interleavedVertices[ 0 ], gMeshes[ m ].interleavedVertices.size() * sizeof( VertexPTNTC_Skinned ) );
+            // Quantized bone indices are 8-bit.
+            if (quantize && gMeshes[ m ].joints.size() <= 256)
+            {
+                quantizedSkinned = QuantizeVertices( gMeshes[ m ].interleavedVertices, subMeshMin, subMeshMax );
+                format = 5;
+                vertexData = quantizedSkinned.data();
+                vertexDataSize = quantizedSkinned.size() * sizeof( ae3d::Quantization::VertexPTNTC_Skinned );
+            }
+            else
+            {
+                format = 2;
+                vertexData = gMeshes[ m ].interleavedVertices.data();
+                vertexDataSize = gMeshes[ m ].interleavedVertices.size() * sizeof( VertexPTNTC_Skinned );
+            }
         }
         else if (vertexFormat == VertexFormat::PTNTC)
         {
             gMeshes[ m ].CopyInterleavedVerticesToPTNTC();
-            
-            const unsigned char format = 0;
-            ofs.write( (char*)&format, 1 );
-            
-            ofs.write( (char*)&gMeshes[ m ].interleavedVerticesPTNTC[ 0 ], gMeshes[ m ].interleavedVerticesPTNTC.size() * sizeof( VertexPTNTC ) );
+
+            if (quantize)
+            {
+                quantizedPTNTC = QuantizeVertices( gMeshes[ m ].interleavedVerticesPTNTC, subMeshMin, subMeshMax );
+                format = 3;
+                vertexData = quantizedPTNTC.data();
+                vertexDataSize = quantizedPTNTC.size() * sizeof( ae3d::Quantization::VertexPTNTC );
+            }
+            else
+            {
+                format = 0;
+                vertexData = gMeshes[ m ].interleavedVerticesPTNTC.data();
+                vertexDataSize = gMeshes[ m ].interleavedVerticesPTNTC.size() * sizeof( VertexPTNTC );
+            }
         }
         else if (vertexFormat == VertexFormat::PTN)
         {
             gMeshes[ m ].CopyInterleavedVerticesToPTN();
 
-            const unsigned char format = 1;
-            ofs.write( (char*)&format, 1 );
-        
-            ofs.write( (char*)&gMeshes[m].interleavedVerticesPTN[ 0 ], gMeshes[ m ].interleavedVerticesPTN.size() * sizeof( VertexPTN ) );
+            if (quantize)
+            {
+                quantizedPTN = QuantizeVertices( gMeshes[ m ].interleavedVerticesPTN, subMeshMin, subMeshMax );
+                format = 4;
+                vertexData = quantizedPTN.data();
+                vertexDataSize = quantizedPTN.size() * sizeof( ae3d::Quantization::VertexPTN );
+            }
+            else
+            {
+                format = 1;
+                vertexData = gMeshes[ m ].interleavedVerticesPTN.data();
+                vertexDataSize = gMeshes[ m ].interleavedVerticesPTN.size() * sizeof( VertexPTN );
+            }
         }
         else
         {
             std::cerr << "WriteAe3d: Unhandled Vertex format!" << std::endl;
             exit( 1 );
         }
-        
-        // Writes # of indices.
-        const unsigned short indexCount = (unsigned short)gMeshes[m].indices.size();
-        ofs.write( reinterpret_cast< char* >((char*)&indexCount), 2 );
 
-        // Writes indices.
-        ofs.write( (char*)&gMeshes[m].indices[ 0 ], gMeshes[m].indices.size() * sizeof( VertexInd ) );
+        const uint32_t vertexCount = (uint32_t)gMeshes[ m ].interleavedVertices.size();
+        const uint32_t faceCount = (uint32_t)gMeshes[ m ].indices.size();
+        // 16-bit indices are enough if every vertex can be addressed with them.
+        const uint32_t indexSize = vertexCount > 65535 ? 4 : 2;
+        const uint32_t jointCount = (uint32_t)gMeshes[ m ].joints.size();
+        const uint32_t nameLength = (uint32_t)gMeshes[ m ].name.length();
+
+        std::vector< char > subMeshChunk( 2 * sizeof( ae3d::Vec3 ) + 6 * 4 + nameLength );
+        std::memcpy( &subMeshChunk[ 0 ], &gMeshes[ m ].aabbMin.x, sizeof( ae3d::Vec3 ) );
+        std::memcpy( &subMeshChunk[ 12 ], &gMeshes[ m ].aabbMax.x, sizeof( ae3d::Vec3 ) );
+        std::memcpy( &subMeshChunk[ 24 ], &format, 4 );
+        std::memcpy( &subMeshChunk[ 28 ], &vertexCount, 4 );
+        std::memcpy( &subMeshChunk[ 32 ], &faceCount, 4 );
+        std::memcpy( &subMeshChunk[ 36 ], &indexSize, 4 );
+        std::memcpy( &subMeshChunk[ 40 ], &jointCount, 4 );
+        std::memcpy( &subMeshChunk[ 44 ], &nameLength, 4 );
+        std::memcpy( subMeshChunk.data() + 48, gMeshes[ m ].name.data(), nameLength );
+        addChunk( "SUBM", m, subMeshChunk.data(), subMeshChunk.size() );
+
+        addChunk( "VERT", m, vertexData, vertexDataSize );
+
+        if (indexSize == 2)
+        {
+            addChunk( "INDX", m, gMeshes[ m ].indices.data(), gMeshes[ m ].indices.size() * sizeof( VertexInd ) );
+        }
+        else
+        {
+            std::vector< uint32_t > indices32;
+            indices32.reserve( faceCount * 3 );
+
+            for (const auto& face : gMeshes[ m ].indices)
+            {
+                indices32.push_back( face.a );
+                indices32.push_back( face.b );
+                indices32.push_back( face.c );
+            }
+
+            addChunk( "INDX", m, indices32.data(), indices32.size() * sizeof( uint32_t ) );
+        }
+
+        static_assert( sizeof( Cluster ) == 40, "" );
+        addChunk( "CLUS", m, gMeshes[ m ].clusters.data(), gMeshes[ m ].clusters.size() * sizeof( Cluster ) );
 
-        // Writes # of joints.
-        const unsigned short jointCount = (unsigned short)gMeshes[ m ].joints.size();
-        ofs.write( reinterpret_cast< char* >((char*)&jointCount), 2 );
+        if (!gMeshes[ m ].lods.empty())
+        {
+            static_assert( sizeof( Lod ) == 12, "" );
+            addChunk( "LODS", m, gMeshes[ m ].lods.data(), gMeshes[ m ].lods.size() * sizeof( Lod ) );
+        }
 
-        // Writes joints.
-        for (size_t j = 0; j < gMeshes[ m ].joints.size(); ++j)
+        if (jointCount > 0)
         {
-            ofs.write( (char*)&gMeshes[ m ].joints[ j ].globalBindposeInverse, sizeof( ae3d::Matrix44 ) );
-            ofs.write( (char*)&gMeshes[ m ].joints[ j ].parentIndex, 4 );
-            const int jointNameLength = (int)gMeshes[ m ].joints[ j ].name.length();
-            ofs.write( (char*)&jointNameLength, sizeof( int ) );
-            ofs.write( reinterpret_cast<char*>((char*)gMeshes[m].joints[ j ].name.data()),
-                jointNameLength );
-            const int animLength = (int)gMeshes[ m ].joints[ j ].animTransforms.size();
-            ofs.write( (char*)&animLength, sizeof( int ) );
-            ofs.write( (char*)&gMeshes[ m ].joints[ j ].animTransforms[ 0 ].m[ 0 ], gMeshes[ m ].joints[ j ].animTransforms.size() * sizeof( ae3d::Matrix44 ) );
+            std::vector< char > jointChunk;
+
+            auto append = [&jointChunk]( const void* data, std::size_t size )
+            {
+                jointChunk.insert( jointChunk.end(), (const char*)data, (const char*)data + size );
+            };
+
+            for (const auto& joint : gMeshes[ m ].joints)
+            {
+                append( &joint.globalBindposeInverse, sizeof( ae3d::Matrix44 ) );
+                append( &joint.parentIndex, 4 );
+                const int jointNameLength = (int)joint.name.length();
+                append( &jointNameLength, sizeof( int ) );
+                append( joint.name.data(), jointNameLength );
+                const int animLength = (int)joint.animTransforms.size();
+                append( &animLength, sizeof( int ) );
+                append( joint.animTransforms.data(), joint.animTransforms.size() * sizeof( ae3d::Matrix44 ) );
+            }
+
+            addChunk( "JOIN", m, jointChunk.data(), jointChunk.size() );
         }
     }
 
-    // Terminator.
-    const unsigned char byte = 100;
-    ofs.write( (char*)&byte, 1 );
+    const uint32_t header[ 4 ] = { chunkType( "ae3d" ), 2, (uint32_t)chunks.size(), 0 };
+    std::size_t dataOffset = sizeof( header ) + chunks.size() * sizeof( Chunk );
+    dataOffset = (dataOffset + 15) & ~std::size_t( 15 );
+
+    for (auto& chunk : chunks)
+    {
+        chunk.offset += (uint32_t)dataOffset;
+    }
+
+    ofs.write( reinterpret_cast< const char* >( header ), sizeof( header ) );
+    ofs.write( reinterpret_cast< const char* >( chunks.data() ), chunks.size() * sizeof( Chunk ) );
+
+    const char padding[ 16 ] = {};
+    ofs.write( padding, dataOffset - sizeof( header ) - chunks.size() * sizeof( Chunk ) );
+    ofs.write( chunkData.data(), chunkData.size() );
 
     std::cout << "Wrote " << aOutFile << std::endl;
 }